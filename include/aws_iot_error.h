@@ -38,6 +38,10 @@ extern "C" {
  * Values greater than 0 are specific non-error return codes
  */
 typedef enum {
+	/** Reported by the reactor when the reconnect attempt of a client is due, the application makes it */
+			NETWORK_RECONNECT_DUE = 8,
+	/** Returned when a publish made while the client is reconnecting is kept in the offline queue */
+			MQTT_PUBLISH_QUEUED_OFFLINE = 7,
 	/** Returned when the Network physical layer is connected */
 			NETWORK_PHYSICAL_LAYER_CONNECTED = 6,
 	/** Returned when the Network is manually disconnected */
@@ -156,7 +160,17 @@ typedef enum {
 	/** Some limit has been exceeded, e.g. the maximum number of subscriptions has been reached */
 			LIMIT_EXCEEDED_ERROR = -51,
 	/** Invalid input topic type */
-			INVALID_TOPIC_TYPE_ERROR = -52
+			INVALID_TOPIC_TYPE_ERROR = -52,
+	/** The client has the maximum number of QoS1 publishes awaiting PUBACK. Request will fail */
+			MQTT_MAX_INFLIGHT_PUBLISHES_REACHED_ERROR = -53,
+	/** The server refused at least one of the topics of a subscribe request */
+			MQTT_SUBSCRIBE_REJECTED_ERROR = -54,
+	/** Waiting for the sockets of the clients registered with a reactor failed */
+			NETWORK_POLL_ERROR = -55,
+	/** The offline queue has no room for the message under its drop policy */
+			MQTT_OFFLINE_QUEUE_FULL_ERROR = -56,
+	/** The storage allocator of the client could not provide its buffers and tables */
+			MQTT_STORAGE_ALLOCATION_ERROR = -57
 } IoT_Error_t;
 
 #ifdef __cplusplus
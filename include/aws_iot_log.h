@@ -23,6 +23,10 @@
  *
  * It is expected that the macros below will be modified or replaced when porting to
  * specific hardware platforms as printf may not be the desired behavior.
+ *
+ * With ENABLE_IOT_ASYNC_LOG defined, the macros do not print. They store the format string
+ * and a copy of the arguments in a ring buffer of the calling thread, and the records are
+ * formatted and written later by aws_iot_log_flush, called from a background task.
  */
 
 #ifndef _IOT_LOG_H
@@ -35,12 +39,170 @@ extern "C" {
 #include <stdio.h>
 #include <stdlib.h>
 
+#ifdef ENABLE_IOT_ASYNC_LOG
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Log Level
+ *
+ * Defining a type for the levels of the logging macros, in increasing order of severity.
+ *
+ */
+typedef enum {
+	IOT_LOG_LEVEL_TRACE = 0, ///< FUNC_ENTRY, FUNC_EXIT and FUNC_EXIT_RC
+	IOT_LOG_LEVEL_DEBUG = 1, ///< IOT_DEBUG
+	IOT_LOG_LEVEL_INFO = 2, ///< IOT_INFO
+	IOT_LOG_LEVEL_WARN = 3, ///< IOT_WARN
+	IOT_LOG_LEVEL_ERROR = 4, ///< IOT_ERROR
+	IOT_LOG_LEVEL_NONE = 5 ///< Above all levels, filters every message out
+} IoT_Log_Level;
+
+/**
+ * @brief Log Call Site
+ *
+ * Defining a type for the static data of one logging macro call, also used to limit the
+ * number of messages it logs per second.
+ *
+ */
+typedef struct {
+	IoT_Log_Level level; ///< Level of the macro
+	const char *pPrefix; ///< Printed before the function name and line, NULL to print neither
+	const char *pFunction; ///< Name of the calling function
+	int line; ///< Line of the call
+	uint32_t windowStartMs; ///< Start of the current one second rate limiting window
+	uint32_t windowCount; ///< Messages logged in the current window
+	uint32_t suppressedCount; ///< Messages suppressed in the current window
+} IoT_Log_Site;
+
+/**
+ * @brief Log Output Function Type
+ *
+ * Defining a TYPE for the function writing formatted log lines, see aws_iot_log_set_output.
+ * pLine is not NULL terminated and ends with a newline.
+ *
+ */
+typedef void (*pLogOutput_t)(const char *pLine, size_t len);
+
+/**
+ * @brief Queue a log record for the calling thread
+ *
+ * Called by the logging macros. The format string must be a literal, only its address is kept,
+ * IOT_LOG_ASYNC does not compile otherwise. Strings passed for %s are copied. The record is
+ * dropped and counted when the ring of the thread is full.
+ *
+ * @param pSite Call site of the logging macro
+ * @param pFormat printf format string
+ */
+void aws_iot_log_write(IoT_Log_Site *pSite, const char *pFormat, ...);
+
+/**
+ * @brief Format and write the queued log records
+ *
+ * Drains the rings of all threads. Meant to be called periodically from a low priority task,
+ * only one call runs at a time.
+ *
+ * @return uint32_t the number of records written
+ */
+uint32_t aws_iot_log_flush(void);
+
+/**
+ * @brief Set the lowest level logged
+ *
+ * Messages below this level are filtered out before being queued. Levels that are not
+ * enabled at compile time are never logged.
+ *
+ * @param level Lowest level logged, IOT_LOG_LEVEL_TRACE by default
+ */
+void aws_iot_log_set_level(IoT_Log_Level level);
+
+/**
+ * @brief Set the number of messages logged per second by each call site
+ *
+ * Further messages of a call site within the same second are counted and reported with its
+ * next logged message.
+ *
+ * @param maxPerSecond Messages per second and call site, 0 for no limit. AWS_IOT_LOG_RATE_LIMIT by default
+ */
+void aws_iot_log_set_rate_limit(uint32_t maxPerSecond);
+
+/**
+ * @brief Set the function writing formatted log lines
+ *
+ * @param outputFunc Called by aws_iot_log_flush for every line, NULL to write to stdout
+ */
+void aws_iot_log_set_output(pLogOutput_t outputFunc);
+
+/**
+ * @brief Get the number of records dropped because the ring of their thread was full
+ *
+ * @return uint32_t the dropped record count, for all threads
+ */
+uint32_t aws_iot_log_get_dropped_count(void);
+
+#ifdef _ENABLE_THREAD_SUPPORT_
+#include "aws_iot_error.h"
+
+/**
+ * @brief Start a thread calling aws_iot_log_flush periodically
+ *
+ * Provided by the platform layer.
+ *
+ * @param intervalMs Time between two flushes, in milliseconds
+ *
+ * @return IoT_Error_t Type defining successful/failed API call
+ */
+IoT_Error_t aws_iot_log_start_flusher(uint32_t intervalMs);
+
+/**
+ * @brief Stop the thread started by aws_iot_log_start_flusher, after a last flush
+ *
+ * @return IoT_Error_t Type defining successful/failed API call
+ */
+IoT_Error_t aws_iot_log_stop_flusher(void);
+
+/**
+ * @brief Have aws_iot_log_release_thread called when the calling thread exits
+ *
+ * Provided by the platform layer. Called by the logger when a thread takes a ring.
+ *
+ * @param pRing Passed back to aws_iot_log_release_thread
+ *
+ * @return IoT_Error_t Type defining successful/failed API call
+ */
+IoT_Error_t aws_iot_log_watch_thread_exit(void *pRing);
+
+/**
+ * @brief Give back the ring of the calling thread, which is exiting
+ *
+ * Called by the platform layer. The ring is reused once the flush has drained it.
+ *
+ * @param pRing Value given to aws_iot_log_watch_thread_exit
+ */
+void aws_iot_log_release_thread(void *pRing);
+#endif
+
+/**
+ * @brief Logging macro front end of the asynchronous logger
+ *
+ * Each call site has its own static IoT_Log_Site. The format is pasted after an empty literal,
+ * so that a format which is not a string literal fails to compile.
+ */
+#define IOT_LOG_ASYNC(level, prefix, ...)    \
+	{\
+	static IoT_Log_Site _iotLogSite = { level, prefix, __func__, __LINE__, 0, 0, 0 }; \
+	aws_iot_log_write(&_iotLogSite, "" __VA_ARGS__); \
+	}
+#endif
+
 /**
  * @brief Debug level logging macro.
  *
  * Macro to expose function, line number as well as desired log message.
  */
-#ifdef ENABLE_IOT_DEBUG
+#if defined(ENABLE_IOT_DEBUG) && defined(ENABLE_IOT_ASYNC_LOG)
+#define IOT_DEBUG(...) IOT_LOG_ASYNC(IOT_LOG_LEVEL_DEBUG, "DEBUG:  ", __VA_ARGS__)
+#elif defined(ENABLE_IOT_DEBUG)
 #define IOT_DEBUG(...)    \
 	{\
 	printf("DEBUG:   %s L#%d ", __func__, __LINE__);  \
@@ -56,7 +218,15 @@ extern "C" {
  *
  * Macro to print message function entry and exit
  */
-#ifdef ENABLE_IOT_TRACE
+#if defined(ENABLE_IOT_TRACE) && defined(ENABLE_IOT_ASYNC_LOG)
+#define FUNC_ENTRY IOT_LOG_ASYNC(IOT_LOG_LEVEL_TRACE, "FUNC_ENTRY:  ", "")
+#define FUNC_EXIT IOT_LOG_ASYNC(IOT_LOG_LEVEL_TRACE, "FUNC_EXIT:  ", "")
+#define FUNC_EXIT_RC(x)    \
+	{\
+	IOT_LOG_ASYNC(IOT_LOG_LEVEL_TRACE, "FUNC_EXIT:  ", "Return Code : %d ", x); \
+	return x; \
+	}
+#elif defined(ENABLE_IOT_TRACE)
 #define FUNC_ENTRY    \
 	{\
 	printf("FUNC_ENTRY:   %s L#%d \n", __func__, __LINE__);  \
@@ -82,7 +252,9 @@ extern "C" {
  *
  * Macro to expose desired log message.  Info messages do not include automatic function names and line numbers.
  */
-#ifdef ENABLE_IOT_INFO
+#if defined(ENABLE_IOT_INFO) && defined(ENABLE_IOT_ASYNC_LOG)
+#define IOT_INFO(...) IOT_LOG_ASYNC(IOT_LOG_LEVEL_INFO, NULL, __VA_ARGS__)
+#elif defined(ENABLE_IOT_INFO)
 #define IOT_INFO(...)    \
 	{\
 	printf(__VA_ARGS__); \
@@ -97,7 +269,9 @@ extern "C" {
  *
  * Macro to expose function, line number as well as desired log message.
  */
-#ifdef ENABLE_IOT_WARN
+#if defined(ENABLE_IOT_WARN) && defined(ENABLE_IOT_ASYNC_LOG)
+#define IOT_WARN(...) IOT_LOG_ASYNC(IOT_LOG_LEVEL_WARN, "WARN: ", __VA_ARGS__)
+#elif defined(ENABLE_IOT_WARN)
 #define IOT_WARN(...)   \
 	{ \
 	printf("WARN:  %s L#%d ", __func__, __LINE__);  \
@@ -113,7 +287,9 @@ extern "C" {
  *
  * Macro to expose function, line number as well as desired log message.
  */
-#ifdef ENABLE_IOT_ERROR
+#if defined(ENABLE_IOT_ERROR) && defined(ENABLE_IOT_ASYNC_LOG)
+#define IOT_ERROR(...) IOT_LOG_ASYNC(IOT_LOG_LEVEL_ERROR, "ERROR:", __VA_ARGS__)
+#elif defined(ENABLE_IOT_ERROR)
 #define IOT_ERROR(...)  \
 	{ \
 	printf("ERROR: %s L#%d ", __func__, __LINE__); \
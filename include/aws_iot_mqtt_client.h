@@ -56,14 +56,88 @@ extern "C" {
 /* Platform specific implementation header files */
 #include "network_interface.h"
 #include "timer_interface.h"
+#include "aws_iot_timer_wheel.h"
 
 #ifdef _ENABLE_THREAD_SUPPORT_
 #include "threads_interface.h"
 #endif
+#ifdef AWS_IOT_MQTT_ENABLE_OFFLINE_QUEUE
+#include "offline_store_interface.h"
+#endif
 
 /** Greatest packet identifier, per MQTT spec */
 #define MAX_PACKET_ID 65535
 
+#ifndef AWS_IOT_MQTT_MAX_INFLIGHT_PUBLISHES
+/** Maximum number of asynchronous QoS1 publishes awaiting PUBACK, if not set in aws_iot_config.h */
+#define AWS_IOT_MQTT_MAX_INFLIGHT_PUBLISHES 10
+#endif
+
+#if AWS_IOT_MQTT_MAX_INFLIGHT_PUBLISHES >= AWS_IOT_TIMER_WHEEL_INDEX_NONE
+#error "In-flight publishes are timed by a timer wheel indexed with 16 bits"
+#endif
+
+#ifndef AWS_IOT_MQTT_NUM_TOPIC_TRIE_NODES
+/** Number of topic levels held by the subscription index, if not set in aws_iot_config.h */
+#define AWS_IOT_MQTT_NUM_TOPIC_TRIE_NODES (AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS * 8)
+#endif
+
+/** Index value marking the end of a list of topic trie nodes or message handlers */
+#define TOPIC_TRIE_INDEX_NONE 0xFFFF
+
+#if AWS_IOT_MQTT_NUM_TOPIC_TRIE_NODES >= TOPIC_TRIE_INDEX_NONE || AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS >= TOPIC_TRIE_INDEX_NONE
+#error "Topic trie nodes and message handlers are indexed with 16 bits"
+#endif
+
+/** Alignment of the storage blocks handed out by a client storage arena */
+#define AWS_IOT_MQTT_STORAGE_ALIGNMENT 8
+
+#ifndef AWS_IOT_MQTT_ADAPTIVE_KEEP_ALIVE_MIN_SEC
+/** Idle time before the first PINGREQ of an adaptive keep alive, in seconds, if not set in aws_iot_config.h */
+#define AWS_IOT_MQTT_ADAPTIVE_KEEP_ALIVE_MIN_SEC 30
+#endif
+
+#ifdef AWS_IOT_MQTT_OUTBOUND_QUEUE_SLOTS
+#ifndef _ENABLE_THREAD_SUPPORT_
+#error "The outbound queue is only available with _ENABLE_THREAD_SUPPORT_"
+#endif
+#if 0 == AWS_IOT_MQTT_OUTBOUND_QUEUE_SLOTS || 0 != (AWS_IOT_MQTT_OUTBOUND_QUEUE_SLOTS & (AWS_IOT_MQTT_OUTBOUND_QUEUE_SLOTS - 1))
+#error "AWS_IOT_MQTT_OUTBOUND_QUEUE_SLOTS must be a power of two"
+#endif
+#ifndef AWS_IOT_MQTT_OUTBOUND_SLOT_LEN
+/** Largest packet held by one slot of the outbound queue, if not set in aws_iot_config.h */
+#define AWS_IOT_MQTT_OUTBOUND_SLOT_LEN (AWS_IOT_MQTT_TX_BUF_LEN / 4)
+#endif
+#if AWS_IOT_MQTT_OUTBOUND_SLOT_LEN >= AWS_IOT_MQTT_TX_BUF_LEN
+#error "Queued packets are sent from the write buffer, AWS_IOT_MQTT_OUTBOUND_SLOT_LEN must be smaller than AWS_IOT_MQTT_TX_BUF_LEN"
+#endif
+#endif
+
+#ifdef AWS_IOT_MQTT_INFLIGHT_PACKET_LEN
+#if AWS_IOT_MQTT_INFLIGHT_PACKET_LEN > AWS_IOT_MQTT_TX_BUF_LEN
+#error "Stored packets are resent from the write buffer, AWS_IOT_MQTT_INFLIGHT_PACKET_LEN cannot exceed AWS_IOT_MQTT_TX_BUF_LEN"
+#endif
+#endif
+
+#ifdef AWS_IOT_MQTT_ENABLE_OFFLINE_QUEUE
+#ifndef AWS_IOT_MQTT_OFFLINE_QUEUE_DRAIN_BATCH
+/** Number of queued messages published per drain step after reconnecting, if not set in aws_iot_config.h */
+#define AWS_IOT_MQTT_OFFLINE_QUEUE_DRAIN_BATCH 4
+#endif
+#ifndef AWS_IOT_MQTT_OFFLINE_QUEUE_DRAIN_INTERVAL_MS
+/** Minimum time between two drain steps, in milliseconds, if not set in aws_iot_config.h */
+#define AWS_IOT_MQTT_OFFLINE_QUEUE_DRAIN_INTERVAL_MS 100
+#endif
+#endif
+
+#ifdef AWS_IOT_MQTT_ENABLE_STATS
+/** Number of MQTT control packet types, the packet counters are indexed by the type in the fixed header */
+#define AWS_IOT_MQTT_STATS_PACKET_TYPES 16
+/** Number of buckets of a latency histogram. Bucket 0 counts durations under 1us, bucket n
+ * durations from 2^(n-1) up to 2^n us, the last bucket everything longer */
+#define AWS_IOT_MQTT_STATS_HISTOGRAM_BUCKETS 32
+#endif
+
 typedef struct _Client AWS_IoT_Client;
 
 /**
@@ -160,6 +234,57 @@ extern const IoT_Client_Connect_Params iotClientConnectParamsDefault;
  */
 typedef void (*iot_disconnect_handler)(AWS_IoT_Client *, void *);
 
+/** Returned by a reconnect policy to stop the automatic reconnect attempts */
+#define AWS_IOT_MQTT_RECONNECT_GIVE_UP UINT32_MAX
+
+/**
+ * @brief Reconnect Policy Type
+ *
+ * Defining a TYPE for the functions deciding how long to wait before an automatic reconnect
+ * attempt. Called with the number of the attempt, from 1, and the previous wait in milliseconds,
+ * 0 before the first attempt. Returns the wait in milliseconds, or AWS_IOT_MQTT_RECONNECT_GIVE_UP.
+ *
+ */
+typedef uint32_t (*iot_reconnect_policy)(AWS_IoT_Client *, uint32_t, uint32_t);
+
+/**
+ * @brief Offline Queue Drop Policy Type
+ *
+ * Defining a type for the message given up when the offline queue has no room for a new one.
+ *
+ */
+typedef enum {
+	OFFLINE_QUEUE_DROP_OLDEST = 0, ///< Remove the oldest queued messages to make room
+	OFFLINE_QUEUE_DROP_NEWEST = 1 ///< Reject the new message with MQTT_OFFLINE_QUEUE_FULL_ERROR
+} OfflineQueueDropPolicy;
+
+/**
+ * @brief Client Storage Allocator
+ *
+ * Defining a type for the source of the buffers and tables of a client, see
+ * aws_iot_mqtt_get_storage_size. The client allocates them in one block when it is initialized
+ * and releases the block when it is freed. The block must be aligned for any pointer.
+ *
+ */
+typedef struct {
+	void *(*allocate)(void *pContext, size_t size);	///< Returns a block of size bytes, NULL if there is none
+	void (*release)(void *pContext, void *pBlock);	///< Gives a block back, NULL if blocks are never given back
+	void *pContext;					///< Context passed to both functions
+} IoT_Client_Allocator;
+
+/**
+ * @brief Client Storage Arena
+ *
+ * Defining a type for a caller-supplied region from which the storage of several clients is
+ * carved, see aws_iot_mqtt_arena_allocate. Blocks are never given back to the arena.
+ *
+ */
+typedef struct {
+	unsigned char *pBase;	///< Start of the region
+	size_t size;		///< Size of the region in bytes
+	size_t used;		///< Bytes already handed out
+} IoT_Client_Arena;
+
 /**
  * @brief MQTT Initialization Parameters
  *
@@ -180,6 +305,20 @@ typedef struct {
 	bool isSSLHostnameVerify;			///< Client should perform server certificate hostname validation
 	iot_disconnect_handler disconnectHandler;	///< Callback to be invoked upon connection loss
 	void *disconnectHandlerData;			///< Data to pass as argument when disconnect handler is called
+	char *pOfflineQueuePath;			///< Persistent region keeping publishes made while reconnecting, a file path on Linux. NULL to disable. Needs AWS_IOT_MQTT_ENABLE_OFFLINE_QUEUE
+	size_t offlineQueueSize;			///< Size of the offline queue region in bytes
+	OfflineQueueDropPolicy offlineQueueDropPolicy;	///< Which message is given up when the offline queue is full
+	char *pTlsSessionLocation;			///< File keeping the last TLS session so that the first handshake after a restart can be resumed. NULL to keep it in memory only
+	uint32_t minReconnectWait_ms;			///< Shortest wait between reconnect attempts after the first one. 0 for AWS_IOT_MQTT_MIN_RECONNECT_WAIT_INTERVAL
+	uint32_t maxReconnectWait_ms;			///< Longest wait between reconnect attempts. 0 for AWS_IOT_MQTT_MAX_RECONNECT_WAIT_INTERVAL
+	iot_reconnect_policy reconnectPolicy;		///< Decides the wait before each reconnect attempt. NULL for aws_iot_mqtt_reconnect_policy_decorrelated_jitter
+	bool isKeepAliveAdaptive;			///< Learn how long the connection survives without traffic and send PINGREQs that rarely, up to the keep alive interval
+	size_t txBufLen;				///< Size of the outgoing data buffer. 0 for AWS_IOT_MQTT_TX_BUF_LEN
+	size_t rxBufLen;				///< Size of the incoming data buffer, the largest message that is not streamed. 0 for AWS_IOT_MQTT_RX_BUF_LEN
+	uint16_t subscribeHandlerCount;			///< Most subscriptions held at a time, up to AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS. 0 for AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS
+	uint16_t inflightPublishCount;			///< QoS1 publishes awaiting a PUBACK at a time. 0 for AWS_IOT_MQTT_MAX_INFLIGHT_PUBLISHES
+	uint32_t outboundQueueSlotCount;		///< Slots of the outbound queue, a power of two. 0 for AWS_IOT_MQTT_OUTBOUND_QUEUE_SLOTS. Needs AWS_IOT_MQTT_OUTBOUND_QUEUE_SLOTS
+	IoT_Client_Allocator *pStorageAllocator;	///< Allocates the buffers and the tables. NULL to use the arrays embedded in the client, which bound the sizes above
 #ifdef _ENABLE_THREAD_SUPPORT_
 	bool isBlockOnThreadLockEnabled;		///< Timeout for Thread blocking calls. Set to 0 to block until lock is obtained. In milliseconds
 #endif
@@ -189,9 +328,9 @@ extern const IoT_Client_Init_Params iotClientInitParamsDefault;
 
 /** Default initializer for client */
 #ifdef _ENABLE_THREAD_SUPPORT_
-#define IoT_Client_Init_Params_initializer { true, NULL, 0, NULL, NULL, NULL, 2000, 20000, 5000, true, NULL, NULL, false }
+#define IoT_Client_Init_Params_initializer { true, NULL, 0, NULL, NULL, NULL, 2000, 20000, 5000, true, NULL, NULL, NULL, 0, OFFLINE_QUEUE_DROP_OLDEST, NULL, 0, 0, NULL, false, 0, 0, 0, 0, 0, NULL, false }
 #else
-#define IoT_Client_Init_Params_initializer { true, NULL, 0, NULL, NULL, NULL, 2000, 20000, 5000, true, NULL, NULL }
+#define IoT_Client_Init_Params_initializer { true, NULL, 0, NULL, NULL, NULL, 2000, 20000, 5000, true, NULL, NULL, NULL, 0, OFFLINE_QUEUE_DROP_OLDEST, NULL, 0, 0, NULL, false, 0, 0, 0, 0, 0, NULL }
 #endif
 
 /**
@@ -227,6 +366,141 @@ typedef enum _ClientState {
 typedef void (*pApplicationHandler_t)(AWS_IoT_Client *pClient, char *pTopicName, uint16_t topicNameLen,
 									  IoT_Publish_Message_Params *pParams, void *pClientData);
 
+/**
+ * @brief Application Fragment Callback Handler Type
+ *
+ * Defining a TYPE for definition of streaming application callback function pointers.
+ * Used to send incoming data to the application in fragments. pParams->payload and
+ * pParams->payloadLen describe one fragment, found at payloadOffset in a message payload
+ * of payloadTotalLen bytes. Fragments are delivered in order.
+ *
+ */
+typedef void (*pApplicationFragmentHandler_t)(AWS_IoT_Client *pClient, char *pTopicName, uint16_t topicNameLen,
+											  IoT_Publish_Message_Params *pParams, size_t payloadOffset,
+											  size_t payloadTotalLen, void *pClientData);
+
+/**
+ * @brief Subscription Parameters Type
+ *
+ * Defines a type for one topic of a subscribe request made with aws_iot_mqtt_subscribe_batch.
+ *
+ */
+typedef struct {
+	const char *pTopicName; ///< Topic filter to subscribe to. Needs to be static in memory since no malloc is performed by the SDK
+	uint16_t topicNameLen; ///< Length of the topic filter
+	QoS qos; ///< Quality of service for the subscription
+	pApplicationHandler_t pApplicationHandler; ///< Reference to the handler function for this subscription
+	void *pApplicationHandlerData; ///< Point to data passed to the callback. Needs to be static in memory since no malloc is performed by the SDK
+	IoT_Error_t result; ///< Set by the MQTT client to the outcome of the subscription to this topic
+} IoT_Subscribe_Params;
+
+/**
+ * @brief Publish Completion Callback Handler Type
+ *
+ * Defining a TYPE for definition of asynchronous publish completion function pointers.
+ * Called once for every QoS1 message sent with aws_iot_mqtt_publish_async, either when the
+ * matching PUBACK is received (SUCCESS) or when the message is abandoned (timeout or disconnect).
+ *
+ */
+typedef void (*pPublishCompleteHandler_t)(AWS_IoT_Client *pClient, uint16_t packetId, IoT_Error_t status,
+										  void *pCompleteHandlerData);
+
+/**
+ * @brief MQTT In-flight Publish
+ *
+ * Defining a type for asynchronous QoS1 publishes that are waiting for a PUBACK.
+ * Entries are indexed by packet identifier. A blocking publish made while another thread
+ * yields also waits on an entry, which the reading thread completes in place.
+ * The PUBACK deadline of an entry is kept in the timer wheel of the client, at the same index.
+ *
+ */
+typedef struct _InflightPublish {
+	bool isFree; ///< Whether this entry is available
+	uint16_t packetId; ///< Packet identifier of the outstanding PUBLISH
+	pPublishCompleteHandler_t pCompleteHandler; ///< Application function to invoke on completion
+	void *pCompleteHandlerData; ///< Context to pass to completion handler
+	bool isWaited; ///< Whether a blocking publish waits on this entry and releases it
+	bool isComplete; ///< Whether the waited entry has completed
+	IoT_Error_t completeStatus; ///< Completion status of the waited entry
+#ifdef AWS_IOT_MQTT_INFLIGHT_PACKET_LEN
+	size_t storedLen; ///< Length of the copy of the PUBLISH packet kept for a persistent session, 0 if none
+#endif
+#ifdef AWS_IOT_MQTT_ENABLE_STATS
+	uint32_t sentUs; ///< When the PUBLISH was last sent, from timer_now_us
+#endif
+} InflightPublish;
+
+#ifdef AWS_IOT_MQTT_OUTBOUND_QUEUE_SLOTS
+/**
+ * @brief MQTT Outbound Queue Slot
+ *
+ * Defining a type for the preallocated slots of the outbound queue.
+ * The sequence tells which queue position the slot is available for, or holds a packet for.
+ *
+ */
+typedef struct _OutboundSlot {
+	uint32_t sequence; ///< Queue position plus one when the slot holds a packet, position when it is available. Accessed atomically
+	size_t len; ///< Length of the queued packet, 0 for a slot that was given up by its producer
+	unsigned char packet[AWS_IOT_MQTT_OUTBOUND_SLOT_LEN]; ///< Serialized packet
+} OutboundSlot;
+
+/**
+ * @brief MQTT Outbound Queue
+ *
+ * Defining a type for the lock-free queue of serialized packets. Any thread can queue a
+ * packet, only the thread holding the write buffer sends them.
+ *
+ */
+typedef struct _OutboundQueue {
+	uint32_t enqueuePos; ///< Next position claimed by a producer. Accessed atomically
+	uint32_t dequeuePos; ///< Next position to send. Only changed with the write buffer held
+	uint32_t slotCount; ///< Number of slots, a power of two
+	OutboundSlot *slots; ///< Packet slab, indexed by position
+} OutboundQueue;
+#endif
+
+#ifdef AWS_IOT_MQTT_ENABLE_OFFLINE_QUEUE
+/**
+ * @brief Queued QoS1 message that has been sent
+ *
+ * The slot is passed to the completion handler of the publish, and freed once the
+ * record leaves the queue.
+ */
+typedef struct {
+	uint32_t offset; ///< Offset of the record in the ring
+	bool isUsed; ///< Whether the slot tracks a record
+	bool isPending; ///< Whether the publish waits for its PUBACK
+	bool isAcked; ///< Whether the PUBACK was received, the record is removed once it is the oldest
+} OfflineInflightRecord;
+
+/**
+ * @brief MQTT Offline Queue
+ *
+ * Defining a type for the messages published while the client is reconnecting. The
+ * messages are kept in a persistent ring of records so that they survive a restart of
+ * the application, and are published at a limited rate once the client is connected.
+ * A QoS1 message stays in the ring until its PUBACK is received.
+ *
+ */
+typedef struct _OfflineQueue {
+	OfflineStore store; ///< Platform handle of the persistent region
+	unsigned char *pRegion; ///< Mapped region, a header followed by the ring of records
+	uint32_t dataSize; ///< Size of the ring of records
+	uint32_t messageCount; ///< Number of queued messages, including those sent and not yet acknowledged
+	uint32_t sentLen; ///< Bytes of the ring, from the oldest record, holding messages already sent
+	uint32_t sentCount; ///< Number of messages within sentLen
+	bool isSending; ///< Whether the drain sends the record at sendingOffset, with the lock released
+	uint32_t sendingOffset; ///< Offset of the record being sent
+	OfflineInflightRecord inflight[AWS_IOT_MQTT_MAX_INFLIGHT_PUBLISHES]; ///< QoS1 messages sent and still queued
+	OfflineQueueDropPolicy dropPolicy; ///< Which message is given up when the queue is full
+	bool isOpen; ///< Whether the persistent region is open
+	Timer drainTimer; ///< Timer spacing the drain steps
+#ifdef _ENABLE_THREAD_SUPPORT_
+	IoT_Mutex_t lock; ///< Mutex protecting the queue
+#endif
+} OfflineQueue;
+#endif
+
 /**
  * @brief MQTT Message Handler
  *
@@ -240,9 +514,30 @@ typedef struct _MessageHandlers {
 	char resubscribed; ///< Whether this handler was successfully resubscribed in the reconnect workflow
 	QoS qos; ///< QoS of subscription
 	pApplicationHandler_t pApplicationHandler; ///< Application function to invoke
+	pApplicationFragmentHandler_t pApplicationFragmentHandler; ///< Application function to invoke with payload fragments, for streaming subscriptions
 	void *pApplicationHandlerData; ///< Context to pass to application handler
+	uint16_t trieNode; ///< Index of the topic trie node holding the topic filter of this subscription
+	uint16_t nextTrieHandler; ///< Index of the next message handler subscribed with the same topic filter
 } MessageHandlers;   /* Message handlers are indexed by subscription topic */
 
+/**
+ * @brief MQTT Topic Trie Node
+ *
+ * Defining a type for the nodes of the subscription index.
+ * Each node is one level of a topic filter, so that incoming topics are matched level by level
+ * instead of against every subscription. Nodes are taken from a fixed pool in the client.
+ *
+ */
+typedef struct _TopicTrieNode {
+	const char *pLevel; ///< Topic level, points into the topic filter of a subscription below this node
+	uint16_t levelLen; ///< Length of the topic level
+	uint16_t parent; ///< Index of the parent node
+	uint16_t firstChild; ///< Index of the first child node
+	uint16_t nextSibling; ///< Index of the next child of the parent node, or of the next free node
+	uint16_t firstHandler; ///< Index of the first message handler subscribed with the topic filter ending here
+	uint16_t subscriptionCount; ///< Number of message handlers subscribed through this node
+} TopicTrieNode;
+
 /**
  * @brief MQTT Client Status
  *
@@ -254,8 +549,45 @@ typedef struct _ClientStatus {
 	ClientState clientState; ///< The current state of the client's state machine
 	bool isPingOutstanding; ///< Whether this client is waiting for a ping response
 	bool isAutoReconnectEnabled; ///< Whether auto-reconnect is enabled for this client
+	bool isSessionPresent; ///< Whether the broker resumed the persistent session on the last connection
 } ClientStatus;
 
+#ifdef AWS_IOT_MQTT_ENABLE_STATS
+/**
+ * @brief Latency Histogram
+ *
+ * Defining a type for the distribution of a duration, in buckets of powers of two microseconds.
+ *
+ */
+typedef struct {
+	uint32_t buckets[AWS_IOT_MQTT_STATS_HISTOGRAM_BUCKETS]; ///< Number of samples per bucket, see AWS_IOT_MQTT_STATS_HISTOGRAM_BUCKETS
+	uint32_t count; ///< Number of samples
+	uint32_t maxUs; ///< Longest sample, in microseconds
+	uint64_t totalUs; ///< Sum of the samples, in microseconds
+} IoT_Latency_Histogram;
+
+/**
+ * @brief MQTT Client Statistics
+ *
+ * Defining a type for the counters kept by a client since it was initialized.
+ * Packet counters are indexed by MQTT control packet type, from 1 for CONNECT to 14 for DISCONNECT.
+ *
+ */
+typedef struct {
+	uint32_t packetsIn[AWS_IOT_MQTT_STATS_PACKET_TYPES]; ///< Packets received, per type
+	uint32_t packetsOut[AWS_IOT_MQTT_STATS_PACKET_TYPES]; ///< Packets sent, per type
+	uint64_t bytesIn[AWS_IOT_MQTT_STATS_PACKET_TYPES]; ///< Bytes received, per type, fixed header included
+	uint64_t bytesOut[AWS_IOT_MQTT_STATS_PACKET_TYPES]; ///< Bytes sent, per type, fixed header included
+	uint32_t droppedMessages; ///< Received messages dropped because they did not fit in the incoming data buffer
+	IoT_Latency_Histogram pubackLatency; ///< Time from sending a QoS1 PUBLISH to receiving its PUBACK
+	IoT_Latency_Histogram subackLatency; ///< Time from sending a SUBSCRIBE to receiving its SUBACK
+	IoT_Latency_Histogram callbackTime; ///< Time spent in each call of a message handler
+	uint32_t yieldCount; ///< Calls of aws_iot_mqtt_yield
+	uint64_t yieldWallUs; ///< Time spent in aws_iot_mqtt_yield, in microseconds
+	uint64_t yieldBusyUs; ///< Part of yieldWallUs not spent waiting for the network, yieldBusyUs / yieldWallUs is the duty cycle
+} IoT_Client_Stats;
+#endif
+
 /**
  * @brief MQTT Client Data
  *
@@ -269,28 +601,77 @@ typedef struct _ClientData {
 	uint32_t packetTimeoutMs; ///< Timeout for reading incoming packets from the network
 	uint32_t commandTimeoutMs; ///< Timeout for processing outgoing MQTT packets
 	uint16_t keepAliveInterval; ///< Maximum interval between control packets
+	bool isKeepAliveAdaptive; ///< Whether the PINGREQ interval is learnt, see IoT_Client_Init_Params
+	uint16_t pingIntervalSec; ///< Idle time after which a PINGREQ is sent
+	uint16_t pingIntervalConfirmedSec; ///< Longest idle time the connection is known to survive, 0 until the first one
+	uint16_t pingProbeSec; ///< Idle time tested by the outstanding PINGREQ, 0 if it tests nothing new
+	bool isIdleSincePingTimer; ///< Whether nothing was received since the PINGREQ timer was restarted
 	uint32_t currentReconnectWaitInterval; ///< Current backoff period for reconnect
+	uint32_t reconnectAttempt; ///< Number of the next automatic reconnect attempt, from 1
+	uint32_t minReconnectWaitMs; ///< Lower bound of the reconnect backoff
+	uint32_t maxReconnectWaitMs; ///< Upper bound of the reconnect backoff
+	uint32_t reconnectJitterState; ///< Random state of the reconnect jitter, seeded from the client ID when 0
+	iot_reconnect_policy reconnectPolicy; ///< Decides the wait before each reconnect attempt
 	uint32_t counterNetworkDisconnected; ///< How many times this client detected a disconnection
+#ifdef AWS_IOT_MQTT_ENABLE_STATS
+	IoT_Client_Stats stats; ///< Traffic counters and latency histograms
+#endif
 
 	/* The below values are initialized with the
 	 * lengths of the TX/RX buffers and never modified
 	 * afterwards */
 	size_t writeBufSize; ///< Size of this client's outgoing data buffer
 	size_t readBufSize; ///< Size of this client's incoming data buffer
-	size_t readBufIndex; ///< Current offset into the incoming data buffer
-	unsigned char writeBuf[AWS_IOT_MQTT_TX_BUF_LEN]; ///< Buffer for outgoing data
-	unsigned char readBuf[AWS_IOT_MQTT_RX_BUF_LEN]; ///< Buffer for incoming data
+	size_t readBufIndex; ///< Number of bytes buffered in the incoming data buffer
+	size_t readBufPacketLen; ///< Length of the last complete packet at the start of the incoming data buffer
+	unsigned char *writeBuf; ///< Buffer for outgoing data
+	unsigned char *readBuf; ///< Buffer for incoming data
 
 #ifdef _ENABLE_THREAD_SUPPORT_
 	bool isBlockOnThreadLockEnabled; ///< Whether to use nonblocking or blocking mutex APIs
 	IoT_Mutex_t state_change_mutex; ///< Mutex protecting the client's state machine
 	IoT_Mutex_t tls_read_mutex; ///< Mutex protecting incoming data
 	IoT_Mutex_t tls_write_mutex; ///< Mutex protecting outgoing data
+	IoT_Mutex_t inflight_mutex; ///< Mutex protecting the in-flight publish table and the packet identifier
+	IoT_Cond_t inflight_cond; ///< Signalled with inflight_mutex held when an entry completes or is freed, or the reader leaves
+#endif
+#ifdef AWS_IOT_MQTT_OUTBOUND_QUEUE_SLOTS
+	OutboundQueue outboundQueue; ///< Packets queued by publishing threads, sent by the write buffer holder
+#endif
+#ifdef AWS_IOT_MQTT_ENABLE_OFFLINE_QUEUE
+	OfflineQueue offlineQueue; ///< Messages published while reconnecting
 #endif
 
 	IoT_Client_Connect_Params options; ///< Options passed when the client was initialized
 
-	MessageHandlers messageHandlers[AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS]; ///< Callbacks for incoming messages
+	uint16_t messageHandlerCount; ///< Number of message handlers, the most subscriptions held at a time
+	uint16_t topicTrieNodeCount; ///< Number of topic trie nodes
+	MessageHandlers *messageHandlers; ///< Callbacks for incoming messages
+	TopicTrieNode *topicTrie; ///< Subscription index over the message handlers, node 0 is the root
+	uint16_t topicTrieFreeNode; ///< Index of the first unused topic trie node
+	IoT_Client_Allocator storageAllocator; ///< Allocator of the storage block
+	void *pStorage; ///< Block holding the buffers and tables above, NULL when they are the embedded arrays
+#ifndef AWS_IOT_MQTT_DISABLE_EMBEDDED_STORAGE
+	unsigned char embeddedWriteBuf[AWS_IOT_MQTT_TX_BUF_LEN]; ///< Default outgoing data buffer
+	unsigned char embeddedReadBuf[AWS_IOT_MQTT_RX_BUF_LEN]; ///< Default incoming data buffer
+	MessageHandlers embeddedMessageHandlers[AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS]; ///< Default message handlers
+	TopicTrieNode embeddedTopicTrie[AWS_IOT_MQTT_NUM_TOPIC_TRIE_NODES]; ///< Default topic trie nodes
+	InflightPublish embeddedInflightPublishes[AWS_IOT_MQTT_MAX_INFLIGHT_PUBLISHES]; ///< Default in-flight publishes
+	TimerWheelEntry embeddedInflightWheelEntries[AWS_IOT_MQTT_MAX_INFLIGHT_PUBLISHES]; ///< Default timer wheel entries
+#ifdef AWS_IOT_MQTT_INFLIGHT_PACKET_LEN
+	unsigned char embeddedInflightStore[AWS_IOT_MQTT_MAX_INFLIGHT_PUBLISHES * AWS_IOT_MQTT_INFLIGHT_PACKET_LEN]; ///< Default stored PUBLISH packets
+#endif
+#ifdef AWS_IOT_MQTT_OUTBOUND_QUEUE_SLOTS
+	OutboundSlot embeddedOutboundSlots[AWS_IOT_MQTT_OUTBOUND_QUEUE_SLOTS]; ///< Default outbound queue slots
+#endif
+#endif
+	uint16_t inflightPublishCount; ///< Number of in-flight entries, the most QoS1 publishes awaiting a PUBACK at a time
+	InflightPublish *inflightPublishes; ///< QoS1 publishes awaiting PUBACK
+	TimerWheel inflightWheel; ///< PUBACK deadlines of the in-flight publishes
+	TimerWheelEntry *inflightWheelEntries; ///< Timer wheel entries, one per in-flight publish
+#ifdef AWS_IOT_MQTT_INFLIGHT_PACKET_LEN
+	unsigned char *inflightStore; ///< PUBLISH packets resent after reconnecting, AWS_IOT_MQTT_INFLIGHT_PACKET_LEN bytes per in-flight entry
+#endif
 	iot_disconnect_handler disconnectHandler; ///< Callback when a disconnection is detected
 	void *disconnectHandlerData; ///< Context for disconnect handler
 } ClientData;
@@ -399,6 +780,73 @@ IoT_Error_t aws_iot_mqtt_set_disconnect_handler(AWS_IoT_Client *pClient, iot_dis
  */
 IoT_Error_t aws_iot_mqtt_autoreconnect_set_status(AWS_IoT_Client *pClient, bool newStatus);
 
+/**
+ * @brief Reconnect policy with decorrelated jitter
+ *
+ * The default reconnect policy. The first attempt is made at once, as most disconnects are
+ * transient. Each later wait is drawn at random between the minimum wait and three times the
+ * previous wait, capped at the maximum wait. The randomness is seeded from the client ID, so
+ * that a fleet disconnected at the same time does not come back in waves. Never gives up.
+ *
+ * @param pClient Reference to the IoT Client
+ * @param attempt Number of the reconnect attempt, from 1
+ * @param previousWait_ms Wait before the previous attempt, 0 before the first one
+ *
+ * @return uint32_t wait before the attempt, in milliseconds
+ */
+uint32_t aws_iot_mqtt_reconnect_policy_decorrelated_jitter(AWS_IoT_Client *pClient, uint32_t attempt,
+														   uint32_t previousWait_ms);
+
+/**
+ * @brief Reconnect policy with exponential backoff
+ *
+ * The wait starts at the minimum wait and doubles after every failed attempt. Gives up once
+ * it would exceed the maximum wait. This was the only behavior of earlier versions.
+ *
+ * @param pClient Reference to the IoT Client
+ * @param attempt Number of the reconnect attempt, from 1
+ * @param previousWait_ms Wait before the previous attempt, 0 before the first one
+ *
+ * @return uint32_t wait before the attempt in milliseconds, or AWS_IOT_MQTT_RECONNECT_GIVE_UP
+ */
+uint32_t aws_iot_mqtt_reconnect_policy_exponential(AWS_IoT_Client *pClient, uint32_t attempt,
+												   uint32_t previousWait_ms);
+
+/**
+ * @brief Get the size of the storage block of a client
+ *
+ * The block allocated through IoT_Client_Init_Params.pStorageAllocator holds the buffers, the
+ * message handlers, the topic trie nodes, the in-flight publishes with their stored packets
+ * and the outbound queue slots of the client. Use it to size an arena.
+ *
+ * @param pInitParams Initialization parameters of the client, sizes left at 0 take the values of aws_iot_config.h
+ *
+ * @return size_t size of the block in bytes, 0 if a size is out of range
+ */
+size_t aws_iot_mqtt_get_storage_size(const IoT_Client_Init_Params *pInitParams);
+
+/**
+ * @brief Initialize a storage arena
+ *
+ * @param pArena Arena to initialize
+ * @param pBuffer Region the client storage is carved from
+ * @param size Size of the region in bytes
+ */
+void aws_iot_mqtt_arena_init(IoT_Client_Arena *pArena, void *pBuffer, size_t size);
+
+/**
+ * @brief Allocate a block from a storage arena
+ *
+ * Matches IoT_Client_Allocator.allocate, with the arena as context and no release function.
+ * Blocks are aligned on AWS_IOT_MQTT_STORAGE_ALIGNMENT bytes.
+ *
+ * @param pArena The IoT_Client_Arena to allocate from
+ * @param size Size of the block in bytes
+ *
+ * @return Pointer to the block, NULL if the arena has no room left
+ */
+void *aws_iot_mqtt_arena_allocate(void *pArena, size_t size);
+
 /**
  * @brief Get count of Network Disconnects
  *
@@ -419,6 +867,22 @@ uint32_t aws_iot_mqtt_get_network_disconnected_count(AWS_IoT_Client *pClient);
  */
 void aws_iot_mqtt_reset_network_disconnected_count(AWS_IoT_Client *pClient);
 
+#ifdef AWS_IOT_MQTT_ENABLE_STATS
+/**
+ * @brief Get the statistics of the client
+ *
+ * Called to copy the traffic counters and latency histograms kept since the client was
+ * initialized. The copy is taken without locking, counters updated by other threads
+ * meanwhile may be a few packets apart from each other.
+ *
+ * @param pClient Reference to the IoT Client
+ * @param pStats Output parameter receiving the statistics
+ *
+ * @return IoT_Error_t Type defining successful/failed API call
+ */
+IoT_Error_t aws_iot_mqtt_get_stats(AWS_IoT_Client *pClient, IoT_Client_Stats *pStats);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
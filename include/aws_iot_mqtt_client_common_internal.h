@@ -69,6 +69,9 @@ typedef enum msgTypes {
 	DISCONNECT = 14
 } MessageTypes;
 
+/** Largest value that can be encoded in the remaining length field */
+#define MAX_MQTT_REMAINING_LENGTH 268435455u
+
 /* Macros for parsing header fields from incoming MQTT frame. */
 #define MQTT_HEADER_FIELD_TYPE(_byte)	((_byte >> 4) & 0x0F) /**< Message type */
 #define MQTT_HEADER_FIELD_DUP(_byte)	((_byte & (1 << 3)) >> 3) /**< DUP flag */
@@ -105,9 +108,18 @@ void aws_iot_mqtt_internal_write_char(unsigned char **pptr, unsigned char c);
 void aws_iot_mqtt_internal_write_utf8_string(unsigned char **pptr, const char *string, uint16_t stringLen);
 
 IoT_Error_t aws_iot_mqtt_internal_flushBuffers( AWS_IoT_Client *pClient );
+IoT_Error_t aws_iot_mqtt_internal_lock_write_buffer(AWS_IoT_Client *pClient);
+IoT_Error_t aws_iot_mqtt_internal_unlock_write_buffer(AWS_IoT_Client *pClient, IoT_Error_t rc);
 IoT_Error_t aws_iot_mqtt_internal_send_packet(AWS_IoT_Client *pClient, size_t length, Timer *pTimer);
+void aws_iot_mqtt_internal_keep_alive_init(AWS_IoT_Client *pClient);
+void aws_iot_mqtt_internal_restart_ping_timer(AWS_IoT_Client *pClient);
+IoT_Error_t aws_iot_mqtt_internal_send_packet_with_payload(AWS_IoT_Client *pClient, size_t headerLength,
+														 const unsigned char *pPayload, size_t payloadLength,
+														 Timer *pTimer);
 IoT_Error_t aws_iot_mqtt_internal_cycle_read(AWS_IoT_Client *pClient, Timer *pTimer, uint8_t *pPacketType);
 IoT_Error_t aws_iot_mqtt_internal_wait_for_read(AWS_IoT_Client *pClient, uint8_t packetType, Timer *pTimer);
+IoT_Error_t aws_iot_mqtt_internal_read_available(AWS_IoT_Client *pClient, bool *pIsBufferFull);
+bool aws_iot_mqtt_internal_is_packet_buffered(AWS_IoT_Client *pClient);
 IoT_Error_t aws_iot_mqtt_internal_serialize_zero(unsigned char *pTxBuf, size_t txBufLen,
 												 MessageTypes packetType, size_t *pSerializedLength);
 IoT_Error_t aws_iot_mqtt_internal_deserialize_publish(uint8_t *dup, QoS *qos,
@@ -116,6 +128,59 @@ IoT_Error_t aws_iot_mqtt_internal_deserialize_publish(uint8_t *dup, QoS *qos,
 													  unsigned char **payload, size_t *payloadLen,
 													  unsigned char *pRxBuf, size_t rxBufLen);
 
+IoT_Error_t aws_iot_mqtt_internal_complete_inflight_publish(AWS_IoT_Client *pClient, uint16_t packetId);
+void aws_iot_mqtt_internal_expire_inflight_publishes(AWS_IoT_Client *pClient);
+uint32_t aws_iot_mqtt_internal_inflight_deadline_ms(AWS_IoT_Client *pClient);
+void aws_iot_mqtt_internal_abort_inflight_publishes(AWS_IoT_Client *pClient, IoT_Error_t status);
+#ifdef _ENABLE_THREAD_SUPPORT_
+void aws_iot_mqtt_internal_wake_inflight_waiters(AWS_IoT_Client *pClient);
+#endif
+#ifdef AWS_IOT_MQTT_INFLIGHT_PACKET_LEN
+IoT_Error_t aws_iot_mqtt_internal_resend_inflight_publishes(AWS_IoT_Client *pClient, Timer *pTimer);
+#endif
+
+#ifdef AWS_IOT_MQTT_OUTBOUND_QUEUE_SLOTS
+void aws_iot_mqtt_internal_outbound_queue_init(AWS_IoT_Client *pClient);
+OutboundSlot *aws_iot_mqtt_internal_outbound_queue_claim(AWS_IoT_Client *pClient);
+void aws_iot_mqtt_internal_outbound_queue_commit(OutboundSlot *pSlot, size_t len);
+IoT_Error_t aws_iot_mqtt_internal_outbound_queue_flush(AWS_IoT_Client *pClient);
+void aws_iot_mqtt_internal_outbound_queue_discard(AWS_IoT_Client *pClient);
+IoT_Error_t aws_iot_mqtt_internal_outbound_queue_send(AWS_IoT_Client *pClient);
+#endif
+
+#ifdef AWS_IOT_MQTT_ENABLE_OFFLINE_QUEUE
+IoT_Error_t aws_iot_mqtt_internal_offline_queue_init(AWS_IoT_Client *pClient, IoT_Client_Init_Params *pInitParams);
+IoT_Error_t aws_iot_mqtt_internal_offline_queue_free(AWS_IoT_Client *pClient);
+IoT_Error_t aws_iot_mqtt_internal_offline_queue_append(AWS_IoT_Client *pClient, const char *pTopicName,
+													   uint16_t topicNameLen, IoT_Publish_Message_Params *pParams);
+IoT_Error_t aws_iot_mqtt_internal_offline_queue_drain(AWS_IoT_Client *pClient);
+uint32_t aws_iot_mqtt_internal_offline_queue_deadline_ms(AWS_IoT_Client *pClient);
+IoT_Error_t aws_iot_mqtt_internal_publish_offline_message(AWS_IoT_Client *pClient, const char *pTopicName,
+														  uint16_t topicNameLen, IoT_Publish_Message_Params *pParams,
+														  pPublishCompleteHandler_t pCompleteHandler,
+														  void *pCompleteHandlerData);
+#endif
+
+#ifdef AWS_IOT_MQTT_ENABLE_STATS
+void aws_iot_mqtt_internal_stats_count_sent(AWS_IoT_Client *pClient, const unsigned char *pPackets, size_t length);
+void aws_iot_mqtt_internal_stats_count_received(AWS_IoT_Client *pClient, unsigned char headerByte, size_t length);
+void aws_iot_mqtt_internal_stats_record(IoT_Latency_Histogram *pHistogram, uint32_t startUs);
+void aws_iot_mqtt_internal_stats_record_yield(AWS_IoT_Client *pClient, uint32_t startUs, uint32_t idleUs);
+#endif
+
+IoT_Error_t aws_iot_mqtt_internal_storage_init(AWS_IoT_Client *pClient, IoT_Client_Init_Params *pInitParams);
+void aws_iot_mqtt_internal_storage_free(AWS_IoT_Client *pClient);
+
+void aws_iot_mqtt_internal_topic_trie_init(AWS_IoT_Client *pClient);
+bool aws_iot_mqtt_internal_topic_trie_has_room(AWS_IoT_Client *pClient, const char *pTopicFilter,
+											   uint16_t topicFilterLen);
+IoT_Error_t aws_iot_mqtt_internal_topic_trie_insert(AWS_IoT_Client *pClient, uint32_t handlerIndex);
+void aws_iot_mqtt_internal_topic_trie_remove(AWS_IoT_Client *pClient, uint32_t handlerIndex);
+uint32_t aws_iot_mqtt_internal_topic_trie_find(AWS_IoT_Client *pClient, const char *pTopicFilter,
+											   uint16_t topicFilterLen);
+uint32_t aws_iot_mqtt_internal_topic_trie_match(AWS_IoT_Client *pClient, const char *pTopicName, uint16_t topicNameLen,
+												uint16_t *pHandlerList);
+
 IoT_Error_t aws_iot_mqtt_set_client_state(AWS_IoT_Client *pClient, ClientState expectedCurrentState,
 										  ClientState newState);
 
@@ -100,6 +100,18 @@ IoT_Error_t aws_iot_mqtt_connect(AWS_IoT_Client *pClient, IoT_Client_Connect_Par
  * @note Call is blocking.  In the case of a QoS 0 message the function returns
  * after the message was successfully passed to the TLS layer.  In the case of QoS 1
  * the function returns after the receipt of the PUBACK control packet.
+ * @note The payload is sent from the caller's buffer without being copied into the
+ * client write buffer, so its size is not limited by AWS_IOT_MQTT_TX_BUF_LEN.
+ * @note With thread support, publishing is allowed while another thread is in
+ * aws_iot_mqtt_yield. The PUBACK of a QoS 1 message is then received by the yielding
+ * thread, and the publish uses an entry of the in-flight table while it waits. On a
+ * persistent session with AWS_IOT_MQTT_INFLIGHT_PACKET_LEN set, the entry keeps a copy of the
+ * packet as for aws_iot_mqtt_publish_async: if the yielding thread reconnects before the
+ * command timeout, the message is sent again and the publish completes with its PUBACK.
+ * A QoS 1 publish that reads its own PUBACK fails as soon as the connection is lost and is
+ * not sent again.
+ * @note With an offline queue, a message published while the client waits to reconnect
+ * is stored and returns MQTT_PUBLISH_QUEUED_OFFLINE, see aws_iot_mqtt_publish_async.
  *
  * @param pClient Reference to the IoT Client
  * @param pTopicName Topic Name to publish to
@@ -111,6 +123,67 @@ IoT_Error_t aws_iot_mqtt_connect(AWS_IoT_Client *pClient, IoT_Client_Connect_Par
 IoT_Error_t aws_iot_mqtt_publish(AWS_IoT_Client *pClient, const char *pTopicName, uint16_t topicNameLen,
 								 IoT_Publish_Message_Params *pParams);
 
+/**
+ * @brief Publish an MQTT message on a topic without waiting for the PUBACK
+ *
+ * Called to publish an MQTT message on a topic.
+ * @note Call is non-blocking with respect to the acknowledgment. The function returns
+ * after the message was successfully passed to the TLS layer. For QoS 1 the packet
+ * identifier is returned in pParams->id and the PUBACK is processed by a later call to
+ * aws_iot_mqtt_yield, which invokes pCompleteHandler with the matching packet identifier.
+ * If no PUBACK arrives within the command timeout, or the connection is lost, the handler is
+ * invoked with an error status. Up to IoT_Client_Init_Params.inflightPublishCount messages,
+ * #AWS_IOT_MQTT_MAX_INFLIGHT_PUBLISHES by default, can be awaiting acknowledgment at any given time.
+ * When the client is connected without a clean session and AWS_IOT_MQTT_INFLIGHT_PACKET_LEN is
+ * set in aws_iot_config.h, messages that fit in that length survive the loss of the connection:
+ * they are sent again with the DUP flag after reconnecting and complete with their PUBACK.
+ * When AWS_IOT_MQTT_ENABLE_OFFLINE_QUEUE is defined and pOfflineQueuePath is set in the init
+ * parameters, a message published while the client waits to reconnect is appended to the
+ * persistent offline queue and MQTT_PUBLISH_QUEUED_OFFLINE is returned. Queued messages are
+ * published by aws_iot_mqtt_yield once the client has reconnected, up to
+ * AWS_IOT_MQTT_OFFLINE_QUEUE_DRAIN_BATCH every AWS_IOT_MQTT_OFFLINE_QUEUE_DRAIN_INTERVAL_MS,
+ * without a completion handler and possibly after messages published since reconnecting.
+ *
+ * @param pClient Reference to the IoT Client
+ * @param pTopicName Topic Name to publish to
+ * @param topicNameLen Length of the topic name
+ * @param pParams Pointer to Publish Message parameters
+ * @param pCompleteHandler Reference to the handler invoked when a QoS 1 message completes. Can be NULL
+ * @param pCompleteHandlerData Point to data passed to the completion handler
+ *
+ * @return An IoT Error Type defining successful/failed publish.
+ *         MQTT_MAX_INFLIGHT_PUBLISHES_REACHED_ERROR if the in-flight window is full
+ */
+IoT_Error_t aws_iot_mqtt_publish_async(AWS_IoT_Client *pClient, const char *pTopicName, uint16_t topicNameLen,
+									   IoT_Publish_Message_Params *pParams, pPublishCompleteHandler_t pCompleteHandler,
+									   void *pCompleteHandlerData);
+
+/**
+ * @brief Get the number of QoS1 publishes awaiting PUBACK
+ *
+ * Called to get the number of messages sent with aws_iot_mqtt_publish_async that
+ * have not completed yet
+ *
+ * @param pClient Reference to the IoT Client
+ *
+ * @return uint32_t the in-flight count
+ */
+uint32_t aws_iot_mqtt_get_inflight_publish_count(AWS_IoT_Client *pClient);
+
+#ifdef AWS_IOT_MQTT_ENABLE_OFFLINE_QUEUE
+/**
+ * @brief Get the number of messages in the offline queue
+ *
+ * Called to get the number of messages published while reconnecting that have not
+ * been sent yet, including those recovered from a previous run
+ *
+ * @param pClient Reference to the IoT Client
+ *
+ * @return uint32_t the queued message count
+ */
+uint32_t aws_iot_mqtt_get_offline_message_count(AWS_IoT_Client *pClient);
+#endif
+
 /**
  * @brief Subscribe to an MQTT topic.
  *
@@ -128,22 +201,77 @@ IoT_Error_t aws_iot_mqtt_publish(AWS_IoT_Client *pClient, const char *pTopicName
  * @param pApplicationHandlerData Point to data passed to the callback. pApplicationHandlerData
  * also needs to be static in memory since no malloc is performed by the SDK
  *
- * @return An IoT Error Type defining successful/failed subscription
+ * @return An IoT Error Type defining successful/failed subscription.
+ *         MQTT_SUBSCRIBE_REJECTED_ERROR, without registering the handler, if the broker refused it
  */
 IoT_Error_t aws_iot_mqtt_subscribe(AWS_IoT_Client *pClient, const char *pTopicName, uint16_t topicNameLen,
 								   QoS qos, pApplicationHandler_t pApplicationHandler, void *pApplicationHandlerData);
 
+/**
+ * @brief Subscribe to an MQTT topic and receive its messages in fragments.
+ *
+ * Same as aws_iot_mqtt_subscribe, but the payload of every message on the topic is passed
+ * to pApplicationFragmentHandler as a sequence of fragments. Messages that do not fit in
+ * the incoming data buffer are streamed through it instead of being dropped, so messages
+ * of any size can be received with a buffer of AWS_IOT_MQTT_RX_BUF_LEN bytes. Messages that
+ * fit are delivered as a single fragment.
+ * @note Call is blocking.  The call returns after the receipt of the SUBACK control packet.
+ * @warning pTopicName and pApplicationHandlerData need to be static in memory.
+ * @warning The rest of a streamed message is read from the network between fragments. The
+ * fragment handler must not call functions that wait for a response from the broker.
+ * If reading the rest of a message fails or times out, the handler gets no further fragment
+ * for it and the connection is closed, then reconnected if auto-reconnect is enabled. The
+ * next message then starts at payloadOffset 0 before the previous one reached payloadTotalLen.
+ *
+ * @param pClient Reference to the IoT Client
+ * @param pTopicName Topic Name to publish to. pTopicName needs to be static in memory since
+ * no malloc is performed by the SDK
+ * @param topicNameLen Length of the topic name
+ * @param qos Quality of service for subscription
+ * @param pApplicationFragmentHandler Reference to the fragment handler function for this subscription
+ * @param pApplicationHandlerData Point to data passed to the callback. pApplicationHandlerData
+ * also needs to be static in memory since no malloc is performed by the SDK
+ *
+ * @return An IoT Error Type defining successful/failed subscription
+ */
+IoT_Error_t aws_iot_mqtt_subscribe_streaming(AWS_IoT_Client *pClient, const char *pTopicName, uint16_t topicNameLen,
+											 QoS qos, pApplicationFragmentHandler_t pApplicationFragmentHandler,
+											 void *pApplicationHandlerData);
+
+/**
+ * @brief Subscribe to several MQTT topics.
+ *
+ * Called to send subscribe messages to the broker requesting subscriptions to a list of
+ * topics. As many topics as fit in the client write buffer are requested in one SUBSCRIBE
+ * control packet, so the call takes one round trip per packet instead of one per topic.
+ * The outcome for each topic is returned in its result field: SUCCESS, MQTT_SUBSCRIBE_REJECTED_ERROR
+ * if the broker refused it, or the error that stopped the request before the topic was acknowledged.
+ * @note Call is blocking.  The call returns after the receipt of the SUBACK control packet for the last topics.
+ * @warning The topic names and handler data of the list need to be static in memory. The list itself does not.
+ *
+ * @param pClient Reference to the IoT Client
+ * @param pSubscribeList Array of the topics to subscribe to
+ * @param subscribeCount Number of topics in the array
+ *
+ * @return An IoT Error Type defining successful/failed subscription. SUCCESS if every topic was subscribed.
+ *         MQTT_MAX_SUBSCRIPTIONS_REACHED_ERROR, without sending anything, if the client cannot hold all the topics
+ */
+IoT_Error_t aws_iot_mqtt_subscribe_batch(AWS_IoT_Client *pClient, IoT_Subscribe_Params *pSubscribeList,
+										 uint32_t subscribeCount);
+
 /**
  * @brief Subscribe to an MQTT topic.
  *
  * Called to resubscribe to the topics that the client has active subscriptions on.
- * Internally called when autoreconnect is enabled
+ * Internally called when autoreconnect is enabled. Topics the broker refuses on the new
+ * connection are removed along with their handler.
  *
  * @note Call is blocking.  The call returns after the receipt of the SUBACK control packet.
  *
  * @param pClient Reference to the IoT Client
  *
- * @return An IoT Error Type defining successful/failed subscription
+ * @return An IoT Error Type defining successful/failed subscription.
+ *         MQTT_SUBSCRIBE_REJECTED_ERROR if a topic was refused, the others are subscribed
  */
 IoT_Error_t aws_iot_mqtt_resubscribe(AWS_IoT_Client *pClient);
 
@@ -162,6 +290,25 @@ IoT_Error_t aws_iot_mqtt_resubscribe(AWS_IoT_Client *pClient);
  */
 IoT_Error_t aws_iot_mqtt_unsubscribe(AWS_IoT_Client *pClient, const char *pTopicFilter, uint16_t topicFilterLen);
 
+/**
+ * @brief Unsubscribe from several MQTT topics.
+ *
+ * Called to send unsubscribe messages to the broker requesting removal of the subscriptions
+ * to a list of topic filters. As many filters as fit in the client write buffer are sent in
+ * one UNSUBSCRIBE control packet.
+ * @note Call is blocking.  The call returns after the receipt of the UNSUBACK control packet for the last filters.
+ *
+ * @param pClient Reference to the IoT Client
+ * @param pTopicFilterList Array of the topic filters of the subscriptions
+ * @param pTopicFilterLenList Array of the lengths of the topic filters
+ * @param topicFilterCount Number of topic filters in the arrays
+ *
+ * @return An IoT Error Type defining successful/failed unsubscribe call.
+ *         FAILURE, without sending anything, if one of the filters has no subscription
+ */
+IoT_Error_t aws_iot_mqtt_unsubscribe_batch(AWS_IoT_Client *pClient, const char **pTopicFilterList,
+										   uint16_t *pTopicFilterLenList, uint32_t topicFilterCount);
+
 /**
  * @brief Disconnect an MQTT Connection
  *
@@ -192,6 +339,53 @@ IoT_Error_t aws_iot_mqtt_disconnect(AWS_IoT_Client *pClient);
  */
 IoT_Error_t aws_iot_mqtt_yield(AWS_IoT_Client *pClient, uint32_t timeout_ms);
 
+/** Returned by aws_iot_mqtt_get_next_deadline_ms when no timer is running */
+#define AWS_IOT_MQTT_NO_DEADLINE UINT32_MAX
+
+/**
+ * @brief Process the work that is ready, without waiting
+ *
+ * Alternative to aws_iot_mqtt_yield for applications running their own event loop.
+ * Handles the packets already received, invoking the subscription and publish completion
+ * callbacks, then sends the keep-alive PINGREQ and expires the publishes that are due.
+ * Call it when the socket returned by aws_iot_mqtt_get_network_fd is readable, or when
+ * the time returned by aws_iot_mqtt_get_next_deadline_ms has elapsed.
+ * Only a packet larger than the receive buffer, or a reconnect attempt once its delay
+ * has elapsed, waits on the network.
+ *
+ * @param pClient Reference to the IoT Client
+ *
+ * @return An IoT Error Type defining successful/failed client processing.
+ *         If this call results in an error it is likely the MQTT connection has dropped.
+ */
+IoT_Error_t aws_iot_mqtt_process_ready(AWS_IoT_Client *pClient);
+
+/**
+ * @brief Get the file descriptor of the client's network socket
+ *
+ * The descriptor changes on every reconnect, it must be fetched again after
+ * aws_iot_mqtt_process_ready returns NETWORK_RECONNECTED.
+ *
+ * @param pClient Reference to the IoT Client
+ *
+ * @return socket file descriptor to wait on for readability, -1 if the client is not
+ *         connected or the network layer does not provide one
+ */
+int aws_iot_mqtt_get_network_fd(AWS_IoT_Client *pClient);
+
+/**
+ * @brief Get the time until aws_iot_mqtt_process_ready has timer work to do
+ *
+ * Covers the keep-alive, PUBACK timeouts of in-flight publishes and the auto-reconnect
+ * delay. The application can use it as the timeout of its poll call.
+ *
+ * @param pClient Reference to the IoT Client
+ *
+ * @return milliseconds until the next deadline, 0 if work is ready now,
+ *         AWS_IOT_MQTT_NO_DEADLINE if no timer is running
+ */
+uint32_t aws_iot_mqtt_get_next_deadline_ms(AWS_IoT_Client *pClient);
+
 /**
  * @brief MQTT Manual Re-Connection Function
  *
@@ -0,0 +1,216 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file aws_iot_mqtt_reactor.h
+ * @brief Reactor driving many MQTT clients from a single thread
+ *
+ * The reactor waits on the sockets of all registered clients at once and keeps their
+ * keep-alive, PUBACK timeout and reconnect deadlines in one timer heap. A client is only
+ * processed, with aws_iot_mqtt_process_ready, when its socket is readable or its next
+ * deadline has elapsed, so idle clients cost nothing.
+ * The Linux implementation, based on epoll, is in platform/linux/epoll.
+ */
+
+#ifndef AWS_IOT_SDK_SRC_IOT_MQTT_REACTOR_H
+#define AWS_IOT_SDK_SRC_IOT_MQTT_REACTOR_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "aws_iot_mqtt_client_interface.h"
+
+#ifndef AWS_IOT_MQTT_REACTOR_MAX_CLIENTS
+/** Maximum number of clients registered with one reactor, if not set in aws_iot_config.h */
+#define AWS_IOT_MQTT_REACTOR_MAX_CLIENTS 64
+#endif
+
+#ifndef AWS_IOT_MQTT_REACTOR_MAX_EVENTS
+/** Maximum number of socket events handled per wait of the reactor, if not set in aws_iot_config.h */
+#define AWS_IOT_MQTT_REACTOR_MAX_EVENTS 64
+#endif
+
+/** Index value marking a reactor client that is not in the timer heap, or the end of a list */
+#define REACTOR_INDEX_NONE UINT32_MAX
+
+typedef struct _Reactor AWS_IoT_Reactor;
+
+/**
+ * @brief Reactor Event Callback Handler Type
+ *
+ * Defining a TYPE for definition of reactor event function pointers.
+ * Called with every result other than SUCCESS returned by aws_iot_mqtt_process_ready for a
+ * registered client, for instance NETWORK_ATTEMPTING_RECONNECT or NETWORK_RECONNECTED.
+ * The handler can unregister the client.
+ * Also called with NETWORK_RECONNECT_DUE when the reconnect delay of the client has elapsed.
+ * The reactor does not make the attempt, it blocks until the broker answers. The client is
+ * no longer processed, the application calls aws_iot_mqtt_process_ready on it from a thread
+ * of its own until the result is not NETWORK_ATTEMPTING_RECONNECT, then calls
+ * aws_iot_mqtt_reactor_resume from that thread. Calling aws_iot_mqtt_process_ready and
+ * aws_iot_mqtt_reactor_update from the handler is allowed, it holds up the other clients
+ * for the duration of the attempt.
+ *
+ */
+typedef void (*iot_reactor_event_handler)(AWS_IoT_Reactor *pReactor, AWS_IoT_Client *pClient, IoT_Error_t rc,
+										  void *pEventHandlerData);
+
+/**
+ * @brief Reactor Client
+ *
+ * Defining a type for the clients registered with a reactor.
+ *
+ */
+typedef struct _ReactorClient {
+	AWS_IoT_Client *pClient; ///< Registered client, NULL if this entry is available
+	int fd; ///< Socket of the client that the reactor waits on, -1 if none
+	uint64_t deadlineMs; ///< Time at which the client has timer work to do, on the reactor clock
+	uint32_t heapIndex; ///< Position of this entry in the timer heap, REACTOR_INDEX_NONE if no timer is running
+	uint32_t nextDue; ///< Next entry whose deadline has elapsed, while the reactor processes them
+	uint32_t nextResume; ///< Next entry of the resume list, while isResumePending is set
+	bool isResumePending; ///< Whether aws_iot_mqtt_reactor_resume was called and the entry is not updated yet
+	iot_reactor_event_handler eventHandler; ///< Application function to invoke on client events
+	void *pEventHandlerData; ///< Context to pass to event handler
+} ReactorClient;
+
+/**
+ * @brief MQTT Reactor
+ *
+ * Defining a type for the reactor. The timer heap holds the indexes of the registered
+ * clients that have a deadline, earliest deadline first. The resume list holds the clients
+ * that other threads asked to update, it is emptied by the reactor thread once woken up.
+ *
+ */
+struct _Reactor {
+	int pollFd; ///< Descriptor of the platform readiness notification mechanism
+	int wakeFd; ///< Descriptor signalled by aws_iot_mqtt_reactor_resume to interrupt the wait
+	uint32_t firstResume; ///< Head of the resume list, REACTOR_INDEX_NONE if empty
+#ifdef _ENABLE_THREAD_SUPPORT_
+	IoT_Mutex_t resumeLock; ///< Mutex protecting the resume list and the registered clients
+#endif
+	uint32_t clientCount; ///< Number of registered clients
+	uint32_t timerHeapSize; ///< Number of entries in the timer heap
+	ReactorClient clients[AWS_IOT_MQTT_REACTOR_MAX_CLIENTS]; ///< Registered clients
+	uint32_t timerHeap[AWS_IOT_MQTT_REACTOR_MAX_CLIENTS]; ///< Indexes of clients, ordered by deadline
+};
+
+/**
+ * @brief Reactor Initialization Function
+ *
+ * Called to initialize the reactor before registering clients
+ *
+ * @param pReactor Reference to the reactor
+ *
+ * @return An IoT Error Type defining successful/failed Initialization
+ */
+IoT_Error_t aws_iot_mqtt_reactor_init(AWS_IoT_Reactor *pReactor);
+
+/**
+ * @brief Reactor Destroy Function
+ *
+ * Releases the resources of the reactor. Registered clients are left untouched.
+ *
+ * @param pReactor Reference to the reactor
+ *
+ * @return An IoT Error Type defining successful/failed cleanup
+ */
+IoT_Error_t aws_iot_mqtt_reactor_destroy(AWS_IoT_Reactor *pReactor);
+
+/**
+ * @brief Register a client with the reactor
+ *
+ * From now on the client is processed by aws_iot_mqtt_reactor_run_once, the application
+ * must not call aws_iot_mqtt_yield on it. A client that is not connected yet is picked
+ * up when aws_iot_mqtt_reactor_update is called after connecting it.
+ *
+ * @param pReactor Reference to the reactor
+ * @param pClient Reference to the IoT Client
+ * @param eventHandler Function to call with client events, can be NULL
+ * @param pEventHandlerData Data to pass to the event handler
+ *
+ * @return An IoT Error Type defining successful/failed registration.
+ *         LIMIT_EXCEEDED_ERROR if AWS_IOT_MQTT_REACTOR_MAX_CLIENTS clients are registered
+ */
+IoT_Error_t aws_iot_mqtt_reactor_register(AWS_IoT_Reactor *pReactor, AWS_IoT_Client *pClient,
+										  iot_reactor_event_handler eventHandler, void *pEventHandlerData);
+
+/**
+ * @brief Unregister a client from the reactor
+ *
+ * @param pReactor Reference to the reactor
+ * @param pClient Reference to the IoT Client
+ *
+ * @return An IoT Error Type defining successful/failed operation.
+ *         FAILURE if the client is not registered
+ */
+IoT_Error_t aws_iot_mqtt_reactor_unregister(AWS_IoT_Reactor *pReactor, AWS_IoT_Client *pClient);
+
+/**
+ * @brief Refresh the socket and deadline of a registered client
+ *
+ * Needed when the client was used outside of the reactor callbacks, for instance after
+ * connecting it or publishing with aws_iot_mqtt_publish_async, so that the new connection
+ * and timers are taken into account.
+ *
+ * @param pReactor Reference to the reactor
+ * @param pClient Reference to the IoT Client
+ *
+ * @return An IoT Error Type defining successful/failed operation.
+ *         FAILURE if the client is not registered
+ */
+IoT_Error_t aws_iot_mqtt_reactor_update(AWS_IoT_Reactor *pReactor, AWS_IoT_Client *pClient);
+
+/**
+ * @brief Have the reactor thread refresh the socket and deadline of a registered client
+ *
+ * Same as aws_iot_mqtt_reactor_update, but callable from any thread, for instance the one that
+ * reconnected the client after NETWORK_RECONNECT_DUE. The client is queued and the wait of
+ * aws_iot_mqtt_reactor_run_once is interrupted, the update is done by the reactor thread.
+ * A NETWORK_POLL_ERROR of the update is reported to the event handler of the client.
+ * Without _ENABLE_THREAD_SUPPORT_ it can only be called from the reactor thread.
+ *
+ * @param pReactor Reference to the reactor
+ * @param pClient Reference to the IoT Client
+ *
+ * @return An IoT Error Type defining successful/failed operation.
+ *         FAILURE if the client is not registered, NETWORK_POLL_ERROR if the reactor could not be woken up
+ */
+IoT_Error_t aws_iot_mqtt_reactor_resume(AWS_IoT_Reactor *pReactor, AWS_IoT_Client *pClient);
+
+/**
+ * @brief Wait for and process the work of the registered clients
+ *
+ * Waits until a client socket is readable, a client deadline elapses or the timeout
+ * expires, then processes the clients concerned. Subscription and publish completion
+ * callbacks are called from here. Applications call it in a loop.
+ * A client whose reconnect attempts have timed out is reported to its event handler
+ * with NETWORK_RECONNECT_TIMED_OUT_ERROR and is then ignored until it is updated.
+ * A client whose reconnect is due is reported with NETWORK_RECONNECT_DUE, and ignored
+ * until it is updated as well. Clients registered without an event handler are
+ * reconnected from here, which blocks the other clients while the attempt lasts.
+ *
+ * @param pReactor Reference to the reactor
+ * @param timeout_ms Maximum time to wait for work, in milliseconds
+ *
+ * @return An IoT Error Type defining successful/failed processing.
+ *         NETWORK_POLL_ERROR if waiting on the sockets failed
+ */
+IoT_Error_t aws_iot_mqtt_reactor_run_once(AWS_IoT_Reactor *pReactor, uint32_t timeout_ms);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -26,6 +26,11 @@ IoT_Error_t aws_iot_shadow_internal_action(const char *pThingName, ShadowActions
 										   const char *pJsonDocumentToBeSent, size_t jsonSize, fpActionCallback_t callback,
 										   void *pCallbackContext, uint32_t timeout_seconds, bool isSticky);
 
+IoT_Error_t aws_iot_shadow_internal_context_action(ShadowContext_t *pContext, const char *pThingName,
+												   ShadowActions_t action, const char *pJsonDocumentToBeSent,
+												   size_t jsonSize, fpActionCallback_t callback,
+												   void *pCallbackContext, uint32_t timeout_seconds, bool isSticky);
+
 #ifdef __cplusplus
 }
 #endif
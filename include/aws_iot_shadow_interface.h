@@ -73,6 +73,8 @@ typedef struct {
 	char *pMqttClientId; ///< Currently the Shadow uses MQTT to connect and it is important to ensure we have unique client id
 	uint16_t mqttClientIdLen; ///< Currently the Shadow uses MQTT to connect and it is important to ensure we have unique client id
 	pApplicationHandler_t deleteActionHandler;	///< Callback to be invoked when Thing shadow for this device is deleted
+	bool isCleanSession; ///< False to resume the MQTT session of this client id, keeping its subscriptions and unacknowledged QoS1 messages across reconnects
+	bool isAckSubscribedOnConnect; ///< True to subscribe to the accepted and rejected topics of every action on pMyThingName when connecting, so that actions on it do not subscribe before publishing
 } ShadowConnectParameters_t;
 
 /*!
@@ -93,6 +95,40 @@ extern const ShadowInitParameters_t ShadowInitParametersDefault;
  */
 extern const ShadowConnectParameters_t ShadowConnectParametersDefault;
 
+/**
+ * @brief Shadow Context
+ *
+ * The shadow state of one MQTT client: the actions waiting for their response, the subscriptions
+ * to the response topics and, for every thing, its delta registrations and last received version.
+ * The functions taking an MQTT client use a default context sized in aws_iot_config.h. A gateway
+ * acting on the shadows of many things creates its own contexts with aws_iot_shadow_context_init.
+ * Every context parses the received documents into its own tokens, so the contexts of different
+ * MQTT clients can be yielded from different threads. A context is used by one thread at a time.
+ */
+typedef struct ShadowContext ShadowContext_t;
+
+/*!
+ * @brief Shadow Context parameters
+ *
+ * @note Always use the \c ShadowContextParametersDefault to initialize this struct
+ */
+typedef struct {
+	const char *pClientId; ///< Prefix of the client tokens generated by the context, usually the MQTT client id
+	uint16_t maxThings; ///< Things with delta registrations or a tracked version. Twice as many accepted/rejected topics can be subscribed for actions
+	uint16_t maxPendingActions; ///< Actions waiting for their response at any given time
+	uint16_t maxDeltaHandlers; ///< jsonStruct_t registered on the delta topics, for all the things together
+	uint16_t maxJsonTokens; ///< JSON tokens of the largest document received, metadata included
+	IoT_Client_Allocator *pAllocator; ///< Allocates the context, see aws_iot_shadow_get_context_size. An IoT_Client_Arena can be used
+} ShadowContextParameters_t;
+
+/*!
+ * @brief This is set to defaults from the configuration file
+ * The client id and the allocator need to be assigned in code.
+ *
+ * \relates ShadowContextParameters_t
+ */
+extern const ShadowContextParameters_t ShadowContextParametersDefault;
+
 /**
 * @brief Clean shadow client from all dynamic memory allocate
 *
@@ -189,10 +225,11 @@ typedef void (*fpActionCallback_t)(const char *pThingName, ShadowActions_t actio
  * update is one of the most frequently used functionality by a device. In most cases the device may be just reporting few params to update the thing shadow in the cloud
  * Update Action if no callback or if the JSON document does not have a client token then will just publish the update and not track it.
  *
- * @note The update has to subscribe to two topics update/accepted and update/rejected. This function waits 2 seconds to ensure the subscriptions are registered before publishing the update message.
+ * @note The update has to subscribe to two topics update/accepted and update/rejected. This function waits for the SUBACK of both subscriptions before publishing the update message.
  * The following steps are performed on using this function:
- * 1. Subscribe to Shadow topics - $aws/things/{thingName}/shadow/update/accepted and $aws/things/{thingName}/shadow/update/rejected
- * 2. wait for 2 seconds for the subscription to take effect
+ * 1. Subscribe to Shadow topics - $aws/things/{thingName}/shadow/update/accepted and $aws/things/{thingName}/shadow/update/rejected,
+ *    unless they are already subscribed or isAckSubscribedOnConnect was set in the connect parameters
+ * 2. wait for the SUBACK of each subscription
  * 3. Publish on the update topic - $aws/things/{thingName}/shadow/update
  * 4. In the \c aws_iot_shadow_yield() function the response will be handled. In case of timeout or if the response is received, the subscription to shadow response topics are un-subscribed from.
  *    On the contrary if the persistent subscription is set to true then the un-subscribe will not be done. The topics will always be listened to.
@@ -249,6 +286,8 @@ IoT_Error_t aws_iot_shadow_delete(AWS_IoT_Client *pClient, const char *pThingNam
  *
  * Any time a delta is published the Json document will be delivered to the pStruct->cb. If you don't want the parsing done by the SDK then use the jsonStruct_t key set to "state". A good example of this is displayed in the sample_apps/shadow_console_echo.c
  *
+ * The key may be a path of keys separated by dots, such as "led.brightness", to tell apart keys of the same name in different objects. The first member of the delta matching the path is used.
+ *
  * @param pClient MQTT Client used as the protocol layer
  * @param pStruct The struct used to parse JSON value
  * @return An IoT Error Type defining successful/failed delta registering
@@ -298,6 +337,166 @@ void aws_iot_shadow_disable_discard_old_delta_msgs(void);
  */
 IoT_Error_t aws_iot_shadow_set_autoreconnect_status(AWS_IoT_Client *pClient, bool newStatus);
 
+/**
+ * @brief Get the size of the block allocated for a shadow context
+ *
+ * @param pParams Context parameters
+ * @return Size in bytes of the block, 0 if the parameters are invalid
+ */
+size_t aws_iot_shadow_get_context_size(const ShadowContextParameters_t *pParams);
+
+/**
+ * @brief Create a shadow context on an MQTT client
+ *
+ * The context is allocated in one block through pParams->pAllocator. The client is initialized and
+ * connected by the caller. Several contexts can share a client, each action is answered to the
+ * context that sent it.
+ *
+ * @param ppContext Output parameter, the new context
+ * @param pClient MQTT Client used as the protocol layer
+ * @param pParams Context parameters
+ * @return An IoT Error Type defining successful/failed creation
+ */
+IoT_Error_t aws_iot_shadow_context_init(ShadowContext_t **ppContext, AWS_IoT_Client *pClient,
+										const ShadowContextParameters_t *pParams);
+
+/**
+ * @brief Give the block of a shadow context back to its allocator
+ *
+ * The MQTT client keeps calling the context on the topics it subscribed, unsubscribe them or
+ * disconnect the client first.
+ *
+ * @param pContext Context created by aws_iot_shadow_context_init
+ * @return An IoT Error Type defining successful/failed operation
+ */
+IoT_Error_t aws_iot_shadow_context_free(ShadowContext_t *pContext);
+
+/**
+ * @brief Subscribe once to the responses of every action on a thing
+ *
+ * Subscribes to $aws/things/{thingName}/shadow/+/accepted and +/rejected, so that actions on the
+ * thing do not subscribe before publishing. The thing name "+" covers all the things.
+ *
+ * @param pContext Shadow context
+ * @param pThingName Thing Name, or "+"
+ * @return An IoT Error Type defining successful/failed subscription
+ */
+IoT_Error_t aws_iot_shadow_context_subscribe_acks(ShadowContext_t *pContext, const char *pThingName);
+
+/**
+ * @brief Yield function of a shadow context
+ *
+ * Times out the expired actions of the context and yields its MQTT client, see aws_iot_shadow_yield.
+ *
+ * @param pContext Shadow context
+ * @param timeout in milliseconds, the maximum time the MQTT client will wait for a message
+ * @return An IoT Error Type defining successful/failed Yield
+ */
+IoT_Error_t aws_iot_shadow_context_yield(ShadowContext_t *pContext, uint32_t timeout);
+
+/**
+ * @brief Update action of a shadow context, see aws_iot_shadow_update
+ *
+ * The client token of pJsonString is expected from aws_iot_shadow_context_finalize_json_document.
+ */
+IoT_Error_t aws_iot_shadow_context_update(ShadowContext_t *pContext, const char *pThingName, char *pJsonString,
+										  fpActionCallback_t callback, void *pContextData, uint8_t timeout_seconds,
+										  bool isPersistentSubscribe);
+
+/**
+ * @brief Get action of a shadow context, see aws_iot_shadow_get
+ */
+IoT_Error_t aws_iot_shadow_context_get(ShadowContext_t *pContext, const char *pThingName,
+									   fpActionCallback_t callback, void *pContextData, uint8_t timeout_seconds,
+									   bool isPersistentSubscribe);
+
+/**
+ * @brief Delete action of a shadow context, see aws_iot_shadow_delete
+ */
+IoT_Error_t aws_iot_shadow_context_delete(ShadowContext_t *pContext, const char *pThingName,
+										  fpActionCallback_t callback, void *pContextData, uint8_t timeout_seconds,
+										  bool isPersistentSubscribe);
+
+/**
+ * @brief Listen on the delta topic of a thing
+ *
+ * The first registration of a thing subscribes to its delta topic. Deltas are dispatched to the
+ * registrations of the thing they are published for. As with aws_iot_shadow_register_delta, the key
+ * may be a dotted path.
+ *
+ * @param pContext Shadow context
+ * @param pThingName Thing Name
+ * @param pStruct The struct used to parse JSON value
+ * @return An IoT Error Type defining successful/failed delta registering
+ */
+IoT_Error_t aws_iot_shadow_context_register_delta(ShadowContext_t *pContext, const char *pThingName,
+												  jsonStruct_t *pStruct);
+
+/**
+ * @brief Stop dispatching the deltas of a thing to a registration
+ *
+ * The thing stays subscribed to its delta topic, see aws_iot_shadow_context_remove_thing. Not to be
+ * called from a delta callback.
+ *
+ * @param pContext Shadow context
+ * @param pThingName Thing Name
+ * @param pStruct The struct given to aws_iot_shadow_context_register_delta
+ * @return SUCCESS, or FAILURE if pStruct is not registered on the thing
+ */
+IoT_Error_t aws_iot_shadow_context_unregister_delta(ShadowContext_t *pContext, const char *pThingName,
+													jsonStruct_t *pStruct);
+
+/**
+ * @brief Stop tracking a thing
+ *
+ * Unsubscribes the delta topic of the thing and drops its delta registrations and version, so that
+ * the context can track another thing in its place. The thing is kept if the unsubscribe fails.
+ * Not to be called from a delta callback.
+ *
+ * @param pContext Shadow context
+ * @param pThingName Thing Name
+ * @return SUCCESS, FAILURE if the context does not track the thing, or the error of the unsubscribe
+ */
+IoT_Error_t aws_iot_shadow_context_remove_thing(ShadowContext_t *pContext, const char *pThingName);
+
+/**
+ * @brief Get the last version received for a thing, see aws_iot_shadow_get_last_received_version
+ *
+ * @param pContext Shadow context
+ * @param pThingName Thing Name
+ * @return version number of the last received response, 0 for a thing the context does not track
+ */
+uint32_t aws_iot_shadow_context_get_last_received_version(ShadowContext_t *pContext, const char *pThingName);
+
+/**
+ * @brief Reset the last version received for a thing to zero
+ *
+ * @param pContext Shadow context
+ * @param pThingName Thing Name
+ */
+void aws_iot_shadow_context_reset_last_received_version(ShadowContext_t *pContext, const char *pThingName);
+
+/**
+ * @brief Enable or disable the ignoring of delta messages with an old version number
+ *
+ * @param pContext Shadow context
+ * @param isEnabled True to ignore old deltas, which is the default
+ */
+void aws_iot_shadow_context_set_discard_old_delta_msgs(ShadowContext_t *pContext, bool isEnabled);
+
+/**
+ * @brief Finalize a JSON document with a client token of a shadow context
+ *
+ * Same as aws_iot_finalize_json_document, with the client id of the context.
+ *
+ * @param pContext Shadow context
+ * @param pJsonDocument This is the pointer to the JSON document
+ * @param maxSizeOfJsonDocument The maximum size of the pJsonDocument to be used
+ * @return An IoT Error Type defining successful/failed finalizing
+ */
+IoT_Error_t aws_iot_shadow_context_finalize_json_document(ShadowContext_t *pContext, char *pJsonDocument,
+														  size_t maxSizeOfJsonDocument);
+
 #ifdef __cplusplus
 }
 #endif
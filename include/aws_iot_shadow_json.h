@@ -23,13 +23,50 @@ extern "C" {
 #include <stdbool.h>
 #include <stdarg.h>
 
+#include "jsmn.h"
+
 #include "aws_iot_error.h"
 #include "aws_iot_shadow_json_data.h"
+#include "aws_iot_shadow_interface.h"
+
+/** Parser of the received documents and the tokens it fills, each shadow context has its own */
+typedef struct {
+	jsmn_parser parser;
+	jsmntok_t *pTokens;
+	uint16_t maxTokens;
+} ShadowJsonParser_t;
+
+bool isJsonValidAndParse(const char *pJsonDocument, size_t jsonSize, ShadowJsonParser_t *pJsonParser,
+						 int32_t *pTokenCount);
+
+/** Objects and arrays nested deeper than this are not walked by walkParsedJsonMembers */
+#ifndef SHADOW_JSON_MAX_WALK_DEPTH
+#define SHADOW_JSON_MAX_WALK_DEPTH 8
+#endif
 
-bool isJsonValidAndParse(const char *pJsonDocument, size_t jsonSize, void *pJsonHandler, int32_t *pTokenCount);
+/** Member of an object met by walkParsedJsonMembers */
+typedef struct ShadowJsonMember ShadowJsonMember_t;
+struct ShadowJsonMember {
+	const char *pKey; ///< Key of the member, not null terminated
+	uint32_t keyLength;
+	uint32_t keyHash; ///< FNV-1a hash of the key
+	int32_t valueToken; ///< Token of the value, see updateParsedJsonValue
+	int32_t valueStart; ///< Offset of the value in the document
+	uint32_t valueLength;
+	const ShadowJsonMember_t *pParent; ///< Member whose value holds this member, arrays are skipped. NULL at the top level
+};
 
-bool isJsonKeyMatchingAndUpdateValue(const char *pJsonDocument, void *pJsonHandler, int32_t tokenCount,
-									 jsonStruct_t *pDataStruct, uint32_t *pDataLength, int32_t *pDataPosition);
+typedef void (*ShadowJsonMemberVisitor_t)(void *pVisitorData, const ShadowJsonMember_t *pMember);
+
+void walkParsedJsonMembers(const char *pJsonDocument, ShadowJsonParser_t *pJsonParser, int32_t tokenCount,
+						   ShadowJsonMemberVisitor_t visitor, void *pVisitorData);
+
+uint32_t hashJsonKey(const char *pKey, size_t keyLength);
+
+IoT_Error_t updateParsedJsonValue(const char *pJsonDocument, ShadowJsonParser_t *pJsonParser, int32_t valueToken,
+								  jsonStruct_t *pDataStruct);
+
+IoT_Error_t aws_iot_shadow_internal_empty_request_json(ShadowContext_t *pContext, char *pBuffer, size_t bufferSize);
 
 IoT_Error_t aws_iot_shadow_internal_get_request_json(char *pBuffer, size_t bufferSize);
 
@@ -42,7 +79,11 @@ bool isReceivedJsonValid(const char *pJsonDocument, size_t jsonSize);
 
 bool extractClientToken(const char *pJsonDocument, size_t jsonSize, char *pExtractedClientToken, size_t clientTokenSize);
 
-bool extractVersionNumber(const char *pJsonDocument, void *pJsonHandler, int32_t tokenCount, uint32_t *pVersionNumber);
+bool extractParsedClientToken(const char *pJsonDocument, ShadowJsonParser_t *pJsonParser, int32_t tokenCount,
+							  char *pExtractedClientToken, size_t clientTokenSize);
+
+bool extractVersionNumber(const char *pJsonDocument, ShadowJsonParser_t *pJsonParser, int32_t tokenCount,
+						  uint32_t *pVersionNumber);
 
 #ifdef __cplusplus
 }
@@ -26,6 +26,8 @@ extern "C" {
  */
 
 #include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
 
 /**
  * @brief This is a static JSON object that could be used in code
@@ -68,10 +70,153 @@ struct jsonStruct {
 	jsonStructCallback_t cb; ///< callback to be executed on receiving the Key value pair
 };
 
+/**
+ * @brief Writer of a JSON document into a buffer
+ *
+ * The writer keeps its position in the document, so appending a value does not rescan what was written before.
+ * Commas between members are inserted by the writer. Once the buffer is full the writer keeps counting the length
+ * of the document, see aws_iot_shadow_json_writer_get_required_size.
+ */
+typedef struct {
+	char *pBuffer; ///< Buffer the document is written to, always null terminated
+	size_t bufferSize; ///< Size of pBuffer
+	size_t length; ///< Length of the document, including what did not fit in the buffer
+	uint32_t depth; ///< Number of objects and arrays open
+	uint32_t hasMembers; ///< Bit per depth, set once a value was written at that depth
+	uint32_t isArray; ///< Bit per depth, set when the container open at that depth is an array
+} ShadowJsonWriter_t;
+
+/** Objects and arrays can be nested up to this depth in a ShadowJsonWriter_t */
+#define SHADOW_JSON_WRITER_MAX_DEPTH 31
+
+/**
+ * @brief Start a JSON document in a buffer
+ *
+ * @param pWriter Writer to initialize
+ * @param pBuffer The JSON document is written in this char buffer
+ * @param bufferSize Size of pBuffer
+ * @return An IoT Error Type defining if the writer or the buffer was null
+ */
+IoT_Error_t aws_iot_shadow_json_writer_init(ShadowJsonWriter_t *pWriter, char *pBuffer, size_t bufferSize);
+
+/**
+ * @brief Open an object
+ *
+ * @param pWriter Writer of the document
+ * @param pKey Key of the object in the enclosing object, NULL at the top level or in an array
+ * @return SHADOW_JSON_BUFFER_TRUNCATED once the buffer is full, SHADOW_JSON_ERROR if nested too deep
+ */
+IoT_Error_t aws_iot_shadow_json_writer_begin_object(ShadowJsonWriter_t *pWriter, const char *pKey);
+
+/**
+ * @brief Close the object opened last
+ *
+ * @param pWriter Writer of the document
+ * @return SHADOW_JSON_BUFFER_TRUNCATED once the buffer is full, SHADOW_JSON_ERROR if no object is open
+ */
+IoT_Error_t aws_iot_shadow_json_writer_end_object(ShadowJsonWriter_t *pWriter);
+
+/**
+ * @brief Open an array
+ *
+ * @param pWriter Writer of the document
+ * @param pKey Key of the array in the enclosing object, NULL at the top level or in an array
+ * @return SHADOW_JSON_BUFFER_TRUNCATED once the buffer is full, SHADOW_JSON_ERROR if nested too deep
+ */
+IoT_Error_t aws_iot_shadow_json_writer_begin_array(ShadowJsonWriter_t *pWriter, const char *pKey);
+
+/**
+ * @brief Close the array opened last
+ *
+ * @param pWriter Writer of the document
+ * @return SHADOW_JSON_BUFFER_TRUNCATED once the buffer is full, SHADOW_JSON_ERROR if no array is open
+ */
+IoT_Error_t aws_iot_shadow_json_writer_end_array(ShadowJsonWriter_t *pWriter);
+
+/**
+ * @brief Add a signed integer
+ *
+ * @param pWriter Writer of the document
+ * @param pKey Key of the value in the enclosing object, NULL in an array
+ * @param value Value to write
+ * @return SHADOW_JSON_BUFFER_TRUNCATED once the buffer is full
+ */
+IoT_Error_t aws_iot_shadow_json_writer_add_int(ShadowJsonWriter_t *pWriter, const char *pKey, int32_t value);
+
+/**
+ * @brief Add an unsigned integer
+ *
+ * @param pWriter Writer of the document
+ * @param pKey Key of the value in the enclosing object, NULL in an array
+ * @param value Value to write
+ * @return SHADOW_JSON_BUFFER_TRUNCATED once the buffer is full
+ */
+IoT_Error_t aws_iot_shadow_json_writer_add_uint(ShadowJsonWriter_t *pWriter, const char *pKey, uint32_t value);
+
+/**
+ * @brief Add a floating point number, written with six decimals
+ *
+ * @param pWriter Writer of the document
+ * @param pKey Key of the value in the enclosing object, NULL in an array
+ * @param value Value to write
+ * @return SHADOW_JSON_BUFFER_TRUNCATED once the buffer is full
+ */
+IoT_Error_t aws_iot_shadow_json_writer_add_float(ShadowJsonWriter_t *pWriter, const char *pKey, double value);
+
+/**
+ * @brief Add a boolean
+ *
+ * @param pWriter Writer of the document
+ * @param pKey Key of the value in the enclosing object, NULL in an array
+ * @param value Value to write
+ * @return SHADOW_JSON_BUFFER_TRUNCATED once the buffer is full
+ */
+IoT_Error_t aws_iot_shadow_json_writer_add_bool(ShadowJsonWriter_t *pWriter, const char *pKey, bool value);
+
+/**
+ * @brief Add a string, quotes, backslashes and control characters are escaped
+ *
+ * @param pWriter Writer of the document
+ * @param pKey Key of the value in the enclosing object, NULL in an array
+ * @param pValue Null terminated string to write
+ * @return SHADOW_JSON_BUFFER_TRUNCATED once the buffer is full, NULL_VALUE_ERROR if pValue is null
+ */
+IoT_Error_t aws_iot_shadow_json_writer_add_string(ShadowJsonWriter_t *pWriter, const char *pKey, const char *pValue);
+
+/**
+ * @brief Add a value that already is JSON, such as a serialized object, without escaping it
+ *
+ * @param pWriter Writer of the document
+ * @param pKey Key of the value in the enclosing object, NULL in an array
+ * @param pJsonValue Null terminated JSON value to write
+ * @return SHADOW_JSON_BUFFER_TRUNCATED once the buffer is full, NULL_VALUE_ERROR if pJsonValue is null
+ */
+IoT_Error_t aws_iot_shadow_json_writer_add_raw(ShadowJsonWriter_t *pWriter, const char *pKey, const char *pJsonValue);
+
+/**
+ * @brief Add the key and value of a jsonStruct_t, written according to its type
+ *
+ * @param pWriter Writer of the document
+ * @param pStruct Key value pair to write
+ * @return SHADOW_JSON_BUFFER_TRUNCATED once the buffer is full, NULL_VALUE_ERROR if the key or data is null
+ */
+IoT_Error_t aws_iot_shadow_json_writer_add_struct(ShadowJsonWriter_t *pWriter, const jsonStruct_t *pStruct);
+
+/**
+ * @brief Size of the buffer needed to hold the document written so far
+ *
+ * After a SHADOW_JSON_BUFFER_TRUNCATED error this is the exact size to write the same document again,
+ * null terminator included.
+ *
+ * @param pWriter Writer of the document
+ * @return Size in bytes
+ */
+size_t aws_iot_shadow_json_writer_get_required_size(const ShadowJsonWriter_t *pWriter);
+
 /**
  * @brief Initialize the JSON document with Shadow expected name/value
  *
- * This Function will fill the JSON Buffer with a null terminated string. Internally it uses snprintf
+ * This Function will fill the JSON Buffer with a null terminated string. Internally it uses a ShadowJsonWriter_t
  * This function should always be used First, followed by iot_shadow_add_reported and/or iot_shadow_add_desired.
  * Always finish the call sequence with iot_finalize_json_document
  *
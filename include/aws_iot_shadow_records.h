@@ -23,30 +23,117 @@ extern "C" {
 #include <stdbool.h>
 
 #include "aws_iot_shadow_interface.h"
+#include "aws_iot_shadow_json.h"
+#include "aws_iot_timer_wheel.h"
 #include "aws_iot_config.h"
 
+/** Index value marking a free slot of an index or the end of a list */
+#define SHADOW_INDEX_NONE 0xFFFF
 
-extern uint32_t shadowJsonVersionNum;
-extern bool shadowDiscardOldDeltaFlag;
+/** Response an action waits for */
+typedef struct {
+	char clientTokenID[MAX_SIZE_CLIENT_ID_WITH_SEQUENCE];
+	char thingName[MAX_SIZE_OF_THING_NAME];
+	ShadowActions_t action;
+	fpActionCallback_t callback;
+	void *pCallbackContext;
+	uint32_t clientTokenHash; ///< Hash of clientTokenID, its slot in the token index is probed from it
+	uint16_t nextFree; ///< Next record of the free list while the record is free
+	bool isFree;
+} ToBeReceivedAckRecord_t;
 
-extern char myThingName[MAX_SIZE_OF_THING_NAME];
-extern uint16_t myThingNameLen;
-extern char mqttClientID[MAX_SIZE_OF_UNIQUE_CLIENT_ID_BYTES];
-extern uint16_t mqttClientIDLen;
+/** Accepted or rejected topic subscribed for actions, shared by the actions on the same thing */
+typedef struct {
+	char Topic[MAX_SHADOW_TOPIC_LENGTH_BYTES];
+	uint8_t count;
+	bool isFree;
+	bool isSticky;
+} SubscriptionRecord_t;
 
-void initializeRecords(AWS_IoT_Client *pClient);
-bool isSubscriptionPresent(const char *pThingName, ShadowActions_t action);
-IoT_Error_t subscribeToShadowActionAcks(const char *pThingName, ShadowActions_t action, bool isSticky);
-void incrementSubscriptionCnt(const char *pThingName, ShadowActions_t action, bool isSticky);
+/** jsonStruct_t registered on the delta topic of a thing, indexed by the last key of its path */
+typedef struct {
+	jsonStruct_t *pStruct;
+	uint32_t keyHash; ///< Hash of the last key of pStruct->pKey mixed with the thing, its slot in the key index is probed from it
+	uint32_t matchedSequence; ///< Delta sequence number of the last match, a handler is updated once per delta
+	uint16_t keyLength; ///< Length of pStruct->pKey
+	uint16_t thing; ///< Index of the thing in pThings
+} ShadowDeltaHandler_t;
 
-IoT_Error_t publishToShadowAction(const char *pThingName, ShadowActions_t action, const char *pJsonDocumentToBeSent);
-void addToAckWaitList(uint8_t indexAckWaitList, const char *pThingName, ShadowActions_t action,
-					  const char *pExtractedClientToken, fpActionCallback_t callback, void *pCallbackContext,
-					  uint32_t timeout_seconds);
-bool getNextFreeIndexOfAckWaitList(uint8_t *pIndex);
-void HandleExpiredResponseCallbacks(void);
-void initDeltaTokens(void);
-IoT_Error_t registerJsonTokenOnDelta(jsonStruct_t *pStruct);
+/** Delta registrations and version tracking of one thing */
+typedef struct {
+	char thingName[MAX_SIZE_OF_THING_NAME];
+	char deltaTopic[MAX_SHADOW_TOPIC_LENGTH_BYTES]; ///< Kept for the MQTT client, which does not copy topic names
+	uint32_t versionNum; ///< Last version received on the get/accepted or delta topic
+	uint16_t nextFree; ///< Next thing of the free list while the thing is removed
+	bool isDeltaSubscribed;
+} ShadowThing_t;
+
+/**
+ * @brief Shadow context
+ *
+ * Everything the shadow layer keeps for one MQTT client. The tables are either the arrays of
+ * the default context or carved from the block the context was allocated in.
+ */
+struct ShadowContext {
+	AWS_IoT_Client *pMqttClient;
+	char clientId[MAX_SIZE_OF_UNIQUE_CLIENT_ID_BYTES]; ///< Prefix of the client tokens
+	uint32_t clientTokenNum; ///< Sequence number of the next client token
+	ToBeReceivedAckRecord_t *pAckWaitList;
+	uint16_t ackWaitListSize;
+	TimerWheel ackWaitWheel; ///< Response deadlines of the pAckWaitList, an entry of the wheel per record
+	uint16_t *pAckTokenIndex; ///< Open addressing table of the waiting records in pAckWaitList, by hash of their client token
+	uint16_t ackTokenIndexSize;
+	uint16_t firstFreeAck; ///< Head of the free list of pAckWaitList, SHADOW_INDEX_NONE if all the records wait
+	SubscriptionRecord_t *pSubscriptionList;
+	uint16_t subscriptionListSize;
+	ShadowThing_t *pThings;
+	uint16_t thingCount; ///< Number of pThings used so far, removed things are reused from firstFreeThing first
+	uint16_t maxThings;
+	uint16_t firstFreeThing; ///< Head of the free list of removed things, SHADOW_INDEX_NONE if none is
+	uint16_t *pThingIndex; ///< Open addressing table of indexes in pThings, by hash of the thing name
+	uint16_t thingIndexSize;
+	ShadowDeltaHandler_t *pDeltaHandlers;
+	uint16_t deltaHandlerCount;
+	uint16_t maxDeltaHandlers;
+	uint16_t *pDeltaKeyIndex; ///< Open addressing table of indexes in pDeltaHandlers, by keyHash
+	uint16_t deltaKeyIndexSize;
+	uint32_t deltaSequence; ///< Number of the delta being dispatched
+	ShadowJsonParser_t jsonParser; ///< Parser of the documents received on the topics of the context
+	char ackWildcardTopics[2][MAX_SHADOW_TOPIC_LENGTH_BYTES]; ///< Accepted and rejected topics of every action on ackWildcardThingName
+	char ackWildcardThingName[MAX_SIZE_OF_THING_NAME]; ///< Thing of the wildcard subscriptions, "+" for all things
+	bool isAckWildcardSubscribed;
+	bool isDiscardOldDeltaEnabled;
+	IoT_Client_Allocator allocator; ///< Allocator of the context, unset for the default context
+	char rxBuf[SHADOW_MAX_SIZE_OF_RX_BUFFER]; ///< Copy of the received document, the JSON parser relies on a string
+};
+
+/** Context of the API taking an MQTT client, with the tables sized in aws_iot_config.h */
+ShadowContext_t *getShadowDefaultContext(void);
+
+void initializeRecords(ShadowContext_t *pContext, AWS_IoT_Client *pClient);
+void resetShadowThings(ShadowContext_t *pContext);
+ShadowThing_t *findShadowThing(ShadowContext_t *pContext, const char *pThingName, size_t thingNameLen);
+ShadowThing_t *getOrAddShadowThing(ShadowContext_t *pContext, const char *pThingName);
+IoT_Error_t removeShadowThing(ShadowContext_t *pContext, const char *pThingName);
+size_t getShadowContextStorageSize(const ShadowContextParameters_t *pParams);
+void setupShadowContext(ShadowContext_t *pContext, const ShadowContextParameters_t *pParams);
+
+bool isSubscriptionPresent(ShadowContext_t *pContext, const char *pThingName, ShadowActions_t action);
+IoT_Error_t subscribeToShadowActionAcks(ShadowContext_t *pContext, const char *pThingName, ShadowActions_t action,
+										bool isSticky);
+IoT_Error_t subscribeToShadowAckWildcards(ShadowContext_t *pContext, const char *pThingName);
+void incrementSubscriptionCnt(ShadowContext_t *pContext, const char *pThingName, ShadowActions_t action,
+							  bool isSticky);
+
+IoT_Error_t publishToShadowAction(ShadowContext_t *pContext, const char *pThingName, ShadowActions_t action,
+								  const char *pJsonDocumentToBeSent);
+void addToAckWaitList(ShadowContext_t *pContext, uint16_t indexAckWaitList, const char *pThingName,
+					  ShadowActions_t action, const char *pExtractedClientToken, fpActionCallback_t callback,
+					  void *pCallbackContext, uint32_t timeout_seconds);
+bool getNextFreeIndexOfAckWaitList(ShadowContext_t *pContext, uint16_t *pIndex);
+void HandleExpiredResponseCallbacks(ShadowContext_t *pContext);
+IoT_Error_t registerJsonTokenOnDelta(ShadowContext_t *pContext, const char *pThingName, jsonStruct_t *pStruct);
+IoT_Error_t unregisterJsonTokenOnDelta(ShadowContext_t *pContext, const char *pThingName, jsonStruct_t *pStruct);
 
 #ifdef __cplusplus
 }
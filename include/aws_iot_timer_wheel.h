@@ -0,0 +1,153 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file aws_iot_timer_wheel.h
+ * @brief Hierarchical timer wheel for per-request deadlines
+ *
+ * Tracks the deadlines of a fixed table of requests, for instance the QoS1 publishes awaiting
+ * PUBACK or the shadow requests awaiting a response. Arming and disarming a deadline take
+ * constant time, and a pass only visits the slots that came due since the previous one, so
+ * the cost of checking for expirations does not grow with the number of requests.
+ * The table entries are owned by the caller and referred to by index, the wheel is not
+ * thread safe.
+ */
+
+#ifndef AWS_IOT_SDK_SRC_IOT_TIMER_WHEEL_H
+#define AWS_IOT_SDK_SRC_IOT_TIMER_WHEEL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "aws_iot_config.h"
+#include "timer_interface.h"
+
+#ifndef AWS_IOT_TIMER_WHEEL_TICK_MS
+/** Granularity of the timer wheel in milliseconds, if not set in aws_iot_config.h. Deadlines fire up to one tick late, never early */
+#define AWS_IOT_TIMER_WHEEL_TICK_MS 16
+#endif
+
+/** Number of levels of the timer wheel, each level counts in steps of a full turn of the level below */
+#define AWS_IOT_TIMER_WHEEL_LEVELS 3
+/** Number of slots per level, a power of two */
+#define AWS_IOT_TIMER_WHEEL_SLOTS 64
+/** List of the entries that came due and were not popped yet */
+#define AWS_IOT_TIMER_WHEEL_EXPIRED_LIST (AWS_IOT_TIMER_WHEEL_LEVELS * AWS_IOT_TIMER_WHEEL_SLOTS)
+/** Index value marking a disarmed entry, the end of a list, or no expired entry */
+#define AWS_IOT_TIMER_WHEEL_INDEX_NONE 0xFFFF
+
+/**
+ * @brief Timer Wheel Entry
+ *
+ * Deadline of one request of the table, linked into the list of the slot it is due in.
+ */
+typedef struct {
+	uint32_t expiryTick; ///< Tick at the end of which the deadline has passed
+	uint16_t list; ///< Slot list holding the entry, the expired list, or AWS_IOT_TIMER_WHEEL_INDEX_NONE when disarmed
+	uint16_t next; ///< Index of the next entry of the list
+	uint16_t prev; ///< Index of the previous entry of the list
+} TimerWheelEntry;
+
+/**
+ * @brief Timer Wheel
+ *
+ * Level 0 holds the deadlines due within one turn of AWS_IOT_TIMER_WHEEL_SLOTS ticks, level 1
+ * and 2 hold later deadlines and are cascaded down as the wheel turns. Deadlines beyond the
+ * last level are parked in its farthest slot and placed again when it comes round.
+ */
+typedef struct {
+	TimerWheelEntry *pEntries; ///< Entries of the table, one per request
+	uint16_t entryCount; ///< Number of entries of the table
+	uint16_t armedCount; ///< Number of entries waiting in a slot, the expired list is not counted
+	uint32_t currentTick; ///< Next tick to be processed
+	uint32_t currentTickStartMs; ///< Reading of timer_now_ms at the start of the current tick
+	uint16_t listHead[AWS_IOT_TIMER_WHEEL_EXPIRED_LIST + 1]; ///< First entry of every slot list, then of the expired list
+	uint16_t expiredTail; ///< Last entry of the expired list, which is popped in the order the entries came due
+} TimerWheel;
+
+/**
+ * @brief Initialize a timer wheel
+ *
+ * All entries start disarmed.
+ *
+ * @param pWheel Timer wheel to initialize
+ * @param pEntries Entries of the table, indexed like the requests they time
+ * @param entryCount Number of entries, below AWS_IOT_TIMER_WHEEL_INDEX_NONE
+ */
+void aws_iot_timer_wheel_init(TimerWheel *pWheel, TimerWheelEntry *pEntries, uint16_t entryCount);
+
+/**
+ * @brief Arm the deadline of an entry
+ *
+ * An entry that was already armed is moved to its new deadline.
+ *
+ * @param pWheel Timer wheel
+ * @param index Index of the entry
+ * @param timeout_ms Time from now after which the entry is due
+ */
+void aws_iot_timer_wheel_arm(TimerWheel *pWheel, uint16_t index, uint32_t timeout_ms);
+
+/**
+ * @brief Disarm the deadline of an entry
+ *
+ * Does nothing if the entry is not armed.
+ *
+ * @param pWheel Timer wheel
+ * @param index Index of the entry
+ */
+void aws_iot_timer_wheel_disarm(TimerWheel *pWheel, uint16_t index);
+
+/**
+ * @brief Turn the wheel to the current time
+ *
+ * Reads the clock once and moves every entry whose deadline has passed to the expired list.
+ *
+ * @param pWheel Timer wheel
+ */
+void aws_iot_timer_wheel_advance(TimerWheel *pWheel);
+
+/**
+ * @brief Take the next expired entry
+ *
+ * The entry is disarmed as it is returned.
+ *
+ * @param pWheel Timer wheel
+ *
+ * @return Index of the entry, or AWS_IOT_TIMER_WHEEL_INDEX_NONE if no entry came due
+ */
+uint16_t aws_iot_timer_wheel_pop_expired(TimerWheel *pWheel);
+
+/**
+ * @brief Get the time until the wheel next has work to do
+ *
+ * Either an entry comes due or a higher level has to be cascaded down. Only the slot heads are
+ * looked at, never the entries.
+ *
+ * @param pWheel Timer wheel
+ *
+ * @return Milliseconds to wait before calling aws_iot_timer_wheel_advance, 0 if an entry is
+ * already expired, UINT32_MAX if no entry is armed
+ */
+uint32_t aws_iot_timer_wheel_next_deadline_ms(TimerWheel *pWheel);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AWS_IOT_SDK_SRC_IOT_TIMER_WHEEL_H */
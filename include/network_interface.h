@@ -55,8 +55,20 @@ typedef struct {
 	uint16_t DestinationPort;            ///< Integer defining the connection port of the MQTT service.
 	uint32_t timeout_ms;                ///< Unsigned integer defining the TLS handshake timeout value in milliseconds.
 	bool ServerVerificationFlag;        ///< Boolean.  True = perform server certificate hostname validation.  False = skip validation \b NOT recommended.
+	char *pTlsSessionLocation;            ///< Pointer to string containing the filename (including path) keeping the last TLS session. NULL to keep it in memory only.
 } TLSConnectParams;
 
+/**
+ * @brief Network Buffer Vector
+ *
+ * Defines one segment of a gathered write. A packet can be sent as a list of
+ * segments so that large data does not need to be copied into a single buffer.
+ */
+typedef struct {
+	unsigned char *pBuffer;                ///< Pointer to the segment data
+	size_t len;                            ///< Length of the segment in bytes
+} NetworkBufferVector;
+
 /**
  * @brief Network Structure
  *
@@ -66,10 +78,13 @@ struct Network {
 	IoT_Error_t (*connect)(Network *, TLSConnectParams *);
 
 	IoT_Error_t (*read)(Network *, unsigned char *, size_t, Timer *, size_t *);    ///< Function pointer pointing to the network function to read from the network
+	IoT_Error_t (*readAvailable)(Network *, unsigned char *, size_t, Timer *, size_t *);    ///< Function pointer pointing to the network function to read the bytes already available, up to the given length. Optional, can be NULL
 	IoT_Error_t (*write)(Network *, unsigned char *, size_t, Timer *, size_t *);    ///< Function pointer pointing to the network function to write to the network
+	IoT_Error_t (*writeVector)(Network *, NetworkBufferVector *, size_t, Timer *, size_t *);    ///< Function pointer pointing to the network function to write a list of segments to the network. Optional, can be NULL
 	IoT_Error_t (*disconnect)(Network *);    ///< Function pointer pointing to the network function to disconnect from the network
 	IoT_Error_t (*isConnected)(Network *);    ///< Function pointer pointing to the network function to check if TLS is connected
 	IoT_Error_t (*destroy)(Network *);        ///< Function pointer pointing to the network function to destroy the network object
+	int (*getSocketFd)(Network *);            ///< Function pointer pointing to the network function to get the socket file descriptor. Optional, can be NULL
 
 	TLSConnectParams tlsConnectParams;        ///< TLSConnect params structure containing the common connection parameters
 	TLSDataParams tlsDataParams;            ///< TLSData params structure containing the connection data parameters that are specific to the library being used
@@ -90,12 +105,14 @@ struct Network {
  * @param DestinationPort - The port on the target to connect to
  * @param timeout_ms - The value to use for timeout of operation
  * @param ServerVerificationFlag - used to decide whether server verification is needed or not
+ * @param pTlsSessionLocation - Path of the file keeping the last TLS session, NULL to keep it in memory only
  *
  * @return IoT_Error_t - successful initialization or TLS error
  */
 IoT_Error_t iot_tls_init(Network *pNetwork, char *pRootCALocation, char *pDeviceCertLocation,
 						 char *pDevicePrivateKeyLocation, char *pDestinationURL,
-						 uint16_t DestinationPort, uint32_t timeout_ms, bool ServerVerificationFlag);
+						 uint16_t DestinationPort, uint32_t timeout_ms, bool ServerVerificationFlag,
+						 char *pTlsSessionLocation);
 
 /**
  * @brief Create a TLS socket and open the connection
@@ -120,6 +137,21 @@ IoT_Error_t iot_tls_connect(Network *pNetwork, TLSConnectParams *TLSParams);
  */
 IoT_Error_t iot_tls_write(Network *, unsigned char *, size_t, Timer *, size_t *);
 
+/**
+ * @brief Write a list of buffer segments to the network socket
+ *
+ * The segments are written in order as one contiguous stream of bytes.
+ * Implementations may copy short segments together to send fewer records.
+ *
+ * @param Network - Pointer to a Network struct defining the network interface.
+ * @param NetworkBufferVector pointer - list of segments to write to socket
+ * @param size_t - number of segments in the list
+ * @param Timer * - operation timer
+ * @param size_t - pointer to store the total number of bytes written
+ * @return IoT_Error_t - successful write or TLS error code
+ */
+IoT_Error_t iot_tls_write_vector(Network *, NetworkBufferVector *, size_t, Timer *, size_t *);
+
 /**
  * @brief Read bytes from the network socket
  *
@@ -132,6 +164,32 @@ IoT_Error_t iot_tls_write(Network *, unsigned char *, size_t, Timer *, size_t *)
  */
 IoT_Error_t iot_tls_read(Network *, unsigned char *, size_t, Timer *, size_t *);
 
+/**
+ * @brief Read the bytes available on the network socket
+ *
+ * Unlike iot_tls_read, this does not wait for the requested number of bytes.
+ * It returns as soon as some data has been read, up to the given length, which
+ * lets the MQTT client buffer several packets with a single call.
+ *
+ * @param Network - Pointer to a Network struct defining the network interface.
+ * @param unsigned char pointer - pointer to buffer where read bytes should be copied
+ * @param size_t - maximum number of bytes to read
+ * @param Timer * - operation timer
+ * @param size_t - pointer to store number of bytes read
+ * @return IoT_Error_t - successful read, NETWORK_SSL_NOTHING_TO_READ or TLS error code
+ */
+IoT_Error_t iot_tls_read_available(Network *, unsigned char *, size_t, Timer *, size_t *);
+
+/**
+ * @brief Get the file descriptor of the network socket
+ *
+ * Lets the application wait for incoming data with its own poll or select call.
+ *
+ * @param Network - Pointer to a Network struct defining the network interface.
+ * @return int - socket file descriptor, -1 if there is no open socket
+ */
+int iot_tls_get_socket_fd(Network *pNetwork);
+
 /**
  * @brief Disconnect from network socket
  *
@@ -150,6 +208,17 @@ IoT_Error_t iot_tls_disconnect(Network *pNetwork);
  */
 IoT_Error_t iot_tls_destroy(Network *pNetwork);
 
+/**
+ * @brief Free what the TLS layer keeps between connections
+ *
+ * Called when the network object is no longer used, after the last iot_tls_destroy.
+ * Frees the saved TLS session and drops the credentials the network still holds.
+ *
+ * @param Network - Pointer to a Network struct defining the network interface
+ * @return IoT_Error_t - successful cleanup or TLS error code
+ */
+IoT_Error_t iot_tls_free(Network *pNetwork);
+
 /**
  * @brief Check if TLS layer is still connected
  *
@@ -0,0 +1,94 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file offline_store_interface.h
+ * @brief Offline store interface definition for MQTT client.
+ *
+ * Defines the persistent memory region that backs the offline queue of the MQTT client.
+ * Starting point for porting the offline queue to the storage of a new platform.
+ * Only required when AWS_IOT_MQTT_ENABLE_OFFLINE_QUEUE is defined in aws_iot_config.h.
+ */
+
+#include "aws_iot_config.h"
+
+#ifdef AWS_IOT_MQTT_ENABLE_OFFLINE_QUEUE
+#ifndef __OFFLINE_STORE_INTERFACE_H_
+#define __OFFLINE_STORE_INTERFACE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * The platform specific offline store header that defines the OfflineStore struct
+ */
+#include "offline_store_platform.h"
+
+#include <stddef.h>
+#include <aws_iot_error.h>
+
+/**
+ * @brief Offline Store Type
+ *
+ * Forward declaration of an offline store struct.  The definition of this struct is
+ * platform dependent.  When porting to a new platform add this definition
+ * in "offline_store_platform.h".
+ *
+ */
+typedef struct _OfflineStore OfflineStore;
+
+/**
+ * @brief Open the persistent region backing an offline queue
+ *
+ * The region keeps its content across restarts of the application as long as its size
+ * does not change. A region that did not exist is filled with zeros.
+ *
+ * @param OfflineStore - pointer to the store to open
+ * @param char - name of the region, a file path on Linux
+ * @param size_t - size of the region in bytes
+ * @param unsigned char - output parameter, address of the region in memory
+ * @return IoT_Error_t - error code indicating result of operation
+ */
+IoT_Error_t aws_iot_offline_store_open(OfflineStore *, const char *, size_t, unsigned char **);
+
+/**
+ * @brief Write part of the region to persistent storage
+ *
+ * Returns once the bytes are stored, so that they survive a power loss.
+ *
+ * @param OfflineStore - pointer to the open store
+ * @param size_t - offset of the first byte to store
+ * @param size_t - number of bytes to store
+ * @return IoT_Error_t - error code indicating result of operation
+ */
+IoT_Error_t aws_iot_offline_store_sync(OfflineStore *, size_t, size_t);
+
+/**
+ * @brief Close the store
+ *
+ * The address of the region is no longer valid afterwards.
+ *
+ * @param OfflineStore - pointer to the store to close
+ * @return IoT_Error_t - error code indicating result of operation
+ */
+IoT_Error_t aws_iot_offline_store_close(OfflineStore *);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __OFFLINE_STORE_INTERFACE_H_ */
+#endif /* AWS_IOT_MQTT_ENABLE_OFFLINE_QUEUE */
@@ -36,6 +36,8 @@ extern "C" {
  */
 #include "threads_platform.h"
 
+#include <stdbool.h>
+#include <stdint.h>
 #include <aws_iot_error.h>
 
 /**
@@ -48,6 +50,16 @@ extern "C" {
  */
 typedef struct _IoT_Mutex_t IoT_Mutex_t;
 
+/**
+ * @brief Condition Type
+ *
+ * Forward declaration of a condition variable struct.  The definition of this struct is
+ * platform dependent.  When porting to a new platform add this definition
+ * in "threads_platform.h".
+ *
+ */
+typedef struct _IoT_Cond_t IoT_Cond_t;
+
 /**
  * @brief Initialize the provided mutex
  *
@@ -100,6 +112,78 @@ IoT_Error_t aws_iot_thread_mutex_unlock(IoT_Mutex_t *);
  */
 IoT_Error_t aws_iot_thread_mutex_destroy(IoT_Mutex_t *);
 
+/**
+ * @brief Initialize the provided condition variable
+ *
+ * @param IoT_Cond_t - pointer to the condition variable to be initialized
+ * @return IoT_Error_t - error code indicating result of operation
+ */
+IoT_Error_t aws_iot_thread_cond_init(IoT_Cond_t *);
+
+/**
+ * @brief Wait on the provided condition variable
+ *
+ * The mutex must be locked by the caller. It is released while waiting and locked again
+ * before returning. The wait may also end without the condition being signalled, so the
+ * caller checks its condition again.
+ *
+ * @param IoT_Cond_t - pointer to the condition variable to wait on
+ * @param IoT_Mutex_t - pointer to the locked mutex guarding the condition
+ * @param uint32_t - maximum time to wait in milliseconds
+ * @return IoT_Error_t - SUCCESS when signalled or when the time elapsed, error code otherwise
+ */
+IoT_Error_t aws_iot_thread_cond_wait(IoT_Cond_t *, IoT_Mutex_t *, uint32_t);
+
+/**
+ * @brief Wake all the threads waiting on the provided condition variable
+ *
+ * @param IoT_Cond_t - pointer to the condition variable to signal
+ * @return IoT_Error_t - error code indicating result of operation
+ */
+IoT_Error_t aws_iot_thread_cond_broadcast(IoT_Cond_t *);
+
+/**
+ * @brief Destroy the provided condition variable
+ *
+ * @param IoT_Cond_t - pointer to the condition variable to be destroyed
+ * @return IoT_Error_t - error code indicating result of operation
+ */
+IoT_Error_t aws_iot_thread_cond_destroy(IoT_Cond_t *);
+
+/**
+ * @brief Atomically read a 32 bit value
+ *
+ * Reads done after this one are not moved before it. Only required when the
+ * outbound queue is enabled with AWS_IOT_MQTT_OUTBOUND_QUEUE_SLOTS.
+ *
+ * @param uint32_t - pointer to the value to read
+ * @return uint32_t - the value read
+ */
+uint32_t aws_iot_thread_atomic_load(uint32_t *);
+
+/**
+ * @brief Atomically write a 32 bit value
+ *
+ * Writes done before this one are visible to a thread that reads the new value with
+ * aws_iot_thread_atomic_load. Only required when the outbound queue is enabled.
+ *
+ * @param uint32_t - pointer to the value to write
+ * @param uint32_t - the value to write
+ */
+void aws_iot_thread_atomic_store(uint32_t *, uint32_t);
+
+/**
+ * @brief Atomically replace a 32 bit value if it holds the expected value
+ *
+ * Only required when the outbound queue is enabled.
+ *
+ * @param uint32_t - pointer to the value to replace
+ * @param uint32_t - pointer to the expected value, updated with the current value on failure
+ * @param uint32_t - the value to write
+ * @return bool - true if the value was replaced
+ */
+bool aws_iot_thread_atomic_compare_exchange(uint32_t *, uint32_t *, uint32_t);
+
 #ifdef __cplusplus
 }
 #endif
@@ -98,6 +98,26 @@ uint32_t left_ms(Timer *);
  */
 void init_timer(Timer *);
 
+/**
+ * @brief Read the clock the timers run on
+ *
+ * Returns a free-running millisecond count of the clock behind the timers. The count must
+ * never go backwards and wraps around, only the difference between two readings is meaningful.
+ *
+ * @return uint32_t - current count in milliseconds
+ */
+uint32_t timer_now_ms(void);
+
+/**
+ * @brief Read the clock the timers run on, in microseconds
+ *
+ * Same as timer_now_ms with a finer resolution, the count wraps around after about 71 minutes.
+ * Only used to measure durations when AWS_IOT_MQTT_ENABLE_STATS is defined in aws_iot_config.h.
+ *
+ * @return uint32_t - current count in microseconds
+ */
+uint32_t timer_now_us(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,178 @@
+/*
+ * Copyright 2010-2015 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "network_credential_cache.h"
+
+static char *_iot_tls_copy_path(char **ppDest, const char *pPath) {
+	size_t len = strlen(pPath) + 1;
+
+	memcpy(*ppDest, pPath, len);
+	*ppDest += len;
+
+	return *ppDest - len;
+}
+
+static bool _iot_tls_credential_cache_match(const CredentialCacheEntry *pEntry, const CredentialCacheEntry *pKey) {
+	return !pEntry->isInvalidated
+		   && pEntry->ServerVerificationFlag == pKey->ServerVerificationFlag
+		   && pEntry->isAlpnEnabled == pKey->isAlpnEnabled
+		   && 0 == strcmp(pEntry->pRootCALocation, pKey->pRootCALocation)
+		   && 0 == strcmp(pEntry->pDeviceCertLocation, pKey->pDeviceCertLocation)
+		   && 0 == strcmp(pEntry->pDevicePrivateKeyLocation, pKey->pDevicePrivateKeyLocation);
+}
+
+static void _iot_tls_credential_cache_free(CredentialCache *pCache, CredentialCacheEntry *pEntry) {
+	pCache->free(pEntry);
+	free(pEntry);
+}
+
+static void _iot_tls_credential_cache_unlink(CredentialCache *pCache, CredentialCacheEntry *pEntry) {
+	CredentialCacheEntry **ppEntry = &(pCache->pHead);
+
+	while(*ppEntry != pEntry) {
+		ppEntry = &((*ppEntry)->pNext);
+	}
+	*ppEntry = pEntry->pNext;
+}
+
+static CredentialCacheEntry *_iot_tls_credential_cache_find(CredentialCache *pCache, const CredentialCacheEntry *pKey) {
+	CredentialCacheEntry *pEntry;
+
+	for(pEntry = pCache->pHead; NULL != pEntry; pEntry = pEntry->pNext) {
+		if(_iot_tls_credential_cache_match(pEntry, pKey)) {
+			return pEntry;
+		}
+	}
+
+	return NULL;
+}
+
+IoT_Error_t iot_tls_credential_cache_acquire(CredentialCache *pCache, const CredentialCacheEntry *pKey,
+											 CredentialCacheEntry **ppEntry) {
+	CredentialCacheEntry *pEntry, *pCached;
+	IoT_Error_t rc;
+	uint32_t generation;
+	char *pPaths;
+
+	if(NULL == pCache || NULL == pKey || NULL == ppEntry || NULL == pKey->pRootCALocation
+	   || NULL == pKey->pDeviceCertLocation || NULL == pKey->pDevicePrivateKeyLocation) {
+		return NULL_VALUE_ERROR;
+	}
+
+	pthread_mutex_lock(&(pCache->lock));
+	pCached = _iot_tls_credential_cache_find(pCache, pKey);
+	if(NULL != pCached) {
+		pCached->refCount++;
+		*ppEntry = pCached;
+		pthread_mutex_unlock(&(pCache->lock));
+		return SUCCESS;
+	}
+	generation = pCache->generation;
+	pthread_mutex_unlock(&(pCache->lock));
+
+	/*
+	 * Parsing reads files and builds keys, it is done without the lock so that connections
+	 * using other credentials, or releasing theirs, do not wait for it
+	 */
+
+	/* The paths are copied after the entry, the caller strings may not outlive it */
+	pEntry = (CredentialCacheEntry *) calloc(1, pCache->entrySize + strlen(pKey->pRootCALocation)
+											 + strlen(pKey->pDeviceCertLocation)
+											 + strlen(pKey->pDevicePrivateKeyLocation) + 3);
+	if(NULL == pEntry) {
+		return NETWORK_SSL_INIT_ERROR;
+	}
+	pPaths = (char *) pEntry + pCache->entrySize;
+	pEntry->pRootCALocation = _iot_tls_copy_path(&pPaths, pKey->pRootCALocation);
+	pEntry->pDeviceCertLocation = _iot_tls_copy_path(&pPaths, pKey->pDeviceCertLocation);
+	pEntry->pDevicePrivateKeyLocation = _iot_tls_copy_path(&pPaths, pKey->pDevicePrivateKeyLocation);
+	pEntry->ServerVerificationFlag = pKey->ServerVerificationFlag;
+	pEntry->isAlpnEnabled = pKey->isAlpnEnabled;
+
+	rc = pCache->parse(pEntry);
+	if(SUCCESS != rc) {
+		_iot_tls_credential_cache_free(pCache, pEntry);
+		return rc;
+	}
+
+	pthread_mutex_lock(&(pCache->lock));
+	/* Another connection may have parsed the same files meanwhile, keep a single entry */
+	pCached = _iot_tls_credential_cache_find(pCache, pKey);
+	if(NULL != pCached) {
+		pCached->refCount++;
+		*ppEntry = pCached;
+	} else {
+		/* The files may have been replaced after they were read, do not hand them to later connections */
+		pEntry->isInvalidated = (generation != pCache->generation);
+		pEntry->refCount = 1;
+		pEntry->pNext = pCache->pHead;
+		pCache->pHead = pEntry;
+		*ppEntry = pEntry;
+	}
+	pthread_mutex_unlock(&(pCache->lock));
+
+	if(NULL != pCached) {
+		_iot_tls_credential_cache_free(pCache, pEntry);
+	}
+
+	return SUCCESS;
+}
+
+void iot_tls_credential_cache_release(CredentialCache *pCache, CredentialCacheEntry *pEntry) {
+	if(NULL == pCache || NULL == pEntry) {
+		return;
+	}
+
+	pthread_mutex_lock(&(pCache->lock));
+	pEntry->refCount--;
+	if(0 == pEntry->refCount && pEntry->isInvalidated) {
+		_iot_tls_credential_cache_unlink(pCache, pEntry);
+		_iot_tls_credential_cache_free(pCache, pEntry);
+	}
+	pthread_mutex_unlock(&(pCache->lock));
+}
+
+void iot_tls_credential_cache_invalidate(CredentialCache *pCache) {
+	CredentialCacheEntry *pEntry, *pNext;
+
+	if(NULL == pCache) {
+		return;
+	}
+
+	pthread_mutex_lock(&(pCache->lock));
+	pCache->generation++;
+	for(pEntry = pCache->pHead; NULL != pEntry; pEntry = pNext) {
+		pNext = pEntry->pNext;
+		if(0 == pEntry->refCount) {
+			_iot_tls_credential_cache_unlink(pCache, pEntry);
+			_iot_tls_credential_cache_free(pCache, pEntry);
+		} else {
+			/* Freed when the last connection using them is closed */
+			pEntry->isInvalidated = true;
+		}
+	}
+	pthread_mutex_unlock(&(pCache->lock));
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2010-2015 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#ifndef IOTSDKC_NETWORK_CREDENTIAL_CACHE_H_
+#define IOTSDKC_NETWORK_CREDENTIAL_CACHE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file network_credential_cache.h
+ * @brief Cache of the credentials parsed by the TLS layer
+ *
+ * Connections made with the same certificate and key files share the credentials parsed
+ * from them. Entries are reference counted by the connections using them, and kept once
+ * unused so that a reconnect does not parse the files again.
+ */
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#include "aws_iot_error.h"
+
+/**
+ * @brief Credential Cache Entry
+ *
+ * Start of the structure the TLS layer keeps its parsed credentials in. The files and
+ * options the credentials were parsed with are the key of the entry.
+ */
+typedef struct _CredentialCacheEntry {
+	char *pRootCALocation;                   ///< Path of the root CA
+	char *pDeviceCertLocation;               ///< Path of the device certificate
+	char *pDevicePrivateKeyLocation;         ///< Path of the device private key
+	bool ServerVerificationFlag;             ///< Whether the server certificate must be valid
+	bool isAlpnEnabled;                      ///< Whether the ALPN extension is sent
+	uint32_t refCount;                       ///< Number of connections using the entry
+	bool isInvalidated;                      ///< Freed once unused, never handed out again
+	struct _CredentialCacheEntry *pNext;     ///< Next entry of the cache
+} CredentialCacheEntry;
+
+/**
+ * @brief Credential Cache
+ *
+ * Set entrySize and the callbacks, then leave the rest zeroed, see IOT_CREDENTIAL_CACHE_INITIALIZER.
+ */
+typedef struct {
+	size_t entrySize;                                    ///< Size of the structure starting with the entry
+	IoT_Error_t (*parse)(CredentialCacheEntry *pEntry);  ///< Parse the files named by a new entry, called unlocked
+	void (*free)(CredentialCacheEntry *pEntry);          ///< Free what parse made, also called when parse fails
+	CredentialCacheEntry *pHead;                         ///< Entries parsed so far
+	uint32_t generation;                                 ///< Incremented by every invalidate
+	pthread_mutex_t lock;                                ///< Protects the list and the reference counts
+} CredentialCache;
+
+/** Static initializer of a credential cache */
+#define IOT_CREDENTIAL_CACHE_INITIALIZER(entrySize, parse, free) { entrySize, parse, free, NULL, 0, PTHREAD_MUTEX_INITIALIZER }
+
+/**
+ * @brief Take a reference on the credentials matching a key, parsing them on first use
+ *
+ * @param pCache Credential cache
+ * @param pKey Files and options of the connection, only the key fields are read
+ * @param ppEntry Set to the entry the connection uses
+ *
+ * The files are parsed without holding the cache lock. If another connection parsed the
+ * same files meanwhile, its entry is used and the new one freed. Files parsed while the cache
+ * was invalidated are only used by this connection.
+ *
+ * @return SUCCESS, NETWORK_SSL_INIT_ERROR if out of memory, or the error of the parse callback
+ */
+IoT_Error_t iot_tls_credential_cache_acquire(CredentialCache *pCache, const CredentialCacheEntry *pKey,
+											 CredentialCacheEntry **ppEntry);
+
+/**
+ * @brief Drop a reference taken with iot_tls_credential_cache_acquire
+ *
+ * The entry is kept for the next connections once unused, unless it was invalidated.
+ *
+ * @param pCache Credential cache
+ * @param pEntry Entry of the connection
+ */
+void iot_tls_credential_cache_release(CredentialCache *pCache, CredentialCacheEntry *pEntry);
+
+/**
+ * @brief Drop every cached entry
+ *
+ * Unused entries are freed at once, the others when their last connection releases them.
+ * Later connections parse the files again.
+ *
+ * @param pCache Credential cache
+ */
+void iot_tls_credential_cache_invalidate(CredentialCache *pCache);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IOTSDKC_NETWORK_CREDENTIAL_CACHE_H_ */
@@ -27,47 +27,68 @@ extern "C" {
 #include <stdint.h>
 #include <stdbool.h>
 #include <unistd.h>
+#include <time.h>
 
 #include "timer_platform.h"
 
+/* Timers run on the monotonic clock, which NTP may slew but never steps. It is read from the
+ * vDSO, without a system call */
+#define TIMER_CLOCK_ID CLOCK_MONOTONIC
+
+/* The coarse clock is cheaper still but lags by a scheduler tick or more, it is only used for
+ * timer_now_ms whose callers count in coarser steps */
+#ifdef CLOCK_MONOTONIC_COARSE
+#define TIMER_COARSE_CLOCK_ID CLOCK_MONOTONIC_COARSE
+#else
+#define TIMER_COARSE_CLOCK_ID CLOCK_MONOTONIC
+#endif
+
+#define TIMER_NS_PER_US 1000ULL
+#define TIMER_NS_PER_MS 1000000ULL
+#define TIMER_NS_PER_SEC 1000000000ULL
+
+static uint64_t _timer_read_ns(clockid_t clockId) {
+	struct timespec now;
+
+	if(0 != clock_gettime(clockId, &now)) {
+		clock_gettime(TIMER_CLOCK_ID, &now);
+	}
+
+	return (uint64_t) now.tv_sec * TIMER_NS_PER_SEC + (uint64_t) now.tv_nsec;
+}
+
 bool has_timer_expired(Timer *timer) {
-	struct timeval now, res;
-	gettimeofday(&now, NULL);
-	timersub(&timer->end_time, &now, &res);
-	return res.tv_sec < 0 || (res.tv_sec == 0 && res.tv_usec <= 0);
+	return _timer_read_ns(TIMER_CLOCK_ID) >= timer->end_ns;
 }
 
 void countdown_ms(Timer *timer, uint32_t timeout) {
-	struct timeval now;
-#ifdef __cplusplus
-	struct timeval interval = {timeout / 1000, static_cast<int>((timeout % 1000) * 1000)};
-#else
-	struct timeval interval = {timeout / 1000, (int)((timeout % 1000) * 1000)};
-#endif
-	gettimeofday(&now, NULL);
-	timeradd(&now, &interval, &timer->end_time);
+	timer->end_ns = _timer_read_ns(TIMER_CLOCK_ID) + (uint64_t) timeout * TIMER_NS_PER_MS;
 }
 
 uint32_t left_ms(Timer *timer) {
-	struct timeval now, res;
+	uint64_t now = _timer_read_ns(TIMER_CLOCK_ID);
 	uint32_t result_ms = 0;
-	gettimeofday(&now, NULL);
-	timersub(&timer->end_time, &now, &res);
-	if(res.tv_sec >= 0) {
-		result_ms = (uint32_t) (res.tv_sec * 1000 + res.tv_usec / 1000);
+
+	if(timer->end_ns > now) {
+		result_ms = (uint32_t) ((timer->end_ns - now) / TIMER_NS_PER_MS);
 	}
 	return result_ms;
 }
 
 void countdown_sec(Timer *timer, uint32_t timeout) {
-	struct timeval now;
-	struct timeval interval = {timeout, 0};
-	gettimeofday(&now, NULL);
-	timeradd(&now, &interval, &timer->end_time);
+	timer->end_ns = _timer_read_ns(TIMER_CLOCK_ID) + (uint64_t) timeout * TIMER_NS_PER_SEC;
 }
 
 void init_timer(Timer *timer) {
-	timer->end_time = (struct timeval) {0, 0};
+	timer->end_ns = 0;
+}
+
+uint32_t timer_now_ms(void) {
+	return (uint32_t) (_timer_read_ns(TIMER_COARSE_CLOCK_ID) / TIMER_NS_PER_MS);
+}
+
+uint32_t timer_now_us(void) {
+	return (uint32_t) (_timer_read_ns(TIMER_CLOCK_ID) / TIMER_NS_PER_US);
 }
 
 void delay(unsigned milliseconds)
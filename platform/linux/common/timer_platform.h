@@ -25,13 +25,17 @@ extern "C" {
  */
 #include <sys/time.h>
 #include <sys/select.h>
+#include <stdint.h>
 #include "timer_interface.h"
 
 /**
  * definition of the Timer struct. Platform specific
+ *
+ * The expiry is kept in nanoseconds of the monotonic clock, so stepping the wall clock does
+ * not move it.
  */
 struct Timer {
-	struct timeval end_time;
+	uint64_t end_ns;
 };
 
 /**
@@ -0,0 +1,589 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file aws_iot_mqtt_reactor_epoll.c
+ * @brief Linux implementation of the MQTT reactor, based on epoll
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#include "aws_iot_log.h"
+#include "aws_iot_mqtt_reactor.h"
+
+/** Event data of the wake descriptor, registered clients have their index */
+#define REACTOR_WAKE_EVENT REACTOR_INDEX_NONE
+
+static void _aws_iot_mqtt_reactor_lock(AWS_IoT_Reactor *pReactor) {
+#ifdef _ENABLE_THREAD_SUPPORT_
+	aws_iot_thread_mutex_lock(&(pReactor->resumeLock));
+#else
+	IOT_UNUSED(pReactor);
+#endif
+}
+
+static void _aws_iot_mqtt_reactor_unlock(AWS_IoT_Reactor *pReactor) {
+#ifdef _ENABLE_THREAD_SUPPORT_
+	aws_iot_thread_mutex_unlock(&(pReactor->resumeLock));
+#else
+	IOT_UNUSED(pReactor);
+#endif
+}
+
+/**
+ * @brief Current time of the reactor clock, in milliseconds
+ *
+ * The monotonic clock is used so that deadlines are not moved by changes of the system time.
+ */
+static uint64_t _aws_iot_mqtt_reactor_now_ms(void) {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t) now.tv_sec * 1000 + (uint64_t) now.tv_nsec / 1000000;
+}
+
+static void _aws_iot_mqtt_reactor_heap_swap(AWS_IoT_Reactor *pReactor, uint32_t first, uint32_t second) {
+	uint32_t index = pReactor->timerHeap[first];
+
+	pReactor->timerHeap[first] = pReactor->timerHeap[second];
+	pReactor->timerHeap[second] = index;
+	pReactor->clients[pReactor->timerHeap[first]].heapIndex = first;
+	pReactor->clients[pReactor->timerHeap[second]].heapIndex = second;
+}
+
+static bool _aws_iot_mqtt_reactor_heap_is_earlier(AWS_IoT_Reactor *pReactor, uint32_t first, uint32_t second) {
+	return pReactor->clients[pReactor->timerHeap[first]].deadlineMs <
+		   pReactor->clients[pReactor->timerHeap[second]].deadlineMs;
+}
+
+static void _aws_iot_mqtt_reactor_heap_sift_up(AWS_IoT_Reactor *pReactor, uint32_t position) {
+	uint32_t parent;
+
+	while(0 < position) {
+		parent = (position - 1) / 2;
+		if(!_aws_iot_mqtt_reactor_heap_is_earlier(pReactor, position, parent)) {
+			break;
+		}
+		_aws_iot_mqtt_reactor_heap_swap(pReactor, position, parent);
+		position = parent;
+	}
+}
+
+static void _aws_iot_mqtt_reactor_heap_sift_down(AWS_IoT_Reactor *pReactor, uint32_t position) {
+	uint32_t child;
+
+	for(;;) {
+		child = 2 * position + 1;
+		if(child >= pReactor->timerHeapSize) {
+			break;
+		}
+		if(child + 1 < pReactor->timerHeapSize && _aws_iot_mqtt_reactor_heap_is_earlier(pReactor, child + 1, child)) {
+			child++;
+		}
+		if(!_aws_iot_mqtt_reactor_heap_is_earlier(pReactor, child, position)) {
+			break;
+		}
+		_aws_iot_mqtt_reactor_heap_swap(pReactor, position, child);
+		position = child;
+	}
+}
+
+/**
+ * @brief Remove a client from the timer heap, if it is in it
+ */
+static void _aws_iot_mqtt_reactor_heap_remove(AWS_IoT_Reactor *pReactor, uint32_t index) {
+	uint32_t position = pReactor->clients[index].heapIndex;
+	uint32_t last;
+
+	if(REACTOR_INDEX_NONE == position) {
+		return;
+	}
+
+	pReactor->clients[index].heapIndex = REACTOR_INDEX_NONE;
+	last = --pReactor->timerHeapSize;
+	if(position != last) {
+		pReactor->timerHeap[position] = pReactor->timerHeap[last];
+		pReactor->clients[pReactor->timerHeap[position]].heapIndex = position;
+		_aws_iot_mqtt_reactor_heap_sift_down(pReactor, position);
+		_aws_iot_mqtt_reactor_heap_sift_up(pReactor, position);
+	}
+}
+
+static void _aws_iot_mqtt_reactor_heap_insert(AWS_IoT_Reactor *pReactor, uint32_t index) {
+	uint32_t position = pReactor->timerHeapSize++;
+
+	pReactor->timerHeap[position] = index;
+	pReactor->clients[index].heapIndex = position;
+	_aws_iot_mqtt_reactor_heap_sift_up(pReactor, position);
+}
+
+/**
+ * @brief Stop waiting on the socket of a client
+ *
+ * A socket the client no longer has was closed by a disconnect, which removed it from
+ * epoll, and its number may already be the socket of another client. It is only forgotten.
+ */
+static void _aws_iot_mqtt_reactor_remove_fd(AWS_IoT_Reactor *pReactor, uint32_t index) {
+	ReactorClient *pEntry = &(pReactor->clients[index]);
+
+	if(0 <= pEntry->fd) {
+		if(pEntry->fd == aws_iot_mqtt_get_network_fd(pEntry->pClient)) {
+			epoll_ctl(pReactor->pollFd, EPOLL_CTL_DEL, pEntry->fd, NULL);
+		}
+		pEntry->fd = -1;
+	}
+}
+
+/**
+ * @brief Take the current socket and next deadline of a client into account
+ *
+ * @param pReactor Reference to the reactor
+ * @param index Index of the client entry
+ * @param isNewConnection Whether the client may have reconnected with the same socket number,
+ *        in which case the socket is registered again
+ *
+ * @return SUCCESS, or NETWORK_POLL_ERROR if the socket could not be added to epoll
+ */
+static IoT_Error_t _aws_iot_mqtt_reactor_schedule(AWS_IoT_Reactor *pReactor, uint32_t index, bool isNewConnection) {
+	ReactorClient *pEntry = &(pReactor->clients[index]);
+	struct epoll_event event;
+	uint32_t deadline;
+	int fd;
+
+	fd = aws_iot_mqtt_get_network_fd(pEntry->pClient);
+	if(fd != pEntry->fd || isNewConnection) {
+		_aws_iot_mqtt_reactor_remove_fd(pReactor, index);
+		if(0 <= fd) {
+			event.events = EPOLLIN;
+			event.data.u32 = index;
+			if(0 != epoll_ctl(pReactor->pollFd, EPOLL_CTL_ADD, fd, &event)) {
+				IOT_ERROR("Failed to wait on socket %d, errno %d", fd, errno);
+				return NETWORK_POLL_ERROR;
+			}
+			pEntry->fd = fd;
+		}
+	}
+
+	_aws_iot_mqtt_reactor_heap_remove(pReactor, index);
+	deadline = aws_iot_mqtt_get_next_deadline_ms(pEntry->pClient);
+	if(AWS_IOT_MQTT_NO_DEADLINE != deadline) {
+		pEntry->deadlineMs = _aws_iot_mqtt_reactor_now_ms() + deadline;
+		_aws_iot_mqtt_reactor_heap_insert(pReactor, index);
+	}
+
+	return SUCCESS;
+}
+
+/**
+ * @brief Stop processing a client until it is updated, without unregistering it
+ */
+static void _aws_iot_mqtt_reactor_park(AWS_IoT_Reactor *pReactor, uint32_t index) {
+	_aws_iot_mqtt_reactor_remove_fd(pReactor, index);
+	_aws_iot_mqtt_reactor_heap_remove(pReactor, index);
+}
+
+/**
+ * @brief Schedule a client once it was used, parking it if its socket cannot be waited on
+ */
+static void _aws_iot_mqtt_reactor_reschedule(AWS_IoT_Reactor *pReactor, uint32_t index, bool isNewConnection) {
+	ReactorClient *pEntry = &(pReactor->clients[index]);
+
+	if(SUCCESS != _aws_iot_mqtt_reactor_schedule(pReactor, index, isNewConnection)) {
+		_aws_iot_mqtt_reactor_park(pReactor, index);
+		if(NULL != pEntry->eventHandler) {
+			pEntry->eventHandler(pReactor, pEntry->pClient, NETWORK_POLL_ERROR, pEntry->pEventHandlerData);
+		}
+	}
+}
+
+/**
+ * @brief Find the entry of a registered client
+ *
+ * @return Index of the entry, REACTOR_INDEX_NONE if the client is not registered
+ */
+static uint32_t _aws_iot_mqtt_reactor_find(AWS_IoT_Reactor *pReactor, AWS_IoT_Client *pClient) {
+	uint32_t itr;
+
+	for(itr = 0; itr < AWS_IOT_MQTT_REACTOR_MAX_CLIENTS; itr++) {
+		if(pClient == pReactor->clients[itr].pClient) {
+			return itr;
+		}
+	}
+
+	return REACTOR_INDEX_NONE;
+}
+
+/**
+ * @brief Whether the reconnect attempt of a client is due
+ *
+ * The attempt opens the connection and waits for the CONNACK, and the resubscribe for
+ * its SUBACKs, it would hold up every other client of the reactor.
+ */
+static bool _aws_iot_mqtt_reactor_is_reconnect_due(AWS_IoT_Client *pClient) {
+	ClientState clientState = aws_iot_mqtt_get_client_state(pClient);
+
+	return ((CLIENT_STATE_PENDING_RECONNECT == clientState
+			 || CLIENT_STATE_CONNECTED_RESUBSCRIBE_IN_PROGRESS == clientState)
+			&& 0 == aws_iot_mqtt_get_next_deadline_ms(pClient));
+}
+
+static void _aws_iot_mqtt_reactor_process(AWS_IoT_Reactor *pReactor, uint32_t index) {
+	ReactorClient *pEntry = &(pReactor->clients[index]);
+	AWS_IoT_Client *pClient = pEntry->pClient;
+	IoT_Error_t rc;
+
+	if(NULL != pEntry->eventHandler && _aws_iot_mqtt_reactor_is_reconnect_due(pClient)) {
+		/* Handed to the application, the client is picked up again when it is updated */
+		_aws_iot_mqtt_reactor_park(pReactor, index);
+		pEntry->eventHandler(pReactor, pClient, NETWORK_RECONNECT_DUE, pEntry->pEventHandlerData);
+		return;
+	}
+
+	rc = aws_iot_mqtt_process_ready(pClient);
+	if(SUCCESS != rc && NULL != pEntry->eventHandler) {
+		pEntry->eventHandler(pReactor, pClient, rc, pEntry->pEventHandlerData);
+	}
+
+	if(pClient != pEntry->pClient) {
+		/* Unregistered by the event handler */
+		return;
+	}
+
+	if(NETWORK_RECONNECT_TIMED_OUT_ERROR == rc) {
+		/* Would be reported again on every run */
+		_aws_iot_mqtt_reactor_park(pReactor, index);
+		return;
+	}
+
+	_aws_iot_mqtt_reactor_reschedule(pReactor, index, NETWORK_RECONNECTED == rc);
+}
+
+/**
+ * @brief Update the clients of the resume list, once woken up by aws_iot_mqtt_reactor_resume
+ *
+ * The list is taken under the lock, the updates are made without it since they can call
+ * event handlers, which can unregister clients.
+ */
+static void _aws_iot_mqtt_reactor_process_resumes(AWS_IoT_Reactor *pReactor) {
+	uint32_t resumed[AWS_IOT_MQTT_REACTOR_MAX_CLIENTS];
+	uint32_t resumedCount = 0;
+	uint32_t index, itr;
+	uint64_t wakeCount;
+
+	/* Nonblocking, fails with EAGAIN if another run already read it */
+	if(0 > read(pReactor->wakeFd, &wakeCount, sizeof(wakeCount)) && EAGAIN != errno) {
+		IOT_WARN("Failed to read the reactor wake descriptor, errno %d", errno);
+	}
+
+	_aws_iot_mqtt_reactor_lock(pReactor);
+	index = pReactor->firstResume;
+	while(REACTOR_INDEX_NONE != index) {
+		resumed[resumedCount++] = index;
+		pReactor->clients[index].isResumePending = false;
+		index = pReactor->clients[index].nextResume;
+	}
+	pReactor->firstResume = REACTOR_INDEX_NONE;
+	_aws_iot_mqtt_reactor_unlock(pReactor);
+
+	for(itr = 0; itr < resumedCount; itr++) {
+		/* The client may have been unregistered since */
+		if(NULL != pReactor->clients[resumed[itr]].pClient) {
+			_aws_iot_mqtt_reactor_reschedule(pReactor, resumed[itr], true);
+		}
+	}
+}
+
+IoT_Error_t aws_iot_mqtt_reactor_init(AWS_IoT_Reactor *pReactor) {
+	struct epoll_event event;
+	uint32_t itr;
+
+	FUNC_ENTRY;
+
+	if(NULL == pReactor) {
+		FUNC_EXIT_RC(NULL_VALUE_ERROR);
+	}
+
+	pReactor->pollFd = epoll_create1(EPOLL_CLOEXEC);
+	if(0 > pReactor->pollFd) {
+		IOT_ERROR("Failed to create epoll instance, errno %d", errno);
+		FUNC_EXIT_RC(NETWORK_POLL_ERROR);
+	}
+
+	pReactor->wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if(0 > pReactor->wakeFd) {
+		IOT_ERROR("Failed to create the reactor wake descriptor, errno %d", errno);
+		close(pReactor->pollFd);
+		pReactor->pollFd = -1;
+		FUNC_EXIT_RC(NETWORK_POLL_ERROR);
+	}
+
+	event.events = EPOLLIN;
+	event.data.u32 = REACTOR_WAKE_EVENT;
+	if(0 != epoll_ctl(pReactor->pollFd, EPOLL_CTL_ADD, pReactor->wakeFd, &event)) {
+		IOT_ERROR("Failed to wait on the reactor wake descriptor, errno %d", errno);
+		close(pReactor->wakeFd);
+		close(pReactor->pollFd);
+		pReactor->wakeFd = -1;
+		pReactor->pollFd = -1;
+		FUNC_EXIT_RC(NETWORK_POLL_ERROR);
+	}
+
+#ifdef _ENABLE_THREAD_SUPPORT_
+	if(SUCCESS != aws_iot_thread_mutex_init(&(pReactor->resumeLock))) {
+		close(pReactor->wakeFd);
+		close(pReactor->pollFd);
+		pReactor->wakeFd = -1;
+		pReactor->pollFd = -1;
+		FUNC_EXIT_RC(MUTEX_INIT_ERROR);
+	}
+#endif
+
+	pReactor->clientCount = 0;
+	pReactor->timerHeapSize = 0;
+	pReactor->firstResume = REACTOR_INDEX_NONE;
+	for(itr = 0; itr < AWS_IOT_MQTT_REACTOR_MAX_CLIENTS; itr++) {
+		pReactor->clients[itr].pClient = NULL;
+		pReactor->clients[itr].fd = -1;
+		pReactor->clients[itr].heapIndex = REACTOR_INDEX_NONE;
+		pReactor->clients[itr].nextDue = REACTOR_INDEX_NONE;
+		pReactor->clients[itr].nextResume = REACTOR_INDEX_NONE;
+		pReactor->clients[itr].isResumePending = false;
+	}
+
+	FUNC_EXIT_RC(SUCCESS);
+}
+
+IoT_Error_t aws_iot_mqtt_reactor_destroy(AWS_IoT_Reactor *pReactor) {
+	FUNC_ENTRY;
+
+	if(NULL == pReactor) {
+		FUNC_EXIT_RC(NULL_VALUE_ERROR);
+	}
+
+	if(0 <= pReactor->pollFd) {
+		close(pReactor->pollFd);
+		pReactor->pollFd = -1;
+	}
+
+	if(0 <= pReactor->wakeFd) {
+		close(pReactor->wakeFd);
+		pReactor->wakeFd = -1;
+#ifdef _ENABLE_THREAD_SUPPORT_
+		aws_iot_thread_mutex_destroy(&(pReactor->resumeLock));
+#endif
+	}
+
+	FUNC_EXIT_RC(SUCCESS);
+}
+
+IoT_Error_t aws_iot_mqtt_reactor_register(AWS_IoT_Reactor *pReactor, AWS_IoT_Client *pClient,
+										  iot_reactor_event_handler eventHandler, void *pEventHandlerData) {
+	uint32_t index;
+	IoT_Error_t rc;
+
+	FUNC_ENTRY;
+
+	if(NULL == pReactor || NULL == pClient) {
+		FUNC_EXIT_RC(NULL_VALUE_ERROR);
+	}
+
+	if(REACTOR_INDEX_NONE != _aws_iot_mqtt_reactor_find(pReactor, pClient)) {
+		FUNC_EXIT_RC(FAILURE);
+	}
+
+	index = _aws_iot_mqtt_reactor_find(pReactor, NULL);
+	if(REACTOR_INDEX_NONE == index) {
+		FUNC_EXIT_RC(LIMIT_EXCEEDED_ERROR);
+	}
+
+	/* nextDue and the resume list are left alone, the entry may be on them for a run in progress */
+	pReactor->clients[index].fd = -1;
+	pReactor->clients[index].heapIndex = REACTOR_INDEX_NONE;
+	pReactor->clients[index].eventHandler = eventHandler;
+	pReactor->clients[index].pEventHandlerData = pEventHandlerData;
+	_aws_iot_mqtt_reactor_lock(pReactor);
+	pReactor->clients[index].pClient = pClient;
+	_aws_iot_mqtt_reactor_unlock(pReactor);
+
+	rc = _aws_iot_mqtt_reactor_schedule(pReactor, index, true);
+	if(SUCCESS != rc) {
+		_aws_iot_mqtt_reactor_park(pReactor, index);
+		_aws_iot_mqtt_reactor_lock(pReactor);
+		pReactor->clients[index].pClient = NULL;
+		_aws_iot_mqtt_reactor_unlock(pReactor);
+		FUNC_EXIT_RC(rc);
+	}
+
+	pReactor->clientCount++;
+	FUNC_EXIT_RC(SUCCESS);
+}
+
+IoT_Error_t aws_iot_mqtt_reactor_unregister(AWS_IoT_Reactor *pReactor, AWS_IoT_Client *pClient) {
+	uint32_t index;
+
+	FUNC_ENTRY;
+
+	if(NULL == pReactor || NULL == pClient) {
+		FUNC_EXIT_RC(NULL_VALUE_ERROR);
+	}
+
+	index = _aws_iot_mqtt_reactor_find(pReactor, pClient);
+	if(REACTOR_INDEX_NONE == index) {
+		FUNC_EXIT_RC(FAILURE);
+	}
+
+	_aws_iot_mqtt_reactor_park(pReactor, index);
+	_aws_iot_mqtt_reactor_lock(pReactor);
+	pReactor->clients[index].pClient = NULL;
+	_aws_iot_mqtt_reactor_unlock(pReactor);
+	pReactor->clientCount--;
+
+	FUNC_EXIT_RC(SUCCESS);
+}
+
+IoT_Error_t aws_iot_mqtt_reactor_update(AWS_IoT_Reactor *pReactor, AWS_IoT_Client *pClient) {
+	uint32_t index;
+	IoT_Error_t rc;
+
+	FUNC_ENTRY;
+
+	if(NULL == pReactor || NULL == pClient) {
+		FUNC_EXIT_RC(NULL_VALUE_ERROR);
+	}
+
+	index = _aws_iot_mqtt_reactor_find(pReactor, pClient);
+	if(REACTOR_INDEX_NONE == index) {
+		FUNC_EXIT_RC(FAILURE);
+	}
+
+	rc = _aws_iot_mqtt_reactor_schedule(pReactor, index, true);
+	if(SUCCESS != rc) {
+		_aws_iot_mqtt_reactor_park(pReactor, index);
+	}
+
+	FUNC_EXIT_RC(rc);
+}
+
+IoT_Error_t aws_iot_mqtt_reactor_resume(AWS_IoT_Reactor *pReactor, AWS_IoT_Client *pClient) {
+	ReactorClient *pEntry;
+	uint64_t wakeCount = 1;
+	uint32_t index;
+
+	FUNC_ENTRY;
+
+	if(NULL == pReactor || NULL == pClient) {
+		FUNC_EXIT_RC(NULL_VALUE_ERROR);
+	}
+
+	_aws_iot_mqtt_reactor_lock(pReactor);
+	index = _aws_iot_mqtt_reactor_find(pReactor, pClient);
+	if(REACTOR_INDEX_NONE == index) {
+		_aws_iot_mqtt_reactor_unlock(pReactor);
+		FUNC_EXIT_RC(FAILURE);
+	}
+
+	pEntry = &(pReactor->clients[index]);
+	if(!pEntry->isResumePending) {
+		pEntry->isResumePending = true;
+		pEntry->nextResume = pReactor->firstResume;
+		pReactor->firstResume = index;
+	}
+	_aws_iot_mqtt_reactor_unlock(pReactor);
+
+	/* EAGAIN only if the counter is about to overflow, the reactor is woken up anyway */
+	if(0 > write(pReactor->wakeFd, &wakeCount, sizeof(wakeCount)) && EAGAIN != errno) {
+		IOT_ERROR("Failed to wake up the reactor, errno %d", errno);
+		FUNC_EXIT_RC(NETWORK_POLL_ERROR);
+	}
+
+	FUNC_EXIT_RC(SUCCESS);
+}
+
+IoT_Error_t aws_iot_mqtt_reactor_run_once(AWS_IoT_Reactor *pReactor, uint32_t timeout_ms) {
+	struct epoll_event events[AWS_IOT_MQTT_REACTOR_MAX_EVENTS];
+	uint64_t now, deadline;
+	uint32_t index, dueList;
+	int waitMs, eventCount, itr;
+
+	FUNC_ENTRY;
+
+	if(NULL == pReactor) {
+		FUNC_EXIT_RC(NULL_VALUE_ERROR);
+	}
+
+	waitMs = (timeout_ms > INT_MAX) ? INT_MAX : (int) timeout_ms;
+	if(0 < pReactor->timerHeapSize) {
+		now = _aws_iot_mqtt_reactor_now_ms();
+		deadline = pReactor->clients[pReactor->timerHeap[0]].deadlineMs;
+		if(deadline <= now) {
+			waitMs = 0;
+		} else if(deadline - now < (uint64_t) waitMs) {
+			waitMs = (int) (deadline - now);
+		}
+	}
+
+	eventCount = epoll_wait(pReactor->pollFd, events, AWS_IOT_MQTT_REACTOR_MAX_EVENTS, waitMs);
+	if(0 > eventCount) {
+		if(EINTR != errno) {
+			IOT_ERROR("Failed to wait on client sockets, errno %d", errno);
+			FUNC_EXIT_RC(NETWORK_POLL_ERROR);
+		}
+		eventCount = 0;
+	}
+
+	for(itr = 0; itr < eventCount; itr++) {
+		index = events[itr].data.u32;
+		if(REACTOR_WAKE_EVENT == index) {
+			_aws_iot_mqtt_reactor_process_resumes(pReactor);
+		} else if(NULL != pReactor->clients[index].pClient) {
+			/* Skipped if unregistered by an event handler during this run */
+			_aws_iot_mqtt_reactor_process(pReactor, index);
+		}
+	}
+
+	/* Take the due clients out of the heap first, processing reschedules them */
+	now = _aws_iot_mqtt_reactor_now_ms();
+	dueList = REACTOR_INDEX_NONE;
+	while(0 < pReactor->timerHeapSize && pReactor->clients[pReactor->timerHeap[0]].deadlineMs <= now) {
+		index = pReactor->timerHeap[0];
+		_aws_iot_mqtt_reactor_heap_remove(pReactor, index);
+		pReactor->clients[index].nextDue = dueList;
+		dueList = index;
+	}
+
+	while(REACTOR_INDEX_NONE != dueList) {
+		index = dueList;
+		dueList = pReactor->clients[index].nextDue;
+		pReactor->clients[index].nextDue = REACTOR_INDEX_NONE;
+		if(NULL != pReactor->clients[index].pClient) {
+			_aws_iot_mqtt_reactor_process(pReactor, index);
+		}
+	}
+
+	FUNC_EXIT_RC(SUCCESS);
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -18,7 +18,11 @@ extern "C" {
 #endif
 
 #include <stdbool.h>
+#include <stdlib.h>
 #include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
 #include <timer_platform.h>
 #include <network_interface.h>
 
@@ -31,6 +35,12 @@ extern "C" {
 /* This is the value used for ssl read timeout */
 #define IOT_SSL_READ_TIMEOUT 10
 
+/* Segments of a vector write are gathered into a buffer of this size on the stack,
+ * so that a packet header and a short payload go out in a single TLS record */
+#ifndef IOT_SSL_WRITE_GATHER_SIZE
+#define IOT_SSL_WRITE_GATHER_SIZE 512
+#endif
+
 /* This defines the value of the debug buffer that gets allocated.
  * The value can be altered based on memory constraints
  */
@@ -38,6 +48,14 @@ extern "C" {
 #define MBEDTLS_DEBUG_BUFFER_SIZE 2048
 #endif
 
+/* Sessions can only be written to a file from mbedTLS 2.19, older versions keep them in memory */
+#if MBEDTLS_VERSION_NUMBER >= 0x02130000
+#include "mbedtls/platform_util.h"
+#define IOT_SSL_SESSION_PERSISTENCE
+/* This is the size of the buffer a session is serialized into, the peer certificate is part of it */
+#define IOT_SSL_SESSION_BUFFER_SIZE 4096
+#endif
+
 /*
  * This is a function to do further verification if needed on the cert received
  */
@@ -53,7 +71,7 @@ static int _iot_tls_verify_cert(void *data, mbedtls_x509_crt *crt, int depth, ui
 	if((*flags) == 0) {
 		IOT_DEBUG("  This certificate has no flags\n");
 	} else {
-		IOT_DEBUG(buf, sizeof(buf), "  ! ", *flags);
+		mbedtls_x509_crt_verify_info(buf, sizeof(buf), "  ! ", *flags);
 		IOT_DEBUG("%s\n", buf);
 	}
 
@@ -62,7 +80,8 @@ static int _iot_tls_verify_cert(void *data, mbedtls_x509_crt *crt, int depth, ui
 
 void _iot_tls_set_connect_params(Network *pNetwork, char *pRootCALocation, char *pDeviceCertLocation,
 								 char *pDevicePrivateKeyLocation, char *pDestinationURL,
-								 uint16_t destinationPort, uint32_t timeout_ms, bool ServerVerificationFlag) {
+								 uint16_t destinationPort, uint32_t timeout_ms, bool ServerVerificationFlag,
+								 char *pTlsSessionLocation) {
 	pNetwork->tlsConnectParams.DestinationPort = destinationPort;
 	pNetwork->tlsConnectParams.pDestinationURL = pDestinationURL;
 	pNetwork->tlsConnectParams.pDeviceCertLocation = pDeviceCertLocation;
@@ -70,22 +89,308 @@ void _iot_tls_set_connect_params(Network *pNetwork, char *pRootCALocation, char
 	pNetwork->tlsConnectParams.pRootCALocation = pRootCALocation;
 	pNetwork->tlsConnectParams.timeout_ms = timeout_ms;
 	pNetwork->tlsConnectParams.ServerVerificationFlag = ServerVerificationFlag;
+	pNetwork->tlsConnectParams.pTlsSessionLocation = pTlsSessionLocation;
+}
+
+/*
+ * Read the session written by a previous run of the process, if any
+ */
+static void _iot_tls_load_session(Network *pNetwork) {
+#ifdef IOT_SSL_SESSION_PERSISTENCE
+	TLSDataParams *tlsDataParams = &(pNetwork->tlsDataParams);
+	unsigned char buf[IOT_SSL_SESSION_BUFFER_SIZE];
+	ssize_t len;
+	int fd;
+	int ret;
+
+	fd = open(pNetwork->tlsConnectParams.pTlsSessionLocation, O_RDONLY);
+	if(0 > fd) {
+		/* No session saved yet */
+		return;
+	}
+	len = read(fd, buf, sizeof(buf));
+	close(fd);
+
+	if(0 < len) {
+		ret = mbedtls_ssl_session_load(&(tlsDataParams->savedSession), buf, (size_t) len);
+		if(ret != 0) {
+			/* Written by another version or configuration of mbedTLS, or damaged */
+			IOT_WARN(" Ignoring the saved TLS session, mbedtls_ssl_session_load returned -0x%x\n", -ret);
+			mbedtls_ssl_session_free(&(tlsDataParams->savedSession));
+			mbedtls_ssl_session_init(&(tlsDataParams->savedSession));
+		} else {
+			tlsDataParams->isSessionSaved = true;
+		}
+	}
+	mbedtls_platform_zeroize(buf, sizeof(buf));
+#else
+	IOT_WARN(" Saving the TLS session to a file needs mbedTLS 2.19 or later, it is kept in memory only\n");
+#endif
+}
+
+/*
+ * Keep the session negotiated by the last handshake, to offer it on the next connect
+ */
+static void _iot_tls_save_session(Network *pNetwork) {
+	TLSDataParams *tlsDataParams = &(pNetwork->tlsDataParams);
+	int ret;
+#ifdef IOT_SSL_SESSION_PERSISTENCE
+	unsigned char buf[IOT_SSL_SESSION_BUFFER_SIZE];
+	size_t len = 0;
+	ssize_t written;
+	int fd;
+#endif
+
+	mbedtls_ssl_session_free(&(tlsDataParams->savedSession));
+	mbedtls_ssl_session_init(&(tlsDataParams->savedSession));
+	tlsDataParams->isSessionSaved = false;
+
+	if((ret = mbedtls_ssl_get_session(&(tlsDataParams->ssl), &(tlsDataParams->savedSession))) != 0) {
+		IOT_WARN(" Unable to save the TLS session, mbedtls_ssl_get_session returned -0x%x\n", -ret);
+		return;
+	}
+	tlsDataParams->isSessionSaved = true;
+
+#ifdef IOT_SSL_SESSION_PERSISTENCE
+	if(NULL == pNetwork->tlsConnectParams.pTlsSessionLocation) {
+		return;
+	}
+
+	if((ret = mbedtls_ssl_session_save(&(tlsDataParams->savedSession), buf, sizeof(buf), &len)) != 0) {
+		IOT_WARN(" Unable to write the TLS session, mbedtls_ssl_session_save returned -0x%x\n", -ret);
+		return;
+	}
+
+	/* The session holds the master secret, only the owner may read it */
+	fd = open(pNetwork->tlsConnectParams.pTlsSessionLocation, O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR);
+	if(0 > fd) {
+		IOT_WARN(" Unable to open %s to write the TLS session\n", pNetwork->tlsConnectParams.pTlsSessionLocation);
+	} else {
+		written = write(fd, buf, len);
+		close(fd);
+		if((ssize_t) len != written) {
+			IOT_WARN(" Unable to write the TLS session to %s\n", pNetwork->tlsConnectParams.pTlsSessionLocation);
+			unlink(pNetwork->tlsConnectParams.pTlsSessionLocation);
+		}
+	}
+	mbedtls_platform_zeroize(buf, sizeof(buf));
+#endif
+}
+
+/*
+ * Stop offering the saved session, after a handshake that failed with it
+ */
+static void _iot_tls_forget_session(Network *pNetwork) {
+	TLSDataParams *tlsDataParams = &(pNetwork->tlsDataParams);
+
+	if(!tlsDataParams->isSessionSaved) {
+		return;
+	}
+
+	mbedtls_ssl_session_free(&(tlsDataParams->savedSession));
+	mbedtls_ssl_session_init(&(tlsDataParams->savedSession));
+	tlsDataParams->isSessionSaved = false;
+
+#ifdef IOT_SSL_SESSION_PERSISTENCE
+	if(NULL != pNetwork->tlsConnectParams.pTlsSessionLocation) {
+		unlink(pNetwork->tlsConnectParams.pTlsSessionLocation);
+	}
+#endif
+}
+
+/* Use the AWS IoT ALPN extension for MQTT if port 443 is requested. */
+static const char *alpnProtocols[] = { "x-amzn-mqtt-ca", NULL };
+
+/*
+ * The random generator is part of the shared configuration, connections in other threads use it too
+ */
+static int _iot_tls_credentials_random(void *p_rng, unsigned char *output, size_t output_len) {
+	TLSCredentials *pCredentials = (TLSCredentials *) p_rng;
+	int ret;
+
+	pthread_mutex_lock(&(pCredentials->rngLock));
+	ret = mbedtls_ctr_drbg_random(&(pCredentials->ctr_drbg), output, output_len);
+	pthread_mutex_unlock(&(pCredentials->rngLock));
+
+	return ret;
+}
+
+static void _iot_tls_credentials_free(CredentialCacheEntry *pEntry) {
+	TLSCredentials *pCredentials = (TLSCredentials *) pEntry;
+
+	mbedtls_x509_crt_free(&(pCredentials->clicert));
+	mbedtls_x509_crt_free(&(pCredentials->cacert));
+	mbedtls_pk_free(&(pCredentials->pkey));
+	mbedtls_ssl_config_free(&(pCredentials->conf));
+	mbedtls_ctr_drbg_free(&(pCredentials->ctr_drbg));
+	mbedtls_entropy_free(&(pCredentials->entropy));
+	pthread_mutex_destroy(&(pCredentials->rngLock));
+}
+
+/*
+ * Parse the certificates and key, and build the configuration every connection using them shares
+ */
+static IoT_Error_t _iot_tls_credentials_parse(CredentialCacheEntry *pEntry) {
+	TLSCredentials *pCredentials = (TLSCredentials *) pEntry;
+	int ret = 0;
+	const char *pers = "aws_iot_tls_wrapper";
+
+	mbedtls_entropy_init(&(pCredentials->entropy));
+	mbedtls_ctr_drbg_init(&(pCredentials->ctr_drbg));
+	pthread_mutex_init(&(pCredentials->rngLock), NULL);
+	mbedtls_ssl_config_init(&(pCredentials->conf));
+	mbedtls_x509_crt_init(&(pCredentials->cacert));
+	mbedtls_x509_crt_init(&(pCredentials->clicert));
+	mbedtls_pk_init(&(pCredentials->pkey));
+
+	IOT_DEBUG("\n  . Seeding the random number generator...");
+	if((ret = mbedtls_ctr_drbg_seed(&(pCredentials->ctr_drbg), mbedtls_entropy_func, &(pCredentials->entropy),
+									(const unsigned char *) pers, strlen(pers))) != 0) {
+		IOT_ERROR(" failed\n  ! mbedtls_ctr_drbg_seed returned -0x%x\n", -ret);
+		return NETWORK_MBEDTLS_ERR_CTR_DRBG_ENTROPY_SOURCE_FAILED;
+	}
+
+	IOT_DEBUG("  . Loading the CA root certificate ...");
+	ret = mbedtls_x509_crt_parse_file(&(pCredentials->cacert), pEntry->pRootCALocation);
+	if(ret < 0) {
+		IOT_ERROR(" failed\n  !  mbedtls_x509_crt_parse returned -0x%x while parsing root cert\n\n", -ret);
+		return NETWORK_X509_ROOT_CRT_PARSE_ERROR;
+	}
+	IOT_DEBUG(" ok (%d skipped)\n", ret);
+
+	IOT_DEBUG("  . Loading the client cert. and key...");
+	ret = mbedtls_x509_crt_parse_file(&(pCredentials->clicert), pEntry->pDeviceCertLocation);
+	if(ret != 0) {
+		IOT_ERROR(" failed\n  !  mbedtls_x509_crt_parse returned -0x%x while parsing device cert\n\n", -ret);
+		return NETWORK_X509_DEVICE_CRT_PARSE_ERROR;
+	}
+
+	ret = mbedtls_pk_parse_keyfile(&(pCredentials->pkey), pEntry->pDevicePrivateKeyLocation, "");
+	if(ret != 0) {
+		IOT_ERROR(" failed\n  !  mbedtls_pk_parse_key returned -0x%x while parsing private key\n\n", -ret);
+		IOT_DEBUG(" path : %s ", pEntry->pDevicePrivateKeyLocation);
+		return NETWORK_PK_PRIVATE_KEY_PARSE_ERROR;
+	}
+	IOT_DEBUG(" ok\n");
+
+	IOT_DEBUG("  . Setting up the SSL/TLS structure...");
+	if((ret = mbedtls_ssl_config_defaults(&(pCredentials->conf), MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM,
+										  MBEDTLS_SSL_PRESET_DEFAULT)) != 0) {
+		IOT_ERROR(" failed\n  ! mbedtls_ssl_config_defaults returned -0x%x\n\n", -ret);
+		return SSL_CONNECTION_ERROR;
+	}
+
+	mbedtls_ssl_conf_verify(&(pCredentials->conf), _iot_tls_verify_cert, NULL);
+	if(pEntry->ServerVerificationFlag == true) {
+		mbedtls_ssl_conf_authmode(&(pCredentials->conf), MBEDTLS_SSL_VERIFY_REQUIRED);
+	} else {
+		mbedtls_ssl_conf_authmode(&(pCredentials->conf), MBEDTLS_SSL_VERIFY_OPTIONAL);
+	}
+	mbedtls_ssl_conf_rng(&(pCredentials->conf), _iot_tls_credentials_random, pCredentials);
+
+	mbedtls_ssl_conf_ca_chain(&(pCredentials->conf), &(pCredentials->cacert), NULL);
+	if((ret = mbedtls_ssl_conf_own_cert(&(pCredentials->conf), &(pCredentials->clicert), &(pCredentials->pkey))) !=
+	   0) {
+		IOT_ERROR(" failed\n  ! mbedtls_ssl_conf_own_cert returned %d\n\n", ret);
+		return SSL_CONNECTION_ERROR;
+	}
+
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+	/* A ticket lets the server resume the session without keeping it in a cache */
+	mbedtls_ssl_conf_session_tickets(&(pCredentials->conf), MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+#endif
+
+	if(pEntry->isAlpnEnabled) {
+		if((ret = mbedtls_ssl_conf_alpn_protocols(&(pCredentials->conf), alpnProtocols)) != 0) {
+			IOT_ERROR(" failed\n  ! mbedtls_ssl_conf_alpn_protocols returned -0x%x\n\n", -ret);
+			return SSL_CONNECTION_ERROR;
+		}
+	}
+
+	return SUCCESS;
+}
+
+/* Credentials parsed so far, the entries no longer used are kept for the next connect */
+static CredentialCache credentialCache = IOT_CREDENTIAL_CACHE_INITIALIZER(sizeof(TLSCredentials),
+																		  _iot_tls_credentials_parse,
+																		  _iot_tls_credentials_free);
+
+/*
+ * Take a reference on the credentials for the files of this connection, parsing them on first use
+ */
+static IoT_Error_t _iot_tls_credentials_acquire(Network *pNetwork) {
+	TLSConnectParams *pParams = &(pNetwork->tlsConnectParams);
+	CredentialCacheEntry key;
+	CredentialCacheEntry *pEntry;
+	IoT_Error_t rc;
+
+	key.pRootCALocation = pParams->pRootCALocation;
+	key.pDeviceCertLocation = pParams->pDeviceCertLocation;
+	key.pDevicePrivateKeyLocation = pParams->pDevicePrivateKeyLocation;
+	key.ServerVerificationFlag = pParams->ServerVerificationFlag;
+	key.isAlpnEnabled = (443 == pParams->DestinationPort);
+
+	rc = iot_tls_credential_cache_acquire(&credentialCache, &key, &pEntry);
+	if(SUCCESS == rc) {
+		pNetwork->tlsDataParams.pCredentials = (TLSCredentials *) pEntry;
+	}
+
+	return rc;
+}
+
+static void _iot_tls_credentials_release(Network *pNetwork) {
+	TLSCredentials *pCredentials = pNetwork->tlsDataParams.pCredentials;
+
+	if(NULL == pCredentials) {
+		return;
+	}
+	pNetwork->tlsDataParams.pCredentials = NULL;
+
+	iot_tls_credential_cache_release(&credentialCache, &(pCredentials->cacheEntry));
+}
+
+void iot_tls_invalidate_credentials(void) {
+	iot_tls_credential_cache_invalidate(&credentialCache);
+}
+
+/*
+ * The configuration is shared, the read timeout of each connection is applied here instead
+ */
+static int _iot_tls_net_send(void *ctx, const unsigned char *buf, size_t len) {
+	return mbedtls_net_send(&(((TLSDataParams *) ctx)->server_fd), buf, len);
+}
+
+static int _iot_tls_net_recv_timeout(void *ctx, unsigned char *buf, size_t len, uint32_t timeout) {
+	TLSDataParams *tlsDataParams = (TLSDataParams *) ctx;
+	IOT_UNUSED(timeout);
+
+	return mbedtls_net_recv_timeout(&(tlsDataParams->server_fd), buf, len, tlsDataParams->readTimeout_ms);
 }
 
 IoT_Error_t iot_tls_init(Network *pNetwork, char *pRootCALocation, char *pDeviceCertLocation,
 						 char *pDevicePrivateKeyLocation, char *pDestinationURL,
-						 uint16_t destinationPort, uint32_t timeout_ms, bool ServerVerificationFlag) {
+						 uint16_t destinationPort, uint32_t timeout_ms, bool ServerVerificationFlag,
+						 char *pTlsSessionLocation) {
 	_iot_tls_set_connect_params(pNetwork, pRootCALocation, pDeviceCertLocation, pDevicePrivateKeyLocation,
-								pDestinationURL, destinationPort, timeout_ms, ServerVerificationFlag);
+								pDestinationURL, destinationPort, timeout_ms, ServerVerificationFlag,
+								pTlsSessionLocation);
 
 	pNetwork->connect = iot_tls_connect;
 	pNetwork->read = iot_tls_read;
+	pNetwork->readAvailable = iot_tls_read_available;
 	pNetwork->write = iot_tls_write;
+	pNetwork->writeVector = iot_tls_write_vector;
 	pNetwork->disconnect = iot_tls_disconnect;
 	pNetwork->isConnected = iot_tls_is_connected;
 	pNetwork->destroy = iot_tls_destroy;
+	pNetwork->getSocketFd = iot_tls_get_socket_fd;
 
 	pNetwork->tlsDataParams.flags = 0;
+	pNetwork->tlsDataParams.pCredentials = NULL;
+
+	mbedtls_ssl_session_init(&(pNetwork->tlsDataParams.savedSession));
+	pNetwork->tlsDataParams.isSessionSaved = false;
+	pNetwork->tlsDataParams.isSessionLoadAttempted = false;
 
 	return SUCCESS;
 }
@@ -97,11 +402,10 @@ IoT_Error_t iot_tls_is_connected(Network *pNetwork) {
 
 IoT_Error_t iot_tls_connect(Network *pNetwork, TLSConnectParams *params) {
 	int ret = 0;
-	const char *pers = "aws_iot_tls_wrapper";
+	IoT_Error_t rc;
 	TLSDataParams *tlsDataParams = NULL;
 	char portBuffer[6];
 	char vrfy_buf[512];
-	const char *alpnProtocols[] = { "x-amzn-mqtt-ca", NULL };
 
 #ifdef ENABLE_IOT_DEBUG
 	unsigned char buf[MBEDTLS_DEBUG_BUFFER_SIZE];
@@ -114,49 +418,23 @@ IoT_Error_t iot_tls_connect(Network *pNetwork, TLSConnectParams *params) {
 	if(NULL != params) {
 		_iot_tls_set_connect_params(pNetwork, params->pRootCALocation, params->pDeviceCertLocation,
 									params->pDevicePrivateKeyLocation, params->pDestinationURL,
-									params->DestinationPort, params->timeout_ms, params->ServerVerificationFlag);
+									params->DestinationPort, params->timeout_ms, params->ServerVerificationFlag,
+									params->pTlsSessionLocation);
 	}
 
 	tlsDataParams = &(pNetwork->tlsDataParams);
 
+	/* Still held if the previous connect failed, the connection was not destroyed then */
+	_iot_tls_credentials_release(pNetwork);
+
 	mbedtls_net_init(&(tlsDataParams->server_fd));
 	mbedtls_ssl_init(&(tlsDataParams->ssl));
-	mbedtls_ssl_config_init(&(tlsDataParams->conf));
-	mbedtls_ctr_drbg_init(&(tlsDataParams->ctr_drbg));
-	mbedtls_x509_crt_init(&(tlsDataParams->cacert));
-	mbedtls_x509_crt_init(&(tlsDataParams->clicert));
-	mbedtls_pk_init(&(tlsDataParams->pkey));
 
-	IOT_DEBUG("\n  . Seeding the random number generator...");
-	mbedtls_entropy_init(&(tlsDataParams->entropy));
-	if((ret = mbedtls_ctr_drbg_seed(&(tlsDataParams->ctr_drbg), mbedtls_entropy_func, &(tlsDataParams->entropy),
-									(const unsigned char *) pers, strlen(pers))) != 0) {
-		IOT_ERROR(" failed\n  ! mbedtls_ctr_drbg_seed returned -0x%x\n", -ret);
-		return NETWORK_MBEDTLS_ERR_CTR_DRBG_ENTROPY_SOURCE_FAILED;
-	}
-
-	IOT_DEBUG("  . Loading the CA root certificate ...");
-	ret = mbedtls_x509_crt_parse_file(&(tlsDataParams->cacert), pNetwork->tlsConnectParams.pRootCALocation);
-	if(ret < 0) {
-		IOT_ERROR(" failed\n  !  mbedtls_x509_crt_parse returned -0x%x while parsing root cert\n\n", -ret);
-		return NETWORK_X509_ROOT_CRT_PARSE_ERROR;
+	rc = _iot_tls_credentials_acquire(pNetwork);
+	if(SUCCESS != rc) {
+		return rc;
 	}
-	IOT_DEBUG(" ok (%d skipped)\n", ret);
 
-	IOT_DEBUG("  . Loading the client cert. and key...");
-	ret = mbedtls_x509_crt_parse_file(&(tlsDataParams->clicert), pNetwork->tlsConnectParams.pDeviceCertLocation);
-	if(ret != 0) {
-		IOT_ERROR(" failed\n  !  mbedtls_x509_crt_parse returned -0x%x while parsing device cert\n\n", -ret);
-		return NETWORK_X509_DEVICE_CRT_PARSE_ERROR;
-	}
-
-	ret = mbedtls_pk_parse_keyfile(&(tlsDataParams->pkey), pNetwork->tlsConnectParams.pDevicePrivateKeyLocation, "");
-	if(ret != 0) {
-		IOT_ERROR(" failed\n  !  mbedtls_pk_parse_key returned -0x%x while parsing private key\n\n", -ret);
-		IOT_DEBUG(" path : %s ", pNetwork->tlsConnectParams.pDevicePrivateKeyLocation);
-		return NETWORK_PK_PRIVATE_KEY_PARSE_ERROR;
-	}
-	IOT_DEBUG(" ok\n");
 	snprintf(portBuffer, 6, "%d", pNetwork->tlsConnectParams.DestinationPort);
 	IOT_DEBUG("  . Connecting to %s/%s...", pNetwork->tlsConnectParams.pDestinationURL, portBuffer);
 	if((ret = mbedtls_net_connect(&(tlsDataParams->server_fd), pNetwork->tlsConnectParams.pDestinationURL,
@@ -179,40 +457,10 @@ IoT_Error_t iot_tls_connect(Network *pNetwork, TLSConnectParams *params) {
 		return SSL_CONNECTION_ERROR;
 	} IOT_DEBUG(" ok\n");
 
-	IOT_DEBUG("  . Setting up the SSL/TLS structure...");
-	if((ret = mbedtls_ssl_config_defaults(&(tlsDataParams->conf), MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM,
-										  MBEDTLS_SSL_PRESET_DEFAULT)) != 0) {
-		IOT_ERROR(" failed\n  ! mbedtls_ssl_config_defaults returned -0x%x\n\n", -ret);
-		return SSL_CONNECTION_ERROR;
-	}
-
-	mbedtls_ssl_conf_verify(&(tlsDataParams->conf), _iot_tls_verify_cert, NULL);
-	if(pNetwork->tlsConnectParams.ServerVerificationFlag == true) {
-		mbedtls_ssl_conf_authmode(&(tlsDataParams->conf), MBEDTLS_SSL_VERIFY_REQUIRED);
-	} else {
-		mbedtls_ssl_conf_authmode(&(tlsDataParams->conf), MBEDTLS_SSL_VERIFY_OPTIONAL);
-	}
-	mbedtls_ssl_conf_rng(&(tlsDataParams->conf), mbedtls_ctr_drbg_random, &(tlsDataParams->ctr_drbg));
-
-	mbedtls_ssl_conf_ca_chain(&(tlsDataParams->conf), &(tlsDataParams->cacert), NULL);
-	if((ret = mbedtls_ssl_conf_own_cert(&(tlsDataParams->conf), &(tlsDataParams->clicert), &(tlsDataParams->pkey))) !=
-	   0) {
-		IOT_ERROR(" failed\n  ! mbedtls_ssl_conf_own_cert returned %d\n\n", ret);
-		return SSL_CONNECTION_ERROR;
-	}
-
-	mbedtls_ssl_conf_read_timeout(&(tlsDataParams->conf), pNetwork->tlsConnectParams.timeout_ms);
-
-	/* Use the AWS IoT ALPN extension for MQTT if port 443 is requested. */
-	if(443 == pNetwork->tlsConnectParams.DestinationPort) {
-		if((ret = mbedtls_ssl_conf_alpn_protocols(&(tlsDataParams->conf), alpnProtocols)) != 0) {
-			IOT_ERROR(" failed\n  ! mbedtls_ssl_conf_alpn_protocols returned -0x%x\n\n", -ret);
-			return SSL_CONNECTION_ERROR;
-		}
-	}
+	tlsDataParams->readTimeout_ms = pNetwork->tlsConnectParams.timeout_ms;
 
 	/* Assign the resulting configuration to the SSL context. */
-	if((ret = mbedtls_ssl_setup(&(tlsDataParams->ssl), &(tlsDataParams->conf))) != 0) {
+	if((ret = mbedtls_ssl_setup(&(tlsDataParams->ssl), &(tlsDataParams->pCredentials->conf))) != 0) {
 		IOT_ERROR(" failed\n  ! mbedtls_ssl_setup returned -0x%x\n\n", -ret);
 		return SSL_CONNECTION_ERROR;
 	}
@@ -220,9 +468,21 @@ IoT_Error_t iot_tls_connect(Network *pNetwork, TLSConnectParams *params) {
 		IOT_ERROR(" failed\n  ! mbedtls_ssl_set_hostname returned %d\n\n", ret);
 		return SSL_CONNECTION_ERROR;
 	}
+
+	if(!tlsDataParams->isSessionLoadAttempted && NULL != pNetwork->tlsConnectParams.pTlsSessionLocation) {
+		_iot_tls_load_session(pNetwork);
+	}
+	tlsDataParams->isSessionLoadAttempted = true;
+
+	/* Offer the last session, the server falls back to a full handshake if it does not know it anymore */
+	if(tlsDataParams->isSessionSaved) {
+		IOT_DEBUG("  . Offering the saved session...");
+		if((ret = mbedtls_ssl_set_session(&(tlsDataParams->ssl), &(tlsDataParams->savedSession))) != 0) {
+			IOT_WARN(" mbedtls_ssl_set_session returned -0x%x, doing a full handshake\n", -ret);
+		}
+	}
 	IOT_DEBUG("\n\nSSL state connect : %d ", tlsDataParams->ssl.state);
-	mbedtls_ssl_set_bio(&(tlsDataParams->ssl), &(tlsDataParams->server_fd), mbedtls_net_send, NULL,
-						mbedtls_net_recv_timeout);
+	mbedtls_ssl_set_bio(&(tlsDataParams->ssl), tlsDataParams, _iot_tls_net_send, NULL, _iot_tls_net_recv_timeout);
 	IOT_DEBUG(" ok\n");
 
 	IOT_DEBUG("\n\nSSL state connect : %d ", tlsDataParams->ssl.state);
@@ -238,6 +498,7 @@ IoT_Error_t iot_tls_connect(Network *pNetwork, TLSConnectParams *params) {
 							  "    Alternatively, you may want to use "
 							  "auth_mode=optional for testing purposes.\n");
 			}
+			_iot_tls_forget_session(pNetwork);
 			return SSL_CONNECTION_ERROR;
 		}
 	}
@@ -257,6 +518,7 @@ IoT_Error_t iot_tls_connect(Network *pNetwork, TLSConnectParams *params) {
 			IOT_ERROR(" failed\n");
 			mbedtls_x509_crt_verify_info(vrfy_buf, sizeof(vrfy_buf), "  ! ", tlsDataParams->flags);
 			IOT_ERROR("%s\n", vrfy_buf);
+			_iot_tls_forget_session(pNetwork);
 			ret = SSL_CONNECTION_ERROR;
 		} else {
 			IOT_DEBUG(" ok\n");
@@ -275,7 +537,11 @@ IoT_Error_t iot_tls_connect(Network *pNetwork, TLSConnectParams *params) {
 	}
 #endif
 
-	mbedtls_ssl_conf_read_timeout(&(tlsDataParams->conf), IOT_SSL_READ_TIMEOUT);
+	if(SUCCESS == ret) {
+		_iot_tls_save_session(pNetwork);
+	}
+
+	tlsDataParams->readTimeout_ms = IOT_SSL_READ_TIMEOUT;
 
 	return (IoT_Error_t) ret;
 }
@@ -315,6 +581,42 @@ IoT_Error_t iot_tls_write(Network *pNetwork, unsigned char *pMsg, size_t len, Ti
 	return SUCCESS;
 }
 
+IoT_Error_t iot_tls_write_vector(Network *pNetwork, NetworkBufferVector *pVector, size_t vectorCount, Timer *timer,
+								 size_t *written_len) {
+	unsigned char gatherBuf[IOT_SSL_WRITE_GATHER_SIZE];
+	size_t gathered = 0;
+	size_t itr;
+	size_t segment_len;
+	IoT_Error_t rc = SUCCESS;
+
+	*written_len = 0;
+
+	/* mbedTLS has no gathering write. Consecutive small segments are copied together and
+	 * go out in one record, larger ones are handed to the SSL layer in place */
+	for(itr = 0; itr <= vectorCount && SUCCESS == rc; itr++) {
+		if(itr < vectorCount && pVector[itr].len <= IOT_SSL_WRITE_GATHER_SIZE - gathered) {
+			memcpy(gatherBuf + gathered, pVector[itr].pBuffer, pVector[itr].len);
+			gathered += pVector[itr].len;
+			continue;
+		}
+
+		if(0 < gathered) {
+			segment_len = 0;
+			rc = iot_tls_write(pNetwork, gatherBuf, gathered, timer, &segment_len);
+			*written_len += segment_len;
+			gathered = 0;
+		}
+
+		if(SUCCESS == rc && itr < vectorCount) {
+			segment_len = 0;
+			rc = iot_tls_write(pNetwork, pVector[itr].pBuffer, pVector[itr].len, timer, &segment_len);
+			*written_len += segment_len;
+		}
+	}
+
+	return rc;
+}
+
 IoT_Error_t iot_tls_read(Network *pNetwork, unsigned char *pMsg, size_t len, Timer *timer, size_t *read_len) {
 	mbedtls_ssl_context *ssl = &(pNetwork->tlsDataParams.ssl);
 	size_t rxLen = 0;
@@ -349,6 +651,35 @@ IoT_Error_t iot_tls_read(Network *pNetwork, unsigned char *pMsg, size_t len, Tim
 	}
 }
 
+IoT_Error_t iot_tls_read_available(Network *pNetwork, unsigned char *pMsg, size_t len, Timer *timer, size_t *read_len) {
+	mbedtls_ssl_context *ssl = &(pNetwork->tlsDataParams.ssl);
+	int ret;
+
+	// With an expired timer only the data already received is returned, the read must not wait
+	if (has_timer_expired(timer) && 0 == mbedtls_ssl_get_bytes_avail(ssl)
+		&& 0 == mbedtls_net_poll(&(pNetwork->tlsDataParams.server_fd), MBEDTLS_NET_POLL_READ, 0)) {
+		return NETWORK_SSL_NOTHING_TO_READ;
+	}
+
+	do {
+		// A single record is decrypted per call, return whatever it holds
+		ret = mbedtls_ssl_read(ssl, pMsg, len);
+		if (ret > 0) {
+			*read_len = (size_t) ret;
+			return SUCCESS;
+		} else if (ret == 0 || (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE && ret != MBEDTLS_ERR_SSL_TIMEOUT)) {
+			return NETWORK_SSL_READ_ERROR;
+		}
+		// Evaluate timeout after the read to make sure read is done at least once
+	} while (!has_timer_expired(timer));
+
+	return NETWORK_SSL_NOTHING_TO_READ;
+}
+
+int iot_tls_get_socket_fd(Network *pNetwork) {
+	return pNetwork->tlsDataParams.server_fd.fd;
+}
+
 IoT_Error_t iot_tls_disconnect(Network *pNetwork) {
 	mbedtls_ssl_context *ssl = &(pNetwork->tlsDataParams.ssl);
 	int ret = 0;
@@ -367,13 +698,23 @@ IoT_Error_t iot_tls_destroy(Network *pNetwork) {
 
 	mbedtls_net_free(&(tlsDataParams->server_fd));
 
-	mbedtls_x509_crt_free(&(tlsDataParams->clicert));
-	mbedtls_x509_crt_free(&(tlsDataParams->cacert));
-	mbedtls_pk_free(&(tlsDataParams->pkey));
+	/* The saved session is kept, so that the next connect can resume it */
 	mbedtls_ssl_free(&(tlsDataParams->ssl));
-	mbedtls_ssl_config_free(&(tlsDataParams->conf));
-	mbedtls_ctr_drbg_free(&(tlsDataParams->ctr_drbg));
-	mbedtls_entropy_free(&(tlsDataParams->entropy));
+	_iot_tls_credentials_release(pNetwork);
+
+	return SUCCESS;
+}
+
+IoT_Error_t iot_tls_free(Network *pNetwork) {
+	TLSDataParams *tlsDataParams = &(pNetwork->tlsDataParams);
+
+	/* Still held if the last connect failed, the connection was not destroyed then */
+	_iot_tls_credentials_release(pNetwork);
+
+	mbedtls_ssl_session_free(&(tlsDataParams->savedSession));
+	mbedtls_ssl_session_init(&(tlsDataParams->savedSession));
+	tlsDataParams->isSessionSaved = false;
+	tlsDataParams->isSessionLoadAttempted = false;
 
 	return SUCCESS;
 }
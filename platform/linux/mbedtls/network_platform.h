@@ -15,6 +15,8 @@
 
 #ifndef IOTSDKC_NETWORK_MBEDTLS_PLATFORM_H_H
 
+#include <pthread.h>
+
 #include "mbedtls/config.h"
 
 #include "mbedtls/platform.h"
@@ -27,29 +29,58 @@
 #include "mbedtls/error.h"
 #include "mbedtls/debug.h"
 #include "mbedtls/timing.h"
+#include "mbedtls/version.h"
+
+#include "network_credential_cache.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 /**
- * @brief TLS Connection Parameters
+ * @brief TLS Credentials
  *
- * Defines a type containing TLS specific parameters to be passed down to the
- * TLS networking layer to create a TLS secured socket.
+ * Parsed certificates and key, with the SSL configuration built from them. Shared
+ * read-only by every connection using the same files, and reference counted.
  */
-typedef struct _TLSDataParams {
+typedef struct _TLSCredentials {
+	CredentialCacheEntry cacheEntry;
 	mbedtls_entropy_context entropy;
 	mbedtls_ctr_drbg_context ctr_drbg;
-	mbedtls_ssl_context ssl;
+	pthread_mutex_t rngLock;
 	mbedtls_ssl_config conf;
-	uint32_t flags;
 	mbedtls_x509_crt cacert;
 	mbedtls_x509_crt clicert;
 	mbedtls_pk_context pkey;
+} TLSCredentials;
+
+/**
+ * @brief TLS Connection Parameters
+ *
+ * Defines a type containing TLS specific parameters to be passed down to the
+ * TLS networking layer to create a TLS secured socket.
+ */
+typedef struct _TLSDataParams {
+	TLSCredentials *pCredentials;
+	mbedtls_ssl_context ssl;
+	uint32_t flags;
+	uint32_t readTimeout_ms;
 	mbedtls_net_context server_fd;
+	mbedtls_ssl_session savedSession;
+	bool isSessionSaved;
+	bool isSessionLoadAttempted;
 }TLSDataParams;
 
+/**
+ * @brief Drop the cached credentials
+ *
+ * Certificates and keys are parsed from their files by the first connect using them,
+ * then reused by every later connect and reconnect. Call this after replacing the
+ * files, the next connects parse them again. Connections already open keep the
+ * credentials they were made with until they are closed.
+ */
+void iot_tls_invalidate_credentials(void);
+
 #define IOTSDKC_NETWORK_MBEDTLS_PLATFORM_H_H
 
 #ifdef __cplusplus
@@ -0,0 +1,114 @@
+/*
+ * Copyright 2010-2015 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+/**
+ * @file offline_store_mmap.c
+ * @brief Linux implementation of the offline store, a file mapped in memory
+ */
+
+#include "offline_store_platform.h"
+#ifdef AWS_IOT_MQTT_ENABLE_OFFLINE_QUEUE
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/**
+ * @brief Open the persistent region backing an offline queue
+ *
+ * The file is created if needed and resized to the requested size, then mapped shared
+ * so that writes reach the page cache at once and survive a crash of the process.
+ *
+ * @param pStore - pointer to the store to open
+ * @param pPath - path of the file
+ * @param size - size of the region in bytes
+ * @param ppRegion - output parameter, address of the region in memory
+ * @return IoT_Error_t - error code indicating result of operation
+ */
+IoT_Error_t aws_iot_offline_store_open(OfflineStore *pStore, const char *pPath, size_t size,
+									   unsigned char **ppRegion) {
+	struct stat fileStat;
+	void *pRegion;
+
+	pStore->fd = open(pPath, O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
+	if(0 > pStore->fd) {
+		return FAILURE;
+	}
+
+	/* A new or resized file reads as zeros past its old end */
+	if(0 != fstat(pStore->fd, &fileStat)
+	   || ((size_t) fileStat.st_size != size && 0 != ftruncate(pStore->fd, (off_t) size))) {
+		close(pStore->fd);
+		return FAILURE;
+	}
+
+	pRegion = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, pStore->fd, 0);
+	if(MAP_FAILED == pRegion) {
+		close(pStore->fd);
+		return FAILURE;
+	}
+
+	pStore->pRegion = (unsigned char *) pRegion;
+	pStore->size = size;
+	*ppRegion = pStore->pRegion;
+
+	return SUCCESS;
+}
+
+/**
+ * @brief Write part of the region to persistent storage
+ *
+ * @param pStore - pointer to the open store
+ * @param offset - offset of the first byte to store
+ * @param len - number of bytes to store
+ * @return IoT_Error_t - error code indicating result of operation
+ */
+IoT_Error_t aws_iot_offline_store_sync(OfflineStore *pStore, size_t offset, size_t len) {
+	size_t pageStart = offset - (offset % (size_t) sysconf(_SC_PAGESIZE));
+
+	if(0 != msync(pStore->pRegion + pageStart, len + (offset - pageStart), MS_SYNC)) {
+		return FAILURE;
+	}
+
+	return SUCCESS;
+}
+
+/**
+ * @brief Close the store
+ *
+ * @param pStore - pointer to the store to close
+ * @return IoT_Error_t - error code indicating result of operation
+ */
+IoT_Error_t aws_iot_offline_store_close(OfflineStore *pStore) {
+	IoT_Error_t rc = SUCCESS;
+
+	if(0 != munmap(pStore->pRegion, pStore->size) || 0 != close(pStore->fd)) {
+		rc = FAILURE;
+	}
+	pStore->pRegion = NULL;
+
+	return rc;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* AWS_IOT_MQTT_ENABLE_OFFLINE_QUEUE */
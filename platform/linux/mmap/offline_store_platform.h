@@ -0,0 +1,44 @@
+/*
+ * Copyright 2010-2015 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "offline_store_interface.h"
+#ifdef AWS_IOT_MQTT_ENABLE_OFFLINE_QUEUE
+#ifndef IOTSDKC_OFFLINE_STORE_PLATFORM_H_
+#define IOTSDKC_OFFLINE_STORE_PLATFORM_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+/**
+ * @brief Offline Store Type
+ *
+ * definition of the offline store struct. Platform specific
+ *
+ */
+struct _OfflineStore {
+	int fd; ///< Descriptor of the file backing the region
+	unsigned char *pRegion; ///< Shared mapping of the file
+	size_t size; ///< Size of the mapping
+};
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* IOTSDKC_OFFLINE_STORE_PLATFORM_H_ */
+#endif /* AWS_IOT_MQTT_ENABLE_OFFLINE_QUEUE */
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2010-2015 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * A copy of the License is located at
+ *
+ *  http://aws.amazon.com/apache2.0
+ *
+ * or in the "license" file accompanying this file. This file is distributed
+ * on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied. See the License for the specific language governing
+ * permissions and limitations under the License.
+ */
+
+#include "threads_platform.h"
+#include "aws_iot_log.h"
+#if defined(_ENABLE_THREAD_SUPPORT_) && defined(ENABLE_IOT_ASYNC_LOG)
+
+#include <unistd.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static pthread_t flusherThread;
+static uint32_t isFlusherRunning = 0;
+static uint32_t flushIntervalMs = 0;
+static pthread_once_t threadExitKeyOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t threadExitKey;
+static int threadExitKeyStatus = -1;
+
+static void *_aws_iot_log_flusher(void *pArg) {
+	(void) pArg;
+
+	while(aws_iot_thread_atomic_load(&isFlusherRunning)) {
+		aws_iot_log_flush();
+		usleep((useconds_t) flushIntervalMs * 1000);
+	}
+
+	/* Records logged until the thread was stopped */
+	aws_iot_log_flush();
+	return NULL;
+}
+
+/**
+ * @brief Start a thread calling aws_iot_log_flush periodically
+ *
+ * @param intervalMs Time between two flushes, in milliseconds
+ * @return IoT_Error_t - error code indicating result of operation
+ */
+IoT_Error_t aws_iot_log_start_flusher(uint32_t intervalMs) {
+	uint32_t isRunning = 0;
+
+	if(!aws_iot_thread_atomic_compare_exchange(&isFlusherRunning, &isRunning, 1)) {
+		return FAILURE;
+	}
+
+	flushIntervalMs = intervalMs;
+	if(0 != pthread_create(&flusherThread, NULL, _aws_iot_log_flusher, NULL)) {
+		aws_iot_thread_atomic_store(&isFlusherRunning, 0);
+		return FAILURE;
+	}
+
+	return SUCCESS;
+}
+
+/**
+ * @brief Stop the thread started by aws_iot_log_start_flusher, after a last flush
+ *
+ * @return IoT_Error_t - error code indicating result of operation
+ */
+IoT_Error_t aws_iot_log_stop_flusher(void) {
+	uint32_t isRunning = 1;
+
+	if(!aws_iot_thread_atomic_compare_exchange(&isFlusherRunning, &isRunning, 0)) {
+		return FAILURE;
+	}
+
+	if(0 != pthread_join(flusherThread, NULL)) {
+		return FAILURE;
+	}
+
+	return SUCCESS;
+}
+
+static void _aws_iot_log_thread_exit(void *pRing) {
+	aws_iot_log_release_thread(pRing);
+}
+
+static void _aws_iot_log_create_thread_exit_key(void) {
+	threadExitKeyStatus = pthread_key_create(&threadExitKey, _aws_iot_log_thread_exit);
+}
+
+/**
+ * @brief Have aws_iot_log_release_thread called when the calling thread exits
+ *
+ * The ring is held by a thread specific value, whose destructor runs when the thread exits.
+ *
+ * @param pRing Passed back to aws_iot_log_release_thread
+ * @return IoT_Error_t - error code indicating result of operation
+ */
+IoT_Error_t aws_iot_log_watch_thread_exit(void *pRing) {
+	if(0 != pthread_once(&threadExitKeyOnce, _aws_iot_log_create_thread_exit_key) || 0 != threadExitKeyStatus) {
+		return FAILURE;
+	}
+
+	if(0 != pthread_setspecific(threadExitKey, pRing)) {
+		return FAILURE;
+	}
+
+	return SUCCESS;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _ENABLE_THREAD_SUPPORT_ && ENABLE_IOT_ASYNC_LOG */
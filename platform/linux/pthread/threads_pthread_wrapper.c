@@ -16,6 +16,9 @@
 #include "threads_platform.h"
 #ifdef _ENABLE_THREAD_SUPPORT_
 
+#include <errno.h>
+#include <time.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -104,6 +107,126 @@ IoT_Error_t aws_iot_thread_mutex_destroy(IoT_Mutex_t *pMutex) {
 	return SUCCESS;
 }
 
+/**
+ * @brief Initialize the provided condition variable
+ *
+ * The condition is timed against the monotonic clock, as the SDK timers are.
+ *
+ * @param IoT_Cond_t - pointer to the condition variable to be initialized
+ * @return IoT_Error_t - error code indicating result of operation
+ */
+IoT_Error_t aws_iot_thread_cond_init(IoT_Cond_t *pCond) {
+	pthread_condattr_t attr;
+	int rc;
+
+	if(0 != pthread_condattr_init(&attr)) {
+		return MUTEX_INIT_ERROR;
+	}
+
+	rc = pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	if(0 == rc) {
+		rc = pthread_cond_init(&(pCond->cond), &attr);
+	}
+	(void)pthread_condattr_destroy(&attr);
+
+	if(0 != rc) {
+		return MUTEX_INIT_ERROR;
+	}
+
+	return SUCCESS;
+}
+
+/**
+ * @brief Wait on the provided condition variable
+ *
+ * @param IoT_Cond_t - pointer to the condition variable to wait on
+ * @param IoT_Mutex_t - pointer to the locked mutex guarding the condition
+ * @param uint32_t - maximum time to wait in milliseconds
+ * @return IoT_Error_t - SUCCESS when signalled or when the time elapsed, error code otherwise
+ */
+IoT_Error_t aws_iot_thread_cond_wait(IoT_Cond_t *pCond, IoT_Mutex_t *pMutex, uint32_t timeout_ms) {
+	struct timespec deadline;
+	int rc;
+
+	if(0 != clock_gettime(CLOCK_MONOTONIC, &deadline)) {
+		return MUTEX_LOCK_ERROR;
+	}
+
+	deadline.tv_sec += (time_t) (timeout_ms / 1000);
+	deadline.tv_nsec += (long) (timeout_ms % 1000) * 1000000L;
+	if(deadline.tv_nsec >= 1000000000L) {
+		deadline.tv_sec++;
+		deadline.tv_nsec -= 1000000000L;
+	}
+
+	rc = pthread_cond_timedwait(&(pCond->cond), &(pMutex->lock), &deadline);
+	if(0 != rc && ETIMEDOUT != rc) {
+		return MUTEX_LOCK_ERROR;
+	}
+
+	return SUCCESS;
+}
+
+/**
+ * @brief Wake all the threads waiting on the provided condition variable
+ *
+ * @param IoT_Cond_t - pointer to the condition variable to signal
+ * @return IoT_Error_t - error code indicating result of operation
+ */
+IoT_Error_t aws_iot_thread_cond_broadcast(IoT_Cond_t *pCond) {
+	if(0 != pthread_cond_broadcast(&(pCond->cond))) {
+		return MUTEX_UNLOCK_ERROR;
+	}
+
+	return SUCCESS;
+}
+
+/**
+ * @brief Destroy the provided condition variable
+ *
+ * @param IoT_Cond_t - pointer to the condition variable to be destroyed
+ * @return IoT_Error_t - error code indicating result of operation
+ */
+IoT_Error_t aws_iot_thread_cond_destroy(IoT_Cond_t *pCond) {
+	if(0 != pthread_cond_destroy(&(pCond->cond))) {
+		return MUTEX_DESTROY_ERROR;
+	}
+
+	return SUCCESS;
+}
+
+/**
+ * @brief Atomically read a 32 bit value
+ *
+ * @param uint32_t - pointer to the value to read
+ * @return uint32_t - the value read
+ */
+uint32_t aws_iot_thread_atomic_load(uint32_t *pValue) {
+	return __atomic_load_n(pValue, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * @brief Atomically write a 32 bit value
+ *
+ * @param uint32_t - pointer to the value to write
+ * @param uint32_t - the value to write
+ */
+void aws_iot_thread_atomic_store(uint32_t *pValue, uint32_t value) {
+	__atomic_store_n(pValue, value, __ATOMIC_SEQ_CST);
+}
+
+/**
+ * @brief Atomically replace a 32 bit value if it holds the expected value
+ *
+ * @param uint32_t - pointer to the value to replace
+ * @param uint32_t - pointer to the expected value, updated with the current value on failure
+ * @param uint32_t - the value to write
+ * @return bool - true if the value was replaced
+ */
+bool aws_iot_thread_atomic_compare_exchange(uint32_t *pValue, uint32_t *pExpected, uint32_t desired) {
+	return __atomic_compare_exchange_n(pValue, pExpected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -33,12 +33,14 @@
 
 // MQTT PubSub
 #ifndef DISABLE_IOT_JOBS
-#define AWS_IOT_MQTT_RX_BUF_LEN 512 ///< Any message that comes into the device should be less than this buffer size. If a received message is bigger than this buffer size the message will be dropped.
+#define AWS_IOT_MQTT_RX_BUF_LEN 512 ///< Any message that comes into the device should be less than this buffer size. If a received message is bigger than this buffer size the message will be dropped, unless it is streamed to a subscription made with aws_iot_mqtt_subscribe_streaming.
 #else
 #define AWS_IOT_MQTT_RX_BUF_LEN 2048
 #endif
-#define AWS_IOT_MQTT_TX_BUF_LEN 512 ///< Any time a message is sent out through the MQTT layer. The message is copied into this buffer anytime a publish is done. This will also be used in the case of Thing Shadow
+#define AWS_IOT_MQTT_TX_BUF_LEN 512 ///< Any time a message is sent out through the MQTT layer. Control packets are serialized into this buffer. Publish payloads are sent from the caller buffer and are not limited by this size. This will also be used in the case of Thing Shadow
 #define AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS 5 ///< Maximum number of topic filters the MQTT client can handle at any given time. This should be increased appropriately when using Thing Shadow
+#define AWS_IOT_MQTT_MAX_INFLIGHT_PUBLISHES 10 ///< Maximum number of QoS1 messages published with aws_iot_mqtt_publish_async that can be awaiting a PUBACK at any given time
+#define AWS_IOT_MQTT_NUM_TOPIC_TRIE_NODES (AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS * 8) ///< Number of topic levels the subscription index can hold. A topic filter takes one node for every level it does not share with another subscription
 
 // Shadow and Job common configs
 #define MAX_SIZE_OF_UNIQUE_CLIENT_ID_BYTES 80  ///< Maximum size of the Unique Client Id. For More info on the Client Id refer \ref response "Acknowledgments"
@@ -65,8 +67,8 @@
 #endif
 
 // Auto Reconnect specific config
-#define AWS_IOT_MQTT_MIN_RECONNECT_WAIT_INTERVAL 1000 ///< Minimum time before the First reconnect attempt is made as part of the exponential back-off algorithm
-#define AWS_IOT_MQTT_MAX_RECONNECT_WAIT_INTERVAL 128000 ///< Maximum time interval after which exponential back-off will stop attempting to reconnect.
+#define AWS_IOT_MQTT_MIN_RECONNECT_WAIT_INTERVAL 1000 ///< Shortest wait between reconnect attempts after the first one, which is made at once. Overridden by minReconnectWait_ms
+#define AWS_IOT_MQTT_MAX_RECONNECT_WAIT_INTERVAL 128000 ///< Longest wait between reconnect attempts. The exponential reconnect policy gives up past it. Overridden by maxReconnectWait_ms
 
 #define DISABLE_METRICS false ///< Disable the collection of metrics by setting this to true
 
@@ -283,7 +283,7 @@ int main(int argc, char **argv) {
 		return rc;
 	}
 	/*
-	 * Enable Auto Reconnect functionality. Minimum and Maximum time of Exponential backoff are set in aws_iot_config.h
+	 * Enable Auto Reconnect functionality. Minimum and Maximum time between attempts are set in aws_iot_config.h
 	 *  #AWS_IOT_MQTT_MIN_RECONNECT_WAIT_INTERVAL
 	 *  #AWS_IOT_MQTT_MAX_RECONNECT_WAIT_INTERVAL
 	 */
@@ -0,0 +1,810 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file aws_iot_log.c
+ * @brief Asynchronous logger
+ *
+ * The logging macros store a record, the address of the format string followed by the
+ * arguments, in a ring buffer owned by the calling thread. Each ring has a single producer,
+ * its thread, and a single consumer, aws_iot_log_flush, so no lock is taken on the logging
+ * path. The format string is parsed once when the record is stored, to know the type of each
+ * argument, and again when it is formatted. Strings are copied, as the buffers they point to
+ * may be reused by then.
+ * With threads, a ring is given back when its thread exits and the flush has drained it. Threads
+ * finding no free ring share one more ring, under a lock.
+ * Only built when ENABLE_IOT_ASYNC_LOG is defined.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "aws_iot_config.h"
+#include "aws_iot_log.h"
+#include "timer_interface.h"
+
+#ifdef _ENABLE_THREAD_SUPPORT_
+#include "threads_interface.h"
+#endif
+
+#ifdef ENABLE_IOT_ASYNC_LOG
+
+#ifndef AWS_IOT_LOG_RING_RECORDS
+/** Number of records in the ring of a thread, a power of two, if not set in aws_iot_config.h */
+#define AWS_IOT_LOG_RING_RECORDS 64
+#endif
+
+#if 0 == AWS_IOT_LOG_RING_RECORDS || 0 != (AWS_IOT_LOG_RING_RECORDS & (AWS_IOT_LOG_RING_RECORDS - 1))
+#error "AWS_IOT_LOG_RING_RECORDS must be a power of two"
+#endif
+
+#ifndef AWS_IOT_LOG_RECORD_ARGS_LEN
+/** Space for the arguments of one record, copied strings included, if not set in aws_iot_config.h */
+#define AWS_IOT_LOG_RECORD_ARGS_LEN 96
+#endif
+
+#ifndef AWS_IOT_LOG_LINE_LEN
+/** Longest formatted log line, longer lines are truncated, if not set in aws_iot_config.h */
+#define AWS_IOT_LOG_LINE_LEN 256
+#endif
+
+#ifndef AWS_IOT_LOG_RATE_LIMIT
+/** Messages logged per second by one call site, 0 for no limit, if not set in aws_iot_config.h */
+#define AWS_IOT_LOG_RATE_LIMIT 20
+#endif
+
+#ifdef _ENABLE_THREAD_SUPPORT_
+#ifndef AWS_IOT_LOG_MAX_THREADS
+/** Number of threads that can own a ring at once, if not set in aws_iot_config.h. Other threads share one ring */
+#define AWS_IOT_LOG_MAX_THREADS 4
+#endif
+#ifndef AWS_IOT_LOG_THREAD_LOCAL
+/** Storage class of the per-thread ring pointer, if not set in aws_iot_config.h */
+#define AWS_IOT_LOG_THREAD_LOCAL __thread
+#endif
+#define _aws_iot_log_load(pValue) aws_iot_thread_atomic_load(pValue)
+#define _aws_iot_log_store(pValue, value) aws_iot_thread_atomic_store(pValue, value)
+/* The rings owned by a thread, followed by the shared ring */
+#define LOG_RING_COUNT (AWS_IOT_LOG_MAX_THREADS + 1)
+#define LOG_SHARED_RING (&logRings[AWS_IOT_LOG_MAX_THREADS])
+#else
+/* Without threads there is one ring, and the flush cannot interrupt a write */
+#undef AWS_IOT_LOG_MAX_THREADS
+#define AWS_IOT_LOG_MAX_THREADS 1
+#define LOG_RING_COUNT 1
+#define _aws_iot_log_load(pValue) (*(pValue))
+#define _aws_iot_log_store(pValue, value) (*(pValue) = (value))
+#endif
+
+/** States of a ring */
+#define LOG_RING_FREE 0 ///< No thread owns the ring
+#define LOG_RING_OWNED 1 ///< A thread owns the ring
+#define LOG_RING_RELEASED 2 ///< The thread exited, the ring is freed once drained
+
+/** Length of the longest conversion specification rebuilt by the formatter */
+#define LOG_SPEC_LEN 32
+
+/**
+ * @brief Log Record
+ *
+ * Defining a type for a log message waiting in a ring to be formatted.
+ *
+ */
+typedef struct {
+	IoT_Log_Site *pSite; ///< Call site of the logging macro
+	const char *pFormat; ///< Format string passed to the macro
+	uint32_t suppressedCount; ///< Messages of the call site suppressed before this one
+	uint16_t argsLen; ///< Bytes of args used, formatting stops when they run out
+	unsigned char args[AWS_IOT_LOG_RECORD_ARGS_LEN]; ///< Arguments, integers widened to 64 bits
+} IoT_Log_Record;
+
+/**
+ * @brief Log Ring
+ *
+ * Defining a type for the records of one thread. head is only written by the thread,
+ * tail only by the flush.
+ *
+ */
+typedef struct {
+	uint32_t state; ///< LOG_RING_FREE, LOG_RING_OWNED or LOG_RING_RELEASED. Accessed atomically
+	uint32_t head; ///< Number of records written. Accessed atomically
+	uint32_t tail; ///< Number of records formatted. Accessed atomically
+	uint32_t droppedCount; ///< Records dropped because the ring was full. Accessed atomically
+	uint32_t reportedDroppedCount; ///< Dropped records already reported by the flush
+	IoT_Log_Record records[AWS_IOT_LOG_RING_RECORDS]; ///< Record slots, indexed by position
+} IoT_Log_Ring;
+
+/** Types of the arguments of conversion specifications */
+typedef enum {
+	LOG_ARG_NONE, ///< No argument, %%
+	LOG_ARG_SIGNED, ///< d, i
+	LOG_ARG_UNSIGNED, ///< u, o, x, X
+	LOG_ARG_CHAR, ///< c
+	LOG_ARG_DOUBLE, ///< f, F, e, E, g, G, a, A
+	LOG_ARG_POINTER, ///< p
+	LOG_ARG_STRING, ///< s
+	LOG_ARG_COUNT, ///< n, the pointer is consumed and nothing is written
+	LOG_ARG_INVALID ///< Unknown conversion, the rest of the format is written as is
+} IoT_Log_Arg_Type;
+
+/** One conversion specification of a format string */
+typedef struct {
+	const char *pStart; ///< The '%' starting the specification
+	size_t flagsLen; ///< Length of the flags following the '%'
+	bool isWidthArg; ///< Width given as an argument, '*'
+	int width; ///< Width, -1 if none
+	bool isPrecisionArg; ///< Precision given as an argument, '.*'
+	int precision; ///< Precision, -1 if none
+	char lengthModifier[3]; ///< hh, h, l, ll, j, z, t or L
+	char conversion; ///< Conversion character
+	IoT_Log_Arg_Type argType; ///< Type of the argument
+} IoT_Log_Spec;
+
+static IoT_Log_Ring logRings[LOG_RING_COUNT];
+static IoT_Log_Level logLevel = IOT_LOG_LEVEL_TRACE;
+static uint32_t logRateLimit = AWS_IOT_LOG_RATE_LIMIT;
+static pLogOutput_t logOutput = NULL;
+#ifdef _ENABLE_THREAD_SUPPORT_
+static AWS_IOT_LOG_THREAD_LOCAL IoT_Log_Ring *pThreadRing = NULL;
+static uint32_t isFlushing = 0;
+static uint32_t isSharedRingLocked = 0;
+#endif
+
+static const char *_aws_iot_log_parse_number(const char *pCursor, int *pValue) {
+	*pValue = 0;
+	while(*pCursor >= '0' && *pCursor <= '9') {
+		*pValue = (*pValue * 10) + (*pCursor - '0');
+		pCursor++;
+	}
+	return pCursor;
+}
+
+/**
+ * @brief Parse the conversion specification starting at a '%'
+ *
+ * @param pCursor The '%' of the specification
+ * @param pSpec Output parameter, the parsed specification
+ *
+ * @return The character following the specification
+ */
+static const char *_aws_iot_log_parse_spec(const char *pCursor, IoT_Log_Spec *pSpec) {
+	size_t modifierLen = 0;
+
+	pSpec->pStart = pCursor++;
+	pSpec->isWidthArg = false;
+	pSpec->width = -1;
+	pSpec->isPrecisionArg = false;
+	pSpec->precision = -1;
+
+	pSpec->flagsLen = strspn(pCursor, "-+ #0");
+	pCursor += pSpec->flagsLen;
+
+	if('*' == *pCursor) {
+		pSpec->isWidthArg = true;
+		pCursor++;
+	} else if(*pCursor >= '0' && *pCursor <= '9') {
+		pCursor = _aws_iot_log_parse_number(pCursor, &(pSpec->width));
+	}
+
+	if('.' == *pCursor) {
+		pCursor++;
+		if('*' == *pCursor) {
+			pSpec->isPrecisionArg = true;
+			pCursor++;
+		} else {
+			pCursor = _aws_iot_log_parse_number(pCursor, &(pSpec->precision));
+		}
+	}
+
+	while(modifierLen < 2 && '\0' != *pCursor && NULL != strchr("hljztL", *pCursor)) {
+		pSpec->lengthModifier[modifierLen++] = *pCursor++;
+	}
+	pSpec->lengthModifier[modifierLen] = '\0';
+
+	pSpec->conversion = *pCursor;
+	switch(pSpec->conversion) {
+		case '%':
+			pSpec->argType = LOG_ARG_NONE;
+			break;
+		case 'd':
+		case 'i':
+			pSpec->argType = LOG_ARG_SIGNED;
+			break;
+		case 'u':
+		case 'o':
+		case 'x':
+		case 'X':
+			pSpec->argType = LOG_ARG_UNSIGNED;
+			break;
+		case 'c':
+			pSpec->argType = LOG_ARG_CHAR;
+			break;
+		case 'f':
+		case 'F':
+		case 'e':
+		case 'E':
+		case 'g':
+		case 'G':
+		case 'a':
+		case 'A':
+			pSpec->argType = LOG_ARG_DOUBLE;
+			break;
+		case 'p':
+			pSpec->argType = LOG_ARG_POINTER;
+			break;
+		case 's':
+			pSpec->argType = LOG_ARG_STRING;
+			break;
+		case 'n':
+			pSpec->argType = LOG_ARG_COUNT;
+			break;
+		default:
+			pSpec->argType = LOG_ARG_INVALID;
+			return pCursor;
+	}
+
+	return pCursor + 1;
+}
+
+static bool _aws_iot_log_put(IoT_Log_Record *pRecord, const void *pValue, size_t len) {
+	if(len > (size_t) (AWS_IOT_LOG_RECORD_ARGS_LEN - pRecord->argsLen)) {
+		return false;
+	}
+
+	memcpy(&(pRecord->args[pRecord->argsLen]), pValue, len);
+	pRecord->argsLen = (uint16_t) (pRecord->argsLen + len);
+	return true;
+}
+
+static bool _aws_iot_log_take(const IoT_Log_Record *pRecord, size_t *pOffset, void *pValue, size_t len) {
+	if(len > pRecord->argsLen - *pOffset) {
+		return false;
+	}
+
+	memcpy(pValue, &(pRecord->args[*pOffset]), len);
+	*pOffset += len;
+	return true;
+}
+
+/**
+ * @brief Read an integer argument with the type given by its length modifier
+ *
+ * @param pArgs Arguments of the logging macro
+ * @param pSpec Conversion specification of the argument
+ *
+ * @return The argument, widened to 64 bits
+ */
+static uint64_t _aws_iot_log_read_integer(va_list *pArgs, const IoT_Log_Spec *pSpec) {
+	bool isSigned = (LOG_ARG_SIGNED == pSpec->argType);
+	const char *pModifier = pSpec->lengthModifier;
+
+	if(0 == strcmp(pModifier, "hh")) {
+		return isSigned ? (uint64_t) (signed char) va_arg(*pArgs, int) : (uint64_t) (unsigned char) va_arg(*pArgs, int);
+	} else if(0 == strcmp(pModifier, "h")) {
+		return isSigned ? (uint64_t) (short) va_arg(*pArgs, int) : (uint64_t) (unsigned short) va_arg(*pArgs, int);
+	} else if(0 == strcmp(pModifier, "l")) {
+		return isSigned ? (uint64_t) va_arg(*pArgs, long) : (uint64_t) va_arg(*pArgs, unsigned long);
+	} else if(0 == strcmp(pModifier, "ll")) {
+		return isSigned ? (uint64_t) va_arg(*pArgs, long long) : (uint64_t) va_arg(*pArgs, unsigned long long);
+	} else if(0 == strcmp(pModifier, "j")) {
+		return isSigned ? (uint64_t) va_arg(*pArgs, intmax_t) : (uint64_t) va_arg(*pArgs, uintmax_t);
+	} else if(0 == strcmp(pModifier, "z")) {
+		return (uint64_t) va_arg(*pArgs, size_t);
+	} else if(0 == strcmp(pModifier, "t")) {
+		return (uint64_t) va_arg(*pArgs, ptrdiff_t);
+	}
+
+	return isSigned ? (uint64_t) va_arg(*pArgs, int) : (uint64_t) va_arg(*pArgs, unsigned int);
+}
+
+/**
+ * @brief Copy the arguments described by a format string into a record
+ *
+ * Stops at the first argument that does not fit, the formatter stops there as well.
+ *
+ * @param pRecord Record receiving the arguments
+ * @param pFormat Format string
+ * @param pArgs Arguments of the logging macro
+ */
+static void _aws_iot_log_capture(IoT_Log_Record *pRecord, const char *pFormat, va_list *pArgs) {
+	IoT_Log_Spec spec;
+	const char *pCursor = pFormat;
+	const char *pString;
+	int starValue;
+	size_t maxLen, len;
+	uint64_t integer;
+	double real;
+	void *pointer;
+
+	pRecord->argsLen = 0;
+
+	while(NULL != (pCursor = strchr(pCursor, '%'))) {
+		pCursor = _aws_iot_log_parse_spec(pCursor, &spec);
+		if(LOG_ARG_INVALID == spec.argType) {
+			return;
+		}
+
+		if(spec.isWidthArg) {
+			starValue = va_arg(*pArgs, int);
+			if(!_aws_iot_log_put(pRecord, &starValue, sizeof(starValue))) {
+				return;
+			}
+		}
+		if(spec.isPrecisionArg) {
+			starValue = va_arg(*pArgs, int);
+			spec.precision = starValue;
+			if(!_aws_iot_log_put(pRecord, &starValue, sizeof(starValue))) {
+				return;
+			}
+		}
+
+		switch(spec.argType) {
+			case LOG_ARG_SIGNED:
+			case LOG_ARG_UNSIGNED:
+				integer = _aws_iot_log_read_integer(pArgs, &spec);
+				if(!_aws_iot_log_put(pRecord, &integer, sizeof(integer))) {
+					return;
+				}
+				break;
+			case LOG_ARG_CHAR:
+				integer = (uint64_t) va_arg(*pArgs, int);
+				if(!_aws_iot_log_put(pRecord, &integer, sizeof(integer))) {
+					return;
+				}
+				break;
+			case LOG_ARG_DOUBLE:
+				real = (0 == strcmp(spec.lengthModifier, "L")) ? (double) va_arg(*pArgs, long double)
+															   : va_arg(*pArgs, double);
+				if(!_aws_iot_log_put(pRecord, &real, sizeof(real))) {
+					return;
+				}
+				break;
+			case LOG_ARG_POINTER:
+				pointer = va_arg(*pArgs, void *);
+				if(!_aws_iot_log_put(pRecord, &pointer, sizeof(pointer))) {
+					return;
+				}
+				break;
+			case LOG_ARG_STRING:
+				pString = va_arg(*pArgs, const char *);
+				if(NULL == pString) {
+					pString = "(null)";
+				}
+				/* Only the characters printed are copied, truncated to the space left */
+				maxLen = (0 <= spec.precision) ? (size_t) spec.precision : (size_t) -1;
+				if(pRecord->argsLen >= AWS_IOT_LOG_RECORD_ARGS_LEN) {
+					return;
+				}
+				if(maxLen > (size_t) (AWS_IOT_LOG_RECORD_ARGS_LEN - pRecord->argsLen - 1)) {
+					maxLen = (size_t) (AWS_IOT_LOG_RECORD_ARGS_LEN - pRecord->argsLen - 1);
+				}
+				for(len = 0; len < maxLen && '\0' != pString[len]; len++) {
+				}
+				memcpy(&(pRecord->args[pRecord->argsLen]), pString, len);
+				pRecord->args[pRecord->argsLen + len] = '\0';
+				pRecord->argsLen = (uint16_t) (pRecord->argsLen + len + 1);
+				break;
+			case LOG_ARG_COUNT:
+				(void) va_arg(*pArgs, void *);
+				break;
+			default:
+				break;
+		}
+	}
+}
+
+/**
+ * @brief Rebuild a conversion specification with the '*' values and a 64 bit length modifier
+ *
+ * @param pSpec Parsed specification
+ * @param width Width, used if given as an argument
+ * @param precision Precision, used if given as an argument
+ * @param pOut Output parameter, NULL terminated specification
+ */
+static void _aws_iot_log_build_spec(const IoT_Log_Spec *pSpec, int width, int precision, char *pOut) {
+	size_t len = 0;
+	size_t flagsLen = (pSpec->flagsLen < 6) ? pSpec->flagsLen : 6;
+	const char *pModifier = "";
+
+	pOut[len++] = '%';
+	memcpy(&pOut[len], pSpec->pStart + 1, flagsLen);
+	len += flagsLen;
+
+	if(pSpec->isWidthArg || 0 <= pSpec->width) {
+		len += (size_t) snprintf(&pOut[len], LOG_SPEC_LEN - len, "%d", pSpec->isWidthArg ? width : pSpec->width);
+	}
+	if(pSpec->isPrecisionArg || 0 <= pSpec->precision) {
+		len += (size_t) snprintf(&pOut[len], LOG_SPEC_LEN - len, ".%d",
+								 pSpec->isPrecisionArg ? precision : pSpec->precision);
+	}
+
+	if(LOG_ARG_SIGNED == pSpec->argType || LOG_ARG_UNSIGNED == pSpec->argType) {
+		pModifier = "ll";
+	}
+	(void) snprintf(&pOut[len], LOG_SPEC_LEN - len, "%s%c", pModifier, pSpec->conversion);
+}
+
+/* Add the length reported by snprintf, which is the untruncated length */
+static size_t _aws_iot_log_advance(size_t len, size_t maxLen, int written) {
+	if(0 < written) {
+		len += (size_t) written;
+	}
+	return (len > maxLen) ? maxLen : len;
+}
+
+/**
+ * @brief Format a record as a log line
+ *
+ * @param pRecord Record to format
+ * @param pLine Output buffer of AWS_IOT_LOG_LINE_LEN + 1 bytes
+ *
+ * @return Length of the line, newline included
+ */
+static size_t _aws_iot_log_format(const IoT_Log_Record *pRecord, char *pLine) {
+	const size_t maxLen = AWS_IOT_LOG_LINE_LEN - 1; /* Room for the newline */
+	const IoT_Log_Site *pSite = pRecord->pSite;
+	const char *pCursor = pRecord->pFormat;
+	const char *pNext;
+	char specBuf[LOG_SPEC_LEN];
+	IoT_Log_Spec spec;
+	size_t len = 0, offset = 0, literalLen;
+	int width = 0, precision = 0, written;
+	uint64_t integer;
+	double real;
+	void *pointer;
+	bool isComplete = true;
+
+	if(NULL != pSite->pPrefix) {
+		written = snprintf(pLine, maxLen + 1, "%s %s L#%d ", pSite->pPrefix, pSite->pFunction, pSite->line);
+		len = _aws_iot_log_advance(len, maxLen, written);
+	}
+
+	while(len < maxLen && '\0' != *pCursor) {
+		pNext = strchr(pCursor, '%');
+		literalLen = (NULL == pNext) ? strlen(pCursor) : (size_t) (pNext - pCursor);
+		if(literalLen > maxLen - len) {
+			literalLen = maxLen - len;
+		}
+		memcpy(&pLine[len], pCursor, literalLen);
+		len += literalLen;
+		if(NULL == pNext) {
+			break;
+		}
+
+		pCursor = _aws_iot_log_parse_spec(pNext, &spec);
+		if(LOG_ARG_INVALID == spec.argType) {
+			/* The arguments were not captured past this point */
+			written = snprintf(&pLine[len], maxLen - len + 1, "%s", pNext);
+			len = _aws_iot_log_advance(len, maxLen, written);
+			break;
+		}
+
+		if((spec.isWidthArg && !_aws_iot_log_take(pRecord, &offset, &width, sizeof(width)))
+		   || (spec.isPrecisionArg && !_aws_iot_log_take(pRecord, &offset, &precision, sizeof(precision)))) {
+			isComplete = false;
+			break;
+		}
+		_aws_iot_log_build_spec(&spec, width, precision, specBuf);
+
+		written = 0;
+		switch(spec.argType) {
+			case LOG_ARG_NONE:
+				written = snprintf(&pLine[len], maxLen - len + 1, "%%");
+				break;
+			case LOG_ARG_SIGNED:
+			case LOG_ARG_UNSIGNED:
+			case LOG_ARG_CHAR:
+				if(!_aws_iot_log_take(pRecord, &offset, &integer, sizeof(integer))) {
+					isComplete = false;
+				} else if(LOG_ARG_SIGNED == spec.argType) {
+					written = snprintf(&pLine[len], maxLen - len + 1, specBuf, (long long) integer);
+				} else if(LOG_ARG_UNSIGNED == spec.argType) {
+					written = snprintf(&pLine[len], maxLen - len + 1, specBuf, (unsigned long long) integer);
+				} else {
+					written = snprintf(&pLine[len], maxLen - len + 1, specBuf, (int) integer);
+				}
+				break;
+			case LOG_ARG_DOUBLE:
+				if(!_aws_iot_log_take(pRecord, &offset, &real, sizeof(real))) {
+					isComplete = false;
+				} else {
+					written = snprintf(&pLine[len], maxLen - len + 1, specBuf, real);
+				}
+				break;
+			case LOG_ARG_POINTER:
+				if(!_aws_iot_log_take(pRecord, &offset, &pointer, sizeof(pointer))) {
+					isComplete = false;
+				} else {
+					written = snprintf(&pLine[len], maxLen - len + 1, specBuf, pointer);
+				}
+				break;
+			case LOG_ARG_STRING:
+				if(offset >= pRecord->argsLen) {
+					isComplete = false;
+				} else {
+					written = snprintf(&pLine[len], maxLen - len + 1, specBuf, (const char *) &(pRecord->args[offset]));
+					offset += strlen((const char *) &(pRecord->args[offset])) + 1;
+				}
+				break;
+			default:
+				break;
+		}
+
+		if(!isComplete) {
+			break;
+		}
+		len = _aws_iot_log_advance(len, maxLen, written);
+	}
+
+	if(!isComplete) {
+		written = snprintf(&pLine[len], maxLen - len + 1, "...");
+		len = _aws_iot_log_advance(len, maxLen, written);
+	}
+	if(0 < pRecord->suppressedCount) {
+		written = snprintf(&pLine[len], maxLen - len + 1, " [%u similar messages suppressed]",
+						   (unsigned) pRecord->suppressedCount);
+		len = _aws_iot_log_advance(len, maxLen, written);
+	}
+
+	pLine[len++] = '\n';
+	return len;
+}
+
+static void _aws_iot_log_output(const char *pLine, size_t len) {
+	if(NULL != logOutput) {
+		logOutput(pLine, len);
+	} else {
+		(void) fwrite(pLine, 1, len, stdout);
+	}
+}
+
+/**
+ * @brief Get the ring of the calling thread, claiming a free one on its first message
+ *
+ * @return The ring, NULL if every ring is owned by another thread
+ */
+static IoT_Log_Ring *_aws_iot_log_get_ring(void) {
+#ifdef _ENABLE_THREAD_SUPPORT_
+	uint32_t itr, state;
+
+	if(NULL == pThreadRing) {
+		for(itr = 0; itr < AWS_IOT_LOG_MAX_THREADS; itr++) {
+			state = LOG_RING_FREE;
+			if(aws_iot_thread_atomic_compare_exchange(&(logRings[itr].state), &state, LOG_RING_OWNED)) {
+				if(SUCCESS != aws_iot_log_watch_thread_exit(&logRings[itr])) {
+					/* The ring would never be given back */
+					aws_iot_thread_atomic_store(&(logRings[itr].state), LOG_RING_FREE);
+					break;
+				}
+				pThreadRing = &logRings[itr];
+				break;
+			}
+		}
+	}
+
+	return pThreadRing;
+#else
+	return &logRings[0];
+#endif
+}
+
+#ifdef _ENABLE_THREAD_SUPPORT_
+void aws_iot_log_release_thread(void *pRing) {
+	IoT_Log_Ring *pReleasedRing = (IoT_Log_Ring *) pRing;
+
+	if(pReleasedRing != pThreadRing) {
+		return;
+	}
+
+	pThreadRing = NULL;
+	/* An empty ring is free at once, otherwise the flush frees it once drained */
+	if(aws_iot_thread_atomic_load(&(pReleasedRing->tail)) == pReleasedRing->head) {
+		aws_iot_thread_atomic_store(&(pReleasedRing->state), LOG_RING_FREE);
+	} else {
+		aws_iot_thread_atomic_store(&(pReleasedRing->state), LOG_RING_RELEASED);
+	}
+}
+
+/* Only held while a record is stored, threads spin for it instead of sleeping */
+static void _aws_iot_log_lock_shared_ring(void) {
+	uint32_t isLocked;
+
+	do {
+		isLocked = 0;
+	} while(!aws_iot_thread_atomic_compare_exchange(&isSharedRingLocked, &isLocked, 1));
+}
+
+static void _aws_iot_log_unlock_shared_ring(void) {
+	aws_iot_thread_atomic_store(&isSharedRingLocked, 0);
+}
+#endif
+
+/**
+ * @brief Apply the rate limit of a call site
+ *
+ * Races between threads logging from the same call site may let a few more messages through.
+ *
+ * @param pSite Call site
+ * @param pSuppressedCount Output parameter, messages suppressed since the last one logged
+ *
+ * @return true if the message is logged
+ */
+static bool _aws_iot_log_is_within_rate(IoT_Log_Site *pSite, uint32_t *pSuppressedCount) {
+	uint32_t nowMs;
+
+	*pSuppressedCount = 0;
+	if(0 == logRateLimit) {
+		return true;
+	}
+
+	nowMs = timer_now_ms();
+	if(nowMs - pSite->windowStartMs >= 1000 || 0 == pSite->windowCount) {
+		*pSuppressedCount = pSite->suppressedCount;
+		pSite->suppressedCount = 0;
+		pSite->windowStartMs = nowMs;
+		pSite->windowCount = 0;
+	}
+
+	if(pSite->windowCount >= logRateLimit) {
+		pSite->suppressedCount++;
+		return false;
+	}
+
+	pSite->windowCount++;
+	return true;
+}
+
+/**
+ * @brief Store a record in a ring, or count it as dropped if the ring is full
+ *
+ * @param pRing Ring of the calling thread, or the shared ring with its lock held
+ * @param pSite Call site of the logging macro
+ * @param suppressedCount Messages of the call site suppressed before this one
+ * @param pFormat Format string
+ * @param pArgs Arguments of the logging macro
+ */
+static void _aws_iot_log_queue(IoT_Log_Ring *pRing, IoT_Log_Site *pSite, uint32_t suppressedCount,
+							   const char *pFormat, va_list *pArgs) {
+	IoT_Log_Record *pRecord;
+	uint32_t head = pRing->head;
+
+	if(AWS_IOT_LOG_RING_RECORDS == head - _aws_iot_log_load(&(pRing->tail))) {
+		_aws_iot_log_store(&(pRing->droppedCount), pRing->droppedCount + 1);
+		/* Reported with the next message of the call site instead */
+		pSite->suppressedCount += suppressedCount;
+		return;
+	}
+
+	pRecord = &(pRing->records[head & (AWS_IOT_LOG_RING_RECORDS - 1)]);
+	pRecord->pSite = pSite;
+	pRecord->pFormat = pFormat;
+	pRecord->suppressedCount = suppressedCount;
+	_aws_iot_log_capture(pRecord, pFormat, pArgs);
+
+	/* Publishes the record to the flush */
+	_aws_iot_log_store(&(pRing->head), head + 1);
+}
+
+void aws_iot_log_write(IoT_Log_Site *pSite, const char *pFormat, ...) {
+	IoT_Log_Ring *pRing;
+	uint32_t suppressedCount;
+	va_list args;
+
+	if(NULL == pSite || NULL == pFormat || pSite->level < logLevel) {
+		return;
+	}
+
+	if(!_aws_iot_log_is_within_rate(pSite, &suppressedCount)) {
+		return;
+	}
+
+	va_start(args, pFormat);
+	pRing = _aws_iot_log_get_ring();
+#ifdef _ENABLE_THREAD_SUPPORT_
+	if(NULL == pRing) {
+		_aws_iot_log_lock_shared_ring();
+		_aws_iot_log_queue(LOG_SHARED_RING, pSite, suppressedCount, pFormat, &args);
+		_aws_iot_log_unlock_shared_ring();
+	} else
+#endif
+	{
+		_aws_iot_log_queue(pRing, pSite, suppressedCount, pFormat, &args);
+	}
+	va_end(args);
+}
+
+uint32_t aws_iot_log_flush(void) {
+	IoT_Log_Ring *pRing;
+	uint32_t itr, head, tail, droppedCount, count = 0;
+	char line[AWS_IOT_LOG_LINE_LEN + 1];
+	size_t len;
+#ifdef _ENABLE_THREAD_SUPPORT_
+	uint32_t state, isIdle = 0;
+
+	if(!aws_iot_thread_atomic_compare_exchange(&isFlushing, &isIdle, 1)) {
+		return 0;
+	}
+#endif
+
+	for(itr = 0; itr < LOG_RING_COUNT; itr++) {
+		pRing = &logRings[itr];
+#ifdef _ENABLE_THREAD_SUPPORT_
+		/* Read first, the head of a released ring does not move anymore */
+		state = aws_iot_thread_atomic_load(&(pRing->state));
+#endif
+		head = _aws_iot_log_load(&(pRing->head));
+		for(tail = pRing->tail; tail != head; tail++) {
+			len = _aws_iot_log_format(&(pRing->records[tail & (AWS_IOT_LOG_RING_RECORDS - 1)]), line);
+			_aws_iot_log_output(line, len);
+			/* Gives the slot back to the thread */
+			_aws_iot_log_store(&(pRing->tail), tail + 1);
+			count++;
+		}
+
+		droppedCount = _aws_iot_log_load(&(pRing->droppedCount));
+		if(droppedCount != pRing->reportedDroppedCount) {
+			len = (size_t) snprintf(line, sizeof(line), "WARN:  %u log records dropped, the ring was full\n",
+									(unsigned) (droppedCount - pRing->reportedDroppedCount));
+			_aws_iot_log_output(line, (len < sizeof(line)) ? len : sizeof(line) - 1);
+			pRing->reportedDroppedCount = droppedCount;
+		}
+
+#ifdef _ENABLE_THREAD_SUPPORT_
+		if(LOG_RING_RELEASED == state) {
+			(void) aws_iot_thread_atomic_compare_exchange(&(pRing->state), &state, LOG_RING_FREE);
+		}
+#endif
+	}
+
+#ifdef _ENABLE_THREAD_SUPPORT_
+	aws_iot_thread_atomic_store(&isFlushing, 0);
+#endif
+
+	return count;
+}
+
+void aws_iot_log_set_level(IoT_Log_Level level) {
+	logLevel = level;
+}
+
+void aws_iot_log_set_rate_limit(uint32_t maxPerSecond) {
+	logRateLimit = maxPerSecond;
+}
+
+void aws_iot_log_set_output(pLogOutput_t outputFunc) {
+	logOutput = outputFunc;
+}
+
+uint32_t aws_iot_log_get_dropped_count(void) {
+	uint32_t itr, count = 0;
+
+	for(itr = 0; itr < LOG_RING_COUNT; itr++) {
+		count += _aws_iot_log_load(&(logRings[itr].droppedCount));
+	}
+
+	return count;
+}
+
+#endif /* ENABLE_IOT_ASYNC_LOG */
+
+#ifdef __cplusplus
+}
+#endif
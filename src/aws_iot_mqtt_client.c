@@ -159,6 +159,11 @@ IoT_Error_t aws_iot_mqtt_set_client_state(AWS_IoT_Client *pClient, ClientState e
 	if(SUCCESS == rc && SUCCESS != threadRc) {
 		rc = threadRc;
 	}
+
+	/* Publishes waiting on the thread that used the client may take over from here */
+	if(SUCCESS == rc && CLIENT_STATE_CONNECTED_IDLE == newState) {
+		aws_iot_mqtt_internal_wake_inflight_waiters(pClient);
+	}
 #endif
 
 	FUNC_EXIT_RC(rc);
@@ -225,7 +230,36 @@ IoT_Error_t aws_iot_mqtt_free(AWS_IoT_Client *pClient)
 		}else{
 			(void)aws_iot_thread_mutex_destroy(&(pClient->clientData.tls_write_mutex));
 		}
+
+		if (rc == SUCCESS)
+		{
+			rc = aws_iot_thread_mutex_destroy(&(pClient->clientData.inflight_mutex));
+		}else{
+			(void)aws_iot_thread_mutex_destroy(&(pClient->clientData.inflight_mutex));
+		}
+
+		if (rc == SUCCESS)
+		{
+			rc = aws_iot_thread_cond_destroy(&(pClient->clientData.inflight_cond));
+		}else{
+			(void)aws_iot_thread_cond_destroy(&(pClient->clientData.inflight_cond));
+		}
+	#endif
+	#ifdef AWS_IOT_MQTT_ENABLE_OFFLINE_QUEUE
+		if (rc == SUCCESS)
+		{
+			rc = aws_iot_mqtt_internal_offline_queue_free(pClient);
+		}else{
+			(void)aws_iot_mqtt_internal_offline_queue_free(pClient);
+		}
 	#endif
+		if (rc == SUCCESS)
+		{
+			rc = iot_tls_free(&(pClient->networkStack));
+		}else{
+			(void)iot_tls_free(&(pClient->networkStack));
+		}
+		aws_iot_mqtt_internal_storage_free(pClient);
 	}
 
     FUNC_EXIT_RC(rc);
@@ -244,25 +278,63 @@ IoT_Error_t aws_iot_mqtt_init(AWS_IoT_Client *pClient, IoT_Client_Init_Params *p
 		FUNC_EXIT_RC(NULL_VALUE_ERROR);
 	}
 
-	for(i = 0; i < AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS; ++i) {
+	rc = aws_iot_mqtt_internal_storage_init(pClient, pInitParams);
+	if(SUCCESS != rc) {
+		FUNC_EXIT_RC(rc);
+	}
+
+	for(i = 0; i < pClient->clientData.messageHandlerCount; ++i) {
 		pClient->clientData.messageHandlers[i].topicName = NULL;
 		pClient->clientData.messageHandlers[i].pApplicationHandler = NULL;
+		pClient->clientData.messageHandlers[i].pApplicationFragmentHandler = NULL;
 		pClient->clientData.messageHandlers[i].pApplicationHandlerData = NULL;
 		pClient->clientData.messageHandlers[i].qos = QOS0;
+		pClient->clientData.messageHandlers[i].trieNode = TOPIC_TRIE_INDEX_NONE;
+		pClient->clientData.messageHandlers[i].nextTrieHandler = TOPIC_TRIE_INDEX_NONE;
 	}
+	aws_iot_mqtt_internal_topic_trie_init(pClient);
+#ifdef AWS_IOT_MQTT_OUTBOUND_QUEUE_SLOTS
+	aws_iot_mqtt_internal_outbound_queue_init(pClient);
+#endif
+
+	for(i = 0; i < pClient->clientData.inflightPublishCount; ++i) {
+		pClient->clientData.inflightPublishes[i].isFree = true;
+		pClient->clientData.inflightPublishes[i].pCompleteHandler = NULL;
+		pClient->clientData.inflightPublishes[i].pCompleteHandlerData = NULL;
+		pClient->clientData.inflightPublishes[i].isWaited = false;
+		pClient->clientData.inflightPublishes[i].isComplete = false;
+#ifdef AWS_IOT_MQTT_INFLIGHT_PACKET_LEN
+		pClient->clientData.inflightPublishes[i].storedLen = 0;
+#endif
+	}
+	aws_iot_timer_wheel_init(&(pClient->clientData.inflightWheel), pClient->clientData.inflightWheelEntries,
+							 pClient->clientData.inflightPublishCount);
 
 	pClient->clientData.packetTimeoutMs = pInitParams->mqttPacketTimeout_ms;
 	pClient->clientData.commandTimeoutMs = pInitParams->mqttCommandTimeout_ms;
-	pClient->clientData.writeBufSize = AWS_IOT_MQTT_TX_BUF_LEN;
-	pClient->clientData.readBufSize = AWS_IOT_MQTT_RX_BUF_LEN;
+	pClient->clientData.readBufIndex = 0;
+	pClient->clientData.readBufPacketLen = 0;
 	pClient->clientData.counterNetworkDisconnected = 0;
+#ifdef AWS_IOT_MQTT_ENABLE_STATS
+	memset(&(pClient->clientData.stats), 0, sizeof(IoT_Client_Stats));
+#endif
 	pClient->clientData.disconnectHandler = pInitParams->disconnectHandler;
 	pClient->clientData.disconnectHandlerData = pInitParams->disconnectHandlerData;
 	pClient->clientData.nextPacketId = 1;
+	pClient->clientData.currentReconnectWaitInterval = 0;
+	pClient->clientData.reconnectAttempt = 0;
+	pClient->clientData.minReconnectWaitMs = (0 != pInitParams->minReconnectWait_ms) ?
+											 pInitParams->minReconnectWait_ms : AWS_IOT_MQTT_MIN_RECONNECT_WAIT_INTERVAL;
+	pClient->clientData.maxReconnectWaitMs = (0 != pInitParams->maxReconnectWait_ms) ?
+											 pInitParams->maxReconnectWait_ms : AWS_IOT_MQTT_MAX_RECONNECT_WAIT_INTERVAL;
+	pClient->clientData.reconnectJitterState = 0;
+	pClient->clientData.reconnectPolicy = (NULL != pInitParams->reconnectPolicy) ?
+										  pInitParams->reconnectPolicy : aws_iot_mqtt_reconnect_policy_decorrelated_jitter;
 
 	/* Initialize default connection options */
 	rc = aws_iot_mqtt_set_connect_params(pClient, &default_options);
 	if(SUCCESS != rc) {
+		aws_iot_mqtt_internal_storage_free(pClient);
 		FUNC_EXIT_RC(rc);
 	}
 
@@ -270,34 +342,68 @@ IoT_Error_t aws_iot_mqtt_init(AWS_IoT_Client *pClient, IoT_Client_Init_Params *p
 	pClient->clientData.isBlockOnThreadLockEnabled = pInitParams->isBlockOnThreadLockEnabled;
 	rc = aws_iot_thread_mutex_init(&(pClient->clientData.state_change_mutex));
 	if(SUCCESS != rc) {
+		aws_iot_mqtt_internal_storage_free(pClient);
 		FUNC_EXIT_RC(rc);
 	}
 	rc = aws_iot_thread_mutex_init(&(pClient->clientData.tls_read_mutex));
 	if(SUCCESS != rc) {
 		(void)aws_iot_thread_mutex_destroy(&(pClient->clientData.state_change_mutex));
+		aws_iot_mqtt_internal_storage_free(pClient);
 		FUNC_EXIT_RC(rc);
 	}
 	rc = aws_iot_thread_mutex_init(&(pClient->clientData.tls_write_mutex));
 	if(SUCCESS != rc) {
 		(void)aws_iot_thread_mutex_destroy(&(pClient->clientData.tls_read_mutex));
 		(void)aws_iot_thread_mutex_destroy(&(pClient->clientData.state_change_mutex));
+		aws_iot_mqtt_internal_storage_free(pClient);
+		FUNC_EXIT_RC(rc);
+	}
+	rc = aws_iot_thread_mutex_init(&(pClient->clientData.inflight_mutex));
+	if(SUCCESS != rc) {
+		(void)aws_iot_thread_mutex_destroy(&(pClient->clientData.tls_write_mutex));
+		(void)aws_iot_thread_mutex_destroy(&(pClient->clientData.tls_read_mutex));
+		(void)aws_iot_thread_mutex_destroy(&(pClient->clientData.state_change_mutex));
+		aws_iot_mqtt_internal_storage_free(pClient);
+		FUNC_EXIT_RC(rc);
+	}
+	rc = aws_iot_thread_cond_init(&(pClient->clientData.inflight_cond));
+	if(SUCCESS != rc) {
+		(void)aws_iot_thread_mutex_destroy(&(pClient->clientData.inflight_mutex));
+		(void)aws_iot_thread_mutex_destroy(&(pClient->clientData.tls_write_mutex));
+		(void)aws_iot_thread_mutex_destroy(&(pClient->clientData.tls_read_mutex));
+		(void)aws_iot_thread_mutex_destroy(&(pClient->clientData.state_change_mutex));
+		aws_iot_mqtt_internal_storage_free(pClient);
 		FUNC_EXIT_RC(rc);
 	}
 #endif
 
 	pClient->clientStatus.isPingOutstanding = 0;
+	pClient->clientData.isKeepAliveAdaptive = pInitParams->isKeepAliveAdaptive;
+	pClient->clientData.pingIntervalSec = 0;
+	pClient->clientData.pingIntervalConfirmedSec = 0;
+	pClient->clientData.pingProbeSec = 0;
+	pClient->clientData.isIdleSincePingTimer = false;
 	pClient->clientStatus.isAutoReconnectEnabled = pInitParams->enableAutoReconnect;
+	pClient->clientStatus.isSessionPresent = false;
+
+	/* Optional network functions are left unset by ports that do not implement them */
+	pClient->networkStack.readAvailable = NULL;
+	pClient->networkStack.writeVector = NULL;
 
 	rc = iot_tls_init(&(pClient->networkStack), pInitParams->pRootCALocation, pInitParams->pDeviceCertLocation,
 					  pInitParams->pDevicePrivateKeyLocation, pInitParams->pHostURL, pInitParams->port,
-					  pInitParams->tlsHandshakeTimeout_ms, pInitParams->isSSLHostnameVerify);
+					  pInitParams->tlsHandshakeTimeout_ms, pInitParams->isSSLHostnameVerify,
+					  pInitParams->pTlsSessionLocation);
 
 	if(SUCCESS != rc) {
 		#ifdef _ENABLE_THREAD_SUPPORT_
 		(void)aws_iot_thread_mutex_destroy(&(pClient->clientData.tls_read_mutex));
 		(void)aws_iot_thread_mutex_destroy(&(pClient->clientData.state_change_mutex));
 		(void)aws_iot_thread_mutex_destroy(&(pClient->clientData.tls_write_mutex));
+		(void)aws_iot_thread_mutex_destroy(&(pClient->clientData.inflight_mutex));
+		(void)aws_iot_thread_cond_destroy(&(pClient->clientData.inflight_cond));
 		#endif
+		aws_iot_mqtt_internal_storage_free(pClient);
 		pClient->clientStatus.clientState = CLIENT_STATE_INVALID;
 		FUNC_EXIT_RC(rc);
 	}
@@ -306,14 +412,41 @@ IoT_Error_t aws_iot_mqtt_init(AWS_IoT_Client *pClient, IoT_Client_Init_Params *p
 	init_timer(&(pClient->pingRespTimer));
 	init_timer(&(pClient->reconnectDelayTimer));
 
+#ifdef AWS_IOT_MQTT_ENABLE_OFFLINE_QUEUE
+	rc = aws_iot_mqtt_internal_offline_queue_init(pClient, pInitParams);
+	if(SUCCESS != rc) {
+		#ifdef _ENABLE_THREAD_SUPPORT_
+		(void)aws_iot_thread_mutex_destroy(&(pClient->clientData.tls_read_mutex));
+		(void)aws_iot_thread_mutex_destroy(&(pClient->clientData.state_change_mutex));
+		(void)aws_iot_thread_mutex_destroy(&(pClient->clientData.tls_write_mutex));
+		(void)aws_iot_thread_mutex_destroy(&(pClient->clientData.inflight_mutex));
+		(void)aws_iot_thread_cond_destroy(&(pClient->clientData.inflight_cond));
+		#endif
+		aws_iot_mqtt_internal_storage_free(pClient);
+		pClient->clientStatus.clientState = CLIENT_STATE_INVALID;
+		FUNC_EXIT_RC(rc);
+	}
+#endif
+
 	pClient->clientStatus.clientState = CLIENT_STATE_INITIALIZED;
 
 	FUNC_EXIT_RC(SUCCESS);
 }
 
 uint16_t aws_iot_mqtt_get_next_packet_id(AWS_IoT_Client *pClient) {
-	return pClient->clientData.nextPacketId = (uint16_t) ((MAX_PACKET_ID == pClient->clientData.nextPacketId) ? 1 : (
+	uint16_t packetId;
+
+#ifdef _ENABLE_THREAD_SUPPORT_
+	/* Publishing threads take identifiers while another thread uses the client */
+	(void)aws_iot_thread_mutex_lock(&(pClient->clientData.inflight_mutex));
+#endif
+	packetId = pClient->clientData.nextPacketId = (uint16_t) ((MAX_PACKET_ID == pClient->clientData.nextPacketId) ? 1 : (
 			pClient->clientData.nextPacketId + 1));
+#ifdef _ENABLE_THREAD_SUPPORT_
+	(void)aws_iot_thread_mutex_unlock(&(pClient->clientData.inflight_mutex));
+#endif
+
+	return packetId;
 }
 
 bool aws_iot_mqtt_is_client_connected(AWS_IoT_Client *pClient) {
@@ -296,9 +296,92 @@ IoT_Error_t aws_iot_mqtt_internal_init_header(MQTTHeader *pHeader, MessageTypes
 	FUNC_EXIT_RC(SUCCESS);
 }
 
+/**
+ * @brief Take ownership of the outgoing data buffer
+ *
+ * Packets are serialized into the client write buffer and sent from it, so with thread
+ * support the write mutex is held from serialization until the packet has been sent.
+ * This lets any thread write while another one reads. Does nothing without thread support.
+ *
+ * @param pClient MQTT client
+ *
+ * @return IoT_Error_t of mutex operation
+ */
+IoT_Error_t aws_iot_mqtt_internal_lock_write_buffer(AWS_IoT_Client *pClient) {
+#ifdef _ENABLE_THREAD_SUPPORT_
+	return aws_iot_mqtt_client_lock_mutex(pClient, &(pClient->clientData.tls_write_mutex));
+#else
+	IOT_UNUSED(pClient);
+	return SUCCESS;
+#endif
+}
+
+/**
+ * @brief Release the outgoing data buffer taken with aws_iot_mqtt_internal_lock_write_buffer
+ *
+ * @param pClient MQTT client
+ * @param rc Result of the operation done with the buffer
+ *
+ * @return rc, or the mutex error if the operation succeeded but the buffer could not be released
+ */
+IoT_Error_t aws_iot_mqtt_internal_unlock_write_buffer(AWS_IoT_Client *pClient, IoT_Error_t rc) {
+#ifdef _ENABLE_THREAD_SUPPORT_
+	IoT_Error_t threadRc = aws_iot_mqtt_client_unlock_mutex(pClient, &(pClient->clientData.tls_write_mutex));
+#ifdef AWS_IOT_MQTT_OUTBOUND_QUEUE_SLOTS
+	/* Packets queued while the buffer was held. A failure shows on the next operation */
+	(void)aws_iot_mqtt_internal_outbound_queue_send(pClient);
+#endif
+	if(SUCCESS == rc && SUCCESS != threadRc) {
+		return threadRc;
+	}
+#else
+	IOT_UNUSED(pClient);
+#endif
+	return rc;
+}
+
+/**
+ * @brief Set up the keep alive of a new connection
+ *
+ * Called once the keep alive interval of the connection is known. An adaptive keep alive
+ * starts probing again from AWS_IOT_MQTT_ADAPTIVE_KEEP_ALIVE_MIN_SEC when the interval
+ * changed, otherwise the idle time learnt on the previous connections is kept.
+ *
+ * @param pClient MQTT client
+ */
+void aws_iot_mqtt_internal_keep_alive_init(AWS_IoT_Client *pClient) {
+	uint16_t keepAliveInterval = pClient->clientData.options.keepAliveIntervalInSec;
+
+	if(!pClient->clientData.isKeepAliveAdaptive) {
+		pClient->clientData.pingIntervalSec = keepAliveInterval;
+	} else if(0 == pClient->clientData.pingIntervalSec || keepAliveInterval != pClient->clientData.keepAliveInterval) {
+		pClient->clientData.pingIntervalSec = (AWS_IOT_MQTT_ADAPTIVE_KEEP_ALIVE_MIN_SEC < keepAliveInterval) ?
+											  AWS_IOT_MQTT_ADAPTIVE_KEEP_ALIVE_MIN_SEC : keepAliveInterval;
+		pClient->clientData.pingIntervalConfirmedSec = 0;
+	}
+
+	pClient->clientData.keepAliveInterval = keepAliveInterval;
+	pClient->clientData.pingProbeSec = 0;
+}
+
+/**
+ * @brief Restart the timer of the next PINGREQ
+ *
+ * Any control packet sent resets the keep alive of the broker, so a PINGREQ is only
+ * needed once the client has been silent for the PINGREQ interval.
+ *
+ * @param pClient MQTT client
+ */
+void aws_iot_mqtt_internal_restart_ping_timer(AWS_IoT_Client *pClient) {
+	countdown_sec(&(pClient->pingReqTimer), pClient->clientData.pingIntervalSec);
+	pClient->clientData.isIdleSincePingTimer = true;
+}
+
 /**
  * @brief Send an MQTT packet on the network
  *
+ * The caller owns the write buffer, see aws_iot_mqtt_internal_lock_write_buffer.
+ *
  * @param pClient MQTT client which holds packet
  * @param length Length of packet to send
  * @param pTimer Amount of time allowed to send packet
@@ -320,13 +403,7 @@ IoT_Error_t aws_iot_mqtt_internal_send_packet(AWS_IoT_Client *pClient, size_t le
 		FUNC_EXIT_RC(MQTT_TX_BUFFER_TOO_SHORT_ERROR);
 	}
 
-#ifdef _ENABLE_THREAD_SUPPORT_
-	rc = aws_iot_mqtt_client_lock_mutex(pClient, &(pClient->clientData.tls_write_mutex));
-	if(SUCCESS != rc) {
-		FUNC_EXIT_RC(rc);
-	}
-#endif
-
+	rc = NETWORK_SSL_WRITE_TIMEOUT_ERROR;
 	sentLen = 0;
 	sent = 0;
 
@@ -343,22 +420,148 @@ IoT_Error_t aws_iot_mqtt_internal_send_packet(AWS_IoT_Client *pClient, size_t le
 		sent += sentLen;
 	}
 
-#ifdef _ENABLE_THREAD_SUPPORT_
-	rc = aws_iot_mqtt_client_unlock_mutex(pClient, &(pClient->clientData.tls_write_mutex));
-	if(SUCCESS != rc) {
-		FUNC_EXIT_RC(rc);
-	}
+	if(sent == length) {
+		/* record the fact that we have successfully sent the packet */
+		aws_iot_mqtt_internal_restart_ping_timer(pClient);
+#ifdef AWS_IOT_MQTT_ENABLE_STATS
+		aws_iot_mqtt_internal_stats_count_sent(pClient, pClient->clientData.writeBuf, length);
 #endif
+		FUNC_EXIT_RC(SUCCESS);
+	}
+
+	FUNC_EXIT_RC(rc)
+}
+
+/**
+ * @brief Send an MQTT packet whose payload is held outside of the write buffer
+ *
+ * The packet header is taken from the start of the client write buffer. A payload that fits
+ * in the rest of the write buffer is copied behind the header and sent with it in one write.
+ * A longer payload is handed to the network layer in place, so its length is not limited
+ * by the write buffer size.
+ * The caller owns the write buffer, see aws_iot_mqtt_internal_lock_write_buffer.
+ *
+ * @param pClient MQTT client which holds the packet header
+ * @param headerLength Length of the packet header serialized in the write buffer
+ * @param pPayload Payload to send after the header
+ * @param payloadLength Length of the payload
+ * @param pTimer Amount of time allowed to send packet
+ *
+ * @return IoT_Error_t of send status
+ */
+IoT_Error_t aws_iot_mqtt_internal_send_packet_with_payload(AWS_IoT_Client *pClient, size_t headerLength,
+														 const unsigned char *pPayload, size_t payloadLength,
+														 Timer *pTimer) {
+	NetworkBufferVector vector[2];
+	size_t vectorCount, length, sentLen, sent;
+	IoT_Error_t rc = NETWORK_SSL_WRITE_TIMEOUT_ERROR;
+
+	FUNC_ENTRY;
+
+	if(NULL == pClient || NULL == pTimer || (NULL == pPayload && 0 < payloadLength)) {
+		FUNC_EXIT_RC(NULL_VALUE_ERROR);
+	}
+
+	if(headerLength >= pClient->clientData.writeBufSize) {
+		FUNC_EXIT_RC(MQTT_TX_BUFFER_TOO_SHORT_ERROR);
+	}
+
+	length = headerLength + payloadLength;
+
+	/* A payload that fits behind the header is copied there, the packet is then one write and one TLS record */
+	if(length < pClient->clientData.writeBufSize) {
+		if(0 < payloadLength) {
+			memcpy(&pClient->clientData.writeBuf[headerLength], pPayload, payloadLength);
+		}
+		FUNC_EXIT_RC(aws_iot_mqtt_internal_send_packet(pClient, length, pTimer));
+	}
+
+	sent = 0;
+
+	while(sent < length && !has_timer_expired(pTimer)) {
+		sentLen = 0;
+		if(sent < headerLength) {
+			vector[0].pBuffer = &pClient->clientData.writeBuf[sent];
+			vector[0].len = headerLength - sent;
+			vector[1].pBuffer = (unsigned char *) pPayload;
+			vector[1].len = payloadLength;
+			vectorCount = (0 < payloadLength) ? 2 : 1;
+		} else {
+			vector[0].pBuffer = (unsigned char *) &pPayload[sent - headerLength];
+			vector[0].len = length - sent;
+			vectorCount = 1;
+		}
+
+		if(NULL != pClient->networkStack.writeVector) {
+			rc = pClient->networkStack.writeVector(&(pClient->networkStack), vector, vectorCount, pTimer, &sentLen);
+		} else {
+			/* Without a gathering write the segments go out one after the other */
+			rc = pClient->networkStack.write(&(pClient->networkStack), vector[0].pBuffer, vector[0].len, pTimer,
+											 &sentLen);
+		}
+		if(SUCCESS != rc) {
+			/* there was an error writing the data */
+			break;
+		}
+		sent += sentLen;
+	}
 
 	if(sent == length) {
-		/* record the fact that we have successfully sent the packet */
-		//countdown_sec(&c->pingTimer, c->clientData.keepAliveInterval);
+		aws_iot_mqtt_internal_restart_ping_timer(pClient);
+#ifdef AWS_IOT_MQTT_ENABLE_STATS
+		/* Only the fixed header is read, it gives the length of the whole packet */
+		aws_iot_mqtt_internal_stats_count_sent(pClient, pClient->clientData.writeBuf, length);
+#endif
 		FUNC_EXIT_RC(SUCCESS);
 	}
 
 	FUNC_EXIT_RC(rc)
 }
 
+/**
+ * @brief Fill the incoming data buffer until it holds at least the required number of bytes
+ *
+ * Reads everything the network layer has available, up to the free space in the buffer,
+ * so that the following packets of a burst are framed without further network reads.
+ *
+ * @param pClient MQTT client
+ * @param requiredLen Number of bytes the buffer must hold
+ * @param pTimer Amount of time allowed to read
+ *
+ * @return IoT_Error_t of read status
+ */
+static IoT_Error_t _aws_iot_mqtt_internal_read_ahead(AWS_IoT_Client *pClient, size_t requiredLen, Timer *pTimer) {
+	IoT_Error_t rc;
+	size_t byteRead;
+	size_t startIndex = pClient->clientData.readBufIndex;
+
+	do {
+		byteRead = 0;
+		rc = pClient->networkStack.readAvailable(&(pClient->networkStack),
+												 pClient->clientData.readBuf + pClient->clientData.readBufIndex,
+												 pClient->clientData.readBufSize - pClient->clientData.readBufIndex,
+												 pTimer, &byteRead);
+		if(SUCCESS == rc) {
+			pClient->clientData.readBufIndex += byteRead;
+		} else if(NETWORK_SSL_NOTHING_TO_READ != rc) {
+			return rc;
+		} else if(0 == startIndex) {
+			/* No packet has started, nothing to wait for */
+			return rc;
+		}
+	} while(pClient->clientData.readBufIndex < requiredLen && !has_timer_expired(pTimer));
+
+	if(pClient->clientData.readBufIndex >= requiredLen) {
+		return SUCCESS;
+	}
+
+	if(startIndex == pClient->clientData.readBufIndex) {
+		return NETWORK_SSL_NOTHING_TO_READ;
+	}
+
+	return NETWORK_SSL_READ_TIMEOUT_ERROR;
+}
+
 static IoT_Error_t _aws_iot_mqtt_internal_readWrapper( AWS_IoT_Client *pClient, size_t offset, size_t size, Timer *pTimer, size_t * read_len ) {
     IoT_Error_t rc;
     int byteToRead;
@@ -366,7 +569,15 @@ static IoT_Error_t _aws_iot_mqtt_internal_readWrapper( AWS_IoT_Client *pClient,
 
     byteToRead = ( offset + size ) - pClient->clientData.readBufIndex;
 
-    if ( byteToRead > 0 )
+    if ( byteToRead > 0 && NULL != pClient->networkStack.readAvailable )
+    {
+        rc = _aws_iot_mqtt_internal_read_ahead( pClient, offset + size, pTimer );
+
+        /* refresh byte to read */
+        byteToRead = ( offset + size ) - ((int)pClient->clientData.readBufIndex);
+        *read_len = ( byteToRead > 0 ) ? size - (size_t)byteToRead : size;
+    }
+    else if ( byteToRead > 0 )
     {
         rc = pClient->networkStack.read( &( pClient->networkStack ),
             pClient->clientData.readBuf + pClient->clientData.readBufIndex,
@@ -419,6 +630,31 @@ static IoT_Error_t _aws_iot_mqtt_internal_decode_packet_remaining_len(AWS_IoT_Cl
 	FUNC_EXIT_RC(rc);
 }
 
+/**
+ * @brief Remove the last complete packet from the start of the incoming data buffer
+ *
+ * @param pClient MQTT client
+ */
+static void _aws_iot_mqtt_internal_release_packet(AWS_IoT_Client *pClient) {
+	size_t packetLen = pClient->clientData.readBufPacketLen;
+
+	if(0 == packetLen) {
+		return;
+	}
+
+	if(pClient->clientData.readBufIndex > packetLen) {
+		memmove(pClient->clientData.readBuf, pClient->clientData.readBuf + packetLen,
+				pClient->clientData.readBufIndex - packetLen);
+		pClient->clientData.readBufIndex -= packetLen;
+	} else {
+		pClient->clientData.readBufIndex = 0;
+	}
+	pClient->clientData.readBufPacketLen = 0;
+}
+
+static IoT_Error_t _aws_iot_mqtt_internal_stream_publish(AWS_IoT_Client *pClient, Timer *pTimer, size_t offset,
+														 size_t rem_len);
+
 static IoT_Error_t _aws_iot_mqtt_internal_read_packet(AWS_IoT_Client *pClient, Timer *pTimer, uint8_t *pPacketType) {
 	size_t rem_len, total_bytes_read, bytes_to_be_read, read_len;
 	IoT_Error_t rc;
@@ -433,6 +669,9 @@ static IoT_Error_t _aws_iot_mqtt_internal_read_packet(AWS_IoT_Client *pClient, T
 	bytes_to_be_read = 0;
 	read_len = 0;
 
+	/* 0. drop the previous packet, keeping any bytes read ahead of it */
+	_aws_iot_mqtt_internal_release_packet(pClient);
+
     rc = _aws_iot_mqtt_internal_readWrapper( pClient, offset, 1, pTimer, &read_len );
 	/* 1. read the header byte.  This has the packet type in it */
 	if(NETWORK_SSL_NOTHING_TO_READ == rc) {
@@ -447,10 +686,33 @@ static IoT_Error_t _aws_iot_mqtt_internal_read_packet(AWS_IoT_Client *pClient, T
 		return rc;
 	}
 
-	/* if the buffer is too short then the message will be dropped silently */
+	/* if the buffer is too short then the message will be dropped silently,
+	 * unless it is a PUBLISH for a streaming subscription */
 	if((rem_len + offset) >= pClient->clientData.readBufSize) {
-		bytes_to_be_read = pClient->clientData.readBufSize;
-		do {
+		header.byte = pClient->clientData.readBuf[0];
+		if(PUBLISH == MQTT_HEADER_FIELD_TYPE(header.byte)) {
+			rc = _aws_iot_mqtt_internal_stream_publish(pClient, pTimer, offset, rem_len);
+			if(SUCCESS == rc) {
+#ifdef AWS_IOT_MQTT_ENABLE_STATS
+				aws_iot_mqtt_internal_stats_count_received(pClient, header.byte, offset + rem_len);
+#endif
+				/* The message has been delivered, there is no packet left to process */
+				return MQTT_NOTHING_TO_READ;
+			} else if(MQTT_RX_BUFFER_TOO_SHORT_ERROR != rc) {
+				return rc;
+			}
+		}
+
+		/* Everything read ahead past the header belongs to this message */
+		total_bytes_read = pClient->clientData.readBufIndex - offset;
+		pClient->clientData.readBufIndex = 0;
+		if((rem_len - total_bytes_read) >= pClient->clientData.readBufSize) {
+			bytes_to_be_read = pClient->clientData.readBufSize;
+		} else {
+			bytes_to_be_read = rem_len - total_bytes_read;
+		}
+		rc = SUCCESS;
+		while(total_bytes_read < rem_len && SUCCESS == rc) {
 			rc = pClient->networkStack.read(&(pClient->networkStack), pClient->clientData.readBuf, bytes_to_be_read,
 											pTimer, &read_len);
 			if(SUCCESS == rc) {
@@ -461,11 +723,15 @@ static IoT_Error_t _aws_iot_mqtt_internal_read_packet(AWS_IoT_Client *pClient, T
 					bytes_to_be_read = rem_len - total_bytes_read;
 				}
 			}
-		} while(total_bytes_read < rem_len && SUCCESS == rc);
+		}
 
         /* Check buffer was correctly emptied, otherwise, return error message. */
         if ( total_bytes_read == rem_len )
         {
+#ifdef AWS_IOT_MQTT_ENABLE_STATS
+            aws_iot_mqtt_internal_stats_count_received( pClient, header.byte, offset + rem_len );
+            pClient->clientData.stats.droppedMessages++;
+#endif
             aws_iot_mqtt_internal_flushBuffers( pClient );
             return MQTT_RX_BUFFER_TOO_SHORT_ERROR;
         }
@@ -483,106 +749,276 @@ static IoT_Error_t _aws_iot_mqtt_internal_read_packet(AWS_IoT_Client *pClient, T
 		}
 	}
 
-    /* Pack has been received, we can flush the buffers for next call. */
-    aws_iot_mqtt_internal_flushBuffers( pClient );
+	/* Packet has been received. It stays at the start of the buffer until the next
+	 * read so that it can be deserialized, bytes read ahead follow it */
+	pClient->clientData.readBufPacketLen = offset + rem_len;
 	header.byte = pClient->clientData.readBuf[0];
 	*pPacketType = MQTT_HEADER_FIELD_TYPE(header.byte);
+#ifdef AWS_IOT_MQTT_ENABLE_STATS
+	aws_iot_mqtt_internal_stats_count_received(pClient, header.byte, offset + rem_len);
+#endif
 
 	FUNC_EXIT_RC(rc);
 }
 
-// assume topic filter and name is in correct format
-// # can only be at end
-// + and # can only be next to separator
-static bool _aws_iot_mqtt_internal_is_topic_matched(char *pTopicFilter, char *pTopicName, uint16_t topicNameLen) {
+static IoT_Error_t _aws_iot_mqtt_internal_deliver_message(AWS_IoT_Client *pClient, char *pTopicName,
+														  uint16_t topicNameLen,
+														  IoT_Publish_Message_Params *pMessageParams) {
+	uint16_t matchedHandlers[AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS];
+	uint32_t matchedCount, itr;
+	MessageHandlers *pHandler;
+	IoT_Error_t rc;
+	ClientState clientState;
+#ifdef AWS_IOT_MQTT_ENABLE_STATS
+	uint32_t callbackStartUs;
+#endif
 
-	char *curf, *curn, *curn_end;
+	FUNC_ENTRY;
 
-	if(NULL == pTopicFilter || NULL == pTopicName) {
-		return false;
+	if(NULL == pTopicName) {
+		FUNC_EXIT_RC(NULL_VALUE_ERROR);
 	}
 
-	curf = pTopicFilter;
-	curn = pTopicName;
-	curn_end = curn + topicNameLen;
+	/* Find the right message handlers - indexed by topic */
+	matchedCount = aws_iot_mqtt_internal_topic_trie_match(pClient, pTopicName, topicNameLen, matchedHandlers);
 
-	while(*curf && (curn < curn_end)) {
-		if(*curn == '/' && *curf != '/') {
-			break;
-		}
-		if(*curf != '+' && *curf != '#' && *curf != *curn) {
-			break;
+	/* This function can be called from all MQTT APIs
+	 * But while callback return is in progress, Yield should not be called.
+	 * The state for CB_RETURN accomplishes that, as yield cannot be called while in that state */
+	clientState = aws_iot_mqtt_get_client_state(pClient);
+	aws_iot_mqtt_set_client_state(pClient, clientState, CLIENT_STATE_CONNECTED_WAIT_FOR_CB_RETURN);
+
+	for(itr = 0; itr < matchedCount; ++itr) {
+		pHandler = &(pClient->clientData.messageHandlers[matchedHandlers[itr]]);
+		/* A callback may have unsubscribed a handler that was matched */
+		if(NULL == pHandler->topicName) {
+			continue;
 		}
-		if(*curf == '+') {
-			/* skip until we meet the next separator, or end of string */
-			char *nextpos = curn + 1;
-			while(nextpos < curn_end && *nextpos != '/')
-				nextpos = ++curn + 1;
-		} else if(*curf == '#') {
-			/* skip until end of string */
-			curn = curn_end - 1;
+#ifdef AWS_IOT_MQTT_ENABLE_STATS
+		callbackStartUs = timer_now_us();
+#endif
+		if(NULL != pHandler->pApplicationHandler) {
+			pHandler->pApplicationHandler(pClient, pTopicName, topicNameLen, pMessageParams,
+										  pHandler->pApplicationHandlerData);
+		} else if(NULL != pHandler->pApplicationFragmentHandler) {
+			/* A message that fits in the buffer is a single fragment */
+			pHandler->pApplicationFragmentHandler(pClient, pTopicName, topicNameLen, pMessageParams, 0,
+												  pMessageParams->payloadLen, pHandler->pApplicationHandlerData);
 		}
+#ifdef AWS_IOT_MQTT_ENABLE_STATS
+		aws_iot_mqtt_internal_stats_record(&(pClient->clientData.stats.callbackTime), callbackStartUs);
+#endif
+	}
+	rc = aws_iot_mqtt_set_client_state(pClient, CLIENT_STATE_CONNECTED_WAIT_FOR_CB_RETURN, clientState);
 
-		curf++;
-		curn++;
-	};
+	FUNC_EXIT_RC(rc);
+}
 
-	return (curn == curn_end) && (*curf == '\0');
+/**
+ * @brief Send the acknowledgement of a received QoS 1 message
+ *
+ * Warns if the PUBACK isn't sent; the server will send the PUBLISH again in that case.
+ *
+ * @param pClient MQTT client
+ * @param packetId Packet identifier of the received message
+ */
+static void _aws_iot_mqtt_internal_send_puback(AWS_IoT_Client *pClient, uint16_t packetId) {
+	uint32_t len = 0;
+	IoT_Error_t rc;
+	Timer sendTimer;
+
+	/* Initialize timer for sending PUBACK. */
+	init_timer(&sendTimer);
+	countdown_ms(&sendTimer, pClient->clientData.commandTimeoutMs);
+
+	rc = aws_iot_mqtt_internal_lock_write_buffer(pClient);
+	if(SUCCESS != rc) {
+		IOT_WARN("Failed to send PUBACK");
+		return;
+	}
+
+	/* Generate and send a PUBACK. */
+	rc = aws_iot_mqtt_internal_serialize_ack(pClient->clientData.writeBuf,
+		pClient->clientData.writeBufSize, PUBACK, 0, packetId, &len);
+
+	if(SUCCESS == rc) {
+		rc = aws_iot_mqtt_internal_send_packet(pClient, len, &sendTimer);
+
+		if(SUCCESS != rc) {
+			IOT_WARN("Failed to send PUBACK");
+		}
+	} else {
+		IOT_WARN("Failed to generate PUBACK");
+	}
+
+	(void)aws_iot_mqtt_internal_unlock_write_buffer(pClient, rc);
 }
 
-static IoT_Error_t _aws_iot_mqtt_internal_deliver_message(AWS_IoT_Client *pClient, char *pTopicName,
-														  uint16_t topicNameLen,
-														  IoT_Publish_Message_Params *pMessageParams) {
-	uint32_t itr;
+/**
+ * @brief Stream a PUBLISH that does not fit in the incoming data buffer to the fragment handlers
+ *
+ * The fixed header has already been read. The variable header is read into the buffer and
+ * stays there while the payload is read into the space left after it, one fragment at a time.
+ *
+ * @param pClient MQTT client
+ * @param pTimer Amount of time allowed to read the message
+ * @param offset Length of the fixed header
+ * @param rem_len Remaining length of the message
+ *
+ * @return SUCCESS if the message was delivered, MQTT_RX_BUFFER_TOO_SHORT_ERROR if no streaming
+ *         subscription matches the topic or the variable header does not fit in the buffer,
+ *         NETWORK_SSL_READ_ERROR if reading the payload failed after the first fragments
+ */
+static IoT_Error_t _aws_iot_mqtt_internal_stream_publish(AWS_IoT_Client *pClient, Timer *pTimer, size_t offset,
+														 size_t rem_len) {
+	uint16_t matchedHandlers[AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS];
+	uint32_t matchedCount, itr;
+	uint16_t topicNameLen;
+	size_t read_len, headerLen, payloadOffset, payloadTotalLen, fragmentLen;
+	char *pTopicName;
+	unsigned char *curData;
+	bool isStreamed;
 	IoT_Error_t rc;
+	IoT_Publish_Message_Params msg;
 	ClientState clientState;
+	MQTTHeader header = {0};
+	MessageHandlers *pHandler;
+#ifdef AWS_IOT_MQTT_ENABLE_STATS
+	uint32_t callbackStartUs;
+#endif
 
 	FUNC_ENTRY;
 
-	if(NULL == pTopicName) {
-		FUNC_EXIT_RC(NULL_VALUE_ERROR);
+	if(2 > rem_len) {
+		FUNC_EXIT_RC(MQTT_RX_BUFFER_TOO_SHORT_ERROR);
 	}
 
-	/* This function can be called from all MQTT APIs
-	 * But while callback return is in progress, Yield should not be called.
-	 * The state for CB_RETURN accomplishes that, as yield cannot be called while in that state */
+	/* 1. read the topic name length */
+	rc = _aws_iot_mqtt_internal_readWrapper(pClient, offset, 2, pTimer, &read_len);
+	if(SUCCESS != rc) {
+		FUNC_EXIT_RC(rc);
+	} else if(2 != read_len) {
+		FUNC_EXIT_RC(FAILURE);
+	}
+
+	header.byte = pClient->clientData.readBuf[0];
+	msg.qos = (QoS) MQTT_HEADER_FIELD_QOS(header.byte);
+	msg.isRetained = MQTT_HEADER_FIELD_RETAIN(header.byte);
+	msg.isDup = MQTT_HEADER_FIELD_DUP(header.byte);
+	msg.id = 0;
+
+	curData = pClient->clientData.readBuf + offset;
+	topicNameLen = aws_iot_mqtt_internal_read_uint16_t(&curData);
+	headerLen = offset + 2 + topicNameLen;
+	if(QOS0 != msg.qos) {
+		headerLen += 2; /* packetId */
+	}
+
+	/* The variable header has to stay in the buffer with room left for the payload */
+	if(headerLen >= pClient->clientData.readBufSize || (headerLen - offset) > rem_len) {
+		FUNC_EXIT_RC(MQTT_RX_BUFFER_TOO_SHORT_ERROR);
+	}
+
+	/* 2. read the topic name and packet identifier */
+	rc = _aws_iot_mqtt_internal_readWrapper(pClient, offset + 2, headerLen - offset - 2, pTimer, &read_len);
+	if(SUCCESS != rc) {
+		FUNC_EXIT_RC(rc);
+	} else if((headerLen - offset - 2) != read_len) {
+		FUNC_EXIT_RC(FAILURE);
+	}
+
+	pTopicName = (char *) curData;
+	if(QOS0 != msg.qos) {
+		curData += topicNameLen;
+		msg.id = aws_iot_mqtt_internal_read_uint16_t(&curData);
+	}
+
+	isStreamed = false;
+	matchedCount = aws_iot_mqtt_internal_topic_trie_match(pClient, pTopicName, topicNameLen, matchedHandlers);
+	for(itr = 0; itr < matchedCount; ++itr) {
+		if(NULL != pClient->clientData.messageHandlers[matchedHandlers[itr]].pApplicationFragmentHandler) {
+			isStreamed = true;
+			break;
+		}
+	}
+
+	if(!isStreamed) {
+		FUNC_EXIT_RC(MQTT_RX_BUFFER_TOO_SHORT_ERROR);
+	}
+
+	/* 3. read and deliver the payload, one buffer at a time */
+	payloadTotalLen = rem_len - (headerLen - offset);
+	payloadOffset = 0;
+
 	clientState = aws_iot_mqtt_get_client_state(pClient);
 	aws_iot_mqtt_set_client_state(pClient, clientState, CLIENT_STATE_CONNECTED_WAIT_FOR_CB_RETURN);
 
-	/* Find the right message handler - indexed by topic */
-	for(itr = 0; itr < AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS; ++itr) {
-		if(NULL != pClient->clientData.messageHandlers[itr].topicName) {
-			if(((topicNameLen == pClient->clientData.messageHandlers[itr].topicNameLen)
-				&&
-				(strncmp(pTopicName, (char *) pClient->clientData.messageHandlers[itr].topicName, topicNameLen) == 0))
-			   || _aws_iot_mqtt_internal_is_topic_matched((char *) pClient->clientData.messageHandlers[itr].topicName,
-														  pTopicName, topicNameLen)) {
-				if(NULL != pClient->clientData.messageHandlers[itr].pApplicationHandler) {
-					pClient->clientData.messageHandlers[itr].pApplicationHandler(pClient, pTopicName, topicNameLen,
-																				 pMessageParams,
-																				 pClient->clientData.messageHandlers[itr].pApplicationHandlerData);
-				}
+	while(payloadOffset < payloadTotalLen) {
+		/* Bytes read ahead with the header are the first fragment */
+		if(pClient->clientData.readBufIndex <= headerLen) {
+			fragmentLen = pClient->clientData.readBufSize - headerLen;
+			if(fragmentLen > payloadTotalLen - payloadOffset) {
+				fragmentLen = payloadTotalLen - payloadOffset;
+			}
+
+			rc = pClient->networkStack.read(&(pClient->networkStack), pClient->clientData.readBuf + headerLen,
+											fragmentLen, pTimer, &read_len);
+			if(SUCCESS != rc) {
+				break;
+			}
+			pClient->clientData.readBufIndex = headerLen + read_len;
+		}
+
+		msg.payload = pClient->clientData.readBuf + headerLen;
+		msg.payloadLen = pClient->clientData.readBufIndex - headerLen;
+
+		for(itr = 0; itr < matchedCount; ++itr) {
+			pHandler = &(pClient->clientData.messageHandlers[matchedHandlers[itr]]);
+			if(NULL != pHandler->topicName && NULL != pHandler->pApplicationFragmentHandler) {
+#ifdef AWS_IOT_MQTT_ENABLE_STATS
+				callbackStartUs = timer_now_us();
+#endif
+				pHandler->pApplicationFragmentHandler(pClient, pTopicName, topicNameLen, &msg, payloadOffset,
+													  payloadTotalLen, pHandler->pApplicationHandlerData);
+#ifdef AWS_IOT_MQTT_ENABLE_STATS
+				aws_iot_mqtt_internal_stats_record(&(pClient->clientData.stats.callbackTime), callbackStartUs);
+#endif
 			}
 		}
+
+		payloadOffset += msg.payloadLen;
+		pClient->clientData.readBufIndex = headerLen;
 	}
-	rc = aws_iot_mqtt_set_client_state(pClient, CLIENT_STATE_CONNECTED_WAIT_FOR_CB_RETURN, clientState);
 
-	FUNC_EXIT_RC(rc);
+	aws_iot_mqtt_set_client_state(pClient, CLIENT_STATE_CONNECTED_WAIT_FOR_CB_RETURN, clientState);
+	aws_iot_mqtt_internal_flushBuffers(pClient);
+
+	if(SUCCESS != rc) {
+		/* The rest of the payload is still on the network, the next packet cannot be found.
+		 * Reported as a read error so that the connection is closed, and reconnected if enabled */
+		IOT_WARN("Streamed message cut short after %u of %u bytes, %d", (unsigned int) payloadOffset,
+				 (unsigned int) payloadTotalLen, rc);
+		FUNC_EXIT_RC(NETWORK_SSL_READ_ERROR);
+	}
+
+	/* Acknowledge once the whole message has been received */
+	if(QOS1 == msg.qos) {
+		_aws_iot_mqtt_internal_send_puback(pClient, msg.id);
+	}
+
+	FUNC_EXIT_RC(SUCCESS);
 }
 
 static IoT_Error_t _aws_iot_mqtt_internal_handle_publish(AWS_IoT_Client *pClient) {
 	char *topicName;
 	uint16_t topicNameLen;
-	uint32_t len;
 	IoT_Error_t rc;
 	IoT_Publish_Message_Params msg;
-	Timer sendTimer;
 
 	FUNC_ENTRY;
 
 	topicName = NULL;
 	topicNameLen = 0;
-	len = 0;
 
 	rc = aws_iot_mqtt_internal_deserialize_publish(&msg.isDup, &msg.qos, &msg.isRetained,
 												   &msg.id, &topicName, &topicNameLen,
@@ -596,31 +1032,44 @@ static IoT_Error_t _aws_iot_mqtt_internal_handle_publish(AWS_IoT_Client *pClient
 
 	/* Send acknowledgement of QoS 1 message. */
 	if(QOS1 == msg.qos) {
-		/* Initialize timer for sending PUBACK. */
-		init_timer(&sendTimer);
-		countdown_ms(&sendTimer, pClient->clientData.commandTimeoutMs);
+		_aws_iot_mqtt_internal_send_puback(pClient, msg.id);
+	}
+
+	rc = _aws_iot_mqtt_internal_deliver_message(pClient, topicName, topicNameLen, &msg);
+	if(SUCCESS != rc) {
+		FUNC_EXIT_RC(rc);
+	}
 
-		/* Generate and send a PUBACK. Warn if the PUBACK isn't sent; the server
-		will send the PUBLISH again in that case. */
-		rc = aws_iot_mqtt_internal_serialize_ack(pClient->clientData.writeBuf,
-			pClient->clientData.writeBufSize, PUBACK, 0, msg.id, &len);
+	FUNC_EXIT_RC(SUCCESS);
+}
 
-		if(SUCCESS == rc) {
-			rc = aws_iot_mqtt_internal_send_packet(pClient, len, &sendTimer);
+/**
+ * @brief Match a PUBACK against the asynchronous publishes awaiting acknowledgment
+ *
+ * @param pClient MQTT client
+ * @param pPacketType Packet type reported to the caller. Cleared if the PUBACK was consumed here,
+ *                    so that a blocking publish waiting on PUBACK does not take it for its own
+ *
+ * @return IoT_Error_t of PUBACK processing
+ */
+static IoT_Error_t _aws_iot_mqtt_internal_handle_puback(AWS_IoT_Client *pClient, uint8_t *pPacketType) {
+	uint16_t packetId;
+	unsigned char dup, type;
+	IoT_Error_t rc;
 
-			if(SUCCESS != rc) {
-				IOT_WARN("Failed to send PUBACK");
-			}
-		} else {
-			IOT_WARN("Failed to generate PUBACK");
-		}
-	}
+	FUNC_ENTRY;
 
-	rc = _aws_iot_mqtt_internal_deliver_message(pClient, topicName, topicNameLen, &msg);
+	rc = aws_iot_mqtt_internal_deserialize_ack(&type, &dup, &packetId, pClient->clientData.readBuf,
+											   pClient->clientData.readBufSize);
 	if(SUCCESS != rc) {
 		FUNC_EXIT_RC(rc);
 	}
 
+	/* No match means the PUBACK belongs to a blocking publish */
+	if(SUCCESS == aws_iot_mqtt_internal_complete_inflight_publish(pClient, packetId)) {
+		*pPacketType = (uint8_t) UNKNOWN;
+	}
+
 	FUNC_EXIT_RC(SUCCESS);
 }
 
@@ -668,13 +1117,23 @@ IoT_Error_t aws_iot_mqtt_internal_cycle_read(AWS_IoT_Client *pClient, Timer *pTi
 		return rc;
 	}
 
+	/* Traffic from the broker keeps the connection alive too, the idle time is not probed */
+	if(PINGRESP != *pPacketType) {
+		pClient->clientData.isIdleSincePingTimer = false;
+	}
+
 	switch(*pPacketType) {
 		case CONNACK:
-		case PUBACK:
 		case SUBACK:
 		case UNSUBACK:
 			/* SDK is blocking, these responses will be forwarded to calling function to process */
 			break;
+		case PUBACK: {
+			/* Complete the matching asynchronous publish, if any. Otherwise the
+			 * PUBACK is forwarded to the blocking publish waiting for it */
+			rc = _aws_iot_mqtt_internal_handle_puback(pClient, pPacketType);
+			break;
+		}
 		case PUBLISH: {
 			rc = _aws_iot_mqtt_internal_handle_publish(pClient);
 			break;
@@ -686,6 +1145,15 @@ IoT_Error_t aws_iot_mqtt_internal_cycle_read(AWS_IoT_Client *pClient, Timer *pTi
 		case PINGRESP: {
 			/* There is no outstanding ping request anymore. */
 			pClient->clientStatus.isPingOutstanding = false;
+			if(0 != pClient->clientData.pingProbeSec) {
+				/* The connection survived the probed idle time, try twice as long from now on */
+				pClient->clientData.pingIntervalConfirmedSec = pClient->clientData.pingProbeSec;
+				pClient->clientData.pingIntervalSec =
+						(pClient->clientData.keepAliveInterval / 2 < pClient->clientData.pingProbeSec) ?
+						pClient->clientData.keepAliveInterval : (uint16_t) (pClient->clientData.pingProbeSec * 2);
+				pClient->clientData.pingProbeSec = 0;
+				aws_iot_mqtt_internal_restart_ping_timer(pClient);
+			}
 			break;
 		}
 		default: {
@@ -708,9 +1176,121 @@ IoT_Error_t aws_iot_mqtt_internal_cycle_read(AWS_IoT_Client *pClient, Timer *pTi
  */
 IoT_Error_t aws_iot_mqtt_internal_flushBuffers( AWS_IoT_Client *pClient ) {
     pClient->clientData.readBufIndex = 0;
+    pClient->clientData.readBufPacketLen = 0;
     return SUCCESS;
 }
 
+/**
+ * @brief Read the data already received into the incoming data buffer, without waiting
+ *
+ * The last packet processed is dropped first. Reading stops as soon as the network layer
+ * has nothing more to give or the buffer is full.
+ *
+ * @param pClient MQTT client
+ * @param pIsBufferFull Output parameter, true if reading stopped because the buffer is full
+ *
+ * @return IoT_Error_t of read status, SUCCESS if there was nothing to read
+ */
+IoT_Error_t aws_iot_mqtt_internal_read_available(AWS_IoT_Client *pClient, bool *pIsBufferFull) {
+	IoT_Error_t rc = SUCCESS;
+	size_t byteRead;
+	Timer timer;
+
+#ifdef _ENABLE_THREAD_SUPPORT_
+	IoT_Error_t threadRc;
+#endif
+
+	FUNC_ENTRY;
+
+	if(NULL == pClient || NULL == pIsBufferFull) {
+		FUNC_EXIT_RC(NULL_VALUE_ERROR);
+	}
+
+	*pIsBufferFull = false;
+	if(NULL == pClient->networkStack.readAvailable) {
+		FUNC_EXIT_RC(SUCCESS);
+	}
+
+#ifdef _ENABLE_THREAD_SUPPORT_
+	threadRc = aws_iot_mqtt_client_lock_mutex(pClient, &(pClient->clientData.tls_read_mutex));
+	if(SUCCESS != threadRc) {
+		FUNC_EXIT_RC(threadRc);
+	}
+#endif
+
+	/* An expired timer, the network layer only returns what it has already received */
+	init_timer(&timer);
+	_aws_iot_mqtt_internal_release_packet(pClient);
+
+	while(pClient->clientData.readBufIndex < pClient->clientData.readBufSize) {
+		byteRead = 0;
+		rc = pClient->networkStack.readAvailable(&(pClient->networkStack),
+												 pClient->clientData.readBuf + pClient->clientData.readBufIndex,
+												 pClient->clientData.readBufSize - pClient->clientData.readBufIndex,
+												 &timer, &byteRead);
+		if(SUCCESS != rc || 0 == byteRead) {
+			break;
+		}
+		pClient->clientData.readBufIndex += byteRead;
+	}
+
+	if(NETWORK_SSL_NOTHING_TO_READ == rc) {
+		rc = SUCCESS;
+	} else if(SUCCESS == rc) {
+		*pIsBufferFull = (pClient->clientData.readBufIndex >= pClient->clientData.readBufSize);
+	}
+
+#ifdef _ENABLE_THREAD_SUPPORT_
+	threadRc = aws_iot_mqtt_client_unlock_mutex(pClient, &(pClient->clientData.tls_read_mutex));
+	if(SUCCESS != threadRc && SUCCESS == rc) {
+		rc = threadRc;
+	}
+#endif
+
+	FUNC_EXIT_RC(rc);
+}
+
+/**
+ * @brief Check whether the next packet can be read without waiting on the network
+ *
+ * A packet is ready when all of it is in the incoming data buffer, or when its header
+ * shows that it is larger than the buffer, in which case the packet reader takes the
+ * rest from the network.
+ *
+ * @param pClient MQTT client
+ *
+ * @return true if the next packet is ready
+ */
+bool aws_iot_mqtt_internal_is_packet_buffered(AWS_IoT_Client *pClient) {
+	unsigned char *pPacket;
+	size_t available, len, remLen, multiplier;
+
+	if(NULL == pClient || pClient->clientData.readBufIndex <= pClient->clientData.readBufPacketLen) {
+		return false;
+	}
+
+	/* The packet processed last is still at the start of the buffer */
+	pPacket = pClient->clientData.readBuf + pClient->clientData.readBufPacketLen;
+	available = pClient->clientData.readBufIndex - pClient->clientData.readBufPacketLen;
+
+	len = 1;
+	remLen = 0;
+	multiplier = 1;
+	do {
+		if(len > MAX_NO_OF_REMAINING_LENGTH_BYTES) {
+			/* Malformed, let the packet reader report it */
+			return true;
+		}
+		if(len >= available) {
+			return false;
+		}
+		remLen += (pPacket[len] & 127) * multiplier;
+		multiplier *= 128;
+	} while(0 != (pPacket[len++] & 128));
+
+	return ((len + remLen) <= available) || ((len + remLen) >= pClient->clientData.readBufSize);
+}
+
 /**
  * @brief Wait until a packet is read from the network
  *
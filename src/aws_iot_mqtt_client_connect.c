@@ -78,13 +78,13 @@ typedef union {
 #if defined(REVERSED)
 	struct
 	{
-		unsigned int sessionpresent : 1;	/**< session present flag */
 		unsigned int : 7;					/**< unused */
+		unsigned int sessionpresent : 1;	/**< session present flag */
 	} bits; /**< connect flags byte (reverse order) */
 #else
 	struct {
-		unsigned int : 7; /**< unused */
 		unsigned int sessionpresent : 1; /**< session present flag */
+		unsigned int : 7; /**< unused */
 	} bits; /**< connect flags byte (normal order) */
 #endif
 } MQTT_Connack_Header_Flags;
@@ -400,16 +400,26 @@ static IoT_Error_t _aws_iot_mqtt_internal_connect(AWS_IoT_Client *pClient, IoT_C
 	init_timer(&connect_timer);
 	countdown_ms(&connect_timer, pClient->clientData.commandTimeoutMs);
 
-	pClient->clientData.keepAliveInterval = pClient->clientData.options.keepAliveIntervalInSec;
+	aws_iot_mqtt_internal_keep_alive_init(pClient);
+	rc = aws_iot_mqtt_internal_lock_write_buffer(pClient);
+	if(SUCCESS != rc) {
+		FUNC_EXIT_RC(rc);
+	}
+
+#ifdef AWS_IOT_MQTT_OUTBOUND_QUEUE_SLOTS
+	/* Packets queued for the previous connection */
+	aws_iot_mqtt_internal_outbound_queue_discard(pClient);
+#endif
+
 	rc = _aws_iot_mqtt_serialize_connect(pClient->clientData.writeBuf, pClient->clientData.writeBufSize,
 										 &(pClient->clientData.options), &len);
-	if(SUCCESS != rc || 0 >= len) {
-		FUNC_EXIT_RC(rc);
+	if(SUCCESS == rc && 0 < len) {
+		/* send the connect packet */
+		rc = aws_iot_mqtt_internal_send_packet(pClient, len, &connect_timer);
 	}
 
-	/* send the connect packet */
-	rc = aws_iot_mqtt_internal_send_packet(pClient, len, &connect_timer);
-	if(SUCCESS != rc) {
+	rc = aws_iot_mqtt_internal_unlock_write_buffer(pClient, rc);
+	if(SUCCESS != rc || 0 >= len) {
 		FUNC_EXIT_RC(rc);
 	}
 
@@ -430,9 +440,19 @@ static IoT_Error_t _aws_iot_mqtt_internal_connect(AWS_IoT_Client *pClient, IoT_C
 		FUNC_EXIT_RC(connack_rc);
 	}
 
+	/* The broker kept the subscriptions and the QoS1 messages of a persistent session */
+	pClient->clientStatus.isSessionPresent = (0 != sessionPresent);
+
+#ifdef AWS_IOT_MQTT_INFLIGHT_PACKET_LEN
+	rc = aws_iot_mqtt_internal_resend_inflight_publishes(pClient, &connect_timer);
+	if(SUCCESS != rc) {
+		FUNC_EXIT_RC(rc);
+	}
+#endif
+
 	/* Ensure that a ping request is sent after keepAliveInterval. */
 	pClient->clientStatus.isPingOutstanding = false;
-	countdown_sec(&pClient->pingReqTimer, pClient->clientData.keepAliveInterval);
+	aws_iot_mqtt_internal_restart_ping_timer(pClient);
 
 	FUNC_EXIT_RC(SUCCESS);
 }
@@ -503,11 +523,16 @@ static IoT_Error_t _aws_iot_mqtt_internal_disconnect(AWS_IoT_Client *pClient) {
 
 	FUNC_ENTRY;
 
+	rc = aws_iot_mqtt_internal_lock_write_buffer(pClient);
+	if(SUCCESS != rc) {
+		FUNC_EXIT_RC(rc);
+	}
+
 	rc = aws_iot_mqtt_internal_serialize_zero(pClient->clientData.writeBuf, pClient->clientData.writeBufSize,
 											  DISCONNECT,
 											  &serialized_len);
 	if(SUCCESS != rc) {
-		FUNC_EXIT_RC(rc);
+		FUNC_EXIT_RC(aws_iot_mqtt_internal_unlock_write_buffer(pClient, rc));
 	}
 
 	init_timer(&timer);
@@ -517,10 +542,15 @@ static IoT_Error_t _aws_iot_mqtt_internal_disconnect(AWS_IoT_Client *pClient) {
 	if(serialized_len > 0) {
 		(void)aws_iot_mqtt_internal_send_packet(pClient, serialized_len, &timer);
 	}
+	(void)aws_iot_mqtt_internal_unlock_write_buffer(pClient, SUCCESS);
 
 	/* Clean network stack */
 	pClient->networkStack.disconnect(&(pClient->networkStack));
 	rc = pClient->networkStack.destroy(&(pClient->networkStack));
+
+	/* PUBACKs can no longer arrive for messages published on this connection */
+	aws_iot_mqtt_internal_abort_inflight_publishes(pClient, NETWORK_DISCONNECTED_ERROR);
+
 	if(SUCCESS != rc) {
 		/* TLS Destroy failed, return error */
 		FUNC_EXIT_RC(FAILURE);
@@ -615,8 +645,14 @@ IoT_Error_t aws_iot_mqtt_attempt_reconnect(AWS_IoT_Client *pClient) {
 		}
 	}
 
+	/* Subscriptions are still in place on the broker */
+	if(pClient->clientStatus.isSessionPresent) {
+		FUNC_EXIT_RC(NETWORK_RECONNECTED);
+	}
+
+	/* Topics refused by the broker were removed, the connection itself is usable */
 	rc = aws_iot_mqtt_resubscribe(pClient);
-	if(SUCCESS != rc) {
+	if(SUCCESS != rc && MQTT_SUBSCRIBE_REJECTED_ERROR != rc) {
 		FUNC_EXIT_RC(NETWORK_ATTEMPTING_RECONNECT);
 	}
 
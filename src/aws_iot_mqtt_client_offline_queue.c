@@ -0,0 +1,797 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file aws_iot_mqtt_client_offline_queue.c
+ * @brief MQTT client offline queue
+ *
+ * Messages published while the client waits to reconnect are appended to a ring of
+ * records in a persistent region provided by the platform, a memory mapped file on Linux.
+ * A record and then the header pointing past it are written to storage before the publish
+ * returns, so the queue survives a crash or a power loss. Once the client is connected
+ * again, the queue is drained a few messages at a time from yield. A QoS1 message is only
+ * removed once its PUBACK is received, it is sent again if the publish times out or the
+ * connection is lost first.
+ * Only built when AWS_IOT_MQTT_ENABLE_OFFLINE_QUEUE is defined in aws_iot_config.h.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <string.h>
+
+#include "aws_iot_mqtt_client_common_internal.h"
+
+#ifdef AWS_IOT_MQTT_ENABLE_OFFLINE_QUEUE
+
+/** Marks a region holding an offline queue, "AWSQ" */
+#define OFFLINE_QUEUE_MAGIC 0x51535741
+/** Value of the qos field of a record that only fills the end of the ring */
+#define OFFLINE_RECORD_PADDING 0xFF
+/** Records are aligned on 4 bytes */
+#define OFFLINE_RECORD_ALIGN(len) (((len) + 3) & ~((uint32_t) 3))
+
+/**
+ * @brief Header at the start of the region
+ */
+typedef struct {
+	uint32_t magic; ///< OFFLINE_QUEUE_MAGIC
+	uint32_t dataSize; ///< Size of the ring of records that follows the header
+	uint32_t head; ///< Offset of the oldest record in the ring
+	uint32_t used; ///< Number of bytes of the ring holding records, from head
+} OfflineQueueHeader;
+
+/**
+ * @brief Header of a record, followed by the topic and the payload
+ *
+ * A record never wraps around the end of the ring. The end is filled with a padding
+ * record instead, or skipped if it is shorter than a record header.
+ */
+typedef struct {
+	uint32_t length; ///< Length of the record including this header, aligned on 4 bytes
+	uint32_t checksum; ///< FNV-1a of the record from payloadLen to the end of the payload
+	uint32_t payloadLen; ///< Length of the payload
+	uint16_t topicLen; ///< Length of the topic
+	uint8_t qos; ///< QoS of the message, OFFLINE_RECORD_PADDING for padding
+	uint8_t isRetained; ///< Retained flag of the message
+} OfflineRecordHeader;
+
+/** Offset of the checksummed part of a record */
+#define OFFLINE_RECORD_CHECKSUM_START (offsetof(OfflineRecordHeader, payloadLen))
+
+static OfflineQueueHeader *_aws_iot_mqtt_offline_queue_header(OfflineQueue *pQueue) {
+	return (OfflineQueueHeader *) pQueue->pRegion;
+}
+
+static OfflineRecordHeader *_aws_iot_mqtt_offline_queue_record(OfflineQueue *pQueue, uint32_t offset) {
+	return (OfflineRecordHeader *) (pQueue->pRegion + sizeof(OfflineQueueHeader) + offset);
+}
+
+/**
+ * @brief Lock the offline queue
+ *
+ * @param pQueue Offline queue
+ */
+static void _aws_iot_mqtt_offline_queue_lock(OfflineQueue *pQueue) {
+#ifdef _ENABLE_THREAD_SUPPORT_
+	(void)aws_iot_thread_mutex_lock(&(pQueue->lock));
+#else
+	IOT_UNUSED(pQueue);
+#endif
+}
+
+/**
+ * @brief Unlock the offline queue
+ *
+ * @param pQueue Offline queue
+ */
+static void _aws_iot_mqtt_offline_queue_unlock(OfflineQueue *pQueue) {
+#ifdef _ENABLE_THREAD_SUPPORT_
+	(void)aws_iot_thread_mutex_unlock(&(pQueue->lock));
+#else
+	IOT_UNUSED(pQueue);
+#endif
+}
+
+/**
+ * @brief Checksum of the part of a record following its length and checksum fields
+ *
+ * @param pRecord Record header, followed by the topic and the payload
+ * @param len Length of the record before alignment
+ *
+ * @return FNV-1a hash of the bytes
+ */
+static uint32_t _aws_iot_mqtt_offline_record_checksum(OfflineRecordHeader *pRecord, uint32_t len) {
+	const unsigned char *pByte = (const unsigned char *) pRecord + OFFLINE_RECORD_CHECKSUM_START;
+	const unsigned char *pEnd = (const unsigned char *) pRecord + len;
+	uint32_t hash = 2166136261u;
+
+	while(pByte < pEnd) {
+		hash = (hash ^ *pByte++) * 16777619u;
+	}
+
+	return hash;
+}
+
+/**
+ * @brief Write part of the region to storage
+ *
+ * @param pQueue Offline queue
+ * @param pStart First byte to store, within the region
+ * @param len Number of bytes to store
+ *
+ * @return IoT_Error_t of the platform
+ */
+static IoT_Error_t _aws_iot_mqtt_offline_queue_sync(OfflineQueue *pQueue, void *pStart, size_t len) {
+	return aws_iot_offline_store_sync(&(pQueue->store), (size_t) ((unsigned char *) pStart - pQueue->pRegion), len);
+}
+
+/**
+ * @brief Skip the padding at the end of the ring, if the next record starts at offset 0
+ *
+ * @param pQueue Offline queue
+ */
+static void _aws_iot_mqtt_offline_queue_skip_padding(OfflineQueue *pQueue) {
+	OfflineQueueHeader *pHeader = _aws_iot_mqtt_offline_queue_header(pQueue);
+	uint32_t toEnd = pQueue->dataSize - pHeader->head;
+
+	if(0 < pHeader->used && (sizeof(OfflineRecordHeader) > toEnd
+							 || OFFLINE_RECORD_PADDING == _aws_iot_mqtt_offline_queue_record(pQueue, pHeader->head)->qos)) {
+		pHeader->head = 0;
+		pHeader->used -= toEnd;
+	}
+	if(0 == pHeader->used) {
+		pHeader->head = 0;
+	}
+}
+
+/**
+ * @brief Check the record at an offset of the ring
+ *
+ * @param pQueue Offline queue
+ * @param offset Offset of the record
+ * @param available Number of bytes from the offset that belong to the queue
+ *
+ * @return true if the record is complete and its checksum matches
+ */
+static bool _aws_iot_mqtt_offline_record_is_valid(OfflineQueue *pQueue, uint32_t offset, uint32_t available) {
+	OfflineRecordHeader *pRecord;
+	uint32_t len;
+
+	if(sizeof(OfflineRecordHeader) > available || sizeof(OfflineRecordHeader) > pQueue->dataSize - offset) {
+		return false;
+	}
+
+	pRecord = _aws_iot_mqtt_offline_queue_record(pQueue, offset);
+	if(OFFLINE_RECORD_PADDING == pRecord->qos) {
+		return (pRecord->length == pQueue->dataSize - offset && pRecord->length <= available);
+	}
+
+	len = (uint32_t) sizeof(OfflineRecordHeader) + pRecord->topicLen;
+	if(QOS1 < pRecord->qos || pRecord->payloadLen > pQueue->dataSize - len) {
+		return false;
+	}
+	len += pRecord->payloadLen;
+
+	return (OFFLINE_RECORD_ALIGN(len) == pRecord->length && pRecord->length <= available
+			&& pRecord->length <= pQueue->dataSize - offset
+			&& _aws_iot_mqtt_offline_record_checksum(pRecord, len) == pRecord->checksum);
+}
+
+/**
+ * @brief Recover the queue left in the region by a previous run
+ *
+ * An unknown header resets the queue. Records are kept up to the first one that is not
+ * complete, which can only be found if the storage lost part of a write.
+ *
+ * @param pQueue Offline queue
+ *
+ * @return IoT_Error_t of the platform
+ */
+static IoT_Error_t _aws_iot_mqtt_offline_queue_recover(OfflineQueue *pQueue) {
+	OfflineQueueHeader *pHeader = _aws_iot_mqtt_offline_queue_header(pQueue);
+	uint32_t offset, walked = 0, toEnd, recordLen;
+
+	FUNC_ENTRY;
+
+	if(OFFLINE_QUEUE_MAGIC != pHeader->magic || pQueue->dataSize != pHeader->dataSize
+	   || pHeader->head >= pQueue->dataSize || 0 != (pHeader->head & 3)
+	   || pHeader->used > pQueue->dataSize || 0 != (pHeader->used & 3)) {
+		pHeader->magic = OFFLINE_QUEUE_MAGIC;
+		pHeader->dataSize = pQueue->dataSize;
+		pHeader->head = 0;
+		pHeader->used = 0;
+		FUNC_EXIT_RC(_aws_iot_mqtt_offline_queue_sync(pQueue, pHeader, sizeof(OfflineQueueHeader)));
+	}
+
+	pQueue->messageCount = 0;
+	offset = pHeader->head;
+	while(walked < pHeader->used) {
+		toEnd = pQueue->dataSize - offset;
+		if(sizeof(OfflineRecordHeader) > toEnd && toEnd < pHeader->used - walked) {
+			recordLen = toEnd;
+		} else if(_aws_iot_mqtt_offline_record_is_valid(pQueue, offset, pHeader->used - walked)) {
+			recordLen = _aws_iot_mqtt_offline_queue_record(pQueue, offset)->length;
+			if(OFFLINE_RECORD_PADDING != _aws_iot_mqtt_offline_queue_record(pQueue, offset)->qos) {
+				pQueue->messageCount++;
+			}
+		} else {
+			IOT_WARN("Offline queue truncated at a damaged record, %u bytes dropped",
+					 (unsigned int) (pHeader->used - walked));
+			break;
+		}
+		walked += recordLen;
+		offset = (offset + recordLen) % pQueue->dataSize;
+	}
+
+	if(walked != pHeader->used) {
+		pHeader->used = walked;
+		FUNC_EXIT_RC(_aws_iot_mqtt_offline_queue_sync(pQueue, pHeader, sizeof(OfflineQueueHeader)));
+	}
+
+	FUNC_EXIT_RC(SUCCESS);
+}
+
+/**
+ * @brief Find the in-flight slot of a sent QoS1 record
+ *
+ * @param pQueue Offline queue
+ * @param offset Offset of the record
+ *
+ * @return The slot, NULL if the record has none
+ */
+static OfflineInflightRecord *_aws_iot_mqtt_offline_queue_find_inflight(OfflineQueue *pQueue, uint32_t offset) {
+	uint32_t itr;
+
+	for(itr = 0; itr < AWS_IOT_MQTT_MAX_INFLIGHT_PUBLISHES; itr++) {
+		if(pQueue->inflight[itr].isUsed && offset == pQueue->inflight[itr].offset) {
+			return &(pQueue->inflight[itr]);
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief Remove the oldest message
+ *
+ * The caller stores the header.
+ *
+ * @param pQueue Offline queue, not empty
+ */
+static void _aws_iot_mqtt_offline_queue_pop(OfflineQueue *pQueue) {
+	OfflineQueueHeader *pHeader = _aws_iot_mqtt_offline_queue_header(pQueue);
+	OfflineInflightRecord *pInflight = _aws_iot_mqtt_offline_queue_find_inflight(pQueue, pHeader->head);
+	uint32_t length = _aws_iot_mqtt_offline_queue_record(pQueue, pHeader->head)->length;
+	uint32_t usedBefore = pHeader->used;
+
+	if(NULL != pInflight) {
+		pInflight->isUsed = false;
+	}
+
+	pHeader->head = (pHeader->head + length) % pQueue->dataSize;
+	pHeader->used -= length;
+	pQueue->messageCount--;
+	_aws_iot_mqtt_offline_queue_skip_padding(pQueue);
+
+	/* The sent messages start at the head, the padding skipped with the record is part of them */
+	if(0 < pQueue->sentCount) {
+		pQueue->sentCount--;
+		pQueue->sentLen = (0 == pQueue->sentCount) ? 0 : pQueue->sentLen - (usedBefore - pHeader->used);
+	}
+}
+
+/**
+ * @brief Whether the oldest message has been sent and needs nothing more
+ *
+ * @param pQueue Offline queue
+ *
+ * @return true for a sent QoS0 message or an acknowledged QoS1 message
+ */
+static bool _aws_iot_mqtt_offline_queue_is_head_done(OfflineQueue *pQueue) {
+	OfflineQueueHeader *pHeader = _aws_iot_mqtt_offline_queue_header(pQueue);
+	OfflineInflightRecord *pInflight;
+
+	if(0 == pQueue->sentCount || (pQueue->isSending && pHeader->head == pQueue->sendingOffset)) {
+		return false;
+	}
+	if(QOS0 == _aws_iot_mqtt_offline_queue_record(pQueue, pHeader->head)->qos) {
+		return true;
+	}
+
+	pInflight = _aws_iot_mqtt_offline_queue_find_inflight(pQueue, pHeader->head);
+	return (NULL == pInflight || pInflight->isAcked);
+}
+
+/**
+ * @brief Remove the oldest messages as long as they are done
+ *
+ * A message acknowledged out of order stays until the ones before it are done.
+ *
+ * @param pQueue Offline queue
+ *
+ * @return Number of messages removed, the caller stores the header if not 0
+ */
+static uint32_t _aws_iot_mqtt_offline_queue_pop_done(OfflineQueue *pQueue) {
+	uint32_t popped = 0;
+
+	while(_aws_iot_mqtt_offline_queue_is_head_done(pQueue)) {
+		_aws_iot_mqtt_offline_queue_pop(pQueue);
+		popped++;
+	}
+
+	return popped;
+}
+
+/**
+ * @brief Whether the oldest message can be dropped to make room
+ *
+ * @param pQueue Offline queue, not empty
+ *
+ * @return false if it is being sent or waits for its PUBACK
+ */
+static bool _aws_iot_mqtt_offline_queue_can_drop_head(OfflineQueue *pQueue) {
+	OfflineQueueHeader *pHeader = _aws_iot_mqtt_offline_queue_header(pQueue);
+	OfflineInflightRecord *pInflight = _aws_iot_mqtt_offline_queue_find_inflight(pQueue, pHeader->head);
+
+	if(pQueue->isSending && pHeader->head == pQueue->sendingOffset) {
+		return false;
+	}
+
+	return (NULL == pInflight || !pInflight->isPending);
+}
+
+/**
+ * @brief Whether the drain has messages to send
+ *
+ * @param pQueue Offline queue
+ *
+ * @return true if a message was never sent, or its publish failed and it is sent again
+ */
+static bool _aws_iot_mqtt_offline_queue_has_unsent(OfflineQueue *pQueue) {
+	uint32_t itr;
+
+	if(pQueue->sentCount < pQueue->messageCount) {
+		return true;
+	}
+	for(itr = 0; itr < AWS_IOT_MQTT_MAX_INFLIGHT_PUBLISHES; itr++) {
+		if(pQueue->inflight[itr].isUsed && !pQueue->inflight[itr].isPending && !pQueue->inflight[itr].isAcked) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/**
+ * @brief Initialize the offline queue of a client
+ *
+ * Opens the persistent region named in the init parameters and recovers the messages it
+ * holds. The queue is left disabled if no region is named.
+ *
+ * @param pClient MQTT client
+ * @param pInitParams Initialization parameters of the client
+ *
+ * @return IoT_Error_t of the platform
+ */
+IoT_Error_t aws_iot_mqtt_internal_offline_queue_init(AWS_IoT_Client *pClient, IoT_Client_Init_Params *pInitParams) {
+	OfflineQueue *pQueue = &(pClient->clientData.offlineQueue);
+	IoT_Error_t rc;
+
+	FUNC_ENTRY;
+
+	pQueue->isOpen = false;
+	pQueue->messageCount = 0;
+	pQueue->sentLen = 0;
+	pQueue->sentCount = 0;
+	pQueue->isSending = false;
+	memset(pQueue->inflight, 0, sizeof(pQueue->inflight));
+	pQueue->dropPolicy = pInitParams->offlineQueueDropPolicy;
+	init_timer(&(pQueue->drainTimer));
+
+	if(NULL == pInitParams->pOfflineQueuePath) {
+		FUNC_EXIT_RC(SUCCESS);
+	}
+
+	if(sizeof(OfflineQueueHeader) + sizeof(OfflineRecordHeader) > pInitParams->offlineQueueSize
+	   || UINT32_MAX < pInitParams->offlineQueueSize) {
+		FUNC_EXIT_RC(MAX_SIZE_ERROR);
+	}
+	pQueue->dataSize = (uint32_t) (pInitParams->offlineQueueSize - sizeof(OfflineQueueHeader)) & ~((uint32_t) 3);
+
+	rc = aws_iot_offline_store_open(&(pQueue->store), pInitParams->pOfflineQueuePath,
+									pInitParams->offlineQueueSize, &(pQueue->pRegion));
+	if(SUCCESS != rc) {
+		FUNC_EXIT_RC(rc);
+	}
+
+	rc = _aws_iot_mqtt_offline_queue_recover(pQueue);
+	if(SUCCESS != rc) {
+		(void)aws_iot_offline_store_close(&(pQueue->store));
+		FUNC_EXIT_RC(rc);
+	}
+
+#ifdef _ENABLE_THREAD_SUPPORT_
+	rc = aws_iot_thread_mutex_init(&(pQueue->lock));
+	if(SUCCESS != rc) {
+		(void)aws_iot_offline_store_close(&(pQueue->store));
+		FUNC_EXIT_RC(rc);
+	}
+#endif
+
+	pQueue->isOpen = true;
+	IOT_DEBUG("Offline queue opened with %u messages", (unsigned int) pQueue->messageCount);
+
+	FUNC_EXIT_RC(SUCCESS);
+}
+
+/**
+ * @brief Close the offline queue of a client, the queued messages stay in storage
+ *
+ * @param pClient MQTT client
+ *
+ * @return IoT_Error_t of the platform
+ */
+IoT_Error_t aws_iot_mqtt_internal_offline_queue_free(AWS_IoT_Client *pClient) {
+	OfflineQueue *pQueue = &(pClient->clientData.offlineQueue);
+
+	if(!pQueue->isOpen) {
+		return SUCCESS;
+	}
+
+	pQueue->isOpen = false;
+#ifdef _ENABLE_THREAD_SUPPORT_
+	(void)aws_iot_thread_mutex_destroy(&(pQueue->lock));
+#endif
+
+	return aws_iot_offline_store_close(&(pQueue->store));
+}
+
+/**
+ * @brief Queue a message published while the client is not connected
+ *
+ * Only used while the client waits to reconnect. When the queue is full, the drop policy
+ * decides whether the oldest messages or the new one are given up.
+ *
+ * @param pClient MQTT client
+ * @param pTopicName Topic Name to publish to
+ * @param topicNameLen Length of the topic name
+ * @param pParams Pointer to Publish Message parameters
+ *
+ * @return MQTT_PUBLISH_QUEUED_OFFLINE if the message is stored,
+ *         NETWORK_DISCONNECTED_ERROR if the client does not reconnect or has no queue
+ */
+IoT_Error_t aws_iot_mqtt_internal_offline_queue_append(AWS_IoT_Client *pClient, const char *pTopicName,
+													   uint16_t topicNameLen, IoT_Publish_Message_Params *pParams) {
+	OfflineQueue *pQueue = &(pClient->clientData.offlineQueue);
+	OfflineQueueHeader *pHeader;
+	OfflineRecordHeader *pRecord;
+	ClientState clientState;
+	uint32_t len, recordLen, tailOffset, toEnd, skipLen;
+	IoT_Error_t rc;
+
+	FUNC_ENTRY;
+
+	clientState = aws_iot_mqtt_get_client_state(pClient);
+	if(!pQueue->isOpen || (CLIENT_STATE_PENDING_RECONNECT != clientState
+						   && (CLIENT_STATE_DISCONNECTED_ERROR != clientState
+							   || !pClient->clientStatus.isAutoReconnectEnabled))) {
+		FUNC_EXIT_RC(NETWORK_DISCONNECTED_ERROR);
+	}
+
+	if(NULL == pParams->payload && 0 < pParams->payloadLen) {
+		FUNC_EXIT_RC(NULL_VALUE_ERROR);
+	}
+
+	len = (uint32_t) sizeof(OfflineRecordHeader) + topicNameLen;
+	if(pParams->payloadLen > pQueue->dataSize - len) {
+		FUNC_EXIT_RC(MQTT_OFFLINE_QUEUE_FULL_ERROR);
+	}
+	len += (uint32_t) pParams->payloadLen;
+	recordLen = OFFLINE_RECORD_ALIGN(len);
+	if(recordLen > pQueue->dataSize) {
+		FUNC_EXIT_RC(MQTT_OFFLINE_QUEUE_FULL_ERROR);
+	}
+
+	_aws_iot_mqtt_offline_queue_lock(pQueue);
+	pHeader = _aws_iot_mqtt_offline_queue_header(pQueue);
+
+	/* A record that does not fit before the end of the ring starts over at offset 0 */
+	for(;;) {
+		tailOffset = (pHeader->head + pHeader->used) % pQueue->dataSize;
+		toEnd = pQueue->dataSize - tailOffset;
+		skipLen = (toEnd < recordLen) ? toEnd : 0;
+		if(pHeader->used + skipLen + recordLen <= pQueue->dataSize) {
+			break;
+		}
+		if(OFFLINE_QUEUE_DROP_NEWEST == pQueue->dropPolicy || 0 == pQueue->messageCount
+		   || !_aws_iot_mqtt_offline_queue_can_drop_head(pQueue)) {
+			_aws_iot_mqtt_offline_queue_unlock(pQueue);
+			FUNC_EXIT_RC(MQTT_OFFLINE_QUEUE_FULL_ERROR);
+		}
+		/* The dropped record is only overwritten once the header no longer points at it */
+		_aws_iot_mqtt_offline_queue_pop(pQueue);
+		rc = _aws_iot_mqtt_offline_queue_sync(pQueue, pHeader, sizeof(OfflineQueueHeader));
+		if(SUCCESS != rc) {
+			_aws_iot_mqtt_offline_queue_unlock(pQueue);
+			FUNC_EXIT_RC(rc);
+		}
+		IOT_WARN("Offline queue full, oldest message dropped");
+	}
+
+	if(sizeof(OfflineRecordHeader) <= skipLen) {
+		pRecord = _aws_iot_mqtt_offline_queue_record(pQueue, tailOffset);
+		pRecord->length = skipLen;
+		pRecord->checksum = 0;
+		pRecord->payloadLen = 0;
+		pRecord->topicLen = 0;
+		pRecord->qos = OFFLINE_RECORD_PADDING;
+		pRecord->isRetained = 0;
+		rc = _aws_iot_mqtt_offline_queue_sync(pQueue, pRecord, sizeof(OfflineRecordHeader));
+		if(SUCCESS != rc) {
+			_aws_iot_mqtt_offline_queue_unlock(pQueue);
+			FUNC_EXIT_RC(rc);
+		}
+	}
+
+	pRecord = _aws_iot_mqtt_offline_queue_record(pQueue, (tailOffset + skipLen) % pQueue->dataSize);
+	pRecord->length = recordLen;
+	pRecord->payloadLen = (uint32_t) pParams->payloadLen;
+	pRecord->topicLen = topicNameLen;
+	pRecord->qos = (uint8_t) pParams->qos;
+	pRecord->isRetained = pParams->isRetained;
+	memcpy((unsigned char *) pRecord + sizeof(OfflineRecordHeader), pTopicName, topicNameLen);
+	if(0 < pParams->payloadLen) {
+		memcpy((unsigned char *) pRecord + sizeof(OfflineRecordHeader) + topicNameLen, pParams->payload,
+			   pParams->payloadLen);
+	}
+	pRecord->checksum = _aws_iot_mqtt_offline_record_checksum(pRecord, len);
+
+	/* The record is stored before the header points past it */
+	rc = _aws_iot_mqtt_offline_queue_sync(pQueue, pRecord, recordLen);
+	if(SUCCESS == rc) {
+		pHeader->used += skipLen + recordLen;
+		pQueue->messageCount++;
+		rc = _aws_iot_mqtt_offline_queue_sync(pQueue, pHeader, sizeof(OfflineQueueHeader));
+	}
+
+	_aws_iot_mqtt_offline_queue_unlock(pQueue);
+
+	if(SUCCESS != rc) {
+		FUNC_EXIT_RC(rc);
+	}
+
+	FUNC_EXIT_RC(MQTT_PUBLISH_QUEUED_OFFLINE);
+}
+
+/**
+ * @brief Completion handler of a queued QoS1 message
+ *
+ * The message is acknowledged on SUCCESS, and removed once the messages before it are
+ * done. On a timeout or a lost connection it is left for the drain to send again.
+ *
+ * @param pClient MQTT client
+ * @param packetId Packet identifier of the publish
+ * @param status Completion status
+ * @param pCompleteHandlerData In-flight slot of the message
+ */
+static void _aws_iot_mqtt_offline_queue_complete(AWS_IoT_Client *pClient, uint16_t packetId, IoT_Error_t status,
+												 void *pCompleteHandlerData) {
+	OfflineQueue *pQueue = &(pClient->clientData.offlineQueue);
+	OfflineInflightRecord *pInflight = (OfflineInflightRecord *) pCompleteHandlerData;
+
+	IOT_UNUSED(packetId);
+
+	if(!pQueue->isOpen) {
+		return;
+	}
+
+	_aws_iot_mqtt_offline_queue_lock(pQueue);
+	pInflight->isPending = false;
+	pInflight->isAcked = (SUCCESS == status);
+	if(0 < _aws_iot_mqtt_offline_queue_pop_done(pQueue)) {
+		(void)_aws_iot_mqtt_offline_queue_sync(pQueue, _aws_iot_mqtt_offline_queue_header(pQueue),
+											   sizeof(OfflineQueueHeader));
+	}
+	_aws_iot_mqtt_offline_queue_unlock(pQueue);
+}
+
+/**
+ * @brief Pick the next message to send
+ *
+ * A QoS1 message whose publish failed is sent again before the messages never sent.
+ *
+ * @param pQueue Offline queue
+ * @param pOffset Output parameter, offset of the record
+ * @param ppInflight Output parameter, in-flight slot of a QoS1 message, NULL for QoS0
+ *
+ * @return true if a message is due, false if none is or no in-flight slot is free
+ */
+static bool _aws_iot_mqtt_offline_queue_next(OfflineQueue *pQueue, uint32_t *pOffset,
+											 OfflineInflightRecord **ppInflight) {
+	OfflineQueueHeader *pHeader = _aws_iot_mqtt_offline_queue_header(pQueue);
+	OfflineInflightRecord *pFree = NULL;
+	uint32_t itr, offset, toEnd;
+
+	for(itr = 0; itr < AWS_IOT_MQTT_MAX_INFLIGHT_PUBLISHES; itr++) {
+		if(!pQueue->inflight[itr].isUsed) {
+			pFree = (NULL == pFree) ? &(pQueue->inflight[itr]) : pFree;
+		} else if(!pQueue->inflight[itr].isPending && !pQueue->inflight[itr].isAcked) {
+			*pOffset = pQueue->inflight[itr].offset;
+			*ppInflight = &(pQueue->inflight[itr]);
+			return true;
+		}
+	}
+
+	if(pQueue->sentCount == pQueue->messageCount) {
+		return false;
+	}
+
+	/* The first message never sent follows the sent ones, past the padding at the end of the ring */
+	offset = (pHeader->head + pQueue->sentLen) % pQueue->dataSize;
+	toEnd = pQueue->dataSize - offset;
+	if(sizeof(OfflineRecordHeader) > toEnd
+	   || OFFLINE_RECORD_PADDING == _aws_iot_mqtt_offline_queue_record(pQueue, offset)->qos) {
+		pQueue->sentLen += toEnd;
+		offset = 0;
+	}
+
+	if(QOS0 == _aws_iot_mqtt_offline_queue_record(pQueue, offset)->qos) {
+		*ppInflight = NULL;
+	} else if(NULL == pFree) {
+		return false;
+	} else {
+		pFree->isUsed = true;
+		pFree->isPending = false;
+		pFree->isAcked = false;
+		pFree->offset = offset;
+		*ppInflight = pFree;
+	}
+
+	pQueue->sentLen += _aws_iot_mqtt_offline_queue_record(pQueue, offset)->length;
+	pQueue->sentCount++;
+	*pOffset = offset;
+
+	return true;
+}
+
+/**
+ * @brief Publish a batch of queued messages, at most once per drain interval
+ *
+ * Called by the thread that yields, with the client connected. The queue lock is released
+ * while a message is sent, the record cannot be dropped meanwhile. A QoS0 message leaves
+ * the queue once it has been handed to the network, a QoS1 message once its PUBACK is
+ * received. Draining stops early when the in-flight table is full or sending fails, the
+ * remaining messages are sent on a later call.
+ *
+ * @param pClient MQTT client
+ *
+ * @return SUCCESS, send errors are left to the read and keep-alive paths to detect
+ */
+IoT_Error_t aws_iot_mqtt_internal_offline_queue_drain(AWS_IoT_Client *pClient) {
+	OfflineQueue *pQueue = &(pClient->clientData.offlineQueue);
+	OfflineRecordHeader *pRecord;
+	OfflineInflightRecord *pInflight;
+	IoT_Publish_Message_Params params;
+	uint32_t sent, offset, popped = 0;
+	IoT_Error_t rc = SUCCESS;
+
+	FUNC_ENTRY;
+
+	if(!pQueue->isOpen || 0 == pQueue->messageCount || !has_timer_expired(&(pQueue->drainTimer))) {
+		FUNC_EXIT_RC(SUCCESS);
+	}
+
+	_aws_iot_mqtt_offline_queue_lock(pQueue);
+
+	for(sent = 0; sent < AWS_IOT_MQTT_OFFLINE_QUEUE_DRAIN_BATCH; sent++) {
+		if(!_aws_iot_mqtt_offline_queue_next(pQueue, &offset, &pInflight)) {
+			break;
+		}
+
+		pRecord = _aws_iot_mqtt_offline_queue_record(pQueue, offset);
+		params.qos = (QoS) pRecord->qos;
+		params.isRetained = pRecord->isRetained;
+		params.isDup = 0;
+		params.id = 0;
+		params.payload = (unsigned char *) pRecord + sizeof(OfflineRecordHeader) + pRecord->topicLen;
+		params.payloadLen = pRecord->payloadLen;
+		if(NULL != pInflight) {
+			pInflight->isPending = true;
+		}
+		pQueue->isSending = true;
+		pQueue->sendingOffset = offset;
+
+		_aws_iot_mqtt_offline_queue_unlock(pQueue);
+		rc = aws_iot_mqtt_internal_publish_offline_message(pClient, (char *) pRecord + sizeof(OfflineRecordHeader),
+														   pRecord->topicLen, &params,
+														   _aws_iot_mqtt_offline_queue_complete, pInflight);
+		_aws_iot_mqtt_offline_queue_lock(pQueue);
+
+		pQueue->isSending = false;
+		if(MQTT_TX_BUFFER_TOO_SHORT_ERROR == rc) {
+			/* Would never fit, keeping it would block the queue */
+			IOT_WARN("Queued message dropped, its topic does not fit in the write buffer");
+			if(NULL != pInflight) {
+				pInflight->isPending = false;
+				pInflight->isAcked = true;
+			}
+			rc = SUCCESS;
+		} else if(SUCCESS != rc) {
+			if(NULL != pInflight) {
+				/* Sent again on a later call */
+				pInflight->isPending = false;
+			} else {
+				/* The last message marked as sent, nothing follows it */
+				pQueue->sentCount--;
+				pQueue->sentLen -= pRecord->length;
+			}
+		}
+		popped += _aws_iot_mqtt_offline_queue_pop_done(pQueue);
+		if(SUCCESS != rc) {
+			break;
+		}
+	}
+
+	if(0 < popped) {
+		(void)_aws_iot_mqtt_offline_queue_sync(pQueue, _aws_iot_mqtt_offline_queue_header(pQueue),
+											   sizeof(OfflineQueueHeader));
+	}
+
+	_aws_iot_mqtt_offline_queue_unlock(pQueue);
+
+	if(SUCCESS != rc) {
+		IOT_WARN("Draining the offline queue paused, %d", rc);
+	}
+
+	countdown_ms(&(pQueue->drainTimer), AWS_IOT_MQTT_OFFLINE_QUEUE_DRAIN_INTERVAL_MS);
+
+	FUNC_EXIT_RC(SUCCESS);
+}
+
+/**
+ * @brief Time until the next drain step
+ *
+ * @param pClient MQTT client
+ *
+ * @return Milliseconds until messages are due to be drained, AWS_IOT_MQTT_NO_DEADLINE if none is to be sent
+ */
+uint32_t aws_iot_mqtt_internal_offline_queue_deadline_ms(AWS_IoT_Client *pClient) {
+	OfflineQueue *pQueue = &(pClient->clientData.offlineQueue);
+
+	if(!pQueue->isOpen || !_aws_iot_mqtt_offline_queue_has_unsent(pQueue)) {
+		return AWS_IOT_MQTT_NO_DEADLINE;
+	}
+	if(has_timer_expired(&(pQueue->drainTimer))) {
+		return 0;
+	}
+
+	return left_ms(&(pQueue->drainTimer)) + 1;
+}
+
+uint32_t aws_iot_mqtt_get_offline_message_count(AWS_IoT_Client *pClient) {
+	if(NULL == pClient || !pClient->clientData.offlineQueue.isOpen) {
+		return 0;
+	}
+
+	return pClient->clientData.offlineQueue.messageCount;
+}
+
+#endif /* AWS_IOT_MQTT_ENABLE_OFFLINE_QUEUE */
+
+#ifdef __cplusplus
+}
+#endif
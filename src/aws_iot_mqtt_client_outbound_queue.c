@@ -0,0 +1,213 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file aws_iot_mqtt_client_outbound_queue.c
+ * @brief MQTT client outbound queue
+ *
+ * Publishing threads serialize their packets into the slots of a bounded lock-free queue
+ * instead of waiting for the write buffer. Whichever thread holds the write buffer sends
+ * the queued packets, copying as many as fit into the write buffer so that they go out
+ * in one network write. A producer that finds the write buffer free sends them itself.
+ * Only built when AWS_IOT_MQTT_OUTBOUND_QUEUE_SLOTS is set in aws_iot_config.h.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <string.h>
+
+#include "aws_iot_mqtt_client_common_internal.h"
+
+#ifdef AWS_IOT_MQTT_OUTBOUND_QUEUE_SLOTS
+
+/** Slot of the queue for a position */
+#define OUTBOUND_SLOT(pQueue, pos) (&((pQueue)->slots[(pos) & ((pQueue)->slotCount - 1)]))
+
+/**
+ * @brief Initialize the outbound queue of a client
+ *
+ * @param pClient MQTT client
+ */
+void aws_iot_mqtt_internal_outbound_queue_init(AWS_IoT_Client *pClient) {
+	OutboundQueue *pQueue = &(pClient->clientData.outboundQueue);
+	uint32_t itr;
+
+	pQueue->enqueuePos = 0;
+	pQueue->dequeuePos = 0;
+	for(itr = 0; itr < pQueue->slotCount; itr++) {
+		pQueue->slots[itr].sequence = itr;
+		pQueue->slots[itr].len = 0;
+	}
+}
+
+/**
+ * @brief Claim the next slot of the outbound queue
+ *
+ * The packet is serialized into the slot, which is then handed to the writer with
+ * aws_iot_mqtt_internal_outbound_queue_commit. Packets are sent in the order their
+ * slots were claimed.
+ *
+ * @param pClient MQTT client
+ *
+ * @return The claimed slot, NULL if the queue is full
+ */
+OutboundSlot *aws_iot_mqtt_internal_outbound_queue_claim(AWS_IoT_Client *pClient) {
+	OutboundQueue *pQueue = &(pClient->clientData.outboundQueue);
+	OutboundSlot *pSlot;
+	uint32_t pos, sequence;
+	int32_t diff;
+
+	pos = aws_iot_thread_atomic_load(&(pQueue->enqueuePos));
+	for(;;) {
+		pSlot = OUTBOUND_SLOT(pQueue, pos);
+		sequence = aws_iot_thread_atomic_load(&(pSlot->sequence));
+		diff = (int32_t) (sequence - pos);
+		if(0 == diff) {
+			/* Available, unless another producer claims it first */
+			if(aws_iot_thread_atomic_compare_exchange(&(pQueue->enqueuePos), &pos, pos + 1)) {
+				return pSlot;
+			}
+		} else if(0 > diff) {
+			/* Still holds the packet queued one lap earlier */
+			return NULL;
+		} else {
+			pos = aws_iot_thread_atomic_load(&(pQueue->enqueuePos));
+		}
+	}
+}
+
+/**
+ * @brief Hand a claimed slot over to the writer
+ *
+ * @param pSlot Slot returned by aws_iot_mqtt_internal_outbound_queue_claim
+ * @param len Length of the packet serialized in the slot, 0 to give the slot up
+ */
+void aws_iot_mqtt_internal_outbound_queue_commit(OutboundSlot *pSlot, size_t len) {
+	pSlot->len = len;
+	aws_iot_thread_atomic_store(&(pSlot->sequence), aws_iot_thread_atomic_load(&(pSlot->sequence)) + 1);
+}
+
+/**
+ * @brief Check whether the next queued packet is ready to be sent
+ *
+ * @param pClient MQTT client
+ *
+ * @return true if the packet at the head of the queue has been committed
+ */
+static bool _aws_iot_mqtt_internal_outbound_queue_is_ready(AWS_IoT_Client *pClient) {
+	OutboundQueue *pQueue = &(pClient->clientData.outboundQueue);
+	uint32_t pos = aws_iot_thread_atomic_load(&(pQueue->dequeuePos));
+
+	return (pos + 1 == aws_iot_thread_atomic_load(&(OUTBOUND_SLOT(pQueue, pos)->sequence)));
+}
+
+/**
+ * @brief Release the slot at the head of the queue for the producers of the next lap
+ *
+ * @param pQueue Outbound queue
+ */
+static void _aws_iot_mqtt_internal_outbound_queue_pop(OutboundQueue *pQueue) {
+	uint32_t pos = pQueue->dequeuePos;
+
+	aws_iot_thread_atomic_store(&(OUTBOUND_SLOT(pQueue, pos)->sequence), pos + pQueue->slotCount);
+	aws_iot_thread_atomic_store(&(pQueue->dequeuePos), pos + 1);
+}
+
+/**
+ * @brief Send the packets that are ready at the head of the queue
+ *
+ * The caller owns the write buffer. Consecutive packets are copied into the write buffer
+ * and sent together. Stops at the first packet that is still being serialized.
+ *
+ * @param pClient MQTT client
+ *
+ * @return IoT_Error_t of send status
+ */
+IoT_Error_t aws_iot_mqtt_internal_outbound_queue_flush(AWS_IoT_Client *pClient) {
+	OutboundQueue *pQueue = &(pClient->clientData.outboundQueue);
+	OutboundSlot *pSlot;
+	size_t len = 0;
+	IoT_Error_t rc = SUCCESS;
+	Timer timer;
+
+	FUNC_ENTRY;
+
+	init_timer(&timer);
+	countdown_ms(&timer, pClient->clientData.commandTimeoutMs);
+
+	while(SUCCESS == rc && _aws_iot_mqtt_internal_outbound_queue_is_ready(pClient)) {
+		pSlot = OUTBOUND_SLOT(pQueue, pQueue->dequeuePos);
+		if(len + pSlot->len >= pClient->clientData.writeBufSize) {
+			rc = aws_iot_mqtt_internal_send_packet(pClient, len, &timer);
+			len = 0;
+			continue;
+		}
+
+		memcpy(pClient->clientData.writeBuf + len, pSlot->packet, pSlot->len);
+		len += pSlot->len;
+		_aws_iot_mqtt_internal_outbound_queue_pop(pQueue);
+	}
+
+	if(SUCCESS == rc && 0 < len) {
+		rc = aws_iot_mqtt_internal_send_packet(pClient, len, &timer);
+	}
+
+	FUNC_EXIT_RC(rc);
+}
+
+/**
+ * @brief Drop the queued packets, used before a new connection is made
+ *
+ * The caller owns the write buffer.
+ *
+ * @param pClient MQTT client
+ */
+void aws_iot_mqtt_internal_outbound_queue_discard(AWS_IoT_Client *pClient) {
+	while(_aws_iot_mqtt_internal_outbound_queue_is_ready(pClient)) {
+		_aws_iot_mqtt_internal_outbound_queue_pop(&(pClient->clientData.outboundQueue));
+	}
+}
+
+/**
+ * @brief Send the queued packets unless another thread holds the write buffer
+ *
+ * The holder of the write buffer sends the queued packets before releasing it, so a
+ * thread that cannot take the buffer leaves its packets to the holder.
+ *
+ * @param pClient MQTT client
+ *
+ * @return IoT_Error_t of send status, SUCCESS if the packets were left to another thread
+ */
+IoT_Error_t aws_iot_mqtt_internal_outbound_queue_send(AWS_IoT_Client *pClient) {
+	IoT_Error_t rc = SUCCESS;
+
+	while(SUCCESS == rc && _aws_iot_mqtt_internal_outbound_queue_is_ready(pClient)
+		  && SUCCESS == aws_iot_thread_mutex_trylock(&(pClient->clientData.tls_write_mutex))) {
+		rc = aws_iot_mqtt_internal_outbound_queue_flush(pClient);
+		if(SUCCESS != aws_iot_thread_mutex_unlock(&(pClient->clientData.tls_write_mutex)) && SUCCESS == rc) {
+			rc = MUTEX_UNLOCK_ERROR;
+		}
+	}
+
+	return rc;
+}
+
+#endif /* AWS_IOT_MQTT_OUTBOUND_QUEUE_SLOTS */
+
+#ifdef __cplusplus
+}
+#endif
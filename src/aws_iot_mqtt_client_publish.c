@@ -69,8 +69,9 @@ static IoT_Error_t _aws_iot_mqtt_read_string_with_len(char **stringVar, uint16_t
 }
 
 /**
-  * Serializes the supplied publish data into the supplied buffer, ready for sending
-  * @param pTxBuf the buffer into which the packet will be serialized
+  * Serializes the header of the supplied publish data into the supplied buffer, ready for sending.
+  * The payload is not copied, it is sent from the caller's buffer after the serialized header.
+  * @param pTxBuf the buffer into which the packet header will be serialized
   * @param txBufLen the length in bytes of the supplied buffer
   * @param dup uint8_t - the MQTT dup flag
   * @param qos QoS - the MQTT QoS value
@@ -78,35 +79,37 @@ static IoT_Error_t _aws_iot_mqtt_read_string_with_len(char **stringVar, uint16_t
   * @param packetId uint16_t - the MQTT packet identifier
   * @param pTopicName char * - the MQTT topic in the publish
   * @param topicNameLen uint16_t - the length of the Topic Name
-  * @param pPayload byte buffer - the MQTT publish payload
   * @param payloadLen size_t - the length of the MQTT payload
-  * @param pSerializedLen uint32_t - pointer to the variable that stores serialized len
+  * @param pSerializedLen uint32_t - pointer to the variable that stores serialized header len
   *
   * @return An IoT Error Type defining successful/failed call
   */
-static IoT_Error_t _aws_iot_mqtt_internal_serialize_publish(unsigned char *pTxBuf, size_t txBufLen, uint8_t dup,
-															QoS qos, uint8_t retained, uint16_t packetId,
-															const char *pTopicName, uint16_t topicNameLen,
-															const unsigned char *pPayload, size_t payloadLen,
-															uint32_t *pSerializedLen) {
+static IoT_Error_t _aws_iot_mqtt_internal_serialize_publish_header(unsigned char *pTxBuf, size_t txBufLen, uint8_t dup,
+																   QoS qos, uint8_t retained, uint16_t packetId,
+																   const char *pTopicName, uint16_t topicNameLen,
+																   size_t payloadLen, uint32_t *pSerializedLen) {
 	unsigned char *ptr;
 	uint32_t rem_len;
 	IoT_Error_t rc;
 	MQTTHeader header = {0};
 
 	FUNC_ENTRY;
-	if(NULL == pTxBuf || NULL == pPayload || NULL == pSerializedLen) {
+	if(NULL == pTxBuf || NULL == pSerializedLen) {
 		FUNC_EXIT_RC(NULL_VALUE_ERROR);
 	}
 
 	ptr = pTxBuf;
 	rem_len = 0;
 
+	if(MAX_MQTT_REMAINING_LENGTH - (uint32_t) (topicNameLen + 4) < payloadLen) {
+		FUNC_EXIT_RC(MQTT_TX_BUFFER_TOO_SHORT_ERROR);
+	}
+
 	rem_len += (uint32_t) (topicNameLen + payloadLen + 2);
 	if(qos > 0) {
 		rem_len += 2; /* packetId */
 	}
-	if(aws_iot_mqtt_internal_get_final_packet_length_from_remaining_length(rem_len) > txBufLen) {
+	if(aws_iot_mqtt_internal_get_final_packet_length_from_remaining_length(rem_len) - payloadLen > txBufLen) {
 		FUNC_EXIT_RC(MQTT_TX_BUFFER_TOO_SHORT_ERROR);
 	}
 
@@ -124,9 +127,6 @@ static IoT_Error_t _aws_iot_mqtt_internal_serialize_publish(unsigned char *pTxBu
 		aws_iot_mqtt_internal_write_uint_16(&ptr, packetId);
 	}
 
-	memcpy(ptr, pPayload, payloadLen);
-	ptr += payloadLen;
-
 	*pSerializedLen = (uint32_t) (ptr - pTxBuf);
 
 	FUNC_EXIT_RC(SUCCESS);
@@ -177,6 +177,337 @@ IoT_Error_t aws_iot_mqtt_internal_serialize_ack(unsigned char *pTxBuf, size_t tx
 	FUNC_EXIT_RC(SUCCESS);
 }
 
+/**
+ * @brief Lock the in-flight publish table
+ *
+ * The table is shared by the threads that publish and the thread that reads the PUBACKs.
+ * It is only held for a few instructions, never while calling out, so it always blocks.
+ *
+ * @param pClient Reference to the IoT Client
+ */
+static void _aws_iot_mqtt_internal_lock_inflight_table(AWS_IoT_Client *pClient) {
+#ifdef _ENABLE_THREAD_SUPPORT_
+	(void)aws_iot_thread_mutex_lock(&(pClient->clientData.inflight_mutex));
+#else
+	IOT_UNUSED(pClient);
+#endif
+}
+
+/**
+ * @brief Unlock the in-flight publish table
+ *
+ * @param pClient Reference to the IoT Client
+ */
+static void _aws_iot_mqtt_internal_unlock_inflight_table(AWS_IoT_Client *pClient) {
+#ifdef _ENABLE_THREAD_SUPPORT_
+	(void)aws_iot_thread_mutex_unlock(&(pClient->clientData.inflight_mutex));
+#else
+	IOT_UNUSED(pClient);
+#endif
+}
+
+/**
+ * @brief Wake the publishes waiting on the in-flight table, with the table locked
+ *
+ * @param pClient Reference to the IoT Client
+ */
+static void _aws_iot_mqtt_internal_signal_inflight_table(AWS_IoT_Client *pClient) {
+#ifdef _ENABLE_THREAD_SUPPORT_
+	(void)aws_iot_thread_cond_broadcast(&(pClient->clientData.inflight_cond));
+#else
+	IOT_UNUSED(pClient);
+#endif
+}
+
+#ifdef _ENABLE_THREAD_SUPPORT_
+/**
+ * @brief Wait until the in-flight table is signalled or the timer expires, with the table locked
+ *
+ * @param pClient Reference to the IoT Client
+ * @param pTimer Deadline of the wait
+ */
+static void _aws_iot_mqtt_internal_wait_on_inflight_table(AWS_IoT_Client *pClient, Timer *pTimer) {
+	(void)aws_iot_thread_cond_wait(&(pClient->clientData.inflight_cond), &(pClient->clientData.inflight_mutex),
+								   left_ms(pTimer));
+}
+
+/**
+ * @brief Wake the publishes waiting on the in-flight table once the client went back to idle
+ *
+ * A publish made while another thread reads waits for that thread to free or complete
+ * its entry. When the reading thread leaves, the waiting publish takes over or gives up.
+ *
+ * @param pClient Reference to the IoT Client
+ */
+void aws_iot_mqtt_internal_wake_inflight_waiters(AWS_IoT_Client *pClient) {
+	_aws_iot_mqtt_internal_lock_inflight_table(pClient);
+	_aws_iot_mqtt_internal_signal_inflight_table(pClient);
+	_aws_iot_mqtt_internal_unlock_inflight_table(pClient);
+}
+#endif
+
+/**
+ * @brief Reserve an in-flight entry for a QoS1 publish and assign the packet identifier
+ *
+ * @param pClient Reference to the IoT Client
+ * @param pParams Pointer to Publish Message parameters, the packet identifier is set here
+ * @param pCompleteHandler Reference to the completion handler
+ * @param pCompleteHandlerData Point to data passed to the completion handler
+ * @param isWaited Whether a blocking publish waits on the entry instead of a completion handler
+ * @param pTimer Amount of time allowed to wait for a free entry while another thread reads
+ *               for the client, NULL to fail at once when the table is full
+ *
+ * @return Index of the entry, inflightPublishCount of the client if the table is full
+ */
+static uint32_t _aws_iot_mqtt_internal_reserve_inflight_entry(AWS_IoT_Client *pClient,
+															  IoT_Publish_Message_Params *pParams,
+															  pPublishCompleteHandler_t pCompleteHandler,
+															  void *pCompleteHandlerData, bool isWaited,
+															  Timer *pTimer) {
+	uint32_t itr;
+	InflightPublish *pEntry;
+
+	/* Taken first, the packet identifier is guarded by the same lock as the table */
+	pParams->id = aws_iot_mqtt_get_next_packet_id(pClient);
+
+	_aws_iot_mqtt_internal_lock_inflight_table(pClient);
+
+#ifdef _ENABLE_THREAD_SUPPORT_
+	/* Entries are freed by the reading thread, which signals the table */
+	while(NULL != pTimer && !has_timer_expired(pTimer)
+		  && CLIENT_STATE_CONNECTED_IDLE != aws_iot_mqtt_get_client_state(pClient)) {
+		for(itr = 0; itr < pClient->clientData.inflightPublishCount; itr++) {
+			if(pClient->clientData.inflightPublishes[itr].isFree) {
+				break;
+			}
+		}
+		if(pClient->clientData.inflightPublishCount != itr) {
+			break;
+		}
+		_aws_iot_mqtt_internal_wait_on_inflight_table(pClient, pTimer);
+	}
+#else
+	IOT_UNUSED(pTimer);
+#endif
+
+	for(itr = 0; itr < pClient->clientData.inflightPublishCount; itr++) {
+		pEntry = &(pClient->clientData.inflightPublishes[itr]);
+		if(pEntry->isFree) {
+			pEntry->packetId = pParams->id;
+			pEntry->pCompleteHandler = pCompleteHandler;
+			pEntry->pCompleteHandlerData = pCompleteHandlerData;
+			pEntry->isWaited = isWaited;
+			pEntry->isComplete = false;
+			pEntry->completeStatus = SUCCESS;
+#ifdef AWS_IOT_MQTT_INFLIGHT_PACKET_LEN
+			pEntry->storedLen = 0;
+#endif
+#ifdef AWS_IOT_MQTT_ENABLE_STATS
+			pEntry->sentUs = timer_now_us();
+#endif
+			aws_iot_timer_wheel_arm(&(pClient->clientData.inflightWheel), (uint16_t) itr,
+									pClient->clientData.commandTimeoutMs);
+			pEntry->isFree = false;
+			break;
+		}
+	}
+
+	_aws_iot_mqtt_internal_unlock_inflight_table(pClient);
+
+	return itr;
+}
+
+/**
+ * @brief Release an in-flight entry without completing it
+ *
+ * @param pClient Reference to the IoT Client
+ * @param index Index of the entry in the in-flight table
+ */
+static void _aws_iot_mqtt_internal_release_inflight_entry(AWS_IoT_Client *pClient, uint32_t index) {
+	InflightPublish *pEntry = &(pClient->clientData.inflightPublishes[index]);
+
+	_aws_iot_mqtt_internal_lock_inflight_table(pClient);
+	aws_iot_timer_wheel_disarm(&(pClient->clientData.inflightWheel), (uint16_t) index);
+	pEntry->isFree = true;
+	pEntry->isWaited = false;
+	pEntry->pCompleteHandler = NULL;
+	pEntry->pCompleteHandlerData = NULL;
+#ifdef AWS_IOT_MQTT_INFLIGHT_PACKET_LEN
+	pEntry->storedLen = 0;
+#endif
+	_aws_iot_mqtt_internal_signal_inflight_table(pClient);
+	_aws_iot_mqtt_internal_unlock_inflight_table(pClient);
+}
+
+#ifdef AWS_IOT_MQTT_INFLIGHT_PACKET_LEN
+/**
+ * @brief Keep a copy of the PUBLISH packet of an in-flight entry for a persistent session
+ *
+ * The copy is serialized with the DUP flag set, as it is only sent again after reconnecting.
+ * Nothing is kept for a clean session or when the packet is larger than
+ * AWS_IOT_MQTT_INFLIGHT_PACKET_LEN, such a publish fails when the connection is lost.
+ *
+ * @param pClient Reference to the IoT Client
+ * @param index Index of the reserved entry in the in-flight table
+ * @param pTopicName Topic Name to publish to
+ * @param topicNameLen Length of the topic name
+ * @param pParams Pointer to Publish Message parameters, with the packet identifier set
+ */
+static void _aws_iot_mqtt_internal_store_inflight_packet(AWS_IoT_Client *pClient, uint32_t index,
+														 const char *pTopicName, uint16_t topicNameLen,
+														 IoT_Publish_Message_Params *pParams) {
+	unsigned char *pStore = pClient->clientData.inflightStore + (size_t) index * AWS_IOT_MQTT_INFLIGHT_PACKET_LEN;
+	size_t storeLen = AWS_IOT_MQTT_INFLIGHT_PACKET_LEN;
+	uint32_t len = 0;
+
+	/* The packet is resent from the write buffer, which may be smaller for this client */
+	if(storeLen >= pClient->clientData.writeBufSize) {
+		storeLen = pClient->clientData.writeBufSize - 1;
+	}
+
+	if(pClient->clientData.options.isCleanSession || storeLen <= pParams->payloadLen) {
+		return;
+	}
+
+	if(SUCCESS != _aws_iot_mqtt_internal_serialize_publish_header(pStore, storeLen - pParams->payloadLen,
+																  1, pParams->qos, pParams->isRetained, pParams->id,
+																  pTopicName, topicNameLen, pParams->payloadLen, &len)) {
+		return;
+	}
+	memcpy(pStore + len, pParams->payload, pParams->payloadLen);
+
+	/* Only this thread uses the reserved entry until the packet is sent */
+	pClient->clientData.inflightPublishes[index].storedLen = len + pParams->payloadLen;
+}
+#endif
+
+/**
+ * @brief Serialize and send a PUBLISH packet
+ *
+ * With the outbound queue enabled, a packet that fits in a queue slot is queued and sent
+ * by whichever thread holds the write buffer, together with the other queued packets.
+ * Larger packets are sent from the write buffer once the queued packets have gone out.
+ *
+ * @param pClient Reference to the IoT Client
+ * @param pTopicName Topic Name to publish to
+ * @param topicNameLen Length of the topic name
+ * @param pParams Pointer to Publish Message parameters, with the packet identifier set
+ * @param pTimer Amount of time allowed to send the packet
+ *
+ * @return An IoT Error Type defining successful/failed send
+ */
+static IoT_Error_t _aws_iot_mqtt_internal_send_publish(AWS_IoT_Client *pClient, const char *pTopicName,
+													   uint16_t topicNameLen, IoT_Publish_Message_Params *pParams,
+													   Timer *pTimer) {
+	uint32_t len = 0;
+	IoT_Error_t rc;
+#ifdef AWS_IOT_MQTT_OUTBOUND_QUEUE_SLOTS
+	OutboundSlot *pSlot;
+#endif
+
+	FUNC_ENTRY;
+
+#ifdef AWS_IOT_MQTT_OUTBOUND_QUEUE_SLOTS
+	/* Queued packets are sent from the write buffer, which may be smaller than a slot for this client */
+	pSlot = (pParams->payloadLen < AWS_IOT_MQTT_OUTBOUND_SLOT_LEN
+			 && AWS_IOT_MQTT_OUTBOUND_SLOT_LEN < pClient->clientData.writeBufSize) ?
+			aws_iot_mqtt_internal_outbound_queue_claim(pClient) : NULL;
+	if(NULL != pSlot) {
+		rc = _aws_iot_mqtt_internal_serialize_publish_header(pSlot->packet,
+															 AWS_IOT_MQTT_OUTBOUND_SLOT_LEN - pParams->payloadLen, 0,
+															 pParams->qos, pParams->isRetained, pParams->id,
+															 pTopicName, topicNameLen, pParams->payloadLen, &len);
+		if(SUCCESS == rc) {
+			memcpy(pSlot->packet + len, pParams->payload, pParams->payloadLen);
+			aws_iot_mqtt_internal_outbound_queue_commit(pSlot, len + pParams->payloadLen);
+			FUNC_EXIT_RC(aws_iot_mqtt_internal_outbound_queue_send(pClient));
+		}
+		/* Topic too long for a slot, give it up and use the write buffer */
+		aws_iot_mqtt_internal_outbound_queue_commit(pSlot, 0);
+	}
+#endif
+
+	rc = aws_iot_mqtt_internal_lock_write_buffer(pClient);
+	if(SUCCESS != rc) {
+		FUNC_EXIT_RC(rc);
+	}
+
+#ifdef AWS_IOT_MQTT_OUTBOUND_QUEUE_SLOTS
+	/* Packets queued earlier, possibly by this thread, go out first */
+	rc = aws_iot_mqtt_internal_outbound_queue_flush(pClient);
+	if(SUCCESS != rc) {
+		FUNC_EXIT_RC(aws_iot_mqtt_internal_unlock_write_buffer(pClient, rc));
+	}
+#endif
+
+	rc = _aws_iot_mqtt_internal_serialize_publish_header(pClient->clientData.writeBuf,
+														 pClient->clientData.writeBufSize, 0, pParams->qos,
+														 pParams->isRetained, pParams->id, pTopicName, topicNameLen,
+														 pParams->payloadLen, &len);
+	if(SUCCESS == rc) {
+		/* send the publish packet */
+		rc = aws_iot_mqtt_internal_send_packet_with_payload(pClient, len, (unsigned char *) pParams->payload,
+															pParams->payloadLen, pTimer);
+	}
+
+	FUNC_EXIT_RC(aws_iot_mqtt_internal_unlock_write_buffer(pClient, rc));
+}
+
+#ifdef _ENABLE_THREAD_SUPPORT_
+/**
+ * @brief Wait for the PUBACK of a blocking publish made while another thread reads
+ *
+ * The reading thread completes the in-flight entry of the publish and signals the table.
+ * Should the client become idle in the meantime, the publish is woken as well and takes
+ * over the read side until the entry completes.
+ *
+ * @param pClient Reference to the IoT Client
+ * @param index Index of the entry in the in-flight table, released here
+ * @param pTimer Amount of time allowed to wait for the PUBACK
+ *
+ * @return Completion status of the publish
+ */
+static IoT_Error_t _aws_iot_mqtt_internal_wait_for_inflight_entry(AWS_IoT_Client *pClient, uint32_t index,
+																  Timer *pTimer) {
+	InflightPublish *pEntry = &(pClient->clientData.inflightPublishes[index]);
+	uint8_t packetType;
+	bool isDone;
+	IoT_Error_t rc = MQTT_REQUEST_TIMEOUT_ERROR;
+
+	FUNC_ENTRY;
+
+	do {
+		_aws_iot_mqtt_internal_lock_inflight_table(pClient);
+		while(!pEntry->isComplete && !has_timer_expired(pTimer)
+			  && CLIENT_STATE_CONNECTED_IDLE != aws_iot_mqtt_get_client_state(pClient)) {
+			_aws_iot_mqtt_internal_wait_on_inflight_table(pClient, pTimer);
+		}
+		isDone = pEntry->isComplete || has_timer_expired(pTimer);
+		if(pEntry->isComplete) {
+			rc = pEntry->completeStatus;
+		}
+		_aws_iot_mqtt_internal_unlock_inflight_table(pClient);
+
+		if(isDone) {
+			break;
+		}
+
+		if(SUCCESS == aws_iot_mqtt_set_client_state(pClient, CLIENT_STATE_CONNECTED_IDLE,
+													 CLIENT_STATE_CONNECTED_PUBLISH_IN_PROGRESS)) {
+			/* Nobody reads for this client anymore */
+			rc = aws_iot_mqtt_internal_cycle_read(pClient, pTimer, &packetType);
+			(void)aws_iot_mqtt_set_client_state(pClient, CLIENT_STATE_CONNECTED_PUBLISH_IN_PROGRESS,
+												CLIENT_STATE_CONNECTED_IDLE);
+			isDone = (SUCCESS != rc);
+		}
+	} while(!isDone);
+
+	_aws_iot_mqtt_internal_release_inflight_entry(pClient, index);
+
+	FUNC_EXIT_RC(rc);
+}
+#endif
+
 /**
  * @brief Publish an MQTT message on a topic
  *
@@ -191,39 +522,60 @@ IoT_Error_t aws_iot_mqtt_internal_serialize_ack(unsigned char *pTxBuf, size_t tx
  * @param pTopicName Topic Name to publish to
  * @param topicNameLen Length of the topic name
  * @param pParams Pointer to Publish Message parameters
+ * @param isReader Whether the publish reads its PUBACK. Otherwise another thread is yielding
+ *                 and the PUBACK is routed through the in-flight table
  *
  * @return An IoT Error Type defining successful/failed publish
  */
 static IoT_Error_t _aws_iot_mqtt_internal_publish(AWS_IoT_Client *pClient, const char *pTopicName,
-												  uint16_t topicNameLen, IoT_Publish_Message_Params *pParams) {
+												  uint16_t topicNameLen, IoT_Publish_Message_Params *pParams,
+												  bool isReader) {
 	Timer timer;
-	uint32_t len = 0;
+	uint32_t index = pClient->clientData.inflightPublishCount;
 	uint16_t packet_id;
 	unsigned char dup, type;
 	IoT_Error_t rc;
+#ifdef AWS_IOT_MQTT_ENABLE_STATS
+	uint32_t sentUs = timer_now_us();
+#endif
 
 	FUNC_ENTRY;
 
+	/* The payload is sent from the caller's buffer */
+	if(NULL == pParams->payload) {
+		FUNC_EXIT_RC(NULL_VALUE_ERROR);
+	}
+
 	init_timer(&timer);
 	countdown_ms(&timer, pClient->clientData.commandTimeoutMs);
 
-	if(QOS1 == pParams->qos) {
+	if(QOS1 == pParams->qos && isReader) {
 		pParams->id = aws_iot_mqtt_get_next_packet_id(pClient);
+	} else if(QOS1 == pParams->qos) {
+		/* With the window full, wait for the reading thread to free an entry */
+		index = _aws_iot_mqtt_internal_reserve_inflight_entry(pClient, pParams, NULL, NULL, true, &timer);
+		if(pClient->clientData.inflightPublishCount == index) {
+			FUNC_EXIT_RC(MQTT_MAX_INFLIGHT_PUBLISHES_REACHED_ERROR);
+		}
+#ifdef AWS_IOT_MQTT_INFLIGHT_PACKET_LEN
+		/* The reading thread may reconnect while this publish waits, and resend the packet */
+		_aws_iot_mqtt_internal_store_inflight_packet(pClient, index, pTopicName, topicNameLen, pParams);
+#endif
 	}
 
-	rc = _aws_iot_mqtt_internal_serialize_publish(pClient->clientData.writeBuf, pClient->clientData.writeBufSize, 0,
-												  pParams->qos, pParams->isRetained, pParams->id, pTopicName,
-												  topicNameLen, (unsigned char *) pParams->payload,
-												  pParams->payloadLen, &len);
+	rc = _aws_iot_mqtt_internal_send_publish(pClient, pTopicName, topicNameLen, pParams, &timer);
 	if(SUCCESS != rc) {
+		if(pClient->clientData.inflightPublishCount != index) {
+			_aws_iot_mqtt_internal_release_inflight_entry(pClient, index);
+		}
 		FUNC_EXIT_RC(rc);
 	}
 
-	/* send the publish packet */
-	rc = aws_iot_mqtt_internal_send_packet(pClient, len, &timer);
-	if(SUCCESS != rc) {
-		FUNC_EXIT_RC(rc);
+#ifdef _ENABLE_THREAD_SUPPORT_
+	if(pClient->clientData.inflightPublishCount != index) {
+		FUNC_EXIT_RC(_aws_iot_mqtt_internal_wait_for_inflight_entry(pClient, index, &timer));
 	}
+#endif
 
 	/* Wait for ack if QoS1 */
 	if(QOS1 == pParams->qos) {
@@ -237,11 +589,362 @@ static IoT_Error_t _aws_iot_mqtt_internal_publish(AWS_IoT_Client *pClient, const
 		if(SUCCESS != rc) {
 			FUNC_EXIT_RC(rc);
 		}
+#ifdef AWS_IOT_MQTT_ENABLE_STATS
+		aws_iot_mqtt_internal_stats_record(&(pClient->clientData.stats.pubackLatency), sentUs);
+#endif
 	}
 
 	FUNC_EXIT_RC(SUCCESS);
 }
 
+/**
+ * @brief Complete an in-flight entry, with the in-flight table locked
+ *
+ * A waited entry is only marked complete, the blocking publish waiting on it releases it.
+ * Otherwise the entry is released and copied so that its completion handler can be
+ * invoked once the table is unlocked.
+ *
+ * @param pClient Reference to the IoT Client
+ * @param index Index of the entry in the in-flight table
+ * @param status Completion status
+ * @param pCompleted Output parameter, copy of the released entry
+ *
+ * @return true if a completion handler has to be invoked
+ */
+static bool _aws_iot_mqtt_internal_complete_inflight_entry(AWS_IoT_Client *pClient, uint32_t index,
+														   IoT_Error_t status, InflightPublish *pCompleted) {
+	InflightPublish *pEntry = &(pClient->clientData.inflightPublishes[index]);
+
+	aws_iot_timer_wheel_disarm(&(pClient->clientData.inflightWheel), (uint16_t) index);
+	_aws_iot_mqtt_internal_signal_inflight_table(pClient);
+
+	if(pEntry->isWaited) {
+		pEntry->isComplete = true;
+		pEntry->completeStatus = status;
+		return false;
+	}
+
+	*pCompleted = *pEntry;
+
+	/* Free the entry first so the handler can publish again */
+	pEntry->isFree = true;
+	pEntry->pCompleteHandler = NULL;
+	pEntry->pCompleteHandlerData = NULL;
+#ifdef AWS_IOT_MQTT_INFLIGHT_PACKET_LEN
+	pEntry->storedLen = 0;
+#endif
+
+	return (NULL != pCompleted->pCompleteHandler);
+}
+
+/**
+ * @brief Invoke the completion handler of a released in-flight entry from a connected state
+ *
+ * Moves the client to CLIENT_STATE_CONNECTED_WAIT_FOR_CB_RETURN for the duration of the
+ * callback, as is done for incoming messages, so that the application can publish from
+ * within the handler.
+ *
+ * @param pClient Reference to the IoT Client
+ * @param pCompleted Copy of the released entry
+ * @param status Completion status passed to the handler
+ */
+static void _aws_iot_mqtt_internal_invoke_complete_handler_cb(AWS_IoT_Client *pClient, InflightPublish *pCompleted,
+															  IoT_Error_t status) {
+	ClientState clientState;
+
+	clientState = aws_iot_mqtt_get_client_state(pClient);
+	aws_iot_mqtt_set_client_state(pClient, clientState, CLIENT_STATE_CONNECTED_WAIT_FOR_CB_RETURN);
+	pCompleted->pCompleteHandler(pClient, pCompleted->packetId, status, pCompleted->pCompleteHandlerData);
+	aws_iot_mqtt_set_client_state(pClient, CLIENT_STATE_CONNECTED_WAIT_FOR_CB_RETURN, clientState);
+}
+
+/**
+ * @brief Complete the in-flight publish matching a received PUBACK
+ *
+ * @param pClient Reference to the IoT Client
+ * @param packetId Packet identifier carried by the PUBACK
+ *
+ * @return SUCCESS if an in-flight publish matched, FAILURE otherwise
+ */
+IoT_Error_t aws_iot_mqtt_internal_complete_inflight_publish(AWS_IoT_Client *pClient, uint16_t packetId) {
+	uint32_t itr;
+	bool isHandlerDue = false;
+	IoT_Error_t rc = FAILURE;
+	InflightPublish completed;
+	InflightPublish *pEntry;
+
+	FUNC_ENTRY;
+
+	_aws_iot_mqtt_internal_lock_inflight_table(pClient);
+
+	for(itr = 0; itr < pClient->clientData.inflightPublishCount; itr++) {
+		pEntry = &(pClient->clientData.inflightPublishes[itr]);
+		if(!pEntry->isFree && !pEntry->isComplete && packetId == pEntry->packetId) {
+#ifdef AWS_IOT_MQTT_ENABLE_STATS
+			aws_iot_mqtt_internal_stats_record(&(pClient->clientData.stats.pubackLatency), pEntry->sentUs);
+#endif
+			isHandlerDue = _aws_iot_mqtt_internal_complete_inflight_entry(pClient, itr, SUCCESS, &completed);
+			rc = SUCCESS;
+			break;
+		}
+	}
+
+	_aws_iot_mqtt_internal_unlock_inflight_table(pClient);
+
+	if(isHandlerDue) {
+		_aws_iot_mqtt_internal_invoke_complete_handler_cb(pClient, &completed, SUCCESS);
+	}
+
+	FUNC_EXIT_RC(rc);
+}
+
+/**
+ * @brief Time out in-flight publishes whose PUBACK did not arrive within the command timeout
+ *
+ * Only the entries the timer wheel reports as due are visited, the table is not scanned.
+ *
+ * @param pClient Reference to the IoT Client
+ */
+void aws_iot_mqtt_internal_expire_inflight_publishes(AWS_IoT_Client *pClient) {
+	uint16_t index;
+	bool isHandlerDue;
+	InflightPublish completed;
+	InflightPublish *pEntry;
+
+	_aws_iot_mqtt_internal_lock_inflight_table(pClient);
+	aws_iot_timer_wheel_advance(&(pClient->clientData.inflightWheel));
+	index = aws_iot_timer_wheel_pop_expired(&(pClient->clientData.inflightWheel));
+
+	while(AWS_IOT_TIMER_WHEEL_INDEX_NONE != index) {
+		pEntry = &(pClient->clientData.inflightPublishes[index]);
+		isHandlerDue = false;
+		if(!pEntry->isFree && !pEntry->isComplete) {
+			IOT_WARN("PUBACK not received for packet id %u", pEntry->packetId);
+			isHandlerDue = _aws_iot_mqtt_internal_complete_inflight_entry(pClient, index, MQTT_REQUEST_TIMEOUT_ERROR,
+																		  &completed);
+		}
+
+		if(isHandlerDue) {
+			_aws_iot_mqtt_internal_unlock_inflight_table(pClient);
+			_aws_iot_mqtt_internal_invoke_complete_handler_cb(pClient, &completed, MQTT_REQUEST_TIMEOUT_ERROR);
+			_aws_iot_mqtt_internal_lock_inflight_table(pClient);
+		}
+		index = aws_iot_timer_wheel_pop_expired(&(pClient->clientData.inflightWheel));
+	}
+
+	_aws_iot_mqtt_internal_unlock_inflight_table(pClient);
+}
+
+/**
+ * @brief Time until the next in-flight publish times out
+ *
+ * @param pClient Reference to the IoT Client
+ *
+ * @return Milliseconds until aws_iot_mqtt_internal_expire_inflight_publishes has work to do,
+ * AWS_IOT_MQTT_NO_DEADLINE if no publish is in flight
+ */
+uint32_t aws_iot_mqtt_internal_inflight_deadline_ms(AWS_IoT_Client *pClient) {
+	uint32_t deadline;
+
+	_aws_iot_mqtt_internal_lock_inflight_table(pClient);
+	deadline = aws_iot_timer_wheel_next_deadline_ms(&(pClient->clientData.inflightWheel));
+	_aws_iot_mqtt_internal_unlock_inflight_table(pClient);
+
+	return deadline;
+}
+
+/**
+ * @brief Fail every in-flight publish, used when the connection is closed
+ *
+ * Publishes of a persistent session whose packet was stored are kept, they are sent
+ * again once reconnected.
+ *
+ * @param pClient Reference to the IoT Client
+ * @param status Completion status passed to the handlers
+ */
+void aws_iot_mqtt_internal_abort_inflight_publishes(AWS_IoT_Client *pClient, IoT_Error_t status) {
+	uint32_t itr;
+	bool isHandlerDue;
+	InflightPublish completed;
+	InflightPublish *pEntry;
+
+	for(itr = 0; itr < pClient->clientData.inflightPublishCount; itr++) {
+		pEntry = &(pClient->clientData.inflightPublishes[itr]);
+		isHandlerDue = false;
+
+		_aws_iot_mqtt_internal_lock_inflight_table(pClient);
+#ifdef AWS_IOT_MQTT_INFLIGHT_PACKET_LEN
+		if(!pClient->clientData.options.isCleanSession && 0 < pEntry->storedLen) {
+			_aws_iot_mqtt_internal_unlock_inflight_table(pClient);
+			continue;
+		}
+#endif
+		if(!pEntry->isFree && !pEntry->isComplete) {
+			isHandlerDue = _aws_iot_mqtt_internal_complete_inflight_entry(pClient, itr, status, &completed);
+		}
+		_aws_iot_mqtt_internal_unlock_inflight_table(pClient);
+
+		if(isHandlerDue) {
+			completed.pCompleteHandler(pClient, completed.packetId, status, completed.pCompleteHandlerData);
+		}
+	}
+}
+
+#ifdef AWS_IOT_MQTT_INFLIGHT_PACKET_LEN
+/**
+ * @brief Send the stored PUBLISH packets again after the CONNACK of a new connection
+ *
+ * Packets kept from a persistent session are resent with the DUP flag and their PUBACK
+ * timer restarts. When the new connection uses a clean session they are failed instead.
+ *
+ * @param pClient Reference to the IoT Client
+ * @param pTimer Amount of time allowed to send the packets
+ *
+ * @return IoT_Error_t of send status
+ */
+IoT_Error_t aws_iot_mqtt_internal_resend_inflight_publishes(AWS_IoT_Client *pClient, Timer *pTimer) {
+	uint32_t itr;
+	size_t len;
+	InflightPublish *pEntry;
+	IoT_Error_t rc;
+
+	FUNC_ENTRY;
+
+	if(pClient->clientData.options.isCleanSession) {
+		aws_iot_mqtt_internal_abort_inflight_publishes(pClient, NETWORK_DISCONNECTED_ERROR);
+		FUNC_EXIT_RC(SUCCESS);
+	}
+
+	rc = aws_iot_mqtt_internal_lock_write_buffer(pClient);
+	if(SUCCESS != rc) {
+		FUNC_EXIT_RC(rc);
+	}
+
+	for(itr = 0; SUCCESS == rc && itr < pClient->clientData.inflightPublishCount; itr++) {
+		pEntry = &(pClient->clientData.inflightPublishes[itr]);
+
+		_aws_iot_mqtt_internal_lock_inflight_table(pClient);
+		len = pEntry->storedLen;
+		if(0 < len) {
+			memcpy(pClient->clientData.writeBuf,
+				   pClient->clientData.inflightStore + (size_t) itr * AWS_IOT_MQTT_INFLIGHT_PACKET_LEN, len);
+#ifdef AWS_IOT_MQTT_ENABLE_STATS
+			pEntry->sentUs = timer_now_us();
+#endif
+			aws_iot_timer_wheel_arm(&(pClient->clientData.inflightWheel), (uint16_t) itr,
+									pClient->clientData.commandTimeoutMs);
+		}
+		_aws_iot_mqtt_internal_unlock_inflight_table(pClient);
+
+		if(0 < len) {
+			IOT_DEBUG("Resending PUBLISH with packet id %u", pEntry->packetId);
+			rc = aws_iot_mqtt_internal_send_packet(pClient, len, pTimer);
+		}
+	}
+
+	FUNC_EXIT_RC(aws_iot_mqtt_internal_unlock_write_buffer(pClient, rc));
+}
+#endif
+
+uint32_t aws_iot_mqtt_get_inflight_publish_count(AWS_IoT_Client *pClient) {
+	uint32_t itr, count = 0;
+
+	if(NULL == pClient) {
+		return 0;
+	}
+
+	_aws_iot_mqtt_internal_lock_inflight_table(pClient);
+	for(itr = 0; itr < pClient->clientData.inflightPublishCount; itr++) {
+		if(!pClient->clientData.inflightPublishes[itr].isFree) {
+			count++;
+		}
+	}
+	_aws_iot_mqtt_internal_unlock_inflight_table(pClient);
+
+	return count;
+}
+
+/**
+ * @brief Publish an MQTT message on a topic without waiting for the PUBACK
+ *
+ * Called to publish an MQTT message on a topic.
+ * In the case of QoS 1 an entry is reserved in the in-flight table before the message is sent,
+ * and released when the PUBACK is processed by aws_iot_mqtt_internal_cycle_read.
+ * This is the internal function which is called by the publish API to perform the operation.
+ * Not meant to be called directly as it doesn't do validations or client state changes
+ *
+ * @param pClient Reference to the IoT Client
+ * @param pTopicName Topic Name to publish to
+ * @param topicNameLen Length of the topic name
+ * @param pParams Pointer to Publish Message parameters
+ * @param pCompleteHandler Reference to the completion handler
+ * @param pCompleteHandlerData Point to data passed to the completion handler
+ *
+ * @return An IoT Error Type defining successful/failed publish
+ */
+static IoT_Error_t _aws_iot_mqtt_internal_publish_async(AWS_IoT_Client *pClient, const char *pTopicName,
+														uint16_t topicNameLen, IoT_Publish_Message_Params *pParams,
+														pPublishCompleteHandler_t pCompleteHandler,
+														void *pCompleteHandlerData) {
+	Timer timer;
+	uint32_t index = pClient->clientData.inflightPublishCount;
+	IoT_Error_t rc;
+
+	FUNC_ENTRY;
+
+	/* The payload is sent from the caller's buffer */
+	if(NULL == pParams->payload) {
+		FUNC_EXIT_RC(NULL_VALUE_ERROR);
+	}
+
+	init_timer(&timer);
+	countdown_ms(&timer, pClient->clientData.commandTimeoutMs);
+
+	/* Reserve the entry before sending so that a fast PUBACK can always be matched */
+	if(QOS1 == pParams->qos) {
+		index = _aws_iot_mqtt_internal_reserve_inflight_entry(pClient, pParams, pCompleteHandler,
+																pCompleteHandlerData, false, NULL);
+		if(pClient->clientData.inflightPublishCount == index) {
+			FUNC_EXIT_RC(MQTT_MAX_INFLIGHT_PUBLISHES_REACHED_ERROR);
+		}
+#ifdef AWS_IOT_MQTT_INFLIGHT_PACKET_LEN
+		_aws_iot_mqtt_internal_store_inflight_packet(pClient, index, pTopicName, topicNameLen, pParams);
+#endif
+	}
+
+	rc = _aws_iot_mqtt_internal_send_publish(pClient, pTopicName, topicNameLen, pParams, &timer);
+	if(SUCCESS != rc && pClient->clientData.inflightPublishCount != index) {
+		/* Not sent, the caller gets the error directly and no callback is made */
+		_aws_iot_mqtt_internal_release_inflight_entry(pClient, index);
+	}
+
+	FUNC_EXIT_RC(rc);
+}
+
+#ifdef AWS_IOT_MQTT_ENABLE_OFFLINE_QUEUE
+/**
+ * @brief Publish a message taken from the offline queue
+ *
+ * Called by the thread that yields, the queue completes QoS1 messages in its own handler.
+ *
+ * @param pClient Reference to the IoT Client
+ * @param pTopicName Topic Name to publish to
+ * @param topicNameLen Length of the topic name
+ * @param pParams Pointer to Publish Message parameters
+ * @param pCompleteHandler Reference to the completion handler
+ * @param pCompleteHandlerData Point to data passed to the completion handler
+ *
+ * @return An IoT Error Type defining successful/failed publish
+ */
+IoT_Error_t aws_iot_mqtt_internal_publish_offline_message(AWS_IoT_Client *pClient, const char *pTopicName,
+														  uint16_t topicNameLen, IoT_Publish_Message_Params *pParams,
+														  pPublishCompleteHandler_t pCompleteHandler,
+														  void *pCompleteHandlerData) {
+	return _aws_iot_mqtt_internal_publish_async(pClient, pTopicName, topicNameLen, pParams, pCompleteHandler,
+												pCompleteHandlerData);
+}
+#endif
+
 IoT_Error_t aws_iot_mqtt_publish(AWS_IoT_Client *pClient, const char *pTopicName, uint16_t topicNameLen,
 								 IoT_Publish_Message_Params *pParams) {
 	IoT_Error_t rc, pubRc;
@@ -254,10 +957,68 @@ IoT_Error_t aws_iot_mqtt_publish(AWS_IoT_Client *pClient, const char *pTopicName
 	}
 
 	if(!aws_iot_mqtt_is_client_connected(pClient)) {
+#ifdef AWS_IOT_MQTT_ENABLE_OFFLINE_QUEUE
+		FUNC_EXIT_RC(aws_iot_mqtt_internal_offline_queue_append(pClient, pTopicName, topicNameLen, pParams));
+#else
 		FUNC_EXIT_RC(NETWORK_DISCONNECTED_ERROR);
+#endif
 	}
 
 	clientState = aws_iot_mqtt_get_client_state(pClient);
+#ifdef _ENABLE_THREAD_SUPPORT_
+	if(CLIENT_STATE_CONNECTED_YIELD_IN_PROGRESS == clientState) {
+		/* The yielding thread reads for the client, publishing only takes the write side */
+		FUNC_EXIT_RC(_aws_iot_mqtt_internal_publish(pClient, pTopicName, topicNameLen, pParams, false));
+	}
+#endif
+	if(CLIENT_STATE_CONNECTED_IDLE != clientState && CLIENT_STATE_CONNECTED_WAIT_FOR_CB_RETURN != clientState) {
+		FUNC_EXIT_RC(MQTT_CLIENT_NOT_IDLE_ERROR);
+	}
+
+	rc = aws_iot_mqtt_set_client_state(pClient, clientState, CLIENT_STATE_CONNECTED_PUBLISH_IN_PROGRESS);
+	if(SUCCESS != rc) {
+		FUNC_EXIT_RC(rc);
+	}
+
+	pubRc = _aws_iot_mqtt_internal_publish(pClient, pTopicName, topicNameLen, pParams, true);
+
+	rc = aws_iot_mqtt_set_client_state(pClient, CLIENT_STATE_CONNECTED_PUBLISH_IN_PROGRESS, clientState);
+	if(SUCCESS == pubRc && SUCCESS != rc) {
+		pubRc = rc;
+	}
+
+	FUNC_EXIT_RC(pubRc);
+}
+
+IoT_Error_t aws_iot_mqtt_publish_async(AWS_IoT_Client *pClient, const char *pTopicName, uint16_t topicNameLen,
+									   IoT_Publish_Message_Params *pParams, pPublishCompleteHandler_t pCompleteHandler,
+									   void *pCompleteHandlerData) {
+	IoT_Error_t rc, pubRc;
+	ClientState clientState;
+
+	FUNC_ENTRY;
+
+	if(NULL == pClient || NULL == pTopicName || 0 == topicNameLen || NULL == pParams) {
+		FUNC_EXIT_RC(NULL_VALUE_ERROR);
+	}
+
+	if(!aws_iot_mqtt_is_client_connected(pClient)) {
+#ifdef AWS_IOT_MQTT_ENABLE_OFFLINE_QUEUE
+		/* Queued messages are sent without a completion handler */
+		FUNC_EXIT_RC(aws_iot_mqtt_internal_offline_queue_append(pClient, pTopicName, topicNameLen, pParams));
+#else
+		FUNC_EXIT_RC(NETWORK_DISCONNECTED_ERROR);
+#endif
+	}
+
+	clientState = aws_iot_mqtt_get_client_state(pClient);
+#ifdef _ENABLE_THREAD_SUPPORT_
+	if(CLIENT_STATE_CONNECTED_YIELD_IN_PROGRESS == clientState) {
+		/* The yielding thread reads for the client, publishing only takes the write side */
+		FUNC_EXIT_RC(_aws_iot_mqtt_internal_publish_async(pClient, pTopicName, topicNameLen, pParams,
+														  pCompleteHandler, pCompleteHandlerData));
+	}
+#endif
 	if(CLIENT_STATE_CONNECTED_IDLE != clientState && CLIENT_STATE_CONNECTED_WAIT_FOR_CB_RETURN != clientState) {
 		FUNC_EXIT_RC(MQTT_CLIENT_NOT_IDLE_ERROR);
 	}
@@ -267,7 +1028,8 @@ IoT_Error_t aws_iot_mqtt_publish(AWS_IoT_Client *pClient, const char *pTopicName
 		FUNC_EXIT_RC(rc);
 	}
 
-	pubRc = _aws_iot_mqtt_internal_publish(pClient, pTopicName, topicNameLen, pParams);
+	pubRc = _aws_iot_mqtt_internal_publish_async(pClient, pTopicName, topicNameLen, pParams, pCompleteHandler,
+												 pCompleteHandlerData);
 
 	rc = aws_iot_mqtt_set_client_state(pClient, CLIENT_STATE_CONNECTED_PUBLISH_IN_PROGRESS, clientState);
 	if(SUCCESS == pubRc && SUCCESS != rc) {
@@ -0,0 +1,94 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file aws_iot_mqtt_client_reconnect_policy.c
+ * @brief MQTT client reconnect policies
+ *
+ * Decide how long the client waits before each automatic reconnect attempt. They only read
+ * the reconnect bounds of the client, so they can be replaced by the application.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "aws_iot_mqtt_client_common_internal.h"
+
+/* xorshift32, seeded on first use */
+static uint32_t _aws_iot_mqtt_reconnect_jitter_random(AWS_IoT_Client *pClient) {
+	uint32_t x = pClient->clientData.reconnectJitterState;
+	uint16_t itr;
+
+	if(0 == x) {
+		/* Devices running the same firmware lay out their clients alike, the client ID tells them apart */
+		x = 2166136261u ^ (uint32_t) (uintptr_t) pClient;
+		for(itr = 0; NULL != pClient->clientData.options.pClientID && itr < pClient->clientData.options.clientIDLen;
+			itr++) {
+			x = (x ^ (uint8_t) pClient->clientData.options.pClientID[itr]) * 16777619u;
+		}
+		if(0 == x) {
+			x = 1;
+		}
+	}
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	pClient->clientData.reconnectJitterState = x;
+
+	return x;
+}
+
+uint32_t aws_iot_mqtt_reconnect_policy_decorrelated_jitter(AWS_IoT_Client *pClient, uint32_t attempt,
+														   uint32_t previousWait_ms) {
+	uint32_t minWait = pClient->clientData.minReconnectWaitMs;
+	uint32_t maxWait = pClient->clientData.maxReconnectWaitMs;
+	uint32_t upper, range;
+
+	if(1 >= attempt) {
+		return 0;
+	}
+	if(minWait >= maxWait) {
+		return maxWait;
+	}
+
+	if(previousWait_ms < minWait) {
+		previousWait_ms = minWait;
+	}
+	upper = (previousWait_ms > maxWait / 3) ? maxWait : previousWait_ms * 3;
+	range = upper - minWait;
+
+	if(UINT32_MAX == range) {
+		return _aws_iot_mqtt_reconnect_jitter_random(pClient);
+	}
+	return minWait + _aws_iot_mqtt_reconnect_jitter_random(pClient) % (range + 1);
+}
+
+uint32_t aws_iot_mqtt_reconnect_policy_exponential(AWS_IoT_Client *pClient, uint32_t attempt,
+												   uint32_t previousWait_ms) {
+	if(1 >= attempt) {
+		return pClient->clientData.minReconnectWaitMs;
+	}
+	if(previousWait_ms > pClient->clientData.maxReconnectWaitMs / 2) {
+		return AWS_IOT_MQTT_RECONNECT_GIVE_UP;
+	}
+
+	return previousWait_ms * 2;
+}
+
+#ifdef __cplusplus
+}
+#endif
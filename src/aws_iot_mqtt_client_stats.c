@@ -0,0 +1,138 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file aws_iot_mqtt_client_stats.c
+ * @brief MQTT client statistics
+ *
+ * Counts the packets and bytes sent and received by a client per packet type, and keeps
+ * histograms of the acknowledgment latencies and of the time spent in message handlers, and
+ * the share of the time in aws_iot_mqtt_yield that is not spent waiting for the network.
+ * Counters are updated by whichever thread holds the matching buffer, they are not locked.
+ * Only built when AWS_IOT_MQTT_ENABLE_STATS is defined in aws_iot_config.h.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <string.h>
+
+#include "aws_iot_mqtt_client_common_internal.h"
+
+#ifdef AWS_IOT_MQTT_ENABLE_STATS
+
+/**
+ * @brief Count the packets sent from a buffer
+ *
+ * The buffer may hold several packets sent with one write, as the outbound queue does.
+ * A packet whose payload was sent from outside of the buffer is counted in full from its
+ * fixed header.
+ *
+ * @param pClient MQTT client
+ * @param pPackets Serialized packets, starting with a fixed header
+ * @param length Number of bytes sent
+ */
+void aws_iot_mqtt_internal_stats_count_sent(AWS_IoT_Client *pClient, const unsigned char *pPackets, size_t length) {
+	IoT_Client_Stats *pStats = &(pClient->clientData.stats);
+	uint32_t remLen, remLenBytes;
+	size_t packetLen, offset = 0;
+	unsigned char type;
+
+	while(offset < length) {
+		type = (unsigned char) MQTT_HEADER_FIELD_TYPE(pPackets[offset]);
+		packetLen = length - offset;
+		if(packetLen > 1 && SUCCESS == aws_iot_mqtt_internal_decode_remaining_length_from_buffer(
+				(unsigned char *) &pPackets[offset + 1], &remLen, &remLenBytes)
+		   && 1 + remLenBytes + (size_t) remLen < packetLen) {
+			packetLen = 1 + remLenBytes + (size_t) remLen;
+		}
+
+		pStats->packetsOut[type]++;
+		pStats->bytesOut[type] += packetLen;
+		offset += packetLen;
+	}
+}
+
+/**
+ * @brief Count a received packet
+ *
+ * @param pClient MQTT client
+ * @param headerByte First byte of the fixed header of the packet
+ * @param length Length of the packet, fixed header included
+ */
+void aws_iot_mqtt_internal_stats_count_received(AWS_IoT_Client *pClient, unsigned char headerByte, size_t length) {
+	unsigned char type = (unsigned char) MQTT_HEADER_FIELD_TYPE(headerByte);
+
+	pClient->clientData.stats.packetsIn[type]++;
+	pClient->clientData.stats.bytesIn[type] += length;
+}
+
+/**
+ * @brief Add the time elapsed since a reading of timer_now_us to a histogram
+ *
+ * @param pHistogram Histogram to update
+ * @param startUs Reading of timer_now_us at the start of the measured duration
+ */
+void aws_iot_mqtt_internal_stats_record(IoT_Latency_Histogram *pHistogram, uint32_t startUs) {
+	uint32_t elapsedUs = timer_now_us() - startUs;
+	uint32_t bucket = 0;
+
+	/* The bucket is the number of significant bits of the duration */
+	while(bucket < AWS_IOT_MQTT_STATS_HISTOGRAM_BUCKETS - 1 && 0 != (elapsedUs >> bucket)) {
+		bucket++;
+	}
+
+	pHistogram->buckets[bucket]++;
+	pHistogram->count++;
+	pHistogram->totalUs += elapsedUs;
+	if(elapsedUs > pHistogram->maxUs) {
+		pHistogram->maxUs = elapsedUs;
+	}
+}
+
+/**
+ * @brief Add a call of aws_iot_mqtt_yield to the duty cycle
+ *
+ * @param pClient MQTT client
+ * @param startUs Reading of timer_now_us when the call started
+ * @param idleUs Part of the call spent waiting for the network, in microseconds
+ */
+void aws_iot_mqtt_internal_stats_record_yield(AWS_IoT_Client *pClient, uint32_t startUs, uint32_t idleUs) {
+	IoT_Client_Stats *pStats = &(pClient->clientData.stats);
+	uint32_t elapsedUs = timer_now_us() - startUs;
+
+	pStats->yieldCount++;
+	pStats->yieldWallUs += elapsedUs;
+	pStats->yieldBusyUs += (idleUs < elapsedUs) ? (elapsedUs - idleUs) : 0;
+}
+
+IoT_Error_t aws_iot_mqtt_get_stats(AWS_IoT_Client *pClient, IoT_Client_Stats *pStats) {
+	FUNC_ENTRY;
+
+	if(NULL == pClient || NULL == pStats) {
+		FUNC_EXIT_RC(NULL_VALUE_ERROR);
+	}
+
+	memcpy(pStats, &(pClient->clientData.stats), sizeof(IoT_Client_Stats));
+
+	FUNC_EXIT_RC(SUCCESS);
+}
+
+#endif /* AWS_IOT_MQTT_ENABLE_STATS */
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,264 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file aws_iot_mqtt_client_storage.c
+ * @brief MQTT client buffers and tables
+ *
+ * Sizes the data buffers, the subscription tables, the in-flight publishes and the outbound
+ * queue of a client from its initialization parameters. They are either the arrays embedded in
+ * the client, or one block taken from the allocator of the application, for instance an arena
+ * shared by many clients.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "aws_iot_mqtt_client_common_internal.h"
+
+/** Sizes of the storage of a client, once the 0 values of the initialization parameters are resolved */
+typedef struct {
+	size_t txBufLen;
+	size_t rxBufLen;
+	uint16_t handlerCount;
+	uint16_t trieNodeCount;
+	uint16_t inflightCount;
+	uint32_t outboundSlotCount;
+} ClientStorageSizes;
+
+static size_t _aws_iot_mqtt_storage_align(size_t size) {
+	return (size + AWS_IOT_MQTT_STORAGE_ALIGNMENT - 1) & ~((size_t) AWS_IOT_MQTT_STORAGE_ALIGNMENT - 1);
+}
+
+/**
+ * @brief Resolve the sizes of the storage of a client
+ *
+ * The number of message handlers can only be lowered, the per-call lists of the subscribe
+ * functions and of the message dispatch are on the stack, sized for AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS.
+ *
+ * @return false if a size is out of range
+ */
+static bool _aws_iot_mqtt_storage_resolve(const IoT_Client_Init_Params *pInitParams, ClientStorageSizes *pSizes) {
+	pSizes->txBufLen = (0 != pInitParams->txBufLen) ? pInitParams->txBufLen : AWS_IOT_MQTT_TX_BUF_LEN;
+	pSizes->rxBufLen = (0 != pInitParams->rxBufLen) ? pInitParams->rxBufLen : AWS_IOT_MQTT_RX_BUF_LEN;
+	pSizes->handlerCount = (0 != pInitParams->subscribeHandlerCount) ? pInitParams->subscribeHandlerCount
+																	  : AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS;
+	pSizes->inflightCount = (0 != pInitParams->inflightPublishCount) ? pInitParams->inflightPublishCount
+																	  : AWS_IOT_MQTT_MAX_INFLIGHT_PUBLISHES;
+#ifdef AWS_IOT_MQTT_OUTBOUND_QUEUE_SLOTS
+	pSizes->outboundSlotCount = (0 != pInitParams->outboundQueueSlotCount) ? pInitParams->outboundQueueSlotCount
+																			: AWS_IOT_MQTT_OUTBOUND_QUEUE_SLOTS;
+#else
+	pSizes->outboundSlotCount = 0;
+#endif
+
+	/* Same number of nodes per message handler as the embedded arrays, rounded up */
+	pSizes->trieNodeCount = (uint16_t) ((pSizes->handlerCount * AWS_IOT_MQTT_NUM_TOPIC_TRIE_NODES
+										 + AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS - 1)
+										/ AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS);
+
+	if(AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS < pSizes->handlerCount
+	   || AWS_IOT_TIMER_WHEEL_INDEX_NONE == pSizes->inflightCount
+	   || 0 != (pSizes->outboundSlotCount & (pSizes->outboundSlotCount - 1))) {
+		return false;
+	}
+
+	return true;
+}
+
+size_t aws_iot_mqtt_get_storage_size(const IoT_Client_Init_Params *pInitParams) {
+	ClientStorageSizes sizes;
+
+	if(NULL == pInitParams || !_aws_iot_mqtt_storage_resolve(pInitParams, &sizes)) {
+		return 0;
+	}
+
+	/* The tables come first, the buffers have no alignment requirement */
+	return _aws_iot_mqtt_storage_align(sizes.handlerCount * sizeof(MessageHandlers))
+		   + _aws_iot_mqtt_storage_align(sizes.trieNodeCount * sizeof(TopicTrieNode))
+		   + _aws_iot_mqtt_storage_align(sizes.inflightCount * sizeof(InflightPublish))
+		   + _aws_iot_mqtt_storage_align(sizes.inflightCount * sizeof(TimerWheelEntry))
+#ifdef AWS_IOT_MQTT_OUTBOUND_QUEUE_SLOTS
+		   + _aws_iot_mqtt_storage_align(sizes.outboundSlotCount * sizeof(OutboundSlot))
+#endif
+#ifdef AWS_IOT_MQTT_INFLIGHT_PACKET_LEN
+		   + _aws_iot_mqtt_storage_align((size_t) sizes.inflightCount * AWS_IOT_MQTT_INFLIGHT_PACKET_LEN)
+#endif
+		   + _aws_iot_mqtt_storage_align(sizes.txBufLen) + sizes.rxBufLen;
+}
+
+void aws_iot_mqtt_arena_init(IoT_Client_Arena *pArena, void *pBuffer, size_t size) {
+	if(NULL == pArena) {
+		return;
+	}
+
+	pArena->pBase = (unsigned char *) pBuffer;
+	pArena->size = (NULL != pBuffer) ? size : 0;
+	pArena->used = 0;
+}
+
+void *aws_iot_mqtt_arena_allocate(void *pArena, size_t size) {
+	IoT_Client_Arena *pClientArena = (IoT_Client_Arena *) pArena;
+	size_t start;
+
+	if(NULL == pClientArena || NULL == pClientArena->pBase) {
+		return NULL;
+	}
+
+	/* Align the address rather than the offset, the region itself may not be aligned */
+	start = _aws_iot_mqtt_storage_align((size_t) (uintptr_t) (pClientArena->pBase + pClientArena->used))
+			- (size_t) (uintptr_t) pClientArena->pBase;
+	if(start > pClientArena->size || size > pClientArena->size - start) {
+		return NULL;
+	}
+
+	pClientArena->used = start + size;
+	return pClientArena->pBase + start;
+}
+
+/**
+ * @brief Set up the buffers and tables of a client
+ *
+ * Sizes left at 0 in the initialization parameters take the values of aws_iot_config.h.
+ * Without an allocator, the embedded arrays are used and no size can be larger than
+ * configured in aws_iot_config.h.
+ *
+ * @param pClient Reference to the IoT Client
+ * @param pInitParams Initialization parameters of the client
+ *
+ * @return An IoT Error Type defining successful/failed setup
+ */
+IoT_Error_t aws_iot_mqtt_internal_storage_init(AWS_IoT_Client *pClient, IoT_Client_Init_Params *pInitParams) {
+	ClientData *pData = &(pClient->clientData);
+	ClientStorageSizes sizes;
+	unsigned char *pBlock;
+
+	FUNC_ENTRY;
+
+	pData->pStorage = NULL;
+	if(!_aws_iot_mqtt_storage_resolve(pInitParams, &sizes)) {
+		FUNC_EXIT_RC(MAX_SIZE_ERROR);
+	}
+
+	if(NULL == pInitParams->pStorageAllocator) {
+#ifdef AWS_IOT_MQTT_DISABLE_EMBEDDED_STORAGE
+		FUNC_EXIT_RC(NULL_VALUE_ERROR);
+#else
+		if(AWS_IOT_MQTT_TX_BUF_LEN < sizes.txBufLen || AWS_IOT_MQTT_RX_BUF_LEN < sizes.rxBufLen
+		   || AWS_IOT_MQTT_MAX_INFLIGHT_PUBLISHES < sizes.inflightCount) {
+			FUNC_EXIT_RC(MAX_SIZE_ERROR);
+		}
+		pData->messageHandlers = pData->embeddedMessageHandlers;
+		pData->topicTrie = pData->embeddedTopicTrie;
+		pData->inflightPublishes = pData->embeddedInflightPublishes;
+		pData->inflightWheelEntries = pData->embeddedInflightWheelEntries;
+#ifdef AWS_IOT_MQTT_OUTBOUND_QUEUE_SLOTS
+		if(AWS_IOT_MQTT_OUTBOUND_QUEUE_SLOTS < sizes.outboundSlotCount) {
+			FUNC_EXIT_RC(MAX_SIZE_ERROR);
+		}
+		pData->outboundQueue.slots = pData->embeddedOutboundSlots;
+#endif
+#ifdef AWS_IOT_MQTT_INFLIGHT_PACKET_LEN
+		pData->inflightStore = pData->embeddedInflightStore;
+#endif
+		pData->writeBuf = pData->embeddedWriteBuf;
+		pData->readBuf = pData->embeddedReadBuf;
+#endif
+	} else {
+		if(NULL == pInitParams->pStorageAllocator->allocate) {
+			FUNC_EXIT_RC(NULL_VALUE_ERROR);
+		}
+		pData->storageAllocator = *(pInitParams->pStorageAllocator);
+		pBlock = (unsigned char *) pData->storageAllocator.allocate(pData->storageAllocator.pContext,
+				aws_iot_mqtt_get_storage_size(pInitParams));
+		if(NULL == pBlock) {
+			FUNC_EXIT_RC(MQTT_STORAGE_ALLOCATION_ERROR);
+		}
+
+		pData->pStorage = pBlock;
+		pData->messageHandlers = (MessageHandlers *) pBlock;
+		pBlock += _aws_iot_mqtt_storage_align(sizes.handlerCount * sizeof(MessageHandlers));
+		pData->topicTrie = (TopicTrieNode *) pBlock;
+		pBlock += _aws_iot_mqtt_storage_align(sizes.trieNodeCount * sizeof(TopicTrieNode));
+		pData->inflightPublishes = (InflightPublish *) pBlock;
+		pBlock += _aws_iot_mqtt_storage_align(sizes.inflightCount * sizeof(InflightPublish));
+		pData->inflightWheelEntries = (TimerWheelEntry *) pBlock;
+		pBlock += _aws_iot_mqtt_storage_align(sizes.inflightCount * sizeof(TimerWheelEntry));
+#ifdef AWS_IOT_MQTT_OUTBOUND_QUEUE_SLOTS
+		pData->outboundQueue.slots = (OutboundSlot *) pBlock;
+		pBlock += _aws_iot_mqtt_storage_align(sizes.outboundSlotCount * sizeof(OutboundSlot));
+#endif
+#ifdef AWS_IOT_MQTT_INFLIGHT_PACKET_LEN
+		pData->inflightStore = pBlock;
+		pBlock += _aws_iot_mqtt_storage_align((size_t) sizes.inflightCount * AWS_IOT_MQTT_INFLIGHT_PACKET_LEN);
+#endif
+		pData->writeBuf = pBlock;
+		pData->readBuf = pBlock + _aws_iot_mqtt_storage_align(sizes.txBufLen);
+	}
+
+	pData->messageHandlerCount = sizes.handlerCount;
+	pData->topicTrieNodeCount = sizes.trieNodeCount;
+	pData->inflightPublishCount = sizes.inflightCount;
+#ifdef AWS_IOT_MQTT_OUTBOUND_QUEUE_SLOTS
+	pData->outboundQueue.slotCount = sizes.outboundSlotCount;
+#endif
+	pData->writeBufSize = sizes.txBufLen;
+	pData->readBufSize = sizes.rxBufLen;
+
+	FUNC_EXIT_RC(SUCCESS);
+}
+
+/**
+ * @brief Give the storage block of a client back to its allocator
+ *
+ * Does nothing for a client using the embedded arrays.
+ *
+ * @param pClient Reference to the IoT Client
+ */
+void aws_iot_mqtt_internal_storage_free(AWS_IoT_Client *pClient) {
+	ClientData *pData = &(pClient->clientData);
+
+	if(NULL == pData->pStorage) {
+		return;
+	}
+
+	if(NULL != pData->storageAllocator.release) {
+		pData->storageAllocator.release(pData->storageAllocator.pContext, pData->pStorage);
+	}
+	pData->pStorage = NULL;
+	pData->messageHandlers = NULL;
+	pData->topicTrie = NULL;
+	pData->inflightPublishes = NULL;
+	pData->inflightWheelEntries = NULL;
+#ifdef AWS_IOT_MQTT_OUTBOUND_QUEUE_SLOTS
+	pData->outboundQueue.slots = NULL;
+	pData->outboundQueue.slotCount = 0;
+#endif
+#ifdef AWS_IOT_MQTT_INFLIGHT_PACKET_LEN
+	pData->inflightStore = NULL;
+#endif
+	pData->writeBuf = NULL;
+	pData->readBuf = NULL;
+	pData->messageHandlerCount = 0;
+	pData->topicTrieNodeCount = 0;
+	pData->inflightPublishCount = 0;
+	pData->writeBufSize = 0;
+	pData->readBufSize = 0;
+}
+
+#ifdef __cplusplus
+}
+#endif
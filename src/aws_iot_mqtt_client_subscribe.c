@@ -41,6 +41,12 @@ extern "C" {
 
 #include "aws_iot_mqtt_client_common_internal.h"
 
+/** Return code of a SUBACK for a topic the server refused. MQTT3.1.1 specification 3.9.3 */
+#define SUBACK_FAILURE_RETURN_CODE 0x80
+
+/** Number of bytes a topic filter adds to a SUBSCRIBE packet: length, topic and requested QoS */
+#define SUBSCRIBE_TOPIC_ENTRY_LEN(topicNameLen) ((uint32_t) (topicNameLen) + 2 + 1)
+
 /**
   * Serializes the supplied subscribe data into the supplied buffer, ready for sending
   * @param pTxBuf the buffer into which the packet will be serialized
@@ -160,7 +166,7 @@ static IoT_Error_t _aws_iot_mqtt_deserialize_suback(uint16_t *pPacketId, uint32_
 
 	*pGrantedQoSCount = 0;
 	while(curData < endData) {
-		if(*pGrantedQoSCount > maxExpectedQoSCount) {
+		if(*pGrantedQoSCount >= maxExpectedQoSCount) {
 			FUNC_EXIT_RC(FAILURE);
 		}
 		pGrantedQoSs[(*pGrantedQoSCount)++] = (QoS) aws_iot_mqtt_internal_read_char(&curData);
@@ -169,13 +175,13 @@ static IoT_Error_t _aws_iot_mqtt_deserialize_suback(uint16_t *pPacketId, uint32_
 	FUNC_EXIT_RC(SUCCESS);
 }
 
-/* Returns MAX_MESSAGE_HANDLERS value if no free index is available */
+/* Returns the number of message handlers if no free index is available */
 static uint32_t _aws_iot_mqtt_get_free_message_handler_index(AWS_IoT_Client *pClient) {
 	uint32_t itr;
 
 	FUNC_ENTRY;
 
-	for(itr = 0; itr < AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS; itr++) {
+	for(itr = 0; itr < pClient->clientData.messageHandlerCount; itr++) {
 		if(pClient->clientData.messageHandlers[itr].topicName == NULL) {
 			break;
 		}
@@ -185,34 +191,38 @@ static uint32_t _aws_iot_mqtt_get_free_message_handler_index(AWS_IoT_Client *pCl
 }
 
 /**
- * @brief Subscribe to an MQTT topic.
+ * @brief Remove a subscription from the message handlers
  *
- * Called to send a subscribe message to the broker requesting a subscription
- * to an MQTT topic. This is the internal function which is called by the
- * subscribe API to perform the operation. Not meant to be called directly as
- * it doesn't do validations or client state changes
- * @note Call is blocking.  The call returns after the receipt of the SUBACK control packet.
- * @warning pTopicName and pApplicationHandlerData need to be static in memory.
+ * @param pClient Reference to the IoT Client
+ * @param handlerIndex Index of the message handler of the subscription
+ */
+static void _aws_iot_mqtt_release_message_handler(AWS_IoT_Client *pClient, uint32_t handlerIndex) {
+	aws_iot_mqtt_internal_topic_trie_remove(pClient, handlerIndex);
+	pClient->clientData.messageHandlers[handlerIndex].topicName = NULL;
+}
+
+/**
+ * @brief Send a SUBSCRIBE packet for a list of topics and wait for its SUBACK
  *
  * @param pClient Reference to the IoT Client
- * @param pTopicName Topic Name to publish to. pTopicName needs to be static in memory since
- *     no malloc are performed by the SDK
- * @param topicNameLen Length of the topic name
- * @param pApplicationHandler_t Reference to the handler function for this subscription
- * @param pApplicationHandlerData Point to data passed to the callback.
- *    pApplicationHandlerData also needs to be static in memory  since no malloc are performed by the SDK
+ * @param topicCount Number of topics in the lists
+ * @param pTopicNameList Array of topic filters
+ * @param pTopicNameLenList Array of lengths of the topic filters
+ * @param pRequestedQoSs Array of requested QoS
+ * @param pGrantedQoSs Array of topicCount entries receiving the return codes of the SUBACK
  *
- * @return An IoT Error Type defining successful/failed subscription
+ * @return An IoT Error Type defining successful/failed operation
  */
-static IoT_Error_t _aws_iot_mqtt_internal_subscribe(AWS_IoT_Client *pClient, const char *pTopicName,
-													uint16_t topicNameLen, QoS qos,
-													pApplicationHandler_t pApplicationHandler,
-													void *pApplicationHandlerData) {
-	uint16_t txPacketId, rxPacketId;
-	uint32_t serializedLen, indexOfFreeMessageHandler, count;
+static IoT_Error_t _aws_iot_mqtt_internal_send_subscribe(AWS_IoT_Client *pClient, uint32_t topicCount,
+														 const char **pTopicNameList, uint16_t *pTopicNameLenList,
+														 QoS *pRequestedQoSs, QoS *pGrantedQoSs) {
+	uint16_t rxPacketId;
+	uint32_t serializedLen, count;
 	IoT_Error_t rc;
 	Timer timer;
-	QoS grantedQoS[3] = {QOS0, QOS0, QOS0};
+#ifdef AWS_IOT_MQTT_ENABLE_STATS
+	uint32_t sentUs;
+#endif
 
 	FUNC_ENTRY;
 	init_timer(&timer);
@@ -220,22 +230,25 @@ static IoT_Error_t _aws_iot_mqtt_internal_subscribe(AWS_IoT_Client *pClient, con
 
 	serializedLen = 0;
 	count = 0;
-	txPacketId = aws_iot_mqtt_get_next_packet_id(pClient);
 	rxPacketId = 0;
 
-	rc = _aws_iot_mqtt_serialize_subscribe(pClient->clientData.writeBuf, pClient->clientData.writeBufSize, 0,
-										   txPacketId, 1, &pTopicName, &topicNameLen, &qos, &serializedLen);
+	rc = aws_iot_mqtt_internal_lock_write_buffer(pClient);
 	if(SUCCESS != rc) {
 		FUNC_EXIT_RC(rc);
 	}
 
-	indexOfFreeMessageHandler = _aws_iot_mqtt_get_free_message_handler_index(pClient);
-	if(AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS <= indexOfFreeMessageHandler) {
-		FUNC_EXIT_RC(MQTT_MAX_SUBSCRIPTIONS_REACHED_ERROR);
+#ifdef AWS_IOT_MQTT_ENABLE_STATS
+	sentUs = timer_now_us();
+#endif
+	rc = _aws_iot_mqtt_serialize_subscribe(pClient->clientData.writeBuf, pClient->clientData.writeBufSize, 0,
+										   aws_iot_mqtt_get_next_packet_id(pClient), topicCount, pTopicNameList,
+										   pTopicNameLenList, pRequestedQoSs, &serializedLen);
+	if(SUCCESS == rc) {
+		/* send the subscribe packet */
+		rc = aws_iot_mqtt_internal_send_packet(pClient, serializedLen, &timer);
 	}
 
-	/* send the subscribe packet */
-	rc = aws_iot_mqtt_internal_send_packet(pClient, serializedLen, &timer);
+	rc = aws_iot_mqtt_internal_unlock_write_buffer(pClient, rc);
 	if(SUCCESS != rc) {
 		FUNC_EXIT_RC(rc);
 	}
@@ -245,14 +258,22 @@ static IoT_Error_t _aws_iot_mqtt_internal_subscribe(AWS_IoT_Client *pClient, con
 	if(SUCCESS != rc) {
 		FUNC_EXIT_RC(rc);
 	}
+#ifdef AWS_IOT_MQTT_ENABLE_STATS
+	aws_iot_mqtt_internal_stats_record(&(pClient->clientData.stats.subackLatency), sentUs);
+#endif
 
-	/* Granted QoS can be 0, 1 or 2 */
-	rc = _aws_iot_mqtt_deserialize_suback(&rxPacketId, 1, &count, grantedQoS, pClient->clientData.readBuf,
+	/* Granted QoS can be 0, 1 or 2, or SUBACK_FAILURE_RETURN_CODE */
+	rc = _aws_iot_mqtt_deserialize_suback(&rxPacketId, topicCount, &count, pGrantedQoSs, pClient->clientData.readBuf,
 										  pClient->clientData.readBufSize);
 	if(SUCCESS != rc) {
 		FUNC_EXIT_RC(rc);
 	}
 
+	/* The SUBACK has one return code for each topic of the SUBSCRIBE, in the same order */
+	if(topicCount != count) {
+		FUNC_EXIT_RC(FAILURE);
+	}
+
 	/* TODO : Figure out how to test this before activating this check */
 	//if(txPacketId != rxPacketId) {
 	/* Different SUBACK received than expected. Return error
@@ -260,27 +281,104 @@ static IoT_Error_t _aws_iot_mqtt_internal_subscribe(AWS_IoT_Client *pClient, con
 	//	return RX_MESSAGE_INVALID_ERROR;
 	//}
 
+	FUNC_EXIT_RC(SUCCESS);
+}
+
+/**
+ * @brief Subscribe to an MQTT topic.
+ *
+ * Called to send a subscribe message to the broker requesting a subscription
+ * to an MQTT topic. This is the internal function which is called by the
+ * subscribe API to perform the operation. Not meant to be called directly as
+ * it doesn't do validations or client state changes
+ * @note Call is blocking.  The call returns after the receipt of the SUBACK control packet.
+ * @warning pTopicName and pApplicationHandlerData need to be static in memory.
+ *
+ * @param pClient Reference to the IoT Client
+ * @param pTopicName Topic Name to publish to. pTopicName needs to be static in memory since
+ *     no malloc are performed by the SDK
+ * @param topicNameLen Length of the topic name
+ * @param pApplicationHandler_t Reference to the handler function for this subscription
+ * @param pApplicationFragmentHandler Reference to the fragment handler function for a streaming subscription
+ * @param pApplicationHandlerData Point to data passed to the callback.
+ *    pApplicationHandlerData also needs to be static in memory  since no malloc are performed by the SDK
+ *
+ * @return An IoT Error Type defining successful/failed subscription
+ */
+static IoT_Error_t _aws_iot_mqtt_internal_subscribe(AWS_IoT_Client *pClient, const char *pTopicName,
+													uint16_t topicNameLen, QoS qos,
+													pApplicationHandler_t pApplicationHandler,
+													pApplicationFragmentHandler_t pApplicationFragmentHandler,
+													void *pApplicationHandlerData) {
+	uint32_t indexOfFreeMessageHandler;
+	IoT_Error_t rc;
+	QoS grantedQoS = QOS0;
+
+	FUNC_ENTRY;
+
+	indexOfFreeMessageHandler = _aws_iot_mqtt_get_free_message_handler_index(pClient);
+	if(pClient->clientData.messageHandlerCount <= indexOfFreeMessageHandler
+	   || !aws_iot_mqtt_internal_topic_trie_has_room(pClient, pTopicName, topicNameLen)) {
+		FUNC_EXIT_RC(MQTT_MAX_SUBSCRIPTIONS_REACHED_ERROR);
+	}
+
+	rc = _aws_iot_mqtt_internal_send_subscribe(pClient, 1, &pTopicName, &topicNameLen, &qos, &grantedQoS);
+	if(SUCCESS != rc) {
+		FUNC_EXIT_RC(rc);
+	}
+
+	/* Refused by the broker, no message would reach the handler */
+	if(SUBACK_FAILURE_RETURN_CODE == (uint8_t) grantedQoS) {
+		FUNC_EXIT_RC(MQTT_SUBSCRIBE_REJECTED_ERROR);
+	}
+
 	pClient->clientData.messageHandlers[indexOfFreeMessageHandler].topicName =
 			pTopicName;
 	pClient->clientData.messageHandlers[indexOfFreeMessageHandler].topicNameLen =
 			topicNameLen;
 	pClient->clientData.messageHandlers[indexOfFreeMessageHandler].pApplicationHandler =
 			pApplicationHandler;
+	pClient->clientData.messageHandlers[indexOfFreeMessageHandler].pApplicationFragmentHandler =
+			pApplicationFragmentHandler;
 	pClient->clientData.messageHandlers[indexOfFreeMessageHandler].pApplicationHandlerData =
 			pApplicationHandlerData;
 	pClient->clientData.messageHandlers[indexOfFreeMessageHandler].qos = qos;
 
-	FUNC_EXIT_RC(SUCCESS);
+	/* Room was checked before sending, nothing else can subscribe while waiting for the SUBACK */
+	rc = aws_iot_mqtt_internal_topic_trie_insert(pClient, indexOfFreeMessageHandler);
+	if(SUCCESS != rc) {
+		pClient->clientData.messageHandlers[indexOfFreeMessageHandler].topicName = NULL;
+	}
+
+	FUNC_EXIT_RC(rc);
 }
 
-IoT_Error_t aws_iot_mqtt_subscribe(AWS_IoT_Client *pClient, const char *pTopicName, uint16_t topicNameLen,
-								   QoS qos, pApplicationHandler_t pApplicationHandler, void *pApplicationHandlerData) {
+/**
+ * @brief Validate the client state and subscribe with the given handlers
+ *
+ * Common part of the subscribe APIs. Exactly one of the two handlers is expected to be set.
+ *
+ * @param pClient Reference to the IoT Client
+ * @param pTopicName Topic Name to subscribe to
+ * @param topicNameLen Length of the topic name
+ * @param qos Quality of service for subscription
+ * @param pApplicationHandler Reference to the handler function for this subscription
+ * @param pApplicationFragmentHandler Reference to the fragment handler function for a streaming subscription
+ * @param pApplicationHandlerData Point to data passed to the callback
+ *
+ * @return An IoT Error Type defining successful/failed subscription
+ */
+static IoT_Error_t _aws_iot_mqtt_subscribe_with_handler(AWS_IoT_Client *pClient, const char *pTopicName,
+														uint16_t topicNameLen, QoS qos,
+														pApplicationHandler_t pApplicationHandler,
+														pApplicationFragmentHandler_t pApplicationFragmentHandler,
+														void *pApplicationHandlerData) {
 	ClientState clientState;
 	IoT_Error_t rc, subRc;
 
 	FUNC_ENTRY;
 
-	if(NULL == pClient || NULL == pTopicName || NULL == pApplicationHandler) {
+	if(NULL == pClient || NULL == pTopicName || (NULL == pApplicationHandler && NULL == pApplicationFragmentHandler)) {
 		FUNC_EXIT_RC(NULL_VALUE_ERROR);
 	}
 
@@ -299,7 +397,8 @@ IoT_Error_t aws_iot_mqtt_subscribe(AWS_IoT_Client *pClient, const char *pTopicNa
 	}
 
 	subRc = _aws_iot_mqtt_internal_subscribe(pClient, pTopicName, topicNameLen, qos,
-											 pApplicationHandler, pApplicationHandlerData);
+											 pApplicationHandler, pApplicationFragmentHandler,
+											 pApplicationHandlerData);
 
 	rc = aws_iot_mqtt_set_client_state(pClient, CLIENT_STATE_CONNECTED_SUBSCRIBE_IN_PROGRESS, clientState);
 	if(SUCCESS == subRc && SUCCESS != rc) {
@@ -309,81 +408,278 @@ IoT_Error_t aws_iot_mqtt_subscribe(AWS_IoT_Client *pClient, const char *pTopicNa
 	FUNC_EXIT_RC(subRc);
 }
 
+IoT_Error_t aws_iot_mqtt_subscribe(AWS_IoT_Client *pClient, const char *pTopicName, uint16_t topicNameLen,
+								   QoS qos, pApplicationHandler_t pApplicationHandler, void *pApplicationHandlerData) {
+	IoT_Error_t rc;
+
+	FUNC_ENTRY;
+
+	if(NULL == pApplicationHandler) {
+		FUNC_EXIT_RC(NULL_VALUE_ERROR);
+	}
+
+	rc = _aws_iot_mqtt_subscribe_with_handler(pClient, pTopicName, topicNameLen, qos, pApplicationHandler, NULL,
+											  pApplicationHandlerData);
+
+	FUNC_EXIT_RC(rc);
+}
+
+IoT_Error_t aws_iot_mqtt_subscribe_streaming(AWS_IoT_Client *pClient, const char *pTopicName, uint16_t topicNameLen,
+											 QoS qos, pApplicationFragmentHandler_t pApplicationFragmentHandler,
+											 void *pApplicationHandlerData) {
+	IoT_Error_t rc;
+
+	FUNC_ENTRY;
+
+	if(NULL == pApplicationFragmentHandler) {
+		FUNC_EXIT_RC(NULL_VALUE_ERROR);
+	}
+
+	rc = _aws_iot_mqtt_subscribe_with_handler(pClient, pTopicName, topicNameLen, qos, NULL,
+											  pApplicationFragmentHandler, pApplicationHandlerData);
+
+	FUNC_EXIT_RC(rc);
+}
+
 /**
- * @brief Subscribe to an MQTT topic.
+ * @brief Subscribe to a list of MQTT topics.
  *
- * Called to send a subscribe message to the broker requesting a subscription
- * to an MQTT topic.
- * This is the internal function which is called by the resubscribe API to perform the operation.
+ * This is the internal function which is called by the batch subscribe API to perform the operation.
  * Not meant to be called directly as it doesn't do validations or client state changes
- * @note Call is blocking.  The call returns after the receipt of the SUBACK control packet.
+ * @note Call is blocking.  The call returns after the receipt of the SUBACK control packet for the last topics.
  *
  * @param pClient Reference to the IoT Client
+ * @param pSubscribeList Array of the topics to subscribe to
+ * @param subscribeCount Number of topics in the array
  *
  * @return An IoT Error Type defining successful/failed subscription
  */
-static IoT_Error_t _aws_iot_mqtt_internal_resubscribe(AWS_IoT_Client *pClient) {
-	uint16_t packetId;
-	uint32_t len, count, existingSubCount, itr;
-	IoT_Error_t rc;
-	Timer timer;
-	QoS grantedQoS[3] = {QOS0, QOS0, QOS0};
+static IoT_Error_t _aws_iot_mqtt_internal_subscribe_batch(AWS_IoT_Client *pClient,
+														  IoT_Subscribe_Params *pSubscribeList,
+														  uint32_t subscribeCount) {
+	const char *topicNameList[AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS];
+	uint16_t topicNameLenList[AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS];
+	QoS requestedQoSList[AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS];
+	QoS grantedQoSList[AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS];
+	uint32_t handlerIndexList[AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS];
+	uint32_t handlerIndex, remLen, packetStart, count, itr;
+	IoT_Subscribe_Params *pSubscribe;
+	MessageHandlers *pHandler;
+	IoT_Error_t rc, batchRc;
 
 	FUNC_ENTRY;
 
-	packetId = 0;
-	len = 0;
-	count = 0;
-	existingSubCount = _aws_iot_mqtt_get_free_message_handler_index(pClient);
+	if(AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS < subscribeCount) {
+		FUNC_EXIT_RC(MQTT_MAX_SUBSCRIPTIONS_REACHED_ERROR);
+	}
 
-	for(itr = 0; itr < existingSubCount; itr++) {
-		if(pClient->clientData.messageHandlers[itr].topicName == NULL) {
-			continue;
+	/* Claim a message handler for every topic before sending anything, so that the
+	 * request fails as a whole if the client can't hold all the subscriptions */
+	rc = SUCCESS;
+	for(itr = 0; itr < subscribeCount; itr++) {
+		pSubscribe = &(pSubscribeList[itr]);
+		handlerIndex = _aws_iot_mqtt_get_free_message_handler_index(pClient);
+		if(pClient->clientData.messageHandlerCount <= handlerIndex) {
+			rc = MQTT_MAX_SUBSCRIPTIONS_REACHED_ERROR;
+			break;
 		}
 
-		/* Do not attempt to subscribe to topics which have already been subscribed
-		 to in the previous re-subscribe attempts. */
-		if(pClient->clientData.messageHandlers[itr].resubscribed == 1) {
-			continue;
+		pHandler = &(pClient->clientData.messageHandlers[handlerIndex]);
+		pHandler->topicName = pSubscribe->pTopicName;
+		pHandler->topicNameLen = pSubscribe->topicNameLen;
+		pHandler->pApplicationHandler = pSubscribe->pApplicationHandler;
+		pHandler->pApplicationFragmentHandler = NULL;
+		pHandler->pApplicationHandlerData = pSubscribe->pApplicationHandlerData;
+		pHandler->qos = pSubscribe->qos;
+
+		rc = aws_iot_mqtt_internal_topic_trie_insert(pClient, handlerIndex);
+		if(SUCCESS != rc) {
+			pHandler->topicName = NULL;
+			break;
 		}
+		handlerIndexList[itr] = handlerIndex;
+		pSubscribe->result = rc;
+	}
 
-		init_timer(&timer);
-		countdown_ms(&timer, pClient->clientData.commandTimeoutMs);
+	if(SUCCESS != rc) {
+		while(0 < itr) {
+			_aws_iot_mqtt_release_message_handler(pClient, handlerIndexList[--itr]);
+			pSubscribeList[itr].result = rc;
+		}
+		FUNC_EXIT_RC(rc);
+	}
 
-		rc = _aws_iot_mqtt_serialize_subscribe(pClient->clientData.writeBuf, pClient->clientData.writeBufSize, 0,
-											   aws_iot_mqtt_get_next_packet_id(pClient), 1,
-											   &(pClient->clientData.messageHandlers[itr].topicName),
-											   &(pClient->clientData.messageHandlers[itr].topicNameLen),
-											   &(pClient->clientData.messageHandlers[itr].qos), &len);
-		if(SUCCESS != rc) {
-			FUNC_EXIT_RC(rc);
+	batchRc = SUCCESS;
+	packetStart = 0;
+	while(packetStart < subscribeCount) {
+		/* Gather as many topics as fit in one packet */
+		remLen = 2; /* packetId */
+		count = 0;
+		while(packetStart + count < subscribeCount) {
+			pSubscribe = &(pSubscribeList[packetStart + count]);
+			if(aws_iot_mqtt_internal_get_final_packet_length_from_remaining_length(
+					remLen + SUBSCRIBE_TOPIC_ENTRY_LEN(pSubscribe->topicNameLen)) > pClient->clientData.writeBufSize) {
+				break;
+			}
+
+			remLen += SUBSCRIBE_TOPIC_ENTRY_LEN(pSubscribe->topicNameLen);
+			topicNameList[count] = pSubscribe->pTopicName;
+			topicNameLenList[count] = pSubscribe->topicNameLen;
+			requestedQoSList[count] = pSubscribe->qos;
+			count++;
 		}
 
-		/* send the subscribe packet */
-		rc = aws_iot_mqtt_internal_send_packet(pClient, len, &timer);
+		if(0 == count) {
+			rc = MQTT_TX_BUFFER_TOO_SHORT_ERROR;
+		} else {
+			rc = _aws_iot_mqtt_internal_send_subscribe(pClient, count, topicNameList, topicNameLenList,
+													   requestedQoSList, grantedQoSList);
+		}
 		if(SUCCESS != rc) {
-			FUNC_EXIT_RC(rc);
+			break;
 		}
 
-		/* wait for suback */
-		rc = aws_iot_mqtt_internal_wait_for_read(pClient, SUBACK, &timer);
-		if(SUCCESS != rc) {
-			FUNC_EXIT_RC(rc);
+		for(itr = 0; itr < count; itr++) {
+			if(SUBACK_FAILURE_RETURN_CODE == (uint8_t) grantedQoSList[itr]) {
+				pSubscribeList[packetStart + itr].result = MQTT_SUBSCRIBE_REJECTED_ERROR;
+				_aws_iot_mqtt_release_message_handler(pClient, handlerIndexList[packetStart + itr]);
+				batchRc = MQTT_SUBSCRIBE_REJECTED_ERROR;
+			}
 		}
+		packetStart += count;
+	}
 
-		/* Granted QoS can be 0, 1 or 2 */
-		rc = _aws_iot_mqtt_deserialize_suback(&packetId, 1, &count, grantedQoS, pClient->clientData.readBuf,
-											  pClient->clientData.readBufSize);
-		if(SUCCESS != rc) {
-			FUNC_EXIT_RC(rc);
+	/* Topics that were not acknowledged are not subscribed */
+	for(itr = packetStart; itr < subscribeCount; itr++) {
+		pSubscribeList[itr].result = rc;
+		_aws_iot_mqtt_release_message_handler(pClient, handlerIndexList[itr]);
+	}
+
+	if(SUCCESS != rc) {
+		batchRc = rc;
+	}
+
+	FUNC_EXIT_RC(batchRc);
+}
+
+IoT_Error_t aws_iot_mqtt_subscribe_batch(AWS_IoT_Client *pClient, IoT_Subscribe_Params *pSubscribeList,
+										 uint32_t subscribeCount) {
+	ClientState clientState;
+	IoT_Error_t rc, subRc;
+	uint32_t itr;
+
+	FUNC_ENTRY;
+
+	if(NULL == pClient || NULL == pSubscribeList) {
+		FUNC_EXIT_RC(NULL_VALUE_ERROR);
+	}
+
+	for(itr = 0; itr < subscribeCount; itr++) {
+		if(NULL == pSubscribeList[itr].pTopicName || NULL == pSubscribeList[itr].pApplicationHandler) {
+			FUNC_EXIT_RC(NULL_VALUE_ERROR);
 		}
+	}
 
-		/* Record that this topic has been subscribed to, so that we do not
-		 * attempt to subscribe again to the same topic. */
-		pClient->clientData.messageHandlers[itr].resubscribed = 1;
+	if(!aws_iot_mqtt_is_client_connected(pClient)) {
+		FUNC_EXIT_RC(NETWORK_DISCONNECTED_ERROR);
 	}
 
-	FUNC_EXIT_RC(SUCCESS);
+	clientState = aws_iot_mqtt_get_client_state(pClient);
+	if(CLIENT_STATE_CONNECTED_IDLE != clientState && CLIENT_STATE_CONNECTED_WAIT_FOR_CB_RETURN != clientState) {
+		FUNC_EXIT_RC(MQTT_CLIENT_NOT_IDLE_ERROR);
+	}
+
+	rc = aws_iot_mqtt_set_client_state(pClient, clientState, CLIENT_STATE_CONNECTED_SUBSCRIBE_IN_PROGRESS);
+	if(SUCCESS != rc) {
+		FUNC_EXIT_RC(rc);
+	}
+
+	subRc = _aws_iot_mqtt_internal_subscribe_batch(pClient, pSubscribeList, subscribeCount);
+
+	rc = aws_iot_mqtt_set_client_state(pClient, CLIENT_STATE_CONNECTED_SUBSCRIBE_IN_PROGRESS, clientState);
+	if(SUCCESS == subRc && SUCCESS != rc) {
+		subRc = rc;
+	}
+
+	FUNC_EXIT_RC(subRc);
+}
+
+/**
+ * @brief Subscribe to an MQTT topic.
+ *
+ * Called to send subscribe messages to the broker requesting the subscriptions
+ * the client has. As many topics as fit in the write buffer are requested in each packet.
+ * This is the internal function which is called by the resubscribe API to perform the operation.
+ * Not meant to be called directly as it doesn't do validations or client state changes
+ * Topics the broker refuses are removed from the message handlers and are not requested again.
+ * @note Call is blocking.  The call returns after the receipt of the SUBACK control packet for the last topics.
+ *
+ * @param pClient Reference to the IoT Client
+ *
+ * @return An IoT Error Type defining successful/failed subscription,
+ *         MQTT_SUBSCRIBE_REJECTED_ERROR once every topic was requested if any was refused
+ */
+static IoT_Error_t _aws_iot_mqtt_internal_resubscribe(AWS_IoT_Client *pClient) {
+	const char *topicNameList[AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS];
+	uint16_t topicNameLenList[AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS];
+	QoS requestedQoSList[AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS];
+	QoS grantedQoSList[AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS];
+	uint32_t handlerIndexList[AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS];
+	uint32_t remLen, count, itr;
+	MessageHandlers *pHandler;
+	IoT_Error_t rc, resubRc = SUCCESS;
+
+	FUNC_ENTRY;
+
+	do {
+		/* Gather as many topics as fit in one packet */
+		remLen = 2; /* packetId */
+		count = 0;
+		for(itr = 0; itr < pClient->clientData.messageHandlerCount; itr++) {
+			pHandler = &(pClient->clientData.messageHandlers[itr]);
+			/* Do not attempt to subscribe to topics which have already been subscribed
+			 to in the previous re-subscribe attempts. */
+			if(NULL == pHandler->topicName || 1 == pHandler->resubscribed) {
+				continue;
+			}
+
+			if(aws_iot_mqtt_internal_get_final_packet_length_from_remaining_length(
+					remLen + SUBSCRIBE_TOPIC_ENTRY_LEN(pHandler->topicNameLen)) > pClient->clientData.writeBufSize) {
+				if(0 == count) {
+					FUNC_EXIT_RC(MQTT_TX_BUFFER_TOO_SHORT_ERROR);
+				}
+				break;
+			}
+
+			remLen += SUBSCRIBE_TOPIC_ENTRY_LEN(pHandler->topicNameLen);
+			topicNameList[count] = pHandler->topicName;
+			topicNameLenList[count] = pHandler->topicNameLen;
+			requestedQoSList[count] = pHandler->qos;
+			handlerIndexList[count] = itr;
+			count++;
+		}
+
+		if(0 < count) {
+			rc = _aws_iot_mqtt_internal_send_subscribe(pClient, count, topicNameList, topicNameLenList,
+													   requestedQoSList, grantedQoSList);
+			if(SUCCESS != rc) {
+				FUNC_EXIT_RC(rc);
+			}
+
+			/* Record that these topics have been subscribed to, so that we do not
+			 * attempt to subscribe again to the same topics. */
+			for(itr = 0; itr < count; itr++) {
+				if(SUBACK_FAILURE_RETURN_CODE == (uint8_t) grantedQoSList[itr]) {
+					_aws_iot_mqtt_release_message_handler(pClient, handlerIndexList[itr]);
+					resubRc = MQTT_SUBSCRIBE_REJECTED_ERROR;
+				} else {
+					pClient->clientData.messageHandlers[handlerIndexList[itr]].resubscribed = 1;
+				}
+			}
+		}
+	} while(0 < count);
+
+	FUNC_EXIT_RC(resubRc);
 }
 
 IoT_Error_t aws_iot_mqtt_resubscribe(AWS_IoT_Client *pClient) {
@@ -422,9 +718,12 @@ IoT_Error_t aws_iot_mqtt_resubscribe(AWS_IoT_Client *pClient) {
 
 	/* It is possible that the subscribe operation fails, do not change the state
 	 in that case so that the subscribe is attempted again in the next iteration
-	 of yield. */
-	if(SUCCESS == resubRc) {
-		resubRc = aws_iot_mqtt_set_client_state(pClient, CLIENT_STATE_CONNECTED_RESUBSCRIBE_IN_PROGRESS, CLIENT_STATE_CONNECTED_IDLE);
+	 of yield. Refused topics are done with, they were removed. */
+	if(SUCCESS == resubRc || MQTT_SUBSCRIBE_REJECTED_ERROR == resubRc) {
+		rc = aws_iot_mqtt_set_client_state(pClient, CLIENT_STATE_CONNECTED_RESUBSCRIBE_IN_PROGRESS, CLIENT_STATE_CONNECTED_IDLE);
+		if(SUCCESS != rc) {
+			resubRc = rc;
+		}
 	}
 
 	FUNC_EXIT_RC(resubRc);
@@ -0,0 +1,406 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file aws_iot_mqtt_client_topic_trie.c
+ * @brief MQTT client subscription index
+ *
+ * Topic filters of the message handlers are stored one level per node, so an incoming topic
+ * is matched by walking its levels instead of comparing it with every subscription.
+ * The cost of a match depends on the depth of the topic and on the number of wildcard
+ * branches it meets, not on the number of subscriptions.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "aws_iot_mqtt_client_common_internal.h"
+
+/** Index of the root node, which holds no topic level */
+#define TOPIC_TRIE_ROOT 0
+
+/**
+ * @brief Get the length of the topic level starting at pLevel
+ *
+ * @param pLevel Start of the level
+ * @param pEnd End of the topic
+ *
+ * @return Number of characters before the next separator or the end of the topic
+ */
+static uint16_t _aws_iot_mqtt_topic_trie_level_len(const char *pLevel, const char *pEnd) {
+	const char *pCur = pLevel;
+
+	while(pCur < pEnd && '/' != *pCur) {
+		pCur++;
+	}
+
+	return (uint16_t) (pCur - pLevel);
+}
+
+/**
+ * @brief Get the length of a topic filter
+ *
+ * Topic filters are C strings, a filter ends at its terminator even if a longer length was given
+ *
+ * @return Number of characters of the filter that are used for matching
+ */
+static uint16_t _aws_iot_mqtt_topic_trie_filter_len(const char *pTopicFilter, uint16_t topicFilterLen) {
+	uint16_t len = 0;
+
+	while(len < topicFilterLen && '\0' != pTopicFilter[len]) {
+		len++;
+	}
+
+	return len;
+}
+
+static bool _aws_iot_mqtt_topic_trie_is_level(TopicTrieNode *pNode, const char *pLevel, uint16_t levelLen) {
+	return levelLen == pNode->levelLen && 0 == strncmp(pNode->pLevel, pLevel, levelLen);
+}
+
+static bool _aws_iot_mqtt_topic_trie_is_wildcard(TopicTrieNode *pNode) {
+	return 1 == pNode->levelLen && ('+' == pNode->pLevel[0] || '#' == pNode->pLevel[0]);
+}
+
+/**
+ * @brief Find the child of a node holding exactly the given level
+ *
+ * Wildcards are compared as plain characters.
+ *
+ * @return Index of the child, TOPIC_TRIE_INDEX_NONE if there is none
+ */
+static uint16_t _aws_iot_mqtt_topic_trie_find_child(AWS_IoT_Client *pClient, uint16_t node, const char *pLevel,
+													uint16_t levelLen) {
+	uint16_t child = pClient->clientData.topicTrie[node].firstChild;
+
+	while(TOPIC_TRIE_INDEX_NONE != child) {
+		if(_aws_iot_mqtt_topic_trie_is_level(&(pClient->clientData.topicTrie[child]), pLevel, levelLen)) {
+			break;
+		}
+		child = pClient->clientData.topicTrie[child].nextSibling;
+	}
+
+	return child;
+}
+
+/**
+ * @brief Find the node holding exactly the given topic filter
+ *
+ * @return Index of the node, TOPIC_TRIE_INDEX_NONE if no subscription uses the filter
+ */
+static uint16_t _aws_iot_mqtt_topic_trie_find_node(AWS_IoT_Client *pClient, const char *pTopicFilter,
+												   uint16_t topicFilterLen) {
+	const char *pEnd = pTopicFilter + _aws_iot_mqtt_topic_trie_filter_len(pTopicFilter, topicFilterLen);
+	const char *pLevel = pTopicFilter;
+	uint16_t levelLen;
+	uint16_t node = TOPIC_TRIE_ROOT;
+
+	do {
+		levelLen = _aws_iot_mqtt_topic_trie_level_len(pLevel, pEnd);
+		node = _aws_iot_mqtt_topic_trie_find_child(pClient, node, pLevel, levelLen);
+		pLevel += levelLen + 1;
+	} while(TOPIC_TRIE_INDEX_NONE != node && pLevel <= pEnd);
+
+	return node;
+}
+
+/**
+ * @brief Add the message handlers subscribed with the filter ending at a node to a match list
+ */
+static void _aws_iot_mqtt_topic_trie_collect(AWS_IoT_Client *pClient, uint16_t node, uint16_t *pHandlerList,
+											 uint32_t *pHandlerCount) {
+	uint16_t handler = pClient->clientData.topicTrie[node].firstHandler;
+
+	while(TOPIC_TRIE_INDEX_NONE != handler && *pHandlerCount < pClient->clientData.messageHandlerCount) {
+		pHandlerList[(*pHandlerCount)++] = handler;
+		handler = pClient->clientData.messageHandlers[handler].nextTrieHandler;
+	}
+}
+
+/**
+ * @brief Match the topic level starting at pLevel against the children of a node
+ *
+ * Recurses once per topic level, for every child that matches the level.
+ */
+static void _aws_iot_mqtt_topic_trie_match_level(AWS_IoT_Client *pClient, uint16_t node, const char *pLevel,
+												 const char *pEnd, uint16_t *pHandlerList, uint32_t *pHandlerCount) {
+	uint16_t levelLen = _aws_iot_mqtt_topic_trie_level_len(pLevel, pEnd);
+	bool isLastLevel = (pLevel + levelLen >= pEnd);
+	uint16_t child = pClient->clientData.topicTrie[node].firstChild;
+	TopicTrieNode *pChild;
+
+	while(TOPIC_TRIE_INDEX_NONE != child) {
+		pChild = &(pClient->clientData.topicTrie[child]);
+		if(_aws_iot_mqtt_topic_trie_is_wildcard(pChild) && '#' == pChild->pLevel[0]) {
+			/* Matches this level and all the levels below it */
+			_aws_iot_mqtt_topic_trie_collect(pClient, child, pHandlerList, pHandlerCount);
+		} else if(_aws_iot_mqtt_topic_trie_is_wildcard(pChild)
+				  || _aws_iot_mqtt_topic_trie_is_level(pChild, pLevel, levelLen)) {
+			if(isLastLevel) {
+				_aws_iot_mqtt_topic_trie_collect(pClient, child, pHandlerList, pHandlerCount);
+			} else {
+				_aws_iot_mqtt_topic_trie_match_level(pClient, child, pLevel + levelLen + 1, pEnd, pHandlerList,
+													 pHandlerCount);
+			}
+		}
+		child = pChild->nextSibling;
+	}
+}
+
+/**
+ * @brief Initialize the subscription index
+ *
+ * Called when the client is initialized, before any subscription is made.
+ *
+ * @param pClient Reference to the IoT Client
+ */
+void aws_iot_mqtt_internal_topic_trie_init(AWS_IoT_Client *pClient) {
+	uint16_t itr;
+	TopicTrieNode *pNode;
+
+	for(itr = 0; itr < pClient->clientData.topicTrieNodeCount; itr++) {
+		pNode = &(pClient->clientData.topicTrie[itr]);
+		pNode->pLevel = NULL;
+		pNode->levelLen = 0;
+		pNode->parent = TOPIC_TRIE_INDEX_NONE;
+		pNode->firstChild = TOPIC_TRIE_INDEX_NONE;
+		pNode->firstHandler = TOPIC_TRIE_INDEX_NONE;
+		pNode->subscriptionCount = 0;
+		pNode->nextSibling = (uint16_t) ((itr + 1 < pClient->clientData.topicTrieNodeCount) ? itr + 1
+																							   : TOPIC_TRIE_INDEX_NONE);
+	}
+
+	/* The root is never free */
+	pClient->clientData.topicTrie[TOPIC_TRIE_ROOT].nextSibling = TOPIC_TRIE_INDEX_NONE;
+	pClient->clientData.topicTrieFreeNode =
+			(uint16_t) ((1 < pClient->clientData.topicTrieNodeCount) ? 1 : TOPIC_TRIE_INDEX_NONE);
+}
+
+/**
+ * @brief Check whether the subscription index has room for a topic filter
+ *
+ * @param pClient Reference to the IoT Client
+ * @param pTopicFilter Topic filter of the new subscription
+ * @param topicFilterLen Length of the topic filter
+ *
+ * @return true if aws_iot_mqtt_internal_topic_trie_insert will succeed for this filter
+ */
+bool aws_iot_mqtt_internal_topic_trie_has_room(AWS_IoT_Client *pClient, const char *pTopicFilter,
+											   uint16_t topicFilterLen) {
+	const char *pEnd = pTopicFilter + _aws_iot_mqtt_topic_trie_filter_len(pTopicFilter, topicFilterLen);
+	const char *pLevel = pTopicFilter;
+	uint16_t levelLen;
+	uint16_t node = TOPIC_TRIE_ROOT;
+	uint16_t child;
+	uint32_t nodesNeeded = 0;
+
+	/* Count the levels that are not in the index yet */
+	do {
+		levelLen = _aws_iot_mqtt_topic_trie_level_len(pLevel, pEnd);
+		child = (TOPIC_TRIE_INDEX_NONE == node) ? TOPIC_TRIE_INDEX_NONE
+												: _aws_iot_mqtt_topic_trie_find_child(pClient, node, pLevel, levelLen);
+		if(TOPIC_TRIE_INDEX_NONE == child) {
+			nodesNeeded++;
+		}
+		node = child;
+		pLevel += levelLen + 1;
+	} while(pLevel <= pEnd);
+
+	node = pClient->clientData.topicTrieFreeNode;
+	while(0 < nodesNeeded && TOPIC_TRIE_INDEX_NONE != node) {
+		nodesNeeded--;
+		node = pClient->clientData.topicTrie[node].nextSibling;
+	}
+
+	return 0 == nodesNeeded;
+}
+
+/**
+ * @brief Add a message handler to the subscription index
+ *
+ * @param pClient Reference to the IoT Client
+ * @param handlerIndex Index of the message handler, its topic filter must be set
+ *
+ * @return SUCCESS, or MQTT_MAX_SUBSCRIPTIONS_REACHED_ERROR if the node pool is exhausted
+ */
+IoT_Error_t aws_iot_mqtt_internal_topic_trie_insert(AWS_IoT_Client *pClient, uint32_t handlerIndex) {
+	MessageHandlers *pHandler = &(pClient->clientData.messageHandlers[handlerIndex]);
+	const char *pEnd = pHandler->topicName
+					   + _aws_iot_mqtt_topic_trie_filter_len(pHandler->topicName, pHandler->topicNameLen);
+	const char *pLevel = pHandler->topicName;
+	uint16_t levelLen;
+	uint16_t node = TOPIC_TRIE_ROOT;
+	uint16_t child;
+	TopicTrieNode *pChild;
+
+	FUNC_ENTRY;
+
+	if(!aws_iot_mqtt_internal_topic_trie_has_room(pClient, pHandler->topicName, pHandler->topicNameLen)) {
+		FUNC_EXIT_RC(MQTT_MAX_SUBSCRIPTIONS_REACHED_ERROR);
+	}
+
+	pClient->clientData.topicTrie[TOPIC_TRIE_ROOT].subscriptionCount++;
+	do {
+		levelLen = _aws_iot_mqtt_topic_trie_level_len(pLevel, pEnd);
+		child = _aws_iot_mqtt_topic_trie_find_child(pClient, node, pLevel, levelLen);
+		if(TOPIC_TRIE_INDEX_NONE == child) {
+			child = pClient->clientData.topicTrieFreeNode;
+			pChild = &(pClient->clientData.topicTrie[child]);
+			pClient->clientData.topicTrieFreeNode = pChild->nextSibling;
+
+			pChild->pLevel = pLevel;
+			pChild->levelLen = levelLen;
+			pChild->parent = node;
+			pChild->firstChild = TOPIC_TRIE_INDEX_NONE;
+			pChild->firstHandler = TOPIC_TRIE_INDEX_NONE;
+			pChild->subscriptionCount = 0;
+			pChild->nextSibling = pClient->clientData.topicTrie[node].firstChild;
+			pClient->clientData.topicTrie[node].firstChild = child;
+		}
+		pClient->clientData.topicTrie[child].subscriptionCount++;
+		node = child;
+		pLevel += levelLen + 1;
+	} while(pLevel <= pEnd);
+
+	pHandler->trieNode = node;
+	pHandler->nextTrieHandler = pClient->clientData.topicTrie[node].firstHandler;
+	pClient->clientData.topicTrie[node].firstHandler = (uint16_t) handlerIndex;
+
+	FUNC_EXIT_RC(SUCCESS);
+}
+
+/**
+ * @brief Remove a message handler from the subscription index
+ *
+ * Nodes that are no longer used by any subscription are returned to the pool.
+ *
+ * @param pClient Reference to the IoT Client
+ * @param handlerIndex Index of the message handler, its topic filter must still be set
+ */
+void aws_iot_mqtt_internal_topic_trie_remove(AWS_IoT_Client *pClient, uint32_t handlerIndex) {
+	MessageHandlers *pHandler = &(pClient->clientData.messageHandlers[handlerIndex]);
+	const char *pRemovedStart = pHandler->topicName;
+	const char *pRemovedEnd = pHandler->topicName + pHandler->topicNameLen;
+	uint16_t node = pHandler->trieNode;
+	uint16_t *pLink;
+	uint16_t parent, descendant;
+	TopicTrieNode *pNode;
+
+	/* Unlink the handler from the node of its topic filter */
+	pLink = &(pClient->clientData.topicTrie[node].firstHandler);
+	while(TOPIC_TRIE_INDEX_NONE != *pLink && handlerIndex != *pLink) {
+		pLink = &(pClient->clientData.messageHandlers[*pLink].nextTrieHandler);
+	}
+	if(TOPIC_TRIE_INDEX_NONE == *pLink) {
+		return;
+	}
+	*pLink = pHandler->nextTrieHandler;
+	pHandler->nextTrieHandler = TOPIC_TRIE_INDEX_NONE;
+	pHandler->trieNode = TOPIC_TRIE_INDEX_NONE;
+
+	/* Walk back to the root, releasing the nodes no other subscription goes through */
+	while(TOPIC_TRIE_ROOT != node) {
+		pNode = &(pClient->clientData.topicTrie[node]);
+		parent = pNode->parent;
+		pNode->subscriptionCount--;
+
+		if(0 == pNode->subscriptionCount) {
+			pLink = &(pClient->clientData.topicTrie[parent].firstChild);
+			while(node != *pLink) {
+				pLink = &(pClient->clientData.topicTrie[*pLink].nextSibling);
+			}
+			*pLink = pNode->nextSibling;
+
+			pNode->pLevel = NULL;
+			pNode->parent = TOPIC_TRIE_INDEX_NONE;
+			pNode->nextSibling = pClient->clientData.topicTrieFreeNode;
+			pClient->clientData.topicTrieFreeNode = node;
+		} else if(pNode->pLevel >= pRemovedStart && pNode->pLevel <= pRemovedEnd) {
+			/* The level text belongs to the removed filter. Another filter below this node
+			 * has the same prefix, so the level is found at the same offset in it */
+			descendant = node;
+			while(TOPIC_TRIE_INDEX_NONE == pClient->clientData.topicTrie[descendant].firstHandler) {
+				descendant = pClient->clientData.topicTrie[descendant].firstChild;
+			}
+			pNode->pLevel = pClient->clientData.messageHandlers[pClient->clientData.topicTrie[descendant].firstHandler].topicName
+							+ (pNode->pLevel - pRemovedStart);
+		}
+		node = parent;
+	}
+	pClient->clientData.topicTrie[TOPIC_TRIE_ROOT].subscriptionCount--;
+}
+
+/**
+ * @brief Find a message handler subscribed with exactly the given topic filter
+ *
+ * @param pClient Reference to the IoT Client
+ * @param pTopicFilter Topic filter
+ * @param topicFilterLen Length of the topic filter
+ *
+ * @return Index of the message handler, the number of message handlers of the client if there is none
+ */
+uint32_t aws_iot_mqtt_internal_topic_trie_find(AWS_IoT_Client *pClient, const char *pTopicFilter,
+											   uint16_t topicFilterLen) {
+	uint16_t node = _aws_iot_mqtt_topic_trie_find_node(pClient, pTopicFilter, topicFilterLen);
+
+	if(TOPIC_TRIE_INDEX_NONE == node || TOPIC_TRIE_INDEX_NONE == pClient->clientData.topicTrie[node].firstHandler) {
+		return pClient->clientData.messageHandlerCount;
+	}
+
+	return pClient->clientData.topicTrie[node].firstHandler;
+}
+
+/**
+ * @brief Find the message handlers whose topic filter matches a topic name
+ *
+ * The handlers are listed in increasing index order, the order in which they were subscribed
+ * when no subscription was removed in between.
+ *
+ * @param pClient Reference to the IoT Client
+ * @param pTopicName Topic name of an incoming message
+ * @param topicNameLen Length of the topic name
+ * @param pHandlerList Array of AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS entries receiving the handler indexes
+ *
+ * @return Number of matching message handlers
+ */
+uint32_t aws_iot_mqtt_internal_topic_trie_match(AWS_IoT_Client *pClient, const char *pTopicName, uint16_t topicNameLen,
+												uint16_t *pHandlerList) {
+	uint32_t handlerCount = 0;
+	uint32_t itr, pos;
+	uint16_t handler;
+
+	if(NULL == pTopicName || 0 == pClient->clientData.topicTrie[TOPIC_TRIE_ROOT].subscriptionCount) {
+		return 0;
+	}
+
+	_aws_iot_mqtt_topic_trie_match_level(pClient, TOPIC_TRIE_ROOT, pTopicName, pTopicName + topicNameLen,
+										 pHandlerList, &handlerCount);
+
+	/* Few handlers match a topic, insertion sort keeps the subscription order */
+	for(itr = 1; itr < handlerCount; itr++) {
+		handler = pHandlerList[itr];
+		for(pos = itr; 0 < pos && pHandlerList[pos - 1] > handler; pos--) {
+			pHandlerList[pos] = pHandlerList[pos - 1];
+		}
+		pHandlerList[pos] = handler;
+	}
+
+	return handlerCount;
+}
+
+#ifdef __cplusplus
+}
+#endif
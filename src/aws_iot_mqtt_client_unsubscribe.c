@@ -116,59 +116,42 @@ static IoT_Error_t _aws_iot_mqtt_deserialize_unsuback(uint16_t *pPacketId, unsig
 }
 
 /**
- * @brief Unsubscribe to an MQTT topic.
- *
- * Called to send an unsubscribe message to the broker requesting removal of a subscription
- * to an MQTT topic.
- * @note Call is blocking.  The call returns after the receipt of the UNSUBACK control packet.
- * This is the internal function which is called by the unsubscribe API to perform the operation.
- * Not meant to be called directly as it doesn't do validations or client state changes
+ * @brief Send an UNSUBSCRIBE packet for a list of topic filters and wait for its UNSUBACK
  *
  * @param pClient Reference to the IoT Client
- * @param pTopicName Topic Name to publish to
- * @param topicNameLen Length of the topic name
+ * @param count Number of topic filters in the lists
+ * @param pTopicFilterList Array of topic filters
+ * @param pTopicFilterLenList Array of lengths of the topic filters
  *
- * @return An IoT Error Type defining successful/failed unsubscribe call
+ * @return An IoT Error Type defining successful/failed operation
  */
-static IoT_Error_t _aws_iot_mqtt_internal_unsubscribe(AWS_IoT_Client *pClient, const char *pTopicFilter,
-													  uint16_t topicFilterLen) {
-	/* No NULL checks because this is a static internal function */
-
+static IoT_Error_t _aws_iot_mqtt_internal_send_unsubscribe(AWS_IoT_Client *pClient, uint32_t count,
+														   const char **pTopicFilterList,
+														   uint16_t *pTopicFilterLenList) {
 	Timer timer;
-
 	uint16_t packet_id;
 	uint32_t serializedLen = 0;
-	uint32_t i = 0;
 	IoT_Error_t rc;
-	bool subscriptionExists = false;
 
 	FUNC_ENTRY;
 
-	/* Remove from message handler array */
-	for(i = 0; i < AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS; ++i) {
-		if(pClient->clientData.messageHandlers[i].topicName != NULL &&
-		   (strcmp(pClient->clientData.messageHandlers[i].topicName, pTopicFilter) == 0)) {
-			subscriptionExists = true;
-            break;
-		}
-	}
-
-	if(false == subscriptionExists) {
-		FUNC_EXIT_RC(FAILURE);
-	}
-
 	init_timer(&timer);
 	countdown_ms(&timer, pClient->clientData.commandTimeoutMs);
 
-	rc = _aws_iot_mqtt_serialize_unsubscribe(pClient->clientData.writeBuf, pClient->clientData.writeBufSize, 0,
-											 aws_iot_mqtt_get_next_packet_id(pClient), 1, &pTopicFilter,
-											 &topicFilterLen, &serializedLen);
+	rc = aws_iot_mqtt_internal_lock_write_buffer(pClient);
 	if(SUCCESS != rc) {
 		FUNC_EXIT_RC(rc);
 	}
 
-	/* send the unsubscribe packet */
-	rc = aws_iot_mqtt_internal_send_packet(pClient, serializedLen, &timer);
+	rc = _aws_iot_mqtt_serialize_unsubscribe(pClient->clientData.writeBuf, pClient->clientData.writeBufSize, 0,
+											 aws_iot_mqtt_get_next_packet_id(pClient), count, pTopicFilterList,
+											 pTopicFilterLenList, &serializedLen);
+	if(SUCCESS == rc) {
+		/* send the unsubscribe packet */
+		rc = aws_iot_mqtt_internal_send_packet(pClient, serializedLen, &timer);
+	}
+
+	rc = aws_iot_mqtt_internal_unlock_write_buffer(pClient, rc);
 	if(SUCCESS != rc) {
 		FUNC_EXIT_RC(rc);
 	}
@@ -179,17 +162,74 @@ static IoT_Error_t _aws_iot_mqtt_internal_unsubscribe(AWS_IoT_Client *pClient, c
 	}
 
 	rc = _aws_iot_mqtt_deserialize_unsuback(&packet_id, pClient->clientData.readBuf, pClient->clientData.readBufSize);
-	if(SUCCESS != rc) {
-		FUNC_EXIT_RC(rc);
+
+	FUNC_EXIT_RC(rc);
+}
+
+/**
+ * @brief Unsubscribe from a list of MQTT topics.
+ *
+ * Called to send unsubscribe messages to the broker requesting removal of the subscriptions
+ * to a list of topic filters. As many filters as fit in the write buffer are sent in each packet.
+ * @note Call is blocking.  The call returns after the receipt of the UNSUBACK control packet for the last filters.
+ * This is the internal function which is called by the unsubscribe APIs to perform the operation.
+ * Not meant to be called directly as it doesn't do validations or client state changes
+ *
+ * @param pClient Reference to the IoT Client
+ * @param pTopicFilterList Array of the topic filters of the subscriptions
+ * @param pTopicFilterLenList Array of the lengths of the topic filters
+ * @param topicFilterCount Number of topic filters in the arrays
+ *
+ * @return An IoT Error Type defining successful/failed unsubscribe call
+ */
+static IoT_Error_t _aws_iot_mqtt_internal_unsubscribe(AWS_IoT_Client *pClient, const char **pTopicFilterList,
+													  uint16_t *pTopicFilterLenList, uint32_t topicFilterCount) {
+	/* No NULL checks because this is a static internal function */
+	uint32_t i, remLen, packetStart, count;
+	IoT_Error_t rc;
+
+	FUNC_ENTRY;
+
+	for(i = 0; i < topicFilterCount; ++i) {
+		if(pClient->clientData.messageHandlerCount
+		   == aws_iot_mqtt_internal_topic_trie_find(pClient, pTopicFilterList[i], pTopicFilterLenList[i])) {
+			FUNC_EXIT_RC(FAILURE);
+		}
 	}
 
-	/* Remove from message handler array */
-	for(i = 0; i < AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS; ++i) {
-		if(pClient->clientData.messageHandlers[i].topicName != NULL &&
-		   (strcmp(pClient->clientData.messageHandlers[i].topicName, pTopicFilter) == 0)) {
-			pClient->clientData.messageHandlers[i].topicName = NULL;
-			/* We don't want to break here, in case the same topic is registered
-             * with 2 callbacks. Unlikely scenario */
+	packetStart = 0;
+	while(packetStart < topicFilterCount) {
+		/* Gather as many filters as fit in one packet */
+		remLen = 2; /* packetId */
+		count = 0;
+		while(packetStart + count < topicFilterCount
+			  && aws_iot_mqtt_internal_get_final_packet_length_from_remaining_length(
+					  remLen + pTopicFilterLenList[packetStart + count] + 2) <= pClient->clientData.writeBufSize) {
+			remLen += (uint32_t) (pTopicFilterLenList[packetStart + count] + 2); /* topic + length */
+			count++;
+		}
+
+		if(0 == count) {
+			FUNC_EXIT_RC(MQTT_TX_BUFFER_TOO_SHORT_ERROR);
+		}
+
+		rc = _aws_iot_mqtt_internal_send_unsubscribe(pClient, count, &(pTopicFilterList[packetStart]),
+													 &(pTopicFilterLenList[packetStart]));
+		if(SUCCESS != rc) {
+			FUNC_EXIT_RC(rc);
+		}
+
+		/* Remove from message handler array. We don't stop at the first one, in case
+		 * the same topic is registered with 2 callbacks. Unlikely scenario */
+		for(; 0 < count; count--, packetStart++) {
+			i = aws_iot_mqtt_internal_topic_trie_find(pClient, pTopicFilterList[packetStart],
+													  pTopicFilterLenList[packetStart]);
+			while(pClient->clientData.messageHandlerCount != i) {
+				aws_iot_mqtt_internal_topic_trie_remove(pClient, i);
+				pClient->clientData.messageHandlers[i].topicName = NULL;
+				i = aws_iot_mqtt_internal_topic_trie_find(pClient, pTopicFilterList[packetStart],
+														  pTopicFilterLenList[packetStart]);
+			}
 		}
 	}
 
@@ -197,13 +237,29 @@ static IoT_Error_t _aws_iot_mqtt_internal_unsubscribe(AWS_IoT_Client *pClient, c
 }
 
 IoT_Error_t aws_iot_mqtt_unsubscribe(AWS_IoT_Client *pClient, const char *pTopicFilter, uint16_t topicFilterLen) {
+	if(NULL == pTopicFilter) {
+		return NULL_VALUE_ERROR;
+	}
+
+	return aws_iot_mqtt_unsubscribe_batch(pClient, &pTopicFilter, &topicFilterLen, 1);
+}
+
+IoT_Error_t aws_iot_mqtt_unsubscribe_batch(AWS_IoT_Client *pClient, const char **pTopicFilterList,
+										   uint16_t *pTopicFilterLenList, uint32_t topicFilterCount) {
 	IoT_Error_t rc, unsubRc;
 	ClientState clientState;
+	uint32_t i;
 
-	if(NULL == pClient || NULL == pTopicFilter) {
+	if(NULL == pClient || NULL == pTopicFilterList || NULL == pTopicFilterLenList) {
 		return NULL_VALUE_ERROR;
 	}
 
+	for(i = 0; i < topicFilterCount; ++i) {
+		if(NULL == pTopicFilterList[i]) {
+			return NULL_VALUE_ERROR;
+		}
+	}
+
 	if(!aws_iot_mqtt_is_client_connected(pClient)) {
 		return NETWORK_DISCONNECTED_ERROR;
 	}
@@ -219,7 +275,7 @@ IoT_Error_t aws_iot_mqtt_unsubscribe(AWS_IoT_Client *pClient, const char *pTopic
 		return rc;
 	}
 
-	unsubRc = _aws_iot_mqtt_internal_unsubscribe(pClient, pTopicFilter, topicFilterLen);
+	unsubRc = _aws_iot_mqtt_internal_unsubscribe(pClient, pTopicFilterList, pTopicFilterLenList, topicFilterCount);
 
 	rc = aws_iot_mqtt_set_client_state(pClient, CLIENT_STATE_CONNECTED_UNSUBSCRIBE_IN_PROGRESS, clientState);
 	if(SUCCESS == unsubRc && SUCCESS != rc) {
@@ -48,6 +48,7 @@ static void _aws_iot_mqtt_force_client_disconnect(AWS_IoT_Client *pClient) {
 	pClient->clientStatus.clientState = CLIENT_STATE_DISCONNECTED_ERROR;
 	pClient->networkStack.disconnect(&(pClient->networkStack));
 	pClient->networkStack.destroy(&(pClient->networkStack));
+	aws_iot_mqtt_internal_abort_inflight_publishes(pClient, NETWORK_DISCONNECTED_ERROR);
 }
 
 static IoT_Error_t _aws_iot_mqtt_handle_disconnect(AWS_IoT_Client *pClient) {
@@ -63,6 +64,15 @@ static IoT_Error_t _aws_iot_mqtt_handle_disconnect(AWS_IoT_Client *pClient) {
 
 	pClient->clientStatus.clientState = CLIENT_STATE_DISCONNECTED_ERROR;
 
+	if(0 != pClient->clientData.pingProbeSec) {
+		/* The connection did not survive the probed idle time, stay with the longest one that did */
+		if(0 == pClient->clientData.pingIntervalConfirmedSec) {
+			pClient->clientData.pingIntervalConfirmedSec = pClient->clientData.pingIntervalSec;
+		}
+		pClient->clientData.pingIntervalSec = pClient->clientData.pingIntervalConfirmedSec;
+		pClient->clientData.pingProbeSec = 0;
+	}
+
 	if(NULL != pClient->clientData.disconnectHandler) {
 		pClient->clientData.disconnectHandler(pClient, pClient->clientData.disconnectHandlerData);
 	}
@@ -99,13 +109,20 @@ static IoT_Error_t _aws_iot_mqtt_handle_reconnect(AWS_IoT_Client *pClient) {
 			if(SUCCESS != rc) {
 				FUNC_EXIT_RC(rc);
 			}
+#ifdef AWS_IOT_MQTT_ENABLE_OFFLINE_QUEUE
+			/* First batch of the messages published during the outage, the rest follows from yield */
+			(void)aws_iot_mqtt_internal_offline_queue_drain(pClient);
+#endif
 			FUNC_EXIT_RC(NETWORK_RECONNECTED);
 		}
 	}
 
-	pClient->clientData.currentReconnectWaitInterval *= 2;
+	pClient->clientData.reconnectAttempt++;
+	pClient->clientData.currentReconnectWaitInterval =
+			pClient->clientData.reconnectPolicy(pClient, pClient->clientData.reconnectAttempt,
+												pClient->clientData.currentReconnectWaitInterval);
 
-	if(AWS_IOT_MQTT_MAX_RECONNECT_WAIT_INTERVAL < pClient->clientData.currentReconnectWaitInterval) {
+	if(AWS_IOT_MQTT_RECONNECT_GIVE_UP == pClient->clientData.currentReconnectWaitInterval) {
 		FUNC_EXIT_RC(NETWORK_RECONNECT_TIMED_OUT_ERROR);
 	}
 	countdown_ms(&(pClient->reconnectDelayTimer), pClient->clientData.currentReconnectWaitInterval);
@@ -123,6 +140,11 @@ static IoT_Error_t _aws_iot_mqtt_keep_alive(AWS_IoT_Client *pClient) {
 		FUNC_EXIT_RC(NULL_VALUE_ERROR);
 	}
 
+#ifdef AWS_IOT_MQTT_OUTBOUND_QUEUE_SLOTS
+	/* Packets a producer queued just as the previous writer released the write buffer */
+	(void)aws_iot_mqtt_internal_outbound_queue_send(pClient);
+#endif
+
 	if(0 == pClient->clientData.keepAliveInterval) {
 		FUNC_EXIT_RC(SUCCESS);
 	}
@@ -154,14 +176,28 @@ static IoT_Error_t _aws_iot_mqtt_keep_alive(AWS_IoT_Client *pClient) {
 
 	countdown_ms(&timer, pClient->clientData.commandTimeoutMs);
 	serialized_len = 0;
+
+	/* Another thread is writing, the ping is sent on the next call */
+	if(SUCCESS != aws_iot_mqtt_internal_lock_write_buffer(pClient)) {
+		FUNC_EXIT_RC(SUCCESS);
+	}
+
 	rc = aws_iot_mqtt_internal_serialize_zero(pClient->clientData.writeBuf, pClient->clientData.writeBufSize,
 											  PINGREQ, &serialized_len);
 	if(SUCCESS != rc) {
-		FUNC_EXIT_RC(rc);
+		FUNC_EXIT_RC(aws_iot_mqtt_internal_unlock_write_buffer(pClient, rc));
+	}
+
+	/* A PINGREQ after a silence longer than any the connection is known to survive tests it */
+	pClient->clientData.pingProbeSec = 0;
+	if(pClient->clientData.isKeepAliveAdaptive && pClient->clientData.isIdleSincePingTimer
+	   && pClient->clientData.pingIntervalSec != pClient->clientData.pingIntervalConfirmedSec) {
+		pClient->clientData.pingProbeSec = pClient->clientData.pingIntervalSec;
 	}
 
 	/* send the ping packet */
 	rc = aws_iot_mqtt_internal_send_packet(pClient, serialized_len, &timer);
+	(void)aws_iot_mqtt_internal_unlock_write_buffer(pClient, rc);
 	if(SUCCESS != rc) {
 		//If sending a PING fails we can no longer determine if we are connected.  In this case we decide we are disconnected and begin reconnection attempts
 		rc = _aws_iot_mqtt_handle_disconnect(pClient);
@@ -169,14 +205,53 @@ static IoT_Error_t _aws_iot_mqtt_keep_alive(AWS_IoT_Client *pClient) {
 	}
 
 	pClient->clientStatus.isPingOutstanding = true;
-	/* Start a timer to wait for PINGRESP from server. */
+	/* Start a timer to wait for PINGRESP from server. The timer of the next PINGREQ
+	 * was restarted by sending this one. */
 	countdown_sec(&pClient->pingRespTimer, pClient->clientData.keepAliveInterval);
-	/* Start a timer to keep track of when to send the next PINGREQ. */
-	countdown_sec(&pClient->pingReqTimer, pClient->clientData.keepAliveInterval);
 
 	FUNC_EXIT_RC(SUCCESS);
 }
 
+/**
+ * @brief Start the auto-reconnect workflow after the connection has been lost
+ *
+ * @param pClient Reference to the IoT Client
+ *
+ * @return NETWORK_ATTEMPTING_RECONNECT if auto-reconnect is enabled,
+ *         NETWORK_DISCONNECTED_ERROR otherwise
+ */
+static IoT_Error_t _aws_iot_mqtt_handle_network_disconnected(AWS_IoT_Client *pClient) {
+	IoT_Error_t rc;
+	uint32_t itr;
+
+	FUNC_ENTRY;
+
+	pClient->clientData.counterNetworkDisconnected++;
+	if(1 != pClient->clientStatus.isAutoReconnectEnabled) {
+		FUNC_EXIT_RC(NETWORK_DISCONNECTED_ERROR);
+	}
+
+	rc = aws_iot_mqtt_set_client_state(pClient, CLIENT_STATE_DISCONNECTED_ERROR, CLIENT_STATE_PENDING_RECONNECT);
+	if(SUCCESS != rc) {
+		FUNC_EXIT_RC(rc);
+	}
+
+	pClient->clientData.reconnectAttempt = 1;
+	pClient->clientData.currentReconnectWaitInterval = pClient->clientData.reconnectPolicy(pClient, 1, 0);
+	if(AWS_IOT_MQTT_RECONNECT_GIVE_UP != pClient->clientData.currentReconnectWaitInterval) {
+		countdown_ms(&(pClient->reconnectDelayTimer), pClient->clientData.currentReconnectWaitInterval);
+	}
+
+	for(itr = 0; itr < pClient->clientData.messageHandlerCount; itr++) {
+		pClient->clientData.messageHandlers[itr].resubscribed = 0;
+	}
+
+	/* Depending on timer values, it is possible that yield timer has expired
+	 * Set to rc to attempting reconnect to inform client that autoreconnect
+	 * attempt has started */
+	FUNC_EXIT_RC(NETWORK_ATTEMPTING_RECONNECT);
+}
+
 /**
  * @brief Yield to the MQTT client
  *
@@ -199,11 +274,14 @@ static IoT_Error_t _aws_iot_mqtt_keep_alive(AWS_IoT_Client *pClient) {
 
 static IoT_Error_t _aws_iot_mqtt_internal_yield(AWS_IoT_Client *pClient, uint32_t timeout_ms) {
 	IoT_Error_t yieldRc = SUCCESS;
-	int itr = 0;
 
 	uint8_t packet_type;
 	ClientState clientState;
 	Timer timer;
+#ifdef AWS_IOT_MQTT_ENABLE_STATS
+	uint32_t yieldStartUs = timer_now_us();
+	uint32_t cycleStartUs, idleUs = 0;
+#endif
 	init_timer(&timer);
 	countdown_ms(&timer, timeout_ms);
 
@@ -219,7 +297,7 @@ static IoT_Error_t _aws_iot_mqtt_internal_yield(AWS_IoT_Client *pClient, uint32_
 		 subsequent invocations only attempt remaining subscribes.  */
 		if((CLIENT_STATE_PENDING_RECONNECT == clientState) ||
 			(CLIENT_STATE_CONNECTED_RESUBSCRIBE_IN_PROGRESS == clientState)) {
-			if(AWS_IOT_MQTT_MAX_RECONNECT_WAIT_INTERVAL < pClient->clientData.currentReconnectWaitInterval) {
+			if(AWS_IOT_MQTT_RECONNECT_GIVE_UP == pClient->clientData.currentReconnectWaitInterval) {
 				yieldRc = NETWORK_RECONNECT_TIMED_OUT_ERROR;
 				break;
 			}
@@ -229,9 +307,25 @@ static IoT_Error_t _aws_iot_mqtt_internal_yield(AWS_IoT_Client *pClient, uint32_
 			continue;
 		}
 
+#ifdef AWS_IOT_MQTT_ENABLE_STATS
+		/* A cycle that reads no packet was spent waiting for the network */
+		packet_type = 0;
+		cycleStartUs = timer_now_us();
+#endif
 		yieldRc = aws_iot_mqtt_internal_cycle_read(pClient, &timer, &packet_type);
+#ifdef AWS_IOT_MQTT_ENABLE_STATS
+		if(SUCCESS == yieldRc && 0 == packet_type) {
+			idleUs += timer_now_us() - cycleStartUs;
+		}
+#endif
 		if(SUCCESS == yieldRc) {
+			aws_iot_mqtt_internal_expire_inflight_publishes(pClient);
 			yieldRc = _aws_iot_mqtt_keep_alive(pClient);
+#ifdef AWS_IOT_MQTT_ENABLE_OFFLINE_QUEUE
+			if(SUCCESS == yieldRc) {
+				yieldRc = aws_iot_mqtt_internal_offline_queue_drain(pClient);
+			}
+#endif
 		} else {
 			// SSL read and write errors are terminal, connection must be closed and retried
 			if(NETWORK_SSL_READ_ERROR == yieldRc || NETWORK_SSL_WRITE_ERROR == yieldRc || NETWORK_SSL_WRITE_TIMEOUT_ERROR == yieldRc) {
@@ -240,26 +334,8 @@ static IoT_Error_t _aws_iot_mqtt_internal_yield(AWS_IoT_Client *pClient, uint32_
 		}
 
 		if(NETWORK_DISCONNECTED_ERROR == yieldRc) {
-			pClient->clientData.counterNetworkDisconnected++;
-			if(1 == pClient->clientStatus.isAutoReconnectEnabled) {
-				yieldRc = aws_iot_mqtt_set_client_state(pClient, CLIENT_STATE_DISCONNECTED_ERROR,
-														CLIENT_STATE_PENDING_RECONNECT);
-				if(SUCCESS != yieldRc) {
-					FUNC_EXIT_RC(yieldRc);
-				}
-
-				pClient->clientData.currentReconnectWaitInterval = AWS_IOT_MQTT_MIN_RECONNECT_WAIT_INTERVAL;
-				countdown_ms(&(pClient->reconnectDelayTimer), pClient->clientData.currentReconnectWaitInterval);
-
-				for(itr = 0; itr < AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS; itr++) {
-					pClient->clientData.messageHandlers[itr].resubscribed = 0;
-				}
-
-				/* Depending on timer values, it is possible that yield timer has expired
-				 * Set to rc to attempting reconnect to inform client that autoreconnect
-				 * attempt has started */
-				yieldRc = NETWORK_ATTEMPTING_RECONNECT;
-			} else {
+			yieldRc = _aws_iot_mqtt_handle_network_disconnected(pClient);
+			if(NETWORK_ATTEMPTING_RECONNECT != yieldRc) {
 				break;
 			}
 		} else if(SUCCESS != yieldRc) {
@@ -267,17 +343,90 @@ static IoT_Error_t _aws_iot_mqtt_internal_yield(AWS_IoT_Client *pClient, uint32_
 		}
 	} while(!has_timer_expired(&timer));
 
+#ifdef AWS_IOT_MQTT_ENABLE_STATS
+	aws_iot_mqtt_internal_stats_record_yield(pClient, yieldStartUs, idleUs);
+#endif
+
 	FUNC_EXIT_RC(yieldRc);
 }
 
-IoT_Error_t aws_iot_mqtt_yield(AWS_IoT_Client *pClient, uint32_t timeout_ms) {
-	IoT_Error_t rc, yieldRc;
+/**
+ * @brief Process the work that is ready, without waiting on the network
+ *
+ * Handles every packet already received, then the timers that are due. This is the
+ * internal function which is called by the process ready API to perform the operation.
+ *
+ * @param pClient Reference to the IoT Client
+ *
+ * @return An IoT Error Type defining successful/failed client processing.
+ */
+static IoT_Error_t _aws_iot_mqtt_internal_process_ready(AWS_IoT_Client *pClient) {
+	IoT_Error_t rc;
+	uint8_t packet_type;
+	bool isBufferFull;
 	ClientState clientState;
+	Timer timer;
 
-	if(NULL == pClient || 0 == timeout_ms) {
-		FUNC_EXIT_RC(NULL_VALUE_ERROR);
+	FUNC_ENTRY;
+
+	clientState = aws_iot_mqtt_get_client_state(pClient);
+	if((CLIENT_STATE_PENDING_RECONNECT == clientState) ||
+		(CLIENT_STATE_CONNECTED_RESUBSCRIBE_IN_PROGRESS == clientState)) {
+		if(AWS_IOT_MQTT_RECONNECT_GIVE_UP == pClient->clientData.currentReconnectWaitInterval) {
+			FUNC_EXIT_RC(NETWORK_RECONNECT_TIMED_OUT_ERROR);
+		}
+		rc = _aws_iot_mqtt_handle_reconnect(pClient);
+		FUNC_EXIT_RC(rc);
+	}
+
+	if(NULL == pClient->networkStack.readAvailable) {
+		/* Single read attempt with an expired timer */
+		init_timer(&timer);
+		rc = aws_iot_mqtt_internal_cycle_read(pClient, &timer, &packet_type);
+	} else {
+		/* Drain what has been received, a full buffer means more may be waiting */
+		do {
+			rc = aws_iot_mqtt_internal_read_available(pClient, &isBufferFull);
+			while(SUCCESS == rc && aws_iot_mqtt_internal_is_packet_buffered(pClient)) {
+				/* Only a packet larger than the buffer waits on the network */
+				countdown_ms(&timer, pClient->clientData.commandTimeoutMs);
+				rc = aws_iot_mqtt_internal_cycle_read(pClient, &timer, &packet_type);
+			}
+		} while(SUCCESS == rc && isBufferFull);
+	}
+
+	if(SUCCESS == rc) {
+		aws_iot_mqtt_internal_expire_inflight_publishes(pClient);
+		rc = _aws_iot_mqtt_keep_alive(pClient);
+#ifdef AWS_IOT_MQTT_ENABLE_OFFLINE_QUEUE
+		if(SUCCESS == rc) {
+			rc = aws_iot_mqtt_internal_offline_queue_drain(pClient);
+		}
+#endif
+	} else if(NETWORK_SSL_READ_ERROR == rc || NETWORK_SSL_WRITE_ERROR == rc || NETWORK_SSL_WRITE_TIMEOUT_ERROR == rc) {
+		rc = _aws_iot_mqtt_handle_disconnect(pClient);
 	}
 
+	if(NETWORK_DISCONNECTED_ERROR == rc) {
+		rc = _aws_iot_mqtt_handle_network_disconnected(pClient);
+	}
+
+	FUNC_EXIT_RC(rc);
+}
+
+/**
+ * @brief Move the client to the yield in progress state, before yield or process ready
+ *
+ * @param pClient Reference to the IoT Client
+ *
+ * @return SUCCESS if the client can be processed
+ */
+static IoT_Error_t _aws_iot_mqtt_begin_yield(AWS_IoT_Client *pClient) {
+	IoT_Error_t rc;
+	ClientState clientState;
+
+	FUNC_ENTRY;
+
 	clientState = aws_iot_mqtt_get_client_state(pClient);
 	/* Check if network was manually disconnected */
 	if(CLIENT_STATE_DISCONNECTED_MANUALLY == clientState) {
@@ -306,7 +455,21 @@ IoT_Error_t aws_iot_mqtt_yield(AWS_IoT_Client *pClient, uint32_t timeout_ms) {
 		}
 	}
 
-	yieldRc = _aws_iot_mqtt_internal_yield(pClient, timeout_ms);
+	FUNC_EXIT_RC(SUCCESS);
+}
+
+/**
+ * @brief Return the client to the idle state, after yield or process ready
+ *
+ * @param pClient Reference to the IoT Client
+ * @param yieldRc Result of the processing
+ *
+ * @return yieldRc, or the state change error if the processing succeeded
+ */
+static IoT_Error_t _aws_iot_mqtt_end_yield(AWS_IoT_Client *pClient, IoT_Error_t yieldRc) {
+	IoT_Error_t rc;
+
+	FUNC_ENTRY;
 
 	if(NETWORK_DISCONNECTED_ERROR != yieldRc && NETWORK_ATTEMPTING_RECONNECT != yieldRc) {
 		rc = aws_iot_mqtt_set_client_state(pClient, CLIENT_STATE_CONNECTED_YIELD_IN_PROGRESS,
@@ -319,6 +482,104 @@ IoT_Error_t aws_iot_mqtt_yield(AWS_IoT_Client *pClient, uint32_t timeout_ms) {
 	FUNC_EXIT_RC(yieldRc);
 }
 
+IoT_Error_t aws_iot_mqtt_yield(AWS_IoT_Client *pClient, uint32_t timeout_ms) {
+	IoT_Error_t rc, yieldRc;
+
+	if(NULL == pClient || 0 == timeout_ms) {
+		FUNC_EXIT_RC(NULL_VALUE_ERROR);
+	}
+
+	rc = _aws_iot_mqtt_begin_yield(pClient);
+	if(SUCCESS != rc) {
+		FUNC_EXIT_RC(rc);
+	}
+
+	yieldRc = _aws_iot_mqtt_internal_yield(pClient, timeout_ms);
+
+	rc = _aws_iot_mqtt_end_yield(pClient, yieldRc);
+	FUNC_EXIT_RC(rc);
+}
+
+IoT_Error_t aws_iot_mqtt_process_ready(AWS_IoT_Client *pClient) {
+	IoT_Error_t rc, processRc;
+
+	if(NULL == pClient) {
+		FUNC_EXIT_RC(NULL_VALUE_ERROR);
+	}
+
+	rc = _aws_iot_mqtt_begin_yield(pClient);
+	if(SUCCESS != rc) {
+		FUNC_EXIT_RC(rc);
+	}
+
+	processRc = _aws_iot_mqtt_internal_process_ready(pClient);
+
+	rc = _aws_iot_mqtt_end_yield(pClient, processRc);
+	FUNC_EXIT_RC(rc);
+}
+
+int aws_iot_mqtt_get_network_fd(AWS_IoT_Client *pClient) {
+	if(NULL == pClient || NULL == pClient->networkStack.getSocketFd || !aws_iot_mqtt_is_client_connected(pClient)) {
+		return -1;
+	}
+
+	return pClient->networkStack.getSocketFd(&(pClient->networkStack));
+}
+
+/**
+ * @brief Milliseconds until a timer expires, rounded up so that it has expired by then
+ */
+static uint32_t _aws_iot_mqtt_timer_deadline_ms(Timer *pTimer) {
+	if(has_timer_expired(pTimer)) {
+		return 0;
+	}
+
+	return left_ms(pTimer) + 1;
+}
+
+uint32_t aws_iot_mqtt_get_next_deadline_ms(AWS_IoT_Client *pClient) {
+	uint32_t deadline = AWS_IOT_MQTT_NO_DEADLINE, timerDeadline;
+	ClientState clientState;
+
+	if(NULL == pClient) {
+		return AWS_IOT_MQTT_NO_DEADLINE;
+	}
+
+	clientState = aws_iot_mqtt_get_client_state(pClient);
+	if((CLIENT_STATE_PENDING_RECONNECT == clientState) ||
+		(CLIENT_STATE_CONNECTED_RESUBSCRIBE_IN_PROGRESS == clientState)) {
+		return _aws_iot_mqtt_timer_deadline_ms(&(pClient->reconnectDelayTimer));
+	}
+
+	if(!aws_iot_mqtt_is_client_connected(pClient)) {
+		return AWS_IOT_MQTT_NO_DEADLINE;
+	}
+
+	/* Packets read ahead won't wake up the application's poll */
+	if(aws_iot_mqtt_internal_is_packet_buffered(pClient)) {
+		return 0;
+	}
+
+	if(0 != pClient->clientData.keepAliveInterval) {
+		deadline = _aws_iot_mqtt_timer_deadline_ms(pClient->clientStatus.isPingOutstanding ?
+												   &(pClient->pingRespTimer) : &(pClient->pingReqTimer));
+	}
+
+	timerDeadline = aws_iot_mqtt_internal_inflight_deadline_ms(pClient);
+	if(timerDeadline < deadline) {
+		deadline = timerDeadline;
+	}
+
+#ifdef AWS_IOT_MQTT_ENABLE_OFFLINE_QUEUE
+	timerDeadline = aws_iot_mqtt_internal_offline_queue_deadline_ms(pClient);
+	if(timerDeadline < deadline) {
+		deadline = timerDeadline;
+	}
+#endif
+
+	return deadline;
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -36,24 +36,32 @@ const ShadowInitParameters_t ShadowInitParametersDefault = {(char *) AWS_IOT_MQT
 															NULL, false, NULL};
 
 const ShadowConnectParameters_t ShadowConnectParametersDefault = {(char *) AWS_IOT_MY_THING_NAME,
-								  (char *) AWS_IOT_MQTT_CLIENT_ID, 0, NULL};
+								  (char *) AWS_IOT_MQTT_CLIENT_ID, 0, NULL, true, false};
+
+const ShadowContextParameters_t ShadowContextParametersDefault = {NULL, MAX_THINGNAME_HANDLED_AT_ANY_GIVEN_TIME,
+																	MAX_ACKS_TO_COMEIN_AT_ANY_GIVEN_TIME,
+																	MAX_JSON_TOKEN_EXPECTED, MAX_JSON_TOKEN_EXPECTED,
+																	NULL};
+
+/* Thing of the API taking an MQTT client, tracked in the default context */
+static char myThingName[MAX_SIZE_OF_THING_NAME];
 
 static char deleteAcceptedTopic[MAX_SHADOW_TOPIC_LENGTH_BYTES];
 
 void aws_iot_shadow_reset_last_received_version(void) {
-	shadowJsonVersionNum = 0;
+	aws_iot_shadow_context_reset_last_received_version(getShadowDefaultContext(), myThingName);
 }
 
 uint32_t aws_iot_shadow_get_last_received_version(void) {
-	return shadowJsonVersionNum;
+	return aws_iot_shadow_context_get_last_received_version(getShadowDefaultContext(), myThingName);
 }
 
 void aws_iot_shadow_enable_discard_old_delta_msgs(void) {
-	shadowDiscardOldDeltaFlag = true;
+	getShadowDefaultContext()->isDiscardOldDeltaEnabled = true;
 }
 
 void aws_iot_shadow_disable_discard_old_delta_msgs(void) {
-	shadowDiscardOldDeltaFlag = false;
+	getShadowDefaultContext()->isDiscardOldDeltaEnabled = false;
 }
 
 IoT_Error_t aws_iot_shadow_free(AWS_IoT_Client *pClient)
@@ -97,13 +105,13 @@ IoT_Error_t aws_iot_shadow_init(AWS_IoT_Client *pClient, ShadowInitParameters_t
 	}
 
 	resetClientTokenSequenceNum();
-	aws_iot_shadow_reset_last_received_version();
-	initDeltaTokens();
+	resetShadowThings(getShadowDefaultContext());
 
 	FUNC_EXIT_RC(SUCCESS);
 }
 
 IoT_Error_t aws_iot_shadow_connect(AWS_IoT_Client *pClient, ShadowConnectParameters_t *pParams) {
+	ShadowContext_t *pContext = getShadowDefaultContext();
 	IoT_Error_t rc = SUCCESS;
 	uint16_t deleteAcceptedTopicLen;
 	IoT_Client_Connect_Params ConnectParams = iotClientConnectParamsDefault;
@@ -115,11 +123,11 @@ IoT_Error_t aws_iot_shadow_connect(AWS_IoT_Client *pClient, ShadowConnectParamet
 	}
 
 	snprintf(myThingName, MAX_SIZE_OF_THING_NAME, "%s", pParams->pMyThingName);
-	snprintf(mqttClientID, MAX_SIZE_OF_UNIQUE_CLIENT_ID_BYTES, "%s", pParams->pMqttClientId);
+	snprintf(pContext->clientId, MAX_SIZE_OF_UNIQUE_CLIENT_ID_BYTES, "%s", pParams->pMqttClientId);
 
 	ConnectParams.keepAliveIntervalInSec = 600; // NOTE: Temporary fix
 	ConnectParams.MQTTVersion = MQTT_3_1_1;
-	ConnectParams.isCleanSession = true;
+	ConnectParams.isCleanSession = pParams->isCleanSession;
 	ConnectParams.isWillMsgPresent = false;
 	ConnectParams.pClientID = pParams->pMqttClientId;
 	ConnectParams.clientIDLen = pParams->mqttClientIdLen;
@@ -132,7 +140,10 @@ IoT_Error_t aws_iot_shadow_connect(AWS_IoT_Client *pClient, ShadowConnectParamet
 		FUNC_EXIT_RC(rc);
 	}
 
-	initializeRecords(pClient);
+	initializeRecords(pContext, pClient);
+	if(NULL == getOrAddShadowThing(pContext, myThingName)) {
+		FUNC_EXIT_RC(FAILURE);
+	}
 
 	if(NULL != pParams->deleteActionHandler) {
 		snprintf(deleteAcceptedTopic, MAX_SHADOW_TOPIC_LENGTH_BYTES,
@@ -142,6 +153,10 @@ IoT_Error_t aws_iot_shadow_connect(AWS_IoT_Client *pClient, ShadowConnectParamet
 									pParams->deleteActionHandler, (void *) myThingName);
 	}
 
+	if(SUCCESS == rc && pParams->isAckSubscribedOnConnect) {
+		rc = subscribeToShadowAckWildcards(pContext, myThingName);
+	}
+
 	FUNC_EXIT_RC(rc);
 }
 
@@ -154,7 +169,7 @@ IoT_Error_t aws_iot_shadow_register_delta(AWS_IoT_Client *pMqttClient, jsonStruc
 		return MQTT_CONNECTION_ERROR;
 	}
 
-	return registerJsonTokenOnDelta(pStruct);
+	return registerJsonTokenOnDelta(getShadowDefaultContext(), myThingName, pStruct);
 }
 
 IoT_Error_t aws_iot_shadow_yield(AWS_IoT_Client *pClient, uint32_t timeout) {
@@ -162,7 +177,7 @@ IoT_Error_t aws_iot_shadow_yield(AWS_IoT_Client *pClient, uint32_t timeout) {
 		return NULL_VALUE_ERROR;
 	}
 
-	HandleExpiredResponseCallbacks();
+	HandleExpiredResponseCallbacks(getShadowDefaultContext());
 	return aws_iot_mqtt_yield(pClient, timeout);
 }
 
@@ -244,6 +259,217 @@ IoT_Error_t aws_iot_shadow_set_autoreconnect_status(AWS_IoT_Client *pClient, boo
 	return aws_iot_mqtt_autoreconnect_set_status(pClient, newStatus);
 }
 
+size_t aws_iot_shadow_get_context_size(const ShadowContextParameters_t *pParams) {
+	if(NULL == pParams || 0 == pParams->maxThings || 0 == pParams->maxJsonTokens
+	   || pParams->maxThings >= SHADOW_INDEX_NONE / 2
+	   || pParams->maxPendingActions >= SHADOW_INDEX_NONE / 2
+	   || pParams->maxDeltaHandlers >= SHADOW_INDEX_NONE / 2) {
+		return 0;
+	}
+
+	return getShadowContextStorageSize(pParams);
+}
+
+IoT_Error_t aws_iot_shadow_context_init(ShadowContext_t **ppContext, AWS_IoT_Client *pClient,
+										const ShadowContextParameters_t *pParams) {
+	ShadowContext_t *pContext;
+	size_t contextSize;
+
+	FUNC_ENTRY;
+
+	if(NULL == ppContext || NULL == pClient || NULL == pParams || NULL == pParams->pClientId
+	   || NULL == pParams->pAllocator || NULL == pParams->pAllocator->allocate) {
+		FUNC_EXIT_RC(NULL_VALUE_ERROR);
+	}
+
+	if(strlen(pParams->pClientId) >= MAX_SIZE_OF_UNIQUE_CLIENT_ID_BYTES) {
+		FUNC_EXIT_RC(MAX_SIZE_ERROR);
+	}
+
+	contextSize = aws_iot_shadow_get_context_size(pParams);
+	if(0 == contextSize) {
+		FUNC_EXIT_RC(MAX_SIZE_ERROR);
+	}
+
+	pContext = (ShadowContext_t *) pParams->pAllocator->allocate(pParams->pAllocator->pContext, contextSize);
+	if(NULL == pContext) {
+		FUNC_EXIT_RC(MQTT_STORAGE_ALLOCATION_ERROR);
+	}
+
+	memset(pContext, 0, sizeof(ShadowContext_t));
+	setupShadowContext(pContext, pParams);
+	initializeRecords(pContext, pClient);
+	snprintf(pContext->clientId, MAX_SIZE_OF_UNIQUE_CLIENT_ID_BYTES, "%s", pParams->pClientId);
+	pContext->allocator = *(pParams->pAllocator);
+	*ppContext = pContext;
+
+	FUNC_EXIT_RC(SUCCESS);
+}
+
+IoT_Error_t aws_iot_shadow_context_free(ShadowContext_t *pContext) {
+	FUNC_ENTRY;
+
+	if(NULL == pContext) {
+		FUNC_EXIT_RC(NULL_VALUE_ERROR);
+	}
+
+	if(NULL != pContext->allocator.release) {
+		pContext->allocator.release(pContext->allocator.pContext, pContext);
+	}
+
+	FUNC_EXIT_RC(SUCCESS);
+}
+
+IoT_Error_t aws_iot_shadow_context_subscribe_acks(ShadowContext_t *pContext, const char *pThingName) {
+	if(NULL == pContext || NULL == pThingName) {
+		return NULL_VALUE_ERROR;
+	}
+
+	if(!aws_iot_mqtt_is_client_connected(pContext->pMqttClient)) {
+		return MQTT_CONNECTION_ERROR;
+	}
+
+	return subscribeToShadowAckWildcards(pContext, pThingName);
+}
+
+IoT_Error_t aws_iot_shadow_context_yield(ShadowContext_t *pContext, uint32_t timeout) {
+	if(NULL == pContext) {
+		return NULL_VALUE_ERROR;
+	}
+
+	HandleExpiredResponseCallbacks(pContext);
+	return aws_iot_mqtt_yield(pContext->pMqttClient, timeout);
+}
+
+IoT_Error_t aws_iot_shadow_context_update(ShadowContext_t *pContext, const char *pThingName, char *pJsonString,
+										  fpActionCallback_t callback, void *pContextData, uint8_t timeout_seconds,
+										  bool isPersistentSubscribe) {
+	IoT_Error_t rc;
+
+	FUNC_ENTRY;
+
+	if(NULL == pContext || NULL == pJsonString) {
+		FUNC_EXIT_RC(NULL_VALUE_ERROR);
+	}
+
+	if(!aws_iot_mqtt_is_client_connected(pContext->pMqttClient)) {
+		FUNC_EXIT_RC(MQTT_CONNECTION_ERROR);
+	}
+
+	rc = aws_iot_shadow_internal_context_action(pContext, pThingName, SHADOW_UPDATE, pJsonString, strlen(pJsonString),
+												callback, pContextData, timeout_seconds, isPersistentSubscribe);
+
+	FUNC_EXIT_RC(rc);
+}
+
+/* Get and delete requests only hold a client token */
+static IoT_Error_t shadowContextEmptyRequest(ShadowContext_t *pContext, const char *pThingName,
+											 ShadowActions_t action, fpActionCallback_t callback,
+											 void *pContextData, uint8_t timeout_seconds,
+											 bool isPersistentSubscribe) {
+	char requestJsonBuf[MAX_SIZE_CLIENT_TOKEN_CLIENT_SEQUENCE];
+	IoT_Error_t rc;
+
+	FUNC_ENTRY;
+
+	if(NULL == pContext) {
+		FUNC_EXIT_RC(NULL_VALUE_ERROR);
+	}
+
+	if(!aws_iot_mqtt_is_client_connected(pContext->pMqttClient)) {
+		FUNC_EXIT_RC(MQTT_CONNECTION_ERROR);
+	}
+
+	rc = aws_iot_shadow_internal_empty_request_json(pContext, requestJsonBuf, MAX_SIZE_CLIENT_TOKEN_CLIENT_SEQUENCE);
+	if(SUCCESS != rc) {
+		FUNC_EXIT_RC(rc);
+	}
+
+	rc = aws_iot_shadow_internal_context_action(pContext, pThingName, action, requestJsonBuf,
+												MAX_SIZE_CLIENT_TOKEN_CLIENT_SEQUENCE, callback, pContextData,
+												timeout_seconds, isPersistentSubscribe);
+
+	FUNC_EXIT_RC(rc);
+}
+
+IoT_Error_t aws_iot_shadow_context_get(ShadowContext_t *pContext, const char *pThingName,
+									   fpActionCallback_t callback, void *pContextData, uint8_t timeout_seconds,
+									   bool isPersistentSubscribe) {
+	return shadowContextEmptyRequest(pContext, pThingName, SHADOW_GET, callback, pContextData, timeout_seconds,
+									 isPersistentSubscribe);
+}
+
+IoT_Error_t aws_iot_shadow_context_delete(ShadowContext_t *pContext, const char *pThingName,
+										  fpActionCallback_t callback, void *pContextData, uint8_t timeout_seconds,
+										  bool isPersistentSubscribe) {
+	return shadowContextEmptyRequest(pContext, pThingName, SHADOW_DELETE, callback, pContextData, timeout_seconds,
+									 isPersistentSubscribe);
+}
+
+IoT_Error_t aws_iot_shadow_context_register_delta(ShadowContext_t *pContext, const char *pThingName,
+												  jsonStruct_t *pStruct) {
+	if(NULL == pContext || NULL == pThingName || NULL == pStruct) {
+		return NULL_VALUE_ERROR;
+	}
+
+	if(!aws_iot_mqtt_is_client_connected(pContext->pMqttClient)) {
+		return MQTT_CONNECTION_ERROR;
+	}
+
+	return registerJsonTokenOnDelta(pContext, pThingName, pStruct);
+}
+
+IoT_Error_t aws_iot_shadow_context_unregister_delta(ShadowContext_t *pContext, const char *pThingName,
+													jsonStruct_t *pStruct) {
+	if(NULL == pContext || NULL == pThingName || NULL == pStruct) {
+		return NULL_VALUE_ERROR;
+	}
+
+	return unregisterJsonTokenOnDelta(pContext, pThingName, pStruct);
+}
+
+IoT_Error_t aws_iot_shadow_context_remove_thing(ShadowContext_t *pContext, const char *pThingName) {
+	if(NULL == pContext || NULL == pThingName) {
+		return NULL_VALUE_ERROR;
+	}
+
+	return removeShadowThing(pContext, pThingName);
+}
+
+uint32_t aws_iot_shadow_context_get_last_received_version(ShadowContext_t *pContext, const char *pThingName) {
+	ShadowThing_t *pThing;
+
+	if(NULL == pContext || NULL == pThingName) {
+		return 0;
+	}
+
+	pThing = findShadowThing(pContext, pThingName, strlen(pThingName));
+	if(NULL == pThing) {
+		return 0;
+	}
+
+	return pThing->versionNum;
+}
+
+void aws_iot_shadow_context_reset_last_received_version(ShadowContext_t *pContext, const char *pThingName) {
+	ShadowThing_t *pThing;
+
+	if(NULL == pContext || NULL == pThingName) {
+		return;
+	}
+
+	pThing = findShadowThing(pContext, pThingName, strlen(pThingName));
+	if(NULL != pThing) {
+		pThing->versionNum = 0;
+	}
+}
+
+void aws_iot_shadow_context_set_discard_old_delta_msgs(ShadowContext_t *pContext, bool isEnabled) {
+	if(NULL != pContext) {
+		pContext->isDiscardOldDeltaEnabled = isEnabled;
+	}
+}
+
 #ifdef __cplusplus
 }
 #endif
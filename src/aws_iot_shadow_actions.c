@@ -32,10 +32,19 @@ extern "C" {
 IoT_Error_t aws_iot_shadow_internal_action(const char *pThingName, ShadowActions_t action,
 										   const char *pJsonDocumentToBeSent, size_t jsonSize, fpActionCallback_t callback,
 										   void *pCallbackContext, uint32_t timeout_seconds, bool isSticky) {
+	return aws_iot_shadow_internal_context_action(getShadowDefaultContext(), pThingName, action, pJsonDocumentToBeSent,
+												  jsonSize, callback, pCallbackContext, timeout_seconds, isSticky);
+}
+
+IoT_Error_t aws_iot_shadow_internal_context_action(ShadowContext_t *pContext, const char *pThingName,
+												   ShadowActions_t action, const char *pJsonDocumentToBeSent,
+												   size_t jsonSize, fpActionCallback_t callback,
+												   void *pCallbackContext, uint32_t timeout_seconds, bool isSticky) {
 	IoT_Error_t ret_val = SUCCESS;
 	bool isClientTokenPresent = false;
 	bool isAckWaitListFree = false;
-	uint8_t indexAckWaitList;
+	uint16_t indexAckWaitList;
+	int32_t tokenCount;
 	char extractedClientToken[MAX_SIZE_CLIENT_ID_WITH_SEQUENCE];
 
 	FUNC_ENTRY;
@@ -44,18 +53,21 @@ IoT_Error_t aws_iot_shadow_internal_action(const char *pThingName, ShadowActions
 		FUNC_EXIT_RC(NULL_VALUE_ERROR);
 	}
 
-	isClientTokenPresent = extractClientToken(pJsonDocumentToBeSent, jsonSize, extractedClientToken, MAX_SIZE_CLIENT_ID_WITH_SEQUENCE );
+	if(isJsonValidAndParse(pJsonDocumentToBeSent, jsonSize, &(pContext->jsonParser), &tokenCount)) {
+		isClientTokenPresent = extractParsedClientToken(pJsonDocumentToBeSent, &(pContext->jsonParser), tokenCount,
+														extractedClientToken, MAX_SIZE_CLIENT_ID_WITH_SEQUENCE);
+	}
 
 	if(isClientTokenPresent && (NULL != callback)) {
-		if(getNextFreeIndexOfAckWaitList(&indexAckWaitList)) {
+		if(getNextFreeIndexOfAckWaitList(pContext, &indexAckWaitList)) {
 			isAckWaitListFree = true;
 		}
 
 		if(isAckWaitListFree) {
-			if(!isSubscriptionPresent(pThingName, action)) {
-				ret_val = subscribeToShadowActionAcks(pThingName, action, isSticky);
+			if(!isSubscriptionPresent(pContext, pThingName, action)) {
+				ret_val = subscribeToShadowActionAcks(pContext, pThingName, action, isSticky);
 			} else {
-				incrementSubscriptionCnt(pThingName, action, isSticky);
+				incrementSubscriptionCnt(pContext, pThingName, action, isSticky);
 			}
 		}
 		else {
@@ -64,12 +76,12 @@ IoT_Error_t aws_iot_shadow_internal_action(const char *pThingName, ShadowActions
 	}
 
 	if(SUCCESS == ret_val) {
-		ret_val = publishToShadowAction(pThingName, action, pJsonDocumentToBeSent);
+		ret_val = publishToShadowAction(pContext, pThingName, action, pJsonDocumentToBeSent);
 	}
 
 	if(isClientTokenPresent && (NULL != callback) && (SUCCESS == ret_val) && isAckWaitListFree) {
-		addToAckWaitList(indexAckWaitList, pThingName, action, extractedClientToken, callback, pCallbackContext,
-						 timeout_seconds);
+		addToAckWaitList(pContext, indexAckWaitList, pThingName, action, extractedClientToken, callback,
+						 pCallbackContext, timeout_seconds);
 	}
 
 	FUNC_EXIT_RC(ret_val);
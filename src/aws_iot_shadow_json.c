@@ -26,365 +26,447 @@ extern "C" {
 
 #include <string.h>
 #include <stdbool.h>
+#include <stdio.h>
 
 #include "aws_iot_json_utils.h"
 #include "aws_iot_log.h"
 #include "aws_iot_shadow_key.h"
+#include "aws_iot_shadow_records.h"
 #include "aws_iot_config.h"
 
-extern char mqttClientID[MAX_SIZE_OF_UNIQUE_CLIENT_ID_BYTES];
 #define AWS_IOT_SHADOW_CLIENT_TOKEN_KEY "{\"clientToken\":\""
-static uint32_t clientTokenNum = 0;
-
-//helper functions
-static IoT_Error_t convertDataToString(char *pStringBuffer, size_t maxSizoStringBuffer, JsonPrimitiveType type,
-									   void *pData);
 
 void resetClientTokenSequenceNum(void) {
-	clientTokenNum = 0;
-}
-
-static IoT_Error_t emptyJsonWithClientToken(char *pBuffer, size_t bufferSize) {
-
-    IoT_Error_t rc = SUCCESS;
-    size_t dataLenInBuffer = 0;
-
-	if(pBuffer != NULL)
-    {
-        dataLenInBuffer = (size_t)snprintf(pBuffer, bufferSize, AWS_IOT_SHADOW_CLIENT_TOKEN_KEY);
-    }else
-	{
-	    IOT_ERROR("NULL buffer in emptyJsonWithClientToken\n");
-        rc = FAILURE;
-	}
-
-	if(rc == SUCCESS)
-	{
-	    if ( dataLenInBuffer < bufferSize )
-	    {
-	        dataLenInBuffer += (size_t)snprintf(pBuffer + dataLenInBuffer, bufferSize - dataLenInBuffer, "%s-%d", mqttClientID, ( int )clientTokenNum++);
-	    }
-	    else
-	    {
-	        rc = FAILURE;
-	        IOT_ERROR("Supplied buffer too small to create JSON file\n");
-	    }
-    }
-
-	if(rc == SUCCESS)
-	{
-	    if ( dataLenInBuffer < bufferSize )
-	    {
-	        dataLenInBuffer += (size_t)snprintf( pBuffer + dataLenInBuffer, bufferSize - dataLenInBuffer, "\"}" );
-	        if ( dataLenInBuffer > bufferSize )
-	        {
-	            rc = FAILURE;
-	            IOT_ERROR( "Supplied buffer too small to create JSON file\n" );
-	        }
-	    }
-	    else
-	    {
-	        rc = FAILURE;
-	        IOT_ERROR( "Supplied buffer too small to create JSON file\n" );
-	    }
-    }
-
-    FUNC_EXIT_RC(rc);
+	getShadowDefaultContext()->clientTokenNum = 0;
 }
 
-IoT_Error_t aws_iot_shadow_internal_get_request_json(char *pBuffer, size_t bufferSize) {
-	return emptyJsonWithClientToken( pBuffer, bufferSize);
+static IoT_Error_t getJsonWriterStatus(const ShadowJsonWriter_t *pWriter) {
+	return (pWriter->length < pWriter->bufferSize) ? SUCCESS : SHADOW_JSON_BUFFER_TRUNCATED;
 }
 
-IoT_Error_t aws_iot_shadow_internal_delete_request_json(char *pBuffer, size_t bufferSize ) {
-	return emptyJsonWithClientToken( pBuffer, bufferSize);
+/* Copy what fits in the buffer, the length counts all of the text */
+static void appendJsonText(ShadowJsonWriter_t *pWriter, const char *pText, size_t textLength) {
+	size_t copyLength;
+
+	if(pWriter->length + 1 < pWriter->bufferSize) {
+		copyLength = pWriter->bufferSize - pWriter->length - 1;
+		if(copyLength > textLength) {
+			copyLength = textLength;
+		}
+		memcpy(pWriter->pBuffer + pWriter->length, pText, copyLength);
+		pWriter->pBuffer[pWriter->length + copyLength] = '\0';
+	}
+
+	pWriter->length += textLength;
 }
 
-static inline IoT_Error_t checkReturnValueOfSnPrintf(int32_t snPrintfReturn, size_t maxSizeOfJsonDocument) {
-	if(snPrintfReturn < 0) {
+static IoT_Error_t appendJsonFormat(ShadowJsonWriter_t *pWriter, const char *pFormat, ...) {
+	size_t remainingSize = 0;
+	char *pEnd = NULL;
+	int written;
+	va_list pArgs;
+
+	if(pWriter->length < pWriter->bufferSize) {
+		remainingSize = pWriter->bufferSize - pWriter->length;
+		pEnd = pWriter->pBuffer + pWriter->length;
+	}
+
+	va_start(pArgs, pFormat);
+	written = vsnprintf(pEnd, remainingSize, pFormat, pArgs);
+	va_end(pArgs);
+
+	if(written < 0) {
 		return SHADOW_JSON_ERROR;
-	} else if((size_t) snPrintfReturn >= maxSizeOfJsonDocument) {
-		return SHADOW_JSON_BUFFER_TRUNCATED;
 	}
-	return SUCCESS;
+
+	pWriter->length += (size_t) written;
+	return getJsonWriterStatus(pWriter);
 }
 
-IoT_Error_t aws_iot_shadow_init_json_document(char *pJsonDocument, size_t maxSizeOfJsonDocument) {
+static void appendJsonEscapedString(ShadowJsonWriter_t *pWriter, const char *pString) {
+	const char *pRun = pString;
+	char escaped[7];
 
-	IoT_Error_t ret_val = SUCCESS;
-	int32_t snPrintfReturn = 0;
+	appendJsonText(pWriter, "\"", 1);
+	for(; '\0' != *pString; pString++) {
+		if('"' != *pString && '\\' != *pString && (unsigned char) *pString >= 0x20) {
+			continue;
+		}
 
-	if(pJsonDocument == NULL) {
-		return NULL_VALUE_ERROR;
+		/* Characters that need no escaping are copied in runs */
+		appendJsonText(pWriter, pRun, (size_t) (pString - pRun));
+		pRun = pString + 1;
+		switch(*pString) {
+			case '"':
+				appendJsonText(pWriter, "\\\"", 2);
+				break;
+			case '\\':
+				appendJsonText(pWriter, "\\\\", 2);
+				break;
+			case '\n':
+				appendJsonText(pWriter, "\\n", 2);
+				break;
+			case '\r':
+				appendJsonText(pWriter, "\\r", 2);
+				break;
+			case '\t':
+				appendJsonText(pWriter, "\\t", 2);
+				break;
+			default:
+				snprintf(escaped, sizeof(escaped), "\\u%04x", (unsigned int) (unsigned char) *pString);
+				appendJsonText(pWriter, escaped, 6);
+				break;
+		}
 	}
-	snPrintfReturn = snprintf(pJsonDocument, maxSizeOfJsonDocument, "{\"state\":{");
+	appendJsonText(pWriter, pRun, (size_t) (pString - pRun));
+	appendJsonText(pWriter, "\"", 1);
+}
 
-	ret_val = checkReturnValueOfSnPrintf(snPrintfReturn, maxSizeOfJsonDocument);
+/* Comma before all but the first value of a container, then the key if any */
+static void appendJsonKey(ShadowJsonWriter_t *pWriter, const char *pKey) {
+	uint32_t depthBit = (uint32_t) 1 << pWriter->depth;
 
-	return ret_val;
+	if(pWriter->hasMembers & depthBit) {
+		appendJsonText(pWriter, ",", 1);
+	}
+	pWriter->hasMembers |= depthBit;
 
+	if(NULL != pKey) {
+		appendJsonEscapedString(pWriter, pKey);
+		appendJsonText(pWriter, ":", 1);
+	}
 }
 
-IoT_Error_t aws_iot_shadow_add_desired(char *pJsonDocument, size_t maxSizeOfJsonDocument, uint8_t count, ...) {
-	IoT_Error_t ret_val = SUCCESS;
-	size_t tempSize = 0;
-	int8_t i;
-	size_t remSizeOfJsonBuffer = maxSizeOfJsonDocument;
-	int32_t snPrintfReturn = 0;
-	va_list pArgs;
-	jsonStruct_t *pTemporary = NULL;
-	va_start(pArgs, count);
+static IoT_Error_t beginJsonContainer(ShadowJsonWriter_t *pWriter, const char *pKey, bool isArray) {
+	if(NULL == pWriter) {
+		return NULL_VALUE_ERROR;
+	}
 
-	if(pJsonDocument == NULL) {
-		va_end(pArgs);
+	if(pWriter->depth >= SHADOW_JSON_WRITER_MAX_DEPTH) {
+		return SHADOW_JSON_ERROR;
+	}
+
+	appendJsonKey(pWriter, pKey);
+	appendJsonText(pWriter, isArray ? "[" : "{", 1);
+
+	pWriter->depth++;
+	pWriter->hasMembers &= ~((uint32_t) 1 << pWriter->depth);
+	if(isArray) {
+		pWriter->isArray |= (uint32_t) 1 << pWriter->depth;
+	} else {
+		pWriter->isArray &= ~((uint32_t) 1 << pWriter->depth);
+	}
+
+	return getJsonWriterStatus(pWriter);
+}
+
+static IoT_Error_t endJsonContainer(ShadowJsonWriter_t *pWriter, bool isArray) {
+	if(NULL == pWriter) {
 		return NULL_VALUE_ERROR;
 	}
 
-	tempSize = maxSizeOfJsonDocument - strlen(pJsonDocument);
-	if(tempSize <= 1) {
-		va_end(pArgs);
+	if(0 == pWriter->depth || isArray != (0 != (pWriter->isArray & ((uint32_t) 1 << pWriter->depth)))) {
 		return SHADOW_JSON_ERROR;
 	}
-	remSizeOfJsonBuffer = tempSize;
 
-	snPrintfReturn = snprintf(pJsonDocument + strlen(pJsonDocument), remSizeOfJsonBuffer, "\"desired\":{");
-	ret_val = checkReturnValueOfSnPrintf(snPrintfReturn, remSizeOfJsonBuffer);
+	pWriter->depth--;
+	appendJsonText(pWriter, isArray ? "]" : "}", 1);
 
-	if(ret_val != SUCCESS) {
-		va_end(pArgs);
-		return ret_val;
+	return getJsonWriterStatus(pWriter);
+}
+
+IoT_Error_t aws_iot_shadow_json_writer_init(ShadowJsonWriter_t *pWriter, char *pBuffer, size_t bufferSize) {
+	if(NULL == pWriter || NULL == pBuffer) {
+		return NULL_VALUE_ERROR;
 	}
 
-	for(i = 0; i < count; i++) {
-		tempSize = maxSizeOfJsonDocument - strlen(pJsonDocument);
-		if(tempSize <= 1) {
-			va_end(pArgs);
-			return SHADOW_JSON_ERROR;
-		}
-		remSizeOfJsonBuffer = tempSize;
-		pTemporary = va_arg (pArgs, jsonStruct_t *);
-		if(pTemporary != NULL) {
-			snPrintfReturn = snprintf(pJsonDocument + strlen(pJsonDocument), remSizeOfJsonBuffer, "\"%s\":",
-									  pTemporary->pKey);
-			ret_val = checkReturnValueOfSnPrintf(snPrintfReturn, remSizeOfJsonBuffer);
-			if(ret_val != SUCCESS) {
-				va_end(pArgs);
-				return ret_val;
-			}
-			if(pTemporary->pKey != NULL && pTemporary->pData != NULL) {
-				ret_val = convertDataToString(pJsonDocument + strlen(pJsonDocument), remSizeOfJsonBuffer,
-											  pTemporary->type, pTemporary->pData);
-			} else {
-				va_end(pArgs);
-				return NULL_VALUE_ERROR;
-			}
-			if(ret_val != SUCCESS) {
-				va_end(pArgs);
-				return ret_val;
-			}
-		} else {
-			va_end(pArgs);
-			return NULL_VALUE_ERROR;
-		}
+	pWriter->pBuffer = pBuffer;
+	pWriter->bufferSize = bufferSize;
+	pWriter->length = 0;
+	pWriter->depth = 0;
+	pWriter->hasMembers = 0;
+	pWriter->isArray = 0;
+	if(0 < bufferSize) {
+		pBuffer[0] = '\0';
 	}
 
-	va_end(pArgs);
-	snPrintfReturn = snprintf(pJsonDocument + strlen(pJsonDocument) - 1, remSizeOfJsonBuffer, "},");
-	ret_val = checkReturnValueOfSnPrintf(snPrintfReturn, remSizeOfJsonBuffer);
-	return ret_val;
+	return SUCCESS;
 }
 
-IoT_Error_t aws_iot_shadow_add_reported(char *pJsonDocument, size_t maxSizeOfJsonDocument, uint8_t count, ...) {
-	IoT_Error_t ret_val = SUCCESS;
+IoT_Error_t aws_iot_shadow_json_writer_begin_object(ShadowJsonWriter_t *pWriter, const char *pKey) {
+	return beginJsonContainer(pWriter, pKey, false);
+}
 
-	int8_t i;
-	size_t remSizeOfJsonBuffer = maxSizeOfJsonDocument;
-	int32_t snPrintfReturn = 0;
-	size_t tempSize = 0;
-	jsonStruct_t *pTemporary;
-	va_list pArgs;
-	va_start(pArgs, count);
+IoT_Error_t aws_iot_shadow_json_writer_end_object(ShadowJsonWriter_t *pWriter) {
+	return endJsonContainer(pWriter, false);
+}
 
-	if(pJsonDocument == NULL) {
-		va_end(pArgs);
+IoT_Error_t aws_iot_shadow_json_writer_begin_array(ShadowJsonWriter_t *pWriter, const char *pKey) {
+	return beginJsonContainer(pWriter, pKey, true);
+}
+
+IoT_Error_t aws_iot_shadow_json_writer_end_array(ShadowJsonWriter_t *pWriter) {
+	return endJsonContainer(pWriter, true);
+}
+
+IoT_Error_t aws_iot_shadow_json_writer_add_int(ShadowJsonWriter_t *pWriter, const char *pKey, int32_t value) {
+	if(NULL == pWriter) {
 		return NULL_VALUE_ERROR;
 	}
 
+	appendJsonKey(pWriter, pKey);
+	return appendJsonFormat(pWriter, "%ld", (long) value);
+}
 
-	tempSize = maxSizeOfJsonDocument - strlen(pJsonDocument);
-	if(tempSize <= 1) {
-		va_end(pArgs);
-		return SHADOW_JSON_ERROR;
+IoT_Error_t aws_iot_shadow_json_writer_add_uint(ShadowJsonWriter_t *pWriter, const char *pKey, uint32_t value) {
+	if(NULL == pWriter) {
+		return NULL_VALUE_ERROR;
 	}
-	remSizeOfJsonBuffer = tempSize;
 
-	snPrintfReturn = snprintf(pJsonDocument + strlen(pJsonDocument), remSizeOfJsonBuffer, "\"reported\":{");
-	ret_val = checkReturnValueOfSnPrintf(snPrintfReturn, remSizeOfJsonBuffer);
+	appendJsonKey(pWriter, pKey);
+	return appendJsonFormat(pWriter, "%lu", (unsigned long) value);
+}
 
-	if(ret_val != SUCCESS) {
-		va_end(pArgs);
-		return ret_val;
+IoT_Error_t aws_iot_shadow_json_writer_add_float(ShadowJsonWriter_t *pWriter, const char *pKey, double value) {
+	if(NULL == pWriter) {
+		return NULL_VALUE_ERROR;
 	}
 
-	for(i = 0; i < count; i++) {
-		tempSize = maxSizeOfJsonDocument - strlen(pJsonDocument);
-		if(tempSize <= 1) {
-			va_end(pArgs);
-			return SHADOW_JSON_ERROR;
-		}
-		remSizeOfJsonBuffer = tempSize;
-
-		pTemporary = va_arg (pArgs, jsonStruct_t *);
-		if(pTemporary != NULL) {
-			snPrintfReturn = snprintf(pJsonDocument + strlen(pJsonDocument), remSizeOfJsonBuffer, "\"%s\":",
-									  pTemporary->pKey);
-			ret_val = checkReturnValueOfSnPrintf(snPrintfReturn, remSizeOfJsonBuffer);
-			if(ret_val != SUCCESS) {
-				va_end(pArgs);
-				return ret_val;
-			}
-			if(pTemporary->pKey != NULL && pTemporary->pData != NULL) {
-				ret_val = convertDataToString(pJsonDocument + strlen(pJsonDocument), remSizeOfJsonBuffer,
-											  pTemporary->type, pTemporary->pData);
-			} else {
-				va_end(pArgs);
-				return NULL_VALUE_ERROR;
-			}
-			if(ret_val != SUCCESS) {
-				va_end(pArgs);
-				return ret_val;
-			}
-		} else {
-			va_end(pArgs);
-			return NULL_VALUE_ERROR;
-		}
+	appendJsonKey(pWriter, pKey);
+	return appendJsonFormat(pWriter, "%f", value);
+}
+
+IoT_Error_t aws_iot_shadow_json_writer_add_bool(ShadowJsonWriter_t *pWriter, const char *pKey, bool value) {
+	if(NULL == pWriter) {
+		return NULL_VALUE_ERROR;
 	}
 
-	va_end(pArgs);
-	snPrintfReturn = snprintf(pJsonDocument + strlen(pJsonDocument) - 1, remSizeOfJsonBuffer, "},");
-	ret_val = checkReturnValueOfSnPrintf(snPrintfReturn, remSizeOfJsonBuffer);
-	return ret_val;
+	appendJsonKey(pWriter, pKey);
+	if(value) {
+		appendJsonText(pWriter, "true", 4);
+	} else {
+		appendJsonText(pWriter, "false", 5);
+	}
+
+	return getJsonWriterStatus(pWriter);
 }
 
+IoT_Error_t aws_iot_shadow_json_writer_add_string(ShadowJsonWriter_t *pWriter, const char *pKey, const char *pValue) {
+	if(NULL == pWriter || NULL == pValue) {
+		return NULL_VALUE_ERROR;
+	}
 
-int32_t FillWithClientTokenSize(char *pBufferToBeUpdatedWithClientToken, size_t maxSizeOfJsonDocument) {
-	int32_t snPrintfReturn;
-	snPrintfReturn = snprintf(pBufferToBeUpdatedWithClientToken, maxSizeOfJsonDocument, "%s-%d", mqttClientID,
-				  (int) clientTokenNum++);
+	appendJsonKey(pWriter, pKey);
+	appendJsonEscapedString(pWriter, pValue);
 
-	return snPrintfReturn;
+	return getJsonWriterStatus(pWriter);
 }
 
-IoT_Error_t aws_iot_fill_with_client_token(char *pBufferToBeUpdatedWithClientToken, size_t maxSizeOfJsonDocument) {
+IoT_Error_t aws_iot_shadow_json_writer_add_raw(ShadowJsonWriter_t *pWriter, const char *pKey, const char *pJsonValue) {
+	if(NULL == pWriter || NULL == pJsonValue) {
+		return NULL_VALUE_ERROR;
+	}
 
-	int32_t snPrintfRet = 0;
-	snPrintfRet = FillWithClientTokenSize(pBufferToBeUpdatedWithClientToken, maxSizeOfJsonDocument);
-	return checkReturnValueOfSnPrintf(snPrintfRet, maxSizeOfJsonDocument);
+	appendJsonKey(pWriter, pKey);
+	appendJsonText(pWriter, pJsonValue, strlen(pJsonValue));
 
+	return getJsonWriterStatus(pWriter);
 }
 
-IoT_Error_t aws_iot_finalize_json_document(char *pJsonDocument, size_t maxSizeOfJsonDocument) {
-	size_t remSizeOfJsonBuffer = maxSizeOfJsonDocument;
-	int32_t snPrintfReturn = 0;
-	size_t tempSize = 0;
-	IoT_Error_t ret_val = SUCCESS;
+IoT_Error_t aws_iot_shadow_json_writer_add_struct(ShadowJsonWriter_t *pWriter, const jsonStruct_t *pStruct) {
+	IoT_Error_t ret_val = SHADOW_JSON_ERROR;
 
-	if(pJsonDocument == NULL) {
+	if(NULL == pWriter || NULL == pStruct || NULL == pStruct->pKey || NULL == pStruct->pData) {
 		return NULL_VALUE_ERROR;
 	}
 
-	tempSize = maxSizeOfJsonDocument - strlen(pJsonDocument);
-	if(tempSize <= 1) {
+	if(pStruct->type == SHADOW_JSON_INT32) {
+		ret_val = aws_iot_shadow_json_writer_add_int(pWriter, pStruct->pKey, *(int32_t *) (pStruct->pData));
+	} else if(pStruct->type == SHADOW_JSON_INT16) {
+		ret_val = aws_iot_shadow_json_writer_add_int(pWriter, pStruct->pKey, *(int16_t *) (pStruct->pData));
+	} else if(pStruct->type == SHADOW_JSON_INT8) {
+		ret_val = aws_iot_shadow_json_writer_add_int(pWriter, pStruct->pKey, *(int8_t *) (pStruct->pData));
+	} else if(pStruct->type == SHADOW_JSON_UINT32) {
+		ret_val = aws_iot_shadow_json_writer_add_uint(pWriter, pStruct->pKey, *(uint32_t *) (pStruct->pData));
+	} else if(pStruct->type == SHADOW_JSON_UINT16) {
+		ret_val = aws_iot_shadow_json_writer_add_uint(pWriter, pStruct->pKey, *(uint16_t *) (pStruct->pData));
+	} else if(pStruct->type == SHADOW_JSON_UINT8) {
+		ret_val = aws_iot_shadow_json_writer_add_uint(pWriter, pStruct->pKey, *(uint8_t *) (pStruct->pData));
+	} else if(pStruct->type == SHADOW_JSON_DOUBLE) {
+		ret_val = aws_iot_shadow_json_writer_add_float(pWriter, pStruct->pKey, *(double *) (pStruct->pData));
+	} else if(pStruct->type == SHADOW_JSON_FLOAT) {
+		ret_val = aws_iot_shadow_json_writer_add_float(pWriter, pStruct->pKey, *(float *) (pStruct->pData));
+	} else if(pStruct->type == SHADOW_JSON_BOOL) {
+		ret_val = aws_iot_shadow_json_writer_add_bool(pWriter, pStruct->pKey, *(bool *) (pStruct->pData));
+	} else if(pStruct->type == SHADOW_JSON_STRING) {
+		ret_val = aws_iot_shadow_json_writer_add_string(pWriter, pStruct->pKey, (const char *) (pStruct->pData));
+	} else if(pStruct->type == SHADOW_JSON_OBJECT) {
+		ret_val = aws_iot_shadow_json_writer_add_raw(pWriter, pStruct->pKey, (const char *) (pStruct->pData));
+	}
+
+	return ret_val;
+}
+
+size_t aws_iot_shadow_json_writer_get_required_size(const ShadowJsonWriter_t *pWriter) {
+	return pWriter->length + 1;
+}
+
+IoT_Error_t aws_iot_shadow_internal_empty_request_json(ShadowContext_t *pContext, char *pBuffer, size_t bufferSize) {
+	ShadowJsonWriter_t writer;
+
+	FUNC_ENTRY;
+
+	if(SUCCESS != aws_iot_shadow_json_writer_init(&writer, pBuffer, bufferSize)) {
+		IOT_ERROR("NULL buffer in aws_iot_shadow_internal_empty_request_json\n");
+		FUNC_EXIT_RC(FAILURE);
+	}
+
+	if(SUCCESS != appendJsonFormat(&writer, AWS_IOT_SHADOW_CLIENT_TOKEN_KEY "%s-%d\"}", pContext->clientId,
+								   (int) pContext->clientTokenNum++)) {
+		IOT_ERROR("Supplied buffer too small to create JSON file\n");
+		FUNC_EXIT_RC(FAILURE);
+	}
+
+	FUNC_EXIT_RC(SUCCESS);
+}
+
+IoT_Error_t aws_iot_shadow_internal_get_request_json(char *pBuffer, size_t bufferSize) {
+	return aws_iot_shadow_internal_empty_request_json(getShadowDefaultContext(), pBuffer, bufferSize);
+}
+
+IoT_Error_t aws_iot_shadow_internal_delete_request_json(char *pBuffer, size_t bufferSize ) {
+	return aws_iot_shadow_internal_empty_request_json(getShadowDefaultContext(), pBuffer, bufferSize);
+}
+
+static inline IoT_Error_t checkReturnValueOfSnPrintf(int32_t snPrintfReturn, size_t maxSizeOfJsonDocument) {
+	if(snPrintfReturn < 0) {
 		return SHADOW_JSON_ERROR;
+	} else if((size_t) snPrintfReturn >= maxSizeOfJsonDocument) {
+		return SHADOW_JSON_BUFFER_TRUNCATED;
 	}
-	remSizeOfJsonBuffer = tempSize;
+	return SUCCESS;
+}
 
-	// strlen(ShadowTxBuffer) - 1 is to ensure we remove the last ,(comma) that was added
-	snPrintfReturn = snprintf(pJsonDocument + strlen(pJsonDocument) - 1, remSizeOfJsonBuffer, "}, \"%s\":\"",
-							  SHADOW_CLIENT_TOKEN_STRING);
-	ret_val = checkReturnValueOfSnPrintf(snPrintfReturn, remSizeOfJsonBuffer);
+IoT_Error_t aws_iot_shadow_init_json_document(char *pJsonDocument, size_t maxSizeOfJsonDocument) {
+	ShadowJsonWriter_t writer;
 
-	if(ret_val != SUCCESS) {
-		return ret_val;
+	if(pJsonDocument == NULL) {
+		return NULL_VALUE_ERROR;
 	}
-	// refactor this XXX repeated code
-	tempSize = maxSizeOfJsonDocument - strlen(pJsonDocument);
-	if(tempSize <= 1) {
+
+	aws_iot_shadow_json_writer_init(&writer, pJsonDocument, maxSizeOfJsonDocument);
+	aws_iot_shadow_json_writer_begin_object(&writer, NULL);
+	return aws_iot_shadow_json_writer_begin_object(&writer, "state");
+}
+
+/* Append "<section>":{...}, to the document, whose end is searched for once */
+static IoT_Error_t addJsonSection(char *pJsonDocument, size_t maxSizeOfJsonDocument, const char *pSectionKey,
+								  uint8_t count, va_list pArgs) {
+	ShadowJsonWriter_t writer;
+	IoT_Error_t ret_val;
+	size_t documentLength;
+	uint8_t i;
+
+	if(pJsonDocument == NULL) {
+		return NULL_VALUE_ERROR;
+	}
+
+	documentLength = strlen(pJsonDocument);
+	if(documentLength + 1 >= maxSizeOfJsonDocument) {
 		return SHADOW_JSON_ERROR;
 	}
-	remSizeOfJsonBuffer = tempSize;
 
+	aws_iot_shadow_json_writer_init(&writer, pJsonDocument + documentLength, maxSizeOfJsonDocument - documentLength);
+	ret_val = aws_iot_shadow_json_writer_begin_object(&writer, pSectionKey);
 
-	snPrintfReturn = FillWithClientTokenSize(pJsonDocument + strlen(pJsonDocument), remSizeOfJsonBuffer);
-	ret_val = checkReturnValueOfSnPrintf(snPrintfReturn, remSizeOfJsonBuffer);
+	for(i = 0; i < count && ret_val == SUCCESS; i++) {
+		ret_val = aws_iot_shadow_json_writer_add_struct(&writer, va_arg(pArgs, jsonStruct_t *));
+	}
 
 	if(ret_val != SUCCESS) {
 		return ret_val;
 	}
-	tempSize = maxSizeOfJsonDocument - strlen(pJsonDocument);
-	if(tempSize <= 1) {
-		return SHADOW_JSON_ERROR;
-	}
-	remSizeOfJsonBuffer = tempSize;
 
+	aws_iot_shadow_json_writer_end_object(&writer);
+	/* The trailing comma is replaced when the document is finalized */
+	appendJsonText(&writer, ",", 1);
+	return getJsonWriterStatus(&writer);
+}
 
-	snPrintfReturn = snprintf(pJsonDocument + strlen(pJsonDocument), remSizeOfJsonBuffer, "\"}");
-	ret_val = checkReturnValueOfSnPrintf(snPrintfReturn, remSizeOfJsonBuffer);
+IoT_Error_t aws_iot_shadow_add_desired(char *pJsonDocument, size_t maxSizeOfJsonDocument, uint8_t count, ...) {
+	IoT_Error_t ret_val;
+	va_list pArgs;
+
+	va_start(pArgs, count);
+	ret_val = addJsonSection(pJsonDocument, maxSizeOfJsonDocument, "desired", count, pArgs);
+	va_end(pArgs);
 
 	return ret_val;
 }
 
-static IoT_Error_t convertDataToString(char *pStringBuffer, size_t maxSizoStringBuffer, JsonPrimitiveType type,
-									   void *pData) {
-	int32_t snPrintfReturn = 0;
-	IoT_Error_t ret_val = SUCCESS;
-
-	if(maxSizoStringBuffer == 0) {
-		return SHADOW_JSON_ERROR;
-	}
+IoT_Error_t aws_iot_shadow_add_reported(char *pJsonDocument, size_t maxSizeOfJsonDocument, uint8_t count, ...) {
+	IoT_Error_t ret_val;
+	va_list pArgs;
 
-	if(type == SHADOW_JSON_INT32) {
-		snPrintfReturn = snprintf(pStringBuffer, maxSizoStringBuffer, "%i,", *(int32_t *) (pData));
-	} else if(type == SHADOW_JSON_INT16) {
-		snPrintfReturn = snprintf(pStringBuffer, maxSizoStringBuffer, "%hi,", *(int16_t *) (pData));
-	} else if(type == SHADOW_JSON_INT8) {
-		snPrintfReturn = snprintf(pStringBuffer, maxSizoStringBuffer, "%hhi,", *(int8_t *) (pData));
-	} else if(type == SHADOW_JSON_UINT32) {
-		snPrintfReturn = snprintf(pStringBuffer, maxSizoStringBuffer, "%u,", *(uint32_t *) (pData));
-	} else if(type == SHADOW_JSON_UINT16) {
-		snPrintfReturn = snprintf(pStringBuffer, maxSizoStringBuffer, "%hu,", *(uint16_t *) (pData));
-	} else if(type == SHADOW_JSON_UINT8) {
-		snPrintfReturn = snprintf(pStringBuffer, maxSizoStringBuffer, "%hhu,", *(uint8_t *) (pData));
-	} else if(type == SHADOW_JSON_DOUBLE) {
-		snPrintfReturn = snprintf(pStringBuffer, maxSizoStringBuffer, "%f,", *(double *) (pData));
-	} else if(type == SHADOW_JSON_FLOAT) {
-		snPrintfReturn = snprintf(pStringBuffer, maxSizoStringBuffer, "%f,", *(float *) (pData));
-	} else if(type == SHADOW_JSON_BOOL) {
-		snPrintfReturn = snprintf(pStringBuffer, maxSizoStringBuffer, "%s,", *(bool *) (pData) ? "true" : "false");
-	} else if(type == SHADOW_JSON_STRING) {
-		snPrintfReturn = snprintf(pStringBuffer, maxSizoStringBuffer, "\"%s\",", (char *) (pData));
-	} else if(type == SHADOW_JSON_OBJECT) {
-		snPrintfReturn = snprintf(pStringBuffer, maxSizoStringBuffer, "%s,", (char *) (pData));
-	}
-
-
-	ret_val = checkReturnValueOfSnPrintf(snPrintfReturn, maxSizoStringBuffer);
+	va_start(pArgs, count);
+	ret_val = addJsonSection(pJsonDocument, maxSizeOfJsonDocument, "reported", count, pArgs);
+	va_end(pArgs);
 
 	return ret_val;
 }
 
-static jsmn_parser shadowJsonParser;
-static jsmntok_t jsonTokenStruct[MAX_JSON_TOKEN_EXPECTED];
+static int32_t FillWithClientTokenSize(ShadowContext_t *pContext, char *pBufferToBeUpdatedWithClientToken,
+									   size_t maxSizeOfJsonDocument) {
+	int32_t snPrintfReturn;
+	snPrintfReturn = snprintf(pBufferToBeUpdatedWithClientToken, maxSizeOfJsonDocument, "%s-%d", pContext->clientId,
+				  (int) pContext->clientTokenNum++);
 
-bool isJsonValidAndParse(const char *pJsonDocument, size_t jsonSize, void *pJsonHandler, int32_t *pTokenCount) {
-	int32_t tokenCount;
+	return snPrintfReturn;
+}
 
-	IOT_UNUSED(pJsonHandler);
+IoT_Error_t aws_iot_fill_with_client_token(char *pBufferToBeUpdatedWithClientToken, size_t maxSizeOfJsonDocument) {
+
+	int32_t snPrintfRet = 0;
+	snPrintfRet = FillWithClientTokenSize(getShadowDefaultContext(), pBufferToBeUpdatedWithClientToken,
+										  maxSizeOfJsonDocument);
+	return checkReturnValueOfSnPrintf(snPrintfRet, maxSizeOfJsonDocument);
+
+}
+
+IoT_Error_t aws_iot_finalize_json_document(char *pJsonDocument, size_t maxSizeOfJsonDocument) {
+	return aws_iot_shadow_context_finalize_json_document(getShadowDefaultContext(), pJsonDocument,
+														 maxSizeOfJsonDocument);
+}
+
+IoT_Error_t aws_iot_shadow_context_finalize_json_document(ShadowContext_t *pContext, char *pJsonDocument,
+														  size_t maxSizeOfJsonDocument) {
+	ShadowJsonWriter_t writer;
+	size_t documentLength;
+
+	if(pContext == NULL || pJsonDocument == NULL) {
+		return NULL_VALUE_ERROR;
+	}
+
+	documentLength = strlen(pJsonDocument);
+	if(0 == documentLength || documentLength + 1 >= maxSizeOfJsonDocument) {
+		return SHADOW_JSON_ERROR;
+	}
 
-	jsmn_init(&shadowJsonParser);
+	// Start over the last ,(comma) that was added
+	aws_iot_shadow_json_writer_init(&writer, pJsonDocument + documentLength - 1,
+									maxSizeOfJsonDocument - documentLength + 1);
+	return appendJsonFormat(&writer, "}, \"%s\":\"%s-%d\"}", SHADOW_CLIENT_TOKEN_STRING, pContext->clientId,
+							(int) pContext->clientTokenNum++);
+}
 
-	tokenCount = jsmn_parse(&shadowJsonParser, pJsonDocument, jsonSize, jsonTokenStruct,
-							sizeof(jsonTokenStruct) / sizeof(jsonTokenStruct[0]));
+bool isJsonValidAndParse(const char *pJsonDocument, size_t jsonSize, ShadowJsonParser_t *pJsonParser,
+						 int32_t *pTokenCount) {
+	int32_t tokenCount;
+
+	jsmn_init(&(pJsonParser->parser));
+
+	tokenCount = jsmn_parse(&(pJsonParser->parser), pJsonDocument, jsonSize, pJsonParser->pTokens,
+							pJsonParser->maxTokens);
 
 	if(tokenCount < 0) {
 		IOT_WARN("Failed to parse JSON: %d\n", tokenCount);
@@ -392,7 +474,7 @@ bool isJsonValidAndParse(const char *pJsonDocument, size_t jsonSize, void *pJson
 	}
 
 	/* Assume the top-level element is an object */
-	if(tokenCount < 1 || jsonTokenStruct[0].type != JSMN_OBJECT) {
+	if(tokenCount < 1 || pJsonParser->pTokens[0].type != JSMN_OBJECT) {
 		IOT_WARN("Top Level is not an object\n");
 		return false;
 	}
@@ -429,61 +511,114 @@ static IoT_Error_t UpdateValueIfNoObject(const char *pJsonString, jsonStruct_t *
 	return ret_val;
 }
 
-bool isJsonKeyMatchingAndUpdateValue(const char *pJsonDocument, void *pJsonHandler, int32_t tokenCount,
-									 jsonStruct_t *pDataStruct, uint32_t *pDataLength, int32_t *pDataPosition) {
-	int32_t i, metadataEnd;
-	uint32_t dataLength;
-	jsmntok_t dataToken;
-
-	IOT_UNUSED(pJsonHandler);
-
-	for(i = 1; i < tokenCount; ) {
-		if(jsoneq(pJsonDocument, &(jsonTokenStruct[i]), pDataStruct->pKey) == 0) {
-			dataToken = jsonTokenStruct[i + 1];
-			dataLength = (uint32_t) (dataToken.end - dataToken.start);
-			UpdateValueIfNoObject(pJsonDocument, pDataStruct, dataToken);
-			*pDataPosition = dataToken.start;
-			*pDataLength = dataLength;
-			return true;
-		} else if(jsoneq(pJsonDocument, &(jsonTokenStruct[i]), "metadata") == 0) {
-			/* Sanity check: must not be at the last key in the json object. */
-			if(i >= tokenCount-2)
-			{
-				return false;
-			}
+IoT_Error_t updateParsedJsonValue(const char *pJsonDocument, ShadowJsonParser_t *pJsonParser, int32_t valueToken,
+								  jsonStruct_t *pDataStruct) {
+	return UpdateValueIfNoObject(pJsonDocument, pDataStruct, pJsonParser->pTokens[valueToken]);
+}
+
+uint32_t hashJsonKey(const char *pKey, size_t keyLength) {
+	uint32_t hash = 2166136261u;
+	size_t i;
 
-			/* Record where the metadata object ends. */
-			metadataEnd = jsonTokenStruct[i+1].end;
+	for(i = 0; i < keyLength; i++) {
+		hash ^= (unsigned char) pKey[i];
+		hash *= 16777619u;
+	}
 
-			/* Skip past the "metadata" key and jsmn object element. */
-			i+= 2;
+	return hash;
+}
+
+/* First token after the value starting at token i and all the tokens nested in it */
+static int32_t skipParsedJsonValue(const jsmntok_t *pTokens, int32_t i, int32_t tokenCount) {
+	int32_t next = i + 1;
+
+	while(next < tokenCount && pTokens[next].start < pTokens[i].end) {
+		next++;
+	}
 
-			/* Skip past every key inside "metadata". Keys inside "metadata" have
-			 * have an end character before the end of the metadata object.
-			 */
-			while(jsonTokenStruct[i].end < metadataEnd)
-			{
+	return next;
+}
+
+void walkParsedJsonMembers(const char *pJsonDocument, ShadowJsonParser_t *pJsonParser, int32_t tokenCount,
+						   ShadowJsonMemberVisitor_t visitor, void *pVisitorData) {
+	jsmntok_t *pTokens = pJsonParser->pTokens;
+	/* Level 0 is the top level object, the next levels are the objects and arrays being walked */
+	ShadowJsonMember_t members[SHADOW_JSON_MAX_WALK_DEPTH + 1];
+	const ShadowJsonMember_t *pOwner[SHADOW_JSON_MAX_WALK_DEPTH + 1];
+	int32_t containerEnd[SHADOW_JSON_MAX_WALK_DEPTH + 1];
+	bool isObject[SHADOW_JSON_MAX_WALK_DEPTH + 1];
+	ShadowJsonMember_t *pMember;
+	jsmntok_t *pValue;
+	int32_t depth = 0;
+	int32_t i = 1;
+
+	pOwner[0] = NULL;
+	containerEnd[0] = pTokens[0].end;
+	isObject[0] = true;
+
+	/* Tokens are in document order, each one is visited once */
+	while(i < tokenCount) {
+		while(0 < depth && pTokens[i].start >= containerEnd[depth]) {
+			depth--;
+		}
+
+		if(!isObject[depth]) {
+			/* Array elements have no key, the members of an object in an array belong to the array's owner */
+			pValue = &(pTokens[i]);
+			if((JSMN_OBJECT == pValue->type || JSMN_ARRAY == pValue->type) && depth < SHADOW_JSON_MAX_WALK_DEPTH) {
+				depth++;
+				pOwner[depth] = pOwner[depth - 1];
+				containerEnd[depth] = pValue->end;
+				isObject[depth] = (JSMN_OBJECT == pValue->type);
 				i++;
+			} else {
+				i = skipParsedJsonValue(pTokens, i, tokenCount);
 			}
+			continue;
+		}
+
+		if(i + 1 >= tokenCount) {
+			break;
 		}
-		else
-		{
-			/* Only increment the loop counter if the current object doesn't
-			 * match AND isn't "metadata".
-			 */
-			i++;
+
+		/* Timestamps of the delta, their keys are the keys of the state */
+		if(jsoneq(pJsonDocument, &(pTokens[i]), "metadata") == 0) {
+			i = skipParsedJsonValue(pTokens, i + 1, tokenCount);
+			continue;
+		}
+
+		pMember = &(members[depth]);
+		pValue = &(pTokens[i + 1]);
+		pMember->pKey = pJsonDocument + pTokens[i].start;
+		pMember->keyLength = (uint32_t) (pTokens[i].end - pTokens[i].start);
+		pMember->keyHash = hashJsonKey(pMember->pKey, pMember->keyLength);
+		pMember->valueToken = i + 1;
+		pMember->valueStart = pValue->start;
+		pMember->valueLength = (uint32_t) (pValue->end - pValue->start);
+		pMember->pParent = pOwner[depth];
+		visitor(pVisitorData, pMember);
+
+		if((JSMN_OBJECT == pValue->type || JSMN_ARRAY == pValue->type) && depth < SHADOW_JSON_MAX_WALK_DEPTH) {
+			depth++;
+			pOwner[depth] = pMember;
+			containerEnd[depth] = pValue->end;
+			isObject[depth] = (JSMN_OBJECT == pValue->type);
+			i += 2;
+		} else {
+			i = skipParsedJsonValue(pTokens, i + 1, tokenCount);
 		}
 	}
-	return false;
 }
 
+/* Parsed with the tokens of the default context */
 bool isReceivedJsonValid(const char *pJsonDocument, size_t jsonSize ) {
+	ShadowJsonParser_t *pJsonParser = &(getShadowDefaultContext()->jsonParser);
 	int32_t tokenCount;
 
-	jsmn_init(&shadowJsonParser);
+	jsmn_init(&(pJsonParser->parser));
 
-	tokenCount = jsmn_parse(&shadowJsonParser, pJsonDocument, jsonSize, jsonTokenStruct,
-							sizeof(jsonTokenStruct) / sizeof(jsonTokenStruct[0]));
+	tokenCount = jsmn_parse(&(pJsonParser->parser), pJsonDocument, jsonSize, pJsonParser->pTokens,
+							pJsonParser->maxTokens);
 
 	if(tokenCount < 0) {
 		IOT_WARN("Failed to parse JSON: %d\n", tokenCount);
@@ -491,35 +626,35 @@ bool isReceivedJsonValid(const char *pJsonDocument, size_t jsonSize ) {
 	}
 
 	/* Assume the top-level element is an object */
-	if(tokenCount < 1 || jsonTokenStruct[0].type != JSMN_OBJECT) {
+	if(tokenCount < 1 || pJsonParser->pTokens[0].type != JSMN_OBJECT) {
 		return false;
 	}
 
 	return true;
 }
 
+/* Parsed with the tokens of the default context */
 bool extractClientToken(const char *pJsonDocument, size_t jsonSize, char *pExtractedClientToken, size_t clientTokenSize) {
-	int32_t tokenCount, i;
-	size_t length;
-	jsmntok_t ClientJsonToken;
-	jsmn_init(&shadowJsonParser);
-
-	tokenCount = jsmn_parse(&shadowJsonParser, pJsonDocument, jsonSize, jsonTokenStruct,
-							sizeof(jsonTokenStruct) / sizeof(jsonTokenStruct[0]));
+	ShadowJsonParser_t *pJsonParser = &(getShadowDefaultContext()->jsonParser);
+	int32_t tokenCount;
 
-	if(tokenCount < 0) {
-		IOT_WARN("Failed to parse JSON: %d\n", tokenCount);
+	if(!isJsonValidAndParse(pJsonDocument, jsonSize, pJsonParser, &tokenCount)) {
 		return false;
 	}
 
-	/* Assume the top-level element is an object */
-	if(tokenCount < 1 || jsonTokenStruct[0].type != JSMN_OBJECT) {
-		return false;
-	}
+	return extractParsedClientToken(pJsonDocument, pJsonParser, tokenCount, pExtractedClientToken, clientTokenSize);
+}
+
+bool extractParsedClientToken(const char *pJsonDocument, ShadowJsonParser_t *pJsonParser, int32_t tokenCount,
+							  char *pExtractedClientToken, size_t clientTokenSize) {
+	jsmntok_t *pTokens = pJsonParser->pTokens;
+	int32_t i;
+	size_t length;
+	jsmntok_t ClientJsonToken;
 
 	for(i = 1; i < tokenCount; i++) {
-		if(jsoneq(pJsonDocument, &jsonTokenStruct[i], SHADOW_CLIENT_TOKEN_STRING) == 0) {
-			ClientJsonToken = jsonTokenStruct[i + 1];
+		if(jsoneq(pJsonDocument, &pTokens[i], SHADOW_CLIENT_TOKEN_STRING) == 0) {
+			ClientJsonToken = pTokens[i + 1];
 			length = (size_t) (ClientJsonToken.end - ClientJsonToken.start);
             if (clientTokenSize >= length + 1)
             {
@@ -536,15 +671,15 @@ bool extractClientToken(const char *pJsonDocument, size_t jsonSize, char *pExtra
 	return false;
 }
 
-bool extractVersionNumber(const char *pJsonDocument, void *pJsonHandler, int32_t tokenCount, uint32_t *pVersionNumber) {
+bool extractVersionNumber(const char *pJsonDocument, ShadowJsonParser_t *pJsonParser, int32_t tokenCount,
+						  uint32_t *pVersionNumber) {
+	jsmntok_t *pTokens = pJsonParser->pTokens;
 	int32_t i;
 	IoT_Error_t ret_val = SUCCESS;
 
-	IOT_UNUSED(pJsonHandler);
-
 	for(i = 1; i < tokenCount; i++) {
-		if(jsoneq(pJsonDocument, &(jsonTokenStruct[i]), SHADOW_VERSION_STRING) == 0) {
-			ret_val = parseUnsignedInteger32Value(pVersionNumber, pJsonDocument, &jsonTokenStruct[i + 1]);
+		if(jsoneq(pJsonDocument, &(pTokens[i]), SHADOW_VERSION_STRING) == 0) {
+			ret_val = parseUnsignedInteger32Value(pVersionNumber, pJsonDocument, &pTokens[i + 1]);
 			if(ret_val == SUCCESS) {
 				return true;
 			}
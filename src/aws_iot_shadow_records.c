@@ -14,8 +14,8 @@
  */
 
 /**
- * @file aws_iot_mqtt_client_subscribe.c
- * @brief MQTT client subscribe API definitions
+ * @file aws_iot_shadow_records.c
+ * @brief Shadow client records of the actions, subscriptions and things of a context
  */
 
 #ifdef __cplusplus
@@ -27,64 +27,40 @@ extern "C" {
 #include <string.h>
 #include <stdio.h>
 
-#include "timer_interface.h"
+#include "aws_iot_timer_wheel.h"
 #include "aws_iot_json_utils.h"
 #include "aws_iot_log.h"
 #include "aws_iot_shadow_json.h"
 #include "aws_iot_config.h"
 
-typedef struct {
-	char clientTokenID[MAX_SIZE_CLIENT_ID_WITH_SEQUENCE];
-	char thingName[MAX_SIZE_OF_THING_NAME];
-	ShadowActions_t action;
-	fpActionCallback_t callback;
-	void *pCallbackContext;
-	bool isFree;
-	Timer timer;
-} ToBeReceivedAckRecord_t;
-
-typedef struct {
-	const char *pKey;
-	void *pStruct;
-	jsonStructCallback_t callback;
-	bool isFree;
-} JsonTokenTable_t;
-
-typedef struct {
-	char Topic[MAX_SHADOW_TOPIC_LENGTH_BYTES];
-	uint8_t count;
-	bool isFree;
-	bool isSticky;
-} SubscriptionRecord_t;
-
 typedef enum {
 	SHADOW_ACCEPTED, SHADOW_REJECTED, SHADOW_ACTION
 } ShadowAckTopicTypes_t;
 
-ToBeReceivedAckRecord_t AckWaitList[MAX_ACKS_TO_COMEIN_AT_ANY_GIVEN_TIME];
-
-AWS_IoT_Client *pMqttClient;
-
-char myThingName[MAX_SIZE_OF_THING_NAME];
-char mqttClientID[MAX_SIZE_OF_UNIQUE_CLIENT_ID_BYTES];
-
-char shadowDeltaTopic[MAX_SHADOW_TOPIC_LENGTH_BYTES];
+/** Prefix of every shadow topic, followed by the thing name */
+#define SHADOW_TOPIC_PREFIX "$aws/things/"
+#define SHADOW_TOPIC_PREFIX_LEN 12
 
 #define MAX_TOPICS_AT_ANY_GIVEN_TIME 2*MAX_THINGNAME_HANDLED_AT_ANY_GIVEN_TIME
-SubscriptionRecord_t SubscriptionList[MAX_TOPICS_AT_ANY_GIVEN_TIME];
-
-#define SUBSCRIBE_SETTLING_TIME 2
-char shadowRxBuf[SHADOW_MAX_SIZE_OF_RX_BUFFER];
 
-static JsonTokenTable_t tokenTable[MAX_JSON_TOKEN_EXPECTED];
-static uint32_t tokenTableIndex = 0;
-static bool deltaTopicSubscribedFlag = false;
-uint32_t shadowJsonVersionNum = 0;
-bool shadowDiscardOldDeltaFlag = true;
+/* Tables of the default context */
+static ToBeReceivedAckRecord_t AckWaitList[MAX_ACKS_TO_COMEIN_AT_ANY_GIVEN_TIME];
+static TimerWheelEntry AckWaitWheelEntries[MAX_ACKS_TO_COMEIN_AT_ANY_GIVEN_TIME];
+static uint16_t AckTokenIndex[2 * MAX_ACKS_TO_COMEIN_AT_ANY_GIVEN_TIME];
+static SubscriptionRecord_t SubscriptionList[MAX_TOPICS_AT_ANY_GIVEN_TIME];
+static ShadowThing_t ThingList[MAX_THINGNAME_HANDLED_AT_ANY_GIVEN_TIME];
+static uint16_t ThingIndex[2 * MAX_THINGNAME_HANDLED_AT_ANY_GIVEN_TIME];
+static ShadowDeltaHandler_t DeltaHandlerList[MAX_JSON_TOKEN_EXPECTED];
+static uint16_t DeltaKeyIndex[2 * MAX_JSON_TOKEN_EXPECTED];
+static jsmntok_t JsonTokens[MAX_JSON_TOKEN_EXPECTED];
+static ShadowContext_t shadowDefaultContext;
 
 // local helper functions
-static void AckStatusCallback(AWS_IoT_Client *pClient, char *topicName,
-							  uint16_t topicNameLen, IoT_Publish_Message_Params *params, void *pData);
+static void AckAcceptedCallback(AWS_IoT_Client *pClient, char *topicName,
+								uint16_t topicNameLen, IoT_Publish_Message_Params *params, void *pData);
+
+static void AckRejectedCallback(AWS_IoT_Client *pClient, char *topicName,
+								uint16_t topicNameLen, IoT_Publish_Message_Params *params, void *pData);
 
 static void shadow_delta_callback(AWS_IoT_Client *pClient, char *topicName,
 								  uint16_t topicNameLen, IoT_Publish_Message_Params *params, void *pData);
@@ -92,48 +68,463 @@ static void shadow_delta_callback(AWS_IoT_Client *pClient, char *topicName,
 static void topicNameFromThingAndAction(char *pTopic, const char *pThingName, ShadowActions_t action,
 										ShadowAckTopicTypes_t ackType);
 
-static int16_t getNextFreeIndexOfSubscriptionList(void);
+static int32_t getNextFreeIndexOfSubscriptionList(ShadowContext_t *pContext);
+
+static void unsubscribeFromAcceptedAndRejected(ShadowContext_t *pContext, uint16_t index);
+
+static size_t alignShadowStorage(size_t size) {
+	return (size + AWS_IOT_MQTT_STORAGE_ALIGNMENT - 1) & ~((size_t) AWS_IOT_MQTT_STORAGE_ALIGNMENT - 1);
+}
+
+static void attachShadowContextTables(ShadowContext_t *pContext, ToBeReceivedAckRecord_t *pAckWaitList,
+									  TimerWheelEntry *pAckWaitWheelEntries, uint16_t *pAckTokenIndex,
+									  uint16_t maxPendingActions, SubscriptionRecord_t *pSubscriptionList, ShadowThing_t *pThings,
+									  uint16_t *pThingIndex, uint16_t maxThings,
+									  ShadowDeltaHandler_t *pDeltaHandlers, uint16_t *pDeltaKeyIndex,
+									  uint16_t maxDeltaHandlers, jsmntok_t *pJsonTokens, uint16_t maxJsonTokens) {
+	pContext->pAckWaitList = pAckWaitList;
+	pContext->ackWaitListSize = maxPendingActions;
+	aws_iot_timer_wheel_init(&(pContext->ackWaitWheel), pAckWaitWheelEntries, maxPendingActions);
+	pContext->pAckTokenIndex = pAckTokenIndex;
+	pContext->ackTokenIndexSize = (uint16_t) (2 * maxPendingActions);
+	pContext->pSubscriptionList = pSubscriptionList;
+	pContext->subscriptionListSize = (uint16_t) (2 * maxThings);
+	pContext->pThings = pThings;
+	pContext->maxThings = maxThings;
+	pContext->pThingIndex = pThingIndex;
+	pContext->thingIndexSize = (uint16_t) (2 * maxThings);
+	pContext->pDeltaHandlers = pDeltaHandlers;
+	pContext->maxDeltaHandlers = maxDeltaHandlers;
+	pContext->pDeltaKeyIndex = pDeltaKeyIndex;
+	pContext->deltaKeyIndexSize = (uint16_t) (2 * maxDeltaHandlers);
+	pContext->jsonParser.pTokens = pJsonTokens;
+	pContext->jsonParser.maxTokens = maxJsonTokens;
+	pContext->isDiscardOldDeltaEnabled = true;
+	pContext->clientTokenNum = 0;
+	resetShadowThings(pContext);
+	initializeRecords(pContext, NULL);
+}
+
+ShadowContext_t *getShadowDefaultContext(void) {
+	if(NULL == shadowDefaultContext.pThings) {
+		attachShadowContextTables(&shadowDefaultContext, AckWaitList, AckWaitWheelEntries, AckTokenIndex,
+								  MAX_ACKS_TO_COMEIN_AT_ANY_GIVEN_TIME, SubscriptionList, ThingList, ThingIndex,
+								  MAX_THINGNAME_HANDLED_AT_ANY_GIVEN_TIME, DeltaHandlerList, DeltaKeyIndex,
+								  MAX_JSON_TOKEN_EXPECTED, JsonTokens, MAX_JSON_TOKEN_EXPECTED);
+	}
+
+	return &shadowDefaultContext;
+}
+
+size_t getShadowContextStorageSize(const ShadowContextParameters_t *pParams) {
+	return alignShadowStorage(sizeof(ShadowContext_t))
+		   + alignShadowStorage(pParams->maxPendingActions * sizeof(ToBeReceivedAckRecord_t))
+		   + alignShadowStorage(pParams->maxPendingActions * sizeof(TimerWheelEntry))
+		   + alignShadowStorage(2 * (size_t) pParams->maxPendingActions * sizeof(uint16_t))
+		   + alignShadowStorage(2 * (size_t) pParams->maxThings * sizeof(SubscriptionRecord_t))
+		   + alignShadowStorage(pParams->maxThings * sizeof(ShadowThing_t))
+		   + alignShadowStorage(2 * (size_t) pParams->maxThings * sizeof(uint16_t))
+		   + alignShadowStorage(pParams->maxDeltaHandlers * sizeof(ShadowDeltaHandler_t))
+		   + alignShadowStorage(2 * (size_t) pParams->maxDeltaHandlers * sizeof(uint16_t))
+		   + alignShadowStorage(pParams->maxJsonTokens * sizeof(jsmntok_t));
+}
+
+void setupShadowContext(ShadowContext_t *pContext, const ShadowContextParameters_t *pParams) {
+	unsigned char *pStorage = (unsigned char *) pContext + alignShadowStorage(sizeof(ShadowContext_t));
+	ToBeReceivedAckRecord_t *pAckWaitList;
+	TimerWheelEntry *pAckWaitWheelEntries;
+	uint16_t *pAckTokenIndex;
+	SubscriptionRecord_t *pSubscriptionList;
+	ShadowThing_t *pThings;
+	uint16_t *pThingIndex;
+	ShadowDeltaHandler_t *pDeltaHandlers;
+	uint16_t *pDeltaKeyIndex;
+
+	/* The tables follow the context in its block */
+	pAckWaitList = (ToBeReceivedAckRecord_t *) pStorage;
+	pStorage += alignShadowStorage(pParams->maxPendingActions * sizeof(ToBeReceivedAckRecord_t));
+	pAckWaitWheelEntries = (TimerWheelEntry *) pStorage;
+	pStorage += alignShadowStorage(pParams->maxPendingActions * sizeof(TimerWheelEntry));
+	pAckTokenIndex = (uint16_t *) pStorage;
+	pStorage += alignShadowStorage(2 * (size_t) pParams->maxPendingActions * sizeof(uint16_t));
+	pSubscriptionList = (SubscriptionRecord_t *) pStorage;
+	pStorage += alignShadowStorage(2 * (size_t) pParams->maxThings * sizeof(SubscriptionRecord_t));
+	pThings = (ShadowThing_t *) pStorage;
+	pStorage += alignShadowStorage(pParams->maxThings * sizeof(ShadowThing_t));
+	pThingIndex = (uint16_t *) pStorage;
+	pStorage += alignShadowStorage(2 * (size_t) pParams->maxThings * sizeof(uint16_t));
+	pDeltaHandlers = (ShadowDeltaHandler_t *) pStorage;
+	pStorage += alignShadowStorage(pParams->maxDeltaHandlers * sizeof(ShadowDeltaHandler_t));
+	pDeltaKeyIndex = (uint16_t *) pStorage;
+	pStorage += alignShadowStorage(2 * (size_t) pParams->maxDeltaHandlers * sizeof(uint16_t));
+
+	attachShadowContextTables(pContext, pAckWaitList, pAckWaitWheelEntries, pAckTokenIndex,
+							  pParams->maxPendingActions, pSubscriptionList, pThings, pThingIndex, pParams->maxThings,
+							  pDeltaHandlers, pDeltaKeyIndex, pParams->maxDeltaHandlers,
+							  (jsmntok_t *) pStorage, pParams->maxJsonTokens);
+}
+
+void resetShadowThings(ShadowContext_t *pContext) {
+	uint16_t i;
+
+	for(i = 0; i < pContext->thingIndexSize; i++) {
+		pContext->pThingIndex[i] = SHADOW_INDEX_NONE;
+	}
+	for(i = 0; i < pContext->deltaKeyIndexSize; i++) {
+		pContext->pDeltaKeyIndex[i] = SHADOW_INDEX_NONE;
+	}
+	pContext->thingCount = 0;
+	pContext->firstFreeThing = SHADOW_INDEX_NONE;
+	pContext->deltaHandlerCount = 0;
+}
+
+/* Slot of the thing index holding the thing, or the free slot where it would be added */
+static uint16_t findThingIndexSlot(ShadowContext_t *pContext, const char *pThingName, size_t thingNameLen) {
+	uint16_t slot = (uint16_t) (hashJsonKey(pThingName, thingNameLen) % pContext->thingIndexSize);
+	ShadowThing_t *pThing;
+
+	/* The index is twice as large as the thing list, a free slot is always found */
+	while(SHADOW_INDEX_NONE != pContext->pThingIndex[slot]) {
+		pThing = &(pContext->pThings[pContext->pThingIndex[slot]]);
+		if(strncmp(pThing->thingName, pThingName, thingNameLen) == 0 && '\0' == pThing->thingName[thingNameLen]) {
+			break;
+		}
+		slot = (uint16_t) ((slot + 1) % pContext->thingIndexSize);
+	}
+
+	return slot;
+}
+
+ShadowThing_t *findShadowThing(ShadowContext_t *pContext, const char *pThingName, size_t thingNameLen) {
+	uint16_t index;
+
+	if(thingNameLen >= MAX_SIZE_OF_THING_NAME || 0 == pContext->thingIndexSize) {
+		return NULL;
+	}
+
+	index = pContext->pThingIndex[findThingIndexSlot(pContext, pThingName, thingNameLen)];
+	if(SHADOW_INDEX_NONE == index) {
+		return NULL;
+	}
+
+	return &(pContext->pThings[index]);
+}
+
+ShadowThing_t *getOrAddShadowThing(ShadowContext_t *pContext, const char *pThingName) {
+	size_t thingNameLen = strlen(pThingName);
+	ShadowThing_t *pThing;
+	uint16_t index, slot;
+
+	if(thingNameLen >= MAX_SIZE_OF_THING_NAME || 0 == pContext->thingIndexSize) {
+		return NULL;
+	}
+
+	slot = findThingIndexSlot(pContext, pThingName, thingNameLen);
+	if(SHADOW_INDEX_NONE != pContext->pThingIndex[slot]) {
+		return &(pContext->pThings[pContext->pThingIndex[slot]]);
+	}
+
+	/* Removed things are reused first, the others never move as the MQTT client points to their delta topic */
+	if(SHADOW_INDEX_NONE != pContext->firstFreeThing) {
+		index = pContext->firstFreeThing;
+		pContext->firstFreeThing = pContext->pThings[index].nextFree;
+	} else if(pContext->thingCount < pContext->maxThings) {
+		index = pContext->thingCount;
+		pContext->thingCount++;
+	} else {
+		return NULL;
+	}
+
+	pThing = &(pContext->pThings[index]);
+	memcpy(pThing->thingName, pThingName, thingNameLen + 1);
+	pThing->versionNum = 0;
+	pThing->isDeltaSubscribed = false;
+	pContext->pThingIndex[slot] = index;
+
+	return pThing;
+}
+
+/* Empty a slot of the thing index, moving back the things probed past it so that no probe sequence is cut */
+static void removeFromThingIndex(ShadowContext_t *pContext, uint16_t slot) {
+	uint16_t size = pContext->thingIndexSize;
+	uint16_t next = (uint16_t) ((slot + 1) % size);
+	uint16_t home;
+	ShadowThing_t *pThing;
+
+	while(SHADOW_INDEX_NONE != pContext->pThingIndex[next]) {
+		pThing = &(pContext->pThings[pContext->pThingIndex[next]]);
+		home = (uint16_t) (hashJsonKey(pThing->thingName, strlen(pThing->thingName)) % size);
+		if((slot < next) ? (home <= slot || home > next) : (home <= slot && home > next)) {
+			pContext->pThingIndex[slot] = pContext->pThingIndex[next];
+			slot = next;
+		}
+		next = (uint16_t) ((next + 1) % size);
+	}
+	pContext->pThingIndex[slot] = SHADOW_INDEX_NONE;
+}
+
+/* Thing a shadow topic is published for, NULL if the context does not track it */
+static ShadowThing_t *findShadowThingOfTopic(ShadowContext_t *pContext, const char *pTopicName,
+											 uint16_t topicNameLen) {
+	const char *pThingName = pTopicName + SHADOW_TOPIC_PREFIX_LEN;
+	size_t thingNameLen = 0;
+
+	if(topicNameLen <= SHADOW_TOPIC_PREFIX_LEN
+	   || strncmp(pTopicName, SHADOW_TOPIC_PREFIX, SHADOW_TOPIC_PREFIX_LEN) != 0) {
+		return NULL;
+	}
+
+	while(SHADOW_TOPIC_PREFIX_LEN + thingNameLen < topicNameLen && '/' != pThingName[thingNameLen]) {
+		thingNameLen++;
+	}
+
+	return findShadowThing(pContext, pThingName, thingNameLen);
+}
+
+static bool isTopicEndingWith(const char *pTopicName, uint16_t topicNameLen, const char *pSuffix) {
+	size_t suffixLen = strlen(pSuffix);
+
+	return topicNameLen >= suffixLen && strncmp(pTopicName + topicNameLen - suffixLen, pSuffix, suffixLen) == 0;
+}
+
+/* Hash of the last key of a path, mixed with the thing so that each thing has its own keys in the index */
+static uint32_t deltaKeyHash(uint32_t lastKeyHash, uint16_t thing) {
+	return lastKeyHash ^ ((uint32_t) thing * 2654435761u);
+}
+
+/* Key hash of a registered path, a dotted key is a path in the delta and only its last key is hashed */
+static uint32_t deltaPathHash(const char *pKey, size_t keyLength, uint16_t thing) {
+	size_t lastKeyStart = keyLength;
+
+	while(0 < lastKeyStart && '.' != pKey[lastKeyStart - 1]) {
+		lastKeyStart--;
+	}
+
+	return deltaKeyHash(hashJsonKey(pKey + lastKeyStart, keyLength - lastKeyStart), thing);
+}
 
-static void unsubscribeFromAcceptedAndRejected(uint8_t index);
+/* Slot of the key index holding a handler, which is always indexed */
+static uint16_t findDeltaKeySlot(ShadowContext_t *pContext, uint16_t index) {
+	uint16_t slot = (uint16_t) (pContext->pDeltaHandlers[index].keyHash % pContext->deltaKeyIndexSize);
 
-void initDeltaTokens(void) {
-	uint32_t i;
-	for(i = 0; i < MAX_JSON_TOKEN_EXPECTED; i++) {
-		tokenTable[i].isFree = true;
+	while(index != pContext->pDeltaKeyIndex[slot]) {
+		slot = (uint16_t) ((slot + 1) % pContext->deltaKeyIndexSize);
 	}
-	tokenTableIndex = 0;
-	deltaTopicSubscribedFlag = false;
+
+	return slot;
+}
+
+/* Empty a slot of the key index, moving back the handlers probed past it so that no probe sequence is cut */
+static void removeFromDeltaKeyIndex(ShadowContext_t *pContext, uint16_t slot) {
+	uint16_t size = pContext->deltaKeyIndexSize;
+	uint16_t next = (uint16_t) ((slot + 1) % size);
+	uint16_t home;
+
+	while(SHADOW_INDEX_NONE != pContext->pDeltaKeyIndex[next]) {
+		home = (uint16_t) (pContext->pDeltaHandlers[pContext->pDeltaKeyIndex[next]].keyHash % size);
+		if((slot < next) ? (home <= slot || home > next) : (home <= slot && home > next)) {
+			pContext->pDeltaKeyIndex[slot] = pContext->pDeltaKeyIndex[next];
+			slot = next;
+		}
+		next = (uint16_t) ((next + 1) % size);
+	}
+	pContext->pDeltaKeyIndex[slot] = SHADOW_INDEX_NONE;
 }
 
-IoT_Error_t registerJsonTokenOnDelta(jsonStruct_t *pStruct) {
+/* Free a handler, the last handler of the list takes its place */
+static void removeDeltaHandler(ShadowContext_t *pContext, uint16_t index) {
+	uint16_t last = (uint16_t) (pContext->deltaHandlerCount - 1);
+
+	removeFromDeltaKeyIndex(pContext, findDeltaKeySlot(pContext, index));
+	if(index != last) {
+		pContext->pDeltaKeyIndex[findDeltaKeySlot(pContext, last)] = index;
+		pContext->pDeltaHandlers[index] = pContext->pDeltaHandlers[last];
+	}
+	pContext->deltaHandlerCount = last;
+}
 
+IoT_Error_t registerJsonTokenOnDelta(ShadowContext_t *pContext, const char *pThingName, jsonStruct_t *pStruct) {
 	IoT_Error_t rc = SUCCESS;
+	ShadowThing_t *pThing;
+	ShadowDeltaHandler_t *pHandler;
+	size_t keyLength;
+	uint16_t index, slot;
 
-	if(!deltaTopicSubscribedFlag) {
-		snprintf(shadowDeltaTopic, MAX_SHADOW_TOPIC_LENGTH_BYTES, "$aws/things/%s/shadow/update/delta", myThingName);
-		rc = aws_iot_mqtt_subscribe(pMqttClient, shadowDeltaTopic, (uint16_t) strlen(shadowDeltaTopic), QOS0,
-									shadow_delta_callback, NULL);
-		deltaTopicSubscribedFlag = true;
+	if(NULL == pStruct->pKey) {
+		return NULL_VALUE_ERROR;
+	}
+
+	keyLength = strlen(pStruct->pKey);
+	if(0 == keyLength || keyLength >= SHADOW_INDEX_NONE) {
+		return FAILURE;
 	}
 
-	if(tokenTableIndex >= MAX_JSON_TOKEN_EXPECTED) {
+	pThing = getOrAddShadowThing(pContext, pThingName);
+	if(NULL == pThing || pContext->deltaHandlerCount >= pContext->maxDeltaHandlers) {
 		return FAILURE;
 	}
 
-	tokenTable[tokenTableIndex].pKey = pStruct->pKey;
-	tokenTable[tokenTableIndex].callback = pStruct->cb;
-	tokenTable[tokenTableIndex].pStruct = pStruct;
-	tokenTable[tokenTableIndex].isFree = false;
-	tokenTableIndex++;
+	if(!pThing->isDeltaSubscribed) {
+		snprintf(pThing->deltaTopic, MAX_SHADOW_TOPIC_LENGTH_BYTES, "$aws/things/%s/shadow/update/delta", pThingName);
+		rc = aws_iot_mqtt_subscribe(pContext->pMqttClient, pThing->deltaTopic, (uint16_t) strlen(pThing->deltaTopic),
+									QOS0, shadow_delta_callback, pContext);
+		if(SUCCESS != rc) {
+			return rc;
+		}
+		pThing->isDeltaSubscribed = true;
+	}
+
+	index = pContext->deltaHandlerCount;
+	pHandler = &(pContext->pDeltaHandlers[index]);
+	pHandler->pStruct = pStruct;
+	pHandler->keyLength = (uint16_t) keyLength;
+	pHandler->thing = (uint16_t) (pThing - pContext->pThings);
+	pHandler->keyHash = deltaPathHash(pStruct->pKey, keyLength, pHandler->thing);
+	pHandler->matchedSequence = pContext->deltaSequence;
+
+	/* The index is twice as large as the handler list, a free slot is always found */
+	slot = (uint16_t) (pHandler->keyHash % pContext->deltaKeyIndexSize);
+	while(SHADOW_INDEX_NONE != pContext->pDeltaKeyIndex[slot]) {
+		slot = (uint16_t) ((slot + 1) % pContext->deltaKeyIndexSize);
+	}
+	pContext->pDeltaKeyIndex[slot] = index;
+	pContext->deltaHandlerCount++;
 
 	return rc;
 }
 
-static int16_t getNextFreeIndexOfSubscriptionList(void) {
-	uint8_t i;
-	for(i = 0; i < MAX_TOPICS_AT_ANY_GIVEN_TIME; i++) {
-		if(SubscriptionList[i].isFree) {
-			SubscriptionList[i].isFree = false;
+IoT_Error_t unregisterJsonTokenOnDelta(ShadowContext_t *pContext, const char *pThingName, jsonStruct_t *pStruct) {
+	ShadowThing_t *pThing;
+	uint32_t keyHash;
+	uint16_t thing, slot, index;
+
+	if(NULL == pStruct->pKey) {
+		return NULL_VALUE_ERROR;
+	}
+
+	pThing = findShadowThing(pContext, pThingName, strlen(pThingName));
+	if(NULL == pThing || 0 == pContext->deltaKeyIndexSize) {
+		return FAILURE;
+	}
+
+	/* The handler is in the probe sequence of its key, up to the first free slot */
+	thing = (uint16_t) (pThing - pContext->pThings);
+	keyHash = deltaPathHash(pStruct->pKey, strlen(pStruct->pKey), thing);
+	slot = (uint16_t) (keyHash % pContext->deltaKeyIndexSize);
+	while(SHADOW_INDEX_NONE != pContext->pDeltaKeyIndex[slot]) {
+		index = pContext->pDeltaKeyIndex[slot];
+		if(pStruct == pContext->pDeltaHandlers[index].pStruct && thing == pContext->pDeltaHandlers[index].thing) {
+			removeDeltaHandler(pContext, index);
+			return SUCCESS;
+		}
+		slot = (uint16_t) ((slot + 1) % pContext->deltaKeyIndexSize);
+	}
+
+	return FAILURE;
+}
+
+IoT_Error_t removeShadowThing(ShadowContext_t *pContext, const char *pThingName) {
+	size_t thingNameLen = strlen(pThingName);
+	ShadowThing_t *pThing;
+	IoT_Error_t rc;
+	uint16_t thing, slot, i;
+
+	if(thingNameLen >= MAX_SIZE_OF_THING_NAME || 0 == pContext->thingIndexSize) {
+		return FAILURE;
+	}
+
+	slot = findThingIndexSlot(pContext, pThingName, thingNameLen);
+	thing = pContext->pThingIndex[slot];
+	if(SHADOW_INDEX_NONE == thing) {
+		return FAILURE;
+	}
+	pThing = &(pContext->pThings[thing]);
+
+	/* The MQTT client points to deltaTopic until it is unsubscribed, the thing is kept if that fails */
+	if(pThing->isDeltaSubscribed) {
+		rc = aws_iot_mqtt_unsubscribe(pContext->pMqttClient, pThing->deltaTopic, (uint16_t) strlen(pThing->deltaTopic));
+		if(SUCCESS != rc) {
+			return rc;
+		}
+		pThing->isDeltaSubscribed = false;
+	}
+
+	/* From the end of the list, a handler moved in place of a removed one is already checked */
+	i = pContext->deltaHandlerCount;
+	while(0 < i) {
+		i--;
+		if(thing == pContext->pDeltaHandlers[i].thing) {
+			removeDeltaHandler(pContext, i);
+		}
+	}
+
+	removeFromThingIndex(pContext, slot);
+	pThing->thingName[0] = '\0';
+	pThing->nextFree = pContext->firstFreeThing;
+	pContext->firstFreeThing = thing;
+
+	return SUCCESS;
+}
+
+/* Compare a dotted path with a member and the members enclosing it, from the last key back */
+static bool isDeltaPathMatching(const char *pPath, size_t pathLength, const ShadowJsonMember_t *pMember) {
+	size_t keyStart, keyEnd = pathLength;
+
+	while(NULL != pMember) {
+		keyStart = keyEnd;
+		while(0 < keyStart && '.' != pPath[keyStart - 1]) {
+			keyStart--;
+		}
+
+		if(pMember->keyLength != keyEnd - keyStart || strncmp(pMember->pKey, pPath + keyStart, pMember->keyLength) != 0) {
+			return false;
+		}
+
+		if(0 == keyStart) {
+			return true;
+		}
+
+		keyEnd = keyStart - 1;
+		pMember = pMember->pParent;
+	}
+
+	return false;
+}
+
+typedef struct {
+	ShadowContext_t *pContext;
+	uint16_t thing;
+} ShadowDeltaDispatch_t;
+
+static void dispatchDeltaMember(void *pVisitorData, const ShadowJsonMember_t *pMember) {
+	ShadowDeltaDispatch_t *pDispatch = (ShadowDeltaDispatch_t *) pVisitorData;
+	ShadowContext_t *pContext = pDispatch->pContext;
+	ShadowDeltaHandler_t *pHandler;
+	uint32_t keyHash = deltaKeyHash(pMember->keyHash, pDispatch->thing);
+	uint16_t slot = (uint16_t) (keyHash % pContext->deltaKeyIndexSize);
+
+	/* Every handler of the key is in the probe sequence, up to the first free slot */
+	while(SHADOW_INDEX_NONE != pContext->pDeltaKeyIndex[slot]) {
+		pHandler = &(pContext->pDeltaHandlers[pContext->pDeltaKeyIndex[slot]]);
+		if(keyHash == pHandler->keyHash && pDispatch->thing == pHandler->thing
+		   && pContext->deltaSequence != pHandler->matchedSequence
+		   && isDeltaPathMatching(pHandler->pStruct->pKey, pHandler->keyLength, pMember)) {
+			/* Only the first occurrence of a key in the delta is used */
+			pHandler->matchedSequence = pContext->deltaSequence;
+			updateParsedJsonValue(pContext->rxBuf, &(pContext->jsonParser), pMember->valueToken, pHandler->pStruct);
+			if(pHandler->pStruct->cb != NULL) {
+				pHandler->pStruct->cb(pContext->rxBuf + pMember->valueStart, pMember->valueLength, pHandler->pStruct);
+			}
+		}
+		slot = (uint16_t) ((slot + 1) % pContext->deltaKeyIndexSize);
+	}
+}
+
+static int32_t getNextFreeIndexOfSubscriptionList(ShadowContext_t *pContext) {
+	uint16_t i;
+	for(i = 0; i < pContext->subscriptionListSize; i++) {
+		if(pContext->pSubscriptionList[i].isFree) {
+			pContext->pSubscriptionList[i].isFree = false;
 			return i;
 		}
 	}
@@ -168,78 +559,149 @@ static void topicNameFromThingAndAction(char *pTopic, const char *pThingName, Sh
 	}
 }
 
-static bool isValidShadowVersionUpdate(const char *pTopicName) {
-	if(strstr(pTopicName, myThingName) != NULL &&
-	   ((strstr(pTopicName, "get/accepted") != NULL) ||
-		(strstr(pTopicName, "delta") != NULL))) {
-		return true;
+/* Record waiting for the response carrying a client token, SHADOW_INDEX_NONE if none does */
+static uint16_t findAckWaitRecord(ShadowContext_t *pContext, const char *pClientToken) {
+	uint32_t hash = hashJsonKey(pClientToken, strlen(pClientToken));
+	ToBeReceivedAckRecord_t *pAckRecord;
+	uint16_t slot;
+
+	if(0 == pContext->ackTokenIndexSize) {
+		return SHADOW_INDEX_NONE;
 	}
-	return false;
+
+	/* The index is twice as large as the wait list, a free slot ends every probe sequence */
+	slot = (uint16_t) (hash % pContext->ackTokenIndexSize);
+	while(SHADOW_INDEX_NONE != pContext->pAckTokenIndex[slot]) {
+		pAckRecord = &(pContext->pAckWaitList[pContext->pAckTokenIndex[slot]]);
+		if(hash == pAckRecord->clientTokenHash && strcmp(pAckRecord->clientTokenID, pClientToken) == 0) {
+			return pContext->pAckTokenIndex[slot];
+		}
+		slot = (uint16_t) ((slot + 1) % pContext->ackTokenIndexSize);
+	}
+
+	return SHADOW_INDEX_NONE;
+}
+
+static void addToAckTokenIndex(ShadowContext_t *pContext, uint16_t indexAckWaitList) {
+	uint16_t slot = (uint16_t) (pContext->pAckWaitList[indexAckWaitList].clientTokenHash % pContext->ackTokenIndexSize);
+
+	while(SHADOW_INDEX_NONE != pContext->pAckTokenIndex[slot]) {
+		slot = (uint16_t) ((slot + 1) % pContext->ackTokenIndexSize);
+	}
+	pContext->pAckTokenIndex[slot] = indexAckWaitList;
+}
+
+static void removeFromAckTokenIndex(ShadowContext_t *pContext, uint16_t indexAckWaitList) {
+	uint16_t size = pContext->ackTokenIndexSize;
+	uint16_t slot = (uint16_t) (pContext->pAckWaitList[indexAckWaitList].clientTokenHash % size);
+	uint16_t next, home;
+
+	while(indexAckWaitList != pContext->pAckTokenIndex[slot]) {
+		if(SHADOW_INDEX_NONE == pContext->pAckTokenIndex[slot]) {
+			return;
+		}
+		slot = (uint16_t) ((slot + 1) % size);
+	}
+
+	/* Move back the records probed past the emptied slot, so that no probe sequence is cut */
+	next = (uint16_t) ((slot + 1) % size);
+	while(SHADOW_INDEX_NONE != pContext->pAckTokenIndex[next]) {
+		home = (uint16_t) (pContext->pAckWaitList[pContext->pAckTokenIndex[next]].clientTokenHash % size);
+		if((slot < next) ? (home <= slot || home > next) : (home <= slot && home > next)) {
+			pContext->pAckTokenIndex[slot] = pContext->pAckTokenIndex[next];
+			slot = next;
+		}
+		next = (uint16_t) ((next + 1) % size);
+	}
+	pContext->pAckTokenIndex[slot] = SHADOW_INDEX_NONE;
 }
 
-static void AckStatusCallback(AWS_IoT_Client *pClient, char *topicName, uint16_t topicNameLen,
-							  IoT_Publish_Message_Params *params, void *pData) {
+static void releaseAckWaitRecord(ShadowContext_t *pContext, uint16_t indexAckWaitList) {
+	ToBeReceivedAckRecord_t *pAckRecord = &(pContext->pAckWaitList[indexAckWaitList]);
+
+	removeFromAckTokenIndex(pContext, indexAckWaitList);
+	aws_iot_timer_wheel_disarm(&(pContext->ackWaitWheel), indexAckWaitList);
+	pAckRecord->isFree = true;
+	pAckRecord->nextFree = pContext->firstFreeAck;
+	pContext->firstFreeAck = indexAckWaitList;
+}
+
+static void handleShadowAck(ShadowContext_t *pContext, char *topicName, uint16_t topicNameLen,
+							IoT_Publish_Message_Params *params, Shadow_Ack_Status_t status) {
+	ToBeReceivedAckRecord_t *pAckRecord;
+	ShadowThing_t *pThing;
 	int32_t tokenCount;
-	uint8_t i;
-	void *pJsonHandler = NULL;
+	uint16_t indexAckWaitList;
+	ShadowJsonParser_t *pJsonParser = &(pContext->jsonParser);
 	char temporaryClientToken[MAX_SIZE_CLIENT_TOKEN_CLIENT_SEQUENCE];
 
-	IOT_UNUSED(pClient);
-	IOT_UNUSED(topicNameLen);
-	IOT_UNUSED(pData);
-
 	if(params->payloadLen >= SHADOW_MAX_SIZE_OF_RX_BUFFER) {
 		IOT_WARN("Payload larger than RX Buffer");
 		return;
 	}
 
-	memcpy(shadowRxBuf, params->payload, params->payloadLen);
-	shadowRxBuf[params->payloadLen] = '\0';    // jsmn_parse relies on a string
+	memcpy(pContext->rxBuf, params->payload, params->payloadLen);
+	pContext->rxBuf[params->payloadLen] = '\0';    // jsmn_parse relies on a string
 
-	if(!isJsonValidAndParse(shadowRxBuf, SHADOW_MAX_SIZE_OF_RX_BUFFER, pJsonHandler, &tokenCount)) {
+	/* The document is parsed once, the version and the client token are read from its tokens */
+	if(!isJsonValidAndParse(pContext->rxBuf, SHADOW_MAX_SIZE_OF_RX_BUFFER, pJsonParser, &tokenCount)) {
 		IOT_WARN("Received JSON is not valid");
 		return;
 	}
 
-	if(isValidShadowVersionUpdate(topicName)) {
-		uint32_t tempVersionNumber = 0;
-		if(extractVersionNumber(shadowRxBuf, pJsonHandler, tokenCount, &tempVersionNumber)) {
-			if(tempVersionNumber > shadowJsonVersionNum) {
-				shadowJsonVersionNum = tempVersionNumber;
+	/* Versions are only taken from full documents */
+	if(SHADOW_ACK_ACCEPTED == status && isTopicEndingWith(topicName, topicNameLen, "/get/accepted")) {
+		pThing = findShadowThingOfTopic(pContext, topicName, topicNameLen);
+		if(NULL != pThing) {
+			uint32_t tempVersionNumber = 0;
+			if(extractVersionNumber(pContext->rxBuf, pJsonParser, tokenCount, &tempVersionNumber)) {
+				if(tempVersionNumber > pThing->versionNum) {
+					pThing->versionNum = tempVersionNumber;
+				}
 			}
 		}
 	}
 
-	if(extractClientToken(shadowRxBuf, SHADOW_MAX_SIZE_OF_RX_BUFFER, temporaryClientToken, MAX_SIZE_CLIENT_TOKEN_CLIENT_SEQUENCE)) {
-		for(i = 0; i < MAX_ACKS_TO_COMEIN_AT_ANY_GIVEN_TIME; i++) {
-			if(!AckWaitList[i].isFree) {
-				if(strcmp(AckWaitList[i].clientTokenID, temporaryClientToken) == 0) {
-					Shadow_Ack_Status_t status = SHADOW_ACK_REJECTED;
-					if(strstr(topicName, "accepted") != NULL) {
-						status = SHADOW_ACK_ACCEPTED;
-					} else if(strstr(topicName, "rejected") != NULL) {
-						status = SHADOW_ACK_REJECTED;
-					}
-					if(status == SHADOW_ACK_ACCEPTED || status == SHADOW_ACK_REJECTED) {
-						if(AckWaitList[i].callback != NULL) {
-							AckWaitList[i].callback(AckWaitList[i].thingName, AckWaitList[i].action, status,
-													shadowRxBuf, AckWaitList[i].pCallbackContext);
-						}
-						unsubscribeFromAcceptedAndRejected(i);
-						AckWaitList[i].isFree = true;
-						return;
-					}
-				}
-			}
-		}
+	if(!extractParsedClientToken(pContext->rxBuf, pJsonParser, tokenCount, temporaryClientToken,
+								 MAX_SIZE_CLIENT_TOKEN_CLIENT_SEQUENCE)) {
+		return;
+	}
+
+	indexAckWaitList = findAckWaitRecord(pContext, temporaryClientToken);
+	if(SHADOW_INDEX_NONE == indexAckWaitList) {
+		return;
+	}
+
+	pAckRecord = &(pContext->pAckWaitList[indexAckWaitList]);
+	if(pAckRecord->callback != NULL) {
+		pAckRecord->callback(pAckRecord->thingName, pAckRecord->action, status, pContext->rxBuf,
+							 pAckRecord->pCallbackContext);
 	}
+	/* Released first, the unsubscribe may dispatch responses received meanwhile */
+	releaseAckWaitRecord(pContext, indexAckWaitList);
+	unsubscribeFromAcceptedAndRejected(pContext, indexAckWaitList);
 }
 
-static int16_t findIndexOfSubscriptionList(const char *pTopic) {
-	uint8_t i;
-	for(i = 0; i < MAX_TOPICS_AT_ANY_GIVEN_TIME; i++) {
-		if(!SubscriptionList[i].isFree) {
-			if((strcmp(pTopic, SubscriptionList[i].Topic) == 0)) {
+/* The accepted and rejected topics are subscribed with their own handler, the status comes from the subscription */
+static void AckAcceptedCallback(AWS_IoT_Client *pClient, char *topicName, uint16_t topicNameLen,
+								IoT_Publish_Message_Params *params, void *pData) {
+	IOT_UNUSED(pClient);
+
+	handleShadowAck((ShadowContext_t *) pData, topicName, topicNameLen, params, SHADOW_ACK_ACCEPTED);
+}
+
+static void AckRejectedCallback(AWS_IoT_Client *pClient, char *topicName, uint16_t topicNameLen,
+								IoT_Publish_Message_Params *params, void *pData) {
+	IOT_UNUSED(pClient);
+
+	handleShadowAck((ShadowContext_t *) pData, topicName, topicNameLen, params, SHADOW_ACK_REJECTED);
+}
+
+static int32_t findIndexOfSubscriptionList(ShadowContext_t *pContext, const char *pTopic) {
+	uint16_t i;
+	for(i = 0; i < pContext->subscriptionListSize; i++) {
+		if(!pContext->pSubscriptionList[i].isFree) {
+			if((strcmp(pTopic, pContext->pSubscriptionList[i].Topic) == 0)) {
 				return i;
 			}
 		}
@@ -247,76 +709,127 @@ static int16_t findIndexOfSubscriptionList(const char *pTopic) {
 	return -1;
 }
 
-static void unsubscribeFromAcceptedAndRejected(uint8_t index) {
-
-	char TemporaryTopicNameAccepted[MAX_SHADOW_TOPIC_LENGTH_BYTES];
-	char TemporaryTopicNameRejected[MAX_SHADOW_TOPIC_LENGTH_BYTES];
+static void unsubscribeFromTopic(ShadowContext_t *pContext, const char *pTopic) {
+	SubscriptionRecord_t *pRecord;
 	IoT_Error_t ret_val = SUCCESS;
+	int32_t indexSubList;
 
-	int16_t indexSubList;
-
-	topicNameFromThingAndAction(TemporaryTopicNameAccepted, AckWaitList[index].thingName, AckWaitList[index].action,
-								SHADOW_ACCEPTED);
-	topicNameFromThingAndAction(TemporaryTopicNameRejected, AckWaitList[index].thingName, AckWaitList[index].action,
-								SHADOW_REJECTED);
-
-	indexSubList = findIndexOfSubscriptionList(TemporaryTopicNameAccepted);
+	indexSubList = findIndexOfSubscriptionList(pContext, pTopic);
 	if((indexSubList >= 0)) {
-		if(!SubscriptionList[indexSubList].isSticky && (SubscriptionList[indexSubList].count == 1)) {
-			ret_val = aws_iot_mqtt_unsubscribe(pMqttClient, TemporaryTopicNameAccepted,
-											   (uint16_t) strlen(TemporaryTopicNameAccepted));
+		pRecord = &(pContext->pSubscriptionList[indexSubList]);
+		if(!pRecord->isSticky && (pRecord->count == 1)) {
+			ret_val = aws_iot_mqtt_unsubscribe(pContext->pMqttClient, pRecord->Topic, (uint16_t) strlen(pRecord->Topic));
 			if(ret_val == SUCCESS) {
-				SubscriptionList[indexSubList].isFree = true;
+				pRecord->isFree = true;
 			}
-		} else if(SubscriptionList[indexSubList].count > 1) {
-			SubscriptionList[indexSubList].count--;
+		} else if(pRecord->count > 1) {
+			pRecord->count--;
 		}
 	}
+}
 
-	indexSubList = findIndexOfSubscriptionList(TemporaryTopicNameRejected);
-	if((indexSubList >= 0)) {
-		if(!SubscriptionList[indexSubList].isSticky && (SubscriptionList[indexSubList].count == 1)) {
-			ret_val = aws_iot_mqtt_unsubscribe(pMqttClient, TemporaryTopicNameRejected,
-											   (uint16_t) strlen(TemporaryTopicNameRejected));
-			if(ret_val == SUCCESS) {
-				SubscriptionList[indexSubList].isFree = true;
-			}
-		} else if(SubscriptionList[indexSubList].count > 1) {
-			SubscriptionList[indexSubList].count--;
-		}
+static void unsubscribeFromAcceptedAndRejected(ShadowContext_t *pContext, uint16_t index) {
+
+	char TemporaryTopicNameAccepted[MAX_SHADOW_TOPIC_LENGTH_BYTES];
+	char TemporaryTopicNameRejected[MAX_SHADOW_TOPIC_LENGTH_BYTES];
+
+	topicNameFromThingAndAction(TemporaryTopicNameAccepted, pContext->pAckWaitList[index].thingName,
+								pContext->pAckWaitList[index].action, SHADOW_ACCEPTED);
+	topicNameFromThingAndAction(TemporaryTopicNameRejected, pContext->pAckWaitList[index].thingName,
+								pContext->pAckWaitList[index].action, SHADOW_REJECTED);
+
+	unsubscribeFromTopic(pContext, TemporaryTopicNameAccepted);
+	unsubscribeFromTopic(pContext, TemporaryTopicNameRejected);
+}
+
+void initializeRecords(ShadowContext_t *pContext, AWS_IoT_Client *pClient) {
+	uint16_t i;
+	for(i = 0; i < pContext->ackWaitListSize; i++) {
+		pContext->pAckWaitList[i].isFree = true;
+		pContext->pAckWaitList[i].nextFree = (uint16_t) (i + 1);
+	}
+	if(0 < pContext->ackWaitListSize) {
+		pContext->pAckWaitList[pContext->ackWaitListSize - 1].nextFree = SHADOW_INDEX_NONE;
+		pContext->firstFreeAck = 0;
+	} else {
+		pContext->firstFreeAck = SHADOW_INDEX_NONE;
+	}
+	for(i = 0; i < pContext->ackTokenIndexSize; i++) {
+		pContext->pAckTokenIndex[i] = SHADOW_INDEX_NONE;
+	}
+	aws_iot_timer_wheel_init(&(pContext->ackWaitWheel), pContext->ackWaitWheel.pEntries, pContext->ackWaitListSize);
+	for(i = 0; i < pContext->subscriptionListSize; i++) {
+		pContext->pSubscriptionList[i].isFree = true;
+		pContext->pSubscriptionList[i].count = 0;
+		pContext->pSubscriptionList[i].isSticky = false;
 	}
+	pContext->isAckWildcardSubscribed = false;
+
+	pContext->pMqttClient = pClient;
 }
 
-void initializeRecords(AWS_IoT_Client *pClient) {
+IoT_Error_t subscribeToShadowAckWildcards(ShadowContext_t *pContext, const char *pThingName) {
+	IoT_Subscribe_Params subscribeList[2];
+	IoT_Error_t ret_val;
 	uint8_t i;
-	for(i = 0; i < MAX_ACKS_TO_COMEIN_AT_ANY_GIVEN_TIME; i++) {
-		AckWaitList[i].isFree = true;
+
+	if(strlen(pThingName) >= MAX_SIZE_OF_THING_NAME) {
+		return FAILURE;
 	}
-	for(i = 0; i < MAX_TOPICS_AT_ANY_GIVEN_TIME; i++) {
-		SubscriptionList[i].isFree = true;
-		SubscriptionList[i].count = 0;
-		SubscriptionList[i].isSticky = false;
+
+	snprintf(pContext->ackWildcardTopics[0], MAX_SHADOW_TOPIC_LENGTH_BYTES, "$aws/things/%s/shadow/+/accepted",
+			 pThingName);
+	snprintf(pContext->ackWildcardTopics[1], MAX_SHADOW_TOPIC_LENGTH_BYTES, "$aws/things/%s/shadow/+/rejected",
+			 pThingName);
+	for(i = 0; i < 2; i++) {
+		subscribeList[i].pTopicName = pContext->ackWildcardTopics[i];
+		subscribeList[i].topicNameLen = (uint16_t) strlen(pContext->ackWildcardTopics[i]);
+		subscribeList[i].qos = QOS0;
+		subscribeList[i].pApplicationHandlerData = pContext;
+		subscribeList[i].result = FAILURE;
+	}
+	subscribeList[0].pApplicationHandler = AckAcceptedCallback;
+	subscribeList[1].pApplicationHandler = AckRejectedCallback;
+
+	/* Both topics go in one SUBSCRIBE, the call returns once the SUBACK is received */
+	ret_val = aws_iot_mqtt_subscribe_batch(pContext->pMqttClient, subscribeList, 2);
+	if(SUCCESS == ret_val) {
+		snprintf(pContext->ackWildcardThingName, MAX_SIZE_OF_THING_NAME, "%s", pThingName);
+		pContext->isAckWildcardSubscribed = true;
+	} else {
+		/* Accepted and rejected responses are only useful together, drop a topic the broker granted */
+		for(i = 0; i < 2; i++) {
+			if(SUCCESS == subscribeList[i].result) {
+				aws_iot_mqtt_unsubscribe(pContext->pMqttClient, subscribeList[i].pTopicName,
+										 subscribeList[i].topicNameLen);
+			}
+		}
 	}
 
-	pMqttClient = pClient;
+	return ret_val;
 }
 
-bool isSubscriptionPresent(const char *pThingName, ShadowActions_t action) {
+bool isSubscriptionPresent(ShadowContext_t *pContext, const char *pThingName, ShadowActions_t action) {
 
-	uint8_t i = 0;
+	uint16_t i = 0;
 	bool isAcceptedPresent = false;
 	bool isRejectedPresent = false;
 	char TemporaryTopicNameAccepted[MAX_SHADOW_TOPIC_LENGTH_BYTES];
 	char TemporaryTopicNameRejected[MAX_SHADOW_TOPIC_LENGTH_BYTES];
 
+	if(pContext->isAckWildcardSubscribed && (strcmp(pContext->ackWildcardThingName, "+") == 0
+											 || strcmp(pThingName, pContext->ackWildcardThingName) == 0)) {
+		return true;
+	}
+
 	topicNameFromThingAndAction(TemporaryTopicNameAccepted, pThingName, action, SHADOW_ACCEPTED);
 	topicNameFromThingAndAction(TemporaryTopicNameRejected, pThingName, action, SHADOW_REJECTED);
 
-	for(i = 0; i < MAX_TOPICS_AT_ANY_GIVEN_TIME; i++) {
-		if(!SubscriptionList[i].isFree) {
-			if((strcmp(TemporaryTopicNameAccepted, SubscriptionList[i].Topic) == 0)) {
+	for(i = 0; i < pContext->subscriptionListSize; i++) {
+		if(!pContext->pSubscriptionList[i].isFree) {
+			if((strcmp(TemporaryTopicNameAccepted, pContext->pSubscriptionList[i].Topic) == 0)) {
 				isAcceptedPresent = true;
-			} else if((strcmp(TemporaryTopicNameRejected, SubscriptionList[i].Topic) == 0)) {
+			} else if((strcmp(TemporaryTopicNameRejected, pContext->pSubscriptionList[i].Topic) == 0)) {
 				isRejectedPresent = true;
 			}
 		}
@@ -329,54 +842,54 @@ bool isSubscriptionPresent(const char *pThingName, ShadowActions_t action) {
 	return false;
 }
 
-IoT_Error_t subscribeToShadowActionAcks(const char *pThingName, ShadowActions_t action, bool isSticky) {
+IoT_Error_t subscribeToShadowActionAcks(ShadowContext_t *pContext, const char *pThingName, ShadowActions_t action,
+										bool isSticky) {
 	IoT_Error_t ret_val = SUCCESS;
 
 	bool clearBothEntriesFromList = true;
-	int16_t indexAcceptedSubList = 0;
-	int16_t indexRejectedSubList = 0;
-	Timer subSettlingtimer;
-	indexAcceptedSubList = getNextFreeIndexOfSubscriptionList();
-	indexRejectedSubList = getNextFreeIndexOfSubscriptionList();
-
-	if(indexAcceptedSubList >= 0 && indexRejectedSubList >= 0) {
-		topicNameFromThingAndAction(SubscriptionList[indexAcceptedSubList].Topic, pThingName, action, SHADOW_ACCEPTED);
-		ret_val = aws_iot_mqtt_subscribe(pMqttClient, SubscriptionList[indexAcceptedSubList].Topic,
-										 (uint16_t) strlen(SubscriptionList[indexAcceptedSubList].Topic), QOS0,
-										 AckStatusCallback, NULL);
+	int32_t indexAcceptedSubList = 0;
+	int32_t indexRejectedSubList = 0;
+	SubscriptionRecord_t *pAccepted = NULL;
+	SubscriptionRecord_t *pRejected = NULL;
+	indexAcceptedSubList = getNextFreeIndexOfSubscriptionList(pContext);
+	indexRejectedSubList = getNextFreeIndexOfSubscriptionList(pContext);
+
+	if(indexAcceptedSubList >= 0) {
+		pAccepted = &(pContext->pSubscriptionList[indexAcceptedSubList]);
+	}
+	if(indexRejectedSubList >= 0) {
+		pRejected = &(pContext->pSubscriptionList[indexRejectedSubList]);
+	}
+
+	if(NULL != pAccepted && NULL != pRejected) {
+		topicNameFromThingAndAction(pAccepted->Topic, pThingName, action, SHADOW_ACCEPTED);
+		ret_val = aws_iot_mqtt_subscribe(pContext->pMqttClient, pAccepted->Topic, (uint16_t) strlen(pAccepted->Topic),
+										 QOS0, AckAcceptedCallback, pContext);
 		if(ret_val == SUCCESS) {
-			SubscriptionList[indexAcceptedSubList].count = 1;
-			SubscriptionList[indexAcceptedSubList].isSticky = isSticky;
-			topicNameFromThingAndAction(SubscriptionList[indexRejectedSubList].Topic, pThingName, action,
-										SHADOW_REJECTED);
-			ret_val = aws_iot_mqtt_subscribe(pMqttClient, SubscriptionList[indexRejectedSubList].Topic,
-											 (uint16_t) strlen(SubscriptionList[indexRejectedSubList].Topic), QOS0,
-											 AckStatusCallback, NULL);
+			pAccepted->count = 1;
+			pAccepted->isSticky = isSticky;
+			topicNameFromThingAndAction(pRejected->Topic, pThingName, action, SHADOW_REJECTED);
+			ret_val = aws_iot_mqtt_subscribe(pContext->pMqttClient, pRejected->Topic,
+											 (uint16_t) strlen(pRejected->Topic), QOS0, AckRejectedCallback, pContext);
 			if(ret_val == SUCCESS) {
-				SubscriptionList[indexRejectedSubList].count = 1;
-				SubscriptionList[indexRejectedSubList].isSticky = isSticky;
+				/* Each subscribe returned on its SUBACK, the responses can be received from now on */
+				pRejected->count = 1;
+				pRejected->isSticky = isSticky;
 				clearBothEntriesFromList = false;
-
-				// wait for SUBSCRIBE_SETTLING_TIME seconds to let the subscription take effect
-				init_timer(&subSettlingtimer);
-				countdown_sec(&subSettlingtimer, SUBSCRIBE_SETTLING_TIME);
-				while(!has_timer_expired(&subSettlingtimer));
-
 			}
 		}
 	}
 
 	if(clearBothEntriesFromList) {
-		if(indexAcceptedSubList >= 0) {
-			SubscriptionList[indexAcceptedSubList].isFree = true;
+		if(NULL != pAccepted) {
+			pAccepted->isFree = true;
 			
-			if(SubscriptionList[indexAcceptedSubList].count == 1) {
-			    aws_iot_mqtt_unsubscribe(pMqttClient, SubscriptionList[indexAcceptedSubList].Topic,
-				(uint16_t) strlen(SubscriptionList[indexAcceptedSubList].Topic));
+			if(pAccepted->count == 1) {
+			    aws_iot_mqtt_unsubscribe(pContext->pMqttClient, pAccepted->Topic, (uint16_t) strlen(pAccepted->Topic));
 		    }
 		}
-		if(indexRejectedSubList >= 0) {
-			SubscriptionList[indexRejectedSubList].isFree = true;
+		if(NULL != pRejected) {
+			pRejected->isFree = true;
 		}
 
 	}
@@ -384,25 +897,27 @@ IoT_Error_t subscribeToShadowActionAcks(const char *pThingName, ShadowActions_t
 	return ret_val;
 }
 
-void incrementSubscriptionCnt(const char *pThingName, ShadowActions_t action, bool isSticky) {
+void incrementSubscriptionCnt(ShadowContext_t *pContext, const char *pThingName, ShadowActions_t action,
+							  bool isSticky) {
 	char TemporaryTopicNameAccepted[MAX_SHADOW_TOPIC_LENGTH_BYTES];
 	char TemporaryTopicNameRejected[MAX_SHADOW_TOPIC_LENGTH_BYTES];
-	uint8_t i;
+	uint16_t i;
 	topicNameFromThingAndAction(TemporaryTopicNameAccepted, pThingName, action, SHADOW_ACCEPTED);
 	topicNameFromThingAndAction(TemporaryTopicNameRejected, pThingName, action, SHADOW_REJECTED);
 
-	for(i = 0; i < MAX_TOPICS_AT_ANY_GIVEN_TIME; i++) {
-		if(!SubscriptionList[i].isFree) {
-			if((strcmp(TemporaryTopicNameAccepted, SubscriptionList[i].Topic) == 0)
-			   || (strcmp(TemporaryTopicNameRejected, SubscriptionList[i].Topic) == 0)) {
-				SubscriptionList[i].count++;
-				SubscriptionList[i].isSticky = isSticky;
+	for(i = 0; i < pContext->subscriptionListSize; i++) {
+		if(!pContext->pSubscriptionList[i].isFree) {
+			if((strcmp(TemporaryTopicNameAccepted, pContext->pSubscriptionList[i].Topic) == 0)
+			   || (strcmp(TemporaryTopicNameRejected, pContext->pSubscriptionList[i].Topic) == 0)) {
+				pContext->pSubscriptionList[i].count++;
+				pContext->pSubscriptionList[i].isSticky = isSticky;
 			}
 		}
 	}
 }
 
-IoT_Error_t publishToShadowAction(const char *pThingName, ShadowActions_t action, const char *pJsonDocumentToBeSent) {
+IoT_Error_t publishToShadowAction(ShadowContext_t *pContext, const char *pThingName, ShadowActions_t action,
+								  const char *pJsonDocumentToBeSent) {
 	IoT_Error_t ret_val = SUCCESS;
 	char TemporaryTopicName[MAX_SHADOW_TOPIC_LENGTH_BYTES];
 	IoT_Publish_Message_Params msgParams;
@@ -417,111 +932,116 @@ IoT_Error_t publishToShadowAction(const char *pThingName, ShadowActions_t action
 	msgParams.isRetained = 0;
 	msgParams.payloadLen = strlen(pJsonDocumentToBeSent);
 	msgParams.payload = (char *) pJsonDocumentToBeSent;
-	ret_val = aws_iot_mqtt_publish(pMqttClient, TemporaryTopicName, (uint16_t) strlen(TemporaryTopicName), &msgParams);
+	ret_val = aws_iot_mqtt_publish(pContext->pMqttClient, TemporaryTopicName, (uint16_t) strlen(TemporaryTopicName),
+								   &msgParams);
 
 	return ret_val;
 }
 
-bool getNextFreeIndexOfAckWaitList(uint8_t *pIndex) {
-	uint8_t i;
-	bool rc = false;
-
-	if(NULL == pIndex) {
+bool getNextFreeIndexOfAckWaitList(ShadowContext_t *pContext, uint16_t *pIndex) {
+	if(NULL == pIndex || SHADOW_INDEX_NONE == pContext->firstFreeAck) {
 		return false;
 	}
 
-	for(i = 0; i < MAX_ACKS_TO_COMEIN_AT_ANY_GIVEN_TIME; i++) {
-		if(AckWaitList[i].isFree) {
-			*pIndex = i;
-			rc = true;
-			break;
-		}
-	}
-
-	return rc;
+	/* The record stays in the free list until addToAckWaitList */
+	*pIndex = pContext->firstFreeAck;
+	return true;
 }
 
-void addToAckWaitList(uint8_t indexAckWaitList, const char *pThingName, ShadowActions_t action,
-					  const char *pExtractedClientToken, fpActionCallback_t callback, void *pCallbackContext,
-					  uint32_t timeout_seconds) {
-	AckWaitList[indexAckWaitList].callback = callback;
-	memcpy(AckWaitList[indexAckWaitList].clientTokenID, pExtractedClientToken, MAX_SIZE_CLIENT_ID_WITH_SEQUENCE);
-	memcpy(AckWaitList[indexAckWaitList].thingName, pThingName, MAX_SIZE_OF_THING_NAME);
-	AckWaitList[indexAckWaitList].pCallbackContext = pCallbackContext;
-	AckWaitList[indexAckWaitList].action = action;
-	init_timer(&(AckWaitList[indexAckWaitList].timer));
-	countdown_sec(&(AckWaitList[indexAckWaitList].timer), timeout_seconds);
-	AckWaitList[indexAckWaitList].isFree = false;
+void addToAckWaitList(ShadowContext_t *pContext, uint16_t indexAckWaitList, const char *pThingName,
+					  ShadowActions_t action, const char *pExtractedClientToken, fpActionCallback_t callback,
+					  void *pCallbackContext, uint32_t timeout_seconds) {
+	ToBeReceivedAckRecord_t *pAckRecord = &(pContext->pAckWaitList[indexAckWaitList]);
+	uint16_t *pNextFree = &(pContext->firstFreeAck);
+
+	while(indexAckWaitList != *pNextFree) {
+		pNextFree = &(pContext->pAckWaitList[*pNextFree].nextFree);
+	}
+	*pNextFree = pAckRecord->nextFree;
+
+	pAckRecord->callback = callback;
+	memcpy(pAckRecord->clientTokenID, pExtractedClientToken, MAX_SIZE_CLIENT_ID_WITH_SEQUENCE);
+	memcpy(pAckRecord->thingName, pThingName, MAX_SIZE_OF_THING_NAME);
+	pAckRecord->pCallbackContext = pCallbackContext;
+	pAckRecord->action = action;
+	pAckRecord->clientTokenHash = hashJsonKey(pAckRecord->clientTokenID, strlen(pAckRecord->clientTokenID));
+	addToAckTokenIndex(pContext, indexAckWaitList);
+	aws_iot_timer_wheel_arm(&(pContext->ackWaitWheel), indexAckWaitList, timeout_seconds * 1000);
+	pAckRecord->isFree = false;
 }
 
-void HandleExpiredResponseCallbacks(void) {
-	uint8_t i;
-	for(i = 0; i < MAX_ACKS_TO_COMEIN_AT_ANY_GIVEN_TIME; i++) {
-		if(!AckWaitList[i].isFree) {
-			if(has_timer_expired(&(AckWaitList[i].timer))) {
-				if(AckWaitList[i].callback != NULL) {
-					AckWaitList[i].callback(AckWaitList[i].thingName, AckWaitList[i].action, SHADOW_ACK_TIMEOUT,
-											shadowRxBuf, AckWaitList[i].pCallbackContext);
-				}
-				AckWaitList[i].isFree = true;
-				unsubscribeFromAcceptedAndRejected(i);
+void HandleExpiredResponseCallbacks(ShadowContext_t *pContext) {
+	ToBeReceivedAckRecord_t *pAckRecord;
+	uint16_t i;
+
+	aws_iot_timer_wheel_advance(&(pContext->ackWaitWheel));
+	for(i = aws_iot_timer_wheel_pop_expired(&(pContext->ackWaitWheel)); AWS_IOT_TIMER_WHEEL_INDEX_NONE != i;
+		i = aws_iot_timer_wheel_pop_expired(&(pContext->ackWaitWheel))) {
+		pAckRecord = &(pContext->pAckWaitList[i]);
+		if(!pAckRecord->isFree) {
+			if(pAckRecord->callback != NULL) {
+				pAckRecord->callback(pAckRecord->thingName, pAckRecord->action, SHADOW_ACK_TIMEOUT,
+									 pContext->rxBuf, pAckRecord->pCallbackContext);
 			}
+			releaseAckWaitRecord(pContext, i);
+			unsubscribeFromAcceptedAndRejected(pContext, i);
 		}
 	}
 }
 
 static void shadow_delta_callback(AWS_IoT_Client *pClient, char *topicName,
 								  uint16_t topicNameLen, IoT_Publish_Message_Params *params, void *pData) {
+	ShadowContext_t *pContext = (ShadowContext_t *) pData;
+	ShadowDeltaDispatch_t dispatch;
+	ShadowThing_t *pThing;
 	int32_t tokenCount;
-	uint32_t i = 0;
-	void *pJsonHandler = NULL;
-	int32_t DataPosition;
-	uint32_t dataLength;
+	ShadowJsonParser_t *pJsonParser = &(pContext->jsonParser);
 	uint32_t tempVersionNumber = 0;
 
 	FUNC_ENTRY;
 
 	IOT_UNUSED(pClient);
-	IOT_UNUSED(topicName);
-	IOT_UNUSED(topicNameLen);
-	IOT_UNUSED(pData);
+
+	pThing = findShadowThingOfTopic(pContext, topicName, topicNameLen);
+	if(NULL == pThing) {
+		IOT_WARN("Delta received for an unknown thing");
+		return;
+	}
 
 	if(params->payloadLen >= SHADOW_MAX_SIZE_OF_RX_BUFFER) {
 		IOT_WARN("Payload larger than RX Buffer");
 		return;
 	}
 
-	memcpy(shadowRxBuf, params->payload, params->payloadLen);
-	shadowRxBuf[params->payloadLen] = '\0';    // jsmn_parse relies on a string
+	memcpy(pContext->rxBuf, params->payload, params->payloadLen);
+	pContext->rxBuf[params->payloadLen] = '\0';    // jsmn_parse relies on a string
 
-	if(!isJsonValidAndParse(shadowRxBuf, SHADOW_MAX_SIZE_OF_RX_BUFFER, pJsonHandler, &tokenCount)) {
+	if(!isJsonValidAndParse(pContext->rxBuf, SHADOW_MAX_SIZE_OF_RX_BUFFER, pJsonParser, &tokenCount)) {
 		IOT_WARN("Received JSON is not valid");
 		return;
 	}
 
-	if(shadowDiscardOldDeltaFlag) {
-		if(extractVersionNumber(shadowRxBuf, pJsonHandler, tokenCount, &tempVersionNumber)) {
-			if(tempVersionNumber > shadowJsonVersionNum) {
-				shadowJsonVersionNum = tempVersionNumber;
+	if(pContext->isDiscardOldDeltaEnabled) {
+		if(extractVersionNumber(pContext->rxBuf, pJsonParser, tokenCount, &tempVersionNumber)) {
+			if(tempVersionNumber > pThing->versionNum) {
+				pThing->versionNum = tempVersionNumber;
 			} else {
 				IOT_WARN("Old Delta Message received - Ignoring rx: %d local: %d", tempVersionNumber,
-						 shadowJsonVersionNum);
+						 pThing->versionNum);
 				return;
 			}
 		}
 	}
 
-	for(i = 0; i < tokenTableIndex; i++) {
-		if(!tokenTable[i].isFree) {
-			if(isJsonKeyMatchingAndUpdateValue(shadowRxBuf, pJsonHandler, tokenCount,
-											   (jsonStruct_t *) tokenTable[i].pStruct, &dataLength, &DataPosition)) {
-				if(tokenTable[i].callback != NULL) {
-					tokenTable[i].callback(shadowRxBuf + DataPosition, dataLength,
-										   (jsonStruct_t *) tokenTable[i].pStruct);
-				}
-			}
-		}
+	if(0 == pContext->deltaKeyIndexSize) {
+		return;
 	}
+
+	/* One walk of the document, each key is looked up in the key index */
+	pContext->deltaSequence++;
+	dispatch.pContext = pContext;
+	dispatch.thing = (uint16_t) (pThing - pContext->pThings);
+	walkParsedJsonMembers(pContext->rxBuf, pJsonParser, tokenCount, dispatchDeltaMember, &dispatch);
 }
 
 #ifdef __cplusplus
@@ -0,0 +1,301 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file aws_iot_timer_wheel.c
+ * @brief Hierarchical timer wheel for per-request deadlines
+ *
+ * Ticks are counted with 32 bits and wrap around, slots are selected by the bits of the
+ * expiry tick of the entry so the wrap needs no special case. Only differences of ticks are
+ * compared, the same way as differences of timer_now_ms readings.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+#include "aws_iot_timer_wheel.h"
+
+/** Number of bits of the tick selecting the slot of a level */
+#define TIMER_WHEEL_SLOT_BITS 6
+#define TIMER_WHEEL_SLOT_MASK (AWS_IOT_TIMER_WHEEL_SLOTS - 1)
+/** Number of ticks spanned by each level */
+#define TIMER_WHEEL_LEVEL0_SPAN ((uint32_t) AWS_IOT_TIMER_WHEEL_SLOTS)
+#define TIMER_WHEEL_LEVEL1_SPAN (TIMER_WHEEL_LEVEL0_SPAN * AWS_IOT_TIMER_WHEEL_SLOTS)
+#define TIMER_WHEEL_LEVEL2_SPAN (TIMER_WHEEL_LEVEL1_SPAN * AWS_IOT_TIMER_WHEEL_SLOTS)
+/** Tick differences at or above this value are in the past */
+#define TIMER_WHEEL_PAST_TICKS 0x80000000u
+
+#if (1 << TIMER_WHEEL_SLOT_BITS) != AWS_IOT_TIMER_WHEEL_SLOTS
+#error "AWS_IOT_TIMER_WHEEL_SLOTS must match TIMER_WHEEL_SLOT_BITS"
+#endif
+
+/**
+ * @brief Get the slot list a tick falls in at a level
+ */
+static uint16_t _aws_iot_timer_wheel_list(uint32_t tick, uint8_t level) {
+	return (uint16_t) (level * AWS_IOT_TIMER_WHEEL_SLOTS +
+					   ((tick >> (level * TIMER_WHEEL_SLOT_BITS)) & TIMER_WHEEL_SLOT_MASK));
+}
+
+static void _aws_iot_timer_wheel_unlink(TimerWheel *pWheel, uint16_t index) {
+	TimerWheelEntry *pEntry = &pWheel->pEntries[index];
+
+	if(AWS_IOT_TIMER_WHEEL_INDEX_NONE == pEntry->list) {
+		return;
+	}
+
+	if(AWS_IOT_TIMER_WHEEL_INDEX_NONE != pEntry->prev) {
+		pWheel->pEntries[pEntry->prev].next = pEntry->next;
+	} else {
+		pWheel->listHead[pEntry->list] = pEntry->next;
+	}
+
+	if(AWS_IOT_TIMER_WHEEL_INDEX_NONE != pEntry->next) {
+		pWheel->pEntries[pEntry->next].prev = pEntry->prev;
+	} else if(AWS_IOT_TIMER_WHEEL_EXPIRED_LIST == pEntry->list) {
+		pWheel->expiredTail = pEntry->prev;
+	}
+
+	if(AWS_IOT_TIMER_WHEEL_EXPIRED_LIST != pEntry->list) {
+		pWheel->armedCount--;
+	}
+	pEntry->list = AWS_IOT_TIMER_WHEEL_INDEX_NONE;
+}
+
+static void _aws_iot_timer_wheel_link_expired(TimerWheel *pWheel, uint16_t index) {
+	TimerWheelEntry *pEntry = &pWheel->pEntries[index];
+
+	pEntry->list = AWS_IOT_TIMER_WHEEL_EXPIRED_LIST;
+	pEntry->next = AWS_IOT_TIMER_WHEEL_INDEX_NONE;
+	pEntry->prev = pWheel->expiredTail;
+	if(AWS_IOT_TIMER_WHEEL_INDEX_NONE != pWheel->expiredTail) {
+		pWheel->pEntries[pWheel->expiredTail].next = index;
+	} else {
+		pWheel->listHead[AWS_IOT_TIMER_WHEEL_EXPIRED_LIST] = index;
+	}
+	pWheel->expiredTail = index;
+}
+
+/**
+ * @brief Link an entry into the slot its expiry tick falls in, relative to the current tick
+ */
+static void _aws_iot_timer_wheel_place(TimerWheel *pWheel, uint16_t index) {
+	TimerWheelEntry *pEntry = &pWheel->pEntries[index];
+	uint32_t delta = pEntry->expiryTick - pWheel->currentTick;
+	uint16_t list;
+
+	if(TIMER_WHEEL_PAST_TICKS <= delta) {
+		_aws_iot_timer_wheel_link_expired(pWheel, index);
+		return;
+	}
+
+	if(TIMER_WHEEL_LEVEL0_SPAN > delta) {
+		list = _aws_iot_timer_wheel_list(pEntry->expiryTick, 0);
+	} else if(TIMER_WHEEL_LEVEL1_SPAN > delta) {
+		list = _aws_iot_timer_wheel_list(pEntry->expiryTick, 1);
+	} else if(TIMER_WHEEL_LEVEL2_SPAN > delta) {
+		list = _aws_iot_timer_wheel_list(pEntry->expiryTick, 2);
+	} else {
+		/* Beyond the wheel, parked in the last slot to come round and placed again from there */
+		list = _aws_iot_timer_wheel_list(pWheel->currentTick + TIMER_WHEEL_LEVEL2_SPAN - TIMER_WHEEL_LEVEL1_SPAN, 2);
+	}
+
+	pEntry->list = list;
+	pEntry->prev = AWS_IOT_TIMER_WHEEL_INDEX_NONE;
+	pEntry->next = pWheel->listHead[list];
+	if(AWS_IOT_TIMER_WHEEL_INDEX_NONE != pEntry->next) {
+		pWheel->pEntries[pEntry->next].prev = index;
+	}
+	pWheel->listHead[list] = index;
+	pWheel->armedCount++;
+}
+
+/**
+ * @brief Move every entry of a slot list down to where it belongs now
+ */
+static void _aws_iot_timer_wheel_cascade(TimerWheel *pWheel, uint16_t list) {
+	uint16_t index = pWheel->listHead[list];
+	uint16_t next;
+
+	while(AWS_IOT_TIMER_WHEEL_INDEX_NONE != index) {
+		next = pWheel->pEntries[index].next;
+		_aws_iot_timer_wheel_unlink(pWheel, index);
+		_aws_iot_timer_wheel_place(pWheel, index);
+		index = next;
+	}
+}
+
+/**
+ * @brief Process the current tick, which has fully elapsed
+ */
+static void _aws_iot_timer_wheel_process_tick(TimerWheel *pWheel) {
+	uint32_t tick = pWheel->currentTick;
+	uint16_t list;
+	uint16_t index;
+
+	if(0 == (tick & (TIMER_WHEEL_LEVEL0_SPAN - 1))) {
+		if(0 == (tick & (TIMER_WHEEL_LEVEL1_SPAN - 1))) {
+			_aws_iot_timer_wheel_cascade(pWheel, _aws_iot_timer_wheel_list(tick, 2));
+		}
+		_aws_iot_timer_wheel_cascade(pWheel, _aws_iot_timer_wheel_list(tick, 1));
+	}
+
+	list = _aws_iot_timer_wheel_list(tick, 0);
+	while(AWS_IOT_TIMER_WHEEL_INDEX_NONE != pWheel->listHead[list]) {
+		index = pWheel->listHead[list];
+		_aws_iot_timer_wheel_unlink(pWheel, index);
+		_aws_iot_timer_wheel_link_expired(pWheel, index);
+	}
+}
+
+/**
+ * @brief Check whether processing a tick would cascade or expire entries
+ */
+static bool _aws_iot_timer_wheel_is_tick_busy(TimerWheel *pWheel, uint32_t tick) {
+	if(AWS_IOT_TIMER_WHEEL_INDEX_NONE != pWheel->listHead[_aws_iot_timer_wheel_list(tick, 0)]) {
+		return true;
+	}
+
+	if(0 != (tick & (TIMER_WHEEL_LEVEL0_SPAN - 1))) {
+		return false;
+	}
+
+	if(AWS_IOT_TIMER_WHEEL_INDEX_NONE != pWheel->listHead[_aws_iot_timer_wheel_list(tick, 1)]) {
+		return true;
+	}
+
+	return 0 == (tick & (TIMER_WHEEL_LEVEL1_SPAN - 1)) &&
+		   AWS_IOT_TIMER_WHEEL_INDEX_NONE != pWheel->listHead[_aws_iot_timer_wheel_list(tick, 2)];
+}
+
+void aws_iot_timer_wheel_init(TimerWheel *pWheel, TimerWheelEntry *pEntries, uint16_t entryCount) {
+	uint16_t itr;
+
+	pWheel->pEntries = pEntries;
+	pWheel->entryCount = entryCount;
+	pWheel->armedCount = 0;
+	pWheel->currentTick = 0;
+	pWheel->currentTickStartMs = timer_now_ms();
+	pWheel->expiredTail = AWS_IOT_TIMER_WHEEL_INDEX_NONE;
+
+	for(itr = 0; itr <= AWS_IOT_TIMER_WHEEL_EXPIRED_LIST; itr++) {
+		pWheel->listHead[itr] = AWS_IOT_TIMER_WHEEL_INDEX_NONE;
+	}
+
+	for(itr = 0; itr < entryCount; itr++) {
+		pEntries[itr].list = AWS_IOT_TIMER_WHEEL_INDEX_NONE;
+		pEntries[itr].next = AWS_IOT_TIMER_WHEEL_INDEX_NONE;
+		pEntries[itr].prev = AWS_IOT_TIMER_WHEEL_INDEX_NONE;
+		pEntries[itr].expiryTick = 0;
+	}
+}
+
+void aws_iot_timer_wheel_arm(TimerWheel *pWheel, uint16_t index, uint32_t timeout_ms) {
+	uint32_t now = timer_now_ms();
+	uint64_t ticks;
+
+	if(index >= pWheel->entryCount) {
+		return;
+	}
+
+	_aws_iot_timer_wheel_unlink(pWheel, index);
+
+	if(0 == pWheel->armedCount) {
+		/* Nothing to process in between, skip the idle ticks */
+		pWheel->currentTickStartMs = now;
+	}
+
+	/* Round up, a deadline inside a tick is only passed at the end of that tick */
+	ticks = ((uint64_t) (uint32_t) (now - pWheel->currentTickStartMs) + timeout_ms + AWS_IOT_TIMER_WHEEL_TICK_MS - 1) /
+			AWS_IOT_TIMER_WHEEL_TICK_MS;
+	if(0 == ticks) {
+		_aws_iot_timer_wheel_link_expired(pWheel, index);
+		return;
+	}
+
+	pWheel->pEntries[index].expiryTick = pWheel->currentTick + (uint32_t) (ticks - 1);
+	_aws_iot_timer_wheel_place(pWheel, index);
+}
+
+void aws_iot_timer_wheel_disarm(TimerWheel *pWheel, uint16_t index) {
+	if(index < pWheel->entryCount) {
+		_aws_iot_timer_wheel_unlink(pWheel, index);
+	}
+}
+
+void aws_iot_timer_wheel_advance(TimerWheel *pWheel) {
+	uint32_t now = timer_now_ms();
+
+	while(0 < pWheel->armedCount && AWS_IOT_TIMER_WHEEL_TICK_MS <= (uint32_t) (now - pWheel->currentTickStartMs)) {
+		_aws_iot_timer_wheel_process_tick(pWheel);
+		pWheel->currentTick++;
+		pWheel->currentTickStartMs += AWS_IOT_TIMER_WHEEL_TICK_MS;
+	}
+
+	if(0 == pWheel->armedCount) {
+		pWheel->currentTickStartMs = now;
+	}
+}
+
+uint16_t aws_iot_timer_wheel_pop_expired(TimerWheel *pWheel) {
+	uint16_t index = pWheel->listHead[AWS_IOT_TIMER_WHEEL_EXPIRED_LIST];
+
+	if(AWS_IOT_TIMER_WHEEL_INDEX_NONE != index) {
+		_aws_iot_timer_wheel_unlink(pWheel, index);
+	}
+
+	return index;
+}
+
+uint32_t aws_iot_timer_wheel_next_deadline_ms(TimerWheel *pWheel) {
+	uint32_t elapsed, due;
+	uint32_t tick = pWheel->currentTick;
+	uint32_t stride = 1;
+	uint8_t level, itr;
+
+	if(AWS_IOT_TIMER_WHEEL_INDEX_NONE != pWheel->listHead[AWS_IOT_TIMER_WHEEL_EXPIRED_LIST]) {
+		return 0;
+	}
+
+	if(0 == pWheel->armedCount) {
+		return UINT32_MAX;
+	}
+
+	/* Every tick of a turn of level 0, then every cascade of level 1, then of level 2 */
+	for(level = 0; level < AWS_IOT_TIMER_WHEEL_LEVELS; level++) {
+		if(0 < level) {
+			stride *= AWS_IOT_TIMER_WHEEL_SLOTS;
+			tick = (tick + stride - 1) & ~(stride - 1);
+		}
+		for(itr = 0; itr < AWS_IOT_TIMER_WHEEL_SLOTS; itr++) {
+			if(_aws_iot_timer_wheel_is_tick_busy(pWheel, tick)) {
+				elapsed = timer_now_ms() - pWheel->currentTickStartMs;
+				due = (tick - pWheel->currentTick + 1) * AWS_IOT_TIMER_WHEEL_TICK_MS;
+				return due > elapsed ? due - elapsed : 0;
+			}
+			tick += stride;
+		}
+	}
+
+	/* Not reached while the armed count is right, come back within a turn of the wheel */
+	return TIMER_WHEEL_LEVEL2_SPAN * AWS_IOT_TIMER_WHEEL_TICK_MS;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,217 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file aws_iot_tests_benchmark_outbound_queue.c
+ * @brief IoT Client Benchmarks - Concurrent publishers
+ *
+ * Several threads publish small QoS0 messages on one client while another thread yields, as
+ * publishes from other threads are only made during a yield. The network write is replaced by
+ * a sink that sleeps for a fixed time per call, like a system call sending one TLS record.
+ * Built once with the outbound queue and once without, it prints the publish rate and the
+ * number of network writes the messages took.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <sys/time.h>
+
+#include "aws_iot_mqtt_client_interface.h"
+#include "aws_iot_tests_unit_mock_tls_params.h"
+
+#define QUEUE_PUBLISHERS 4
+#define QUEUE_MESSAGES_PER_PUBLISHER 20000
+/** Time one network write takes, in microseconds */
+#define QUEUE_WRITE_COST_US 20
+#define QUEUE_PAYLOAD "{\"temperature\":21.5,\"seq\":0}"
+
+/** Yield timeout of the reading thread, publishes made between two yields are retried */
+#define QUEUE_YIELD_TIMEOUT_MS 100
+
+static AWS_IoT_Client client;
+static uint32_t networkWrites;
+static uint32_t publishErrors;
+static uint32_t publishRetries;
+static volatile bool isPublishing;
+static pthread_mutex_t countLock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint64_t now_us(void) {
+	struct timeval now;
+
+	gettimeofday(&now, NULL);
+	return (uint64_t) now.tv_sec * 1000000u + (uint64_t) now.tv_usec;
+}
+
+static void spend_write_cost(void) {
+	struct timespec cost = {0, QUEUE_WRITE_COST_US * 1000};
+
+	nanosleep(&cost, NULL);
+}
+
+static IoT_Error_t sink_write(Network *pNetwork, unsigned char *pMsg, size_t len, Timer *pTimer,
+							  size_t *pWrittenLen) {
+	IOT_UNUSED(pNetwork);
+	IOT_UNUSED(pMsg);
+	IOT_UNUSED(pTimer);
+
+	spend_write_cost();
+	pthread_mutex_lock(&countLock);
+	networkWrites++;
+	pthread_mutex_unlock(&countLock);
+	*pWrittenLen = len;
+
+	return SUCCESS;
+}
+
+static IoT_Error_t sink_write_vector(Network *pNetwork, NetworkBufferVector *pVector, size_t vectorCount,
+									 Timer *pTimer, size_t *pWrittenLen) {
+	size_t itr;
+
+	*pWrittenLen = 0;
+	for(itr = 0; itr < vectorCount; itr++) {
+		*pWrittenLen += pVector[itr].len;
+	}
+
+	return sink_write(pNetwork, NULL, *pWrittenLen, pTimer, pWrittenLen);
+}
+
+static void *publisher(void *pArg) {
+	IoT_Publish_Message_Params params;
+	uint32_t itr;
+	IoT_Error_t rc;
+
+	IOT_UNUSED(pArg);
+
+	params.qos = QOS0;
+	params.isRetained = 0;
+	params.payload = (void *) QUEUE_PAYLOAD;
+	params.payloadLen = strlen(QUEUE_PAYLOAD);
+	for(itr = 0; itr < QUEUE_MESSAGES_PER_PUBLISHER; itr++) {
+		rc = aws_iot_mqtt_publish(&client, "sdk/bench/telemetry", 19, &params);
+		if(MQTT_CLIENT_NOT_IDLE_ERROR == rc) {
+			/* Between two yields, or another publisher got the client first */
+			pthread_mutex_lock(&countLock);
+			publishRetries++;
+			pthread_mutex_unlock(&countLock);
+			sched_yield();
+			itr--;
+		} else if(SUCCESS != rc) {
+			pthread_mutex_lock(&countLock);
+			publishErrors++;
+			pthread_mutex_unlock(&countLock);
+		}
+	}
+
+	return NULL;
+}
+
+static void *yielder(void *pArg) {
+	IOT_UNUSED(pArg);
+
+	while(isPublishing) {
+		aws_iot_mqtt_yield(&client, QUEUE_YIELD_TIMEOUT_MS);
+	}
+
+	return NULL;
+}
+
+static IoT_Error_t connect_client(void) {
+	IoT_Client_Init_Params initParams = iotClientInitParamsDefault;
+	IoT_Client_Connect_Params connectParams = iotClientConnectParamsDefault;
+	IoT_Error_t rc;
+
+	initParams.pHostURL = AWS_IOT_MQTT_HOST;
+	initParams.port = AWS_IOT_MQTT_PORT;
+	initParams.pRootCALocation = AWS_IOT_ROOT_CA_FILENAME;
+	initParams.pDeviceCertLocation = AWS_IOT_CERTIFICATE_FILENAME;
+	initParams.pDevicePrivateKeyLocation = AWS_IOT_PRIVATE_KEY_FILENAME;
+	initParams.mqttCommandTimeout_ms = 20000;
+	initParams.tlsHandshakeTimeout_ms = 5000;
+	initParams.isBlockOnThreadLockEnabled = true;
+	rc = aws_iot_mqtt_init(&client, &initParams);
+	if(SUCCESS != rc) {
+		return rc;
+	}
+
+	/* CONNACK, session not present, accepted */
+	RxBuffer.pBuffer[0] = 0x20;
+	RxBuffer.pBuffer[1] = 0x02;
+	RxBuffer.pBuffer[2] = 0x00;
+	RxBuffer.pBuffer[3] = 0x00;
+	RxBuffer.len = 4;
+	RxBuffer.NoMsgFlag = false;
+	RxIndex = 0;
+
+	connectParams.keepAliveIntervalInSec = 600;
+	connectParams.isCleanSession = true;
+	connectParams.MQTTVersion = MQTT_3_1_1;
+	connectParams.pClientID = AWS_IOT_MQTT_CLIENT_ID;
+	connectParams.clientIDLen = (uint16_t) strlen(AWS_IOT_MQTT_CLIENT_ID);
+	rc = aws_iot_mqtt_connect(&client, &connectParams);
+	if(SUCCESS != rc) {
+		return rc;
+	}
+
+	client.networkStack.write = sink_write;
+	client.networkStack.writeVector = sink_write_vector;
+
+	return SUCCESS;
+}
+
+int main(void) {
+	pthread_t threads[QUEUE_PUBLISHERS];
+	pthread_t yieldThread;
+	uint32_t messages = QUEUE_PUBLISHERS * QUEUE_MESSAGES_PER_PUBLISHER;
+	uint64_t start, elapsed;
+	IoT_Error_t rc;
+	int itr;
+
+	rc = connect_client();
+	if(SUCCESS != rc) {
+		printf("Connect failed: %d\n", rc);
+		return 1;
+	}
+
+	isPublishing = true;
+	pthread_create(&yieldThread, NULL, yielder, NULL);
+	start = now_us();
+	for(itr = 0; itr < QUEUE_PUBLISHERS; itr++) {
+		pthread_create(&threads[itr], NULL, publisher, NULL);
+	}
+	for(itr = 0; itr < QUEUE_PUBLISHERS; itr++) {
+		pthread_join(threads[itr], NULL);
+	}
+	elapsed = now_us() - start;
+	isPublishing = false;
+	pthread_join(yieldThread, NULL);
+
+#ifdef AWS_IOT_MQTT_OUTBOUND_QUEUE_SLOTS
+	printf("\nOutbound queue, %d slots\n", AWS_IOT_MQTT_OUTBOUND_QUEUE_SLOTS);
+#else
+	printf("\nWrite buffer lock only\n");
+#endif
+	printf("%d publishers, %u QoS0 messages of %u bytes, %d us per network write\n", QUEUE_PUBLISHERS, messages,
+		   (unsigned) strlen(QUEUE_PAYLOAD), QUEUE_WRITE_COST_US);
+	printf("%10.0f messages/s, %u network writes, %.2f messages per write, %u retries, %u errors\n",
+		   (double) messages * 1000000.0 / (double) elapsed, networkWrites, (double) messages / (double) networkWrites,
+		   publishRetries, publishErrors);
+
+	aws_iot_mqtt_free(&client);
+
+	return (0 == publishErrors) ? 0 : 1;
+}
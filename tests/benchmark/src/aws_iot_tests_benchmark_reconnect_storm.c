@@ -0,0 +1,201 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file aws_iot_tests_benchmark_reconnect_storm.c
+ * @brief IoT Client Benchmarks - Reconnect storm
+ *
+ * Simulates a fleet of clients losing the broker at the same time, in virtual time. The broker
+ * refuses every attempt during the outage, then accepts a limited number of connections per
+ * window. Each reconnect policy is run on the same fleet, printing the peak number of attempts
+ * in a window, the total number of attempts and the time the clients take to reconnect.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "aws_iot_mqtt_client_common_internal.h"
+
+#define STORM_CLIENTS 10000
+/** Spread of the moments the clients notice the broker is gone */
+#define STORM_DETECTION_SPREAD_MS 1000
+#define STORM_OUTAGE_MS 30000
+#define STORM_WINDOW_MS 100
+/** Connections the broker accepts per window once it is back */
+#define STORM_WINDOW_CAPACITY 200
+#define STORM_HORIZON_MS 3600000
+#define STORM_CLIENT_ID_LEN 24
+
+typedef struct {
+	char clientId[STORM_CLIENT_ID_LEN];
+	uint32_t jitterState;
+	uint32_t attempt;
+	uint32_t previousWait;
+	uint32_t nextAttemptMs;
+	uint32_t reconnectedMs;
+	bool isDone;
+	bool hasGivenUp;
+} StormClient;
+
+typedef struct {
+	uint32_t peakOutageAttempts;
+	uint32_t peakRecoveryAttempts;
+	uint32_t totalAttempts;
+	uint32_t reconnected;
+	uint32_t gaveUp;
+	uint32_t p50Ms;
+	uint32_t p99Ms;
+	uint32_t lastMs;
+} StormResult;
+
+/* One client runs the policies, the state of the simulated client is swapped in around each call */
+static AWS_IoT_Client client;
+static StormClient fleet[STORM_CLIENTS];
+static uint32_t windowClients[STORM_CLIENTS];
+static uint32_t reconnectTimes[STORM_CLIENTS];
+
+static uint32_t next_wait(StormClient *pStormClient, iot_reconnect_policy policy) {
+	uint32_t wait;
+
+	client.clientData.options.pClientID = pStormClient->clientId;
+	client.clientData.options.clientIDLen = (uint16_t) strlen(pStormClient->clientId);
+	client.clientData.reconnectJitterState = pStormClient->jitterState;
+	wait = policy(&client, pStormClient->attempt, pStormClient->previousWait);
+	pStormClient->jitterState = client.clientData.reconnectJitterState;
+
+	return wait;
+}
+
+static void schedule(StormClient *pStormClient, uint32_t nowMs, iot_reconnect_policy policy) {
+	uint32_t wait = next_wait(pStormClient, policy);
+
+	if(AWS_IOT_MQTT_RECONNECT_GIVE_UP == wait) {
+		pStormClient->isDone = true;
+		pStormClient->hasGivenUp = true;
+		return;
+	}
+	pStormClient->previousWait = wait;
+	pStormClient->nextAttemptMs = nowMs + wait;
+}
+
+static int compare_attempt_time(const void *pA, const void *pB) {
+	uint32_t a = fleet[*(const uint32_t *) pA].nextAttemptMs;
+	uint32_t b = fleet[*(const uint32_t *) pB].nextAttemptMs;
+
+	return (a > b) - (a < b);
+}
+
+static int compare_ms(const void *pA, const void *pB) {
+	uint32_t a = *(const uint32_t *) pA;
+	uint32_t b = *(const uint32_t *) pB;
+
+	return (a > b) - (a < b);
+}
+
+static void run_storm(iot_reconnect_policy policy, StormResult *pResult) {
+	uint32_t windowStart, windowCount, accepted, pending, itr;
+	uint32_t detectionSeed = 12345;
+	StormClient *pStormClient;
+
+	memset(pResult, 0, sizeof(StormResult));
+	for(itr = 0; itr < STORM_CLIENTS; itr++) {
+		pStormClient = &fleet[itr];
+		memset(pStormClient, 0, sizeof(StormClient));
+		snprintf(pStormClient->clientId, STORM_CLIENT_ID_LEN, "sensor-%05u", itr);
+		detectionSeed = detectionSeed * 1103515245u + 12345u;
+		pStormClient->attempt = 1;
+		schedule(pStormClient, (detectionSeed >> 8) % STORM_DETECTION_SPREAD_MS, policy);
+	}
+
+	pending = STORM_CLIENTS;
+	for(windowStart = 0; 0 < pending && windowStart < STORM_HORIZON_MS; windowStart += STORM_WINDOW_MS) {
+		windowCount = 0;
+		for(itr = 0; itr < STORM_CLIENTS; itr++) {
+			if(!fleet[itr].isDone && fleet[itr].nextAttemptMs < windowStart + STORM_WINDOW_MS) {
+				windowClients[windowCount++] = itr;
+			}
+		}
+		if(0 == windowCount) {
+			continue;
+		}
+
+		pResult->totalAttempts += windowCount;
+		if(windowStart < STORM_OUTAGE_MS) {
+			if(windowCount > pResult->peakOutageAttempts) {
+				pResult->peakOutageAttempts = windowCount;
+			}
+		} else if(windowCount > pResult->peakRecoveryAttempts) {
+			pResult->peakRecoveryAttempts = windowCount;
+		}
+
+		/* First come, first served */
+		qsort(windowClients, windowCount, sizeof(uint32_t), compare_attempt_time);
+		accepted = 0;
+		for(itr = 0; itr < windowCount; itr++) {
+			pStormClient = &fleet[windowClients[itr]];
+			if(STORM_OUTAGE_MS <= pStormClient->nextAttemptMs && STORM_WINDOW_CAPACITY > accepted) {
+				accepted++;
+				pStormClient->isDone = true;
+				pStormClient->reconnectedMs = pStormClient->nextAttemptMs - STORM_OUTAGE_MS;
+				reconnectTimes[pResult->reconnected++] = pStormClient->reconnectedMs;
+			} else {
+				pStormClient->attempt++;
+				schedule(pStormClient, pStormClient->nextAttemptMs, policy);
+			}
+			if(pStormClient->isDone) {
+				pending--;
+				if(pStormClient->hasGivenUp) {
+					pResult->gaveUp++;
+				}
+			}
+		}
+	}
+
+	if(0 < pResult->reconnected) {
+		qsort(reconnectTimes, pResult->reconnected, sizeof(uint32_t), compare_ms);
+		pResult->p50Ms = reconnectTimes[(pResult->reconnected - 1) / 2];
+		pResult->p99Ms = reconnectTimes[(pResult->reconnected - 1) * 99 / 100];
+		pResult->lastMs = reconnectTimes[pResult->reconnected - 1];
+	}
+}
+
+static void print_result(const char *pName, StormResult *pResult) {
+	printf("%-24s %10u %10u %10u %10u %8u %10.1f %10.1f %10.1f\n", pName, pResult->peakOutageAttempts,
+		   pResult->peakRecoveryAttempts, pResult->totalAttempts, pResult->reconnected, pResult->gaveUp,
+		   pResult->p50Ms / 1000.0, pResult->p99Ms / 1000.0, pResult->lastMs / 1000.0);
+}
+
+int main(void) {
+	StormResult result;
+
+	client.clientData.minReconnectWaitMs = AWS_IOT_MQTT_MIN_RECONNECT_WAIT_INTERVAL;
+	client.clientData.maxReconnectWaitMs = AWS_IOT_MQTT_MAX_RECONNECT_WAIT_INTERVAL;
+
+	printf("%u clients, broker down for %u s, then accepting %u connections per %u ms\n", STORM_CLIENTS,
+		   STORM_OUTAGE_MS / 1000, STORM_WINDOW_CAPACITY, STORM_WINDOW_MS);
+	printf("Attempts are counted per %u ms window, times are in seconds after the broker is back\n\n",
+		   STORM_WINDOW_MS);
+	printf("%-24s %10s %10s %10s %10s %8s %10s %10s %10s\n", "policy", "peak down", "peak up", "attempts",
+		   "reconnect", "gave up", "p50 s", "p99 s", "last s");
+
+	run_storm(aws_iot_mqtt_reconnect_policy_exponential, &result);
+	print_result("exponential", &result);
+
+	run_storm(aws_iot_mqtt_reconnect_policy_decorrelated_jitter, &result);
+	print_result("decorrelated jitter", &result);
+
+	return 0;
+}
@@ -0,0 +1,284 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file aws_iot_tests_benchmark_tls_resumption.c
+ * @brief IoT Client Benchmarks - TLS session resumption
+ *
+ * Compares the time taken by iot_tls_connect for a full handshake against a handshake
+ * resuming the session saved by the previous connect, and by a new network instance
+ * reading the session from a file as after a restart. A local mbedTLS server with the
+ * mbedTLS test certificates runs in a thread, with both a session cache and tickets.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "network_interface.h"
+#include "mbedtls/ssl_cache.h"
+#include "mbedtls/ssl_ticket.h"
+
+#define BENCHMARK_ITERATIONS 50
+#define BENCHMARK_SERVER_HOST "localhost"
+#define BENCHMARK_SERVER_PORT 4433
+#define BENCHMARK_HANDSHAKE_TIMEOUT_MS 5000
+
+#define BENCHMARK_ROOT_CA_FILENAME "/tmp/aws_iot_benchmark_ca.crt"
+#define BENCHMARK_CERTIFICATE_FILENAME "/tmp/aws_iot_benchmark_cli.crt"
+#define BENCHMARK_PRIVATE_KEY_FILENAME "/tmp/aws_iot_benchmark_cli.key"
+#define BENCHMARK_SESSION_FILENAME "/tmp/aws_iot_benchmark_session"
+
+/* Full handshakes, resumed from memory, resumed from the file */
+#define BENCHMARK_CONNECTIONS (BENCHMARK_ITERATIONS * 3)
+
+typedef struct {
+	mbedtls_net_context listen_fd;
+	mbedtls_entropy_context entropy;
+	mbedtls_ctr_drbg_context ctr_drbg;
+	mbedtls_ssl_config conf;
+	mbedtls_x509_crt srvcert;
+	mbedtls_x509_crt cacert;
+	mbedtls_pk_context pkey;
+	mbedtls_ssl_cache_context cache;
+	mbedtls_ssl_ticket_context ticket;
+	uint32_t resumedCount;
+} BenchmarkServer;
+
+static BenchmarkServer server;
+
+/* Counts the sessions found in the cache, resumed by session ID */
+static int benchmark_cache_get(void *data, mbedtls_ssl_session *session) {
+	int ret = mbedtls_ssl_cache_get(data, session);
+
+	if(0 == ret) {
+		server.resumedCount++;
+	}
+	return ret;
+}
+
+/* Counts the sessions resumed by ticket */
+static int benchmark_ticket_parse(void *p_ticket, mbedtls_ssl_session *session, unsigned char *buf, size_t len) {
+	int ret = mbedtls_ssl_ticket_parse(p_ticket, session, buf, len);
+
+	if(0 == ret) {
+		server.resumedCount++;
+	}
+	return ret;
+}
+
+static int benchmark_server_setup(void) {
+	const char *pers = "aws_iot_benchmark_server";
+	char portBuffer[6];
+	int ret;
+
+	mbedtls_net_init(&server.listen_fd);
+	mbedtls_entropy_init(&server.entropy);
+	mbedtls_ctr_drbg_init(&server.ctr_drbg);
+	mbedtls_ssl_config_init(&server.conf);
+	mbedtls_x509_crt_init(&server.srvcert);
+	mbedtls_x509_crt_init(&server.cacert);
+	mbedtls_pk_init(&server.pkey);
+	mbedtls_ssl_cache_init(&server.cache);
+	mbedtls_ssl_ticket_init(&server.ticket);
+	server.resumedCount = 0;
+
+	if(0 != (ret = mbedtls_ctr_drbg_seed(&server.ctr_drbg, mbedtls_entropy_func, &server.entropy,
+										 (const unsigned char *) pers, strlen(pers)))
+	   || 0 != (ret = mbedtls_x509_crt_parse(&server.srvcert, (const unsigned char *) mbedtls_test_srv_crt,
+											 mbedtls_test_srv_crt_len))
+	   || 0 != (ret = mbedtls_x509_crt_parse(&server.cacert, (const unsigned char *) mbedtls_test_cas_pem,
+											 mbedtls_test_cas_pem_len))
+	   || 0 != (ret = mbedtls_pk_parse_key(&server.pkey, (const unsigned char *) mbedtls_test_srv_key,
+										   mbedtls_test_srv_key_len, NULL, 0))) {
+		printf("Server credentials setup failed: -0x%x\n", -ret);
+		return ret;
+	}
+
+	if(0 != (ret = mbedtls_ssl_config_defaults(&server.conf, MBEDTLS_SSL_IS_SERVER, MBEDTLS_SSL_TRANSPORT_STREAM,
+											   MBEDTLS_SSL_PRESET_DEFAULT))
+	   || 0 != (ret = mbedtls_ssl_conf_own_cert(&server.conf, &server.srvcert, &server.pkey))
+	   || 0 != (ret = mbedtls_ssl_ticket_setup(&server.ticket, mbedtls_ctr_drbg_random, &server.ctr_drbg,
+											   MBEDTLS_CIPHER_AES_256_GCM, 86400))) {
+		printf("Server configuration failed: -0x%x\n", -ret);
+		return ret;
+	}
+
+	/* The client authenticates with a certificate, as with AWS IoT */
+	mbedtls_ssl_conf_authmode(&server.conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+	mbedtls_ssl_conf_ca_chain(&server.conf, &server.cacert, NULL);
+	mbedtls_ssl_conf_rng(&server.conf, mbedtls_ctr_drbg_random, &server.ctr_drbg);
+	mbedtls_ssl_conf_session_cache(&server.conf, &server.cache, benchmark_cache_get, mbedtls_ssl_cache_set);
+	mbedtls_ssl_conf_session_tickets_cb(&server.conf, mbedtls_ssl_ticket_write, benchmark_ticket_parse,
+										&server.ticket);
+
+	snprintf(portBuffer, sizeof(portBuffer), "%d", BENCHMARK_SERVER_PORT);
+	if(0 != (ret = mbedtls_net_bind(&server.listen_fd, BENCHMARK_SERVER_HOST, portBuffer, MBEDTLS_NET_PROTO_TCP))) {
+		printf("Server bind failed: -0x%x\n", -ret);
+		return ret;
+	}
+
+	return 0;
+}
+
+/* Accepts the connections of the benchmark one after the other, until the client closes each */
+static void *benchmark_server_run(void *arg) {
+	mbedtls_net_context client_fd;
+	mbedtls_ssl_context ssl;
+	unsigned char buf[64];
+	uint32_t connection;
+	int ret;
+	IOT_UNUSED(arg);
+
+	mbedtls_ssl_init(&ssl);
+	if(0 != mbedtls_ssl_setup(&ssl, &server.conf)) {
+		return NULL;
+	}
+
+	for(connection = 0; connection < BENCHMARK_CONNECTIONS; connection++) {
+		mbedtls_net_init(&client_fd);
+		if(0 != mbedtls_net_accept(&server.listen_fd, &client_fd, NULL, 0, NULL)) {
+			break;
+		}
+		mbedtls_ssl_set_bio(&ssl, &client_fd, mbedtls_net_send, mbedtls_net_recv, NULL);
+
+		do {
+			ret = mbedtls_ssl_handshake(&ssl);
+		} while(MBEDTLS_ERR_SSL_WANT_READ == ret || MBEDTLS_ERR_SSL_WANT_WRITE == ret);
+
+		while(0 == ret && 0 < mbedtls_ssl_read(&ssl, buf, sizeof(buf))) {
+		}
+
+		mbedtls_net_free(&client_fd);
+		mbedtls_ssl_session_reset(&ssl);
+	}
+
+	mbedtls_ssl_free(&ssl);
+	return NULL;
+}
+
+static int write_file(const char *pPath, const char *pContent) {
+	FILE *pFile = fopen(pPath, "w");
+	size_t len = strlen(pContent);
+
+	if(NULL == pFile) {
+		return -1;
+	}
+	if(len != fwrite(pContent, 1, len, pFile)) {
+		fclose(pFile);
+		return -1;
+	}
+	return fclose(pFile);
+}
+
+static double elapsed_ms(struct timespec *pStart, struct timespec *pEnd) {
+	return (double) (pEnd->tv_sec - pStart->tv_sec) * 1e3 + (double) (pEnd->tv_nsec - pStart->tv_nsec) / 1e6;
+}
+
+static void network_init(Network *pNetwork, char *pTlsSessionLocation) {
+	iot_tls_init(pNetwork, BENCHMARK_ROOT_CA_FILENAME, BENCHMARK_CERTIFICATE_FILENAME, BENCHMARK_PRIVATE_KEY_FILENAME,
+				 BENCHMARK_SERVER_HOST, BENCHMARK_SERVER_PORT, BENCHMARK_HANDSHAKE_TIMEOUT_MS, true,
+				 pTlsSessionLocation);
+}
+
+/* Connects and closes, returning the time taken by the connect */
+static double timed_connect(Network *pNetwork, IoT_Error_t *pRc) {
+	struct timespec start, end;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	*pRc = iot_tls_connect(pNetwork, NULL);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	iot_tls_disconnect(pNetwork);
+	iot_tls_destroy(pNetwork);
+
+	return elapsed_ms(&start, &end);
+}
+
+/* A new network instance for every connect, that has no session to offer unless it reads one from a file */
+static double run_fresh(char *pTlsSessionLocation, uint32_t *pResumed) {
+	Network network;
+	IoT_Error_t rc = SUCCESS;
+	uint32_t itr, resumedBefore = server.resumedCount;
+	double totalMs = 0;
+
+	for(itr = 0; itr < BENCHMARK_ITERATIONS && SUCCESS == rc; itr++) {
+		network_init(&network, pTlsSessionLocation);
+		totalMs += timed_connect(&network, &rc);
+		iot_tls_free(&network);
+	}
+
+	*pResumed = server.resumedCount - resumedBefore;
+	return (SUCCESS == rc) ? totalMs / BENCHMARK_ITERATIONS : -1;
+}
+
+/* One network instance reconnecting, as the client does on auto-reconnect */
+static double run_reconnect(uint32_t *pResumed) {
+	Network network;
+	IoT_Error_t rc;
+	uint32_t itr, resumedBefore;
+	double totalMs = 0;
+
+	network_init(&network, NULL);
+	timed_connect(&network, &rc);
+
+	resumedBefore = server.resumedCount;
+	for(itr = 0; itr < BENCHMARK_ITERATIONS - 1 && SUCCESS == rc; itr++) {
+		totalMs += timed_connect(&network, &rc);
+	}
+	iot_tls_free(&network);
+
+	*pResumed = server.resumedCount - resumedBefore;
+	return (SUCCESS == rc) ? totalMs / (BENCHMARK_ITERATIONS - 1) : -1;
+}
+
+int main(void) {
+	pthread_t serverThread;
+	uint32_t fullResumed, memoryResumed, fileResumed;
+	double fullMs, memoryMs, fileMs;
+
+	if(0 != write_file(BENCHMARK_ROOT_CA_FILENAME, mbedtls_test_cas_pem)
+	   || 0 != write_file(BENCHMARK_CERTIFICATE_FILENAME, mbedtls_test_cli_crt)
+	   || 0 != write_file(BENCHMARK_PRIVATE_KEY_FILENAME, mbedtls_test_cli_key)) {
+		printf("Unable to write the client credentials\n");
+		return 1;
+	}
+	unlink(BENCHMARK_SESSION_FILENAME);
+
+	if(0 != benchmark_server_setup() || 0 != pthread_create(&serverThread, NULL, benchmark_server_run, NULL)) {
+		return 1;
+	}
+
+	fullMs = run_fresh(NULL, &fullResumed);
+	memoryMs = (0 > fullMs) ? -1 : run_reconnect(&memoryResumed);
+	fileMs = (0 > memoryMs) ? -1 : run_fresh(BENCHMARK_SESSION_FILENAME, &fileResumed);
+	unlink(BENCHMARK_SESSION_FILENAME);
+
+	/* The server thread still waits for the connections that were not made */
+	if(0 > fileMs) {
+		printf("Connect to the local server failed\n");
+		return 1;
+	}
+	pthread_join(serverThread, NULL);
+
+	printf("%24s %14s %10s\n", "handshake", "ms/connect", "resumed");
+	printf("%24s %14.2f %10u\n", "full", fullMs, fullResumed);
+	printf("%24s %14.2f %10u\n", "resumed on reconnect", memoryMs, memoryResumed);
+	printf("%24s %14.2f %10u\n", "resumed after restart", fileMs, fileResumed);
+
+	return 0;
+}
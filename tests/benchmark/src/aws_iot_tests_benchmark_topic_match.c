@@ -0,0 +1,191 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file aws_iot_tests_benchmark_topic_match.c
+ * @brief IoT Client Benchmarks - Topic matching
+ *
+ * Compares the cost of finding the subscriptions matching an incoming topic with the
+ * subscription index against a scan of every message handler, for an increasing number
+ * of subscriptions. Prints the time per match and the number of subscriptions from which
+ * the index is faster.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "aws_iot_mqtt_client_common_internal.h"
+
+#define BENCHMARK_ITERATIONS 200000
+#define BENCHMARK_TOPIC_LEN 64
+
+static AWS_IoT_Client client;
+static char topicFilters[AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS][BENCHMARK_TOPIC_LEN];
+
+static void benchmark_handler(AWS_IoT_Client *pClient, char *pTopicName, uint16_t topicNameLen,
+							  IoT_Publish_Message_Params *pParams, void *pClientData) {
+	IOT_UNUSED(pClient);
+	IOT_UNUSED(pTopicName);
+	IOT_UNUSED(topicNameLen);
+	IOT_UNUSED(pParams);
+	IOT_UNUSED(pClientData);
+}
+
+/* Matching used before the subscription index, kept as the reference */
+static bool linear_is_topic_matched(char *pTopicFilter, char *pTopicName, uint16_t topicNameLen) {
+	char *curf, *curn, *curn_end;
+
+	if(NULL == pTopicFilter || NULL == pTopicName) {
+		return false;
+	}
+
+	curf = pTopicFilter;
+	curn = pTopicName;
+	curn_end = curn + topicNameLen;
+
+	while(*curf && (curn < curn_end)) {
+		if(*curn == '/' && *curf != '/') {
+			break;
+		}
+		if(*curf != '+' && *curf != '#' && *curf != *curn) {
+			break;
+		}
+		if(*curf == '+') {
+			char *nextpos = curn + 1;
+			while(nextpos < curn_end && *nextpos != '/')
+				nextpos = ++curn + 1;
+		} else if(*curf == '#') {
+			curn = curn_end - 1;
+		}
+
+		curf++;
+		curn++;
+	};
+
+	return (curn == curn_end) && (*curf == '\0');
+}
+
+/* Scans as many handlers as a client configured with exactly handlerCount of them */
+static uint32_t linear_match(AWS_IoT_Client *pClient, uint32_t handlerCount, char *pTopicName, uint16_t topicNameLen) {
+	uint32_t itr, count = 0;
+	MessageHandlers *pHandler;
+
+	for(itr = 0; itr < handlerCount; ++itr) {
+		pHandler = &(pClient->clientData.messageHandlers[itr]);
+		if(NULL != pHandler->topicName
+		   && (((topicNameLen == pHandler->topicNameLen)
+				&& (strncmp(pTopicName, (char *) pHandler->topicName, topicNameLen) == 0))
+			   || linear_is_topic_matched((char *) pHandler->topicName, pTopicName, topicNameLen))) {
+			count++;
+		}
+	}
+
+	return count;
+}
+
+/* A gateway subscribes per device, with one wildcard filter for every eight devices */
+static void subscribe_devices(AWS_IoT_Client *pClient, uint32_t subscriptionCount) {
+	uint32_t itr;
+	MessageHandlers *pHandler;
+
+	for(itr = 0; itr < AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS; itr++) {
+		pClient->clientData.messageHandlers[itr].topicName = NULL;
+	}
+	aws_iot_mqtt_internal_topic_trie_init(pClient);
+
+	for(itr = 0; itr < subscriptionCount; itr++) {
+		if(7 == itr % 8) {
+			snprintf(topicFilters[itr], BENCHMARK_TOPIC_LEN, "gateway/+/device%u/cmd/#", itr / 8);
+		} else {
+			snprintf(topicFilters[itr], BENCHMARK_TOPIC_LEN, "gateway/site%u/device%u/telemetry", itr % 4, itr);
+		}
+		pHandler = &(pClient->clientData.messageHandlers[itr]);
+		pHandler->topicName = topicFilters[itr];
+		pHandler->topicNameLen = (uint16_t) strlen(topicFilters[itr]);
+		pHandler->pApplicationHandler = benchmark_handler;
+		if(SUCCESS != aws_iot_mqtt_internal_topic_trie_insert(pClient, itr)) {
+			printf("Subscription index full at %u subscriptions\n", itr);
+			pHandler->topicName = NULL;
+			break;
+		}
+	}
+}
+
+static double elapsed_ns(struct timespec *pStart, struct timespec *pEnd) {
+	return (double) (pEnd->tv_sec - pStart->tv_sec) * 1e9 + (double) (pEnd->tv_nsec - pStart->tv_nsec);
+}
+
+int main(void) {
+	uint16_t matchedHandlers[AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS];
+	char topicName[BENCHMARK_TOPIC_LEN];
+	uint16_t topicNameLen;
+	uint32_t subscriptionCount, itr, crossover = 0;
+	volatile uint32_t linearCount = 0, trieCount = 0;
+	double linearNs, trieNs;
+	struct timespec start, end;
+
+	/* Only the subscription tables are used, set up as aws_iot_mqtt_init does by default */
+	client.clientData.messageHandlers = client.clientData.embeddedMessageHandlers;
+	client.clientData.messageHandlerCount = AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS;
+	client.clientData.topicTrie = client.clientData.embeddedTopicTrie;
+	client.clientData.topicTrieNodeCount = AWS_IOT_MQTT_NUM_TOPIC_TRIE_NODES;
+
+	printf("%14s %14s %14s\n", "subscriptions", "scan ns/msg", "index ns/msg");
+
+	/* Every count up to 16, where the two are close, then doubling */
+	for(subscriptionCount = 1; subscriptionCount <= AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS;
+		subscriptionCount = (16 > subscriptionCount) ? subscriptionCount + 1 : subscriptionCount * 2) {
+		subscribe_devices(&client, subscriptionCount);
+
+		/* A message for the last device */
+		itr = subscriptionCount - 1;
+		snprintf(topicName, BENCHMARK_TOPIC_LEN, "gateway/site%u/device%u/telemetry", itr % 4, itr);
+		topicNameLen = (uint16_t) strlen(topicName);
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for(itr = 0; itr < BENCHMARK_ITERATIONS; itr++) {
+			linearCount = linear_match(&client, subscriptionCount, topicName, topicNameLen);
+		}
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		linearNs = elapsed_ns(&start, &end) / BENCHMARK_ITERATIONS;
+
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for(itr = 0; itr < BENCHMARK_ITERATIONS; itr++) {
+			trieCount = aws_iot_mqtt_internal_topic_trie_match(&client, topicName, topicNameLen, matchedHandlers);
+		}
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		trieNs = elapsed_ns(&start, &end) / BENCHMARK_ITERATIONS;
+
+		if(linearCount != trieCount) {
+			printf("Mismatch for %u subscriptions: scan found %u handlers, index found %u\n", subscriptionCount,
+				   linearCount, trieCount);
+			return 1;
+		}
+
+		printf("%14u %14.1f %14.1f\n", subscriptionCount, linearNs, trieNs);
+		if(0 == crossover && trieNs < linearNs) {
+			crossover = subscriptionCount;
+		}
+	}
+
+	if(0 != crossover) {
+		printf("Index is faster from %u subscriptions\n", crossover);
+	} else {
+		printf("Index is not faster up to %u subscriptions\n", AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS);
+	}
+
+	return 0;
+}
@@ -157,7 +157,7 @@ int aws_iot_mqtt_tests_basic_connectivity() {
 	char clientKey[PATH_MAX + 1];
 	char CurrentWD[PATH_MAX + 1];
 	char clientId[50];
-	IoT_Client_Init_Params initParams;
+	IoT_Client_Init_Params initParams = IoT_Client_Init_Params_initializer;
 	IoT_Client_Connect_Params connectParams;
 	int pubThreadReturn;
 	int yieldThreadReturn = 0;
@@ -35,12 +35,31 @@
 
 // MQTT PubSub
 #ifndef DISABLE_IOT_JOBS
-#define AWS_IOT_MQTT_RX_BUF_LEN 512 ///< Any message that comes into the device should be less than this buffer size. If a received message is bigger than this buffer size the message will be dropped.
+#define AWS_IOT_MQTT_RX_BUF_LEN 512 ///< Any message that comes into the device should be less than this buffer size. If a received message is bigger than this buffer size the message will be dropped, unless it is streamed to a subscription made with aws_iot_mqtt_subscribe_streaming.
 #else
 #define AWS_IOT_MQTT_RX_BUF_LEN 2048
 #endif
-#define AWS_IOT_MQTT_TX_BUF_LEN 512 ///< Any time a message is sent out through the MQTT layer. The message is copied into this buffer anytime a publish is done. This will also be used in the case of Thing Shadow
+#define AWS_IOT_MQTT_TX_BUF_LEN 512 ///< Any time a message is sent out through the MQTT layer. Control packets are serialized into this buffer. Publish payloads are sent from the caller buffer and are not limited by this size. This will also be used in the case of Thing Shadow
 #define AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS 5 ///< Maximum number of topic filters the MQTT client can handle at any given time. This should be increased appropriately when using Thing Shadow
+#define AWS_IOT_MQTT_MAX_INFLIGHT_PUBLISHES 10 ///< Maximum number of QoS1 messages published with aws_iot_mqtt_publish_async that can be awaiting a PUBACK at any given time
+#define AWS_IOT_MQTT_INFLIGHT_PACKET_LEN 128 ///< Largest QoS1 message kept by a persistent session to be sent again after reconnecting. Leave undefined to fail in-flight messages when the connection is lost
+#define AWS_IOT_MQTT_NUM_TOPIC_TRIE_NODES (AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS * 8) ///< Number of topic levels the subscription index can hold. A topic filter takes one node for every level it does not share with another subscription
+#define AWS_IOT_MQTT_ADAPTIVE_KEEP_ALIVE_MIN_SEC 1 ///< Idle time before the first PINGREQ when isKeepAliveAdaptive is set in the init parameters, doubled after every PINGRESP up to the keep alive interval
+#define AWS_IOT_MQTT_REACTOR_MAX_CLIENTS 4 ///< Maximum number of clients that can be registered with one reactor
+#define AWS_IOT_MQTT_ENABLE_OFFLINE_QUEUE ///< Keep messages published while reconnecting in the persistent region named by pOfflineQueuePath in the init parameters
+#define AWS_IOT_MQTT_OFFLINE_QUEUE_DRAIN_BATCH 2 ///< Number of queued messages published per drain step after reconnecting
+#define AWS_IOT_MQTT_OFFLINE_QUEUE_DRAIN_INTERVAL_MS 100 ///< Minimum time between two drain steps, in milliseconds
+#define AWS_IOT_MQTT_ENABLE_STATS ///< Count the traffic of each client and keep histograms of acknowledgment latencies and callback times, see aws_iot_mqtt_get_stats
+#ifdef _ENABLE_THREAD_SUPPORT_
+#define AWS_IOT_MQTT_OUTBOUND_QUEUE_SLOTS 4 ///< Slots of the lock-free queue small publishes are serialized into when another thread holds the write buffer, a power of two
+#endif
+
+// Asynchronous logger, used when ENABLE_IOT_ASYNC_LOG is defined with the log level flags
+#define AWS_IOT_LOG_RING_RECORDS 64 ///< Number of records in the ring of each logging thread, a power of two. Records are dropped when the ring is full
+#define AWS_IOT_LOG_RECORD_ARGS_LEN 96 ///< Space for the arguments of one log record, copied strings included
+#define AWS_IOT_LOG_LINE_LEN 256 ///< Longest formatted log line
+#define AWS_IOT_LOG_RATE_LIMIT 20 ///< Messages logged per second by one call site, 0 for no limit
+#define AWS_IOT_LOG_MAX_THREADS 4 ///< Number of threads owning a ring at once, further threads share one more ring
 
 // Shadow and Job common configs
 #define MAX_SIZE_OF_UNIQUE_CLIENT_ID_BYTES 80  ///< Maximum size of the Unique Client Id. For More info on the Client Id refer \ref response "Acknowledgments"
@@ -67,7 +86,7 @@
 #endif
 
 // Auto Reconnect specific config
-#define AWS_IOT_MQTT_MIN_RECONNECT_WAIT_INTERVAL 1000 ///< Minimum time before the First reconnect attempt is made as part of the exponential back-off algorithm
-#define AWS_IOT_MQTT_MAX_RECONNECT_WAIT_INTERVAL 128000 ///< Maximum time interval after which exponential back-off will stop attempting to reconnect.
+#define AWS_IOT_MQTT_MIN_RECONNECT_WAIT_INTERVAL 1000 ///< Shortest wait between reconnect attempts after the first one, which is made at once. Overridden by minReconnectWait_ms
+#define AWS_IOT_MQTT_MAX_RECONNECT_WAIT_INTERVAL 128000 ///< Longest wait between reconnect attempts. The exponential reconnect policy gives up past it. Overridden by maxReconnectWait_ms
 
 #endif /* IOT_TESTS_UNIT_CONFIG_H_ */
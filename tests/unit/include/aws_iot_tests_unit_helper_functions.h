@@ -55,12 +55,16 @@ void setTLSRxBufferForConnack(IoT_Client_Connect_Params *params, unsigned char s
 
 void setTLSRxBufferForPuback(void);
 
+void setTLSRxBufferForPubackWithId(uint16_t packetId);
+
 void setTLSRxBufferForSuback(char *topicName, size_t topicNameLen, QoS qos, IoT_Publish_Message_Params params);
 
 void setTLSRxBufferForDoubleSuback(char *topicName, size_t topicNameLen, QoS qos, IoT_Publish_Message_Params params);
 
 void setTLSRxBufferForSubFail(void);
 
+void setTLSRxBufferForMultiSuback(unsigned char *pReturnCodes, uint32_t count);
+
 void setTLSRxBufferWithMsgOnSubscribedTopic(char *topicName, size_t topicNameLen, QoS qos,
 											IoT_Publish_Message_Params params, char *pMsg);
 
@@ -74,6 +78,8 @@ void setTLSTxBufferForError(IoT_Error_t error);
 
 void setTLSRxBufferForConnackAndSuback(IoT_Client_Connect_Params *conParams, unsigned char sessionPresent,
 											  char *topicName, size_t topicNameLen, QoS qos);
+void setTLSRxBufferForConnackAndMultiSuback(IoT_Client_Connect_Params *conParams, unsigned char sessionPresent,
+											unsigned char *pReturnCodes, uint32_t count);
 
 unsigned char isLastTLSTxMessagePuback(void);
 
@@ -0,0 +1,38 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file aws_iot_tests_unit_client_stats.cpp
+ * @brief IoT Client Unit Testing - Client Statistics Tests
+ */
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness_c.h>
+
+TEST_GROUP_C(ClientStatsTests){
+	TEST_GROUP_C_SETUP_WRAPPER(ClientStatsTests)
+	TEST_GROUP_C_TEARDOWN_WRAPPER(ClientStatsTests)
+};
+
+/* T:1 - Packets and bytes are counted per packet type in both directions */
+TEST_GROUP_C_WRAPPER(ClientStatsTests, PacketsCountedPerType)
+/* T:2 - SUBACK and PUBACK latencies and callback times are recorded in their histograms */
+TEST_GROUP_C_WRAPPER(ClientStatsTests, LatencyHistograms)
+/* T:3 - A message larger than the incoming buffer is counted as dropped */
+TEST_GROUP_C_WRAPPER(ClientStatsTests, OversizedMessageDropped)
+/* T:4 - Get stats with NULL parameters */
+TEST_GROUP_C_WRAPPER(ClientStatsTests, NullParams)
+/* T:5 - Yield counts its wall time and the part of it not spent waiting for the network */
+TEST_GROUP_C_WRAPPER(ClientStatsTests, YieldDutyCycle)
@@ -0,0 +1,252 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file aws_iot_tests_unit_client_stats_helper.c
+ * @brief IoT Client Unit Testing - Client Statistics Tests Helper
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <CppUTest/TestHarness_c.h>
+
+#include "aws_iot_tests_unit_helper_functions.h"
+#include "aws_iot_mqtt_client_common_internal.h"
+#include "aws_iot_tests_unit_mock_tls_params.h"
+#include "aws_iot_log.h"
+
+#define CLIENT_STATS_TEST_CALLBACK_US 3000
+
+static IoT_Client_Init_Params initParams;
+static IoT_Client_Connect_Params connectParams;
+static IoT_Publish_Message_Params testPubMsgParams;
+static AWS_IoT_Client iotClient;
+static IoT_Client_Stats stats;
+
+static char subTopic[10] = "sdk/Test";
+static uint16_t subTopicLen = 8;
+static char largeMessage[AWS_IOT_MQTT_RX_BUF_LEN + 1];
+static uint32_t callbackCount;
+
+static void iot_tests_unit_client_stats_handler(AWS_IoT_Client *pClient, char *pTopicName, uint16_t topicNameLen,
+												IoT_Publish_Message_Params *pParams, void *pClientData) {
+	IOT_UNUSED(pClient);
+	IOT_UNUSED(pTopicName);
+	IOT_UNUSED(topicNameLen);
+	IOT_UNUSED(pParams);
+	IOT_UNUSED(pClientData);
+	callbackCount++;
+	usleep(CLIENT_STATS_TEST_CALLBACK_US);
+}
+
+static void iot_tests_unit_client_stats_connect_and_subscribe(void) {
+	IoT_Error_t rc;
+
+	setTLSRxBufferForConnack(&connectParams, 0, 0);
+	rc = aws_iot_mqtt_connect(&iotClient, &connectParams);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	setTLSRxBufferForSuback(subTopic, subTopicLen, QOS0, testPubMsgParams);
+	rc = aws_iot_mqtt_subscribe(&iotClient, subTopic, subTopicLen, QOS0, iot_tests_unit_client_stats_handler, NULL);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+}
+
+static void iot_tests_unit_client_stats_publish(void) {
+	IoT_Error_t rc;
+	IoT_Publish_Message_Params pubParams;
+
+	pubParams.qos = QOS1;
+	pubParams.isRetained = 0;
+	pubParams.payload = (void *) "stats";
+	pubParams.payloadLen = 5;
+
+	setTLSRxBufferForPuback();
+	rc = aws_iot_mqtt_publish(&iotClient, subTopic, subTopicLen, &pubParams);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+}
+
+static uint32_t iot_tests_unit_client_stats_bucket_total(IoT_Latency_Histogram *pHistogram) {
+	uint32_t itr, total = 0;
+
+	for(itr = 0; itr < AWS_IOT_MQTT_STATS_HISTOGRAM_BUCKETS; itr++) {
+		total += pHistogram->buckets[itr];
+	}
+
+	return total;
+}
+
+TEST_GROUP_C_SETUP(ClientStatsTests) {
+	IoT_Error_t rc;
+
+	ResetTLSBuffer();
+	InitMQTTParamsSetup(&initParams, AWS_IOT_MQTT_HOST, AWS_IOT_MQTT_PORT, false, NULL);
+	rc = aws_iot_mqtt_init(&iotClient, &initParams);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	ConnectMQTTParamsSetup(&connectParams, AWS_IOT_MQTT_CLIENT_ID, (uint16_t) strlen(AWS_IOT_MQTT_CLIENT_ID));
+	testPubMsgParams.qos = QOS1;
+	callbackCount = 0;
+	memset(&stats, 0xFF, sizeof(stats));
+}
+
+TEST_GROUP_C_TEARDOWN(ClientStatsTests) {
+}
+
+/* T:1 - Packets and bytes are counted per packet type in both directions */
+TEST_C(ClientStatsTests, PacketsCountedPerType) {
+	IoT_Error_t rc;
+
+	IOT_DEBUG("-->Running Client Stats Tests - T:1 - Packets counted per type \n");
+
+	rc = aws_iot_mqtt_get_stats(&iotClient, &stats);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(0, stats.packetsOut[CONNECT]);
+	CHECK_EQUAL_C_INT(0, stats.pubackLatency.count);
+
+	iot_tests_unit_client_stats_connect_and_subscribe();
+	iot_tests_unit_client_stats_publish();
+
+	setTLSRxBufferWithMsgOnSubscribedTopic(subTopic, subTopicLen, QOS1, testPubMsgParams, "hello");
+	rc = aws_iot_mqtt_yield(&iotClient, 100);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(1, callbackCount);
+
+	rc = aws_iot_mqtt_get_stats(&iotClient, &stats);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	CHECK_EQUAL_C_INT(1, stats.packetsOut[CONNECT]);
+	CHECK_C(0 < stats.bytesOut[CONNECT]);
+	CHECK_EQUAL_C_INT(1, stats.packetsIn[CONNACK]);
+	CHECK_EQUAL_C_INT(4, stats.bytesIn[CONNACK]);
+	CHECK_EQUAL_C_INT(1, stats.packetsOut[SUBSCRIBE]);
+	/* Header, packet identifier, topic filter and requested QoS */
+	CHECK_EQUAL_C_INT(2 + 2 + 2 + subTopicLen + 1, stats.bytesOut[SUBSCRIBE]);
+	CHECK_EQUAL_C_INT(1, stats.packetsIn[SUBACK]);
+	CHECK_EQUAL_C_INT(5, stats.bytesIn[SUBACK]);
+
+	/* Header, topic, packet identifier and a payload sent from outside of the write buffer */
+	CHECK_EQUAL_C_INT(1, stats.packetsOut[PUBLISH]);
+	CHECK_EQUAL_C_INT(2 + 2 + subTopicLen + 2 + 5, stats.bytesOut[PUBLISH]);
+	CHECK_EQUAL_C_INT(1, stats.packetsIn[PUBACK]);
+	CHECK_EQUAL_C_INT(4, stats.bytesIn[PUBACK]);
+
+	/* The mock message includes the terminating NULL byte */
+	CHECK_EQUAL_C_INT(1, stats.packetsIn[PUBLISH]);
+	CHECK_EQUAL_C_INT(2 + 2 + subTopicLen + 2 + 6, stats.bytesIn[PUBLISH]);
+	CHECK_EQUAL_C_INT(1, stats.packetsOut[PUBACK]);
+	CHECK_EQUAL_C_INT(4, stats.bytesOut[PUBACK]);
+
+	CHECK_EQUAL_C_INT(0, stats.packetsOut[PINGREQ]);
+	CHECK_EQUAL_C_INT(0, stats.droppedMessages);
+
+	IOT_DEBUG("-->Success - T:1 - Packets counted per type \n");
+}
+
+/* T:2 - SUBACK and PUBACK latencies and callback times are recorded in their histograms */
+TEST_C(ClientStatsTests, LatencyHistograms) {
+	IoT_Error_t rc;
+	uint32_t bucket = 0;
+
+	IOT_DEBUG("-->Running Client Stats Tests - T:2 - Latency histograms \n");
+
+	iot_tests_unit_client_stats_connect_and_subscribe();
+	iot_tests_unit_client_stats_publish();
+	iot_tests_unit_client_stats_publish();
+
+	setTLSRxBufferWithMsgOnSubscribedTopic(subTopic, subTopicLen, QOS1, testPubMsgParams, "hello");
+	rc = aws_iot_mqtt_yield(&iotClient, 100);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	rc = aws_iot_mqtt_get_stats(&iotClient, &stats);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	CHECK_EQUAL_C_INT(1, stats.subackLatency.count);
+	CHECK_EQUAL_C_INT(1, iot_tests_unit_client_stats_bucket_total(&stats.subackLatency));
+	CHECK_EQUAL_C_INT(2, stats.pubackLatency.count);
+	CHECK_EQUAL_C_INT(2, iot_tests_unit_client_stats_bucket_total(&stats.pubackLatency));
+	CHECK_C(stats.pubackLatency.maxUs <= stats.pubackLatency.totalUs);
+
+	/* The handler sleeps, its sample lands in the bucket of the number of bits of the duration */
+	CHECK_EQUAL_C_INT(1, stats.callbackTime.count);
+	CHECK_C(CLIENT_STATS_TEST_CALLBACK_US <= stats.callbackTime.maxUs);
+	CHECK_EQUAL_C_INT(stats.callbackTime.maxUs, stats.callbackTime.totalUs);
+	while(0 != (stats.callbackTime.maxUs >> bucket)) {
+		bucket++;
+	}
+	CHECK_EQUAL_C_INT(1, stats.callbackTime.buckets[bucket]);
+
+	IOT_DEBUG("-->Success - T:2 - Latency histograms \n");
+}
+
+/* T:3 - A message larger than the incoming buffer is counted as dropped */
+TEST_C(ClientStatsTests, OversizedMessageDropped) {
+	IoT_Error_t rc;
+
+	IOT_DEBUG("-->Running Client Stats Tests - T:3 - Oversized message dropped \n");
+
+	memset(largeMessage, 'x', AWS_IOT_MQTT_RX_BUF_LEN);
+	largeMessage[AWS_IOT_MQTT_RX_BUF_LEN] = '\0';
+
+	iot_tests_unit_client_stats_connect_and_subscribe();
+	setTLSRxBufferWithMsgOnSubscribedTopic(subTopic, subTopicLen, QOS1, testPubMsgParams, largeMessage);
+	(void) aws_iot_mqtt_yield(&iotClient, 100);
+	CHECK_EQUAL_C_INT(0, callbackCount);
+
+	rc = aws_iot_mqtt_get_stats(&iotClient, &stats);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(1, stats.droppedMessages);
+	CHECK_EQUAL_C_INT(1, stats.packetsIn[PUBLISH]);
+	CHECK_EQUAL_C_INT(0, stats.packetsOut[PUBACK]);
+	CHECK_EQUAL_C_INT(0, stats.callbackTime.count);
+
+	IOT_DEBUG("-->Success - T:3 - Oversized message dropped \n");
+}
+
+/* T:4 - Get stats with NULL parameters */
+TEST_C(ClientStatsTests, NullParams) {
+	IoT_Error_t rc;
+
+	IOT_DEBUG("-->Running Client Stats Tests - T:4 - Get stats with NULL parameters \n");
+
+	rc = aws_iot_mqtt_get_stats(NULL, &stats);
+	CHECK_EQUAL_C_INT(NULL_VALUE_ERROR, rc);
+	rc = aws_iot_mqtt_get_stats(&iotClient, NULL);
+	CHECK_EQUAL_C_INT(NULL_VALUE_ERROR, rc);
+
+	IOT_DEBUG("-->Success - T:4 - Get stats with NULL parameters \n");
+}
+
+/* T:5 - Yield counts its wall time and the part of it not spent waiting for the network */
+TEST_C(ClientStatsTests, YieldDutyCycle) {
+	IoT_Error_t rc;
+
+	IOT_DEBUG("-->Running Client Stats Tests - T:5 - Yield duty cycle \n");
+
+	iot_tests_unit_client_stats_connect_and_subscribe();
+	setTLSRxBufferWithMsgOnSubscribedTopic(subTopic, subTopicLen, QOS1, testPubMsgParams, "hello");
+	rc = aws_iot_mqtt_yield(&iotClient, 100);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(1, callbackCount);
+
+	rc = aws_iot_mqtt_get_stats(&iotClient, &stats);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(1, stats.yieldCount);
+	CHECK_C(100000 <= stats.yieldWallUs);
+	/* The handler runs within the busy time, the rest of the timeout waits for the network */
+	CHECK_C(CLIENT_STATS_TEST_CALLBACK_US <= stats.yieldBusyUs);
+	CHECK_C(stats.yieldBusyUs < stats.yieldWallUs);
+
+	IOT_DEBUG("-->Success - T:5 - Yield duty cycle \n");
+}
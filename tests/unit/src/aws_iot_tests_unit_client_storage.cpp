@@ -0,0 +1,40 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file aws_iot_tests_unit_client_storage.cpp
+ * @brief IoT Client Unit Testing - Client Storage Tests
+ */
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness_c.h>
+
+TEST_GROUP_C(ClientStorageTests){
+	TEST_GROUP_C_SETUP_WRAPPER(ClientStorageTests)
+	TEST_GROUP_C_TEARDOWN_WRAPPER(ClientStorageTests)
+};
+
+/* S:1 - Clients carved from one arena, each with its own buffer sizes and handler count */
+TEST_GROUP_C_WRAPPER(ClientStorageTests, ArenaSizesPerClient)
+/* S:2 - A message larger than AWS_IOT_MQTT_RX_BUF_LEN is received by a client with a larger buffer only */
+TEST_GROUP_C_WRAPPER(ClientStorageTests, ReceiveBufferPerClient)
+/* S:3 - Initialization fails without taking anything when the arena is too small */
+TEST_GROUP_C_WRAPPER(ClientStorageTests, ArenaTooSmall)
+/* S:4 - Without an allocator the embedded arrays bound the sizes */
+TEST_GROUP_C_WRAPPER(ClientStorageTests, EmbeddedStorageBounds)
+/* S:5 - The storage block is given back to the allocator when the client is freed */
+TEST_GROUP_C_WRAPPER(ClientStorageTests, ReleasedOnFree)
+/* S:6 - The in-flight publishes and the outbound queue slots are sized per client */
+TEST_GROUP_C_WRAPPER(ClientStorageTests, InflightAndQueueSizesPerClient)
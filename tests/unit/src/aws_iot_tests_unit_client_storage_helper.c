@@ -0,0 +1,306 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file aws_iot_tests_unit_client_storage_helper.c
+ * @brief IoT Client Unit Testing - Client Storage Tests Helper
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <CppUTest/TestHarness_c.h>
+
+#include "aws_iot_tests_unit_helper_functions.h"
+#include "aws_iot_tests_unit_mock_tls_params.h"
+#include "aws_iot_log.h"
+
+#define CLIENT_STORAGE_TEST_ARENA_SIZE 16384
+/* A telemetry client and a client receiving messages larger than AWS_IOT_MQTT_RX_BUF_LEN */
+#define CLIENT_STORAGE_TEST_SMALL_BUF_LEN 256
+#define CLIENT_STORAGE_TEST_LARGE_BUF_LEN 2048
+#define CLIENT_STORAGE_TEST_MSG_LEN 1500
+
+static IoT_Client_Init_Params initParams;
+static IoT_Client_Connect_Params connectParams;
+static IoT_Publish_Message_Params testPubMsgParams;
+static AWS_IoT_Client telemetryClient;
+static AWS_IoT_Client jobClient;
+
+static unsigned char arenaRegion[CLIENT_STORAGE_TEST_ARENA_SIZE];
+static IoT_Client_Arena arena;
+static IoT_Client_Allocator arenaAllocator;
+
+static char subTopic[10] = "sdk/Test";
+static uint16_t subTopicLen = 8;
+static char largeMessage[CLIENT_STORAGE_TEST_MSG_LEN + 1];
+static size_t receivedPayloadLen;
+
+static uint32_t allocateCount;
+static uint32_t releaseCount;
+
+static void *iot_tests_unit_client_storage_allocate(void *pContext, size_t size) {
+	IOT_UNUSED(pContext);
+	allocateCount++;
+	return malloc(size);
+}
+
+static void iot_tests_unit_client_storage_release(void *pContext, void *pBlock) {
+	IOT_UNUSED(pContext);
+	releaseCount++;
+	free(pBlock);
+}
+
+static void iot_tests_unit_client_storage_handler(AWS_IoT_Client *pClient, char *pTopicName, uint16_t topicNameLen,
+												  IoT_Publish_Message_Params *pParams, void *pClientData) {
+	IOT_UNUSED(pClient);
+	IOT_UNUSED(pTopicName);
+	IOT_UNUSED(topicNameLen);
+	IOT_UNUSED(pClientData);
+	receivedPayloadLen = pParams->payloadLen;
+}
+
+static void iot_tests_unit_client_storage_params(size_t bufLen, uint16_t handlerCount, IoT_Client_Allocator *pAllocator) {
+	InitMQTTParamsSetup(&initParams, AWS_IOT_MQTT_HOST, AWS_IOT_MQTT_PORT, false, NULL);
+	initParams.txBufLen = bufLen;
+	initParams.rxBufLen = bufLen;
+	initParams.subscribeHandlerCount = handlerCount;
+	initParams.inflightPublishCount = 0;
+	initParams.outboundQueueSlotCount = 0;
+	initParams.pStorageAllocator = pAllocator;
+}
+
+static IoT_Error_t iot_tests_unit_client_storage_init(AWS_IoT_Client *pClient, size_t bufLen, uint16_t handlerCount,
+													  IoT_Client_Allocator *pAllocator) {
+	iot_tests_unit_client_storage_params(bufLen, handlerCount, pAllocator);
+	return aws_iot_mqtt_init(pClient, &initParams);
+}
+
+static void iot_tests_unit_client_storage_connect_and_subscribe(AWS_IoT_Client *pClient) {
+	IoT_Error_t rc;
+
+	ResetTLSBuffer();
+	setTLSRxBufferForConnack(&connectParams, 0, 0);
+	rc = aws_iot_mqtt_connect(pClient, &connectParams);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	setTLSRxBufferForSuback(subTopic, subTopicLen, QOS0, testPubMsgParams);
+	rc = aws_iot_mqtt_subscribe(pClient, subTopic, subTopicLen, QOS0, iot_tests_unit_client_storage_handler, NULL);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+}
+
+TEST_GROUP_C_SETUP(ClientStorageTests) {
+	ResetTLSBuffer();
+	aws_iot_mqtt_arena_init(&arena, arenaRegion, sizeof(arenaRegion));
+	arenaAllocator.allocate = aws_iot_mqtt_arena_allocate;
+	arenaAllocator.release = NULL;
+	arenaAllocator.pContext = &arena;
+	ConnectMQTTParamsSetup(&connectParams, AWS_IOT_MQTT_CLIENT_ID, (uint16_t) strlen(AWS_IOT_MQTT_CLIENT_ID));
+	testPubMsgParams.qos = QOS1;
+	receivedPayloadLen = 0;
+	allocateCount = 0;
+	releaseCount = 0;
+}
+
+TEST_GROUP_C_TEARDOWN(ClientStorageTests) {
+}
+
+/* S:1 - Clients carved from one arena, each with its own buffer sizes and handler count */
+TEST_C(ClientStorageTests, ArenaSizesPerClient) {
+	IoT_Error_t rc;
+	size_t telemetrySize;
+	unsigned char *pTelemetryStorage;
+
+	IOT_DEBUG("-->Running Client Storage Tests - S:1 - Arena sizes per client \n");
+
+	rc = iot_tests_unit_client_storage_init(&telemetryClient, CLIENT_STORAGE_TEST_SMALL_BUF_LEN, 1, &arenaAllocator);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	telemetrySize = aws_iot_mqtt_get_storage_size(&initParams);
+	rc = iot_tests_unit_client_storage_init(&jobClient, CLIENT_STORAGE_TEST_LARGE_BUF_LEN, 0, &arenaAllocator);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	pTelemetryStorage = (unsigned char *) telemetryClient.clientData.pStorage;
+	CHECK_C(pTelemetryStorage >= arenaRegion && pTelemetryStorage + telemetrySize <= arenaRegion + arena.used);
+	CHECK_C((unsigned char *) jobClient.clientData.pStorage >= pTelemetryStorage + telemetrySize);
+	CHECK_EQUAL_C_INT(CLIENT_STORAGE_TEST_SMALL_BUF_LEN, telemetryClient.clientData.writeBufSize);
+	CHECK_EQUAL_C_INT(CLIENT_STORAGE_TEST_SMALL_BUF_LEN, telemetryClient.clientData.readBufSize);
+	CHECK_EQUAL_C_INT(1, telemetryClient.clientData.messageHandlerCount);
+	CHECK_EQUAL_C_INT(CLIENT_STORAGE_TEST_LARGE_BUF_LEN, jobClient.clientData.readBufSize);
+	CHECK_EQUAL_C_INT(AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS, jobClient.clientData.messageHandlerCount);
+
+	/* A single handler holds a single subscription */
+	iot_tests_unit_client_storage_connect_and_subscribe(&telemetryClient);
+	setTLSRxBufferForSuback("sdk/Other", 9, QOS0, testPubMsgParams);
+	rc = aws_iot_mqtt_subscribe(&telemetryClient, "sdk/Other", 9, QOS0, iot_tests_unit_client_storage_handler, NULL);
+	CHECK_EQUAL_C_INT(MQTT_MAX_SUBSCRIPTIONS_REACHED_ERROR, rc);
+
+	IOT_DEBUG("-->Success - S:1 - Arena sizes per client \n");
+}
+
+/* S:2 - A message larger than AWS_IOT_MQTT_RX_BUF_LEN is received by a client with a larger buffer only */
+TEST_C(ClientStorageTests, ReceiveBufferPerClient) {
+	IoT_Error_t rc;
+
+	IOT_DEBUG("-->Running Client Storage Tests - S:2 - Receive buffer per client \n");
+
+	memset(largeMessage, 'x', CLIENT_STORAGE_TEST_MSG_LEN);
+	largeMessage[CLIENT_STORAGE_TEST_MSG_LEN] = '\0';
+
+	rc = iot_tests_unit_client_storage_init(&jobClient, CLIENT_STORAGE_TEST_LARGE_BUF_LEN, 0, &arenaAllocator);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	iot_tests_unit_client_storage_connect_and_subscribe(&jobClient);
+	setTLSRxBufferWithMsgOnSubscribedTopic(subTopic, subTopicLen, QOS1, testPubMsgParams, largeMessage);
+	rc = aws_iot_mqtt_yield(&jobClient, 100);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	/* The mock message includes the terminating NULL byte */
+	CHECK_EQUAL_C_INT(CLIENT_STORAGE_TEST_MSG_LEN + 1, receivedPayloadLen);
+
+	receivedPayloadLen = 0;
+	rc = iot_tests_unit_client_storage_init(&telemetryClient, CLIENT_STORAGE_TEST_SMALL_BUF_LEN, 0, &arenaAllocator);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	iot_tests_unit_client_storage_connect_and_subscribe(&telemetryClient);
+	setTLSRxBufferWithMsgOnSubscribedTopic(subTopic, subTopicLen, QOS1, testPubMsgParams, largeMessage);
+	(void) aws_iot_mqtt_yield(&telemetryClient, 100);
+	CHECK_EQUAL_C_INT(0, receivedPayloadLen);
+
+	IOT_DEBUG("-->Success - S:2 - Receive buffer per client \n");
+}
+
+/* S:3 - Initialization fails without taking anything when the arena is too small */
+TEST_C(ClientStorageTests, ArenaTooSmall) {
+	IoT_Error_t rc;
+
+	IOT_DEBUG("-->Running Client Storage Tests - S:3 - Arena too small \n");
+
+	iot_tests_unit_client_storage_params(CLIENT_STORAGE_TEST_SMALL_BUF_LEN, 0, &arenaAllocator);
+	aws_iot_mqtt_arena_init(&arena, arenaRegion, aws_iot_mqtt_get_storage_size(&initParams) - 1);
+	rc = aws_iot_mqtt_init(&telemetryClient, &initParams);
+	CHECK_EQUAL_C_INT(MQTT_STORAGE_ALLOCATION_ERROR, rc);
+	CHECK_EQUAL_C_INT(0, arena.used);
+
+	IOT_DEBUG("-->Success - S:3 - Arena too small \n");
+}
+
+/* S:4 - Without an allocator the embedded arrays bound the sizes */
+TEST_C(ClientStorageTests, EmbeddedStorageBounds) {
+	IoT_Error_t rc;
+
+	IOT_DEBUG("-->Running Client Storage Tests - S:4 - Embedded storage bounds \n");
+
+	rc = iot_tests_unit_client_storage_init(&telemetryClient, AWS_IOT_MQTT_RX_BUF_LEN + 1, 0, NULL);
+	CHECK_EQUAL_C_INT(MAX_SIZE_ERROR, rc);
+	rc = iot_tests_unit_client_storage_init(&telemetryClient, 0, AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS + 1, NULL);
+	CHECK_EQUAL_C_INT(MAX_SIZE_ERROR, rc);
+	rc = iot_tests_unit_client_storage_init(&telemetryClient, 0, AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS + 1,
+											&arenaAllocator);
+	CHECK_EQUAL_C_INT(MAX_SIZE_ERROR, rc);
+
+	rc = iot_tests_unit_client_storage_init(&telemetryClient, CLIENT_STORAGE_TEST_SMALL_BUF_LEN, 2, NULL);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_C(NULL == telemetryClient.clientData.pStorage);
+	CHECK_C(telemetryClient.clientData.embeddedWriteBuf == telemetryClient.clientData.writeBuf);
+	CHECK_EQUAL_C_INT(CLIENT_STORAGE_TEST_SMALL_BUF_LEN, telemetryClient.clientData.writeBufSize);
+	CHECK_EQUAL_C_INT(2, telemetryClient.clientData.messageHandlerCount);
+
+	IOT_DEBUG("-->Success - S:4 - Embedded storage bounds \n");
+}
+
+/* S:5 - The storage block is given back to the allocator when the client is freed */
+TEST_C(ClientStorageTests, ReleasedOnFree) {
+	IoT_Error_t rc;
+	IoT_Client_Allocator heapAllocator;
+
+	IOT_DEBUG("-->Running Client Storage Tests - S:5 - Released on free \n");
+
+	heapAllocator.allocate = iot_tests_unit_client_storage_allocate;
+	heapAllocator.release = iot_tests_unit_client_storage_release;
+	heapAllocator.pContext = NULL;
+
+	rc = iot_tests_unit_client_storage_init(&jobClient, 0, 0, &heapAllocator);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(1, allocateCount);
+	iot_tests_unit_client_storage_connect_and_subscribe(&jobClient);
+
+	rc = aws_iot_mqtt_free(&jobClient);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(1, releaseCount);
+	CHECK_C(NULL == jobClient.clientData.pStorage);
+
+	IOT_DEBUG("-->Success - S:5 - Released on free \n");
+}
+
+/* S:6 - The in-flight publishes and the outbound queue slots are sized per client */
+TEST_C(ClientStorageTests, InflightAndQueueSizesPerClient) {
+	IoT_Error_t rc;
+	IoT_Client_Allocator heapAllocator;
+	IoT_Publish_Message_Params pubParams;
+	size_t defaultSize;
+	uint16_t itr;
+
+	IOT_DEBUG("-->Running Client Storage Tests - S:6 - In-flight and queue sizes per client \n");
+
+	heapAllocator.allocate = iot_tests_unit_client_storage_allocate;
+	heapAllocator.release = iot_tests_unit_client_storage_release;
+	heapAllocator.pContext = NULL;
+
+	/* Without an allocator the embedded arrays bound the counts */
+	iot_tests_unit_client_storage_params(0, 0, NULL);
+	initParams.inflightPublishCount = AWS_IOT_MQTT_MAX_INFLIGHT_PUBLISHES + 1;
+	rc = aws_iot_mqtt_init(&telemetryClient, &initParams);
+	CHECK_EQUAL_C_INT(MAX_SIZE_ERROR, rc);
+#ifdef AWS_IOT_MQTT_OUTBOUND_QUEUE_SLOTS
+	iot_tests_unit_client_storage_params(0, 0, &heapAllocator);
+	initParams.outboundQueueSlotCount = 3;
+	CHECK_EQUAL_C_INT(0, aws_iot_mqtt_get_storage_size(&initParams));
+	rc = aws_iot_mqtt_init(&telemetryClient, &initParams);
+	CHECK_EQUAL_C_INT(MAX_SIZE_ERROR, rc);
+	CHECK_EQUAL_C_INT(0, allocateCount);
+#endif
+
+	iot_tests_unit_client_storage_params(0, 0, &heapAllocator);
+	defaultSize = aws_iot_mqtt_get_storage_size(&initParams);
+	initParams.inflightPublishCount = 2 * AWS_IOT_MQTT_MAX_INFLIGHT_PUBLISHES;
+#ifdef AWS_IOT_MQTT_OUTBOUND_QUEUE_SLOTS
+	initParams.outboundQueueSlotCount = 2 * AWS_IOT_MQTT_OUTBOUND_QUEUE_SLOTS;
+#endif
+	CHECK_C(aws_iot_mqtt_get_storage_size(&initParams) > defaultSize);
+	rc = aws_iot_mqtt_init(&jobClient, &initParams);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(2 * AWS_IOT_MQTT_MAX_INFLIGHT_PUBLISHES, jobClient.clientData.inflightPublishCount);
+	CHECK_C((unsigned char *) jobClient.clientData.inflightPublishes >= (unsigned char *) jobClient.clientData.pStorage);
+#ifdef AWS_IOT_MQTT_OUTBOUND_QUEUE_SLOTS
+	CHECK_EQUAL_C_INT(2 * AWS_IOT_MQTT_OUTBOUND_QUEUE_SLOTS, jobClient.clientData.outboundQueue.slotCount);
+#endif
+
+	/* Twice the configured number of QoS1 publishes await their PUBACK */
+	iot_tests_unit_client_storage_connect_and_subscribe(&jobClient);
+	memset(&pubParams, 0, sizeof(pubParams));
+	pubParams.qos = QOS1;
+	pubParams.payload = (void *) "msg";
+	pubParams.payloadLen = 3;
+	for(itr = 0; itr < 2 * AWS_IOT_MQTT_MAX_INFLIGHT_PUBLISHES; itr++) {
+		rc = aws_iot_mqtt_publish_async(&jobClient, subTopic, subTopicLen, &pubParams, NULL, NULL);
+		CHECK_EQUAL_C_INT(SUCCESS, rc);
+	}
+	CHECK_EQUAL_C_INT(2 * AWS_IOT_MQTT_MAX_INFLIGHT_PUBLISHES, aws_iot_mqtt_get_inflight_publish_count(&jobClient));
+	rc = aws_iot_mqtt_publish_async(&jobClient, subTopic, subTopicLen, &pubParams, NULL, NULL);
+	CHECK_EQUAL_C_INT(MQTT_MAX_INFLIGHT_PUBLISHES_REACHED_ERROR, rc);
+
+	rc = aws_iot_mqtt_free(&jobClient);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(0, jobClient.clientData.inflightPublishCount);
+
+	IOT_DEBUG("-->Success - S:6 - In-flight and queue sizes per client \n");
+}
@@ -25,6 +25,7 @@
 #include "aws_iot_mqtt_client_interface.h"
 #include "aws_iot_log.h"
 #include "aws_iot_tests_unit_helper_functions.h"
+#include "aws_iot_tests_unit_mock_tls_params.h"
 
 static IoT_Client_Init_Params initParams;
 static IoT_Client_Connect_Params connectParams;
@@ -52,6 +53,32 @@ static void iot_tests_unit_common_subscribe_callback_handler(AWS_IoT_Client *pCl
 	}
 }
 
+#define STREAMED_MESSAGE_LEN 2000
+
+static char streamBuffer[STREAMED_MESSAGE_LEN + 1];
+static size_t streamNextOffset;
+static size_t streamTotalLen;
+static uint32_t streamFragmentCount;
+
+static void iot_tests_unit_common_fragment_callback_handler(AWS_IoT_Client *pClient, char *topicName,
+															uint16_t topicNameLen, IoT_Publish_Message_Params *params,
+															size_t payloadOffset, size_t payloadTotalLen, void *pData) {
+	IOT_UNUSED(pClient);
+	IOT_UNUSED(topicName);
+	IOT_UNUSED(topicNameLen);
+	IOT_UNUSED(pData);
+
+	/* Fragments arrive in order and are never larger than the message */
+	if(payloadOffset != streamNextOffset || payloadOffset + params->payloadLen > STREAMED_MESSAGE_LEN) {
+		return;
+	}
+
+	memcpy(streamBuffer + payloadOffset, params->payload, params->payloadLen);
+	streamNextOffset += params->payloadLen;
+	streamTotalLen = payloadTotalLen;
+	streamFragmentCount++;
+}
+
 TEST_GROUP_C_SETUP(CommonTests) {
 	ResetTLSBuffer();
 	InitMQTTParamsSetup(&initParams, AWS_IOT_MQTT_HOST, AWS_IOT_MQTT_PORT, false, NULL);
@@ -184,3 +211,95 @@ TEST_C(CommonTests, BigMQTTRxMessageReadNextMessage) {
 	CHECK_EQUAL_C_INT(rc, SUCCESS);
 	CHECK_EQUAL_C_STRING("XXX", cbBuffer);
 }
+
+/**
+ *
+ * A big message on a streaming subscription is delivered in fragments instead of being dropped.
+ */
+TEST_C(CommonTests, BigMQTTRxMessageStreamed) {
+	uint32_t i = 0;
+	IoT_Error_t rc = FAILURE;
+	char expectedCallbackString[STREAMED_MESSAGE_LEN];
+
+	IOT_DEBUG("\n-->Running CommonTests - Stream Large Incoming Message \n");
+
+	setTLSRxBufferForSuback("limitTest/topic1", 16, QOS1, testPubMsgParams);
+	rc = aws_iot_mqtt_subscribe_streaming(&iotClient, "limitTest/topic1", 16, QOS1,
+										  iot_tests_unit_common_fragment_callback_handler, NULL);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	for(i = 0; i < STREAMED_MESSAGE_LEN - 1; i++) {
+		expectedCallbackString[i] = (char) ('A' + (i % 26));
+	}
+	expectedCallbackString[i] = '\0';
+
+	streamNextOffset = 0;
+	streamTotalLen = 0;
+	streamFragmentCount = 0;
+	memset(streamBuffer, 0, sizeof(streamBuffer));
+
+	testPubMsgParams.qos = QOS1;
+	setTLSRxBufferWithMsgOnSubscribedTopic("limitTest/topic1", 16, QOS1, testPubMsgParams, expectedCallbackString);
+	rc = aws_iot_mqtt_yield(&iotClient, 1000);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	/* The payload includes the terminating null character */
+	CHECK_EQUAL_C_INT(STREAMED_MESSAGE_LEN, streamTotalLen);
+	CHECK_EQUAL_C_INT(STREAMED_MESSAGE_LEN, streamNextOffset);
+	CHECK_C(STREAMED_MESSAGE_LEN / AWS_IOT_MQTT_RX_BUF_LEN <= streamFragmentCount);
+	CHECK_EQUAL_C_STRING(expectedCallbackString, streamBuffer);
+	CHECK_EQUAL_C_INT(1, isLastTLSTxMessagePuback());
+
+	/* The next message is read normally and fits in a single fragment */
+	streamNextOffset = 0;
+	streamFragmentCount = 0;
+	expectedCallbackString[3] = '\0';
+	ResetTLSBuffer();
+	setTLSRxBufferWithMsgOnSubscribedTopic("limitTest/topic1", 16, QOS1, testPubMsgParams, expectedCallbackString);
+	rc = aws_iot_mqtt_yield(&iotClient, 1000);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(1, streamFragmentCount);
+	CHECK_EQUAL_C_INT(4, streamTotalLen);
+	CHECK_EQUAL_C_STRING("ABC", streamBuffer);
+}
+
+/**
+ *
+ * A streamed message whose payload stops arriving closes the connection, the rest of it
+ * would otherwise be read as the next packet.
+ */
+TEST_C(CommonTests, BigMQTTRxMessageStreamCutShort) {
+	uint32_t i = 0;
+	IoT_Error_t rc = FAILURE;
+	char expectedCallbackString[STREAMED_MESSAGE_LEN];
+
+	IOT_DEBUG("\n-->Running CommonTests - Streamed Message Cut Short \n");
+
+	setTLSRxBufferForSuback("limitTest/topic1", 16, QOS1, testPubMsgParams);
+	rc = aws_iot_mqtt_subscribe_streaming(&iotClient, "limitTest/topic1", 16, QOS1,
+										  iot_tests_unit_common_fragment_callback_handler, NULL);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	for(i = 0; i < STREAMED_MESSAGE_LEN - 1; i++) {
+		expectedCallbackString[i] = (char) ('A' + (i % 26));
+	}
+	expectedCallbackString[i] = '\0';
+
+	streamNextOffset = 0;
+	streamTotalLen = 0;
+	streamFragmentCount = 0;
+	memset(streamBuffer, 0, sizeof(streamBuffer));
+
+	/* Only the first half of the message arrives */
+	testPubMsgParams.qos = QOS1;
+	setTLSRxBufferWithMsgOnSubscribedTopic("limitTest/topic1", 16, QOS1, testPubMsgParams, expectedCallbackString);
+	RxBuffer.len = STREAMED_MESSAGE_LEN / 2;
+	rc = aws_iot_mqtt_yield(&iotClient, 1000);
+	CHECK_EQUAL_C_INT(NETWORK_DISCONNECTED_ERROR, rc);
+	CHECK_EQUAL_C_INT(false, aws_iot_mqtt_is_client_connected(&iotClient));
+
+	CHECK_EQUAL_C_INT(STREAMED_MESSAGE_LEN, streamTotalLen);
+	CHECK_C(0 < streamNextOffset);
+	CHECK_C(STREAMED_MESSAGE_LEN > streamNextOffset);
+	CHECK_EQUAL_C_INT(0, isLastTLSTxMessagePuback());
+}
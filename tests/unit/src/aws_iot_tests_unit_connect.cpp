@@ -84,3 +84,5 @@ TEST_GROUP_C_WRAPPER(ConnectTests, cleanSessionInitSubscribers)
 TEST_GROUP_C_WRAPPER(ConnectTests, PowerCycleWithCleanSessionFalse)
 /* B:29 - Reconnect attempt succeeds, but resubscribes fail */
 TEST_GROUP_C_WRAPPER(ConnectTests, ReconnectAndResubscribe)
+/* B:30 - Reconnect attempt succeeds, one topic refused when resubscribing */
+TEST_GROUP_C_WRAPPER(ConnectTests, ReconnectResubscribeTopicRejected)
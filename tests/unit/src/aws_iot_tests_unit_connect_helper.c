@@ -729,7 +729,7 @@ TEST_C(ConnectTests, ReconnectAndResubscribe) {
 	int itr = 0;
 	char subTestTopic[12] = { 0 };
 	uint16_t subTestTopicLen = 0;
-	IoT_Publish_Message_Params publish = { 0 };
+	unsigned char subackReturnCodes[3] = { QOS0, QOS0, QOS0 };
 
 	IOT_DEBUG("-->Running Connect Tests - B:29 - Reconnect attempt succeeds, but resubscribes fail \n");
 
@@ -737,8 +737,9 @@ TEST_C(ConnectTests, ReconnectAndResubscribe) {
 		#error "ReconnectAndResubscribe needs at least 3 subscription handlers to run"
 	#endif
 
-	// 1. Initialize client
+	// 1. Initialize client, with the exponential backoff whose waits are known in advance
 	InitMQTTParamsSetup(&initParams, AWS_IOT_MQTT_HOST, AWS_IOT_MQTT_PORT, true, NULL);
+	initParams.reconnectPolicy = aws_iot_mqtt_reconnect_policy_exponential;
 	rc = aws_iot_mqtt_init(&iotClient, &initParams);
 	CHECK_EQUAL_C_INT(SUCCESS, rc);
 	ResetTLSBuffer();
@@ -762,26 +763,27 @@ TEST_C(ConnectTests, ReconnectAndResubscribe) {
 	}
 
 	// 4. Trigger a reconnect by mocking NETWORK_SSL_READ_ERROR and calling yield.
-	// Place a CONNACK and SUBACK in the Rx buffer so that connect and 1 subscribe
-	// succeed. Note that the CONNACK and SUBACK placed in the Rx buffer are not
+	// Place a CONNACK and SUBACK in the Rx buffer so that connect succeeds. The 3
+	// topics are resubscribed with one SUBSCRIBE, but the SUBACK only has 1 return
+	// code. Note that the CONNACK and SUBACK placed in the Rx buffer are not
 	// effected by the mocked error as it does not change thr content of the Rx
 	// buffer.
 	setTLSRxBufferForError(NETWORK_SSL_READ_ERROR);
 	setTLSRxBufferForConnackAndSuback(&connectParams, 0, "sdk/topic0", 10, QOS0);
 	rc = aws_iot_mqtt_yield(&iotClient, AWS_IOT_MQTT_MIN_RECONNECT_WAIT_INTERVAL * 2);
 
-	// 5. Check results of yield call. As only 1 SUBACK was present in the Rx
-	// buffer, 2 resubscribes must fail. Client should be in a pending
+	// 5. Check results of yield call. As the SUBACK doesn't acknowledge all the
+	// topics, the resubscribe must fail. Client should be in a pending
 	// resubscribe state and the auto reconnect interval should have doubled.
 	CHECK_EQUAL_C_INT(NETWORK_ATTEMPTING_RECONNECT, rc);
-	CHECK_EQUAL_C_INT(1, iotClient.clientData.messageHandlers[0].resubscribed);
+	CHECK_EQUAL_C_INT(0, iotClient.clientData.messageHandlers[0].resubscribed);
 	CHECK_EQUAL_C_INT(0, iotClient.clientData.messageHandlers[1].resubscribed);
 	CHECK_EQUAL_C_INT(0, iotClient.clientData.messageHandlers[2].resubscribed);
 	CHECK_EQUAL_C_INT(CLIENT_STATE_CONNECTED_RESUBSCRIBE_IN_PROGRESS, aws_iot_mqtt_get_client_state(&iotClient));
 	CHECK_EQUAL_C_INT(2 * AWS_IOT_MQTT_MIN_RECONNECT_WAIT_INTERVAL, (int) iotClient.clientData.currentReconnectWaitInterval);
 
-	// 6. Add 2 more SUBACKs to the Rx buffer to complete the resubscribe.
-	setTLSRxBufferForDoubleSuback("sdk/topic1", 10, QOS0, publish);
+	// 6. Add a SUBACK for the 3 topics to the Rx buffer to complete the resubscribe.
+	setTLSRxBufferForMultiSuback(subackReturnCodes, 3);
 	rc = aws_iot_mqtt_yield(&iotClient, 2 * AWS_IOT_MQTT_MIN_RECONNECT_WAIT_INTERVAL * 2);
 	CHECK_EQUAL_C_INT(CLIENT_STATE_CONNECTED_IDLE, aws_iot_mqtt_get_client_state(&iotClient));
 	CHECK_EQUAL_C_INT(1, iotClient.clientData.messageHandlers[0].resubscribed);
@@ -790,3 +792,48 @@ TEST_C(ConnectTests, ReconnectAndResubscribe) {
 
 	IOT_DEBUG("-->Success - B:29 - Reconnect attempt succeeds, but resubscribes fail \n");
 }
+
+/* B:30 - Reconnect attempt succeeds, one topic refused when resubscribing */
+TEST_C(ConnectTests, ReconnectResubscribeTopicRejected) {
+	IoT_Error_t rc = SUCCESS;
+	int itr = 0;
+	char subTestTopic[12] = { 0 };
+	uint16_t subTestTopicLen = 0;
+	unsigned char subackReturnCodes[3] = { QOS0, 0x80, QOS0 };
+
+	IOT_DEBUG("-->Running Connect Tests - B:30 - Reconnect attempt succeeds, one topic refused when resubscribing \n");
+
+	InitMQTTParamsSetup(&initParams, AWS_IOT_MQTT_HOST, AWS_IOT_MQTT_PORT, true, NULL);
+	initParams.reconnectPolicy = aws_iot_mqtt_reconnect_policy_exponential;
+	rc = aws_iot_mqtt_init(&iotClient, &initParams);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	ResetTLSBuffer();
+
+	ConnectMQTTParamsSetup(&connectParams, AWS_IOT_MQTT_CLIENT_ID, (uint16_t) strlen(AWS_IOT_MQTT_CLIENT_ID));
+	connectParams.isCleanSession = true;
+	setTLSRxBufferForConnack(&connectParams, 0, 0);
+	rc = aws_iot_mqtt_connect(&iotClient, &connectParams);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	for(itr = 0; itr < 3; itr++) {
+		snprintf(subTestTopic, 12, "sdk/topic%d", itr + 1);
+		subTestTopicLen = (uint16_t) strlen(subTestTopic);
+		setTLSRxBufferForSuback(subTestTopic, subTestTopicLen, QOS0, testPubMsgParams);
+		rc = aws_iot_mqtt_subscribe(&iotClient, subTestTopic, subTestTopicLen, QOS0, iot_subscribe_callback_handler,
+									NULL);
+		CHECK_EQUAL_C_INT(SUCCESS, rc);
+	}
+
+	/* The second topic is refused on the new connection */
+	setTLSRxBufferForError(NETWORK_SSL_READ_ERROR);
+	setTLSRxBufferForConnackAndMultiSuback(&connectParams, 0, subackReturnCodes, 3);
+	rc = aws_iot_mqtt_yield(&iotClient, AWS_IOT_MQTT_MIN_RECONNECT_WAIT_INTERVAL * 2);
+
+	/* Not retried, the connection is usable with the two other topics */
+	CHECK_EQUAL_C_INT(CLIENT_STATE_CONNECTED_IDLE, aws_iot_mqtt_get_client_state(&iotClient));
+	CHECK_EQUAL_C_INT(1, iotClient.clientData.messageHandlers[0].resubscribed);
+	CHECK_C(NULL == iotClient.clientData.messageHandlers[1].topicName);
+	CHECK_EQUAL_C_INT(1, iotClient.clientData.messageHandlers[2].resubscribed);
+
+	IOT_DEBUG("-->Success - B:30 - Reconnect attempt succeeds, one topic refused when resubscribing \n");
+}
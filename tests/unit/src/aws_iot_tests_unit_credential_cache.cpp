@@ -0,0 +1,46 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file aws_iot_tests_unit_credential_cache.cpp
+ * @brief IoT Client Unit Testing - TLS Credential Cache Tests
+ */
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness_c.h>
+
+TEST_GROUP_C(CredentialCacheTests){
+	TEST_GROUP_C_SETUP_WRAPPER(CredentialCacheTests)
+	TEST_GROUP_C_TEARDOWN_WRAPPER(CredentialCacheTests)
+};
+
+/* K:1 - Connections with the same files share one entry, parsed once */
+TEST_GROUP_C_WRAPPER(CredentialCacheTests, SameKeySharesEntry)
+/* K:2 - Different files or options are parsed into separate entries */
+TEST_GROUP_C_WRAPPER(CredentialCacheTests, DifferentKeysParsedSeparately)
+/* K:3 - Unused entry kept after the last release and reused without parsing */
+TEST_GROUP_C_WRAPPER(CredentialCacheTests, KeptAfterLastRelease)
+/* K:4 - Invalidate frees unused entries at once */
+TEST_GROUP_C_WRAPPER(CredentialCacheTests, InvalidateFreesUnused)
+/* K:5 - Invalidated entry in use freed by its last release, later connections parse again */
+TEST_GROUP_C_WRAPPER(CredentialCacheTests, InvalidateDefersInUse)
+/* K:6 - Failed parse is freed and not cached */
+TEST_GROUP_C_WRAPPER(CredentialCacheTests, ParseFailureNotCached)
+/* K:7 - Other connections acquire and release while a parse is in progress */
+TEST_GROUP_C_WRAPPER(CredentialCacheTests, ParseDoesNotHoldLock)
+/* K:8 - Same files parsed by two connections at once end in one entry */
+TEST_GROUP_C_WRAPPER(CredentialCacheTests, ConcurrentParseKeepsOneEntry)
+/* K:9 - Files parsed across an invalidate used by their connection only */
+TEST_GROUP_C_WRAPPER(CredentialCacheTests, InvalidateDuringParse)
@@ -0,0 +1,357 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file aws_iot_tests_unit_credential_cache_helper.c
+ * @brief IoT Client Unit Testing - TLS Credential Cache Tests Helper
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <CppUTest/TestHarness_c.h>
+
+#include "network_credential_cache.h"
+#include "aws_iot_log.h"
+
+/* Stands in for the parsed credentials of the TLS layer */
+typedef struct {
+	CredentialCacheEntry cacheEntry;
+	uint32_t parsedCerts;
+} TestCredentials;
+
+static uint32_t parseCount;
+static uint32_t freeCount;
+static IoT_Error_t parseRc;
+
+/* Parses of the blocked root CA wait until the gate is opened, like a parse reading a slow file */
+static const char *pBlockedRootCA;
+static bool isGateOpen;
+static uint32_t blockedParses;
+static pthread_mutex_t gateLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t gateCond = PTHREAD_COND_INITIALIZER;
+
+static IoT_Error_t iot_tests_unit_credentials_parse(CredentialCacheEntry *pEntry) {
+	pthread_mutex_lock(&gateLock);
+	parseCount++;
+	if(NULL != pBlockedRootCA && 0 == strcmp(pBlockedRootCA, pEntry->pRootCALocation)) {
+		blockedParses++;
+		pthread_cond_broadcast(&gateCond);
+		while(!isGateOpen) {
+			pthread_cond_wait(&gateCond, &gateLock);
+		}
+	}
+	pthread_mutex_unlock(&gateLock);
+
+	((TestCredentials *) pEntry)->parsedCerts = 2;
+	return parseRc;
+}
+
+static void iot_tests_unit_credentials_free(CredentialCacheEntry *pEntry) {
+	IOT_UNUSED(pEntry);
+	pthread_mutex_lock(&gateLock);
+	freeCount++;
+	pthread_mutex_unlock(&gateLock);
+}
+
+static CredentialCache cache = IOT_CREDENTIAL_CACHE_INITIALIZER(sizeof(TestCredentials),
+																 iot_tests_unit_credentials_parse,
+																 iot_tests_unit_credentials_free);
+
+static CredentialCacheEntry key;
+static char rootCA[32], deviceCert[32], deviceKey[32];
+
+typedef struct {
+	pthread_t thread;
+	CredentialCacheEntry *pEntry;
+	IoT_Error_t rc;
+} AcquireThread;
+
+static void *iot_tests_unit_credentials_acquire_thread(void *pArg) {
+	AcquireThread *pAcquire = (AcquireThread *) pArg;
+
+	pAcquire->rc = iot_tls_credential_cache_acquire(&cache, &key, &(pAcquire->pEntry));
+	return NULL;
+}
+
+static void iot_tests_unit_credentials_wait_blocked(uint32_t count) {
+	pthread_mutex_lock(&gateLock);
+	while(blockedParses < count) {
+		pthread_cond_wait(&gateCond, &gateLock);
+	}
+	pthread_mutex_unlock(&gateLock);
+}
+
+static void iot_tests_unit_credentials_open_gate(void) {
+	pthread_mutex_lock(&gateLock);
+	isGateOpen = true;
+	pthread_cond_broadcast(&gateCond);
+	pthread_mutex_unlock(&gateLock);
+}
+
+TEST_GROUP_C_SETUP(CredentialCacheTests) {
+	parseCount = 0;
+	freeCount = 0;
+	parseRc = SUCCESS;
+	pBlockedRootCA = NULL;
+	isGateOpen = false;
+	blockedParses = 0;
+
+	snprintf(rootCA, sizeof(rootCA), "certs/rootCA.crt");
+	snprintf(deviceCert, sizeof(deviceCert), "certs/cert.pem");
+	snprintf(deviceKey, sizeof(deviceKey), "certs/privkey.pem");
+	memset(&key, 0, sizeof(key));
+	key.pRootCALocation = rootCA;
+	key.pDeviceCertLocation = deviceCert;
+	key.pDevicePrivateKeyLocation = deviceKey;
+	key.ServerVerificationFlag = true;
+	key.isAlpnEnabled = false;
+}
+
+TEST_GROUP_C_TEARDOWN(CredentialCacheTests) {
+	/* Every test releases what it acquired, this empties the cache for the next one */
+	iot_tls_credential_cache_invalidate(&cache);
+	CHECK_C(NULL == cache.pHead);
+}
+
+/* K:1 - Connections with the same files share one entry, parsed once */
+TEST_C(CredentialCacheTests, SameKeySharesEntry) {
+	CredentialCacheEntry *pFirst = NULL, *pSecond = NULL;
+
+	IOT_DEBUG("-->Running Credential Cache Tests - K:1 - Same key shares entry \n");
+
+	CHECK_EQUAL_C_INT(SUCCESS, iot_tls_credential_cache_acquire(&cache, &key, &pFirst));
+	CHECK_EQUAL_C_INT(SUCCESS, iot_tls_credential_cache_acquire(&cache, &key, &pSecond));
+	CHECK_C(pFirst == pSecond);
+	CHECK_EQUAL_C_INT(1, parseCount);
+	CHECK_EQUAL_C_INT(2, pFirst->refCount);
+	CHECK_EQUAL_C_INT(2, ((TestCredentials *) pFirst)->parsedCerts);
+
+	/* The entry owns a copy of the paths */
+	CHECK_C(pFirst->pRootCALocation != rootCA);
+	CHECK_EQUAL_C_STRING(rootCA, pFirst->pRootCALocation);
+	CHECK_EQUAL_C_STRING(deviceCert, pFirst->pDeviceCertLocation);
+	CHECK_EQUAL_C_STRING(deviceKey, pFirst->pDevicePrivateKeyLocation);
+
+	iot_tls_credential_cache_release(&cache, pFirst);
+	CHECK_EQUAL_C_INT(1, pSecond->refCount);
+	iot_tls_credential_cache_release(&cache, pSecond);
+	CHECK_EQUAL_C_INT(0, freeCount);
+
+	IOT_DEBUG("-->Success - K:1 - Same key shares entry \n");
+}
+
+/* K:2 - Different files or options are parsed into separate entries */
+TEST_C(CredentialCacheTests, DifferentKeysParsedSeparately) {
+	CredentialCacheEntry *pFirst = NULL, *pOtherCert = NULL, *pOtherFlag = NULL;
+
+	IOT_DEBUG("-->Running Credential Cache Tests - K:2 - Different keys parsed separately \n");
+
+	CHECK_EQUAL_C_INT(SUCCESS, iot_tls_credential_cache_acquire(&cache, &key, &pFirst));
+	snprintf(deviceCert, sizeof(deviceCert), "certs/other.pem");
+	CHECK_EQUAL_C_INT(SUCCESS, iot_tls_credential_cache_acquire(&cache, &key, &pOtherCert));
+	key.isAlpnEnabled = true;
+	CHECK_EQUAL_C_INT(SUCCESS, iot_tls_credential_cache_acquire(&cache, &key, &pOtherFlag));
+
+	CHECK_EQUAL_C_INT(3, parseCount);
+	CHECK_C(pFirst != pOtherCert);
+	CHECK_C(pOtherCert != pOtherFlag);
+	/* Changing the caller string does not change the cached key */
+	CHECK_EQUAL_C_STRING("certs/cert.pem", pFirst->pDeviceCertLocation);
+
+	iot_tls_credential_cache_release(&cache, pFirst);
+	iot_tls_credential_cache_release(&cache, pOtherCert);
+	iot_tls_credential_cache_release(&cache, pOtherFlag);
+
+	IOT_DEBUG("-->Success - K:2 - Different keys parsed separately \n");
+}
+
+/* K:3 - Unused entry kept after the last release and reused without parsing */
+TEST_C(CredentialCacheTests, KeptAfterLastRelease) {
+	CredentialCacheEntry *pFirst = NULL, *pSecond = NULL;
+
+	IOT_DEBUG("-->Running Credential Cache Tests - K:3 - Kept after last release \n");
+
+	CHECK_EQUAL_C_INT(SUCCESS, iot_tls_credential_cache_acquire(&cache, &key, &pFirst));
+	iot_tls_credential_cache_release(&cache, pFirst);
+	CHECK_EQUAL_C_INT(0, freeCount);
+	CHECK_C(pFirst == cache.pHead);
+	CHECK_EQUAL_C_INT(0, pFirst->refCount);
+
+	CHECK_EQUAL_C_INT(SUCCESS, iot_tls_credential_cache_acquire(&cache, &key, &pSecond));
+	CHECK_C(pFirst == pSecond);
+	CHECK_EQUAL_C_INT(1, parseCount);
+	iot_tls_credential_cache_release(&cache, pSecond);
+
+	IOT_DEBUG("-->Success - K:3 - Kept after last release \n");
+}
+
+/* K:4 - Invalidate frees unused entries at once */
+TEST_C(CredentialCacheTests, InvalidateFreesUnused) {
+	CredentialCacheEntry *pFirst = NULL, *pOther = NULL;
+
+	IOT_DEBUG("-->Running Credential Cache Tests - K:4 - Invalidate frees unused \n");
+
+	CHECK_EQUAL_C_INT(SUCCESS, iot_tls_credential_cache_acquire(&cache, &key, &pFirst));
+	key.ServerVerificationFlag = false;
+	CHECK_EQUAL_C_INT(SUCCESS, iot_tls_credential_cache_acquire(&cache, &key, &pOther));
+	iot_tls_credential_cache_release(&cache, pFirst);
+	iot_tls_credential_cache_release(&cache, pOther);
+
+	iot_tls_credential_cache_invalidate(&cache);
+	CHECK_EQUAL_C_INT(2, freeCount);
+	CHECK_C(NULL == cache.pHead);
+
+	IOT_DEBUG("-->Success - K:4 - Invalidate frees unused \n");
+}
+
+/* K:5 - Invalidated entry in use freed by its last release, later connections parse again */
+TEST_C(CredentialCacheTests, InvalidateDefersInUse) {
+	CredentialCacheEntry *pOld = NULL, *pNew = NULL;
+
+	IOT_DEBUG("-->Running Credential Cache Tests - K:5 - Invalidate defers in use \n");
+
+	CHECK_EQUAL_C_INT(SUCCESS, iot_tls_credential_cache_acquire(&cache, &key, &pOld));
+	iot_tls_credential_cache_invalidate(&cache);
+	CHECK_EQUAL_C_INT(0, freeCount);
+	CHECK_C(pOld->isInvalidated);
+
+	/* Certificates rotated on disk, the next connect must not get the old ones */
+	CHECK_EQUAL_C_INT(SUCCESS, iot_tls_credential_cache_acquire(&cache, &key, &pNew));
+	CHECK_C(pOld != pNew);
+	CHECK_EQUAL_C_INT(2, parseCount);
+
+	iot_tls_credential_cache_release(&cache, pOld);
+	CHECK_EQUAL_C_INT(1, freeCount);
+	CHECK_C(pNew == cache.pHead);
+	CHECK_C(NULL == cache.pHead->pNext);
+
+	iot_tls_credential_cache_release(&cache, pNew);
+	CHECK_EQUAL_C_INT(1, freeCount);
+
+	IOT_DEBUG("-->Success - K:5 - Invalidate defers in use \n");
+}
+
+/* K:6 - Failed parse is freed and not cached */
+TEST_C(CredentialCacheTests, ParseFailureNotCached) {
+	CredentialCacheEntry *pEntry = NULL;
+
+	IOT_DEBUG("-->Running Credential Cache Tests - K:6 - Parse failure not cached \n");
+
+	parseRc = NETWORK_X509_DEVICE_CRT_PARSE_ERROR;
+	CHECK_EQUAL_C_INT(NETWORK_X509_DEVICE_CRT_PARSE_ERROR, iot_tls_credential_cache_acquire(&cache, &key, &pEntry));
+	CHECK_C(NULL == pEntry);
+	CHECK_EQUAL_C_INT(1, freeCount);
+	CHECK_C(NULL == cache.pHead);
+
+	/* Fixed on disk, the next connect parses again */
+	parseRc = SUCCESS;
+	CHECK_EQUAL_C_INT(SUCCESS, iot_tls_credential_cache_acquire(&cache, &key, &pEntry));
+	CHECK_EQUAL_C_INT(2, parseCount);
+	iot_tls_credential_cache_release(&cache, pEntry);
+
+	CHECK_EQUAL_C_INT(NULL_VALUE_ERROR, iot_tls_credential_cache_acquire(&cache, NULL, &pEntry));
+
+	IOT_DEBUG("-->Success - K:6 - Parse failure not cached \n");
+}
+
+/* K:7 - Other connections acquire and release while a parse is in progress */
+TEST_C(CredentialCacheTests, ParseDoesNotHoldLock) {
+	AcquireThread blocked;
+	CredentialCacheEntry *pOther = NULL, *pOtherAgain = NULL;
+	CredentialCacheEntry otherKey;
+
+	IOT_DEBUG("-->Running Credential Cache Tests - K:7 - Parse does not hold lock \n");
+
+	pBlockedRootCA = "certs/rootCA.crt";
+	CHECK_EQUAL_C_INT(0, pthread_create(&blocked.thread, NULL, iot_tests_unit_credentials_acquire_thread, &blocked));
+	iot_tests_unit_credentials_wait_blocked(1);
+
+	/* Would wait for the blocked parse if it held the cache lock */
+	otherKey = key;
+	otherKey.pRootCALocation = (char *) "certs/otherCA.crt";
+	CHECK_EQUAL_C_INT(SUCCESS, iot_tls_credential_cache_acquire(&cache, &otherKey, &pOther));
+	iot_tls_credential_cache_release(&cache, pOther);
+	CHECK_EQUAL_C_INT(SUCCESS, iot_tls_credential_cache_acquire(&cache, &otherKey, &pOtherAgain));
+	CHECK_C(pOther == pOtherAgain);
+	iot_tls_credential_cache_release(&cache, pOtherAgain);
+
+	iot_tests_unit_credentials_open_gate();
+	pthread_join(blocked.thread, NULL);
+	CHECK_EQUAL_C_INT(SUCCESS, blocked.rc);
+	CHECK_EQUAL_C_INT(2, parseCount);
+	iot_tls_credential_cache_release(&cache, blocked.pEntry);
+
+	IOT_DEBUG("-->Success - K:7 - Parse does not hold lock \n");
+}
+
+/* K:8 - Same files parsed by two connections at once end in one entry */
+TEST_C(CredentialCacheTests, ConcurrentParseKeepsOneEntry) {
+	AcquireThread first, second;
+
+	IOT_DEBUG("-->Running Credential Cache Tests - K:8 - Concurrent parse keeps one entry \n");
+
+	pBlockedRootCA = "certs/rootCA.crt";
+	CHECK_EQUAL_C_INT(0, pthread_create(&first.thread, NULL, iot_tests_unit_credentials_acquire_thread, &first));
+	CHECK_EQUAL_C_INT(0, pthread_create(&second.thread, NULL, iot_tests_unit_credentials_acquire_thread, &second));
+	/* Both missed the cache and are parsing */
+	iot_tests_unit_credentials_wait_blocked(2);
+
+	iot_tests_unit_credentials_open_gate();
+	pthread_join(first.thread, NULL);
+	pthread_join(second.thread, NULL);
+
+	CHECK_EQUAL_C_INT(SUCCESS, first.rc);
+	CHECK_EQUAL_C_INT(SUCCESS, second.rc);
+	CHECK_C(first.pEntry == second.pEntry);
+	CHECK_EQUAL_C_INT(2, first.pEntry->refCount);
+	CHECK_EQUAL_C_INT(1, freeCount);
+	CHECK_C(first.pEntry == cache.pHead);
+	CHECK_C(NULL == cache.pHead->pNext);
+
+	iot_tls_credential_cache_release(&cache, first.pEntry);
+	iot_tls_credential_cache_release(&cache, second.pEntry);
+	CHECK_EQUAL_C_INT(1, freeCount);
+
+	IOT_DEBUG("-->Success - K:8 - Concurrent parse keeps one entry \n");
+}
+
+/* K:9 - Files parsed across an invalidate used by their connection only */
+TEST_C(CredentialCacheTests, InvalidateDuringParse) {
+	AcquireThread blocked;
+	CredentialCacheEntry *pEntry = NULL;
+
+	IOT_DEBUG("-->Running Credential Cache Tests - K:9 - Invalidate during parse \n");
+
+	pBlockedRootCA = "certs/rootCA.crt";
+	CHECK_EQUAL_C_INT(0, pthread_create(&blocked.thread, NULL, iot_tests_unit_credentials_acquire_thread, &blocked));
+	iot_tests_unit_credentials_wait_blocked(1);
+	iot_tls_credential_cache_invalidate(&cache);
+	iot_tests_unit_credentials_open_gate();
+	pthread_join(blocked.thread, NULL);
+
+	CHECK_EQUAL_C_INT(SUCCESS, blocked.rc);
+	CHECK_C(blocked.pEntry->isInvalidated);
+
+	CHECK_EQUAL_C_INT(SUCCESS, iot_tls_credential_cache_acquire(&cache, &key, &pEntry));
+	CHECK_C(pEntry != blocked.pEntry);
+	CHECK_EQUAL_C_INT(2, parseCount);
+
+	iot_tls_credential_cache_release(&cache, blocked.pEntry);
+	CHECK_EQUAL_C_INT(1, freeCount);
+	iot_tls_credential_cache_release(&cache, pEntry);
+
+	IOT_DEBUG("-->Success - K:9 - Invalidate during parse \n");
+}
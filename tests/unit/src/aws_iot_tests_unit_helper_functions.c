@@ -151,6 +151,25 @@ void setTLSRxBufferForConnackAndSuback(IoT_Client_Connect_Params *conParams, uns
 	RxIndex = 0;
 }
 
+void setTLSRxBufferForConnackAndMultiSuback(IoT_Client_Connect_Params *conParams, unsigned char sessionPresent,
+											unsigned char *pReturnCodes, uint32_t count) {
+	uint32_t i;
+
+	setTLSRxBufferForConnack(conParams, sessionPresent, 0);
+
+	RxBuffer.pBuffer[4] = (unsigned char) (0x90);
+	RxBuffer.pBuffer[5] = (unsigned char) (0x2 + count);
+	// Variable header - packet identifier
+	RxBuffer.pBuffer[6] = (unsigned char) (2);
+	RxBuffer.pBuffer[7] = (unsigned char) (0);
+	// payload
+	for(i = 0; i < count; i++) {
+		RxBuffer.pBuffer[8 + i] = pReturnCodes[i];
+	}
+
+	RxBuffer.len = CONNACK_PACKET_SIZE + 4 + count;
+}
+
 void setTLSRxBufferForPuback(void) {
 	size_t i;
 
@@ -169,6 +188,12 @@ void setTLSRxBufferForPuback(void) {
 	RxBuffer.NoMsgFlag = false;
 }
 
+void setTLSRxBufferForPubackWithId(uint16_t packetId) {
+	setTLSRxBufferForPuback();
+	RxBuffer.pBuffer[2] = (unsigned char) (packetId >> 8);
+	RxBuffer.pBuffer[3] = (unsigned char) (packetId & 0xFF);
+}
+
 void setTLSRxBufferForSubFail(void) {
 	RxBuffer.NoMsgFlag = false;
 	RxBuffer.pBuffer[0] = (unsigned char) (0x90);
@@ -209,6 +234,25 @@ void setTLSRxBufferForDoubleSuback(char *topicName, size_t topicNameLen, QoS qos
 	RxIndex = 0;
 }
 
+void setTLSRxBufferForMultiSuback(unsigned char *pReturnCodes, uint32_t count) {
+	uint32_t i;
+
+	RxBuffer.NoMsgFlag = false;
+	RxBuffer.pBuffer[0] = (unsigned char) (0x90);
+	// Remaining length fits in one byte for up to 125 return codes
+	RxBuffer.pBuffer[1] = (unsigned char) (0x2 + count);
+	// Variable header - packet identifier
+	RxBuffer.pBuffer[2] = (unsigned char) (2);
+	RxBuffer.pBuffer[3] = (unsigned char) (0);
+	// payload
+	for(i = 0; i < count; i++) {
+		RxBuffer.pBuffer[4 + i] = pReturnCodes[i];
+	}
+
+	RxBuffer.len = 4 + count;
+	RxIndex = 0;
+}
+
 void setTLSRxBufferForSuback(char *topicName, size_t topicNameLen, QoS qos, IoT_Publish_Message_Params params) {
 	IOT_UNUSED(topicName);
 	IOT_UNUSED(topicNameLen);
@@ -321,7 +365,7 @@ void setTLSRxBufferWithMsgOnSubscribedTopic(char *topicName, size_t topicNameLen
 		RxBuffer.pBuffer[payloadStartLoc + i] = (unsigned char) pMsg[i];
 	}
 
-	RxBuffer.len = VariableLen + PayloadLen + 2; // 2 for fixed header
+	RxBuffer.len = cursor + VariableLen + PayloadLen; // cursor is the fixed header length
 	RxIndex = 0;
 	//printBuffer(RxBuffer.pBuffer, RxBuffer.len);
 }
@@ -0,0 +1,36 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file aws_iot_tests_unit_keep_alive.cpp
+ * @brief IoT Client Unit Testing - Keep Alive Tests
+ */
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness_c.h>
+
+TEST_GROUP_C(KeepAliveTests){
+	TEST_GROUP_C_SETUP_WRAPPER(KeepAliveTests)
+	TEST_GROUP_C_TEARDOWN_WRAPPER(KeepAliveTests)
+};
+
+/* K:1 - No PINGREQ while the client keeps publishing */
+TEST_GROUP_C_WRAPPER(KeepAliveTests, PublishDefersPingreq)
+/* K:2 - Adaptive keep alive, idle time doubled after every PINGRESP up to the keep alive interval */
+TEST_GROUP_C_WRAPPER(KeepAliveTests, AdaptiveDoublesUpToKeepAlive)
+/* K:3 - Adaptive keep alive, connection lost during a probe, longest working idle time kept */
+TEST_GROUP_C_WRAPPER(KeepAliveTests, AdaptiveFallsBackWhenProbeFails)
+/* K:4 - Adaptive keep alive, no probe after traffic from the broker */
+TEST_GROUP_C_WRAPPER(KeepAliveTests, AdaptiveNoProbeAfterInboundTraffic)
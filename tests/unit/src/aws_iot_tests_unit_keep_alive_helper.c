@@ -0,0 +1,228 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file aws_iot_tests_unit_keep_alive_helper.c
+ * @brief IoT Client Unit Testing - Keep Alive Tests Helper
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <CppUTest/TestHarness_c.h>
+
+#include "aws_iot_tests_unit_helper_functions.h"
+#include "aws_iot_tests_unit_mock_tls_params.h"
+#include "aws_iot_log.h"
+
+static IoT_Client_Init_Params initParams;
+static IoT_Client_Connect_Params connectParams;
+static AWS_IoT_Client iotClient;
+static IoT_Publish_Message_Params testPubMsgParams;
+
+static char subTopic[10] = "sdk/Test";
+static uint16_t subTopicLen = 8;
+static char cPayload[10] = "keepalive";
+
+static void iot_tests_unit_keep_alive_subscribe_handler(AWS_IoT_Client *pClient, char *topicName,
+														uint16_t topicNameLen, IoT_Publish_Message_Params *params,
+														void *pData) {
+	IOT_UNUSED(pClient);
+	IOT_UNUSED(topicName);
+	IOT_UNUSED(topicNameLen);
+	IOT_UNUSED(params);
+	IOT_UNUSED(pData);
+}
+
+static void iot_tests_unit_keep_alive_connect(bool isKeepAliveAdaptive, uint16_t keepAliveIntervalInSec) {
+	IoT_Error_t rc;
+
+	InitMQTTParamsSetup(&initParams, AWS_IOT_MQTT_HOST, AWS_IOT_MQTT_PORT, false, NULL);
+	initParams.isKeepAliveAdaptive = isKeepAliveAdaptive;
+	rc = aws_iot_mqtt_init(&iotClient, &initParams);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	ConnectMQTTParamsSetup(&connectParams, AWS_IOT_MQTT_CLIENT_ID, (uint16_t) strlen(AWS_IOT_MQTT_CLIENT_ID));
+	connectParams.keepAliveIntervalInSec = keepAliveIntervalInSec;
+	setTLSRxBufferForConnack(&connectParams, 0, 0);
+	rc = aws_iot_mqtt_connect(&iotClient, &connectParams);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	ResetTLSBuffer();
+}
+
+/* Sends the PINGREQ due after the current idle time without waiting for it */
+static void iot_tests_unit_keep_alive_ping(void) {
+	IoT_Error_t rc;
+
+	countdown_ms(&(iotClient.pingReqTimer), 0);
+	rc = aws_iot_mqtt_yield(&iotClient, 20);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(true, isLastTLSTxMessagePingreq());
+	CHECK_EQUAL_C_INT(true, iotClient.clientStatus.isPingOutstanding);
+}
+
+static void iot_tests_unit_keep_alive_pingresp(void) {
+	IoT_Error_t rc;
+
+	ResetTLSBuffer();
+	setTLSRxBufferForPingresp();
+	rc = aws_iot_mqtt_yield(&iotClient, 20);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(false, iotClient.clientStatus.isPingOutstanding);
+}
+
+TEST_GROUP_C_SETUP(KeepAliveTests) {
+	ResetTLSBuffer();
+}
+
+TEST_GROUP_C_TEARDOWN(KeepAliveTests) {
+	/* Clean up. Not checking return code here because this is common to all tests.
+	 * A test might have already caused a disconnect by this point.
+	 */
+	IoT_Error_t rc = aws_iot_mqtt_disconnect(&iotClient);
+	IOT_UNUSED(rc);
+
+	(void)aws_iot_mqtt_free(&iotClient);
+}
+
+/* K:1 - No PINGREQ while the client keeps publishing */
+TEST_C(KeepAliveTests, PublishDefersPingreq) {
+	IoT_Error_t rc;
+	int itr;
+
+	IOT_DEBUG("-->Running Keep Alive Tests - K:1 - Publish defers PINGREQ \n");
+
+	iot_tests_unit_keep_alive_connect(false, 1);
+
+	testPubMsgParams.qos = QOS0;
+	testPubMsgParams.isRetained = 0;
+	testPubMsgParams.payload = (void *) cPayload;
+	testPubMsgParams.payloadLen = strlen(cPayload);
+
+	/* Twice the keep alive interval, a message every 300 ms */
+	for(itr = 0; itr < 7; itr++) {
+		usleep(300000);
+		rc = aws_iot_mqtt_publish(&iotClient, subTopic, subTopicLen, &testPubMsgParams);
+		CHECK_EQUAL_C_INT(SUCCESS, rc);
+		rc = aws_iot_mqtt_yield(&iotClient, 20);
+		CHECK_EQUAL_C_INT(SUCCESS, rc);
+		CHECK_EQUAL_C_INT(false, isLastTLSTxMessagePingreq());
+		CHECK_EQUAL_C_INT(false, iotClient.clientStatus.isPingOutstanding);
+	}
+
+	/* Silent for the keep alive interval */
+	usleep(1100000);
+	rc = aws_iot_mqtt_yield(&iotClient, 20);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(true, isLastTLSTxMessagePingreq());
+
+	IOT_DEBUG("-->Success - K:1 - Publish defers PINGREQ \n");
+}
+
+/* K:2 - Adaptive keep alive, idle time doubled after every PINGRESP up to the keep alive interval */
+TEST_C(KeepAliveTests, AdaptiveDoublesUpToKeepAlive) {
+	IOT_DEBUG("-->Running Keep Alive Tests - K:2 - Adaptive doubles up to keep alive \n");
+
+	iot_tests_unit_keep_alive_connect(true, 6);
+	CHECK_EQUAL_C_INT(AWS_IOT_MQTT_ADAPTIVE_KEEP_ALIVE_MIN_SEC, iotClient.clientData.pingIntervalSec);
+
+	iot_tests_unit_keep_alive_ping();
+	CHECK_EQUAL_C_INT(1, iotClient.clientData.pingProbeSec);
+	iot_tests_unit_keep_alive_pingresp();
+	CHECK_EQUAL_C_INT(1, iotClient.clientData.pingIntervalConfirmedSec);
+	CHECK_EQUAL_C_INT(2, iotClient.clientData.pingIntervalSec);
+
+	iot_tests_unit_keep_alive_ping();
+	CHECK_EQUAL_C_INT(2, iotClient.clientData.pingProbeSec);
+	iot_tests_unit_keep_alive_pingresp();
+	CHECK_EQUAL_C_INT(4, iotClient.clientData.pingIntervalSec);
+
+	/* Capped by the keep alive interval */
+	iot_tests_unit_keep_alive_ping();
+	iot_tests_unit_keep_alive_pingresp();
+	CHECK_EQUAL_C_INT(4, iotClient.clientData.pingIntervalConfirmedSec);
+	CHECK_EQUAL_C_INT(6, iotClient.clientData.pingIntervalSec);
+
+	iot_tests_unit_keep_alive_ping();
+	iot_tests_unit_keep_alive_pingresp();
+	CHECK_EQUAL_C_INT(6, iotClient.clientData.pingIntervalConfirmedSec);
+	CHECK_EQUAL_C_INT(6, iotClient.clientData.pingIntervalSec);
+
+	/* Nothing left to probe */
+	iot_tests_unit_keep_alive_ping();
+	CHECK_EQUAL_C_INT(0, iotClient.clientData.pingProbeSec);
+
+	IOT_DEBUG("-->Success - K:2 - Adaptive doubles up to keep alive \n");
+}
+
+/* K:3 - Adaptive keep alive, connection lost during a probe, longest working idle time kept */
+TEST_C(KeepAliveTests, AdaptiveFallsBackWhenProbeFails) {
+	IoT_Error_t rc;
+
+	IOT_DEBUG("-->Running Keep Alive Tests - K:3 - Adaptive falls back when probe fails \n");
+
+	iot_tests_unit_keep_alive_connect(true, 8);
+	iot_tests_unit_keep_alive_ping();
+	iot_tests_unit_keep_alive_pingresp();
+	CHECK_EQUAL_C_INT(2, iotClient.clientData.pingIntervalSec);
+
+	/* The connection is cut before the PINGRESP */
+	iot_tests_unit_keep_alive_ping();
+	setTLSRxBufferForError(NETWORK_SSL_READ_ERROR);
+	rc = aws_iot_mqtt_yield(&iotClient, 20);
+	CHECK_EQUAL_C_INT(NETWORK_DISCONNECTED_ERROR, rc);
+	CHECK_EQUAL_C_INT(1, iotClient.clientData.pingIntervalSec);
+	CHECK_EQUAL_C_INT(1, iotClient.clientData.pingIntervalConfirmedSec);
+
+	/* Kept by the next connection */
+	ResetTLSBuffer();
+	setTLSRxBufferForConnack(&connectParams, 0, 0);
+	rc = aws_iot_mqtt_connect(&iotClient, &connectParams);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(1, iotClient.clientData.pingIntervalSec);
+	ResetTLSBuffer();
+	iot_tests_unit_keep_alive_ping();
+	CHECK_EQUAL_C_INT(0, iotClient.clientData.pingProbeSec);
+
+	IOT_DEBUG("-->Success - K:3 - Adaptive falls back when probe fails \n");
+}
+
+/* K:4 - Adaptive keep alive, no probe after traffic from the broker */
+TEST_C(KeepAliveTests, AdaptiveNoProbeAfterInboundTraffic) {
+	IoT_Error_t rc;
+
+	IOT_DEBUG("-->Running Keep Alive Tests - K:4 - Adaptive, no probe after inbound traffic \n");
+
+	iot_tests_unit_keep_alive_connect(true, 8);
+
+	/* The SUBACK is received after the SUBSCRIBE restarted the PINGREQ timer */
+	setTLSRxBufferForSuback(subTopic, subTopicLen, QOS0, testPubMsgParams);
+	rc = aws_iot_mqtt_subscribe(&iotClient, subTopic, subTopicLen, QOS0, iot_tests_unit_keep_alive_subscribe_handler,
+								NULL);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	ResetTLSBuffer();
+
+	iot_tests_unit_keep_alive_ping();
+	CHECK_EQUAL_C_INT(0, iotClient.clientData.pingProbeSec);
+	iot_tests_unit_keep_alive_pingresp();
+	CHECK_EQUAL_C_INT(1, iotClient.clientData.pingIntervalSec);
+	CHECK_EQUAL_C_INT(0, iotClient.clientData.pingIntervalConfirmedSec);
+
+	/* Silent since the last PINGREQ, probed */
+	iot_tests_unit_keep_alive_ping();
+	CHECK_EQUAL_C_INT(1, iotClient.clientData.pingProbeSec);
+
+	IOT_DEBUG("-->Success - K:4 - Adaptive, no probe after inbound traffic \n");
+}
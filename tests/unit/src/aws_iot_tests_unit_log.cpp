@@ -0,0 +1,44 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file aws_iot_tests_unit_log.cpp
+ * @brief IoT Client Unit Testing - Asynchronous Logger Tests
+ */
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness_c.h>
+
+TEST_GROUP_C(LogTests){
+	TEST_GROUP_C_SETUP_WRAPPER(LogTests)
+	TEST_GROUP_C_TEARDOWN_WRAPPER(LogTests)
+};
+
+/* L:1 - Records are formatted when flushed, with strings copied when logged */
+TEST_GROUP_C_WRAPPER(LogTests, FormattedOnFlush)
+/* L:2 - Conversions are formatted as printf does */
+TEST_GROUP_C_WRAPPER(LogTests, ConversionsMatchPrintf)
+/* L:3 - Arguments that do not fit in a record are cut */
+TEST_GROUP_C_WRAPPER(LogTests, LongArgumentsTruncated)
+/* L:4 - Messages below the runtime level are filtered out */
+TEST_GROUP_C_WRAPPER(LogTests, RuntimeLevelFilter)
+/* L:5 - Each call site is rate limited and reports the suppressed messages */
+TEST_GROUP_C_WRAPPER(LogTests, RateLimitPerCallSite)
+/* L:6 - A full ring drops records without blocking and reports them */
+TEST_GROUP_C_WRAPPER(LogTests, FullRingDropsRecords)
+/* L:7 - The ring of a thread is given back when the thread exits */
+TEST_GROUP_C_WRAPPER(LogTests, RingsGivenBackOnThreadExit)
+/* L:8 - Threads finding no free ring share one, its drops are counted */
+TEST_GROUP_C_WRAPPER(LogTests, ThreadsWithoutRingShareOne)
@@ -0,0 +1,255 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file aws_iot_tests_unit_log_helper.c
+ * @brief IoT Client Unit Testing - Asynchronous Logger Tests Helper
+ *
+ * The logger is built with ENABLE_IOT_ASYNC_LOG. The levels used by the tests are only
+ * enabled in this file.
+ */
+
+#ifndef ENABLE_IOT_INFO
+#define ENABLE_IOT_INFO
+#endif
+#ifndef ENABLE_IOT_WARN
+#define ENABLE_IOT_WARN
+#endif
+#ifndef ENABLE_IOT_ERROR
+#define ENABLE_IOT_ERROR
+#endif
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <CppUTest/TestHarness_c.h>
+
+#include "aws_iot_config.h"
+#include "aws_iot_log.h"
+
+#define LOG_TEST_MAX_LINES (AWS_IOT_LOG_RING_RECORDS + 8)
+#define LOG_TEST_LINE_LEN (AWS_IOT_LOG_LINE_LEN + 1)
+
+static char lines[LOG_TEST_MAX_LINES][LOG_TEST_LINE_LEN];
+static uint32_t lineCount;
+static pthread_barrier_t threadsBarrier;
+
+static void iot_tests_unit_log_output(const char *pLine, size_t len) {
+	if(lineCount < LOG_TEST_MAX_LINES) {
+		if(len >= LOG_TEST_LINE_LEN) {
+			len = LOG_TEST_LINE_LEN - 1;
+		}
+		memcpy(lines[lineCount], pLine, len);
+		lines[lineCount][len] = '\0';
+	}
+	lineCount++;
+}
+
+/* The message of a line, after the prefix, function and line number */
+static const char *iot_tests_unit_log_message(uint32_t index) {
+	const char *pMessage = strstr(lines[index], " L#");
+
+	CHECK_C(NULL != pMessage);
+	return strchr(pMessage + 1, ' ') + 1;
+}
+
+/* Logs from a single call site */
+static void iot_tests_unit_log_burst(uint32_t count) {
+	uint32_t itr;
+
+	for(itr = 0; itr < count; itr++) {
+		IOT_WARN("burst %u", (unsigned) itr);
+	}
+}
+
+/* Fills a ring, then waits for the other threads so that all of them hold a ring at once */
+static void *iot_tests_unit_log_thread(void *pArg) {
+	(void) pArg;
+
+	iot_tests_unit_log_burst(AWS_IOT_LOG_RING_RECORDS);
+	(void) pthread_barrier_wait(&threadsBarrier);
+	return NULL;
+}
+
+static void iot_tests_unit_log_run_threads(uint32_t count) {
+	pthread_t threads[AWS_IOT_LOG_MAX_THREADS + 1];
+	uint32_t itr;
+
+	CHECK_C(count <= AWS_IOT_LOG_MAX_THREADS + 1);
+	CHECK_EQUAL_C_INT(0, pthread_barrier_init(&threadsBarrier, NULL, count));
+	for(itr = 0; itr < count; itr++) {
+		CHECK_EQUAL_C_INT(0, pthread_create(&threads[itr], NULL, iot_tests_unit_log_thread, NULL));
+	}
+	for(itr = 0; itr < count; itr++) {
+		CHECK_EQUAL_C_INT(0, pthread_join(threads[itr], NULL));
+	}
+	(void) pthread_barrier_destroy(&threadsBarrier);
+}
+
+TEST_GROUP_C_SETUP(LogTests) {
+	aws_iot_log_set_output(iot_tests_unit_log_output);
+	aws_iot_log_set_level(IOT_LOG_LEVEL_TRACE);
+	aws_iot_log_set_rate_limit(0);
+	(void) aws_iot_log_flush();
+	lineCount = 0;
+}
+
+TEST_GROUP_C_TEARDOWN(LogTests) {
+	(void) aws_iot_log_flush();
+	aws_iot_log_set_output(NULL);
+	aws_iot_log_set_rate_limit(AWS_IOT_LOG_RATE_LIMIT);
+}
+
+/* L:1 - Records are formatted when flushed, with strings copied when logged */
+TEST_C(LogTests, FormattedOnFlush) {
+	char topic[] = "sdk/Test/one";
+
+	IOT_WARN("Message on %.*s, rc %d", 8, topic, -2);
+	IOT_INFO("Info %s", topic);
+	/* The logger kept its own copy */
+	memset(topic, 'x', sizeof(topic) - 1);
+	CHECK_EQUAL_C_INT(0, lineCount);
+
+	CHECK_EQUAL_C_INT(2, aws_iot_log_flush());
+	CHECK_EQUAL_C_INT(2, lineCount);
+	CHECK_C(0 == strncmp("WARN:  ", lines[0], 7));
+	CHECK_EQUAL_C_STRING("Message on sdk/Test, rc -2\n", iot_tests_unit_log_message(0));
+	/* Info messages have no prefix */
+	CHECK_EQUAL_C_STRING("Info sdk/Test/one\n", lines[1]);
+
+	CHECK_EQUAL_C_INT(0, aws_iot_log_flush());
+}
+
+/* L:2 - Conversions are formatted as printf does */
+TEST_C(LogTests, ConversionsMatchPrintf) {
+	char expected[LOG_TEST_LINE_LEN];
+	long long big = -1234567890123LL;
+	size_t size = 4096;
+	unsigned char byte = 200;
+	short half = -300;
+	void *pointer = &big;
+
+	IOT_ERROR("[%5d|%-4u|%08x|%#o|%lld|%zu|%hhu|%hd|%c|%%|%*d]", 42, 7u, 0xBEEFu, 8u, big, size, byte, half, 'z',
+			  6, -5);
+	IOT_INFO("[%.3f|%e|%10.2g|%p|%s|%-6s|]", 3.14159, 0.5, 1234.5, pointer, (char *) NULL, "ab");
+	CHECK_EQUAL_C_INT(2, aws_iot_log_flush());
+
+	snprintf(expected, sizeof(expected), "[%5d|%-4u|%08x|%#o|%lld|%zu|%hhu|%hd|%c|%%|%*d]\n", 42, 7u, 0xBEEFu, 8u,
+			 big, size, byte, half, 'z', 6, -5);
+	CHECK_EQUAL_C_STRING(expected, iot_tests_unit_log_message(0));
+	snprintf(expected, sizeof(expected), "[%.3f|%e|%10.2g|%p|%s|%-6s|]\n", 3.14159, 0.5, 1234.5, pointer, "(null)",
+			 "ab");
+	CHECK_EQUAL_C_STRING(expected, lines[1]);
+}
+
+/* L:3 - Arguments that do not fit in a record are cut */
+TEST_C(LogTests, LongArgumentsTruncated) {
+	char longString[AWS_IOT_LOG_RECORD_ARGS_LEN * 2];
+
+	memset(longString, 'a', sizeof(longString) - 1);
+	longString[sizeof(longString) - 1] = '\0';
+
+	IOT_INFO("%s|%d", longString, 12);
+	CHECK_EQUAL_C_INT(1, aws_iot_log_flush());
+
+	/* The string is cut to the record, the integer after it is lost */
+	CHECK_EQUAL_C_INT(AWS_IOT_LOG_RECORD_ARGS_LEN - 1, strspn(lines[0], "a"));
+	CHECK_EQUAL_C_STRING("|...\n", lines[0] + AWS_IOT_LOG_RECORD_ARGS_LEN - 1);
+}
+
+/* L:4 - Messages below the runtime level are filtered out */
+TEST_C(LogTests, RuntimeLevelFilter) {
+	aws_iot_log_set_level(IOT_LOG_LEVEL_WARN);
+	IOT_INFO("filtered");
+	IOT_WARN("kept %d", 1);
+	IOT_ERROR("kept %d", 2);
+	CHECK_EQUAL_C_INT(2, aws_iot_log_flush());
+
+	aws_iot_log_set_level(IOT_LOG_LEVEL_NONE);
+	IOT_ERROR("filtered");
+	CHECK_EQUAL_C_INT(0, aws_iot_log_flush());
+	CHECK_EQUAL_C_INT(2, lineCount);
+	CHECK_EQUAL_C_STRING("kept 2\n", iot_tests_unit_log_message(1));
+}
+
+/* L:5 - Each call site is rate limited and reports the suppressed messages */
+TEST_C(LogTests, RateLimitPerCallSite) {
+	aws_iot_log_set_rate_limit(3);
+	iot_tests_unit_log_burst(10);
+	/* Another call site has its own budget */
+	IOT_ERROR("other");
+	CHECK_EQUAL_C_INT(4, aws_iot_log_flush());
+	CHECK_EQUAL_C_STRING("burst 2\n", iot_tests_unit_log_message(2));
+	CHECK_EQUAL_C_STRING("other\n", iot_tests_unit_log_message(3));
+
+	/* The next window reports what the previous one suppressed */
+	usleep(1100000);
+	iot_tests_unit_log_burst(1);
+	CHECK_EQUAL_C_INT(1, aws_iot_log_flush());
+	CHECK_EQUAL_C_STRING("burst 0 [7 similar messages suppressed]\n", iot_tests_unit_log_message(4));
+}
+
+/* L:6 - A full ring drops records without blocking and reports them */
+TEST_C(LogTests, FullRingDropsRecords) {
+	uint32_t itr, droppedCount = aws_iot_log_get_dropped_count();
+
+	for(itr = 0; itr < AWS_IOT_LOG_RING_RECORDS + 3; itr++) {
+		IOT_INFO("record %u", (unsigned) itr);
+	}
+	CHECK_EQUAL_C_INT(droppedCount + 3, aws_iot_log_get_dropped_count());
+
+	CHECK_EQUAL_C_INT(AWS_IOT_LOG_RING_RECORDS, aws_iot_log_flush());
+	CHECK_EQUAL_C_INT(AWS_IOT_LOG_RING_RECORDS + 1, lineCount);
+	CHECK_EQUAL_C_STRING("record 0\n", lines[0]);
+	CHECK_EQUAL_C_STRING("WARN:  3 log records dropped, the ring was full\n", lines[AWS_IOT_LOG_RING_RECORDS]);
+
+	/* The ring takes records again once flushed */
+	IOT_INFO("after");
+	CHECK_EQUAL_C_INT(1, aws_iot_log_flush());
+}
+
+/* L:7 - The ring of a thread is given back when the thread exits */
+TEST_C(LogTests, RingsGivenBackOnThreadExit) {
+	uint32_t round, droppedCount = aws_iot_log_get_dropped_count();
+
+	/* The test thread holds a ring, the threads take the others and the shared ring */
+	IOT_INFO("main");
+	CHECK_EQUAL_C_INT(1, aws_iot_log_flush());
+
+	for(round = 0; round < 3; round++) {
+		lineCount = 0;
+		iot_tests_unit_log_run_threads(AWS_IOT_LOG_MAX_THREADS);
+		CHECK_EQUAL_C_INT(AWS_IOT_LOG_MAX_THREADS * AWS_IOT_LOG_RING_RECORDS, aws_iot_log_flush());
+		CHECK_EQUAL_C_INT(AWS_IOT_LOG_MAX_THREADS * AWS_IOT_LOG_RING_RECORDS, lineCount);
+		CHECK_EQUAL_C_INT(droppedCount, aws_iot_log_get_dropped_count());
+	}
+}
+
+/* L:8 - Threads finding no free ring share one, its drops are counted */
+TEST_C(LogTests, ThreadsWithoutRingShareOne) {
+	uint32_t droppedCount = aws_iot_log_get_dropped_count();
+
+	IOT_INFO("main");
+	CHECK_EQUAL_C_INT(1, aws_iot_log_flush());
+	lineCount = 0;
+
+	/* Two threads fill the shared ring, the records of one of them do not fit */
+	iot_tests_unit_log_run_threads(AWS_IOT_LOG_MAX_THREADS + 1);
+	CHECK_EQUAL_C_INT(droppedCount + AWS_IOT_LOG_RING_RECORDS, aws_iot_log_get_dropped_count());
+	CHECK_EQUAL_C_INT(AWS_IOT_LOG_MAX_THREADS * AWS_IOT_LOG_RING_RECORDS, aws_iot_log_flush());
+	/* With the line reporting the dropped records */
+	CHECK_EQUAL_C_INT(AWS_IOT_LOG_MAX_THREADS * AWS_IOT_LOG_RING_RECORDS + 1, lineCount);
+}
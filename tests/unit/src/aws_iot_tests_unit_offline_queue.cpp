@@ -0,0 +1,42 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file aws_iot_tests_unit_offline_queue.cpp
+ * @brief IoT Client Unit Testing - Offline Queue API Tests
+ */
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness_c.h>
+
+TEST_GROUP_C(OfflineQueueTests){
+	TEST_GROUP_C_SETUP_WRAPPER(OfflineQueueTests)
+	TEST_GROUP_C_TEARDOWN_WRAPPER(OfflineQueueTests)
+};
+
+/* O:1 - Publish while disconnected, queued only when the client reconnects automatically */
+TEST_GROUP_C_WRAPPER(OfflineQueueTests, QueuedOnlyWhileReconnecting)
+/* O:2 - Queued messages published in order after reconnecting, a batch per drain interval */
+TEST_GROUP_C_WRAPPER(OfflineQueueTests, DrainedAfterReconnect)
+/* O:3 - Full queue, oldest messages dropped to make room */
+TEST_GROUP_C_WRAPPER(OfflineQueueTests, FullDropOldest)
+/* O:4 - Full queue, new messages rejected */
+TEST_GROUP_C_WRAPPER(OfflineQueueTests, FullDropNewest)
+/* O:5 - Queued messages recovered by the next run, up to a damaged record */
+TEST_GROUP_C_WRAPPER(OfflineQueueTests, RecoveredAfterRestart)
+/* O:6 - Queued QoS1 messages removed once acknowledged, in order */
+TEST_GROUP_C_WRAPPER(OfflineQueueTests, Qos1KeptUntilPuback)
+/* O:7 - Queued QoS1 message sent again when the connection is lost before its PUBACK */
+TEST_GROUP_C_WRAPPER(OfflineQueueTests, Qos1ResentAfterConnectionLost)
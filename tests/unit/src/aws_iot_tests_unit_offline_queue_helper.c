@@ -0,0 +1,379 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file aws_iot_tests_unit_offline_queue_helper.c
+ * @brief IoT Client Unit Testing - Offline Queue API Tests Helper
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <CppUTest/TestHarness_c.h>
+
+#include "aws_iot_mqtt_client_common_internal.h"
+#include "aws_iot_tests_unit_helper_functions.h"
+#include "aws_iot_tests_unit_mock_tls_params.h"
+#include "aws_iot_log.h"
+
+/* Room for 7 messages of 5 bytes on subTopic */
+#define OFFLINE_QUEUE_TEST_SIZE 256
+
+static IoT_Client_Init_Params initParams;
+static IoT_Client_Connect_Params connectParams;
+static AWS_IoT_Client iotClient;
+static IoT_Publish_Message_Params testPubMsgParams;
+
+static char offlineQueuePath[] = "/tmp/aws_iot_tests_unit_offline_queue";
+static char subTopic[10] = "sdk/Test";
+static uint16_t subTopicLen = 8;
+static char cPayload[10];
+
+static IoT_Error_t iot_tests_unit_offline_queue_publish(int messageNumber) {
+	snprintf(cPayload, sizeof(cPayload), "msg %d", messageNumber);
+	testPubMsgParams.qos = QOS0;
+	testPubMsgParams.isRetained = 0;
+	testPubMsgParams.payload = (void *) cPayload;
+	testPubMsgParams.payloadLen = strlen(cPayload);
+
+	return aws_iot_mqtt_publish(&iotClient, subTopic, subTopicLen, &testPubMsgParams);
+}
+
+static IoT_Error_t iot_tests_unit_offline_queue_publish_qos1(int messageNumber) {
+	snprintf(cPayload, sizeof(cPayload), "msg %d", messageNumber);
+	testPubMsgParams.qos = QOS1;
+	testPubMsgParams.isRetained = 0;
+	testPubMsgParams.payload = (void *) cPayload;
+	testPubMsgParams.payloadLen = strlen(cPayload);
+
+	return aws_iot_mqtt_publish(&iotClient, subTopic, subTopicLen, &testPubMsgParams);
+}
+
+/* Packet identifier of the publishes awaiting a PUBACK, oldest first */
+static uint32_t iot_tests_unit_offline_queue_inflight_ids(uint16_t *pIds) {
+	uint32_t itr, count = 0, pos;
+	InflightPublish *pEntry;
+
+	for(itr = 0; itr < AWS_IOT_MQTT_MAX_INFLIGHT_PUBLISHES; itr++) {
+		pEntry = &(iotClient.clientData.inflightPublishes[itr]);
+		if(pEntry->isFree) {
+			continue;
+		}
+		for(pos = count; 0 < pos && pIds[pos - 1] > pEntry->packetId; pos--) {
+			pIds[pos] = pIds[pos - 1];
+		}
+		pIds[pos] = pEntry->packetId;
+		count++;
+	}
+
+	return count;
+}
+
+static void iot_tests_unit_offline_queue_puback(uint16_t packetId) {
+	IoT_Error_t rc;
+
+	ResetTLSBuffer();
+	setTLSRxBufferForPubackWithId(packetId);
+	rc = aws_iot_mqtt_yield(&iotClient, 20);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+}
+
+static void iot_tests_unit_offline_queue_lose_connection(void) {
+	IoT_Error_t rc;
+
+	setTLSRxBufferForError(NETWORK_SSL_READ_ERROR);
+	rc = aws_iot_mqtt_yield(&iotClient, 20);
+	CHECK_EQUAL_C_INT(NETWORK_ATTEMPTING_RECONNECT, rc);
+	CHECK_EQUAL_C_INT(CLIENT_STATE_PENDING_RECONNECT, aws_iot_mqtt_get_client_state(&iotClient));
+}
+
+static void iot_tests_unit_offline_queue_reconnect(void) {
+	IoT_Error_t rc;
+
+	/* Skip the reconnect delay */
+	countdown_ms(&(iotClient.reconnectDelayTimer), 0);
+	ResetTLSBuffer();
+	setTLSRxBufferForConnack(&connectParams, 0, 0);
+	rc = aws_iot_mqtt_yield(&iotClient, 20);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(true, aws_iot_mqtt_is_client_connected(&iotClient));
+}
+
+static void iot_tests_unit_offline_queue_open(OfflineQueueDropPolicy dropPolicy) {
+	IoT_Error_t rc;
+
+	InitMQTTParamsSetup(&initParams, AWS_IOT_MQTT_HOST, AWS_IOT_MQTT_PORT, true, NULL);
+	initParams.pOfflineQueuePath = offlineQueuePath;
+	initParams.offlineQueueSize = OFFLINE_QUEUE_TEST_SIZE;
+	initParams.offlineQueueDropPolicy = dropPolicy;
+	rc = aws_iot_mqtt_init(&iotClient, &initParams);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	setTLSRxBufferForConnack(&connectParams, 0, 0);
+	rc = aws_iot_mqtt_connect(&iotClient, &connectParams);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	ResetTLSBuffer();
+}
+
+TEST_GROUP_C_SETUP(OfflineQueueTests) {
+	unlink(offlineQueuePath);
+	ConnectMQTTParamsSetup(&connectParams, AWS_IOT_MQTT_CLIENT_ID, (uint16_t) strlen(AWS_IOT_MQTT_CLIENT_ID));
+	iot_tests_unit_offline_queue_open(OFFLINE_QUEUE_DROP_OLDEST);
+}
+
+TEST_GROUP_C_TEARDOWN(OfflineQueueTests) {
+	/* Clean up. Not checking return code here because this is common to all tests.
+	 * A test might have already caused a disconnect by this point.
+	 */
+	IoT_Error_t rc = aws_iot_mqtt_disconnect(&iotClient);
+	IOT_UNUSED(rc);
+
+	(void)aws_iot_mqtt_free(&iotClient);
+	unlink(offlineQueuePath);
+}
+
+/* O:1 - Publish while disconnected, queued only when the client reconnects automatically */
+TEST_C(OfflineQueueTests, QueuedOnlyWhileReconnecting) {
+	IoT_Error_t rc;
+
+	IOT_DEBUG("-->Running Offline Queue Tests - O:1 - Queued only while reconnecting \n");
+
+	/* Connected, sent at once */
+	rc = iot_tests_unit_offline_queue_publish(1);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(0, aws_iot_mqtt_get_offline_message_count(&iotClient));
+
+	/* Disconnected by the application, no reconnect to wait for */
+	rc = aws_iot_mqtt_disconnect(&iotClient);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	rc = iot_tests_unit_offline_queue_publish(2);
+	CHECK_EQUAL_C_INT(NETWORK_DISCONNECTED_ERROR, rc);
+	CHECK_EQUAL_C_INT(0, aws_iot_mqtt_get_offline_message_count(&iotClient));
+
+	setTLSRxBufferForConnack(&connectParams, 0, 0);
+	rc = aws_iot_mqtt_connect(&iotClient, &connectParams);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	iot_tests_unit_offline_queue_lose_connection();
+	rc = iot_tests_unit_offline_queue_publish(3);
+	CHECK_EQUAL_C_INT(MQTT_PUBLISH_QUEUED_OFFLINE, rc);
+	CHECK_EQUAL_C_INT(1, aws_iot_mqtt_get_offline_message_count(&iotClient));
+
+	IOT_DEBUG("-->Success - O:1 - Queued only while reconnecting \n");
+}
+
+/* O:2 - Queued messages published in order after reconnecting, a batch per drain interval */
+TEST_C(OfflineQueueTests, DrainedAfterReconnect) {
+	IoT_Error_t rc;
+	int itr;
+
+	IOT_DEBUG("-->Running Offline Queue Tests - O:2 - Drained after reconnect \n");
+
+	iot_tests_unit_offline_queue_lose_connection();
+	for(itr = 1; itr <= 3; itr++) {
+		rc = iot_tests_unit_offline_queue_publish(itr);
+		CHECK_EQUAL_C_INT(MQTT_PUBLISH_QUEUED_OFFLINE, rc);
+	}
+	CHECK_EQUAL_C_INT(3, aws_iot_mqtt_get_offline_message_count(&iotClient));
+
+	/* First batch right after the CONNACK */
+	iot_tests_unit_offline_queue_reconnect();
+	CHECK_EQUAL_C_INT(1, aws_iot_mqtt_get_offline_message_count(&iotClient));
+	CHECK_EQUAL_C_STRING(subTopic, LastPublishMessageTopic);
+	CHECK_EQUAL_C_STRING("msg 2", LastPublishMessagePayload);
+	CHECK_C(0 < aws_iot_mqtt_get_next_deadline_ms(&iotClient));
+	CHECK_C(AWS_IOT_MQTT_OFFLINE_QUEUE_DRAIN_INTERVAL_MS >= aws_iot_mqtt_get_next_deadline_ms(&iotClient));
+
+	/* The rest once the interval has passed */
+	usleep((AWS_IOT_MQTT_OFFLINE_QUEUE_DRAIN_INTERVAL_MS + 10) * 1000);
+	rc = aws_iot_mqtt_yield(&iotClient, 20);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(0, aws_iot_mqtt_get_offline_message_count(&iotClient));
+	CHECK_EQUAL_C_STRING("msg 3", LastPublishMessagePayload);
+
+	IOT_DEBUG("-->Success - O:2 - Drained after reconnect \n");
+}
+
+/* O:3 - Full queue, oldest messages dropped to make room */
+TEST_C(OfflineQueueTests, FullDropOldest) {
+	IoT_Error_t rc;
+	int itr;
+
+	IOT_DEBUG("-->Running Offline Queue Tests - O:3 - Full queue, drop oldest \n");
+
+	iot_tests_unit_offline_queue_lose_connection();
+	for(itr = 1; itr <= 10; itr++) {
+		rc = iot_tests_unit_offline_queue_publish(itr);
+		CHECK_EQUAL_C_INT(MQTT_PUBLISH_QUEUED_OFFLINE, rc);
+	}
+	CHECK_EQUAL_C_INT(7, aws_iot_mqtt_get_offline_message_count(&iotClient));
+
+	/* Messages 4 to 10 are left, 4 and 5 go in the first batch */
+	iot_tests_unit_offline_queue_reconnect();
+	CHECK_EQUAL_C_INT(5, aws_iot_mqtt_get_offline_message_count(&iotClient));
+	CHECK_EQUAL_C_STRING("msg 5", LastPublishMessagePayload);
+
+	IOT_DEBUG("-->Success - O:3 - Full queue, drop oldest \n");
+}
+
+/* O:4 - Full queue, new messages rejected */
+TEST_C(OfflineQueueTests, FullDropNewest) {
+	IoT_Error_t rc;
+	int itr;
+
+	IOT_DEBUG("-->Running Offline Queue Tests - O:4 - Full queue, drop newest \n");
+
+	(void)aws_iot_mqtt_disconnect(&iotClient);
+	(void)aws_iot_mqtt_free(&iotClient);
+	iot_tests_unit_offline_queue_open(OFFLINE_QUEUE_DROP_NEWEST);
+
+	iot_tests_unit_offline_queue_lose_connection();
+	for(itr = 1; itr <= 7; itr++) {
+		rc = iot_tests_unit_offline_queue_publish(itr);
+		CHECK_EQUAL_C_INT(MQTT_PUBLISH_QUEUED_OFFLINE, rc);
+	}
+	rc = iot_tests_unit_offline_queue_publish(8);
+	CHECK_EQUAL_C_INT(MQTT_OFFLINE_QUEUE_FULL_ERROR, rc);
+	CHECK_EQUAL_C_INT(7, aws_iot_mqtt_get_offline_message_count(&iotClient));
+
+	/* Larger than the whole queue */
+	testPubMsgParams.payloadLen = OFFLINE_QUEUE_TEST_SIZE;
+	rc = aws_iot_mqtt_publish(&iotClient, subTopic, subTopicLen, &testPubMsgParams);
+	CHECK_EQUAL_C_INT(MQTT_OFFLINE_QUEUE_FULL_ERROR, rc);
+
+	/* Room again once a batch is sent */
+	iot_tests_unit_offline_queue_reconnect();
+	CHECK_EQUAL_C_STRING("msg 2", LastPublishMessagePayload);
+	iot_tests_unit_offline_queue_lose_connection();
+	rc = iot_tests_unit_offline_queue_publish(9);
+	CHECK_EQUAL_C_INT(MQTT_PUBLISH_QUEUED_OFFLINE, rc);
+	CHECK_EQUAL_C_INT(6, aws_iot_mqtt_get_offline_message_count(&iotClient));
+
+	IOT_DEBUG("-->Success - O:4 - Full queue, drop newest \n");
+}
+
+/* O:5 - Queued messages recovered by the next run, up to a damaged record */
+TEST_C(OfflineQueueTests, RecoveredAfterRestart) {
+	IoT_Error_t rc;
+	int itr;
+	FILE *pFile;
+
+	IOT_DEBUG("-->Running Offline Queue Tests - O:5 - Recovered after restart \n");
+
+	iot_tests_unit_offline_queue_lose_connection();
+	for(itr = 1; itr <= 3; itr++) {
+		rc = iot_tests_unit_offline_queue_publish(itr);
+		CHECK_EQUAL_C_INT(MQTT_PUBLISH_QUEUED_OFFLINE, rc);
+	}
+
+	/* Restart, the messages are sent once connected */
+	(void)aws_iot_mqtt_free(&iotClient);
+	iot_tests_unit_offline_queue_open(OFFLINE_QUEUE_DROP_OLDEST);
+	CHECK_EQUAL_C_INT(3, aws_iot_mqtt_get_offline_message_count(&iotClient));
+	rc = aws_iot_mqtt_yield(&iotClient, 20);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(1, aws_iot_mqtt_get_offline_message_count(&iotClient));
+	CHECK_EQUAL_C_STRING("msg 2", LastPublishMessagePayload);
+
+	/* Damage the last byte of the payload of the remaining message */
+	(void)aws_iot_mqtt_free(&iotClient);
+	pFile = fopen(offlineQueuePath, "r+b");
+	CHECK_C(NULL != pFile);
+	CHECK_EQUAL_C_INT(0, fseek(pFile, 16 + 64 + 16 + 8 + 4, SEEK_SET));
+	CHECK_EQUAL_C_INT('3', fgetc(pFile));
+	CHECK_EQUAL_C_INT(0, fseek(pFile, -1, SEEK_CUR));
+	CHECK_EQUAL_C_INT('4', fputc('4', pFile));
+	fclose(pFile);
+
+	iot_tests_unit_offline_queue_open(OFFLINE_QUEUE_DROP_OLDEST);
+	CHECK_EQUAL_C_INT(0, aws_iot_mqtt_get_offline_message_count(&iotClient));
+
+	IOT_DEBUG("-->Success - O:5 - Recovered after restart \n");
+}
+
+/* O:6 - Queued QoS1 messages removed once acknowledged, in order */
+TEST_C(OfflineQueueTests, Qos1KeptUntilPuback) {
+	IoT_Error_t rc;
+	uint16_t ids[AWS_IOT_MQTT_MAX_INFLIGHT_PUBLISHES];
+	int itr;
+
+	IOT_DEBUG("-->Running Offline Queue Tests - O:6 - QoS1 kept until PUBACK \n");
+
+	iot_tests_unit_offline_queue_lose_connection();
+	for(itr = 1; itr <= 3; itr++) {
+		rc = iot_tests_unit_offline_queue_publish_qos1(itr);
+		CHECK_EQUAL_C_INT(MQTT_PUBLISH_QUEUED_OFFLINE, rc);
+	}
+
+	/* Sent, but still queued until acknowledged */
+	iot_tests_unit_offline_queue_reconnect();
+	CHECK_EQUAL_C_STRING("msg 2", LastPublishMessagePayload);
+	CHECK_EQUAL_C_INT(2, iot_tests_unit_offline_queue_inflight_ids(ids));
+	CHECK_EQUAL_C_INT(3, aws_iot_mqtt_get_offline_message_count(&iotClient));
+
+	/* Acknowledged out of order, kept behind the first one */
+	iot_tests_unit_offline_queue_puback(ids[1]);
+	CHECK_EQUAL_C_INT(3, aws_iot_mqtt_get_offline_message_count(&iotClient));
+	iot_tests_unit_offline_queue_puback(ids[0]);
+	CHECK_EQUAL_C_INT(1, aws_iot_mqtt_get_offline_message_count(&iotClient));
+
+	usleep((AWS_IOT_MQTT_OFFLINE_QUEUE_DRAIN_INTERVAL_MS + 10) * 1000);
+	rc = aws_iot_mqtt_yield(&iotClient, 20);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_STRING("msg 3", LastPublishMessagePayload);
+	CHECK_EQUAL_C_INT(1, iot_tests_unit_offline_queue_inflight_ids(ids));
+	CHECK_EQUAL_C_INT(1, aws_iot_mqtt_get_offline_message_count(&iotClient));
+	CHECK_EQUAL_C_INT(AWS_IOT_MQTT_NO_DEADLINE, aws_iot_mqtt_internal_offline_queue_deadline_ms(&iotClient));
+
+	iot_tests_unit_offline_queue_puback(ids[0]);
+	CHECK_EQUAL_C_INT(0, aws_iot_mqtt_get_offline_message_count(&iotClient));
+
+	IOT_DEBUG("-->Success - O:6 - QoS1 kept until PUBACK \n");
+}
+
+/* O:7 - Queued QoS1 message sent again when the connection is lost before its PUBACK */
+TEST_C(OfflineQueueTests, Qos1ResentAfterConnectionLost) {
+	IoT_Error_t rc;
+	uint16_t ids[AWS_IOT_MQTT_MAX_INFLIGHT_PUBLISHES];
+
+	IOT_DEBUG("-->Running Offline Queue Tests - O:7 - QoS1 resent after connection lost \n");
+
+	iot_tests_unit_offline_queue_lose_connection();
+	rc = iot_tests_unit_offline_queue_publish_qos1(1);
+	CHECK_EQUAL_C_INT(MQTT_PUBLISH_QUEUED_OFFLINE, rc);
+	rc = iot_tests_unit_offline_queue_publish(2);
+	CHECK_EQUAL_C_INT(MQTT_PUBLISH_QUEUED_OFFLINE, rc);
+
+	iot_tests_unit_offline_queue_reconnect();
+	CHECK_EQUAL_C_STRING("msg 2", LastPublishMessagePayload);
+	CHECK_EQUAL_C_INT(2, aws_iot_mqtt_get_offline_message_count(&iotClient));
+
+	/* Lost before the PUBACK, the QoS0 message behind it is not sent twice */
+	iot_tests_unit_offline_queue_lose_connection();
+	CHECK_EQUAL_C_INT(0, iot_tests_unit_offline_queue_inflight_ids(ids));
+	CHECK_EQUAL_C_INT(2, aws_iot_mqtt_get_offline_message_count(&iotClient));
+	rc = iot_tests_unit_offline_queue_publish(3);
+	CHECK_EQUAL_C_INT(MQTT_PUBLISH_QUEUED_OFFLINE, rc);
+
+	iot_tests_unit_offline_queue_reconnect();
+	CHECK_EQUAL_C_INT(1, iot_tests_unit_offline_queue_inflight_ids(ids));
+	CHECK_EQUAL_C_STRING("msg 3", LastPublishMessagePayload);
+	CHECK_EQUAL_C_INT(3, aws_iot_mqtt_get_offline_message_count(&iotClient));
+
+	iot_tests_unit_offline_queue_puback(ids[0]);
+	CHECK_EQUAL_C_INT(0, aws_iot_mqtt_get_offline_message_count(&iotClient));
+
+	IOT_DEBUG("-->Success - O:7 - QoS1 resent after connection lost \n");
+}
@@ -0,0 +1,40 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file aws_iot_tests_unit_outbound_queue.cpp
+ * @brief IoT Client Unit Testing - Outbound Queue Tests
+ */
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness_c.h>
+
+TEST_GROUP_C(OutboundQueueTests){
+	TEST_GROUP_C_SETUP_WRAPPER(OutboundQueueTests)
+	TEST_GROUP_C_TEARDOWN_WRAPPER(OutboundQueueTests)
+};
+
+/* Q:1 - Committed packets are flushed in the order their slots were claimed */
+TEST_GROUP_C_WRAPPER(OutboundQueueTests, FlushInClaimOrder)
+/* Q:2 - A slot given up with a zero length is skipped */
+TEST_GROUP_C_WRAPPER(OutboundQueueTests, GivenUpSlotSkipped)
+/* Q:3 - No slot can be claimed while the queue is full, slots are reused once flushed */
+TEST_GROUP_C_WRAPPER(OutboundQueueTests, ClaimFailsWhenFull)
+/* Q:4 - Releasing the write buffer sends the packets queued while it was held */
+TEST_GROUP_C_WRAPPER(OutboundQueueTests, UnlockSendsQueuedPackets)
+/* Q:5 - A publish that finds the queue full is written directly, after the queued packets */
+TEST_GROUP_C_WRAPPER(OutboundQueueTests, QueueFullFallsBackInOrder)
+/* Q:6 - A client whose write buffer is not larger than a slot does not queue */
+TEST_GROUP_C_WRAPPER(OutboundQueueTests, SmallWriteBufferBypassesQueue)
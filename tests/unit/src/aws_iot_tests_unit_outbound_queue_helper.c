@@ -0,0 +1,334 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file aws_iot_tests_unit_outbound_queue_helper.c
+ * @brief IoT Client Unit Testing - Outbound Queue Tests Helper
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <CppUTest/TestHarness_c.h>
+
+#include "aws_iot_mqtt_client_interface.h"
+#include "aws_iot_mqtt_client_common_internal.h"
+#include "aws_iot_tests_unit_helper_functions.h"
+#include "aws_iot_tests_unit_mock_tls_params.h"
+#include "aws_iot_log.h"
+
+#define OUTBOUND_QUEUE_TEST_CAPTURE_LEN 4096
+
+static IoT_Client_Init_Params initParams;
+static IoT_Client_Init_Params smallBufInitParams;
+static IoT_Client_Connect_Params connectParams;
+static IoT_Publish_Message_Params testPubMsgParams;
+static AWS_IoT_Client iotClient;
+static AWS_IoT_Client smallBufClient;
+
+static char pubTopic[10] = "sdk/Test";
+static uint16_t pubTopicLen = 8;
+static char payloads[AWS_IOT_MQTT_OUTBOUND_QUEUE_SLOTS + 1][16];
+
+/* Everything written to the network, in order */
+static unsigned char capturedBytes[OUTBOUND_QUEUE_TEST_CAPTURE_LEN];
+static size_t capturedLen;
+static uint32_t capturedWrites;
+
+static IoT_Error_t fallbackPublishRc;
+
+static void iot_tests_unit_outbound_queue_capture(const unsigned char *pBuffer, size_t len) {
+	if(capturedLen + len <= sizeof(capturedBytes)) {
+		memcpy(capturedBytes + capturedLen, pBuffer, len);
+		capturedLen += len;
+	}
+}
+
+static IoT_Error_t iot_tests_unit_outbound_queue_write(Network *pNetwork, unsigned char *pMsg, size_t len,
+														Timer *pTimer, size_t *pWrittenLen) {
+	capturedWrites++;
+	iot_tests_unit_outbound_queue_capture(pMsg, len);
+	return iot_tls_write(pNetwork, pMsg, len, pTimer, pWrittenLen);
+}
+
+static IoT_Error_t iot_tests_unit_outbound_queue_write_vector(Network *pNetwork, NetworkBufferVector *pVector,
+															   size_t vectorCount, Timer *pTimer, size_t *pWrittenLen) {
+	size_t itr;
+
+	capturedWrites++;
+	for(itr = 0; itr < vectorCount; itr++) {
+		iot_tests_unit_outbound_queue_capture(pVector[itr].pBuffer, pVector[itr].len);
+	}
+	return iot_tls_write_vector(pNetwork, pVector, vectorCount, pTimer, pWrittenLen);
+}
+
+static void iot_tests_unit_outbound_queue_connect(AWS_IoT_Client *pClient) {
+	IoT_Error_t rc;
+
+	ResetTLSBuffer();
+	setTLSRxBufferForConnack(&connectParams, 0, 0);
+	rc = aws_iot_mqtt_connect(pClient, &connectParams);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	pClient->networkStack.write = iot_tests_unit_outbound_queue_write;
+	pClient->networkStack.writeVector = iot_tests_unit_outbound_queue_write_vector;
+	capturedLen = 0;
+	capturedWrites = 0;
+}
+
+/* Offset of a payload in the captured bytes, -1 if it was not written */
+static int iot_tests_unit_outbound_queue_find(const char *pPayload) {
+	size_t len = strlen(pPayload);
+	size_t itr;
+
+	for(itr = 0; itr + len <= capturedLen; itr++) {
+		if(0 == memcmp(capturedBytes + itr, pPayload, len)) {
+			return (int) itr;
+		}
+	}
+	return -1;
+}
+
+static IoT_Error_t iot_tests_unit_outbound_queue_publish(AWS_IoT_Client *pClient, uint32_t index) {
+	testPubMsgParams.payload = (void *) payloads[index];
+	testPubMsgParams.payloadLen = strlen(payloads[index]);
+	return aws_iot_mqtt_publish_async(pClient, pubTopic, pubTopicLen, &testPubMsgParams, NULL, NULL);
+}
+
+static void iot_tests_unit_outbound_queue_commit(OutboundSlot *pSlot, unsigned char packetType) {
+	pSlot->packet[0] = packetType;
+	pSlot->packet[1] = 0;
+	aws_iot_mqtt_internal_outbound_queue_commit(pSlot, 2);
+}
+
+static void iot_tests_unit_outbound_queue_flush(void) {
+	IoT_Error_t rc;
+
+	rc = aws_iot_mqtt_internal_lock_write_buffer(&iotClient);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	rc = aws_iot_mqtt_internal_outbound_queue_flush(&iotClient);
+	CHECK_EQUAL_C_INT(SUCCESS, aws_iot_mqtt_internal_unlock_write_buffer(&iotClient, rc));
+}
+
+static void *iot_tests_unit_outbound_queue_fallback_thread(void *pArg) {
+	IOT_UNUSED(pArg);
+	fallbackPublishRc = iot_tests_unit_outbound_queue_publish(&iotClient, AWS_IOT_MQTT_OUTBOUND_QUEUE_SLOTS);
+	return NULL;
+}
+
+TEST_GROUP_C_SETUP(OutboundQueueTests) {
+	IoT_Error_t rc;
+	uint32_t itr;
+
+	InitMQTTParamsSetup(&initParams, AWS_IOT_MQTT_HOST, AWS_IOT_MQTT_PORT, false, NULL);
+	initParams.isBlockOnThreadLockEnabled = true;
+	rc = aws_iot_mqtt_init(&iotClient, &initParams);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	ConnectMQTTParamsSetup(&connectParams, AWS_IOT_MQTT_CLIENT_ID, (uint16_t) strlen(AWS_IOT_MQTT_CLIENT_ID));
+	iot_tests_unit_outbound_queue_connect(&iotClient);
+
+	testPubMsgParams.qos = QOS0;
+	testPubMsgParams.isRetained = 0;
+	for(itr = 0; itr <= AWS_IOT_MQTT_OUTBOUND_QUEUE_SLOTS; itr++) {
+		snprintf(payloads[itr], sizeof(payloads[itr]), "message %u", (unsigned) itr);
+	}
+	fallbackPublishRc = FAILURE;
+}
+
+TEST_GROUP_C_TEARDOWN(OutboundQueueTests) {
+	(void) aws_iot_mqtt_free(&iotClient);
+}
+
+/* Q:1 - Committed packets are flushed in the order their slots were claimed */
+TEST_C(OutboundQueueTests, FlushInClaimOrder) {
+	OutboundSlot *pFirst, *pSecond, *pThird;
+	const unsigned char firstPacket[] = {0xC0, 0x00};
+	const unsigned char allPackets[] = {0xC0, 0x00, 0xD0, 0x00, 0xE0, 0x00};
+
+	IOT_DEBUG("-->Running Outbound Queue Tests - Q:1 - Committed packets are flushed in the order their slots were claimed \n");
+
+	pFirst = aws_iot_mqtt_internal_outbound_queue_claim(&iotClient);
+	pSecond = aws_iot_mqtt_internal_outbound_queue_claim(&iotClient);
+	pThird = aws_iot_mqtt_internal_outbound_queue_claim(&iotClient);
+	CHECK_C(NULL != pFirst && NULL != pSecond && NULL != pThird);
+
+	/* The second packet is still being serialized, the third one waits behind it */
+	iot_tests_unit_outbound_queue_commit(pThird, 0xE0);
+	iot_tests_unit_outbound_queue_commit(pFirst, 0xC0);
+	iot_tests_unit_outbound_queue_flush();
+	CHECK_EQUAL_C_INT(sizeof(firstPacket), capturedLen);
+	CHECK_C(0 == memcmp(firstPacket, capturedBytes, sizeof(firstPacket)));
+
+	/* Both go out together */
+	iot_tests_unit_outbound_queue_commit(pSecond, 0xD0);
+	iot_tests_unit_outbound_queue_flush();
+	CHECK_EQUAL_C_INT(sizeof(allPackets), capturedLen);
+	CHECK_C(0 == memcmp(allPackets, capturedBytes, sizeof(allPackets)));
+	CHECK_EQUAL_C_INT(2, capturedWrites);
+
+	IOT_DEBUG("-->Success - Q:1 - Committed packets are flushed in the order their slots were claimed \n");
+}
+
+/* Q:2 - A slot given up with a zero length is skipped */
+TEST_C(OutboundQueueTests, GivenUpSlotSkipped) {
+	OutboundSlot *pFirst, *pSecond;
+	const unsigned char packet[] = {0xC0, 0x00};
+
+	IOT_DEBUG("-->Running Outbound Queue Tests - Q:2 - A slot given up with a zero length is skipped \n");
+
+	pFirst = aws_iot_mqtt_internal_outbound_queue_claim(&iotClient);
+	pSecond = aws_iot_mqtt_internal_outbound_queue_claim(&iotClient);
+	CHECK_C(NULL != pFirst && NULL != pSecond);
+
+	aws_iot_mqtt_internal_outbound_queue_commit(pFirst, 0);
+	iot_tests_unit_outbound_queue_commit(pSecond, 0xC0);
+	iot_tests_unit_outbound_queue_flush();
+
+	CHECK_EQUAL_C_INT(sizeof(packet), capturedLen);
+	CHECK_C(0 == memcmp(packet, capturedBytes, sizeof(packet)));
+	CHECK_EQUAL_C_INT(1, capturedWrites);
+
+	IOT_DEBUG("-->Success - Q:2 - A slot given up with a zero length is skipped \n");
+}
+
+/* Q:3 - No slot can be claimed while the queue is full, slots are reused once flushed */
+TEST_C(OutboundQueueTests, ClaimFailsWhenFull) {
+	OutboundSlot *pSlots[AWS_IOT_MQTT_OUTBOUND_QUEUE_SLOTS];
+	OutboundSlot *pSlot;
+	uint32_t itr;
+
+	IOT_DEBUG("-->Running Outbound Queue Tests - Q:3 - No slot can be claimed while the queue is full, slots are reused once flushed \n");
+
+	for(itr = 0; itr < AWS_IOT_MQTT_OUTBOUND_QUEUE_SLOTS; itr++) {
+		pSlots[itr] = aws_iot_mqtt_internal_outbound_queue_claim(&iotClient);
+		CHECK_C(NULL != pSlots[itr]);
+	}
+	CHECK_C(NULL == aws_iot_mqtt_internal_outbound_queue_claim(&iotClient));
+
+	/* Committed but not flushed, the slots still hold their packets */
+	for(itr = 0; itr < AWS_IOT_MQTT_OUTBOUND_QUEUE_SLOTS; itr++) {
+		iot_tests_unit_outbound_queue_commit(pSlots[itr], 0xC0);
+	}
+	CHECK_C(NULL == aws_iot_mqtt_internal_outbound_queue_claim(&iotClient));
+
+	iot_tests_unit_outbound_queue_flush();
+	CHECK_EQUAL_C_INT(2 * AWS_IOT_MQTT_OUTBOUND_QUEUE_SLOTS, capturedLen);
+
+	pSlot = aws_iot_mqtt_internal_outbound_queue_claim(&iotClient);
+	CHECK_C(pSlots[0] == pSlot);
+	aws_iot_mqtt_internal_outbound_queue_commit(pSlot, 0);
+
+	IOT_DEBUG("-->Success - Q:3 - No slot can be claimed while the queue is full, slots are reused once flushed \n");
+}
+
+/* Q:4 - Releasing the write buffer sends the packets queued while it was held */
+TEST_C(OutboundQueueTests, UnlockSendsQueuedPackets) {
+	IoT_Error_t rc;
+
+	IOT_DEBUG("-->Running Outbound Queue Tests - Q:4 - Releasing the write buffer sends the packets queued while it was held \n");
+
+	rc = aws_iot_mqtt_internal_lock_write_buffer(&iotClient);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	/* Left to the holder of the write buffer */
+	rc = iot_tests_unit_outbound_queue_publish(&iotClient, 0);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	rc = iot_tests_unit_outbound_queue_publish(&iotClient, 1);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(0, capturedWrites);
+
+	rc = aws_iot_mqtt_internal_unlock_write_buffer(&iotClient, SUCCESS);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	CHECK_EQUAL_C_INT(1, capturedWrites);
+	CHECK_C(0 <= iot_tests_unit_outbound_queue_find(payloads[0]));
+	CHECK_C(iot_tests_unit_outbound_queue_find(payloads[0]) < iot_tests_unit_outbound_queue_find(payloads[1]));
+
+	IOT_DEBUG("-->Success - Q:4 - Releasing the write buffer sends the packets queued while it was held \n");
+}
+
+/* Q:5 - A publish that finds the queue full is written directly, after the queued packets */
+TEST_C(OutboundQueueTests, QueueFullFallsBackInOrder) {
+	IoT_Error_t rc;
+	pthread_t publishThread;
+	uint32_t itr;
+
+	IOT_DEBUG("-->Running Outbound Queue Tests - Q:5 - A publish that finds the queue full is written directly, after the queued packets \n");
+
+	rc = aws_iot_mqtt_internal_lock_write_buffer(&iotClient);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	for(itr = 0; itr < AWS_IOT_MQTT_OUTBOUND_QUEUE_SLOTS; itr++) {
+		rc = iot_tests_unit_outbound_queue_publish(&iotClient, itr);
+		CHECK_EQUAL_C_INT(SUCCESS, rc);
+	}
+	CHECK_EQUAL_C_INT(0, capturedWrites);
+
+	/* No slot left, this publish waits for the write buffer */
+	CHECK_EQUAL_C_INT(0, pthread_create(&publishThread, NULL, iot_tests_unit_outbound_queue_fallback_thread, NULL));
+	for(itr = 0; itr < 1000 && CLIENT_STATE_CONNECTED_PUBLISH_IN_PROGRESS != aws_iot_mqtt_get_client_state(&iotClient);
+		itr++) {
+		usleep(1000);
+	}
+	usleep(10000);
+	CHECK_EQUAL_C_INT(0, capturedWrites);
+
+	rc = aws_iot_mqtt_internal_unlock_write_buffer(&iotClient, SUCCESS);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(0, pthread_join(publishThread, NULL));
+	CHECK_EQUAL_C_INT(SUCCESS, fallbackPublishRc);
+
+	CHECK_C(0 <= iot_tests_unit_outbound_queue_find(payloads[0]));
+	for(itr = 1; itr <= AWS_IOT_MQTT_OUTBOUND_QUEUE_SLOTS; itr++) {
+		CHECK_C(iot_tests_unit_outbound_queue_find(payloads[itr - 1]) < iot_tests_unit_outbound_queue_find(payloads[itr]));
+	}
+
+	IOT_DEBUG("-->Success - Q:5 - A publish that finds the queue full is written directly, after the queued packets \n");
+}
+
+/* Q:6 - A client whose write buffer is not larger than a slot does not queue */
+TEST_C(OutboundQueueTests, SmallWriteBufferBypassesQueue) {
+	IoT_Error_t rc;
+
+	IOT_DEBUG("-->Running Outbound Queue Tests - Q:6 - A client whose write buffer is not larger than a slot does not queue \n");
+
+	InitMQTTParamsSetup(&smallBufInitParams, AWS_IOT_MQTT_HOST, AWS_IOT_MQTT_PORT, false, NULL);
+	smallBufInitParams.txBufLen = AWS_IOT_MQTT_OUTBOUND_SLOT_LEN;
+	rc = aws_iot_mqtt_init(&smallBufClient, &smallBufInitParams);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	iot_tests_unit_outbound_queue_connect(&smallBufClient);
+
+	rc = aws_iot_mqtt_internal_lock_write_buffer(&smallBufClient);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	/* Not queued, the publish needs the write buffer held above */
+	rc = iot_tests_unit_outbound_queue_publish(&smallBufClient, 0);
+	CHECK_EQUAL_C_INT(MUTEX_LOCK_ERROR, rc);
+
+	rc = aws_iot_mqtt_internal_unlock_write_buffer(&smallBufClient, SUCCESS);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(0, capturedWrites);
+
+	rc = iot_tests_unit_outbound_queue_publish(&smallBufClient, 0);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(1, capturedWrites);
+	CHECK_C(0 <= iot_tests_unit_outbound_queue_find(payloads[0]));
+
+	(void) aws_iot_mqtt_free(&smallBufClient);
+
+	IOT_DEBUG("-->Success - Q:6 - A client whose write buffer is not larger than a slot does not queue \n");
+}
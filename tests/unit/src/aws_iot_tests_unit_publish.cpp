@@ -46,3 +46,27 @@ TEST_GROUP_C_WRAPPER(PublishTests, publishQoS1Success10msDelayedPuback)
 TEST_GROUP_C_WRAPPER(PublishTests, publishQoS0NoPubackSuccess)
 /* E:10 - Publish with QoS1 send success, Puback received */
 TEST_GROUP_C_WRAPPER(PublishTests, publishQoS1Success)
+/* E:11 - Async publish with QoS1 returns before Puback */
+TEST_GROUP_C_WRAPPER(PublishTests, publishAsyncQoS1NoWaitForPuback)
+/* E:12 - Async publish with QoS1, Puback completes the matching message in yield */
+TEST_GROUP_C_WRAPPER(PublishTests, publishAsyncQoS1PubackCorrelation)
+/* E:13 - Async publish with QoS1, in-flight window full */
+TEST_GROUP_C_WRAPPER(PublishTests, publishAsyncQoS1WindowFull)
+/* E:14 - Async publish with QoS1, Puback not received before command timeout */
+TEST_GROUP_C_WRAPPER(PublishTests, publishAsyncQoS1PubackTimeout)
+/* E:15 - Async publish with QoS1, disconnect fails the in-flight messages */
+TEST_GROUP_C_WRAPPER(PublishTests, publishAsyncQoS1AbortedOnDisconnect)
+/* E:16 - Publish with a payload larger than the write buffer */
+TEST_GROUP_C_WRAPPER(PublishTests, publishPayloadLargerThanTxBuffer)
+/* E:17 - Async publish with QoS1 on a persistent session, resent after reconnecting */
+TEST_GROUP_C_WRAPPER(PublishTests, publishAsyncQoS1ResentAfterReconnect)
+/* E:18 - Async publish with QoS1 on a persistent session, failed when reconnecting with a clean session */
+TEST_GROUP_C_WRAPPER(PublishTests, publishAsyncQoS1DroppedByCleanSession)
+/* E:19 - Publish with QoS1 while another thread yields, in-flight window stays full */
+TEST_GROUP_C_WRAPPER(PublishTests, publishQoS1WindowFullWhileYielding)
+/* E:20 - Publish with QoS1 while another thread yields, takes the entry released by a Puback */
+TEST_GROUP_C_WRAPPER(PublishTests, publishQoS1WindowReleasedWhileYielding)
+/* E:21 - Publish with a payload that fits in the write buffer, sent in one write */
+TEST_GROUP_C_WRAPPER(PublishTests, publishSmallPayloadSingleWrite)
+/* E:22 - Publish with QoS1 on a persistent session while another thread yields, resent after reconnecting */
+TEST_GROUP_C_WRAPPER(PublishTests, publishQoS1ResentWhileYielding)
@@ -20,11 +20,16 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/time.h>
 #include <CppUTest/TestHarness_c.h>
 
 #include "aws_iot_mqtt_client_interface.h"
+#include "aws_iot_mqtt_client_common_internal.h"
 #include "aws_iot_tests_unit_helper_functions.h"
 #include "aws_iot_log.h"
+#include "aws_iot_tests_unit_mock_tls_params.h"
 
 static IoT_Client_Init_Params initParams;
 static IoT_Client_Connect_Params connectParams;
@@ -35,6 +40,60 @@ static uint16_t subTopicLen = 8;
 static AWS_IoT_Client iotClient;
 char cPayload[100];
 
+static uint32_t publishCompleteCount;
+static uint16_t publishCompletePacketId;
+static IoT_Error_t publishCompleteStatus;
+
+static void iot_tests_unit_publish_complete_handler(AWS_IoT_Client *pClient, uint16_t packetId, IoT_Error_t status,
+													void *pData) {
+	IOT_UNUSED(pClient);
+	IOT_UNUSED(pData);
+	publishCompleteCount++;
+	publishCompletePacketId = packetId;
+	publishCompleteStatus = status;
+}
+
+static uint32_t yieldThreadTimeoutMs;
+static IoT_Error_t yieldThreadRc;
+
+static void *iot_tests_unit_publish_yield_thread(void *pArg) {
+	IOT_UNUSED(pArg);
+	yieldThreadRc = aws_iot_mqtt_yield(&iotClient, yieldThreadTimeoutMs);
+	return NULL;
+}
+
+/* Read for the client from another thread, the test publishes once the thread yields */
+static void iot_tests_unit_publish_start_yield_thread(pthread_t *pThread, uint32_t timeoutMs) {
+	uint32_t itr;
+
+	yieldThreadTimeoutMs = timeoutMs;
+	yieldThreadRc = FAILURE;
+	CHECK_EQUAL_C_INT(0, pthread_create(pThread, NULL, iot_tests_unit_publish_yield_thread, NULL));
+	for(itr = 0; itr < 1000 && CLIENT_STATE_CONNECTED_YIELD_IN_PROGRESS != aws_iot_mqtt_get_client_state(&iotClient);
+		itr++) {
+		usleep(1000);
+	}
+	CHECK_EQUAL_C_INT(CLIENT_STATE_CONNECTED_YIELD_IN_PROGRESS, aws_iot_mqtt_get_client_state(&iotClient));
+}
+
+/* Called by the yielding thread, answers the blocking publish that took the released entry */
+static void iot_tests_unit_publish_release_handler(AWS_IoT_Client *pClient, uint16_t packetId, IoT_Error_t status,
+												   void *pData) {
+	uint32_t itr, wait;
+
+	iot_tests_unit_publish_complete_handler(pClient, packetId, status, pData);
+
+	for(wait = 0; wait < 1000 && AWS_IOT_MQTT_MAX_INFLIGHT_PUBLISHES != aws_iot_mqtt_get_inflight_publish_count(pClient);
+		wait++) {
+		usleep(1000);
+	}
+	for(itr = 0; itr < AWS_IOT_MQTT_MAX_INFLIGHT_PUBLISHES; itr++) {
+		if(!pClient->clientData.inflightPublishes[itr].isFree && pClient->clientData.inflightPublishes[itr].isWaited) {
+			setTLSRxBufferForPubackWithId(pClient->clientData.inflightPublishes[itr].packetId);
+		}
+	}
+}
+
 TEST_GROUP_C_SETUP(PublishTests) {
 	IoT_Error_t rc = SUCCESS;
 	ResetTLSBuffer();
@@ -55,6 +114,10 @@ TEST_GROUP_C_SETUP(PublishTests) {
 	testPubMsgParams.payload = (void *) cPayload;
 	testPubMsgParams.payloadLen = strlen(cPayload);
 
+	publishCompleteCount = 0;
+	publishCompletePacketId = 0;
+	publishCompleteStatus = FAILURE;
+
 	ResetTLSBuffer();
 }
 
@@ -203,3 +266,414 @@ TEST_C(PublishTests, publishQoS1Success) {
 
 	IOT_DEBUG("-->Success - E:10 - Publish with QoS1 send success, Puback received \n");
 }
+
+/* E:11 - Async publish with QoS1 returns before Puback */
+TEST_C(PublishTests, publishAsyncQoS1NoWaitForPuback) {
+	IoT_Error_t rc = SUCCESS;
+
+	IOT_DEBUG("-->Running Publish Tests - E:11 - Async publish with QoS1 returns before Puback \n");
+
+	testPubMsgParams.id = 0;
+	rc = aws_iot_mqtt_publish_async(&iotClient, subTopic, subTopicLen, &testPubMsgParams,
+									iot_tests_unit_publish_complete_handler, NULL);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_C(0 != testPubMsgParams.id);
+	CHECK_EQUAL_C_INT(1, aws_iot_mqtt_get_inflight_publish_count(&iotClient));
+	CHECK_EQUAL_C_INT(0, publishCompleteCount);
+	CHECK_EQUAL_C_INT(CLIENT_STATE_CONNECTED_IDLE, aws_iot_mqtt_get_client_state(&iotClient));
+
+	IOT_DEBUG("-->Success - E:11 - Async publish with QoS1 returns before Puback \n");
+}
+
+/* E:12 - Async publish with QoS1, Puback completes the matching message in yield */
+TEST_C(PublishTests, publishAsyncQoS1PubackCorrelation) {
+	IoT_Error_t rc = SUCCESS;
+	uint16_t firstId, secondId;
+
+	IOT_DEBUG("-->Running Publish Tests - E:12 - Async publish with QoS1, Puback completes the matching message in yield \n");
+
+	rc = aws_iot_mqtt_publish_async(&iotClient, subTopic, subTopicLen, &testPubMsgParams,
+									iot_tests_unit_publish_complete_handler, NULL);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	firstId = testPubMsgParams.id;
+
+	rc = aws_iot_mqtt_publish_async(&iotClient, subTopic, subTopicLen, &testPubMsgParams,
+									iot_tests_unit_publish_complete_handler, NULL);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	secondId = testPubMsgParams.id;
+	CHECK_C(firstId != secondId);
+	CHECK_EQUAL_C_INT(2, aws_iot_mqtt_get_inflight_publish_count(&iotClient));
+
+	setTLSRxBufferForPubackWithId(secondId);
+	rc = aws_iot_mqtt_yield(&iotClient, 100);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	CHECK_EQUAL_C_INT(1, publishCompleteCount);
+	CHECK_EQUAL_C_INT(secondId, publishCompletePacketId);
+	CHECK_EQUAL_C_INT(SUCCESS, publishCompleteStatus);
+	CHECK_EQUAL_C_INT(1, aws_iot_mqtt_get_inflight_publish_count(&iotClient));
+
+	IOT_DEBUG("-->Success - E:12 - Async publish with QoS1, Puback completes the matching message in yield \n");
+}
+
+/* E:13 - Async publish with QoS1, in-flight window full */
+TEST_C(PublishTests, publishAsyncQoS1WindowFull) {
+	IoT_Error_t rc = SUCCESS;
+	uint32_t itr;
+
+	IOT_DEBUG("-->Running Publish Tests - E:13 - Async publish with QoS1, in-flight window full \n");
+
+	for(itr = 0; itr < AWS_IOT_MQTT_MAX_INFLIGHT_PUBLISHES; itr++) {
+		rc = aws_iot_mqtt_publish_async(&iotClient, subTopic, subTopicLen, &testPubMsgParams, NULL, NULL);
+		CHECK_EQUAL_C_INT(SUCCESS, rc);
+	}
+
+	rc = aws_iot_mqtt_publish_async(&iotClient, subTopic, subTopicLen, &testPubMsgParams, NULL, NULL);
+	CHECK_EQUAL_C_INT(MQTT_MAX_INFLIGHT_PUBLISHES_REACHED_ERROR, rc);
+
+	/* QoS0 does not use the window */
+	testPubMsgParams.qos = QOS0;
+	rc = aws_iot_mqtt_publish_async(&iotClient, subTopic, subTopicLen, &testPubMsgParams, NULL, NULL);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	IOT_DEBUG("-->Success - E:13 - Async publish with QoS1, in-flight window full \n");
+}
+
+/* E:14 - Async publish with QoS1, Puback not received before command timeout */
+TEST_C(PublishTests, publishAsyncQoS1PubackTimeout) {
+	IoT_Error_t rc = SUCCESS;
+
+	IOT_DEBUG("-->Running Publish Tests - E:14 - Async publish with QoS1, Puback not received before command timeout \n");
+
+	iotClient.clientData.commandTimeoutMs = 100;
+	rc = aws_iot_mqtt_publish_async(&iotClient, subTopic, subTopicLen, &testPubMsgParams,
+									iot_tests_unit_publish_complete_handler, NULL);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	rc = aws_iot_mqtt_yield(&iotClient, 300);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	CHECK_EQUAL_C_INT(1, publishCompleteCount);
+	CHECK_EQUAL_C_INT(testPubMsgParams.id, publishCompletePacketId);
+	CHECK_EQUAL_C_INT(MQTT_REQUEST_TIMEOUT_ERROR, publishCompleteStatus);
+	CHECK_EQUAL_C_INT(0, aws_iot_mqtt_get_inflight_publish_count(&iotClient));
+
+	IOT_DEBUG("-->Success - E:14 - Async publish with QoS1, Puback not received before command timeout \n");
+}
+
+/* E:15 - Async publish with QoS1, disconnect fails the in-flight messages */
+TEST_C(PublishTests, publishAsyncQoS1AbortedOnDisconnect) {
+	IoT_Error_t rc = SUCCESS;
+
+	IOT_DEBUG("-->Running Publish Tests - E:15 - Async publish with QoS1, disconnect fails the in-flight messages \n");
+
+	rc = aws_iot_mqtt_publish_async(&iotClient, subTopic, subTopicLen, &testPubMsgParams,
+									iot_tests_unit_publish_complete_handler, NULL);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	rc = aws_iot_mqtt_disconnect(&iotClient);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	CHECK_EQUAL_C_INT(1, publishCompleteCount);
+	CHECK_EQUAL_C_INT(NETWORK_DISCONNECTED_ERROR, publishCompleteStatus);
+	CHECK_EQUAL_C_INT(0, aws_iot_mqtt_get_inflight_publish_count(&iotClient));
+
+	IOT_DEBUG("-->Success - E:15 - Async publish with QoS1, disconnect fails the in-flight messages \n");
+}
+
+/* E:16 - Publish with a payload larger than the write buffer */
+TEST_C(PublishTests, publishPayloadLargerThanTxBuffer) {
+	IoT_Error_t rc = SUCCESS;
+	static char largePayload[AWS_IOT_MQTT_TX_BUF_LEN * 2];
+
+	IOT_DEBUG("-->Running Publish Tests - E:16 - Publish with a payload larger than the write buffer \n");
+
+	memset(largePayload, 'x', sizeof(largePayload) - 1);
+	largePayload[sizeof(largePayload) - 1] = 0;
+	testPubMsgParams.qos = QOS0;
+	testPubMsgParams.payload = (void *) largePayload;
+	testPubMsgParams.payloadLen = strlen(largePayload);
+
+	rc = aws_iot_mqtt_publish(&iotClient, subTopic, subTopicLen, &testPubMsgParams);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_STRING(subTopic, LastPublishMessageTopic);
+	CHECK_EQUAL_C_INT(testPubMsgParams.payloadLen, lastPublishMessagePayloadLen);
+	CHECK_EQUAL_C_STRING(largePayload, LastPublishMessagePayload);
+
+	IOT_DEBUG("-->Success - E:16 - Publish with a payload larger than the write buffer \n");
+}
+
+/* E:17 - Async publish with QoS1 on a persistent session, resent after reconnecting */
+TEST_C(PublishTests, publishAsyncQoS1ResentAfterReconnect) {
+	IoT_Error_t rc = SUCCESS;
+	uint16_t packetId;
+
+	IOT_DEBUG("-->Running Publish Tests - E:17 - Async publish with QoS1 on a persistent session, resent after reconnecting \n");
+
+	rc = aws_iot_mqtt_disconnect(&iotClient);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	connectParams.isCleanSession = false;
+	setTLSRxBufferForConnack(&connectParams, 0, 0);
+	rc = aws_iot_mqtt_connect(&iotClient, &connectParams);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(false, iotClient.clientStatus.isSessionPresent);
+
+	rc = aws_iot_mqtt_publish_async(&iotClient, subTopic, subTopicLen, &testPubMsgParams,
+									iot_tests_unit_publish_complete_handler, NULL);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	packetId = testPubMsgParams.id;
+
+	/* Kept when the connection is lost */
+	rc = aws_iot_mqtt_disconnect(&iotClient);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(0, publishCompleteCount);
+	CHECK_EQUAL_C_INT(1, aws_iot_mqtt_get_inflight_publish_count(&iotClient));
+
+	/* The broker resumed the session, the message is sent again without resubscribing */
+	ResetTLSBuffer();
+	setTLSRxBufferForConnack(&connectParams, 1, 0);
+	rc = aws_iot_mqtt_attempt_reconnect(&iotClient);
+	CHECK_EQUAL_C_INT(NETWORK_RECONNECTED, rc);
+	CHECK_EQUAL_C_INT(true, iotClient.clientStatus.isSessionPresent);
+	CHECK_EQUAL_C_INT(CLIENT_STATE_CONNECTED_IDLE, aws_iot_mqtt_get_client_state(&iotClient));
+	/* QoS1 PUBLISH with the DUP flag */
+	CHECK_EQUAL_C_INT(0x3A, TxBuffer.pBuffer[0]);
+	CHECK_EQUAL_C_STRING(subTopic, LastPublishMessageTopic);
+	CHECK_EQUAL_C_STRING(cPayload, LastPublishMessagePayload);
+
+	setTLSRxBufferForPubackWithId(packetId);
+	rc = aws_iot_mqtt_yield(&iotClient, 100);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	CHECK_EQUAL_C_INT(1, publishCompleteCount);
+	CHECK_EQUAL_C_INT(packetId, publishCompletePacketId);
+	CHECK_EQUAL_C_INT(SUCCESS, publishCompleteStatus);
+	CHECK_EQUAL_C_INT(0, aws_iot_mqtt_get_inflight_publish_count(&iotClient));
+
+	IOT_DEBUG("-->Success - E:17 - Async publish with QoS1 on a persistent session, resent after reconnecting \n");
+}
+
+/* E:18 - Async publish with QoS1 on a persistent session, failed when reconnecting with a clean session */
+TEST_C(PublishTests, publishAsyncQoS1DroppedByCleanSession) {
+	IoT_Error_t rc = SUCCESS;
+
+	IOT_DEBUG("-->Running Publish Tests - E:18 - Async publish with QoS1 on a persistent session, failed when reconnecting with a clean session \n");
+
+	rc = aws_iot_mqtt_disconnect(&iotClient);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	connectParams.isCleanSession = false;
+	setTLSRxBufferForConnack(&connectParams, 0, 0);
+	rc = aws_iot_mqtt_connect(&iotClient, &connectParams);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	rc = aws_iot_mqtt_publish_async(&iotClient, subTopic, subTopicLen, &testPubMsgParams,
+									iot_tests_unit_publish_complete_handler, NULL);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	rc = aws_iot_mqtt_disconnect(&iotClient);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(0, publishCompleteCount);
+
+	connectParams.isCleanSession = true;
+	setTLSRxBufferForConnack(&connectParams, 0, 0);
+	rc = aws_iot_mqtt_connect(&iotClient, &connectParams);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	CHECK_EQUAL_C_INT(1, publishCompleteCount);
+	CHECK_EQUAL_C_INT(NETWORK_DISCONNECTED_ERROR, publishCompleteStatus);
+	CHECK_EQUAL_C_INT(0, aws_iot_mqtt_get_inflight_publish_count(&iotClient));
+
+	IOT_DEBUG("-->Success - E:18 - Async publish with QoS1 on a persistent session, failed when reconnecting with a clean session \n");
+}
+
+/* E:19 - Publish with QoS1 while another thread yields, in-flight window stays full */
+TEST_C(PublishTests, publishQoS1WindowFullWhileYielding) {
+	IoT_Error_t rc = SUCCESS;
+	pthread_t yieldThread;
+	struct timeval start, end, elapsed;
+	uint32_t itr;
+
+	IOT_DEBUG("-->Running Publish Tests - E:19 - Publish with QoS1 while another thread yields, in-flight window stays full \n");
+
+	for(itr = 0; itr < AWS_IOT_MQTT_MAX_INFLIGHT_PUBLISHES; itr++) {
+		rc = aws_iot_mqtt_publish_async(&iotClient, subTopic, subTopicLen, &testPubMsgParams, NULL, NULL);
+		CHECK_EQUAL_C_INT(SUCCESS, rc);
+	}
+
+	iot_tests_unit_publish_start_yield_thread(&yieldThread, 300);
+
+	/* Waits for a free entry until the yielding thread returns the client to idle */
+	gettimeofday(&start, NULL);
+	rc = aws_iot_mqtt_publish(&iotClient, subTopic, subTopicLen, &testPubMsgParams);
+	gettimeofday(&end, NULL);
+	CHECK_EQUAL_C_INT(MQTT_MAX_INFLIGHT_PUBLISHES_REACHED_ERROR, rc);
+
+	CHECK_EQUAL_C_INT(0, pthread_join(yieldThread, NULL));
+	CHECK_EQUAL_C_INT(SUCCESS, yieldThreadRc);
+
+	timersub(&end, &start, &elapsed);
+	CHECK_C(200 <= elapsed.tv_sec * 1000 + elapsed.tv_usec / 1000);
+	CHECK_C(iotClient.clientData.commandTimeoutMs > elapsed.tv_sec * 1000 + elapsed.tv_usec / 1000);
+	CHECK_EQUAL_C_INT(AWS_IOT_MQTT_MAX_INFLIGHT_PUBLISHES, aws_iot_mqtt_get_inflight_publish_count(&iotClient));
+
+	IOT_DEBUG("-->Success - E:19 - Publish with QoS1 while another thread yields, in-flight window stays full \n");
+}
+
+/* E:20 - Publish with QoS1 while another thread yields, takes the entry released by a Puback */
+TEST_C(PublishTests, publishQoS1WindowReleasedWhileYielding) {
+	IoT_Error_t rc = SUCCESS;
+	pthread_t yieldThread;
+	uint16_t firstId;
+	uint32_t itr;
+
+	IOT_DEBUG("-->Running Publish Tests - E:20 - Publish with QoS1 while another thread yields, takes the entry released by a Puback \n");
+
+	rc = aws_iot_mqtt_publish_async(&iotClient, subTopic, subTopicLen, &testPubMsgParams,
+									iot_tests_unit_publish_release_handler, NULL);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	firstId = testPubMsgParams.id;
+	for(itr = 1; itr < AWS_IOT_MQTT_MAX_INFLIGHT_PUBLISHES; itr++) {
+		rc = aws_iot_mqtt_publish_async(&iotClient, subTopic, subTopicLen, &testPubMsgParams, NULL, NULL);
+		CHECK_EQUAL_C_INT(SUCCESS, rc);
+	}
+
+	/* The Puback arrives once the publish below waits for a free entry */
+	setTLSRxBufferForPubackWithId(firstId);
+	setTLSRxBufferDelay(0, 100000);
+	iot_tests_unit_publish_start_yield_thread(&yieldThread, 500);
+
+	rc = aws_iot_mqtt_publish(&iotClient, subTopic, subTopicLen, &testPubMsgParams);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	CHECK_EQUAL_C_INT(0, pthread_join(yieldThread, NULL));
+	CHECK_EQUAL_C_INT(SUCCESS, yieldThreadRc);
+
+	CHECK_EQUAL_C_INT(1, publishCompleteCount);
+	CHECK_EQUAL_C_INT(firstId, publishCompletePacketId);
+	CHECK_EQUAL_C_INT(SUCCESS, publishCompleteStatus);
+	CHECK_EQUAL_C_INT(AWS_IOT_MQTT_MAX_INFLIGHT_PUBLISHES - 1, aws_iot_mqtt_get_inflight_publish_count(&iotClient));
+
+	IOT_DEBUG("-->Success - E:20 - Publish with QoS1 while another thread yields, takes the entry released by a Puback \n");
+}
+
+static uint32_t networkWriteCount;
+static uint32_t networkWriteVectorCount;
+
+static IoT_Error_t iot_tests_unit_publish_counted_write(Network *pNetwork, unsigned char *pMsg, size_t len,
+														Timer *pTimer, size_t *pWrittenLen) {
+	networkWriteCount++;
+	return iot_tls_write(pNetwork, pMsg, len, pTimer, pWrittenLen);
+}
+
+static IoT_Error_t iot_tests_unit_publish_counted_write_vector(Network *pNetwork, NetworkBufferVector *pVector,
+															   size_t vectorCount, Timer *pTimer, size_t *pWrittenLen) {
+	networkWriteVectorCount++;
+	return iot_tls_write_vector(pNetwork, pVector, vectorCount, pTimer, pWrittenLen);
+}
+
+/* E:21 - Publish with a payload that fits in the write buffer, sent in one write */
+TEST_C(PublishTests, publishSmallPayloadSingleWrite) {
+	IoT_Error_t rc = SUCCESS;
+	static char mediumPayload[AWS_IOT_MQTT_TX_BUF_LEN / 2];
+	static char largePayload[AWS_IOT_MQTT_TX_BUF_LEN * 2];
+
+	IOT_DEBUG("-->Running Publish Tests - E:21 - Publish with a payload that fits in the write buffer, sent in one write \n");
+
+	iotClient.networkStack.write = iot_tests_unit_publish_counted_write;
+	iotClient.networkStack.writeVector = iot_tests_unit_publish_counted_write_vector;
+	networkWriteCount = 0;
+	networkWriteVectorCount = 0;
+
+	/* Too long for an outbound queue slot, copied behind the header in the write buffer */
+	memset(mediumPayload, 'y', sizeof(mediumPayload) - 1);
+	mediumPayload[sizeof(mediumPayload) - 1] = 0;
+	testPubMsgParams.qos = QOS0;
+	testPubMsgParams.payload = (void *) mediumPayload;
+	testPubMsgParams.payloadLen = strlen(mediumPayload);
+	rc = aws_iot_mqtt_publish(&iotClient, subTopic, subTopicLen, &testPubMsgParams);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(1, networkWriteCount);
+	CHECK_EQUAL_C_INT(0, networkWriteVectorCount);
+	CHECK_EQUAL_C_STRING(mediumPayload, LastPublishMessagePayload);
+
+	/* A payload past the end of the write buffer is still sent in place */
+	memset(largePayload, 'x', sizeof(largePayload) - 1);
+	largePayload[sizeof(largePayload) - 1] = 0;
+	testPubMsgParams.payload = (void *) largePayload;
+	testPubMsgParams.payloadLen = strlen(largePayload);
+	rc = aws_iot_mqtt_publish(&iotClient, subTopic, subTopicLen, &testPubMsgParams);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(1, networkWriteCount);
+	CHECK_EQUAL_C_INT(1, networkWriteVectorCount);
+	CHECK_EQUAL_C_STRING(largePayload, LastPublishMessagePayload);
+
+	IOT_DEBUG("-->Success - E:21 - Publish with a payload that fits in the write buffer, sent in one write \n");
+}
+
+static IoT_Error_t publishThreadRc;
+
+static void *iot_tests_unit_publish_blocking_thread(void *pArg) {
+	IOT_UNUSED(pArg);
+	publishThreadRc = aws_iot_mqtt_publish(&iotClient, subTopic, subTopicLen, &testPubMsgParams);
+	return NULL;
+}
+
+/* E:22 - Publish with QoS1 on a persistent session while another thread yields, resent after reconnecting */
+TEST_C(PublishTests, publishQoS1ResentWhileYielding) {
+	IoT_Error_t rc = SUCCESS;
+	pthread_t yieldThread, publishThread;
+	InflightPublish *pEntry = NULL;
+	uint16_t packetId;
+	uint32_t itr, wait;
+	Timer timer;
+
+	IOT_DEBUG("-->Running Publish Tests - E:22 - Publish with QoS1 on a persistent session while another thread yields, resent after reconnecting \n");
+
+	rc = aws_iot_mqtt_disconnect(&iotClient);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	connectParams.isCleanSession = false;
+	setTLSRxBufferForConnack(&connectParams, 0, 0);
+	rc = aws_iot_mqtt_connect(&iotClient, &connectParams);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	/* The Puback only arrives once the packet was sent again */
+	ResetTLSBuffer();
+	packetId = (uint16_t) (iotClient.clientData.nextPacketId + 1);
+	setTLSRxBufferForPubackWithId(packetId);
+	setTLSRxBufferDelay(0, 300000);
+	iot_tests_unit_publish_start_yield_thread(&yieldThread, 600);
+	publishThreadRc = FAILURE;
+	CHECK_EQUAL_C_INT(0, pthread_create(&publishThread, NULL, iot_tests_unit_publish_blocking_thread, NULL));
+
+	for(wait = 0; wait < 1000 && NULL == pEntry; wait++) {
+		for(itr = 0; itr < iotClient.clientData.inflightPublishCount; itr++) {
+			if(!iotClient.clientData.inflightPublishes[itr].isFree
+			   && 0 < iotClient.clientData.inflightPublishes[itr].storedLen) {
+				pEntry = &(iotClient.clientData.inflightPublishes[itr]);
+			}
+		}
+		usleep(100);
+	}
+	CHECK_C(NULL != pEntry);
+	CHECK_EQUAL_C_INT(packetId, pEntry->packetId);
+	CHECK_C(pEntry->isWaited);
+
+	/* What the yielding thread does on losing the connection and getting a session present CONNACK */
+	aws_iot_mqtt_internal_abort_inflight_publishes(&iotClient, NETWORK_DISCONNECTED_ERROR);
+	CHECK_C(!pEntry->isComplete);
+	init_timer(&timer);
+	countdown_ms(&timer, 1000);
+	rc = aws_iot_mqtt_internal_resend_inflight_publishes(&iotClient, &timer);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	/* QoS1 PUBLISH with the DUP flag */
+	CHECK_EQUAL_C_INT(0x3A, TxBuffer.pBuffer[0]);
+	CHECK_EQUAL_C_STRING(cPayload, LastPublishMessagePayload);
+
+	CHECK_EQUAL_C_INT(0, pthread_join(publishThread, NULL));
+	CHECK_EQUAL_C_INT(SUCCESS, publishThreadRc);
+	CHECK_EQUAL_C_INT(0, pthread_join(yieldThread, NULL));
+	CHECK_EQUAL_C_INT(SUCCESS, yieldThreadRc);
+	CHECK_EQUAL_C_INT(0, aws_iot_mqtt_get_inflight_publish_count(&iotClient));
+
+	IOT_DEBUG("-->Success - E:22 - Publish with QoS1 on a persistent session while another thread yields, resent after reconnecting \n");
+}
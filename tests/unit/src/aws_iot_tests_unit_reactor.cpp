@@ -0,0 +1,40 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file aws_iot_tests_unit_reactor.cpp
+ * @brief IoT Client Unit Testing - Reactor API Tests
+ */
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness_c.h>
+
+TEST_GROUP_C(ReactorTests){
+	TEST_GROUP_C_SETUP_WRAPPER(ReactorTests)
+	TEST_GROUP_C_TEARDOWN_WRAPPER(ReactorTests)
+};
+
+/* R:1 - Register with null parameters, twice, and beyond the maximum number of clients */
+TEST_GROUP_C_WRAPPER(ReactorTests, RegisterInvalid)
+/* R:2 - Message processed once the client socket is readable */
+TEST_GROUP_C_WRAPPER(ReactorTests, MessageOnReadableSocket)
+/* R:3 - Ping request sent from the timer heap, without socket activity */
+TEST_GROUP_C_WRAPPER(ReactorTests, PingRequestAtDeadline)
+/* R:4 - Ping response timeout reported to the event handler, client no longer waited on */
+TEST_GROUP_C_WRAPPER(ReactorTests, DisconnectReportedToEventHandler)
+/* R:5 - Due reconnect handed to the event handler, not attempted on the reactor thread */
+TEST_GROUP_C_WRAPPER(ReactorTests, ReconnectHandedToApplication)
+TEST_GROUP_C_WRAPPER(ReactorTests, ReusedSocketNotRemoved)
+TEST_GROUP_C_WRAPPER(ReactorTests, ResumeWakesReactor)
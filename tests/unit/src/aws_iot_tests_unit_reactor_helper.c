@@ -0,0 +1,368 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file aws_iot_tests_unit_reactor_helper.c
+ * @brief IoT Client Unit Testing - Reactor API Tests Helper
+ */
+
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <CppUTest/TestHarness_c.h>
+
+#include "aws_iot_tests_unit_helper_functions.h"
+#include "aws_iot_tests_unit_mock_tls_params.h"
+#include "aws_iot_mqtt_reactor.h"
+#include "aws_iot_log.h"
+
+static IoT_Client_Init_Params initParams;
+static IoT_Client_Connect_Params connectParams;
+static AWS_IoT_Client iotClient;
+static AWS_IoT_Client otherClients[AWS_IOT_MQTT_REACTOR_MAX_CLIENTS];
+static AWS_IoT_Reactor reactor;
+static IoT_Publish_Message_Params testPubMsgParams;
+
+static int socketPipe[2];
+static char CallbackMsgString[100];
+static char subTopic[10] = "sdk/Test";
+static uint16_t subTopicLen = 8;
+
+static IoT_Error_t lastEventRc;
+static uint32_t eventCount;
+
+static void iot_tests_unit_reactor_subscribe_callback_handler(AWS_IoT_Client *pClient, char *topicName,
+															  uint16_t topicNameLen,
+															  IoT_Publish_Message_Params *params, void *pData) {
+	IOT_UNUSED(pClient);
+	IOT_UNUSED(topicName);
+	IOT_UNUSED(topicNameLen);
+	IOT_UNUSED(pData);
+
+	memcpy(CallbackMsgString, params->payload, params->payloadLen);
+}
+
+static void iot_tests_unit_reactor_event_handler(AWS_IoT_Reactor *pReactor, AWS_IoT_Client *pClient,
+												 IoT_Error_t rc, void *pData) {
+	IOT_UNUSED(pReactor);
+	IOT_UNUSED(pClient);
+	IOT_UNUSED(pData);
+
+	lastEventRc = rc;
+	eventCount++;
+}
+
+/* Close the mocked socket as a disconnect does, the next socket gets the same number */
+static void iot_tests_unit_reactor_reopen_socket(void) {
+	int oldPipe[2];
+
+	oldPipe[0] = socketPipe[0];
+	oldPipe[1] = socketPipe[1];
+	close(oldPipe[0]);
+	CHECK_EQUAL_C_INT(0, pipe(socketPipe));
+	close(oldPipe[1]);
+	CHECK_EQUAL_C_INT(oldPipe[0], socketPipe[0]);
+}
+
+TEST_GROUP_C_SETUP(ReactorTests) {
+	IoT_Error_t rc;
+
+	lastEventRc = SUCCESS;
+	eventCount = 0;
+	memset(CallbackMsgString, 0, sizeof(CallbackMsgString));
+
+	/* The reactor waits on the read end of a pipe in place of the mocked socket */
+	CHECK_EQUAL_C_INT(0, pipe(socketPipe));
+	MockSocketFd = socketPipe[0];
+
+	InitMQTTParamsSetup(&initParams, AWS_IOT_MQTT_HOST, AWS_IOT_MQTT_PORT, false, NULL);
+	rc = aws_iot_mqtt_init(&iotClient, &initParams);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	ConnectMQTTParamsSetup(&connectParams, AWS_IOT_MQTT_CLIENT_ID, (uint16_t) strlen(AWS_IOT_MQTT_CLIENT_ID));
+	connectParams.keepAliveIntervalInSec = 1;
+	setTLSRxBufferForConnack(&connectParams, 0, 0);
+	rc = aws_iot_mqtt_connect(&iotClient, &connectParams);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	ResetTLSBuffer();
+
+	rc = aws_iot_mqtt_reactor_init(&reactor);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+}
+
+TEST_GROUP_C_TEARDOWN(ReactorTests) {
+	/* Clean up. Not checking return code here because this is common to all tests.
+	 * A test might have already caused a disconnect by this point.
+	 */
+	IoT_Error_t rc = aws_iot_mqtt_disconnect(&iotClient);
+	IOT_UNUSED(rc);
+
+	aws_iot_mqtt_reactor_destroy(&reactor);
+	MockSocketFd = MOCK_TLS_SOCKET_FD;
+	close(socketPipe[0]);
+	close(socketPipe[1]);
+}
+
+/* R:1 - Register with null parameters, twice, and beyond the maximum number of clients */
+TEST_C(ReactorTests, RegisterInvalid) {
+	IoT_Error_t rc;
+	uint32_t itr;
+
+	IOT_DEBUG("-->Running Reactor Tests - R:1 - Register invalid \n");
+
+	CHECK_EQUAL_C_INT(NULL_VALUE_ERROR, aws_iot_mqtt_reactor_register(NULL, &iotClient, NULL, NULL));
+	CHECK_EQUAL_C_INT(NULL_VALUE_ERROR, aws_iot_mqtt_reactor_register(&reactor, NULL, NULL, NULL));
+	CHECK_EQUAL_C_INT(NULL_VALUE_ERROR, aws_iot_mqtt_reactor_run_once(NULL, 10));
+	CHECK_EQUAL_C_INT(FAILURE, aws_iot_mqtt_reactor_unregister(&reactor, &iotClient));
+
+	rc = aws_iot_mqtt_reactor_register(&reactor, &iotClient, NULL, NULL);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	rc = aws_iot_mqtt_reactor_register(&reactor, &iotClient, NULL, NULL);
+	CHECK_EQUAL_C_INT(FAILURE, rc);
+
+	/* Clients that are not connected take a slot but are not waited on */
+	for(itr = 1; itr < AWS_IOT_MQTT_REACTOR_MAX_CLIENTS; itr++) {
+		rc = aws_iot_mqtt_init(&otherClients[itr], &initParams);
+		CHECK_EQUAL_C_INT(SUCCESS, rc);
+		rc = aws_iot_mqtt_reactor_register(&reactor, &otherClients[itr], NULL, NULL);
+		CHECK_EQUAL_C_INT(SUCCESS, rc);
+	}
+	CHECK_EQUAL_C_INT(1, reactor.timerHeapSize);
+
+	rc = aws_iot_mqtt_init(&otherClients[0], &initParams);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	rc = aws_iot_mqtt_reactor_register(&reactor, &otherClients[0], NULL, NULL);
+	CHECK_EQUAL_C_INT(LIMIT_EXCEEDED_ERROR, rc);
+
+	rc = aws_iot_mqtt_reactor_unregister(&reactor, &iotClient);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(0, reactor.timerHeapSize);
+	rc = aws_iot_mqtt_reactor_register(&reactor, &otherClients[0], NULL, NULL);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	IOT_DEBUG("-->Success - R:1 - Register invalid \n");
+}
+
+/* R:2 - Message processed once the client socket is readable */
+TEST_C(ReactorTests, MessageOnReadableSocket) {
+	IoT_Error_t rc;
+	char expectedCallbackString[] = "0xA5A5A5";
+	char wakeUp = 0;
+	Timer timer;
+
+	IOT_DEBUG("-->Running Reactor Tests - R:2 - Message on readable socket \n");
+
+	testPubMsgParams.qos = QOS0;
+	setTLSRxBufferForSuback(subTopic, subTopicLen, QOS0, testPubMsgParams);
+	rc = aws_iot_mqtt_subscribe(&iotClient, subTopic, subTopicLen, QOS0,
+								iot_tests_unit_reactor_subscribe_callback_handler, NULL);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	rc = aws_iot_mqtt_reactor_register(&reactor, &iotClient, iot_tests_unit_reactor_event_handler, NULL);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	setTLSRxBufferWithMsgOnSubscribedTopic(subTopic, subTopicLen, QOS0, testPubMsgParams, expectedCallbackString);
+	CHECK_EQUAL_C_INT(1, write(socketPipe[1], &wakeUp, 1));
+
+	/* Returns as soon as the socket is readable, well before the keep-alive deadline */
+	init_timer(&timer);
+	countdown_ms(&timer, 500);
+	rc = aws_iot_mqtt_reactor_run_once(&reactor, 5000);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(false, has_timer_expired(&timer));
+	CHECK_EQUAL_C_STRING(expectedCallbackString, CallbackMsgString);
+	CHECK_EQUAL_C_INT(0, eventCount);
+
+	IOT_DEBUG("-->Success - R:2 - Message on readable socket \n");
+}
+
+/* R:3 - Ping request sent from the timer heap, without socket activity */
+TEST_C(ReactorTests, PingRequestAtDeadline) {
+	IoT_Error_t rc;
+
+	IOT_DEBUG("-->Running Reactor Tests - R:3 - Ping request at deadline \n");
+
+	rc = aws_iot_mqtt_reactor_register(&reactor, &iotClient, iot_tests_unit_reactor_event_handler, NULL);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	/* Nothing to do before the keep-alive interval */
+	rc = aws_iot_mqtt_reactor_run_once(&reactor, 100);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(0, TxBuffer.len);
+
+	/* Woken up by the keep-alive deadline, not the timeout */
+	rc = aws_iot_mqtt_reactor_run_once(&reactor, 5000);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(true, isLastTLSTxMessagePingreq());
+	CHECK_EQUAL_C_INT(true, iotClient.clientStatus.isPingOutstanding);
+	CHECK_EQUAL_C_INT(0, eventCount);
+
+	IOT_DEBUG("-->Success - R:3 - Ping request at deadline \n");
+}
+
+/* R:4 - Ping response timeout reported to the event handler, client no longer waited on */
+TEST_C(ReactorTests, DisconnectReportedToEventHandler) {
+	IoT_Error_t rc;
+	int itr;
+
+	IOT_DEBUG("-->Running Reactor Tests - R:4 - Disconnect reported to event handler \n");
+
+	rc = aws_iot_mqtt_reactor_register(&reactor, &iotClient, iot_tests_unit_reactor_event_handler, NULL);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	/* Ping request, then ping response timeout */
+	for(itr = 0; itr < 3 && 0 == eventCount; itr++) {
+		rc = aws_iot_mqtt_reactor_run_once(&reactor, 5000);
+		CHECK_EQUAL_C_INT(SUCCESS, rc);
+	}
+
+	CHECK_EQUAL_C_INT(1, eventCount);
+	CHECK_EQUAL_C_INT(NETWORK_DISCONNECTED_ERROR, lastEventRc);
+	CHECK_EQUAL_C_INT(-1, reactor.clients[0].fd);
+	CHECK_EQUAL_C_INT(0, reactor.timerHeapSize);
+
+	IOT_DEBUG("-->Success - R:4 - Disconnect reported to event handler \n");
+}
+
+/* R:5 - Due reconnect handed to the event handler, not attempted on the reactor thread */
+TEST_C(ReactorTests, ReconnectHandedToApplication) {
+	IoT_Error_t rc;
+	int itr;
+
+	IOT_DEBUG("-->Running Reactor Tests - R:5 - Reconnect handed to application \n");
+
+	rc = aws_iot_mqtt_autoreconnect_set_status(&iotClient, true);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	rc = aws_iot_mqtt_reactor_register(&reactor, &iotClient, iot_tests_unit_reactor_event_handler, NULL);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	/* Ping request, then ping response timeout */
+	for(itr = 0; itr < 3 && 0 == eventCount; itr++) {
+		rc = aws_iot_mqtt_reactor_run_once(&reactor, 5000);
+		CHECK_EQUAL_C_INT(SUCCESS, rc);
+	}
+	CHECK_EQUAL_C_INT(NETWORK_ATTEMPTING_RECONNECT, lastEventRc);
+	CHECK_EQUAL_C_INT(1, reactor.timerHeapSize);
+
+	/* Skip the reconnect delay, a CONNACK is ready but the reactor does not connect */
+	countdown_ms(&(iotClient.reconnectDelayTimer), 0);
+	rc = aws_iot_mqtt_reactor_update(&reactor, &iotClient);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	ResetTLSBuffer();
+	setTLSRxBufferForConnack(&connectParams, 0, 0);
+	rc = aws_iot_mqtt_reactor_run_once(&reactor, 100);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(NETWORK_RECONNECT_DUE, lastEventRc);
+	CHECK_EQUAL_C_INT(CLIENT_STATE_PENDING_RECONNECT, aws_iot_mqtt_get_client_state(&iotClient));
+	CHECK_EQUAL_C_INT(0, reactor.timerHeapSize);
+	CHECK_EQUAL_C_INT(-1, reactor.clients[0].fd);
+
+	/* Parked, not reported again */
+	eventCount = 0;
+	rc = aws_iot_mqtt_reactor_run_once(&reactor, 10);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(0, eventCount);
+
+	/* The application reconnects, then the reactor waits on the new connection */
+	iot_tests_unit_reactor_reopen_socket();
+	rc = aws_iot_mqtt_process_ready(&iotClient);
+	CHECK_EQUAL_C_INT(NETWORK_RECONNECTED, rc);
+	rc = aws_iot_mqtt_reactor_update(&reactor, &iotClient);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(socketPipe[0], reactor.clients[0].fd);
+	CHECK_EQUAL_C_INT(1, reactor.timerHeapSize);
+
+	IOT_DEBUG("-->Success - R:5 - Reconnect handed to application \n");
+}
+
+/* R:6 - Socket number of a disconnected client reused by another client, left waited on */
+TEST_C(ReactorTests, ReusedSocketNotRemoved) {
+	IoT_Error_t rc;
+	struct epoll_event event;
+
+	IOT_DEBUG("-->Running Reactor Tests - R:6 - Reused socket not removed \n");
+
+	rc = aws_iot_mqtt_reactor_register(&reactor, &iotClient, iot_tests_unit_reactor_event_handler, NULL);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(socketPipe[0], reactor.clients[0].fd);
+
+	/* The client disconnects, another client connects with the same socket number */
+	rc = aws_iot_mqtt_disconnect(&iotClient);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	iot_tests_unit_reactor_reopen_socket();
+
+	rc = aws_iot_mqtt_init(&otherClients[1], &initParams);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	setTLSRxBufferForConnack(&connectParams, 0, 0);
+	rc = aws_iot_mqtt_connect(&otherClients[1], &connectParams);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	rc = aws_iot_mqtt_reactor_register(&reactor, &otherClients[1], iot_tests_unit_reactor_event_handler, NULL);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(socketPipe[0], reactor.clients[1].fd);
+
+	/* Updating the disconnected client forgets its socket without removing the other one */
+	rc = aws_iot_mqtt_reactor_update(&reactor, &iotClient);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(-1, reactor.clients[0].fd);
+	event.events = EPOLLIN;
+	event.data.u32 = 1;
+	CHECK_EQUAL_C_INT(0, epoll_ctl(reactor.pollFd, EPOLL_CTL_MOD, socketPipe[0], &event));
+
+	rc = aws_iot_mqtt_disconnect(&otherClients[1]);
+	IOT_UNUSED(rc);
+
+	IOT_DEBUG("-->Success - R:6 - Reused socket not removed \n");
+}
+
+/* R:7 - Resume wakes up the reactor, which waits on the new connection */
+TEST_C(ReactorTests, ResumeWakesReactor) {
+	IoT_Error_t rc;
+	Timer timer;
+
+	IOT_DEBUG("-->Running Reactor Tests - R:7 - Resume wakes reactor \n");
+
+	CHECK_EQUAL_C_INT(NULL_VALUE_ERROR, aws_iot_mqtt_reactor_resume(NULL, &iotClient));
+	CHECK_EQUAL_C_INT(FAILURE, aws_iot_mqtt_reactor_resume(&reactor, &iotClient));
+
+	/* Registered while disconnected, nothing to wait on */
+	rc = aws_iot_mqtt_disconnect(&iotClient);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	iot_tests_unit_reactor_reopen_socket();
+	rc = aws_iot_mqtt_reactor_register(&reactor, &iotClient, iot_tests_unit_reactor_event_handler, NULL);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(-1, reactor.clients[0].fd);
+	CHECK_EQUAL_C_INT(0, reactor.timerHeapSize);
+
+	/* Connected outside of the reactor thread, resumed twice before the reactor runs */
+	setTLSRxBufferForConnack(&connectParams, 0, 0);
+	rc = aws_iot_mqtt_connect(&iotClient, &connectParams);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(SUCCESS, aws_iot_mqtt_reactor_resume(&reactor, &iotClient));
+	CHECK_EQUAL_C_INT(SUCCESS, aws_iot_mqtt_reactor_resume(&reactor, &iotClient));
+	CHECK_EQUAL_C_INT(-1, reactor.clients[0].fd);
+
+	/* Returns as soon as woken up, well before the timeout */
+	init_timer(&timer);
+	countdown_ms(&timer, 500);
+	rc = aws_iot_mqtt_reactor_run_once(&reactor, 5000);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(false, has_timer_expired(&timer));
+	CHECK_EQUAL_C_INT(socketPipe[0], reactor.clients[0].fd);
+	CHECK_EQUAL_C_INT(1, reactor.timerHeapSize);
+	CHECK_EQUAL_C_INT(REACTOR_INDEX_NONE, reactor.firstResume);
+	CHECK_EQUAL_C_INT(0, eventCount);
+
+	IOT_DEBUG("-->Success - R:7 - Resume wakes reactor \n");
+}
@@ -0,0 +1,38 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file aws_iot_tests_unit_reconnect_policy.cpp
+ * @brief IoT Client Unit Testing - Reconnect Policy Tests
+ */
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness_c.h>
+
+TEST_GROUP_C(ReconnectPolicyTests){
+	TEST_GROUP_C_SETUP_WRAPPER(ReconnectPolicyTests)
+	TEST_GROUP_C_TEARDOWN_WRAPPER(ReconnectPolicyTests)
+};
+
+/* R:1 - Decorrelated jitter, first retry at once, later waits within bounds */
+TEST_GROUP_C_WRAPPER(ReconnectPolicyTests, JitterWithinBounds)
+/* R:2 - Decorrelated jitter, sequence depends on the client ID */
+TEST_GROUP_C_WRAPPER(ReconnectPolicyTests, JitterSeededByClientId)
+/* R:3 - Exponential backoff doubles and gives up past the maximum wait */
+TEST_GROUP_C_WRAPPER(ReconnectPolicyTests, ExponentialGivesUp)
+/* R:4 - Reconnect bounds taken from the init params, defaults otherwise */
+TEST_GROUP_C_WRAPPER(ReconnectPolicyTests, BoundsFromInitParams)
+/* R:5 - Custom policy called by yield, giving up stops the reconnect */
+TEST_GROUP_C_WRAPPER(ReconnectPolicyTests, CustomPolicyGivesUp)
@@ -0,0 +1,223 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file aws_iot_tests_unit_reconnect_policy_helper.c
+ * @brief IoT Client Unit Testing - Reconnect Policy Tests Helper
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <CppUTest/TestHarness_c.h>
+
+#include "aws_iot_tests_unit_helper_functions.h"
+#include "aws_iot_tests_unit_mock_tls_params.h"
+#include "aws_iot_log.h"
+
+#define RECONNECT_POLICY_TEST_MIN_WAIT 100
+#define RECONNECT_POLICY_TEST_MAX_WAIT 3000
+#define RECONNECT_POLICY_TEST_DRAWS 200
+
+static IoT_Client_Init_Params initParams;
+static IoT_Client_Connect_Params connectParams;
+static AWS_IoT_Client iotClient;
+
+static uint32_t customPolicyCalls;
+static uint32_t customPolicyAttempts[4];
+static uint32_t customPolicyPreviousWaits[4];
+
+static uint32_t iot_tests_unit_reconnect_policy_custom(AWS_IoT_Client *pClient, uint32_t attempt,
+														uint32_t previousWait_ms) {
+	IOT_UNUSED(pClient);
+
+	if(customPolicyCalls < 4) {
+		customPolicyAttempts[customPolicyCalls] = attempt;
+		customPolicyPreviousWaits[customPolicyCalls] = previousWait_ms;
+	}
+	customPolicyCalls++;
+
+	/* Retry once at once, then give up */
+	return (1 == attempt) ? 0 : AWS_IOT_MQTT_RECONNECT_GIVE_UP;
+}
+
+static void iot_tests_unit_reconnect_policy_connect(char *pClientId, uint32_t minWait_ms, uint32_t maxWait_ms,
+													iot_reconnect_policy policy) {
+	IoT_Error_t rc;
+
+	InitMQTTParamsSetup(&initParams, AWS_IOT_MQTT_HOST, AWS_IOT_MQTT_PORT, true, NULL);
+	initParams.minReconnectWait_ms = minWait_ms;
+	initParams.maxReconnectWait_ms = maxWait_ms;
+	initParams.reconnectPolicy = policy;
+	rc = aws_iot_mqtt_init(&iotClient, &initParams);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	ConnectMQTTParamsSetup(&connectParams, pClientId, (uint16_t) strlen(pClientId));
+	setTLSRxBufferForConnack(&connectParams, 0, 0);
+	rc = aws_iot_mqtt_connect(&iotClient, &connectParams);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	ResetTLSBuffer();
+}
+
+static void iot_tests_unit_reconnect_policy_draw(uint32_t *pWaits, uint32_t count) {
+	uint32_t previousWait = 0;
+	uint32_t itr;
+
+	for(itr = 0; itr < count; itr++) {
+		pWaits[itr] = aws_iot_mqtt_reconnect_policy_decorrelated_jitter(&iotClient, itr + 1, previousWait);
+		previousWait = pWaits[itr];
+	}
+}
+
+TEST_GROUP_C_SETUP(ReconnectPolicyTests) {
+	customPolicyCalls = 0;
+	memset(customPolicyAttempts, 0, sizeof(customPolicyAttempts));
+	memset(customPolicyPreviousWaits, 0, sizeof(customPolicyPreviousWaits));
+	ResetTLSBuffer();
+}
+
+TEST_GROUP_C_TEARDOWN(ReconnectPolicyTests) {
+	/* Clean up. Not checking return code here because this is common to all tests.
+	 * A test might have already caused a disconnect by this point.
+	 */
+	IoT_Error_t rc = aws_iot_mqtt_disconnect(&iotClient);
+	IOT_UNUSED(rc);
+
+	(void)aws_iot_mqtt_free(&iotClient);
+}
+
+/* R:1 - Decorrelated jitter, first retry at once, later waits within bounds */
+TEST_C(ReconnectPolicyTests, JitterWithinBounds) {
+	uint32_t waits[RECONNECT_POLICY_TEST_DRAWS];
+	uint32_t previousWait, upper;
+	bool reachedMax = false;
+	uint32_t itr;
+
+	IOT_DEBUG("-->Running Reconnect Policy Tests - R:1 - Jitter within bounds \n");
+
+	iot_tests_unit_reconnect_policy_connect(AWS_IOT_MQTT_CLIENT_ID, RECONNECT_POLICY_TEST_MIN_WAIT,
+											RECONNECT_POLICY_TEST_MAX_WAIT, NULL);
+	iot_tests_unit_reconnect_policy_draw(waits, RECONNECT_POLICY_TEST_DRAWS);
+
+	CHECK_EQUAL_C_INT(0, waits[0]);
+	for(itr = 1; itr < RECONNECT_POLICY_TEST_DRAWS; itr++) {
+		previousWait = (RECONNECT_POLICY_TEST_MIN_WAIT > waits[itr - 1]) ? RECONNECT_POLICY_TEST_MIN_WAIT : waits[itr - 1];
+		upper = (RECONNECT_POLICY_TEST_MAX_WAIT < previousWait * 3) ? RECONNECT_POLICY_TEST_MAX_WAIT : previousWait * 3;
+		CHECK_C(RECONNECT_POLICY_TEST_MIN_WAIT <= waits[itr]);
+		CHECK_C(upper >= waits[itr]);
+		if(RECONNECT_POLICY_TEST_MAX_WAIT * 2 / 3 < waits[itr]) {
+			reachedMax = true;
+		}
+	}
+	/* Grows towards the maximum wait rather than sticking to the minimum */
+	CHECK_C(reachedMax);
+
+	IOT_DEBUG("-->Success - R:1 - Jitter within bounds \n");
+}
+
+/* R:2 - Decorrelated jitter, sequence depends on the client ID */
+TEST_C(ReconnectPolicyTests, JitterSeededByClientId) {
+	uint32_t firstWaits[16];
+	uint32_t secondWaits[16];
+
+	IOT_DEBUG("-->Running Reconnect Policy Tests - R:2 - Jitter seeded by client ID \n");
+
+	iot_tests_unit_reconnect_policy_connect("device-0001", RECONNECT_POLICY_TEST_MIN_WAIT,
+											RECONNECT_POLICY_TEST_MAX_WAIT, NULL);
+	iot_tests_unit_reconnect_policy_draw(firstWaits, 16);
+	(void)aws_iot_mqtt_disconnect(&iotClient);
+	(void)aws_iot_mqtt_free(&iotClient);
+
+	/* Same client ID, same sequence */
+	iot_tests_unit_reconnect_policy_connect("device-0001", RECONNECT_POLICY_TEST_MIN_WAIT,
+											RECONNECT_POLICY_TEST_MAX_WAIT, NULL);
+	iot_tests_unit_reconnect_policy_draw(secondWaits, 16);
+	CHECK_C(0 == memcmp(firstWaits, secondWaits, sizeof(firstWaits)));
+	(void)aws_iot_mqtt_disconnect(&iotClient);
+	(void)aws_iot_mqtt_free(&iotClient);
+
+	/* Another client ID, another sequence */
+	iot_tests_unit_reconnect_policy_connect("device-0002", RECONNECT_POLICY_TEST_MIN_WAIT,
+											RECONNECT_POLICY_TEST_MAX_WAIT, NULL);
+	iot_tests_unit_reconnect_policy_draw(secondWaits, 16);
+	CHECK_C(0 != memcmp(firstWaits, secondWaits, sizeof(firstWaits)));
+
+	IOT_DEBUG("-->Success - R:2 - Jitter seeded by client ID \n");
+}
+
+/* R:3 - Exponential backoff doubles and gives up past the maximum wait */
+TEST_C(ReconnectPolicyTests, ExponentialGivesUp) {
+	IOT_DEBUG("-->Running Reconnect Policy Tests - R:3 - Exponential gives up \n");
+
+	iot_tests_unit_reconnect_policy_connect(AWS_IOT_MQTT_CLIENT_ID, 1000, 8000,
+											aws_iot_mqtt_reconnect_policy_exponential);
+
+	CHECK_EQUAL_C_INT(1000, aws_iot_mqtt_reconnect_policy_exponential(&iotClient, 1, 0));
+	CHECK_EQUAL_C_INT(2000, aws_iot_mqtt_reconnect_policy_exponential(&iotClient, 2, 1000));
+	CHECK_EQUAL_C_INT(4000, aws_iot_mqtt_reconnect_policy_exponential(&iotClient, 3, 2000));
+	CHECK_EQUAL_C_INT(8000, aws_iot_mqtt_reconnect_policy_exponential(&iotClient, 4, 4000));
+	CHECK_C(AWS_IOT_MQTT_RECONNECT_GIVE_UP == aws_iot_mqtt_reconnect_policy_exponential(&iotClient, 5, 8000));
+
+	IOT_DEBUG("-->Success - R:3 - Exponential gives up \n");
+}
+
+/* R:4 - Reconnect bounds taken from the init params, defaults otherwise */
+TEST_C(ReconnectPolicyTests, BoundsFromInitParams) {
+	IOT_DEBUG("-->Running Reconnect Policy Tests - R:4 - Bounds from init params \n");
+
+	iot_tests_unit_reconnect_policy_connect(AWS_IOT_MQTT_CLIENT_ID, 0, 0, NULL);
+	CHECK_EQUAL_C_INT(AWS_IOT_MQTT_MIN_RECONNECT_WAIT_INTERVAL, iotClient.clientData.minReconnectWaitMs);
+	CHECK_EQUAL_C_INT(AWS_IOT_MQTT_MAX_RECONNECT_WAIT_INTERVAL, iotClient.clientData.maxReconnectWaitMs);
+	CHECK_C(aws_iot_mqtt_reconnect_policy_decorrelated_jitter == iotClient.clientData.reconnectPolicy);
+	(void)aws_iot_mqtt_disconnect(&iotClient);
+	(void)aws_iot_mqtt_free(&iotClient);
+
+	iot_tests_unit_reconnect_policy_connect(AWS_IOT_MQTT_CLIENT_ID, 250, 250, NULL);
+	CHECK_EQUAL_C_INT(250, iotClient.clientData.minReconnectWaitMs);
+	CHECK_EQUAL_C_INT(250, iotClient.clientData.maxReconnectWaitMs);
+	/* Nothing to draw from, always the maximum wait */
+	CHECK_EQUAL_C_INT(250, aws_iot_mqtt_reconnect_policy_decorrelated_jitter(&iotClient, 2, 0));
+	CHECK_EQUAL_C_INT(250, aws_iot_mqtt_reconnect_policy_decorrelated_jitter(&iotClient, 3, 250));
+
+	IOT_DEBUG("-->Success - R:4 - Bounds from init params \n");
+}
+
+/* R:5 - Custom policy called by yield, giving up stops the reconnect */
+TEST_C(ReconnectPolicyTests, CustomPolicyGivesUp) {
+	IoT_Error_t rc;
+
+	IOT_DEBUG("-->Running Reconnect Policy Tests - R:5 - Custom policy gives up \n");
+
+	iot_tests_unit_reconnect_policy_connect(AWS_IOT_MQTT_CLIENT_ID, 0, 0, iot_tests_unit_reconnect_policy_custom);
+
+	/* The immediate retry is refused by the broker */
+	setTLSRxBufferForError(NETWORK_SSL_READ_ERROR);
+	setTLSRxBufferForConnack(&connectParams, 0, 5);
+	rc = aws_iot_mqtt_yield(&iotClient, 100);
+	CHECK_EQUAL_C_INT(NETWORK_RECONNECT_TIMED_OUT_ERROR, rc);
+	CHECK_EQUAL_C_INT(false, aws_iot_mqtt_is_client_connected(&iotClient));
+
+	CHECK_EQUAL_C_INT(2, customPolicyCalls);
+	CHECK_EQUAL_C_INT(1, customPolicyAttempts[0]);
+	CHECK_EQUAL_C_INT(0, customPolicyPreviousWaits[0]);
+	CHECK_EQUAL_C_INT(2, customPolicyAttempts[1]);
+	CHECK_EQUAL_C_INT(0, customPolicyPreviousWaits[1]);
+
+	/* Stays given up */
+	rc = aws_iot_mqtt_yield(&iotClient, 100);
+	CHECK_EQUAL_C_INT(NETWORK_RECONNECT_TIMED_OUT_ERROR, rc);
+	CHECK_EQUAL_C_INT(2, customPolicyCalls);
+
+	IOT_DEBUG("-->Success - R:5 - Custom policy gives up \n");
+}
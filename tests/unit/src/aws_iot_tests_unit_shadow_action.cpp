@@ -49,3 +49,6 @@ TEST_GROUP_C_WRAPPER(ShadowActionTests, NoCallbackForShadowAction)
 TEST_GROUP_C_WRAPPER(ShadowActionTests, GetAndDeleteRequest)
 TEST_GROUP_C_WRAPPER(ShadowActionTests, ExtractClientToken)
 TEST_GROUP_C_WRAPPER(ShadowActionTests, IsReceivedJsonValid)
+TEST_GROUP_C_WRAPPER(ShadowActionTests, AckTopicsSubscribedOnConnect)
+TEST_GROUP_C_WRAPPER(ShadowActionTests, AckTopicsPartiallyRejectedOnConnect)
+TEST_GROUP_C_WRAPPER(ShadowActionTests, PendingAcksAnsweredOutOfOrder)
@@ -80,6 +80,8 @@ TEST_GROUP_C_SETUP(ShadowActionTests) {
 	shadowConnectParams.pMyThingName = AWS_IOT_MY_THING_NAME;
 	shadowConnectParams.pMqttClientId = AWS_IOT_MQTT_CLIENT_ID;
 	shadowConnectParams.mqttClientIdLen = (uint16_t) strlen(AWS_IOT_MQTT_CLIENT_ID);
+	shadowConnectParams.isCleanSession = true;
+	shadowConnectParams.isAckSubscribedOnConnect = false;
 	ConnectMQTTParamsSetup(&connectParams, AWS_IOT_MQTT_CLIENT_ID, (uint16_t) strlen(AWS_IOT_MQTT_CLIENT_ID));
 	setTLSRxBufferForConnack(&connectParams, 0, 0);
 	ret_val = aws_iot_shadow_connect(&client, &shadowConnectParams);
@@ -942,3 +944,153 @@ TEST_C(ShadowActionTests, NoCallbackForShadowAction) {
 
 	IOT_DEBUG("-->Success - No callback for shadow action");
 }
+
+TEST_C(ShadowActionTests, AckTopicsSubscribedOnConnect) {
+	IoT_Error_t ret_val = SUCCESS;
+	char getRequestJson[TEST_JSON_SIZE];
+	IoT_Publish_Message_Params params;
+	unsigned char returnCodes[2] = {0, 0};
+
+	IOT_DEBUG("-->Running Shadow Action Tests - Ack topics subscribed on connect \n");
+
+	ret_val = aws_iot_shadow_disconnect(&client);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+
+	shadowConnectParams.isAckSubscribedOnConnect = true;
+	ResetTLSBuffer();
+	setTLSRxBufferForConnackAndMultiSuback(&connectParams, 0, returnCodes, 2);
+	ret_val = aws_iot_shadow_connect(&client, &shadowConnectParams);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+	/* One SUBSCRIBE for the wildcards of both responses */
+	CHECK_C(NULL != strstr((char *) &(TxBuffer.pBuffer[6]), "$aws/things/" AWS_IOT_MY_THING_NAME "/shadow/+/accepted"));
+
+	/* No SUBACK is queued, the action publishes without subscribing */
+	ResetTLSBuffer();
+	snprintf(jsonFullDocument, 200, "NOT_SENT");
+	aws_iot_shadow_internal_get_request_json(getRequestJson, TEST_JSON_SIZE);
+	ret_val = aws_iot_shadow_internal_action(AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, TEST_JSON_SIZE,
+											 actionCallback, NULL, 4, false);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+	CHECK_EQUAL_C_INT(0x30, TxBuffer.pBuffer[0] & 0xF0);
+
+	params.payloadLen = strlen(TEST_JSON_RESPONSE_FULL_DOCUMENT);
+	params.payload = TEST_JSON_RESPONSE_FULL_DOCUMENT;
+	params.qos = QOS0;
+	setTLSRxBufferWithMsgOnSubscribedTopic(GET_ACCEPTED_TOPIC, strlen(GET_ACCEPTED_TOPIC), QOS0, params,
+										   params.payload);
+	ret_val = aws_iot_shadow_yield(&client, 200);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+	CHECK_EQUAL_C_INT(SHADOW_ACK_ACCEPTED, ackStatusRx);
+	CHECK_EQUAL_C_STRING(TEST_JSON_RESPONSE_FULL_DOCUMENT, jsonFullDocument);
+
+	/* The wildcards stay subscribed after the response, no UNSUBSCRIBE was sent */
+	CHECK_EQUAL_C_INT(0x30, TxBuffer.pBuffer[0] & 0xF0);
+
+	IOT_DEBUG("-->Success - Ack topics subscribed on connect \n");
+}
+
+TEST_C(ShadowActionTests, AckTopicsPartiallyRejectedOnConnect) {
+	IoT_Error_t ret_val = SUCCESS;
+	unsigned char returnCodes[2] = {0, 0x80};
+	uint32_t i;
+
+	IOT_DEBUG("-->Running Shadow Action Tests - Ack topics partially rejected on connect \n");
+
+	ret_val = aws_iot_shadow_disconnect(&client);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+
+	shadowConnectParams.isAckSubscribedOnConnect = true;
+	ResetTLSBuffer();
+	setTLSRxBufferForConnackAndMultiSuback(&connectParams, 0, returnCodes, 2);
+	/* UNSUBACK for the granted wildcard, queued behind the SUBACK */
+	RxBuffer.pBuffer[RxBuffer.len] = (unsigned char) (0xB0);
+	RxBuffer.pBuffer[RxBuffer.len + 1] = (unsigned char) (0x02);
+	RxBuffer.pBuffer[RxBuffer.len + 2] = (unsigned char) (2);
+	RxBuffer.pBuffer[RxBuffer.len + 3] = (unsigned char) (0);
+	RxBuffer.len += 4;
+	ret_val = aws_iot_shadow_connect(&client, &shadowConnectParams);
+	CHECK_EQUAL_C_INT(MQTT_SUBSCRIBE_REJECTED_ERROR, ret_val);
+
+	/* The accepted wildcard was unsubscribed and its handler given back */
+	CHECK_EQUAL_C_INT(0xA0, TxBuffer.pBuffer[0] & 0xF0);
+	CHECK_C(NULL != strstr((char *) &(TxBuffer.pBuffer[6]), "$aws/things/" AWS_IOT_MY_THING_NAME "/shadow/+/accepted"));
+	for(i = 0; i < AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS; i++) {
+		CHECK_C(NULL == client.clientData.messageHandlers[i].topicName
+				|| NULL == strstr(client.clientData.messageHandlers[i].topicName, "/shadow/+/"));
+	}
+
+	IOT_DEBUG("-->Success - Ack topics partially rejected on connect \n");
+}
+
+static void recordStatusCallback(const char *pThingName, ShadowActions_t action, Shadow_Ack_Status_t status,
+								 const char *pReceivedJsonDocument, void *pContextData) {
+	IOT_UNUSED(pThingName);
+	IOT_UNUSED(action);
+	IOT_UNUSED(pReceivedJsonDocument);
+	*((Shadow_Ack_Status_t *) pContextData) = status;
+}
+
+TEST_C(ShadowActionTests, PendingAcksAnsweredOutOfOrder) {
+	IoT_Error_t ret_val = SUCCESS;
+	char getRequestJson[TEST_JSON_SIZE];
+	char responseJson[TEST_JSON_SIZE];
+	Shadow_Ack_Status_t statusRx[MAX_ACKS_TO_COMEIN_AT_ANY_GIVEN_TIME];
+	IoT_Publish_Message_Params params;
+	unsigned char returnCodes[2] = {0, 0};
+	int i;
+
+	IOT_DEBUG("-->Running Shadow Action Tests - Pending acks answered out of order \n");
+
+	ret_val = aws_iot_shadow_disconnect(&client);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+
+	shadowConnectParams.isAckSubscribedOnConnect = true;
+	ResetTLSBuffer();
+	setTLSRxBufferForConnackAndMultiSuback(&connectParams, 0, returnCodes, 2);
+	ret_val = aws_iot_shadow_connect(&client, &shadowConnectParams);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+
+	for(i = 0; i < MAX_ACKS_TO_COMEIN_AT_ANY_GIVEN_TIME; i++) {
+		statusRx[i] = SHADOW_ACK_TIMEOUT;
+		aws_iot_shadow_internal_get_request_json(getRequestJson, TEST_JSON_SIZE);
+		ret_val = aws_iot_shadow_internal_action(AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, TEST_JSON_SIZE,
+												 recordStatusCallback, &statusRx[i], 100, false);
+		CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+	}
+
+	/* Answered last to first, every other one rejected, each response reaches the action with its token */
+	for(i = MAX_ACKS_TO_COMEIN_AT_ANY_GIVEN_TIME - 1; i >= 0; i--) {
+		snprintf(responseJson, TEST_JSON_SIZE, "{\"clientToken\":\"%s-%d\"}", AWS_IOT_MQTT_CLIENT_ID, i);
+		params.payloadLen = strlen(responseJson);
+		params.payload = responseJson;
+		params.qos = QOS0;
+		ResetTLSBuffer();
+		if(0 == i % 2) {
+			setTLSRxBufferWithMsgOnSubscribedTopic(GET_ACCEPTED_TOPIC, strlen(GET_ACCEPTED_TOPIC), QOS0, params,
+												   params.payload);
+		} else {
+			setTLSRxBufferWithMsgOnSubscribedTopic(GET_REJECTED_TOPIC, strlen(GET_REJECTED_TOPIC), QOS0, params,
+												   params.payload);
+		}
+		ret_val = aws_iot_shadow_yield(&client, 100);
+		CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+		CHECK_EQUAL_C_INT((0 == i % 2) ? SHADOW_ACK_ACCEPTED : SHADOW_ACK_REJECTED, statusRx[i]);
+		if(0 < i) {
+			CHECK_EQUAL_C_INT(SHADOW_ACK_TIMEOUT, statusRx[i - 1]);
+		}
+	}
+
+	/* Every record was given back */
+	for(i = 0; i < MAX_ACKS_TO_COMEIN_AT_ANY_GIVEN_TIME; i++) {
+		aws_iot_shadow_internal_get_request_json(getRequestJson, TEST_JSON_SIZE);
+		ret_val = aws_iot_shadow_internal_action(AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, TEST_JSON_SIZE,
+												 recordStatusCallback, &statusRx[i], 100, false);
+		CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+	}
+	aws_iot_shadow_internal_get_request_json(getRequestJson, TEST_JSON_SIZE);
+	ret_val = aws_iot_shadow_internal_action(AWS_IOT_MY_THING_NAME, SHADOW_GET, getRequestJson, TEST_JSON_SIZE,
+											 recordStatusCallback, &statusRx[0], 100, false);
+	CHECK_EQUAL_C_INT(FAILURE, ret_val);
+
+	IOT_DEBUG("-->Success - Pending acks answered out of order \n");
+}
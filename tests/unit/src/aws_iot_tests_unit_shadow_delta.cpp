@@ -30,4 +30,8 @@ TEST_GROUP_C_WRAPPER(ShadowDeltaTest, registerDeltaSuccess)
 TEST_GROUP_C_WRAPPER(ShadowDeltaTest, registerDeltaInt)
 TEST_GROUP_C_WRAPPER(ShadowDeltaTest, registerDeltaIntNoCallback)
 TEST_GROUP_C_WRAPPER(ShadowDeltaTest, DeltaNestedObject)
+TEST_GROUP_C_WRAPPER(ShadowDeltaTest, DeltaDottedKeyPath)
 TEST_GROUP_C_WRAPPER(ShadowDeltaTest, DeltaVersionIgnoreOldVersion)
+TEST_GROUP_C_WRAPPER(ShadowDeltaTest, DeltaMultipleThingsContext)
+TEST_GROUP_C_WRAPPER(ShadowDeltaTest, DeltaRemoveThingContext)
+TEST_GROUP_C_WRAPPER(ShadowDeltaTest, DeltaJsonTokensContext)
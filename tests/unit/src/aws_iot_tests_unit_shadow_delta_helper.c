@@ -65,6 +65,7 @@ TEST_GROUP_C_SETUP(ShadowDeltaTest) {
 	shadowConnectParams.pMyThingName = AWS_IOT_MY_THING_NAME;
 	shadowConnectParams.pMqttClientId = AWS_IOT_MQTT_CLIENT_ID;
 	shadowConnectParams.mqttClientIdLen = (uint16_t) strlen(AWS_IOT_MQTT_CLIENT_ID);
+	shadowConnectParams.isCleanSession = true;
 	ConnectMQTTParamsSetup(&connectParams, AWS_IOT_MQTT_CLIENT_ID, (uint16_t) strlen(AWS_IOT_MQTT_CLIENT_ID));
 	setTLSRxBufferForConnack(&connectParams, 0, 0);
 	ret_val = aws_iot_shadow_connect(&client, &shadowConnectParams);
@@ -207,6 +208,47 @@ TEST_C(ShadowDeltaTest, DeltaNestedObject) {
 }
 
 
+
+TEST_C(ShadowDeltaTest, DeltaDottedKeyPath) {
+	IoT_Error_t ret_val = SUCCESS;
+	IoT_Publish_Message_Params params;
+	jsonStruct_t ledHandler;
+	jsonStruct_t fanHandler;
+	int32_t ledData = 0;
+	int32_t fanData = 0;
+	char deltaJSONString[] = "{\"state\":{\"delta\":{\"fan\":{\"brightness\":3},"
+			"\"led\":{\"brightness\":7}}},\"version\":1}";
+
+	IOT_DEBUG("\n-->Running Shadow Delta Tests - same key under two paths of the delta \n");
+
+	ledHandler.cb = genericCallback;
+	ledHandler.pKey = "led.brightness";
+	ledHandler.type = SHADOW_JSON_INT32;
+	ledHandler.pData = &ledData;
+	ledHandler.dataLength = sizeof(int32_t);
+	fanHandler = ledHandler;
+	fanHandler.pKey = "fan.brightness";
+	fanHandler.pData = &fanData;
+
+	params.payloadLen = strlen(deltaJSONString);
+	params.payload = deltaJSONString;
+	params.qos = QOS0;
+
+	ResetTLSBuffer();
+	setTLSRxBufferForSuback(shadowDeltaTopic, strlen(shadowDeltaTopic), QOS0, params);
+	ret_val = aws_iot_shadow_register_delta(&client, &ledHandler);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+	ret_val = aws_iot_shadow_register_delta(&client, &fanHandler);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+
+	ResetTLSBuffer();
+	setTLSRxBufferWithMsgOnSubscribedTopic(shadowDeltaTopic, strlen(shadowDeltaTopic), QOS0, params, params.payload);
+
+	aws_iot_shadow_yield(&client, 3000);
+	CHECK_EQUAL_C_INT(7, ledData);
+	CHECK_EQUAL_C_INT(3, fanData);
+}
+
 // Send back to back version and ensure a wrong version is ignored with old message enabled
 TEST_C(ShadowDeltaTest, DeltaVersionIgnoreOldVersion) {
 	IoT_Error_t ret_val = SUCCESS;
@@ -322,3 +364,280 @@ TEST_C(ShadowDeltaTest, DeltaVersionIgnoreOldVersion) {
 	aws_iot_shadow_yield(&client, 100);
 	CHECK_EQUAL_C_STRING(sentNestedObjectData, receivedNestedObject);
 }
+
+// Two things of a context carved from an arena, each delta goes to the handlers and version of its own thing
+TEST_C(ShadowDeltaTest, DeltaMultipleThingsContext) {
+	IoT_Error_t ret_val = SUCCESS;
+	static unsigned char arenaRegion[8192];
+	IoT_Client_Arena arena;
+	IoT_Client_Allocator arenaAllocator;
+	ShadowContextParameters_t contextParams = ShadowContextParametersDefault;
+	ShadowContext_t *pContext = NULL;
+	jsonStruct_t doorHandler;
+	jsonStruct_t lampHandler;
+	int32_t doorData = 0;
+	int32_t lampData = 0;
+	char doorDeltaTopic[MAX_SHADOW_TOPIC_LENGTH_BYTES];
+	char lampDeltaTopic[MAX_SHADOW_TOPIC_LENGTH_BYTES];
+	char deltaJSONString[100];
+	IoT_Publish_Message_Params params;
+
+	IOT_DEBUG("\n-->Running Shadow Delta Tests - deltas of two things on one context \n");
+
+	aws_iot_mqtt_arena_init(&arena, arenaRegion, sizeof(arenaRegion));
+	arenaAllocator.allocate = aws_iot_mqtt_arena_allocate;
+	arenaAllocator.release = NULL;
+	arenaAllocator.pContext = &arena;
+	contextParams.pClientId = AWS_IOT_MQTT_CLIENT_ID;
+	contextParams.maxThings = 2;
+	contextParams.maxPendingActions = 2;
+	contextParams.maxDeltaHandlers = 2;
+	contextParams.pAllocator = &arenaAllocator;
+	CHECK_C(0 != aws_iot_shadow_get_context_size(&contextParams));
+	CHECK_C(sizeof(arenaRegion) >= aws_iot_shadow_get_context_size(&contextParams));
+
+	ret_val = aws_iot_shadow_context_init(&pContext, &client, &contextParams);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+
+	doorHandler.cb = genericCallback;
+	doorHandler.pKey = "angle";
+	doorHandler.type = SHADOW_JSON_INT32;
+	doorHandler.pData = &doorData;
+	doorHandler.dataLength = sizeof(int32_t);
+	lampHandler = doorHandler;
+	lampHandler.pData = &lampData;
+
+	snprintf(doorDeltaTopic, MAX_SHADOW_TOPIC_LENGTH_BYTES, SHADOW_DELTA_UPDATE, "door");
+	snprintf(lampDeltaTopic, MAX_SHADOW_TOPIC_LENGTH_BYTES, SHADOW_DELTA_UPDATE, "lamp");
+	params.qos = QOS0;
+
+	ResetTLSBuffer();
+	setTLSRxBufferForSuback(doorDeltaTopic, strlen(doorDeltaTopic), QOS0, params);
+	ret_val = aws_iot_shadow_context_register_delta(pContext, "door", &doorHandler);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+
+	ResetTLSBuffer();
+	setTLSRxBufferForSuback(lampDeltaTopic, strlen(lampDeltaTopic), QOS0, params);
+	ret_val = aws_iot_shadow_context_register_delta(pContext, "lamp", &lampHandler);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+
+	snprintf(deltaJSONString, 100, "{\"state\":{\"delta\":{\"angle\":45}},\"version\":5}");
+	params.payloadLen = strlen(deltaJSONString);
+	params.payload = deltaJSONString;
+
+	ResetTLSBuffer();
+	setTLSRxBufferWithMsgOnSubscribedTopic(lampDeltaTopic, strlen(lampDeltaTopic), QOS0, params, params.payload);
+	aws_iot_shadow_context_yield(pContext, 100);
+	CHECK_EQUAL_C_INT(0, doorData);
+	CHECK_EQUAL_C_INT(45, lampData);
+	CHECK_EQUAL_C_INT(0, aws_iot_shadow_context_get_last_received_version(pContext, "door"));
+	CHECK_EQUAL_C_INT(5, aws_iot_shadow_context_get_last_received_version(pContext, "lamp"));
+
+	/* Older than the version of the lamp, not of the door */
+	snprintf(deltaJSONString, 100, "{\"state\":{\"delta\":{\"angle\":90}},\"version\":2}");
+	params.payloadLen = strlen(deltaJSONString);
+
+	ResetTLSBuffer();
+	setTLSRxBufferWithMsgOnSubscribedTopic(doorDeltaTopic, strlen(doorDeltaTopic), QOS0, params, params.payload);
+	aws_iot_shadow_context_yield(pContext, 100);
+	CHECK_EQUAL_C_INT(90, doorData);
+	CHECK_EQUAL_C_INT(45, lampData);
+	CHECK_EQUAL_C_INT(2, aws_iot_shadow_context_get_last_received_version(pContext, "door"));
+
+	ResetTLSBuffer();
+	setTLSRxBufferWithMsgOnSubscribedTopic(lampDeltaTopic, strlen(lampDeltaTopic), QOS0, params, params.payload);
+	aws_iot_shadow_context_yield(pContext, 100);
+	CHECK_EQUAL_C_INT(45, lampData);
+
+	CHECK_EQUAL_C_INT(SUCCESS, aws_iot_shadow_context_free(pContext));
+}
+
+// Unregistered handlers and removed things give their entries back, a full context takes new ones
+TEST_C(ShadowDeltaTest, DeltaRemoveThingContext) {
+	IoT_Error_t ret_val = SUCCESS;
+	static unsigned char arenaRegion[8192];
+	IoT_Client_Arena arena;
+	IoT_Client_Allocator arenaAllocator;
+	ShadowContextParameters_t contextParams = ShadowContextParametersDefault;
+	ShadowContext_t *pContext = NULL;
+	jsonStruct_t doorHandler;
+	jsonStruct_t lampHandler;
+	jsonStruct_t fanHandler;
+	int32_t doorData = 0;
+	int32_t lampData = 0;
+	int32_t fanData = 0;
+	char doorDeltaTopic[MAX_SHADOW_TOPIC_LENGTH_BYTES];
+	char lampDeltaTopic[MAX_SHADOW_TOPIC_LENGTH_BYTES];
+	char fanDeltaTopic[MAX_SHADOW_TOPIC_LENGTH_BYTES];
+	char deltaJSONString[100];
+	IoT_Publish_Message_Params params;
+
+	IOT_DEBUG("\n-->Running Shadow Delta Tests - remove a thing of a context \n");
+
+	aws_iot_mqtt_arena_init(&arena, arenaRegion, sizeof(arenaRegion));
+	arenaAllocator.allocate = aws_iot_mqtt_arena_allocate;
+	arenaAllocator.release = NULL;
+	arenaAllocator.pContext = &arena;
+	contextParams.pClientId = AWS_IOT_MQTT_CLIENT_ID;
+	contextParams.maxThings = 2;
+	contextParams.maxPendingActions = 2;
+	contextParams.maxDeltaHandlers = 2;
+	contextParams.pAllocator = &arenaAllocator;
+
+	ret_val = aws_iot_shadow_context_init(&pContext, &client, &contextParams);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+
+	doorHandler.cb = genericCallback;
+	doorHandler.pKey = "angle";
+	doorHandler.type = SHADOW_JSON_INT32;
+	doorHandler.pData = &doorData;
+	doorHandler.dataLength = sizeof(int32_t);
+	lampHandler = doorHandler;
+	lampHandler.pData = &lampData;
+	fanHandler = doorHandler;
+	fanHandler.pData = &fanData;
+
+	snprintf(doorDeltaTopic, MAX_SHADOW_TOPIC_LENGTH_BYTES, SHADOW_DELTA_UPDATE, "door");
+	snprintf(lampDeltaTopic, MAX_SHADOW_TOPIC_LENGTH_BYTES, SHADOW_DELTA_UPDATE, "lamp");
+	snprintf(fanDeltaTopic, MAX_SHADOW_TOPIC_LENGTH_BYTES, SHADOW_DELTA_UPDATE, "fan");
+	params.qos = QOS0;
+
+	ResetTLSBuffer();
+	setTLSRxBufferForSuback(doorDeltaTopic, strlen(doorDeltaTopic), QOS0, params);
+	ret_val = aws_iot_shadow_context_register_delta(pContext, "door", &doorHandler);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+
+	ResetTLSBuffer();
+	setTLSRxBufferForSuback(lampDeltaTopic, strlen(lampDeltaTopic), QOS0, params);
+	ret_val = aws_iot_shadow_context_register_delta(pContext, "lamp", &lampHandler);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+
+	/* Both things and both handlers are used */
+	CHECK_EQUAL_C_INT(FAILURE, aws_iot_shadow_context_register_delta(pContext, "fan", &fanHandler));
+
+	CHECK_EQUAL_C_INT(SUCCESS, aws_iot_shadow_context_unregister_delta(pContext, "lamp", &lampHandler));
+	CHECK_EQUAL_C_INT(FAILURE, aws_iot_shadow_context_unregister_delta(pContext, "lamp", &lampHandler));
+	CHECK_EQUAL_C_INT(FAILURE, aws_iot_shadow_context_unregister_delta(pContext, "door", &lampHandler));
+
+	snprintf(deltaJSONString, 100, "{\"state\":{\"delta\":{\"angle\":45}},\"version\":5}");
+	params.payloadLen = strlen(deltaJSONString);
+	params.payload = deltaJSONString;
+
+	/* The lamp is still subscribed and tracks its version, no handler gets its delta */
+	ResetTLSBuffer();
+	setTLSRxBufferWithMsgOnSubscribedTopic(lampDeltaTopic, strlen(lampDeltaTopic), QOS0, params, params.payload);
+	aws_iot_shadow_context_yield(pContext, 100);
+	CHECK_EQUAL_C_INT(0, lampData);
+	CHECK_EQUAL_C_INT(5, aws_iot_shadow_context_get_last_received_version(pContext, "lamp"));
+
+	ResetTLSBuffer();
+	setTLSRxBufferForUnsuback();
+	CHECK_EQUAL_C_INT(SUCCESS, aws_iot_shadow_context_remove_thing(pContext, "door"));
+	CHECK_EQUAL_C_INT(FAILURE, aws_iot_shadow_context_remove_thing(pContext, "door"));
+	CHECK_EQUAL_C_INT(FAILURE, aws_iot_shadow_context_unregister_delta(pContext, "door", &doorHandler));
+
+	/* The fan takes the entries of the door */
+	ResetTLSBuffer();
+	setTLSRxBufferForSuback(fanDeltaTopic, strlen(fanDeltaTopic), QOS0, params);
+	ret_val = aws_iot_shadow_context_register_delta(pContext, "fan", &fanHandler);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+	CHECK_EQUAL_C_INT(SUCCESS, aws_iot_shadow_context_register_delta(pContext, "lamp", &lampHandler));
+
+	ResetTLSBuffer();
+	setTLSRxBufferWithMsgOnSubscribedTopic(fanDeltaTopic, strlen(fanDeltaTopic), QOS0, params, params.payload);
+	aws_iot_shadow_context_yield(pContext, 100);
+	CHECK_EQUAL_C_INT(45, fanData);
+	CHECK_EQUAL_C_INT(0, doorData);
+	CHECK_EQUAL_C_INT(0, lampData);
+	CHECK_EQUAL_C_INT(0, aws_iot_shadow_context_get_last_received_version(pContext, "door"));
+	CHECK_EQUAL_C_INT(5, aws_iot_shadow_context_get_last_received_version(pContext, "fan"));
+
+	CHECK_EQUAL_C_INT(SUCCESS, aws_iot_shadow_context_free(pContext));
+}
+
+// Each context parses into its own tokens, a context with too few tokens drops the document the other handles
+TEST_C(ShadowDeltaTest, DeltaJsonTokensContext) {
+	IoT_Error_t ret_val = SUCCESS;
+	static unsigned char arenaRegion[16384];
+	IoT_Client_Arena arena;
+	IoT_Client_Allocator arenaAllocator;
+	ShadowContextParameters_t smallParams = ShadowContextParametersDefault;
+	ShadowContextParameters_t largeParams;
+	ShadowContext_t *pSmallContext = NULL;
+	ShadowContext_t *pLargeContext = NULL;
+	jsonStruct_t doorHandler;
+	jsonStruct_t lampHandler;
+	int32_t doorData = 0;
+	int32_t lampData = 0;
+	char doorDeltaTopic[MAX_SHADOW_TOPIC_LENGTH_BYTES];
+	char lampDeltaTopic[MAX_SHADOW_TOPIC_LENGTH_BYTES];
+	char deltaJSONString[100];
+	IoT_Publish_Message_Params params;
+
+	IOT_DEBUG("\n-->Running Shadow Delta Tests - JSON tokens of two contexts \n");
+
+	aws_iot_mqtt_arena_init(&arena, arenaRegion, sizeof(arenaRegion));
+	arenaAllocator.allocate = aws_iot_mqtt_arena_allocate;
+	arenaAllocator.release = NULL;
+	arenaAllocator.pContext = &arena;
+	smallParams.pClientId = AWS_IOT_MQTT_CLIENT_ID;
+	smallParams.maxThings = 1;
+	smallParams.maxPendingActions = 1;
+	smallParams.maxDeltaHandlers = 1;
+	smallParams.pAllocator = &arenaAllocator;
+	largeParams = smallParams;
+
+	/* The delta below has 9 tokens */
+	smallParams.maxJsonTokens = 8;
+	largeParams.maxJsonTokens = 9;
+	CHECK_C(aws_iot_shadow_get_context_size(&largeParams) > aws_iot_shadow_get_context_size(&smallParams));
+	largeParams.maxJsonTokens = 0;
+	CHECK_EQUAL_C_INT(0, aws_iot_shadow_get_context_size(&largeParams));
+	largeParams.maxJsonTokens = 9;
+
+	ret_val = aws_iot_shadow_context_init(&pSmallContext, &client, &smallParams);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+	ret_val = aws_iot_shadow_context_init(&pLargeContext, &client, &largeParams);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+
+	doorHandler.cb = genericCallback;
+	doorHandler.pKey = "angle";
+	doorHandler.type = SHADOW_JSON_INT32;
+	doorHandler.pData = &doorData;
+	doorHandler.dataLength = sizeof(int32_t);
+	lampHandler = doorHandler;
+	lampHandler.pData = &lampData;
+
+	snprintf(doorDeltaTopic, MAX_SHADOW_TOPIC_LENGTH_BYTES, SHADOW_DELTA_UPDATE, "door");
+	snprintf(lampDeltaTopic, MAX_SHADOW_TOPIC_LENGTH_BYTES, SHADOW_DELTA_UPDATE, "lamp");
+	params.qos = QOS0;
+
+	ResetTLSBuffer();
+	setTLSRxBufferForSuback(doorDeltaTopic, strlen(doorDeltaTopic), QOS0, params);
+	ret_val = aws_iot_shadow_context_register_delta(pSmallContext, "door", &doorHandler);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+
+	ResetTLSBuffer();
+	setTLSRxBufferForSuback(lampDeltaTopic, strlen(lampDeltaTopic), QOS0, params);
+	ret_val = aws_iot_shadow_context_register_delta(pLargeContext, "lamp", &lampHandler);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+
+	snprintf(deltaJSONString, 100, "{\"state\":{\"delta\":{\"angle\":45}},\"version\":5}");
+	params.payloadLen = strlen(deltaJSONString);
+	params.payload = deltaJSONString;
+
+	ResetTLSBuffer();
+	setTLSRxBufferWithMsgOnSubscribedTopic(doorDeltaTopic, strlen(doorDeltaTopic), QOS0, params, params.payload);
+	aws_iot_shadow_context_yield(pSmallContext, 100);
+	CHECK_EQUAL_C_INT(0, doorData);
+	CHECK_EQUAL_C_INT(0, aws_iot_shadow_context_get_last_received_version(pSmallContext, "door"));
+
+	ResetTLSBuffer();
+	setTLSRxBufferWithMsgOnSubscribedTopic(lampDeltaTopic, strlen(lampDeltaTopic), QOS0, params, params.payload);
+	aws_iot_shadow_context_yield(pLargeContext, 100);
+	CHECK_EQUAL_C_INT(45, lampData);
+	CHECK_EQUAL_C_INT(5, aws_iot_shadow_context_get_last_received_version(pLargeContext, "lamp"));
+
+	CHECK_EQUAL_C_INT(SUCCESS, aws_iot_shadow_context_free(pSmallContext));
+	CHECK_EQUAL_C_INT(SUCCESS, aws_iot_shadow_context_free(pLargeContext));
+}
@@ -29,3 +29,5 @@ TEST_GROUP_C(ShadowJsonBuilderTests){
 TEST_GROUP_C_WRAPPER(ShadowJsonBuilderTests, UpdateTheJSONDocumentBuilder)
 TEST_GROUP_C_WRAPPER(ShadowJsonBuilderTests, PassingNullValue)
 TEST_GROUP_C_WRAPPER(ShadowJsonBuilderTests, SmallBuffer)
+TEST_GROUP_C_WRAPPER(ShadowJsonBuilderTests, WriterNestedDocument)
+TEST_GROUP_C_WRAPPER(ShadowJsonBuilderTests, WriterReportsRequiredSize)
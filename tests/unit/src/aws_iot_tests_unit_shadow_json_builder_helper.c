@@ -51,6 +51,7 @@ TEST_GROUP_C_SETUP(ShadowJsonBuilderTests) {
 	shadowConnectParams.pMyThingName = AWS_IOT_MY_THING_NAME;
 	shadowConnectParams.pMqttClientId = AWS_IOT_MQTT_CLIENT_ID;
 	shadowConnectParams.mqttClientIdLen = (uint16_t) strlen(AWS_IOT_MQTT_CLIENT_ID);
+	shadowConnectParams.isCleanSession = true;
 	ConnectMQTTParamsSetup(&connectParams, AWS_IOT_MQTT_CLIENT_ID, (uint16_t) strlen(AWS_IOT_MQTT_CLIENT_ID));
 	setTLSRxBufferForConnack(&connectParams, 0, 0);
 	ret_val = aws_iot_shadow_connect(&iotClient, &shadowConnectParams);
@@ -129,3 +130,66 @@ TEST_C(ShadowJsonBuilderTests, SmallBuffer) {
 	ret_val = aws_iot_finalize_json_document(updateRequestJson, jsonBufSize);
 	CHECK_EQUAL_C_INT(SHADOW_JSON_ERROR, ret_val);
 }
+
+#define TEST_JSON_WRITER_DOCUMENT "{\"state\":{\"reported\":{\"temp\":-12,\"on\":true,\"name\":\"a \\\"b\\\"\\n\",\"levels\":[1.500000,2]}}}"
+
+static IoT_Error_t writeTestDocument(ShadowJsonWriter_t *pWriter) {
+	aws_iot_shadow_json_writer_begin_object(pWriter, NULL);
+	aws_iot_shadow_json_writer_begin_object(pWriter, "state");
+	aws_iot_shadow_json_writer_begin_object(pWriter, "reported");
+	aws_iot_shadow_json_writer_add_int(pWriter, "temp", -12);
+	aws_iot_shadow_json_writer_add_bool(pWriter, "on", true);
+	aws_iot_shadow_json_writer_add_string(pWriter, "name", "a \"b\"\n");
+	aws_iot_shadow_json_writer_begin_array(pWriter, "levels");
+	aws_iot_shadow_json_writer_add_float(pWriter, NULL, 1.5);
+	aws_iot_shadow_json_writer_add_uint(pWriter, NULL, 2);
+	aws_iot_shadow_json_writer_end_array(pWriter);
+	aws_iot_shadow_json_writer_end_object(pWriter);
+	aws_iot_shadow_json_writer_end_object(pWriter);
+	return aws_iot_shadow_json_writer_end_object(pWriter);
+}
+
+TEST_C(ShadowJsonBuilderTests, WriterNestedDocument) {
+	IoT_Error_t ret_val;
+	ShadowJsonWriter_t writer;
+	char updateRequestJson[SIZE_OF_UPFATE_BUF];
+
+	IOT_DEBUG("\n-->Running Shadow Json Builder Tests - Json writer with nested objects and arrays \n");
+
+	ret_val = aws_iot_shadow_json_writer_init(&writer, updateRequestJson, sizeof(updateRequestJson));
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+	ret_val = writeTestDocument(&writer);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+	CHECK_EQUAL_C_STRING(TEST_JSON_WRITER_DOCUMENT, updateRequestJson);
+
+	/* Nothing is left open */
+	ret_val = aws_iot_shadow_json_writer_end_object(&writer);
+	CHECK_EQUAL_C_INT(SHADOW_JSON_ERROR, ret_val);
+
+	aws_iot_shadow_json_writer_init(&writer, updateRequestJson, sizeof(updateRequestJson));
+	aws_iot_shadow_json_writer_begin_object(&writer, NULL);
+	ret_val = aws_iot_shadow_json_writer_end_array(&writer);
+	CHECK_EQUAL_C_INT(SHADOW_JSON_ERROR, ret_val);
+}
+
+TEST_C(ShadowJsonBuilderTests, WriterReportsRequiredSize) {
+	IoT_Error_t ret_val;
+	ShadowJsonWriter_t writer;
+	char updateRequestJson[SIZE_OF_UPFATE_BUF];
+	size_t requiredSize;
+
+	IOT_DEBUG("\n-->Running Shadow Json Builder Tests - Json writer reports the size of a truncated document \n");
+
+	aws_iot_shadow_json_writer_init(&writer, updateRequestJson, 16);
+	ret_val = writeTestDocument(&writer);
+	CHECK_EQUAL_C_INT(SHADOW_JSON_BUFFER_TRUNCATED, ret_val);
+	CHECK_EQUAL_C_INT(15, strlen(updateRequestJson));
+
+	requiredSize = aws_iot_shadow_json_writer_get_required_size(&writer);
+	CHECK_EQUAL_C_INT(strlen(TEST_JSON_WRITER_DOCUMENT) + 1, requiredSize);
+
+	aws_iot_shadow_json_writer_init(&writer, updateRequestJson, requiredSize);
+	ret_val = writeTestDocument(&writer);
+	CHECK_EQUAL_C_INT(SUCCESS, ret_val);
+	CHECK_EQUAL_C_STRING(TEST_JSON_WRITER_DOCUMENT, updateRequestJson);
+}
@@ -109,6 +109,7 @@ TEST_C(ShadowNullFields, NullClientConnect) {
 	shadowConnectParams.pMyThingName = AWS_IOT_MY_THING_NAME;
 	shadowConnectParams.pMqttClientId = AWS_IOT_MQTT_CLIENT_ID;
 	shadowConnectParams.mqttClientIdLen = (uint16_t) strlen(AWS_IOT_MQTT_CLIENT_ID);
+	shadowConnectParams.isCleanSession = true;
 	rc = aws_iot_shadow_connect(NULL, &shadowConnectParams);
 	CHECK_EQUAL_C_INT(NULL_VALUE_ERROR, rc);
 }
@@ -77,3 +77,19 @@ TEST_GROUP_C_WRAPPER(SubscribeTests, subscribeTopicHashkeyMustBeTheLastFail)
 TEST_GROUP_C_WRAPPER(SubscribeTests, subscribeTopicWithPluskeySuccess)
 /* C:22 - Subscribe with '+' as last character in topic name, Success */
 TEST_GROUP_C_WRAPPER(SubscribeTests, subscribeTopicPluskeyComesLastSuccess)
+
+/* C:23 - Subscribe, overlapping filters, handlers called in subscription order */
+TEST_GROUP_C_WRAPPER(SubscribeTests, subscribeOverlappingFiltersCalledInSubscriptionOrder)
+/* C:24 - Subscribe and unsubscribe repeatedly, topic levels are reused */
+TEST_GROUP_C_WRAPPER(SubscribeTests, subscribeUnsubscribeRepeatedlyReusesTopicLevels)
+/* C:25 - Subscribe, topic filter with more levels than the index can hold, Failure */
+TEST_GROUP_C_WRAPPER(SubscribeTests, subscribeTopicDeeperThanIndexFailure)
+
+/* C:26 - Subscribe batch, topics requested in one packet, success */
+TEST_GROUP_C_WRAPPER(SubscribeTests, subscribeBatchSinglePacketSuccess)
+/* C:27 - Subscribe batch, one topic refused by the server */
+TEST_GROUP_C_WRAPPER(SubscribeTests, subscribeBatchTopicRejected)
+/* C:28 - Subscribe batch, more topics than handlers, nothing sent */
+TEST_GROUP_C_WRAPPER(SubscribeTests, subscribeBatchMoreThanMaxTopicsFailure)
+/* C:29 - Subscribe, topic refused by the server */
+TEST_GROUP_C_WRAPPER(SubscribeTests, subscribeTopicRejected)
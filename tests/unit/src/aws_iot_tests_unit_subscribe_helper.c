@@ -24,6 +24,7 @@
 
 #include "aws_iot_tests_unit_helper_functions.h"
 #include "aws_iot_log.h"
+#include "aws_iot_tests_unit_mock_tls_params.h"
 
 static IoT_Client_Init_Params initParams;
 static IoT_Client_Connect_Params connectParams;
@@ -155,6 +156,25 @@ static void iot_subscribe_callback_handler6(AWS_IoT_Client *pClient, char *topic
 	}
 }
 
+static char CallbackOrderString[10];
+
+static void iot_subscribe_callback_order_handler(AWS_IoT_Client *pClient, char *topicName, uint16_t topicNameLen,
+												 IoT_Publish_Message_Params *params, void *pData) {
+	size_t len;
+
+	if(NULL == pClient || NULL == topicName || 0 == topicNameLen) {
+		return;
+	}
+
+	IOT_UNUSED(params);
+
+	len = strlen(CallbackOrderString);
+	if(len + 1 < sizeof(CallbackOrderString)) {
+		CallbackOrderString[len] = *(char *) pData;
+		CallbackOrderString[len + 1] = '\0';
+	}
+}
+
 TEST_GROUP_C_SETUP(SubscribeTests) {
 	IoT_Error_t rc;
 	ResetTLSBuffer();
@@ -604,3 +624,232 @@ TEST_C(SubscribeTests, subscribeTopicPluskeyComesLastSuccess) {
 
 	IOT_DEBUG("-->Success - C:22 - Subscribe with '+' as last character in topic name, Success \n");
 }
+
+/* C:23 - Subscribe, overlapping filters, handlers called in subscription order */
+TEST_C(SubscribeTests, subscribeOverlappingFiltersCalledInSubscriptionOrder) {
+	IoT_Error_t rc = SUCCESS;
+	char expectedCallbackString[100] = "New message: foo, Overlap";
+
+	IOT_DEBUG("-->Running Subscribe Tests - C:23 - Subscribe, overlapping filters, handlers called in subscription order \n");
+
+	setTLSRxBufferForSuback("sdk/#", strlen("sdk/#"), QOS1, testPubMsgParams);
+	rc = aws_iot_mqtt_subscribe(&iotClient, "sdk/#", strlen("sdk/#"), QOS1, iot_subscribe_callback_order_handler,
+								"1");
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	setTLSRxBufferForSuback("sdk/Test/foo", strlen("sdk/Test/foo"), QOS1, testPubMsgParams);
+	rc = aws_iot_mqtt_subscribe(&iotClient, "sdk/Test/foo", strlen("sdk/Test/foo"), QOS1,
+								iot_subscribe_callback_order_handler, "2");
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	setTLSRxBufferForSuback("sdk/+/foo", strlen("sdk/+/foo"), QOS1, testPubMsgParams);
+	rc = aws_iot_mqtt_subscribe(&iotClient, "sdk/+/foo", strlen("sdk/+/foo"), QOS1,
+								iot_subscribe_callback_order_handler, "3");
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	setTLSRxBufferForSuback("sdk/Test/bar", strlen("sdk/Test/bar"), QOS1, testPubMsgParams);
+	rc = aws_iot_mqtt_subscribe(&iotClient, "sdk/Test/bar", strlen("sdk/Test/bar"), QOS1,
+								iot_subscribe_callback_order_handler, "4");
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	setTLSRxBufferForSuback("sdk/Test/+/foo", strlen("sdk/Test/+/foo"), QOS1, testPubMsgParams);
+	rc = aws_iot_mqtt_subscribe(&iotClient, "sdk/Test/+/foo", strlen("sdk/Test/+/foo"), QOS1,
+								iot_subscribe_callback_order_handler, "5");
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	setTLSRxBufferWithMsgOnSubscribedTopic("sdk/Test/foo", strlen("sdk/Test/foo"), QOS1, testPubMsgParams,
+										   expectedCallbackString);
+	CallbackOrderString[0] = '\0';
+
+	rc = aws_iot_mqtt_yield(&iotClient, 1000);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_STRING("123", CallbackOrderString);
+	CHECK_EQUAL_C_INT(1, isLastTLSTxMessagePuback());
+
+	IOT_DEBUG("-->Success - C:23 - Subscribe, overlapping filters, handlers called in subscription order \n");
+}
+
+/* C:24 - Subscribe and unsubscribe repeatedly, topic levels are reused */
+TEST_C(SubscribeTests, subscribeUnsubscribeRepeatedlyReusesTopicLevels) {
+	IoT_Error_t rc = SUCCESS;
+	char expectedCallbackString[100] = "New message: deep, Reuse";
+	char *pDeepTopic = "sdk/Test/a/b/c/d/e/f/g/h";
+	int itr;
+
+	IOT_DEBUG("-->Running Subscribe Tests - C:24 - Subscribe and unsubscribe repeatedly, topic levels are reused \n");
+
+	setTLSRxBufferForSuback("sdk/Test/a", strlen("sdk/Test/a"), QOS1, testPubMsgParams);
+	rc = aws_iot_mqtt_subscribe(&iotClient, "sdk/Test/a", strlen("sdk/Test/a"), QOS1,
+								iot_subscribe_callback_handler1, NULL);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	/* Without reuse the index runs out of nodes after a few iterations */
+	for(itr = 0; itr < 2 * AWS_IOT_MQTT_NUM_TOPIC_TRIE_NODES; itr++) {
+		setTLSRxBufferForSuback(pDeepTopic, strlen(pDeepTopic), QOS1, testPubMsgParams);
+		rc = aws_iot_mqtt_subscribe(&iotClient, pDeepTopic, (uint16_t) strlen(pDeepTopic), QOS1,
+									iot_subscribe_callback_handler, NULL);
+		CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+		setTLSRxBufferForUnsuback();
+		rc = aws_iot_mqtt_unsubscribe(&iotClient, pDeepTopic, (uint16_t) strlen(pDeepTopic));
+		CHECK_EQUAL_C_INT(SUCCESS, rc);
+	}
+
+	/* The shared levels of the remaining subscription are still indexed */
+	setTLSRxBufferWithMsgOnSubscribedTopic("sdk/Test/a", strlen("sdk/Test/a"), QOS1, testPubMsgParams,
+										   expectedCallbackString);
+	snprintf(CallbackMsgString1, 100, "NOT_VISITED");
+
+	rc = aws_iot_mqtt_yield(&iotClient, 1000);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_STRING(expectedCallbackString, CallbackMsgString1);
+
+	IOT_DEBUG("-->Success - C:24 - Subscribe and unsubscribe repeatedly, topic levels are reused \n");
+}
+
+/* C:25 - Subscribe, topic filter with more levels than the index can hold, Failure */
+TEST_C(SubscribeTests, subscribeTopicDeeperThanIndexFailure) {
+	IoT_Error_t rc = SUCCESS;
+	char deepTopic[2 * AWS_IOT_MQTT_NUM_TOPIC_TRIE_NODES + 1];
+	int itr;
+
+	IOT_DEBUG("-->Running Subscribe Tests - C:25 - Subscribe, topic filter with more levels than the index can hold, Failure \n");
+
+	/* One level per node, the root node holds no level */
+	for(itr = 0; itr < AWS_IOT_MQTT_NUM_TOPIC_TRIE_NODES; itr++) {
+		deepTopic[2 * itr] = 'l';
+		deepTopic[2 * itr + 1] = '/';
+	}
+	deepTopic[2 * AWS_IOT_MQTT_NUM_TOPIC_TRIE_NODES - 1] = '\0';
+
+	setTLSRxBufferForSuback(deepTopic, strlen(deepTopic), QOS1, testPubMsgParams);
+	rc = aws_iot_mqtt_subscribe(&iotClient, deepTopic, (uint16_t) strlen(deepTopic), QOS1,
+								iot_subscribe_callback_handler, NULL);
+	CHECK_EQUAL_C_INT(MQTT_MAX_SUBSCRIPTIONS_REACHED_ERROR, rc);
+
+	/* A filter that fits can still be subscribed */
+	deepTopic[2 * AWS_IOT_MQTT_NUM_TOPIC_TRIE_NODES - 3] = '\0';
+	setTLSRxBufferForSuback(deepTopic, strlen(deepTopic), QOS1, testPubMsgParams);
+	rc = aws_iot_mqtt_subscribe(&iotClient, deepTopic, (uint16_t) strlen(deepTopic), QOS1,
+								iot_subscribe_callback_handler, NULL);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	IOT_DEBUG("-->Success - C:25 - Subscribe, topic filter with more levels than the index can hold, Failure \n");
+}
+
+/* C:26 - Subscribe batch, topics requested in one packet, success */
+TEST_C(SubscribeTests, subscribeBatchSinglePacketSuccess) {
+	IoT_Error_t rc = SUCCESS;
+	char expectedCallbackString[100] = "New message: Test2, Batch";
+	unsigned char subackReturnCodes[3] = { QOS1, QOS1, QOS0 };
+	IoT_Subscribe_Params subscribeList[3] = {
+			{ "sdk/Test1", 9, QOS1, iot_subscribe_callback_handler1, NULL, FAILURE },
+			{ "sdk/Test2", 9, QOS1, iot_subscribe_callback_handler2, NULL, FAILURE },
+			{ "sdk/Test3", 9, QOS0, iot_subscribe_callback_handler3, NULL, FAILURE } };
+
+	IOT_DEBUG("-->Running Subscribe Tests - C:26 - Subscribe batch, topics requested in one packet, success \n");
+
+	setTLSRxBufferForMultiSuback(subackReturnCodes, 3);
+	rc = aws_iot_mqtt_subscribe_batch(&iotClient, subscribeList, 3);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(SUCCESS, subscribeList[0].result);
+	CHECK_EQUAL_C_INT(SUCCESS, subscribeList[1].result);
+	CHECK_EQUAL_C_INT(SUCCESS, subscribeList[2].result);
+
+	/* One SUBSCRIBE: header, packet id and 3 times topic length, topic and QoS */
+	CHECK_EQUAL_C_INT(0x82, TxBuffer.pBuffer[0]);
+	CHECK_EQUAL_C_INT(2 + 2 + 3 * (2 + 9 + 1), TxBuffer.len);
+
+	setTLSRxBufferWithMsgOnSubscribedTopic("sdk/Test2", 9, QOS1, testPubMsgParams, expectedCallbackString);
+	snprintf(CallbackMsgString2, 100, "NOT_VISITED");
+	rc = aws_iot_mqtt_yield(&iotClient, 1000);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_STRING(expectedCallbackString, CallbackMsgString2);
+
+	IOT_DEBUG("-->Success - C:26 - Subscribe batch, topics requested in one packet, success \n");
+}
+
+/* C:27 - Subscribe batch, one topic refused by the server */
+TEST_C(SubscribeTests, subscribeBatchTopicRejected) {
+	IoT_Error_t rc = SUCCESS;
+	char expectedCallbackString[100] = "New message: Test5, Rejected";
+	unsigned char subackReturnCodes[2] = { QOS1, 0x80 };
+	IoT_Subscribe_Params subscribeList[2] = {
+			{ "sdk/Test4", 9, QOS1, iot_subscribe_callback_handler4, NULL, FAILURE },
+			{ "sdk/Test5", 9, QOS1, iot_subscribe_callback_handler5, NULL, FAILURE } };
+
+	IOT_DEBUG("-->Running Subscribe Tests - C:27 - Subscribe batch, one topic refused by the server \n");
+
+	setTLSRxBufferForMultiSuback(subackReturnCodes, 2);
+	rc = aws_iot_mqtt_subscribe_batch(&iotClient, subscribeList, 2);
+	CHECK_EQUAL_C_INT(MQTT_SUBSCRIBE_REJECTED_ERROR, rc);
+	CHECK_EQUAL_C_INT(SUCCESS, subscribeList[0].result);
+	CHECK_EQUAL_C_INT(MQTT_SUBSCRIBE_REJECTED_ERROR, subscribeList[1].result);
+
+	/* No handler is left for the refused topic */
+	setTLSRxBufferWithMsgOnSubscribedTopic("sdk/Test5", 9, QOS1, testPubMsgParams, expectedCallbackString);
+	snprintf(CallbackMsgString5, 100, "NOT_VISITED");
+	rc = aws_iot_mqtt_yield(&iotClient, 1000);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_STRING("NOT_VISITED", CallbackMsgString5);
+
+	IOT_DEBUG("-->Success - C:27 - Subscribe batch, one topic refused by the server \n");
+}
+
+/* C:28 - Subscribe batch, more topics than handlers, nothing sent */
+TEST_C(SubscribeTests, subscribeBatchMoreThanMaxTopicsFailure) {
+	IoT_Error_t rc = SUCCESS;
+	IoT_Subscribe_Params subscribeList[AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS + 1];
+	unsigned char subackReturnCodes[AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS] = { QOS0 };
+	char topics[AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS + 1][10];
+	int itr;
+
+	IOT_DEBUG("-->Running Subscribe Tests - C:28 - Subscribe batch, more topics than handlers, nothing sent \n");
+
+	for(itr = 0; itr < AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS + 1; itr++) {
+		snprintf(topics[itr], 10, "sdk/Test%d", itr);
+		subscribeList[itr].pTopicName = topics[itr];
+		subscribeList[itr].topicNameLen = (uint16_t) strlen(topics[itr]);
+		subscribeList[itr].qos = QOS0;
+		subscribeList[itr].pApplicationHandler = iot_subscribe_callback_handler;
+		subscribeList[itr].pApplicationHandlerData = NULL;
+	}
+
+	rc = aws_iot_mqtt_subscribe_batch(&iotClient, subscribeList, AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS + 1);
+	CHECK_EQUAL_C_INT(MQTT_MAX_SUBSCRIPTIONS_REACHED_ERROR, rc);
+	CHECK_EQUAL_C_INT(0, TxBuffer.len);
+
+	/* All the handlers are still free */
+	setTLSRxBufferForMultiSuback(subackReturnCodes, AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS);
+	rc = aws_iot_mqtt_subscribe_batch(&iotClient, subscribeList, AWS_IOT_MQTT_NUM_SUBSCRIBE_HANDLERS);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	IOT_DEBUG("-->Success - C:28 - Subscribe batch, more topics than handlers, nothing sent \n");
+}
+
+/* C:29 - Subscribe, topic refused by the server */
+TEST_C(SubscribeTests, subscribeTopicRejected) {
+	IoT_Error_t rc = SUCCESS;
+	char expectedCallbackString[100] = "New message: Test5, Rejected";
+	unsigned char subackReturnCodes[1] = { 0x80 };
+	uint32_t itr;
+
+	IOT_DEBUG("-->Running Subscribe Tests - C:29 - Subscribe, topic refused by the server \n");
+
+	setTLSRxBufferForMultiSuback(subackReturnCodes, 1);
+	rc = aws_iot_mqtt_subscribe(&iotClient, "sdk/Test5", 9, QOS1, iot_subscribe_callback_handler5, NULL);
+	CHECK_EQUAL_C_INT(MQTT_SUBSCRIBE_REJECTED_ERROR, rc);
+
+	/* The handler was not registered */
+	for(itr = 0; itr < iotClient.clientData.messageHandlerCount; itr++) {
+		CHECK_C(NULL == iotClient.clientData.messageHandlers[itr].topicName);
+	}
+
+	setTLSRxBufferWithMsgOnSubscribedTopic("sdk/Test5", 9, QOS1, testPubMsgParams, expectedCallbackString);
+	snprintf(CallbackMsgString5, 100, "NOT_VISITED");
+	rc = aws_iot_mqtt_yield(&iotClient, 1000);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_STRING("NOT_VISITED", CallbackMsgString5);
+
+	IOT_DEBUG("-->Success - C:29 - Subscribe, topic refused by the server \n");
+}
@@ -0,0 +1,36 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file aws_iot_tests_unit_timer_wheel.cpp
+ * @brief IoT Client Unit Testing - Timer Wheel Tests
+ */
+
+#include <CppUTest/CommandLineTestRunner.h>
+#include <CppUTest/TestHarness_c.h>
+
+TEST_GROUP_C(TimerWheelTests){
+	TEST_GROUP_C_SETUP_WRAPPER(TimerWheelTests)
+	TEST_GROUP_C_TEARDOWN_WRAPPER(TimerWheelTests)
+};
+
+/* W:1 - Deadlines on every level expire after their timeout, never before */
+TEST_GROUP_C_WRAPPER(TimerWheelTests, ExpiresAcrossLevels)
+/* W:2 - Disarmed entries never expire, rearmed entries move to their new deadline */
+TEST_GROUP_C_WRAPPER(TimerWheelTests, DisarmAndRearm)
+/* W:3 - Expired entries popped in the order they came due, zero timeout due at once */
+TEST_GROUP_C_WRAPPER(TimerWheelTests, ExpiryOrder)
+/* W:4 - Next deadline follows the earliest armed entry */
+TEST_GROUP_C_WRAPPER(TimerWheelTests, NextDeadline)
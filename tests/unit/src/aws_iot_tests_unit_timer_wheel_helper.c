@@ -0,0 +1,164 @@
+/*
+* Copyright 2015-2016 Amazon.com, Inc. or its affiliates. All Rights Reserved.
+*
+* Licensed under the Apache License, Version 2.0 (the "License").
+* You may not use this file except in compliance with the License.
+* A copy of the License is located at
+*
+* http://aws.amazon.com/apache2.0
+*
+* or in the "license" file accompanying this file. This file is distributed
+* on an "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+* express or implied. See the License for the specific language governing
+* permissions and limitations under the License.
+*/
+
+/**
+ * @file aws_iot_tests_unit_timer_wheel_helper.c
+ * @brief IoT Client Unit Testing - Timer Wheel Tests Helper
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <CppUTest/TestHarness_c.h>
+
+#include "aws_iot_timer_wheel.h"
+#include "aws_iot_log.h"
+
+#define TIMER_WHEEL_TEST_ENTRIES 4
+
+static TimerWheel wheel;
+static TimerWheelEntry wheelEntries[TIMER_WHEEL_TEST_ENTRIES];
+
+/* Time is moved forward by shifting the start of the current tick back, instead of sleeping */
+static void iot_tests_unit_timer_wheel_elapse(uint32_t elapsed_ms) {
+	wheel.currentTickStartMs -= elapsed_ms;
+	aws_iot_timer_wheel_advance(&wheel);
+}
+
+TEST_GROUP_C_SETUP(TimerWheelTests) {
+	aws_iot_timer_wheel_init(&wheel, wheelEntries, TIMER_WHEEL_TEST_ENTRIES);
+}
+
+TEST_GROUP_C_TEARDOWN(TimerWheelTests) {
+}
+
+/* W:1 - Deadlines on every level expire after their timeout, never before */
+TEST_C(TimerWheelTests, ExpiresAcrossLevels) {
+	IOT_DEBUG("-->Running Timer Wheel Tests - W:1 - Expires across levels \n");
+
+	aws_iot_timer_wheel_arm(&wheel, 0, 50);
+	aws_iot_timer_wheel_arm(&wheel, 1, 3000);
+	aws_iot_timer_wheel_arm(&wheel, 2, 200000);
+	aws_iot_timer_wheel_arm(&wheel, 3, 10000000);
+
+	iot_tests_unit_timer_wheel_elapse(40);
+	CHECK_EQUAL_C_INT(AWS_IOT_TIMER_WHEEL_INDEX_NONE, aws_iot_timer_wheel_pop_expired(&wheel));
+	/* 70 ms */
+	iot_tests_unit_timer_wheel_elapse(30);
+	CHECK_EQUAL_C_INT(0, aws_iot_timer_wheel_pop_expired(&wheel));
+	CHECK_EQUAL_C_INT(AWS_IOT_TIMER_WHEEL_INDEX_NONE, aws_iot_timer_wheel_pop_expired(&wheel));
+
+	/* 2.9 s, then 3.1 s */
+	iot_tests_unit_timer_wheel_elapse(2830);
+	CHECK_EQUAL_C_INT(AWS_IOT_TIMER_WHEEL_INDEX_NONE, aws_iot_timer_wheel_pop_expired(&wheel));
+	iot_tests_unit_timer_wheel_elapse(200);
+	CHECK_EQUAL_C_INT(1, aws_iot_timer_wheel_pop_expired(&wheel));
+
+	/* 199 s, then 201 s */
+	iot_tests_unit_timer_wheel_elapse(195900);
+	CHECK_EQUAL_C_INT(AWS_IOT_TIMER_WHEEL_INDEX_NONE, aws_iot_timer_wheel_pop_expired(&wheel));
+	iot_tests_unit_timer_wheel_elapse(2000);
+	CHECK_EQUAL_C_INT(2, aws_iot_timer_wheel_pop_expired(&wheel));
+
+	/* Beyond the last level: 9990 s, then 10010 s */
+	iot_tests_unit_timer_wheel_elapse(9789000);
+	CHECK_EQUAL_C_INT(AWS_IOT_TIMER_WHEEL_INDEX_NONE, aws_iot_timer_wheel_pop_expired(&wheel));
+	iot_tests_unit_timer_wheel_elapse(20000);
+	CHECK_EQUAL_C_INT(3, aws_iot_timer_wheel_pop_expired(&wheel));
+	CHECK_EQUAL_C_INT(AWS_IOT_TIMER_WHEEL_INDEX_NONE, aws_iot_timer_wheel_pop_expired(&wheel));
+	CHECK_EQUAL_C_INT(0, wheel.armedCount);
+
+	IOT_DEBUG("-->Success - W:1 - Expires across levels \n");
+}
+
+/* W:2 - Disarmed entries never expire, rearmed entries move to their new deadline */
+TEST_C(TimerWheelTests, DisarmAndRearm) {
+	IOT_DEBUG("-->Running Timer Wheel Tests - W:2 - Disarm and rearm \n");
+
+	aws_iot_timer_wheel_arm(&wheel, 0, 100);
+	aws_iot_timer_wheel_arm(&wheel, 1, 100);
+	aws_iot_timer_wheel_arm(&wheel, 2, 5000);
+	aws_iot_timer_wheel_disarm(&wheel, 0);
+	aws_iot_timer_wheel_disarm(&wheel, 0);
+	aws_iot_timer_wheel_arm(&wheel, 1, 1000);
+	aws_iot_timer_wheel_disarm(&wheel, 2);
+	CHECK_EQUAL_C_INT(1, wheel.armedCount);
+
+	iot_tests_unit_timer_wheel_elapse(200);
+	CHECK_EQUAL_C_INT(AWS_IOT_TIMER_WHEEL_INDEX_NONE, aws_iot_timer_wheel_pop_expired(&wheel));
+
+	iot_tests_unit_timer_wheel_elapse(900);
+	CHECK_EQUAL_C_INT(1, aws_iot_timer_wheel_pop_expired(&wheel));
+
+	iot_tests_unit_timer_wheel_elapse(5000);
+	CHECK_EQUAL_C_INT(AWS_IOT_TIMER_WHEEL_INDEX_NONE, aws_iot_timer_wheel_pop_expired(&wheel));
+	CHECK_EQUAL_C_INT(0, wheel.armedCount);
+
+	IOT_DEBUG("-->Success - W:2 - Disarm and rearm \n");
+}
+
+/* W:3 - Expired entries popped in the order they came due, zero timeout due at once */
+TEST_C(TimerWheelTests, ExpiryOrder) {
+	IOT_DEBUG("-->Running Timer Wheel Tests - W:3 - Expiry order \n");
+
+	aws_iot_timer_wheel_arm(&wheel, 3, 0);
+	CHECK_EQUAL_C_INT(3, aws_iot_timer_wheel_pop_expired(&wheel));
+	CHECK_EQUAL_C_INT(AWS_IOT_TIMER_WHEEL_INDEX_NONE, aws_iot_timer_wheel_pop_expired(&wheel));
+
+	aws_iot_timer_wheel_arm(&wheel, 0, 2000);
+	aws_iot_timer_wheel_arm(&wheel, 1, 50);
+	aws_iot_timer_wheel_arm(&wheel, 2, 500);
+
+	iot_tests_unit_timer_wheel_elapse(3000);
+	CHECK_EQUAL_C_INT(1, aws_iot_timer_wheel_pop_expired(&wheel));
+	CHECK_EQUAL_C_INT(2, aws_iot_timer_wheel_pop_expired(&wheel));
+	CHECK_EQUAL_C_INT(0, aws_iot_timer_wheel_pop_expired(&wheel));
+	CHECK_EQUAL_C_INT(AWS_IOT_TIMER_WHEEL_INDEX_NONE, aws_iot_timer_wheel_pop_expired(&wheel));
+
+	IOT_DEBUG("-->Success - W:3 - Expiry order \n");
+}
+
+/* W:4 - Next deadline follows the earliest armed entry */
+TEST_C(TimerWheelTests, NextDeadline) {
+	uint32_t deadline;
+
+	IOT_DEBUG("-->Running Timer Wheel Tests - W:4 - Next deadline \n");
+
+	CHECK_EQUAL_C_INT(UINT32_MAX, aws_iot_timer_wheel_next_deadline_ms(&wheel));
+
+	/* Far deadlines only need the wheel to cascade in time */
+	aws_iot_timer_wheel_arm(&wheel, 0, 100000);
+	deadline = aws_iot_timer_wheel_next_deadline_ms(&wheel);
+	CHECK_C(0 < deadline && 100000 >= deadline);
+
+	aws_iot_timer_wheel_arm(&wheel, 1, 50);
+	deadline = aws_iot_timer_wheel_next_deadline_ms(&wheel);
+	CHECK_C(40 <= deadline && 50 + 2 * AWS_IOT_TIMER_WHEEL_TICK_MS >= deadline);
+
+	iot_tests_unit_timer_wheel_elapse(100);
+	CHECK_EQUAL_C_INT(0, aws_iot_timer_wheel_next_deadline_ms(&wheel));
+	CHECK_EQUAL_C_INT(1, aws_iot_timer_wheel_pop_expired(&wheel));
+
+	/* Following the cascades, the wheel is never woken up after the deadline */
+	deadline = aws_iot_timer_wheel_next_deadline_ms(&wheel);
+	while(0 < deadline) {
+		CHECK_EQUAL_C_INT(AWS_IOT_TIMER_WHEEL_INDEX_NONE, aws_iot_timer_wheel_pop_expired(&wheel));
+		iot_tests_unit_timer_wheel_elapse(deadline);
+		deadline = aws_iot_timer_wheel_next_deadline_ms(&wheel);
+	}
+	CHECK_EQUAL_C_INT(0, aws_iot_timer_wheel_pop_expired(&wheel));
+	CHECK_EQUAL_C_INT(UINT32_MAX, aws_iot_timer_wheel_next_deadline_ms(&wheel));
+
+	IOT_DEBUG("-->Success - W:4 - Next deadline \n");
+}
@@ -53,3 +53,8 @@ TEST_GROUP_C_WRAPPER(UnsubscribeTests, MsgAfterUnsubscribe)
 TEST_GROUP_C_WRAPPER(UnsubscribeTests, MaxTopicsSubscription)
 /* D:12 - Repeated Subscribe and Unsubscribe */
 TEST_GROUP_C_WRAPPER(UnsubscribeTests, RepeatedSubUnSub)
+
+/* D:13 - Unsubscribe batch, filters sent in one packet, messages on topics ignored */
+TEST_GROUP_C_WRAPPER(UnsubscribeTests, unsubscribeBatchSinglePacketSuccess)
+/* D:14 - Unsubscribe batch with a filter that is not subscribed, nothing sent */
+TEST_GROUP_C_WRAPPER(UnsubscribeTests, unsubscribeBatchNotSubscribedFailure)
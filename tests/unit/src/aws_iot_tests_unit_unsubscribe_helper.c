@@ -25,6 +25,7 @@
 #include "aws_iot_mqtt_client_interface.h"
 #include "aws_iot_tests_unit_helper_functions.h"
 #include "aws_iot_log.h"
+#include "aws_iot_tests_unit_mock_tls_params.h"
 
 static IoT_Client_Init_Params initParams;
 static IoT_Client_Connect_Params connectParams;
@@ -341,3 +342,62 @@ TEST_C(UnsubscribeTests, RepeatedSubUnSub) {
 
 	IOT_DEBUG("-->Success - D:12 - Repeated Subscribe and Unsubscribe \n");
 }
+
+/* D:13 - Unsubscribe batch, filters sent in one packet, messages on topics ignored */
+TEST_C(UnsubscribeTests, unsubscribeBatchSinglePacketSuccess) {
+	IoT_Error_t rc = SUCCESS;
+	char expectedCallbackString[100];
+	const char *topicFilterList[3] = { "topic1", "topic2", "topic3" };
+	uint16_t topicFilterLenList[3] = { 6, 6, 6 };
+	int i;
+
+	IOT_DEBUG("-->Running Unsubscribe Tests - D:13 - Unsubscribe batch, filters sent in one packet \n");
+
+	for(i = 0; i < 3; i++) {
+		setTLSRxBufferForSuback((char *) topicFilterList[i], 6, QOS0, testPubMsgParams);
+		rc = aws_iot_mqtt_subscribe(&iotClient, topicFilterList[i], 6, QOS0, iot_subscribe_callback_handler, NULL);
+		CHECK_EQUAL_C_INT(SUCCESS, rc);
+	}
+
+	setTLSRxBufferForUnsuback();
+	rc = aws_iot_mqtt_unsubscribe_batch(&iotClient, topicFilterList, topicFilterLenList, 3);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	/* One UNSUBSCRIBE: header, packet id and 3 times topic length and topic */
+	CHECK_EQUAL_C_INT(0xA2, TxBuffer.pBuffer[0]);
+	CHECK_EQUAL_C_INT(2 + 2 + 3 * (2 + 6), TxBuffer.len);
+
+	snprintf(CallbackMsgString, 100, " ");
+	snprintf(expectedCallbackString, 100, "Message after unsubscribe");
+	setTLSRxBufferWithMsgOnSubscribedTopic("topic2", 6, QOS0, testPubMsgParams, expectedCallbackString);
+	rc = aws_iot_mqtt_yield(&iotClient, 100);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_STRING(" ", CallbackMsgString);
+
+	IOT_DEBUG("-->Success - D:13 - Unsubscribe batch, filters sent in one packet \n");
+}
+
+/* D:14 - Unsubscribe batch with a filter that is not subscribed, nothing sent */
+TEST_C(UnsubscribeTests, unsubscribeBatchNotSubscribedFailure) {
+	IoT_Error_t rc = SUCCESS;
+	const char *topicFilterList[2] = { "topic1", "topic2" };
+	uint16_t topicFilterLenList[2] = { 6, 6 };
+
+	IOT_DEBUG("-->Running Unsubscribe Tests - D:14 - Unsubscribe batch with a filter that is not subscribed \n");
+
+	setTLSRxBufferForSuback("topic1", 6, QOS0, testPubMsgParams);
+	rc = aws_iot_mqtt_subscribe(&iotClient, "topic1", 6, QOS0, iot_subscribe_callback_handler, NULL);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	ResetTLSBuffer();
+
+	setTLSRxBufferForUnsuback();
+	rc = aws_iot_mqtt_unsubscribe_batch(&iotClient, topicFilterList, topicFilterLenList, 2);
+	CHECK_EQUAL_C_INT(FAILURE, rc);
+	CHECK_EQUAL_C_INT(0, TxBuffer.len);
+
+	/* topic1 is still subscribed */
+	rc = aws_iot_mqtt_unsubscribe_batch(&iotClient, topicFilterList, topicFilterLenList, 1);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	IOT_DEBUG("-->Success - D:14 - Unsubscribe batch with a filter that is not subscribed \n");
+}
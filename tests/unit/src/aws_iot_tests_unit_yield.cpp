@@ -55,3 +55,10 @@ TEST_GROUP_C_WRAPPER(YieldTests, resubscribeSuccessfulReconnect)
 
 /* G:13 - Delayed Ping response. */
 TEST_GROUP_C_WRAPPER(YieldTests, delayedPingResponse)
+
+/* G:14 - Process ready, no incoming messages, socket and deadline exposed */
+TEST_GROUP_C_WRAPPER(YieldTests, processReadyNoMessages)
+/* G:15 - Process ready, received message delivered without waiting */
+TEST_GROUP_C_WRAPPER(YieldTests, processReadyDeliversMessage)
+/* G:16 - Process ready, ping request sent once the deadline has elapsed */
+TEST_GROUP_C_WRAPPER(YieldTests, processReadyPingAtDeadline)
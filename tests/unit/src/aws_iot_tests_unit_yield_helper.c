@@ -24,6 +24,7 @@
 
 #include "aws_iot_tests_unit_helper_functions.h"
 #include "aws_iot_tests_unit_mock_tls_params.h"
+#include "aws_iot_mqtt_client_common_internal.h"
 #include "aws_iot_log.h"
 
 static IoT_Client_Init_Params initParams;
@@ -86,10 +87,11 @@ TEST_GROUP_C_SETUP(YieldTests) {
 	dcHandlerInvoked = false;
 
 	InitMQTTParamsSetup(&initParams, AWS_IOT_MQTT_HOST, AWS_IOT_MQTT_PORT, false, iot_tests_unit_disconnect_handler);
+	/* The reconnect tests sleep for the known waits of the exponential backoff */
+	initParams.reconnectPolicy = aws_iot_mqtt_reconnect_policy_exponential;
 	rc = aws_iot_mqtt_init(&iotClient, &initParams);
 	CHECK_EQUAL_C_INT(SUCCESS, rc);
 
-
 	ConnectMQTTParamsSetup_Detailed(&connectParams, AWS_IOT_MQTT_CLIENT_ID, (uint16_t) strlen(AWS_IOT_MQTT_CLIENT_ID),
 									QOS1, false, true, "willTopicName", (uint16_t) strlen("willTopicName"), "willMsg",
 									(uint16_t) strlen("willMsg"), NULL, 0, NULL, 0);
@@ -491,3 +493,83 @@ TEST_C(YieldTests, delayedPingResponse)
 
 	IOT_DEBUG("-->Success - G:13 - Delayed Ping response. \n");
 }
+
+/* G:14 - Process ready, no incoming messages, socket and deadline exposed */
+TEST_C(YieldTests, processReadyNoMessages) {
+	IoT_Error_t rc;
+	uint32_t deadline;
+
+	IOT_DEBUG("-->Running Yield Tests - G:14 - Process ready, no incoming messages \n");
+
+	CHECK_EQUAL_C_INT(NULL_VALUE_ERROR, aws_iot_mqtt_process_ready(NULL));
+
+	rc = aws_iot_mqtt_process_ready(&iotClient);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(CLIENT_STATE_CONNECTED_IDLE, aws_iot_mqtt_get_client_state(&iotClient));
+	CHECK_EQUAL_C_INT(0, TxBuffer.len);
+
+	CHECK_EQUAL_C_INT(MOCK_TLS_SOCKET_FD, aws_iot_mqtt_get_network_fd(&iotClient));
+
+	/* Next ping request is the only timer running */
+	deadline = aws_iot_mqtt_get_next_deadline_ms(&iotClient);
+	CHECK_C(0 < deadline);
+	CHECK_C(iotClient.clientData.keepAliveInterval * 1000 + 1 >= deadline);
+
+	rc = aws_iot_mqtt_disconnect(&iotClient);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(-1, aws_iot_mqtt_get_network_fd(&iotClient));
+	CHECK_EQUAL_C_INT(AWS_IOT_MQTT_NO_DEADLINE, aws_iot_mqtt_get_next_deadline_ms(&iotClient));
+
+	IOT_DEBUG("-->Success - G:14 - Process ready, no incoming messages \n");
+}
+
+/* G:15 - Process ready, received message delivered without waiting */
+TEST_C(YieldTests, processReadyDeliversMessage) {
+	IoT_Error_t rc;
+	char expectedCallbackString[] = "0xA5A5A4";
+
+	IOT_DEBUG("-->Running Yield Tests - G:15 - Process ready, received message delivered \n");
+
+	memset(CallbackMsgString, 0, sizeof(CallbackMsgString));
+	testPubMsgParams.qos = QOS0;
+	setTLSRxBufferForSuback(subTopic, subTopicLen, QOS0, testPubMsgParams);
+	rc = aws_iot_mqtt_subscribe(&iotClient, subTopic, subTopicLen, QOS0,
+								iot_tests_unit_acr_subscribe_callback_handler, NULL);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+
+	setTLSRxBufferWithMsgOnSubscribedTopic(subTopic, subTopicLen, QOS0, testPubMsgParams, expectedCallbackString);
+	rc = aws_iot_mqtt_process_ready(&iotClient);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_STRING(expectedCallbackString, CallbackMsgString);
+	CHECK_EQUAL_C_INT(false, aws_iot_mqtt_internal_is_packet_buffered(&iotClient));
+
+	IOT_DEBUG("-->Success - G:15 - Process ready, received message delivered \n");
+}
+
+/* G:16 - Process ready, ping request sent once the deadline has elapsed */
+TEST_C(YieldTests, processReadyPingAtDeadline) {
+	IoT_Error_t rc;
+	uint32_t deadline;
+
+	IOT_DEBUG("-->Running Yield Tests - G:16 - Process ready, ping request sent at deadline \n");
+
+	deadline = aws_iot_mqtt_get_next_deadline_ms(&iotClient);
+	usleep(deadline * 1000);
+	CHECK_EQUAL_C_INT(0, aws_iot_mqtt_get_next_deadline_ms(&iotClient));
+
+	rc = aws_iot_mqtt_process_ready(&iotClient);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(1, isLastTLSTxMessagePingreq());
+
+	/* Now waiting for the ping response */
+	deadline = aws_iot_mqtt_get_next_deadline_ms(&iotClient);
+	CHECK_C(0 < deadline);
+
+	ResetTLSBuffer();
+	setTLSRxBufferForPingresp();
+	rc = aws_iot_mqtt_process_ready(&iotClient);
+	CHECK_EQUAL_C_INT(SUCCESS, rc);
+	CHECK_EQUAL_C_INT(false, iotClient.clientStatus.isPingOutstanding);
+
+	IOT_DEBUG("-->Success - G:16 - Process ready, ping request sent at deadline \n");
+}
@@ -8,7 +8,8 @@
 
 void _iot_tls_set_connect_params(Network *pNetwork, char *pRootCALocation, char *pDeviceCertLocation,
 								 char *pDevicePrivateKeyLocation, char *pDestinationURL,
-								 uint16_t destinationPort, uint32_t timeout_ms, bool ServerVerificationFlag) {
+								 uint16_t destinationPort, uint32_t timeout_ms, bool ServerVerificationFlag,
+								 char *pTlsSessionLocation) {
 	pNetwork->tlsConnectParams.DestinationPort = destinationPort;
 	pNetwork->tlsConnectParams.pDestinationURL = pDestinationURL;
 	pNetwork->tlsConnectParams.pDeviceCertLocation = pDeviceCertLocation;
@@ -16,20 +17,26 @@ void _iot_tls_set_connect_params(Network *pNetwork, char *pRootCALocation, char
 	pNetwork->tlsConnectParams.pRootCALocation = pRootCALocation;
 	pNetwork->tlsConnectParams.timeout_ms = timeout_ms;
 	pNetwork->tlsConnectParams.ServerVerificationFlag = ServerVerificationFlag;
+	pNetwork->tlsConnectParams.pTlsSessionLocation = pTlsSessionLocation;
 }
 
 IoT_Error_t iot_tls_init(Network *pNetwork, char *pRootCALocation, char *pDeviceCertLocation,
 						 char *pDevicePrivateKeyLocation, char *pDestinationURL,
-						 uint16_t destinationPort, uint32_t timeout_ms, bool ServerVerificationFlag) {
+						 uint16_t destinationPort, uint32_t timeout_ms, bool ServerVerificationFlag,
+						 char *pTlsSessionLocation) {
 	_iot_tls_set_connect_params(pNetwork, pRootCALocation, pDeviceCertLocation, pDevicePrivateKeyLocation,
-								pDestinationURL, destinationPort, timeout_ms, ServerVerificationFlag);
+								pDestinationURL, destinationPort, timeout_ms, ServerVerificationFlag,
+								pTlsSessionLocation);
 
 	pNetwork->connect = iot_tls_connect;
 	pNetwork->read = iot_tls_read;
+	pNetwork->readAvailable = iot_tls_read_available;
 	pNetwork->write = iot_tls_write;
+	pNetwork->writeVector = iot_tls_write_vector;
 	pNetwork->disconnect = iot_tls_disconnect;
 	pNetwork->isConnected = iot_tls_is_connected;
 	pNetwork->destroy = iot_tls_destroy;
+	pNetwork->getSocketFd = iot_tls_get_socket_fd;
 
 	return SUCCESS;
 }
@@ -40,7 +47,7 @@ IoT_Error_t iot_tls_connect(Network *pNetwork, TLSConnectParams *params) {
 	if(NULL != params) {
 		_iot_tls_set_connect_params(pNetwork, params->pRootCALocation, params->pDeviceCertLocation,
 									params->pDevicePrivateKeyLocation, params->pDestinationURL, params->DestinationPort,
-									params->timeout_ms, params->ServerVerificationFlag);
+									params->timeout_ms, params->ServerVerificationFlag, params->pTlsSessionLocation);
 	}
 
 	if(NULL != invalidEndpointFilter && 0 == strcmp(invalidEndpointFilter, pNetwork->tlsConnectParams.pDestinationURL)) {
@@ -77,7 +84,7 @@ static size_t iot_tls_mqtt_read_variable_length_int(const unsigned char *buffer,
 	size_t pos = startPos;
 	size_t multiplier = 1;
 	do {
-		result = (buffer[pos] & 0x7f) * multiplier;
+		result += (buffer[pos] & 0x7f) * multiplier;
 		multiplier *= 0x80;
 		pos++;
 	} while ((buffer[pos - 1] & 0x80) && pos - startPos < 4);
@@ -156,7 +163,7 @@ IoT_Error_t iot_tls_write(Network *pNetwork, unsigned char *pMsg, size_t len, Ti
 			payloadStart += 2;
 		}
 
-		lastPublishMessagePayloadLen = mqttPacketLength - payloadStart + 2; /* + 2 as the first two bytes don't count towards the length */
+		lastPublishMessagePayloadLen = mqttPacketLength - payloadStart + variableHeaderStart; /* the fixed header doesn't count towards the length */
 		memcpy(LastPublishMessagePayload, TxBuffer.pBuffer + payloadStart, lastPublishMessagePayloadLen);
 		LastPublishMessagePayload[lastPublishMessagePayloadLen] = 0;
 	}
@@ -164,6 +171,24 @@ IoT_Error_t iot_tls_write(Network *pNetwork, unsigned char *pMsg, size_t len, Ti
 	return status;
 }
 
+IoT_Error_t iot_tls_write_vector(Network *pNetwork, NetworkBufferVector *pVector, size_t vectorCount, Timer *timer,
+								 size_t *written_len) {
+	static unsigned char gatherBuffer[TLSMaxBufferSize];
+	size_t itr;
+	size_t len = 0;
+
+	/* Gather the segments so the packet can be inspected like a single write */
+	for(itr = 0; itr < vectorCount; itr++) {
+		if(len + pVector[itr].len > TLSMaxBufferSize) {
+			return NETWORK_SSL_WRITE_ERROR;
+		}
+		memcpy(gatherBuffer + len, pVector[itr].pBuffer, pVector[itr].len);
+		len += pVector[itr].len;
+	}
+
+	return iot_tls_write(pNetwork, gatherBuffer, len, timer, written_len);
+}
+
 static unsigned char isTimerExpired(struct timeval target_time) {
 	unsigned char ret_val = 0;
 	struct timeval now, result;
@@ -212,6 +237,48 @@ IoT_Error_t iot_tls_read(Network *pNetwork, unsigned char *pMsg, size_t len, Tim
 	return status;
 }
 
+IoT_Error_t iot_tls_read_available(Network *pNetwork, unsigned char *pMsg, size_t len, Timer *pTimer, size_t *read_len) {
+	IoT_Error_t status = SUCCESS;
+	size_t available;
+
+	IOT_UNUSED(pNetwork);
+	IOT_UNUSED(pTimer);
+
+	if(RxBuffer.mockedError != SUCCESS) {
+		status = RxBuffer.mockedError;
+
+		/* Clear the error before returning. */
+		RxBuffer.mockedError = SUCCESS;
+
+		return status;
+	}
+
+	if(RxIndex > TLSMaxBufferSize - 1) {
+		RxIndex = TLSMaxBufferSize - 1;
+	}
+
+	if(RxBuffer.len <= RxIndex || !isTimerExpired(RxBuffer.expiry_time) || RxBuffer.NoMsgFlag) {
+		return NETWORK_SSL_NOTHING_TO_READ;
+	}
+
+	/* Hand out everything that was queued, like a TLS record holding several packets */
+	available = RxBuffer.len - RxIndex;
+	if(available > len) {
+		available = len;
+	}
+
+	memcpy(pMsg, &(RxBuffer.pBuffer[RxIndex]), available);
+	RxIndex += available;
+	*read_len = available;
+
+	return status;
+}
+
+int iot_tls_get_socket_fd(Network *pNetwork) {
+	IOT_UNUSED(pNetwork);
+	return MockSocketFd;
+}
+
 IoT_Error_t iot_tls_disconnect(Network *pNetwork) {
 	IOT_UNUSED(pNetwork);
 	return SUCCESS;
@@ -221,3 +288,8 @@ IoT_Error_t iot_tls_destroy(Network *pNetwork) {
 	IOT_UNUSED(pNetwork);
 	return SUCCESS;
 }
+
+IoT_Error_t iot_tls_free(Network *pNetwork) {
+	IOT_UNUSED(pNetwork);
+	return SUCCESS;
+}
@@ -39,6 +39,7 @@ TlsBuffer RxBuffer = {.pBuffer = RxBuf,.len = 512, .NoMsgFlag=1, .expiry_time =
 TlsBuffer TxBuffer = {.pBuffer = TxBuf,.len = 512, .NoMsgFlag=1, .expiry_time = {0, 0}, .BufMaxSize = TLSMaxBufferSize, .mockedError = SUCCESS};
 
 size_t RxIndex = 0;
+int MockSocketFd = MOCK_TLS_SOCKET_FD;
 
 char *invalidEndpointFilter;
 char *invalidRootCAPathFilter;
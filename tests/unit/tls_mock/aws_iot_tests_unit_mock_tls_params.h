@@ -29,6 +29,7 @@
 
 #define TLSMaxBufferSize 2560
 #define NO_MSG_LENGTH_MENTIONED -1
+#define MOCK_TLS_SOCKET_FD 3
 
 typedef struct {
 	unsigned char *pBuffer;
@@ -44,6 +45,7 @@ extern TlsBuffer RxBuffer;
 extern TlsBuffer TxBuffer;
 
 extern size_t RxIndex;
+extern int MockSocketFd;
 extern unsigned char RxBuf[TLSMaxBufferSize];
 extern unsigned char TxBuf[TLSMaxBufferSize];
 extern char LastSubscribeMessage[TLSMaxBufferSize];